@@ -21,6 +21,9 @@ PCIE_LANES=16
 PCIE_GEN=4
 PCIE_MAX_PAYLOAD=512
 
+# NPU array configuration (npu_top CORE_COUNT generic)
+NPU_CORE_COUNT=4
+
 # Resource constraints (VU9P has more resources)
 MAX_LUT_UTIL=75
 MAX_BRAM_UTIL=60
@@ -21,6 +21,9 @@ PCIE_LANES=4
 PCIE_GEN=3
 PCIE_MAX_PAYLOAD=256
 
+# NPU array configuration (npu_top CORE_COUNT generic)
+NPU_CORE_COUNT=1
+
 # Resource constraints
 MAX_LUT_UTIL=80
 MAX_BRAM_UTIL=70
@@ -0,0 +1,915 @@
+/**
+ * FPGA NPU Co-simulation Model
+ *
+ * Verilator model of npu_top behind the C ABI in npu_cosim.h. The RTL
+ * stops at the PCIe stream, DDR port, completion-ring write port and the
+ * register-block signals (pe_enable_mask, perf counters, core counters,
+ * cq_*); this file provides everything on the other side of those ports
+ * the way the driver and board see it:
+ *
+ *   - the register block, as a view over npu_top ports (read_reg())
+ *   - the driver's ioctl, write, read and mmap entry points
+ *   - host DMA buffers, and a DDR model with a fixed latency (byte
+ *     addresses on mem_addr, as conv_engine issues them)
+ *   - the completion ring in host memory, reaped on cq_irq like the ISR
+ *
+ * Core and PCIe clocks run in phase, one core cycle per tick(). Time only
+ * advances in tick(): waits, DMA transfers (size / 16 bytes per cycle)
+ * and register reads (NPU_COSIM_MMIO_CYCLES) step the model, so polling
+ * loops make progress and runs are reproducible.
+ *
+ * Environment:
+ *   NPU_COSIM_FREQ_MHZ        Core clock used for timeouts and timestamps (300)
+ *   NPU_COSIM_MEM_LATENCY     DDR cycles from request to response (2)
+ *   NPU_COSIM_DDR_MB          DDR size (64)
+ *   NPU_COSIM_MMIO_CYCLES     Cost of a register read (300, ~1us)
+ *   NPU_COSIM_MAX_WAIT_CYCLES Bound on waits with no timeout (100000000)
+ *   NPU_COSIM_VCD             Waveform file (builds with TRACE=1 only)
+ */
+
+#include "Vnpu_top.h"
+#include "verilated.h"
+#ifdef NPU_COSIM_TRACE
+#include "verilated_vcd_c.h"
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+
+#ifndef BIT
+#define BIT(n) (1u << (n))
+#endif
+
+#include "npu_cosim.h"
+#include "../driver/fpga_npu_enhanced.h"
+
+#ifndef NPU_COSIM_CORES
+#define NPU_COSIM_CORES 1       // Must match -GCORE_COUNT in the Makefile
+#endif
+
+namespace {
+
+// Register map (must match fpga_npu_driver.c)
+constexpr uint32_t REG_CONTROL     = 0x00;
+constexpr uint32_t REG_STATUS      = 0x04;
+constexpr uint32_t REG_PERF_CYCLES = 0x18;   // 64-bit, low word first
+constexpr uint32_t REG_TEMPERATURE = 0x20;
+constexpr uint32_t REG_POWER       = 0x24;
+constexpr uint32_t REG_CONFIG      = 0x28;
+constexpr uint32_t REG_ERROR       = 0x2C;
+constexpr uint32_t REG_PERF_MACS   = 0x40;
+constexpr uint32_t REG_PERF_MACS_SKIPPED = 0x48;
+constexpr uint32_t REG_PERF_MULT_GATED   = 0x50;
+constexpr uint32_t REG_CORE_INFO   = 0x58;
+constexpr uint32_t REG_CQ_BASE_LO  = 0x60;
+constexpr uint32_t REG_CQ_BASE_HI  = 0x64;
+constexpr uint32_t REG_CQ_CTRL     = 0x68;
+constexpr uint32_t REG_CQ_HEAD     = 0x6C;
+constexpr uint32_t REG_CQ_TAIL     = 0x70;
+constexpr uint32_t REG_CORE_BASE   = 0x80;
+constexpr uint32_t REG_CORE_STRIDE = 0x08;
+constexpr uint32_t REG_COUNT       = 64;     // Words returned by NPU_IOCTL_DUMP_REGISTERS
+
+constexpr uint32_t CTRL_ENABLE     = BIT(0);
+constexpr uint32_t CQ_CTRL_ENABLE  = BIT(31);
+
+constexpr uint32_t PE_COUNT        = 16;     // npu_top default
+constexpr int WORDS_PER_BEAT       = 4;      // 128-bit PCIe beat, 32-bit words
+constexpr size_t DMA_BUFFER_SIZE   = 64 * 1024;          // Legacy write()/read() buffer
+constexpr uint64_t CQ_BUS_ADDR     = 0x100000000ull;     // Bus address of the ring
+constexpr uint64_t BUFFER_BUS_BASE = 0x200000000ull;     // Bus addresses of DMA buffers
+constexpr uint64_t DMA_BYTES_PER_CYCLE = 16;
+constexpr uint32_t DDR_UNMAPPED    = 0xDEADBEEF;
+
+uint64_t env_u64(const char *name, uint64_t def)
+{
+    const char *value = getenv(name);
+
+    if (!value || !*value) {
+        return def;
+    }
+    return strtoull(value, nullptr, 0);
+}
+
+// 32-bit word i of a packed port, whatever width Verilator gave it
+template <typename T>
+uint32_t word_of(T value, int i)
+{
+    return i < 2 ? (uint32_t)((uint64_t)value >> (32 * i)) : 0;
+}
+
+template <std::size_t N>
+uint32_t word_of(const VlWide<N> &value, int i)
+{
+    return i < (int)N ? value[i] : 0;
+}
+
+struct Beat {
+    uint32_t word[WORDS_PER_BEAT];
+    uint8_t keep;
+};
+
+}  // namespace
+
+struct npu_cosim {
+    std::unique_ptr<VerilatedContext> context;
+    std::unique_ptr<Vnpu_top> top;
+#ifdef NPU_COSIM_TRACE
+    std::unique_ptr<VerilatedVcdC> vcd;
+#endif
+    uint64_t cycles = 0;
+
+    // Configuration
+    uint64_t freq_mhz;
+    uint64_t mem_latency;
+    uint64_t mmio_cycles;
+    uint64_t max_wait_cycles;
+
+    // PCIe streams
+    std::deque<Beat> rx_beats;
+    std::vector<uint8_t> dma_buffer;
+    size_t tx_offset = 0;
+
+    // DDR
+    std::vector<uint32_t> ddr;
+    uint64_t mem_wait = 0;
+
+    // Driver state
+    std::map<uint32_t, std::vector<uint8_t>> buffers;
+    uint32_t next_buffer_id = 1;
+    uint32_t mmap_buffer = 0;
+    std::vector<npu_completion> cq;
+    uint32_t cq_head = 0;
+    uint32_t cq_next_seq = 1;
+    uint32_t cq_submit_seq = 0;
+    bool interrupt_received = false;
+    uint64_t perf_base = 0;
+    uint64_t perf_operations = 0;
+    npu_device_config config = {};
+    npu_error_info error_info = {};
+
+    void tick();
+    void reset();
+    void cq_arm();
+    void cq_reap();
+    bool cq_reached(uint32_t seq);
+    void post_record();
+    void capture_tx();
+    void drive_rx();
+    void send_words(const uint32_t *words, size_t count);
+    long submit(const void *buf, size_t len, uint32_t *seq);
+    void mmio_read() { step(mmio_cycles); }
+    void step(uint64_t count);
+    uint64_t timeout_cycles(uint32_t timeout_ms) const;
+    uint32_t read_reg(uint32_t offset) const;
+    int ioctl(unsigned long cmd, void *arg);
+};
+
+/**
+ * Advance one core clock cycle
+ */
+void npu_cosim::tick()
+{
+    Vnpu_top *t = top.get();
+
+    // Settle outputs for the current inputs and sample the handshakes
+    t->clk = 0;
+    t->pcie_clk = 0;
+    t->eval();
+#ifdef NPU_COSIM_TRACE
+    if (vcd) {
+        vcd->dump(2 * cycles);
+    }
+#endif
+
+    const bool rx_fire = t->pcie_rx_valid && t->pcie_rx_ready;
+    const bool mem_req = !t->mem_valid && (t->mem_re || t->mem_we);
+    const uint32_t mem_addr = t->mem_addr;
+    const uint32_t mem_wdata = t->mem_wdata;
+    const bool mem_we = t->mem_we;
+
+    if (t->pcie_tx_valid && t->pcie_tx_ready) {
+        capture_tx();
+    }
+    if (t->cq_wr_valid && t->cq_wr_ready) {
+        post_record();
+    }
+
+    t->clk = 1;
+    t->pcie_clk = 1;
+    t->eval();
+#ifdef NPU_COSIM_TRACE
+    if (vcd) {
+        vcd->dump(2 * cycles + 1);
+    }
+#endif
+    cycles++;
+
+    // Inputs for the next edge
+    if (rx_fire) {
+        rx_beats.pop_front();
+    }
+    drive_rx();
+    t->perf_clear = 0;
+
+    // DDR: one access per request, answered with a one-cycle mem_valid pulse
+    if (t->mem_valid) {
+        t->mem_valid = 0;
+        mem_wait = 0;
+    } else if (mem_req && ++mem_wait >= mem_latency) {
+        const uint32_t index = mem_addr >> 2;
+        const bool mapped = index < ddr.size();
+
+        if (mem_we && mapped) {
+            ddr[index] = mem_wdata;
+        }
+        t->mem_rdata = mapped ? ddr[index] : DDR_UNMAPPED;
+        t->mem_valid = 1;
+        mem_wait = 0;
+    }
+
+    if (t->cq_irq) {
+        cq_reap();
+    }
+}
+
+void npu_cosim::step(uint64_t count)
+{
+    while (count--) {
+        tick();
+    }
+}
+
+/**
+ * Reset the RTL and re-arm the completion queue (CTRL_RESET, then CTRL_ENABLE)
+ */
+void npu_cosim::reset()
+{
+    Vnpu_top *t = top.get();
+
+    rx_beats.clear();
+    tx_offset = 0;
+    mem_wait = 0;
+
+    t->rst_n = 0;
+    t->pcie_rst_n = 0;
+    t->pcie_rx_valid = 0;
+    t->pcie_rx_keep = 0;
+    t->pcie_tx_ready = 1;
+    t->mem_rdata = 0;
+    t->mem_valid = 0;
+    t->dip_switches = 0;
+    t->pe_enable_mask = config.pe_enable_mask & ((1u << PE_COUNT) - 1);
+    t->perf_clear = 0;
+    t->cq_enable = 0;
+    t->cq_base = 0;
+    t->cq_entries = 0;
+    t->cq_head = 0;
+    t->cq_wr_ready = 1;
+    step(8);
+
+    t->rst_n = 1;
+    t->pcie_rst_n = 1;
+    step(4);
+    cq_arm();
+}
+
+void npu_cosim::cq_arm()
+{
+    Vnpu_top *t = top.get();
+
+    t->cq_enable = 0;
+    tick();
+
+    std::fill(cq.begin(), cq.end(), npu_completion{});
+    cq_head = 0;
+    cq_next_seq = 1;
+    cq_submit_seq = 0;
+
+    t->cq_base = CQ_BUS_ADDR;
+    t->cq_entries = NPU_CQ_ENTRIES;
+    t->cq_head = 0;
+    t->cq_enable = 1;
+    tick();
+}
+
+/**
+ * Completion interrupt: consume new records (as npu_cq_reap() in the driver)
+ */
+void npu_cosim::cq_reap()
+{
+    uint32_t count = 0;
+
+    for (;;) {
+        const npu_completion &rec = cq[cq_head];
+
+        if (rec.seq != cq_next_seq) {
+            break;
+        }
+        if (rec.error != NPU_CQ_ERR_NONE) {
+            error_info.error_code = rec.error;
+            error_info.error_count++;
+            error_info.timestamp = cycles * 1000 / freq_mhz;
+        }
+        cq_head = (cq_head + 1) % NPU_CQ_ENTRIES;
+        cq_next_seq++;
+        count++;
+    }
+
+    if (count) {
+        top->cq_head = cq_head;
+        interrupt_received = true;
+    }
+}
+
+bool npu_cosim::cq_reached(uint32_t seq)
+{
+    return (int32_t)(cq_next_seq - 1 - seq) >= 0;
+}
+
+/**
+ * Completion writer posted a record: land it in the host ring
+ */
+void npu_cosim::post_record()
+{
+    const uint64_t addr = top->cq_wr_addr;
+    const uint64_t slot = (addr - CQ_BUS_ADDR) / sizeof(npu_completion);
+    npu_completion rec;
+
+    if (addr < CQ_BUS_ADDR || (addr & (sizeof(npu_completion) - 1)) || slot >= cq.size()) {
+        fprintf(stderr, "npu_cosim: completion record to unmapped address 0x%llx\n",
+                (unsigned long long)addr);
+        return;
+    }
+
+    rec.seq = word_of(top->cq_wr_data, 0);
+    rec.status = word_of(top->cq_wr_data, 1);
+    rec.cycles = word_of(top->cq_wr_data, 2);
+    rec.error = word_of(top->cq_wr_data, 3);
+    cq[slot] = rec;
+}
+
+/**
+ * Result beat from the device: DMA the kept words into the shared buffer
+ */
+void npu_cosim::capture_tx()
+{
+    for (int i = 0; i < WORDS_PER_BEAT; i++) {
+        if (!(top->pcie_tx_keep & (1u << i))) {
+            continue;
+        }
+        if (tx_offset + sizeof(uint32_t) <= dma_buffer.size()) {
+            const uint32_t word = word_of(top->pcie_tx_data, i);
+            memcpy(&dma_buffer[tx_offset], &word, sizeof(word));
+        }
+        tx_offset += sizeof(uint32_t);
+    }
+}
+
+void npu_cosim::drive_rx()
+{
+    Vnpu_top *t = top.get();
+
+    if (rx_beats.empty()) {
+        t->pcie_rx_valid = 0;
+        t->pcie_rx_keep = 0;
+        return;
+    }
+
+    const Beat &beat = rx_beats.front();
+    for (int i = 0; i < WORDS_PER_BEAT; i++) {
+        t->pcie_rx_data[i] = beat.word[i];
+    }
+    t->pcie_rx_keep = beat.keep;
+    t->pcie_rx_valid = 1;
+}
+
+/**
+ * Queue instruction words on the PCIe RX stream, the last beat partial
+ */
+void npu_cosim::send_words(const uint32_t *words, size_t count)
+{
+    for (size_t i = 0; i < count; i += WORDS_PER_BEAT) {
+        Beat beat = {};
+
+        for (size_t j = 0; j < WORDS_PER_BEAT && i + j < count; j++) {
+            beat.word[j] = words[i + j];
+            beat.keep |= 1u << j;
+        }
+        rx_beats.push_back(beat);
+    }
+    drive_rx();
+}
+
+/**
+ * Stream a submission from the shared buffer and number its instructions
+ * (as npu_submit_stream() in the driver)
+ */
+long npu_cosim::submit(const void *buf, size_t len, uint32_t *seq)
+{
+    const uint32_t *words = (const uint32_t *)dma_buffer.data();
+    size_t count;
+
+    len = std::min(len, dma_buffer.size());
+    memcpy(dma_buffer.data(), buf, len);
+    count = len / sizeof(uint32_t);
+
+    // Results of this submission are DMA'd back from the start of the buffer
+    tx_offset = 0;
+    send_words(words, count);
+
+    // Routing prefixes post no record; descriptor operations span NPU_INST_MAX_WORDS
+    for (size_t i = 0; i < count;) {
+        const uint32_t opcode = words[i] >> 24;
+        const uint32_t base = opcode & NPU_OP_BASE_MASK;
+
+        if (opcode == NPU_OP_ROUTE) {
+            i++;
+            continue;
+        }
+        i += (base == NPU_OP_CONV || base == NPU_OP_MATMUL || base == NPU_OP_POOLING)
+                 ? NPU_INST_MAX_WORDS : 1;
+        cq_submit_seq++;
+    }
+    *seq = cq_submit_seq;
+    return (long)len;
+}
+
+uint64_t npu_cosim::timeout_cycles(uint32_t timeout_ms) const
+{
+    if (timeout_ms == 0) {
+        return max_wait_cycles;
+    }
+    return (uint64_t)timeout_ms * freq_mhz * 1000;
+}
+
+/**
+ * Register block as the driver sees it
+ */
+uint32_t npu_cosim::read_reg(uint32_t offset) const
+{
+    const Vnpu_top *t = top.get();
+    const uint64_t perf_cycles = cycles - perf_base;
+
+    if (offset >= REG_CORE_BASE) {
+        const uint32_t core = (offset - REG_CORE_BASE) / REG_CORE_STRIDE;
+
+        if (core >= NPU_COSIM_CORES) {
+            return 0;
+        }
+        return (offset & 4) ? word_of(t->core_busy_cycles, core)
+                            : word_of(t->core_inst_count, core);
+    }
+
+    switch (offset) {
+        case REG_CONTROL:
+            return CTRL_ENABLE;
+        case REG_STATUS: {
+            const bool busy = !rx_beats.empty() || t->core_busy || t->pcie_tx_valid;
+
+            return NPU_STATUS_READY | (busy ? NPU_STATUS_BUSY : 0) |
+                   (interrupt_received ? NPU_STATUS_DONE : 0) |
+                   (error_info.error_count ? NPU_STATUS_ERROR : 0);
+        }
+        case REG_PERF_CYCLES:
+            return (uint32_t)perf_cycles;
+        case REG_PERF_CYCLES + 4:
+            return (uint32_t)(perf_cycles >> 32);
+        case REG_TEMPERATURE:
+            return 40;
+        case REG_POWER:
+            return 0;
+        case REG_CONFIG:
+            return t->pe_enable_mask;
+        case REG_ERROR:
+            return error_info.error_code;
+        case REG_PERF_MACS:
+        case REG_PERF_MACS + 4:
+            return word_of(t->perf_macs_nominal, (offset - REG_PERF_MACS) / 4);
+        case REG_PERF_MACS_SKIPPED:
+        case REG_PERF_MACS_SKIPPED + 4:
+            return word_of(t->perf_macs_skipped, (offset - REG_PERF_MACS_SKIPPED) / 4);
+        case REG_PERF_MULT_GATED:
+        case REG_PERF_MULT_GATED + 4:
+            return word_of(t->perf_mult_gated, (offset - REG_PERF_MULT_GATED) / 4);
+        case REG_CORE_INFO:
+            return NPU_COSIM_CORES | ((uint32_t)t->core_busy << 8);
+        case REG_CQ_BASE_LO:
+            return (uint32_t)t->cq_base;
+        case REG_CQ_BASE_HI:
+            return (uint32_t)(t->cq_base >> 32);
+        case REG_CQ_CTRL:
+            return t->cq_enable ? (CQ_CTRL_ENABLE | t->cq_entries) : 0;
+        case REG_CQ_HEAD:
+            return t->cq_head;
+        case REG_CQ_TAIL:
+            return t->cq_tail;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Driver ioctl (as fpga_npu_ioctl())
+ */
+int npu_cosim::ioctl(unsigned long cmd, void *arg)
+{
+    switch (cmd) {
+        case NPU_IOCTL_NOP:
+            return 0;
+
+        case 0:                         // Legacy status read (npu_get_status)
+        case NPU_IOCTL_GET_STATUS: {
+            mmio_read();
+            *(uint32_t *)arg = read_reg(REG_STATUS);
+            return 0;
+        }
+
+        case NPU_IOCTL_GET_DEVICE_INFO: {
+            npu_device_info *info = (npu_device_info *)arg;
+
+            mmio_read();
+            memset(info, 0, sizeof(*info));
+            info->vendor_id = 0x10EE;
+            info->device_id = 0x7024;
+            snprintf(info->board_name, sizeof(info->board_name), "FPGA NPU Co-simulation");
+            info->pe_count = PE_COUNT;
+            info->max_frequency = (uint32_t)freq_mhz;
+            info->memory_size = ddr.size() * sizeof(uint32_t);
+            info->pcie_generation = 3;
+            info->pcie_lanes = 4;
+            info->core_count = NPU_COSIM_CORES;
+            return 0;
+        }
+
+        case NPU_IOCTL_GET_CQ_INFO: {
+            npu_cq_info *info = (npu_cq_info *)arg;
+
+            memset(info, 0, sizeof(*info));
+            info->enabled = 1;
+            info->entries = NPU_CQ_ENTRIES;
+            info->last_seq = cq_next_seq - 1;
+            return 0;
+        }
+
+        case NPU_IOCTL_GET_CORE_STATS: {
+            npu_core_stats *stats = (npu_core_stats *)arg;
+
+            mmio_read();
+            memset(stats, 0, sizeof(*stats));
+            stats->core_count = NPU_COSIM_CORES;
+            stats->busy_mask = (read_reg(REG_CORE_INFO) >> 8) & 0xFF;
+            for (uint32_t i = 0; i < NPU_COSIM_CORES && i < NPU_MAX_CORES; i++) {
+                stats->instructions[i] = read_reg(REG_CORE_BASE + i * REG_CORE_STRIDE);
+                stats->busy_cycles[i] = read_reg(REG_CORE_BASE + i * REG_CORE_STRIDE + 4);
+            }
+            return 0;
+        }
+
+        case NPU_IOCTL_GET_PERF_COUNTERS: {
+            npu_performance_counters *perf = (npu_performance_counters *)arg;
+
+            mmio_read();
+            memset(perf, 0, sizeof(*perf));
+            perf->counters[NPU_PERF_CYCLES] =
+                ((uint64_t)read_reg(REG_PERF_CYCLES + 4) << 32) | read_reg(REG_PERF_CYCLES);
+            perf->counters[NPU_PERF_OPERATIONS] = perf_operations;
+            perf->counters[NPU_PERF_MACS_NOMINAL] = top->perf_macs_nominal;
+            perf->counters[NPU_PERF_MACS_SKIPPED] = top->perf_macs_skipped;
+            perf->counters[NPU_PERF_MULT_GATED] = top->perf_mult_gated;
+            perf->timestamp = cycles * 1000 / freq_mhz;
+            perf->frequency_mhz = (uint32_t)freq_mhz;
+            perf->temperature_celsius = read_reg(REG_TEMPERATURE);
+            perf->power_watts = read_reg(REG_POWER);
+            return 0;
+        }
+
+        case NPU_IOCTL_RESET_PERF_COUNTERS: {
+            perf_base = cycles;
+            perf_operations = 0;
+            top->perf_clear = 1;
+            tick();
+            return 0;
+        }
+
+        case NPU_IOCTL_ALLOC_BUFFER: {
+            npu_dma_buffer *desc = (npu_dma_buffer *)arg;
+
+            if (desc->size < NPU_MIN_BUFFER_SIZE || desc->size > NPU_MAX_BUFFER_SIZE) {
+                return -EINVAL;
+            }
+
+            std::vector<uint8_t> &buf = buffers[next_buffer_id];
+            buf.assign(desc->size, 0);
+            desc->buffer_id = next_buffer_id;
+            desc->physical_addr = BUFFER_BUS_BASE + ((uint64_t)next_buffer_id << 24);
+            desc->user_addr = (uint64_t)(uintptr_t)buf.data();
+            next_buffer_id++;
+            return 0;
+        }
+
+        case NPU_IOCTL_FREE_BUFFER: {
+            const uint32_t id = (uint32_t)(uintptr_t)arg;
+
+            if (!buffers.erase(id)) {
+                return -ENOENT;
+            }
+            if (mmap_buffer == id) {
+                mmap_buffer = 0;
+            }
+            return 0;
+        }
+
+        case NPU_IOCTL_GET_BUFFER_INFO: {
+            npu_dma_buffer *desc = (npu_dma_buffer *)arg;
+            auto it = buffers.find(desc->buffer_id);
+
+            if (it == buffers.end()) {
+                return -ENOENT;
+            }
+            desc->size = it->second.size();
+            desc->physical_addr = BUFFER_BUS_BASE + ((uint64_t)desc->buffer_id << 24);
+            desc->user_addr = (uint64_t)(uintptr_t)it->second.data();
+            return 0;
+        }
+
+        case NPU_IOCTL_MMAP_REQUEST: {
+            const npu_mmap_request *req = (const npu_mmap_request *)arg;
+            auto it = buffers.find(req->buffer_id);
+
+            if (it == buffers.end()) {
+                return -ENOENT;
+            }
+            if (req->size > it->second.size()) {
+                return -EINVAL;
+            }
+            mmap_buffer = req->buffer_id;
+            return 0;
+        }
+
+        case NPU_IOCTL_DMA_SYNC:
+        case NPU_IOCTL_DMA_ABORT: {
+            return buffers.count((uint32_t)(uintptr_t)arg) ? 0 : -ENOENT;
+        }
+
+        case NPU_IOCTL_DMA_TRANSFER: {
+            const npu_dma_transfer *xfer = (const npu_dma_transfer *)arg;
+            auto it = buffers.find(xfer->buffer_id);
+            const uint64_t ddr_bytes = ddr.size() * sizeof(uint32_t);
+
+            if (it == buffers.end()) {
+                return -ENOENT;
+            }
+            if (xfer->offset + xfer->size > it->second.size() ||
+                xfer->user_addr + xfer->size > ddr_bytes) {
+                return -EINVAL;
+            }
+
+            uint8_t *host = it->second.data() + xfer->offset;
+            uint8_t *dev = (uint8_t *)ddr.data() + xfer->user_addr;
+            if (xfer->direction == 0) {
+                memcpy(dev, host, xfer->size);
+            } else {
+                memcpy(host, dev, xfer->size);
+            }
+            step((xfer->size + DMA_BYTES_PER_CYCLE - 1) / DMA_BYTES_PER_CYCLE);
+            return 0;
+        }
+
+        case NPU_IOCTL_EXECUTE_INSTRUCTION: {
+            npu_instruction *inst = (npu_instruction *)arg;
+            uint32_t words[2];
+            size_t count = 0;
+
+            if (inst->flags & NPU_INST_FLAG_TARGET_CORE) {
+                const uint32_t core = NPU_INST_CORE(inst->flags);
+
+                if (core >= NPU_COSIM_CORES) {
+                    return -EINVAL;
+                }
+                words[count++] = ((uint32_t)NPU_OP_ROUTE << 24) | (core << 16);
+            }
+            words[count++] = ((uint32_t)inst->operation << 24) |
+                             ((inst->src1_addr & 0xFF) << 16) |
+                             ((inst->src2_addr & 0xFF) << 8) |
+                             (inst->dst_addr & 0xFF);
+            send_words(words, count);
+
+            if (inst->flags & NPU_INST_FLAG_PROFILE) {
+                perf_operations++;
+            }
+            inst->seq = ++cq_submit_seq;
+            return 0;
+        }
+
+        case NPU_IOCTL_SUBMIT: {
+            npu_submit *req = (npu_submit *)arg;
+            const long len = submit((const void *)(uintptr_t)req->words, req->len, &req->seq);
+
+            req->len = (uint32_t)len;
+            return 0;
+        }
+
+        case NPU_IOCTL_WAIT_COMPLETION: {
+            const uint64_t limit = timeout_cycles(*(const uint32_t *)arg);
+            uint64_t waited = 0;
+
+            while (!interrupt_received && waited++ < limit) {
+                tick();
+            }
+            if (!interrupt_received) {
+                return -ETIMEDOUT;
+            }
+            interrupt_received = false;
+            return 0;
+        }
+
+        case NPU_IOCTL_WAIT_SEQ: {
+            const npu_cq_wait *req = (const npu_cq_wait *)arg;
+            const uint64_t limit = timeout_cycles(req->timeout_ms);
+            uint64_t waited = 0;
+
+            while (!cq_reached(req->seq) && waited++ < limit) {
+                tick();
+            }
+            if (!cq_reached(req->seq)) {
+                if (req->timeout_ms == 0) {
+                    fprintf(stderr, "npu_cosim: record %u not posted after %llu cycles\n",
+                            req->seq, (unsigned long long)limit);
+                }
+                return -ETIMEDOUT;
+            }
+            return 0;
+        }
+
+        case NPU_IOCTL_SET_CONFIG: {
+            config = *(const npu_device_config *)arg;
+            top->pe_enable_mask = config.pe_enable_mask & ((1u << PE_COUNT) - 1);
+            return 0;
+        }
+
+        case NPU_IOCTL_GET_CONFIG: {
+            *(npu_device_config *)arg = config;
+            return 0;
+        }
+
+        case NPU_IOCTL_RESET_DEVICE: {
+            reset();
+            return 0;
+        }
+
+        case NPU_IOCTL_GET_ERROR_INFO: {
+            *(npu_error_info *)arg = error_info;
+            return 0;
+        }
+
+        case NPU_IOCTL_GET_THERMAL_INFO: {
+            npu_thermal_info *thermal = (npu_thermal_info *)arg;
+
+            memset(thermal, 0, sizeof(*thermal));
+            thermal->temperature_celsius = read_reg(REG_TEMPERATURE);
+            return 0;
+        }
+
+        case NPU_IOCTL_DUMP_REGISTERS: {
+            uint32_t *regs = (uint32_t *)arg;
+
+            mmio_read();
+            for (uint32_t i = 0; i < REG_COUNT; i++) {
+                regs[i] = read_reg(i * 4);
+            }
+            return 0;
+        }
+
+        default:
+            return -ENOTTY;
+    }
+}
+
+extern "C" {
+
+int npu_cosim_abi_version(void)
+{
+    return NPU_COSIM_ABI_VERSION;
+}
+
+struct npu_cosim *npu_cosim_create(void)
+{
+    std::unique_ptr<npu_cosim> sim(new npu_cosim);
+
+    sim->freq_mhz = env_u64("NPU_COSIM_FREQ_MHZ", 300);
+    sim->mem_latency = env_u64("NPU_COSIM_MEM_LATENCY", 2);
+    sim->mmio_cycles = env_u64("NPU_COSIM_MMIO_CYCLES", 300);
+    sim->max_wait_cycles = env_u64("NPU_COSIM_MAX_WAIT_CYCLES", 100000000);
+    if (sim->freq_mhz == 0) {
+        sim->freq_mhz = 300;
+    }
+
+    sim->ddr.assign(env_u64("NPU_COSIM_DDR_MB", 64) * 1024 * 1024 / sizeof(uint32_t), 0);
+    sim->dma_buffer.assign(DMA_BUFFER_SIZE, 0);
+    sim->cq.assign(NPU_CQ_ENTRIES, npu_completion{});
+    sim->config.pe_enable_mask = (1u << PE_COUNT) - 1;
+
+    sim->context.reset(new VerilatedContext);
+    sim->top.reset(new Vnpu_top(sim->context.get()));
+
+#ifdef NPU_COSIM_TRACE
+    const char *vcd_path = getenv("NPU_COSIM_VCD");
+    if (vcd_path) {
+        sim->context->traceEverOn(true);
+        sim->vcd.reset(new VerilatedVcdC);
+        sim->top->trace(sim->vcd.get(), 99);
+        sim->vcd->open(vcd_path);
+    }
+#endif
+
+    sim->reset();
+    return sim.release();
+}
+
+void npu_cosim_destroy(struct npu_cosim *sim)
+{
+    if (!sim) {
+        return;
+    }
+
+    sim->top->final();
+#ifdef NPU_COSIM_TRACE
+    if (sim->vcd) {
+        sim->vcd->close();
+    }
+#endif
+    delete sim;
+}
+
+int npu_cosim_ioctl(struct npu_cosim *sim, unsigned long cmd, void *arg)
+{
+    if (!sim) {
+        return -ENODEV;
+    }
+    if (cmd != 0 && _IOC_TYPE(cmd) != FPGA_NPU_MAGIC) {
+        return -ENOTTY;
+    }
+    if (!arg && _IOC_DIR(cmd) != _IOC_NONE && _IOC_SIZE(cmd) > sizeof(uint32_t)) {
+        return -EFAULT;
+    }
+    return sim->ioctl(cmd, arg);
+}
+
+long npu_cosim_write(struct npu_cosim *sim, const void *buf, size_t len)
+{
+    if (!sim || !buf) {
+        return -EFAULT;
+    }
+
+    uint32_t seq;
+    return sim->submit(buf, len, &seq);
+}
+
+long npu_cosim_read(struct npu_cosim *sim, void *buf, size_t len)
+{
+    if (!sim || !buf) {
+        return -EFAULT;
+    }
+
+    len = std::min(len, sim->dma_buffer.size());
+    memcpy(buf, sim->dma_buffer.data(), len);
+    return (long)len;
+}
+
+void *npu_cosim_mmap(struct npu_cosim *sim, size_t len, long offset)
+{
+    if (!sim) {
+        return nullptr;
+    }
+
+    if (offset == NPU_CQ_MMAP_OFFSET) {
+        return len <= sim->cq.size() * sizeof(npu_completion) ? sim->cq.data() : nullptr;
+    }
+    if (offset != 0) {
+        return nullptr;
+    }
+
+    // A pending NPU_IOCTL_MMAP_REQUEST selects the buffer, else the shared buffer
+    auto it = sim->buffers.find(sim->mmap_buffer);
+    sim->mmap_buffer = 0;
+    if (it != sim->buffers.end()) {
+        return len <= it->second.size() ? it->second.data() : nullptr;
+    }
+    return len <= sim->dma_buffer.size() ? sim->dma_buffer.data() : nullptr;
+}
+
+uint64_t npu_cosim_cycles(struct npu_cosim *sim)
+{
+    return sim ? sim->cycles : 0;
+}
+
+}  // extern "C"
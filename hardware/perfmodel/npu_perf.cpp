@@ -0,0 +1,555 @@
+/**
+ * FPGA NPU Performance Model - command line
+ *
+ * Replays instruction-stream traces recorded with NPU_TRACE_FILE (or raw
+ * word streams) through npu_perf_model for one configuration or a sweep of
+ * configurations, and reports cycles, utilisation and the bounding block
+ * per opcode or per instruction as text, CSV or JSON. --calibrate fits the
+ * model's pipeline constants against the Verilator model.
+ */
+
+#include "npu_perf_model.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+enum class format { text, csv, json };
+
+struct options {
+    std::string board = "zcu102";
+    std::vector<std::pair<std::string, std::string>> sets;
+    std::vector<std::pair<std::string, std::vector<std::string>>> sweeps;
+    std::vector<std::string> configs;
+    std::vector<std::string> traces;
+    std::string calibrate;
+    std::string output;
+    uint64_t synthetic = 0;
+    bool per_op = false;
+    format fmt = format::text;
+};
+
+struct run {
+    std::string trace;
+    std::vector<std::pair<std::string, std::string>> point;    // Swept values
+    npu_perf_config cfg;
+    npu_perf_summary sum;
+    std::vector<npu_perf_op> ops;
+    double wall_s = 0.0;
+};
+
+void usage(const char *prog)
+{
+    printf("Usage: %s [options] <trace>...\n", prog);
+    printf("\n");
+    printf("Predict NPU cycles for instruction streams recorded with NPU_TRACE_FILE.\n");
+    printf("\n");
+    printf("Options:\n");
+    printf("  -b, --board NAME          Preset: zcu102 (default), vcu118, cosim\n");
+    printf("  -s, --set NAME=VALUE      Set one parameter (repeatable)\n");
+    printf("  -c, --config FILE         Load NAME=VALUE lines, e.g. a calibration\n");
+    printf("  -S, --sweep NAME=V1,V2..  Sweep a parameter; repeat for a grid\n");
+    printf("  -o, --ops                 Report every instruction\n");
+    printf("  -f, --format FMT          text (default), csv or json\n");
+    printf("  -w, --output FILE         Write the report (or calibration) to FILE\n");
+    printf("  -n, --synthetic N         Model N generated instructions instead of a trace\n");
+    printf("      --calibrate LIB       Fit pipeline constants against libnpu_cosim.so,\n");
+    printf("                            on the probe set or on the given trace\n");
+    printf("  -p, --params              List parameters with their values and exit\n");
+    printf("  -h, --help                Show this help\n");
+}
+
+bool split_assign(const std::string &arg, std::string &name, std::string &value)
+{
+    size_t eq = arg.find('=');
+
+    if (eq == std::string::npos || eq == 0) {
+        return false;
+    }
+    name = arg.substr(0, eq);
+    value = arg.substr(eq + 1);
+    return true;
+}
+
+bool load_config(const std::string &path, npu_perf_config &cfg)
+{
+    FILE *f = fopen(path.c_str(), "r");
+    char line[256];
+    int lineno = 0;
+
+    if (!f) {
+        fprintf(stderr, "npu_perf: %s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    while (fgets(line, sizeof(line), f)) {
+        std::string s(line), name, value;
+
+        lineno++;
+        s = s.substr(0, s.find_first_of("#\r\n"));
+        s.erase(0, s.find_first_not_of(" \t"));
+        s.erase(s.find_last_not_of(" \t") + 1);
+        if (s.empty()) {
+            continue;
+        }
+        if (!split_assign(s, name, value) || !cfg.set(name, value)) {
+            fprintf(stderr, "npu_perf: %s:%d: bad parameter '%s'\n", path.c_str(), lineno, s.c_str());
+            fclose(f);
+            return false;
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+/**
+ * Mix of element-wise, activation, convolution and pooling instructions
+ */
+void synthetic_stream(uint64_t count, npu_perf_model &model)
+{
+    static const uint32_t conv[9] = {
+        0x05000000, 0x0, 0x40000, 0x80000, 0,
+        (1 << 16) | 1, (1 << 16) | 1, (16 << 16) | 16, (3u << 24) | (8 << 12) | 16,
+    };
+    std::vector<uint32_t> words;
+
+    words.reserve(4096);
+    for (uint64_t i = 0; i < count; i++) {
+        switch (i % 8) {
+            case 0: case 1: case 2: words.push_back(0x01030400); break;   // ADD
+            case 3: words.push_back(0x04030400); break;                   // MAC
+            case 4: words.push_back(0x07050000); break;                   // RELU
+            case 5: words.push_back(0x10100000); break;                   // LOAD
+            case 6: words.push_back(0x21030400); break;                   // ADD + ReLU
+            default: words.insert(words.end(), conv, conv + 9); break;
+        }
+        if (words.size() >= 4000) {
+            model.write(words.data(), words.size());
+            words.clear();
+        }
+    }
+    model.write(words.data(), words.size());
+    model.wait();
+}
+
+bool run_one(const options &opt, const std::string &trace, run &r)
+{
+    std::string err;
+
+    if (!r.cfg.validate(err)) {
+        fprintf(stderr, "npu_perf: %s\n", err.c_str());
+        return false;
+    }
+
+    npu_perf_model model(r.cfg);
+    auto start = std::chrono::steady_clock::now();
+
+    model.record_ops(opt.per_op);
+    if (opt.synthetic) {
+        synthetic_stream(opt.synthetic, model);
+    } else if (!npu_perf_replay(model, trace, err)) {
+        fprintf(stderr, "npu_perf: %s\n", err.c_str());
+        return false;
+    }
+    r.wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    r.trace = opt.synthetic ? "synthetic" : trace;
+    r.sum = model.summary();
+    r.ops = model.ops();
+    return true;
+}
+
+npu_perf_bound dominant(const uint64_t bound[4])
+{
+    int best = 0;
+
+    for (int i = 1; i < 4; i++) {
+        if (bound[i] > bound[best]) {
+            best = i;
+        }
+    }
+    return (npu_perf_bound)best;
+}
+
+void print_text(FILE *out, const run &r)
+{
+    const npu_perf_summary &s = r.sum;
+
+    fprintf(out, "Trace: %s\n", r.trace.c_str());
+    for (const auto &p : r.point) {
+        fprintf(out, "  %s=%s\n", p.first.c_str(), p.second.c_str());
+    }
+    fprintf(out, "  Cycles:          %llu (%.3f ms at %.0f MHz)\n", (unsigned long long)s.cycles,
+            s.seconds(r.cfg) * 1e3, r.cfg.freq_mhz);
+    fprintf(out, "  Instructions:    %llu (%llu results, %llu rejected)\n",
+            (unsigned long long)s.instructions, (unsigned long long)s.results,
+            (unsigned long long)s.errors);
+    fprintf(out, "  MACs:            %llu\n", (unsigned long long)s.macs);
+    fprintf(out, "  PE utilisation:  %.1f%%\n", 100.0 * s.pe_utilisation(r.cfg));
+    fprintf(out, "  Core busy:       %.1f%%\n", 100.0 * s.core_utilisation(r.cfg));
+    fprintf(out, "  Memory port:     %.1f%% (%llu accesses)\n", 100.0 * s.mem_utilisation(),
+            (unsigned long long)s.mem_accesses);
+    fprintf(out, "  PCIe:            %.1f%% (%llu words, %llu DMA bytes)\n",
+            100.0 * s.pcie_utilisation(r.cfg), (unsigned long long)s.words,
+            (unsigned long long)s.dma_bytes);
+    fprintf(out, "  Model speed:     %.2f M instructions/s\n",
+            r.wall_s > 0 ? s.instructions / r.wall_s / 1e6 : 0.0);
+
+    fprintf(out, "\n  %-8s %10s %14s %12s %14s  %s\n", "opcode", "count", "cycles", "avg", "macs", "bound");
+    for (uint32_t opcode = 0; opcode < 256; opcode++) {
+        const npu_perf_class &c = s.opcodes[opcode];
+        if (!c.count) {
+            continue;
+        }
+        fprintf(out, "  0x%02x     %10llu %14llu %12.1f %14llu  %s\n", opcode,
+                (unsigned long long)c.count, (unsigned long long)c.cycles,
+                (double)c.cycles / c.count, (unsigned long long)c.macs,
+                npu_perf_bound_name(dominant(c.bound)));
+    }
+
+    if (!r.ops.empty()) {
+        fprintf(out, "\n  %8s %6s %4s %12s %10s %10s %12s  %s\n", "index", "opcode", "core",
+                "issue", "cycles", "starve", "mem", "bound");
+        for (const npu_perf_op &op : r.ops) {
+            fprintf(out, "  %8llu   0x%02x %4u %12llu %10llu %10llu %12llu  %s%s\n",
+                    (unsigned long long)op.index, op.opcode, op.core,
+                    (unsigned long long)op.issue, (unsigned long long)op.cycles,
+                    (unsigned long long)op.starve, (unsigned long long)op.mem_cycles,
+                    npu_perf_bound_name(op.bound), op.error ? " (rejected)" : "");
+        }
+    }
+    fprintf(out, "\n");
+}
+
+void print_csv(FILE *out, const std::vector<run> &runs, bool per_op)
+{
+    if (per_op) {
+        fprintf(out, "trace");
+        if (!runs.empty()) {
+            for (const auto &p : runs[0].point) {
+                fprintf(out, ",%s", p.first.c_str());
+            }
+        }
+        fprintf(out, ",index,opcode,core,issue,done,cycles,starve,mem_accesses,mem_cycles,macs,bound,error\n");
+        for (const run &r : runs) {
+            for (const npu_perf_op &op : r.ops) {
+                fprintf(out, "%s", r.trace.c_str());
+                for (const auto &p : r.point) {
+                    fprintf(out, ",%s", p.second.c_str());
+                }
+                fprintf(out, ",%llu,%u,%u,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%s,%d\n",
+                        (unsigned long long)op.index, op.opcode, op.core,
+                        (unsigned long long)op.issue, (unsigned long long)op.done,
+                        (unsigned long long)op.cycles, (unsigned long long)op.starve,
+                        (unsigned long long)op.mem_accesses, (unsigned long long)op.mem_cycles,
+                        (unsigned long long)op.macs, npu_perf_bound_name(op.bound), op.error);
+            }
+        }
+        return;
+    }
+
+    fprintf(out, "trace");
+    if (!runs.empty()) {
+        for (const auto &p : runs[0].point) {
+            fprintf(out, ",%s", p.first.c_str());
+        }
+    }
+    fprintf(out, ",cycles,seconds,instructions,results,rejected,macs,pe_util,core_util,"
+                 "mem_util,pcie_util,bound\n");
+    for (const run &r : runs) {
+        fprintf(out, "%s", r.trace.c_str());
+        for (const auto &p : r.point) {
+            fprintf(out, ",%s", p.second.c_str());
+        }
+        fprintf(out, ",%llu,%.9f,%llu,%llu,%llu,%llu,%.4f,%.4f,%.4f,%.4f,%s\n",
+                (unsigned long long)r.sum.cycles, r.sum.seconds(r.cfg),
+                (unsigned long long)r.sum.instructions, (unsigned long long)r.sum.results,
+                (unsigned long long)r.sum.errors, (unsigned long long)r.sum.macs,
+                r.sum.pe_utilisation(r.cfg), r.sum.core_utilisation(r.cfg),
+                r.sum.mem_utilisation(), r.sum.pcie_utilisation(r.cfg),
+                npu_perf_bound_name(dominant(r.sum.bound)));
+    }
+}
+
+void print_json(FILE *out, const std::vector<run> &runs)
+{
+    fprintf(out, "[\n");
+    for (size_t i = 0; i < runs.size(); i++) {
+        const run &r = runs[i];
+        const npu_perf_summary &s = r.sum;
+
+        fprintf(out, "  {\n    \"trace\": \"%s\",\n    \"config\": {", r.trace.c_str());
+        std::vector<std::string> cfg = r.cfg.dump();
+        for (size_t k = 0; k < cfg.size(); k++) {
+            size_t eq = cfg[k].find('=');
+            fprintf(out, "%s\"%s\": %s", k ? ", " : "", cfg[k].substr(0, eq).c_str(),
+                    cfg[k].substr(eq + 1).c_str());
+        }
+        fprintf(out, "},\n");
+        fprintf(out, "    \"cycles\": %llu, \"seconds\": %.9f, \"instructions\": %llu, "
+                     "\"results\": %llu, \"rejected\": %llu, \"macs\": %llu,\n",
+                (unsigned long long)s.cycles, s.seconds(r.cfg), (unsigned long long)s.instructions,
+                (unsigned long long)s.results, (unsigned long long)s.errors,
+                (unsigned long long)s.macs);
+        fprintf(out, "    \"pe_util\": %.4f, \"core_util\": %.4f, \"mem_util\": %.4f, "
+                     "\"pcie_util\": %.4f, \"bound\": \"%s\",\n",
+                s.pe_utilisation(r.cfg), s.core_utilisation(r.cfg), s.mem_utilisation(),
+                s.pcie_utilisation(r.cfg), npu_perf_bound_name(dominant(s.bound)));
+
+        fprintf(out, "    \"opcodes\": [");
+        size_t n = 0;
+        for (uint32_t opcode = 0; opcode < 256; opcode++) {
+            const npu_perf_class &c = s.opcodes[opcode];
+            if (!c.count) {
+                continue;
+            }
+            fprintf(out, "%s\n      {\"opcode\": %u, \"count\": %llu, \"cycles\": %llu, "
+                         "\"macs\": %llu, \"mem_accesses\": %llu, \"bound\": \"%s\"}",
+                    n++ ? "," : "", opcode, (unsigned long long)c.count,
+                    (unsigned long long)c.cycles, (unsigned long long)c.macs,
+                    (unsigned long long)c.mem_accesses, npu_perf_bound_name(dominant(c.bound)));
+        }
+        fprintf(out, "\n    ]");
+
+        if (!r.ops.empty()) {
+            fprintf(out, ",\n    \"ops\": [");
+            for (size_t k = 0; k < r.ops.size(); k++) {
+                const npu_perf_op &op = r.ops[k];
+                fprintf(out, "%s\n      {\"index\": %llu, \"opcode\": %u, \"core\": %u, "
+                             "\"issue\": %llu, \"cycles\": %llu, \"starve\": %llu, "
+                             "\"mem_cycles\": %llu, \"macs\": %llu, \"bound\": \"%s\", "
+                             "\"rejected\": %s}",
+                        k ? "," : "", (unsigned long long)op.index, op.opcode, op.core,
+                        (unsigned long long)op.issue, (unsigned long long)op.cycles,
+                        (unsigned long long)op.starve, (unsigned long long)op.mem_cycles,
+                        (unsigned long long)op.macs, npu_perf_bound_name(op.bound),
+                        op.error ? "true" : "false");
+            }
+            fprintf(out, "\n    ]");
+        }
+        fprintf(out, "\n  }%s\n", i + 1 < runs.size() ? "," : "");
+    }
+    fprintf(out, "]\n");
+}
+
+/**
+ * Every point of the sweep grid, as name/value lists
+ */
+std::vector<std::vector<std::pair<std::string, std::string>>> grid(const options &opt)
+{
+    std::vector<std::vector<std::pair<std::string, std::string>>> points(1);
+
+    for (const auto &sweep : opt.sweeps) {
+        std::vector<std::vector<std::pair<std::string, std::string>>> next;
+        for (const auto &p : points) {
+            for (const std::string &v : sweep.second) {
+                next.push_back(p);
+                next.back().emplace_back(sweep.first, v);
+            }
+        }
+        points.swap(next);
+    }
+    return points;
+}
+
+bool base_config(const options &opt, npu_perf_config &cfg)
+{
+    if (!cfg.preset(opt.board)) {
+        fprintf(stderr, "npu_perf: unknown board '%s'\n", opt.board.c_str());
+        return false;
+    }
+    for (const std::string &path : opt.configs) {
+        if (!load_config(path, cfg)) {
+            return false;
+        }
+    }
+    for (const auto &s : opt.sets) {
+        if (!cfg.set(s.first, s.second)) {
+            fprintf(stderr, "npu_perf: bad parameter %s=%s\n", s.first.c_str(), s.second.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    static const struct option long_opts[] = {
+        {"board", required_argument, nullptr, 'b'},
+        {"set", required_argument, nullptr, 's'},
+        {"config", required_argument, nullptr, 'c'},
+        {"sweep", required_argument, nullptr, 'S'},
+        {"ops", no_argument, nullptr, 'o'},
+        {"format", required_argument, nullptr, 'f'},
+        {"output", required_argument, nullptr, 'w'},
+        {"synthetic", required_argument, nullptr, 'n'},
+        {"calibrate", required_argument, nullptr, 'C'},
+        {"params", no_argument, nullptr, 'p'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+    options opt;
+    bool list_params = false;
+    int c;
+
+    while ((c = getopt_long(argc, argv, "b:s:c:S:of:w:n:ph", long_opts, nullptr)) != -1) {
+        std::string name, value;
+
+        switch (c) {
+            case 'b':
+                opt.board = optarg;
+                break;
+            case 's':
+                if (!split_assign(optarg, name, value)) {
+                    fprintf(stderr, "npu_perf: expected NAME=VALUE, got '%s'\n", optarg);
+                    return 1;
+                }
+                opt.sets.emplace_back(name, value);
+                break;
+            case 'c':
+                opt.configs.push_back(optarg);
+                break;
+            case 'S': {
+                std::vector<std::string> values;
+                if (!split_assign(optarg, name, value)) {
+                    fprintf(stderr, "npu_perf: expected NAME=V1,V2,..., got '%s'\n", optarg);
+                    return 1;
+                }
+                for (size_t pos = 0; pos <= value.size();) {
+                    size_t comma = value.find(',', pos);
+                    if (comma == std::string::npos) {
+                        comma = value.size();
+                    }
+                    values.push_back(value.substr(pos, comma - pos));
+                    pos = comma + 1;
+                }
+                opt.sweeps.emplace_back(name, values);
+                break;
+            }
+            case 'o':
+                opt.per_op = true;
+                break;
+            case 'f':
+                if (strcmp(optarg, "text") == 0) {
+                    opt.fmt = format::text;
+                } else if (strcmp(optarg, "csv") == 0) {
+                    opt.fmt = format::csv;
+                } else if (strcmp(optarg, "json") == 0) {
+                    opt.fmt = format::json;
+                } else {
+                    fprintf(stderr, "npu_perf: unknown format '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'w':
+                opt.output = optarg;
+                break;
+            case 'n':
+                opt.synthetic = strtoull(optarg, nullptr, 0);
+                break;
+            case 'C':
+                opt.calibrate = optarg;
+                break;
+            case 'p':
+                list_params = true;
+                break;
+            case 'h':
+                usage(argv[0]);
+                return 0;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    for (int i = optind; i < argc; i++) {
+        opt.traces.push_back(argv[i]);
+    }
+
+    npu_perf_config base;
+    if (!base_config(opt, base)) {
+        return 1;
+    }
+
+    if (list_params) {
+        for (const std::string &line : base.dump()) {
+            printf("%s\n", line.c_str());
+        }
+        return 0;
+    }
+
+    FILE *out = stdout;
+    if (!opt.output.empty()) {
+        out = fopen(opt.output.c_str(), "w");
+        if (!out) {
+            fprintf(stderr, "npu_perf: %s: %s\n", opt.output.c_str(), strerror(errno));
+            return 1;
+        }
+    }
+
+    if (!opt.calibrate.empty()) {
+        std::string err;
+        if (!npu_perf_calibrate(opt.calibrate, opt.traces.empty() ? "" : opt.traces[0], base,
+                                stderr, err)) {
+            fprintf(stderr, "npu_perf: calibration failed: %s\n", err.c_str());
+            return 1;
+        }
+        fprintf(out, "# npu_perf --calibrate %s\n", opt.calibrate.c_str());
+        fprintf(out, "mem_overhead=%g\nop_overhead=%g\n", base.mem_overhead, base.op_overhead);
+        if (out != stdout) {
+            fclose(out);
+        }
+        return 0;
+    }
+
+    if (opt.traces.empty() && !opt.synthetic) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (opt.synthetic) {
+        opt.traces.assign(1, "");
+    }
+
+    std::vector<run> runs;
+    for (const std::string &trace : opt.traces) {
+        for (const auto &point : grid(opt)) {
+            run r;
+            r.cfg = base;
+            r.point = point;
+            for (const auto &p : point) {
+                if (!r.cfg.set(p.first, p.second)) {
+                    fprintf(stderr, "npu_perf: bad sweep value %s=%s\n", p.first.c_str(),
+                            p.second.c_str());
+                    return 1;
+                }
+            }
+            if (!run_one(opt, trace, r)) {
+                return 1;
+            }
+            if (opt.fmt == format::text) {
+                print_text(out, r);
+                r.ops.clear();
+            }
+            runs.push_back(std::move(r));
+        }
+    }
+
+    if (opt.fmt == format::csv) {
+        print_csv(out, runs, opt.per_op);
+    } else if (opt.fmt == format::json) {
+        print_json(out, runs);
+    }
+
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}
@@ -0,0 +1,415 @@
+/**
+ * FPGA NPU Performance Model Calibration
+ *
+ * Runs an instruction stream on the Verilator model (libnpu_cosim.so, loaded
+ * with dlopen() through the npu_cosim.h ABI) and on the performance model,
+ * pairs every completion record with the model's prediction for the same
+ * instruction, and fits the two constants the RTL does not pin down by
+ * least squares:
+ *
+ *   cycles = fixed + accesses * (mem_latency + mem_overhead) + op_overhead
+ *
+ * Streams go out in chunks that leave fewer results outstanding than the
+ * completion ring holds, so no record is overwritten before it is read.
+ * The co-simulated DDR starts zeroed and trace DMAs are not replayed, so
+ * the fit runs with act_density = 0: ZERO_SKIP issues one tap per window.
+ */
+
+#include "npu_perf_model.h"
+#include "npu_cosim.h"
+#include "npu_trace.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <dlfcn.h>
+#include <map>
+
+#ifndef BIT
+#define BIT(n) (1u << (n))
+#endif
+
+#include "../../software/driver/fpga_npu_enhanced.h"
+
+namespace {
+
+constexpr uint32_t OP_CONV     = 0x05;
+constexpr uint32_t OP_MATMUL   = 0x06;
+constexpr uint32_t OP_POOLING  = 0x09;
+constexpr uint32_t OP_ROUTE    = 0x1F;
+constexpr uint32_t OP_BASE_MASK = 0x1F;
+constexpr uint32_t DESC_WORDS  = 8;
+constexpr uint32_t CHUNK_RESULTS = NPU_CQ_ENTRIES / 2;
+constexpr uint32_t WAIT_TIMEOUT_MS = 60000;
+
+struct cosim_lib {
+    void *handle = nullptr;
+    struct npu_cosim *sim = nullptr;
+    int (*abi_version)(void);
+    struct npu_cosim *(*create)(void);
+    void (*destroy)(struct npu_cosim *);
+    int (*ioctl)(struct npu_cosim *, unsigned long, void *);
+    long (*write)(struct npu_cosim *, const void *, size_t);
+    void *(*mmap)(struct npu_cosim *, size_t, long);
+
+    ~cosim_lib()
+    {
+        if (sim) {
+            destroy(sim);
+        }
+        if (handle) {
+            dlclose(handle);
+        }
+    }
+};
+
+template <typename T>
+bool resolve(void *handle, const char *name, T &fn)
+{
+    fn = reinterpret_cast<T>(dlsym(handle, name));
+    return fn != nullptr;
+}
+
+// One probe: opcode, three operand bytes, and the descriptor for CONV/MATMUL/POOLING
+void push_inst(std::vector<uint32_t> &s, uint32_t opcode, uint32_t a = 0, uint32_t b = 0,
+               uint32_t c = 0)
+{
+    s.push_back((opcode << 24) | ((a & 0xFF) << 16) | ((b & 0xFF) << 8) | (c & 0xFF));
+}
+
+void push_route(std::vector<uint32_t> &s, uint32_t core, uint32_t mask)
+{
+    s.push_back((OP_ROUTE << 24) | ((core & 0xFF) << 16) | (mask & 0xFFFF));
+}
+
+void push_conv(std::vector<uint32_t> &s, uint32_t act, uint32_t h, uint32_t w, uint32_t k,
+               uint32_t in_c, uint32_t out_c, uint32_t stride, uint32_t pad, bool sparse)
+{
+    push_inst(s, OP_CONV | (act << 5));
+    s.push_back(0x0000);                                // input
+    s.push_back(0x40000);                               // weights
+    s.push_back(0x80000);                               // output
+    s.push_back(out_c * h * w * 4);
+    s.push_back((stride << 16) | stride);
+    s.push_back((pad << 16) | pad);
+    s.push_back((h << 16) | w);
+    s.push_back((k << 24) | ((in_c & 0xFFF) << 12) | (out_c & 0xFFF) | (sparse ? 1u << 28 : 0));
+}
+
+void push_pool(std::vector<uint32_t> &s, uint32_t h, uint32_t w, uint32_t k, uint32_t c,
+               uint32_t stride, uint32_t pad, uint32_t mode)
+{
+    push_inst(s, OP_POOLING);
+    s.push_back(0x0000);
+    s.push_back((h << 16) | w);
+    s.push_back(0x80000);
+    s.push_back(c * h * w * 4);
+    s.push_back((k << 16) | k);
+    s.push_back((stride << 16) | stride);
+    s.push_back((pad << 16) | pad);
+    s.push_back(((c & 0xFFF) << 8) | mode);
+}
+
+/**
+ * Probe set covering every FSM path and the conv_engine loop terms
+ */
+std::vector<uint32_t> probe_stream(uint32_t pe_count)
+{
+    std::vector<uint32_t> s;
+
+    for (int i = 0; i < 4; i++) {
+        push_inst(s, 0x01, 3, 4, 0);            // ADD
+        push_inst(s, 0x03, 3, 4, 0);            // MUL
+        push_inst(s, 0x04, 3, 4, 0);            // MAC
+        push_inst(s, 0x01 | (1 << 5), 3, 4, 0); // ADD + ReLU epilogue
+        push_inst(s, 0x07, 5, 0, 0);            // RELU
+        push_inst(s, 0x08, 5, 0, 0);            // SIGMOID
+        push_inst(s, 0x10, 0x10, 0, 0);         // LOAD
+        push_inst(s, 0x11, 0, 0, 0x20);         // STORE
+    }
+
+    push_conv(s, 0, 4, 4, 1, 1, 1, 1, 0, false);
+    push_conv(s, 0, 8, 8, 3, 1, 4, 1, 1, false);
+    push_conv(s, 1, 8, 8, 3, 3, pe_count, 1, 1, false);
+    push_conv(s, 0, 16, 16, 3, 2, pe_count + 4, 2, 1, false);
+    push_conv(s, 0, 12, 12, 5, 2, 8, 1, 2, false);
+    push_conv(s, 0, 8, 8, 3, 2, 8, 1, 1, true);
+    push_route(s, 0xFF, 0x000F);
+    push_conv(s, 0, 8, 8, 3, 2, 8, 1, 1, false);
+
+    push_pool(s, 8, 8, 2, 4, 2, 0, 0);
+    push_pool(s, 8, 8, 3, 2, 1, 1, 1);
+    push_pool(s, 16, 16, 1, 3, 1, 0, 2);
+    return s;
+}
+
+/**
+ * Words of every NPU_TRACE_WORDS record of a trace, or of a raw stream
+ */
+bool trace_words(const std::string &path, std::vector<uint32_t> &words, std::string &err)
+{
+    FILE *f = fopen(path.c_str(), "rb");
+    npu_trace_header header;
+    npu_trace_record rec;
+    uint32_t buf[4096];
+    size_t n;
+
+    if (!f) {
+        err = path + ": " + strerror(errno);
+        return false;
+    }
+
+    if (fread(&header, sizeof(header), 1, f) != 1 || header.magic != NPU_TRACE_MAGIC) {
+        rewind(f);
+        while ((n = fread(buf, sizeof(uint32_t), 4096, f)) > 0) {
+            words.insert(words.end(), buf, buf + n);
+        }
+        fclose(f);
+        return true;
+    }
+
+    while (fread(&rec, sizeof(rec), 1, f) == 1) {
+        if (rec.type != NPU_TRACE_WORDS) {
+            continue;
+        }
+        size_t at = words.size();
+        words.resize(at + rec.count);
+        if (fread(words.data() + at, sizeof(uint32_t), rec.count, f) != rec.count) {
+            fclose(f);
+            err = path + ": truncated trace";
+            return false;
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+struct sample {
+    uint32_t opcode;
+    double accesses;
+    double predicted;       // Model cycles with the current constants
+    double measured;        // Completion record cycles
+};
+
+/**
+ * Split a stream after whole instructions, at most CHUNK_RESULTS per chunk
+ */
+std::vector<std::pair<size_t, size_t>> chunks(const std::vector<uint32_t> &s)
+{
+    std::vector<std::pair<size_t, size_t>> out;
+    size_t start = 0, i = 0;
+    uint32_t n = 0;
+
+    while (i < s.size()) {
+        uint32_t opcode = s[i] >> 24;
+        uint32_t base = opcode & OP_BASE_MASK;
+
+        if (opcode == OP_ROUTE) {
+            i++;
+            continue;
+        }
+        i += (base == OP_CONV || base == OP_MATMUL || base == OP_POOLING) ? 1 + DESC_WORDS : 1;
+        i = std::min(i, s.size());
+        if (++n == CHUNK_RESULTS) {
+            out.emplace_back(start, i);
+            start = i;
+            n = 0;
+        }
+    }
+    if (start < s.size()) {
+        out.emplace_back(start, s.size());
+    }
+    return out;
+}
+
+/**
+ * Run the stream on both models and pair up results in completion order
+ */
+bool collect(cosim_lib &lib, const std::vector<uint32_t> &stream, const npu_perf_config &cfg,
+             std::vector<sample> &samples, std::string &err)
+{
+    const npu_completion *ring;
+    npu_cq_info info;
+    npu_perf_model model(cfg);
+    uint32_t seq;
+
+    if (lib.ioctl(lib.sim, NPU_IOCTL_GET_CQ_INFO, &info) < 0 || !info.enabled) {
+        err = "co-simulation model has no completion queue";
+        return false;
+    }
+    ring = static_cast<const npu_completion *>(
+        lib.mmap(lib.sim, NPU_CQ_ENTRIES * sizeof(npu_completion), NPU_CQ_MMAP_OFFSET));
+    if (!ring) {
+        err = "cannot map the completion queue";
+        return false;
+    }
+    seq = info.last_seq;
+
+    model.record_ops(true);
+    for (const auto &chunk : chunks(stream)) {
+        const uint32_t *words = stream.data() + chunk.first;
+        size_t count = chunk.second - chunk.first;
+        size_t first_op = model.ops().size();
+        std::vector<npu_perf_op> results;
+
+        if (lib.write(lib.sim, words, count * sizeof(uint32_t)) != (long)(count * sizeof(uint32_t))) {
+            err = "co-simulation write failed";
+            return false;
+        }
+        model.write(words, count);
+        model.wait();
+
+        for (size_t i = first_op; i < model.ops().size(); i++) {
+            if (model.ops()[i].result) {
+                results.push_back(model.ops()[i]);
+            }
+        }
+        std::stable_sort(results.begin(), results.end(),
+                         [](const npu_perf_op &a, const npu_perf_op &b) { return a.done < b.done; });
+        if (results.empty()) {
+            continue;
+        }
+
+        npu_cq_wait req = { seq + (uint32_t)results.size(), WAIT_TIMEOUT_MS };
+        if (lib.ioctl(lib.sim, NPU_IOCTL_WAIT_SEQ, &req) < 0) {
+            err = "co-simulation wait timed out";
+            return false;
+        }
+
+        for (const npu_perf_op &op : results) {
+            const npu_completion &rec = ring[seq % NPU_CQ_ENTRIES];
+
+            seq++;
+            if (rec.seq != seq || NPU_CQ_STATUS_OPCODE(rec.status) != op.opcode) {
+                continue;           // Completion order differs from the model
+            }
+            samples.push_back(sample{op.opcode, (double)op.mem_accesses,
+                                     (double)op.cycles, (double)rec.cycles});
+        }
+    }
+    return true;
+}
+
+/**
+ * Mean absolute relative error per opcode
+ */
+void report_error(FILE *out, const char *title, const std::vector<sample> &samples)
+{
+    std::map<uint32_t, std::pair<double, int>> by_op;
+    double total = 0.0;
+
+    for (const sample &s : samples) {
+        double e = std::fabs(s.predicted - s.measured) / std::max(1.0, s.measured);
+        by_op[s.opcode].first += e;
+        by_op[s.opcode].second++;
+        total += e;
+    }
+
+    fprintf(out, "%s: mean error %.2f%% over %zu instructions\n", title,
+            samples.empty() ? 0.0 : 100.0 * total / samples.size(), samples.size());
+    for (const auto &kv : by_op) {
+        fprintf(out, "  opcode 0x%02x  %4d  %6.2f%%\n", kv.first, kv.second.second,
+                100.0 * kv.second.first / kv.second.second);
+    }
+}
+
+}  // namespace
+
+bool npu_perf_calibrate(const std::string &lib_path, const std::string &trace,
+                        npu_perf_config &cfg, FILE *report, std::string &err)
+{
+    cosim_lib lib;
+    npu_device_info info;
+    std::vector<uint32_t> stream;
+    std::vector<sample> samples;
+
+    if (!cfg.validate(err)) {
+        return false;
+    }
+
+    lib.handle = dlopen(lib_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!lib.handle) {
+        err = dlerror();
+        return false;
+    }
+    if (!resolve(lib.handle, "npu_cosim_abi_version", lib.abi_version) ||
+        !resolve(lib.handle, "npu_cosim_create", lib.create) ||
+        !resolve(lib.handle, "npu_cosim_destroy", lib.destroy) ||
+        !resolve(lib.handle, "npu_cosim_ioctl", lib.ioctl) ||
+        !resolve(lib.handle, "npu_cosim_write", lib.write) ||
+        !resolve(lib.handle, "npu_cosim_mmap", lib.mmap)) {
+        err = lib_path + ": missing npu_cosim symbols";
+        return false;
+    }
+    if (lib.abi_version() != NPU_COSIM_ABI_VERSION) {
+        err = lib_path + ": ABI version mismatch";
+        return false;
+    }
+
+    lib.sim = lib.create();
+    if (!lib.sim) {
+        err = "cannot create co-simulation instance";
+        return false;
+    }
+
+    // Shape of the Verilated build and timing of its DDR model
+    if (lib.ioctl(lib.sim, NPU_IOCTL_GET_DEVICE_INFO, &info) == 0) {
+        cfg.pe_count = info.pe_count ? info.pe_count : cfg.pe_count;
+        cfg.core_count = info.core_count ? info.core_count : 1;
+    }
+    const char *latency = getenv("NPU_COSIM_MEM_LATENCY");
+    cfg.mem_latency = latency ? (uint32_t)strtoul(latency, nullptr, 0) : 2;
+    cfg.preset("cosim");
+    cfg.act_density = 0.0;
+
+    if (trace.empty()) {
+        stream = probe_stream(cfg.pe_count);
+    } else if (!trace_words(trace, stream, err)) {
+        return false;
+    }
+
+    if (!collect(lib, stream, cfg, samples, err)) {
+        return false;
+    }
+    if (samples.empty()) {
+        err = "no completion records matched the model";
+        return false;
+    }
+    report_error(report, "Before", samples);
+
+    // Least squares for a = mem_overhead, b = op_overhead on
+    // measured - fixed = a * accesses + b
+    double sxx = 0, sx = 0, sy = 0, sxy = 0, n = samples.size();
+    for (sample &s : samples) {
+        double fixed = s.predicted - s.accesses * cfg.mem_overhead - cfg.op_overhead;
+        double y = s.measured - fixed;
+        sxx += s.accesses * s.accesses;
+        sx += s.accesses;
+        sy += y;
+        sxy += s.accesses * y;
+    }
+    double det = n * sxx - sx * sx;
+    double a = cfg.mem_overhead, b;
+    if (std::fabs(det) > 1e-9) {
+        a = (n * sxy - sx * sy) / det;
+        b = (sy - a * sx) / n;
+    } else {
+        b = (sy - a * sx) / n;
+    }
+    cfg.mem_overhead = std::max(0.0, a);
+    cfg.op_overhead = std::max(0.0, b);
+
+    // Measure again with the fitted constants on a fresh instance
+    lib.destroy(lib.sim);
+    lib.sim = lib.create();
+    samples.clear();
+    if (!lib.sim || !collect(lib, stream, cfg, samples, err)) {
+        if (err.empty()) {
+            err = "cannot create co-simulation instance";
+        }
+        return false;
+    }
+    report_error(report, "After", samples);
+    return true;
+}
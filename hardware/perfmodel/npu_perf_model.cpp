@@ -0,0 +1,671 @@
+/**
+ * FPGA NPU Performance Model
+ *
+ * Timing rules, all in core clock cycles, from the RTL in hardware/rtl:
+ *
+ *   npu_core     IDLE (accept) -> DECODE -> EXECUTE -> [ACTIVATE] -> WRITEBACK
+ *                CONV/POOLING: DECODE -> FETCH_DESC (8 words, one per cycle
+ *                as they arrive) -> CONV_RUN (start + engine + done) -> WRITEBACK
+ *                MATMUL: as CONV, a 1x1 convolution of B (K channels, N pixels)
+ *                by A (M output channels); oversized shapes skip CONV_RUN
+ *                LOAD/STORE: EXECUTE -> MEMORY_ACCESS (one access)
+ *                other opcodes: EXECUTE -> IDLE, no result
+ *   conv_engine  CHECK, DIVIDE (3 x 33), CHECK_SIZE, then per output-channel
+ *                group and input channel: weight load, plane stream, per
+ *                window COMPUTE (one cycle per issued tap) + DRAIN, then
+ *                ACCUMULATE or ACTIVATE + WRITE; NEXT_PLANE; FINISH
+ *   memory       an access costs mem_latency + mem_overhead cycles from the
+ *                cycle the request is raised to the cycle after mem_valid
+ *                (+ arb_overhead behind mem_arbiter); idle lanes and padding
+ *                pixels take one cycle without an access
+ */
+
+#include "npu_perf_model.h"
+#include "npu_trace.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+// Opcodes (must match npu_core.sv)
+constexpr uint32_t OP_ADD      = 0x01;
+constexpr uint32_t OP_MAC      = 0x04;
+constexpr uint32_t OP_CONV     = 0x05;
+constexpr uint32_t OP_MATMUL   = 0x06;
+constexpr uint32_t OP_RELU     = 0x07;
+constexpr uint32_t OP_SIGMOID  = 0x08;
+constexpr uint32_t OP_POOLING  = 0x09;
+constexpr uint32_t OP_TANH     = 0x0B;
+constexpr uint32_t OP_LOAD     = 0x10;
+constexpr uint32_t OP_STORE    = 0x11;
+constexpr uint32_t OP_ROUTE    = 0x1F;
+constexpr uint32_t OP_BASE_MASK = 0x1F;
+constexpr uint32_t EPILOGUE_SHIFT = 5;
+constexpr uint32_t CORE_ANY    = 0xFF;
+
+constexpr uint32_t DESC_WORDS  = 8;
+constexpr uint32_t DIVIDE_CYCLES = 3 * 33;      // out_h, out_w, reciprocal
+constexpr uint32_t POOL_GLOBAL_AVG = 2;
+constexpr uint32_t CONV_SPARSE_2_4 = 1u << 28;
+
+struct param {
+    const char *name;
+    uint32_t npu_perf_config::*u;
+    double npu_perf_config::*d;
+};
+
+const param params[] = {
+    {"pe_count", &npu_perf_config::pe_count, nullptr},
+    {"core_count", &npu_perf_config::core_count, nullptr},
+    {"pcie_data_width", &npu_perf_config::pcie_data_width, nullptr},
+    {"rx_fifo_depth", &npu_perf_config::rx_fifo_depth, nullptr},
+    {"conv_max_kernel", &npu_perf_config::conv_max_kernel, nullptr},
+    {"conv_max_width", &npu_perf_config::conv_max_width, nullptr},
+    {"conv_max_out_pixels", &npu_perf_config::conv_max_out_pixels, nullptr},
+    {"zero_skip", &npu_perf_config::zero_skip, nullptr},
+    {"freq_mhz", nullptr, &npu_perf_config::freq_mhz},
+    {"pcie_gbps", nullptr, &npu_perf_config::pcie_gbps},
+    {"ddr_gbps", nullptr, &npu_perf_config::ddr_gbps},
+    {"mem_latency", &npu_perf_config::mem_latency, nullptr},
+    {"mem_overhead", nullptr, &npu_perf_config::mem_overhead},
+    {"arb_overhead", nullptr, &npu_perf_config::arb_overhead},
+    {"op_overhead", nullptr, &npu_perf_config::op_overhead},
+    {"pe_latency", &npu_perf_config::pe_latency, nullptr},
+    {"act_latency", &npu_perf_config::act_latency, nullptr},
+    {"cq_latency", &npu_perf_config::cq_latency, nullptr},
+    {"act_density", nullptr, &npu_perf_config::act_density},
+    {"host_write_ns", nullptr, &npu_perf_config::host_write_ns},
+    {"host_wait_ns", nullptr, &npu_perf_config::host_wait_ns},
+    {"dma_setup_ns", nullptr, &npu_perf_config::dma_setup_ns},
+};
+
+uint64_t ceil_div(uint64_t a, uint64_t b)
+{
+    return (a + b - 1) / b;
+}
+
+uint32_t popcount(uint32_t v)
+{
+    return (uint32_t)__builtin_popcount(v);
+}
+
+}  // namespace
+
+bool npu_perf_config::set(const std::string &name, const std::string &value)
+{
+    char *end;
+    double v = strtod(value.c_str(), &end);
+
+    if (value.empty() || *end != '\0' || v < 0) {
+        return false;
+    }
+
+    for (const param &p : params) {
+        if (name != p.name) {
+            continue;
+        }
+        if (p.u) {
+            this->*p.u = (uint32_t)v;
+        } else {
+            this->*p.d = v;
+        }
+        return true;
+    }
+    return false;
+}
+
+bool npu_perf_config::preset(const std::string &board)
+{
+    if (board == "zcu102") {
+        // hardware/configs/zcu102_config.sh: PCIe Gen3 x4, 300 MHz, DDR4-2400 x64
+        freq_mhz = 300.0;
+        pcie_gbps = 3.94;
+        ddr_gbps = 19.2;
+        host_write_ns = 2000.0;
+        host_wait_ns = 5000.0;
+        dma_setup_ns = 3000.0;
+    } else if (board == "vcu118") {
+        // hardware/configs/vcu118_config.sh: PCIe Gen4 x16, 400 MHz, 2x DDR4-2400
+        freq_mhz = 400.0;
+        pcie_gbps = 31.5;
+        ddr_gbps = 38.4;
+        host_write_ns = 2000.0;
+        host_wait_ns = 5000.0;
+        dma_setup_ns = 3000.0;
+    } else if (board == "cosim") {
+        // hardware/cosim: one beat per cycle, DMA at 16 bytes per cycle, free host
+        freq_mhz = 300.0;
+        pcie_gbps = 16.0 * 300.0 / 1000.0;
+        ddr_gbps = 16.0 * 300.0 / 1000.0;
+        host_write_ns = 0.0;
+        host_wait_ns = 0.0;
+        dma_setup_ns = 0.0;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool npu_perf_config::validate(std::string &err) const
+{
+    // PE lanes are tracked in 32-bit masks; the route prefix core byte
+    // reserves 0xFF for "any core"
+    const struct {
+        const char *name;
+        double value, min, max;
+    } limits[] = {
+        {"pe_count", (double)pe_count, 1, 32},
+        {"core_count", (double)core_count, 1, 255},
+        {"rx_fifo_depth", (double)rx_fifo_depth, 1, UINT32_MAX},
+        {"pcie_data_width", (double)pcie_data_width, 32, 1024},
+    };
+    char buf[128];
+
+    for (const auto &l : limits) {
+        if (l.value < l.min || l.value > l.max) {
+            snprintf(buf, sizeof(buf), "%s=%g out of range [%g, %g]", l.name, l.value, l.min, l.max);
+            err = buf;
+            return false;
+        }
+    }
+    if (freq_mhz <= 0) {
+        err = "freq_mhz must be greater than 0";
+        return false;
+    }
+    return true;
+}
+
+std::vector<std::string> npu_perf_config::dump() const
+{
+    std::vector<std::string> out;
+    char buf[128];
+
+    for (const param &p : params) {
+        if (p.u) {
+            snprintf(buf, sizeof(buf), "%s=%u", p.name, this->*p.u);
+        } else {
+            snprintf(buf, sizeof(buf), "%s=%g", p.name, this->*p.d);
+        }
+        out.push_back(buf);
+    }
+    return out;
+}
+
+const char *npu_perf_bound_name(npu_perf_bound bound)
+{
+    switch (bound) {
+        case npu_perf_bound::compute: return "compute";
+        case npu_perf_bound::memory:  return "memory";
+        case npu_perf_bound::pcie:    return "pcie";
+        case npu_perf_bound::host:    return "host";
+    }
+    return "?";
+}
+
+double npu_perf_summary::seconds(const npu_perf_config &cfg) const
+{
+    return cycles / (cfg.freq_mhz * 1e6);
+}
+
+double npu_perf_summary::pe_utilisation(const npu_perf_config &cfg) const
+{
+    double capacity = (double)cfg.pe_count * cfg.core_count * cycles;
+
+    return capacity > 0 ? macs / capacity : 0.0;
+}
+
+double npu_perf_summary::core_utilisation(const npu_perf_config &cfg) const
+{
+    double capacity = (double)cfg.core_count * cycles;
+
+    return capacity > 0 ? core_busy / capacity : 0.0;
+}
+
+double npu_perf_summary::mem_utilisation() const
+{
+    return cycles ? std::min(1.0, (double)mem_busy / cycles) : 0.0;
+}
+
+double npu_perf_summary::pcie_utilisation(const npu_perf_config &cfg) const
+{
+    double capacity = cfg.pcie_gbps * 1000.0 / cfg.freq_mhz * cycles;
+
+    return capacity > 0 ? std::min(1.0, (words * 4.0 + dma_bytes) / capacity) : 0.0;
+}
+
+npu_perf_model::npu_perf_model(const npu_perf_config &cfg)
+    : cfg_(cfg)
+{
+    double ddr_bytes_per_cycle = cfg_.ddr_gbps * 1000.0 / cfg_.freq_mhz;
+    double pcie_bytes_per_cycle = cfg_.pcie_gbps * 1000.0 / cfg_.freq_mhz;
+
+    // One 32-bit access in flight per requester
+    access_cycles_ = std::max(cfg_.mem_latency + cfg_.mem_overhead, 4.0 / ddr_bytes_per_cycle);
+    if (cfg_.core_count > 1) {
+        access_cycles_ += cfg_.arb_overhead;
+    }
+
+    // At most one beat per cycle out of the RX FIFO, and no faster than the link
+    words_per_cycle_ = std::min(cfg_.pcie_data_width / 32.0, pcie_bytes_per_cycle / 4.0);
+    words_per_cycle_ = std::max(words_per_cycle_, 1e-6);
+    dma_bytes_per_cycle_ = std::max(std::min(pcie_bytes_per_cycle, ddr_bytes_per_cycle), 1e-6);
+    lanes_all_ = cfg_.pe_count;
+
+    consumed_.assign(cfg_.rx_fifo_depth, 0);
+    core_free_.assign(cfg_.core_count, 0);
+    jobs_.assign(cfg_.core_count, job{0, 0, 0.0});
+}
+
+/**
+ * Cycle word (stream index) is readable from the RX FIFO
+ */
+uint64_t npu_perf_model::word_arrival(uint64_t word)
+{
+    double t = link_ + 1.0 / words_per_cycle_;
+
+    link_host_bound_ = host_ >= t;
+    t = std::max(t, host_);
+
+    // The FIFO slot frees when the word depth places earlier is consumed
+    if (word >= cfg_.rx_fifo_depth) {
+        t = std::max(t, (double)consumed_[word % cfg_.rx_fifo_depth]);
+    }
+
+    link_ = t;
+    return (uint64_t)std::ceil(t);
+}
+
+void npu_perf_model::consume(uint64_t word, uint64_t cycle)
+{
+    consumed_[word % cfg_.rx_fifo_depth] = cycle;
+}
+
+/**
+ * Memory-port share of the jobs still running on other cores at cycle at
+ */
+double npu_perf_model::mem_load(uint32_t core, uint64_t at) const
+{
+    double load = 0.0;
+
+    for (uint32_t c = 0; c < cfg_.core_count; c++) {
+        if (c != core && jobs_[c].end > at) {
+            load += jobs_[c].mem_share;
+        }
+    }
+    return load;
+}
+
+void npu_perf_model::conv_cost(uint32_t opcode, const uint32_t *desc, uint32_t lanes,
+                               npu_perf_op &op, uint64_t &busy) const
+{
+    const uint32_t base = opcode & OP_BASE_MASK;
+    const bool pool = base == OP_POOLING;
+    const double m = access_cycles_;
+    uint32_t in_h, in_w, in_c, out_c, kh, kw, sh, sw, ph, pw, mode = 0;
+    bool sparse = false;
+
+    if (base == OP_MATMUL) {
+        // npu_core rejects M, K or N wider than the engine fields in FETCH_DESC
+        if (desc[4] > 0xFFF || desc[5] > 0xFFF || desc[6] > 0xFFFF) {
+            op.error = true;
+            busy = 0;
+            return;
+        }
+        out_c = desc[4];
+        in_c = desc[5];
+        in_h = desc[6];
+        in_w = 1;
+        kh = kw = sh = sw = 1;
+        ph = pw = 0;
+    } else if (pool) {
+        in_h = desc[1] >> 16;
+        in_w = desc[1] & 0xFFFF;
+        kh = (desc[4] >> 16) & 0xF;
+        kw = desc[4] & 0xF;
+        sh = (desc[5] >> 16) & 0xF;
+        sw = desc[5] & 0xF;
+        ph = (desc[6] >> 16) & 0xF;
+        pw = desc[6] & 0xF;
+        in_c = (desc[7] >> 8) & 0xFFF;
+        out_c = in_c;
+        mode = desc[7] & 0x3;
+        if (mode == POOL_GLOBAL_AVG) {
+            kh = kw = sh = sw = 1;
+            ph = pw = 0;
+        }
+    } else {
+        sh = (desc[4] >> 16) & 0xF;
+        sw = desc[4] & 0xF;
+        ph = (desc[5] >> 16) & 0xF;
+        pw = desc[5] & 0xF;
+        in_h = desc[6] >> 16;
+        in_w = desc[6] & 0xFFFF;
+        kh = kw = (desc[7] >> 24) & 0xF;
+        in_c = (desc[7] >> 12) & 0xFFF;
+        out_c = desc[7] & 0xFFF;
+        sparse = (desc[7] & CONV_SPARSE_2_4) != 0;
+    }
+
+    const bool global_pool = pool && mode == POOL_GLOBAL_AVG;
+    const uint64_t padded_h = in_h + 2 * ph;
+    const uint64_t padded_w = in_w + 2 * pw;
+    const uint64_t kk = (uint64_t)kh * kw;
+    double cycles = 1 + DIVIDE_CYCLES;          // CHECK, DIVIDE
+    uint64_t accesses = 0;
+
+    op.error = !(pool || lanes != 0) || kh == 0 || kh > cfg_.conv_max_kernel ||
+               kw == 0 || kw > cfg_.conv_max_kernel || sh == 0 || sw == 0 ||
+               in_c == 0 || out_c == 0 || padded_h < kh || padded_w < kw ||
+               (!global_pool && padded_w > cfg_.conv_max_width) || (pool && mode == 3);
+    if (op.error) {
+        busy = 2;                               // CHECK -> FINISH
+        return;
+    }
+
+    const uint64_t out_h = global_pool ? 1 : (padded_h - kh) / sh + 1;
+    const uint64_t out_w = global_pool ? 1 : (padded_w - kw) / sw + 1;
+    const uint64_t out_pixels = out_h * out_w;
+
+    cycles += 1;                                // CHECK_SIZE
+    if (out_pixels > cfg_.conv_max_out_pixels) {
+        op.error = true;
+        busy = (uint64_t)cycles + 1;            // FINISH
+        return;
+    }
+
+    const uint64_t real = (uint64_t)in_h * in_w;
+    const uint64_t pads = padded_h * padded_w - real;
+
+    if (pool) {
+        // Per channel: one weight-load cycle, the plane, and a write per output
+        uint64_t per_plane = global_pool ? 0 : out_pixels * kk;
+        cycles += in_c * (1.0 + real * m + pads + per_plane + out_pixels * m + 1);
+        accesses = in_c * (real + out_pixels);
+        op.macs = in_c * (global_pool ? real : out_pixels * kk);
+    } else {
+        const uint64_t groups = ceil_div(out_c, lanes);
+        const uint64_t sp_groups = (kk + 3) / 4;
+        const uint64_t sp_meta = (sp_groups + 7) / 8;
+        const uint64_t sp_slots = 2 * sp_groups;
+        uint64_t taps;
+
+        if (sparse) {
+            taps = sp_slots;
+        } else if (cfg_.zero_skip) {
+            taps = std::max<uint64_t>(1, (uint64_t)std::llround(kk * std::min(1.0, cfg_.act_density)));
+        } else {
+            taps = kk;
+        }
+
+        for (uint64_t g = 0; g < groups; g++) {
+            const uint64_t active = std::min<uint64_t>(lanes, out_c - g * lanes);
+            const uint64_t idle = lanes_all_ - active;
+            const uint64_t w_reads = active * (sparse ? sp_meta + sp_slots : kk);
+            const uint64_t w_idle = idle * (sparse ? sp_slots : kk);
+
+            // Every input channel: weights, plane stream, windows, NEXT_PLANE
+            cycles += in_c * (w_reads * m + w_idle + real * m + pads +
+                              out_pixels * (taps + cfg_.pe_latency) + 1);
+            accesses += in_c * (w_reads + real);
+
+            // ACCUMULATE after all but the last channel; ACTIVATE and WRITE after it
+            cycles += (in_c - 1) * out_pixels;
+            cycles += out_pixels * (cfg_.act_latency + active * m + idle);
+            accesses += out_pixels * active;
+        }
+        op.macs = (uint64_t)out_c * in_c * out_pixels * kk;
+    }
+
+    cycles += 1;                                // FINISH
+    op.mem_accesses = accesses;
+    op.mem_cycles = (uint64_t)std::llround(accesses * m);
+    busy = (uint64_t)std::llround(cycles);
+}
+
+void npu_perf_model::issue(const uint32_t *words, size_t count, uint32_t route_core,
+                           uint32_t route_mask, uint64_t first_word)
+{
+    const uint32_t opcode = words[0] >> 24;
+    const uint32_t base = opcode & OP_BASE_MASK;
+    const uint32_t epilogue = opcode >> EPILOGUE_SHIFT;
+    const uint64_t head = word_arrival(first_word);
+    const bool host_bound = link_host_bound_;
+    npu_perf_op op;
+    uint32_t core;
+    uint64_t t, ready, busy;
+
+    // Pick the core: the routed one, else the first to go idle in round-robin order
+    if (route_core != CORE_ANY && route_core < cfg_.core_count) {
+        core = route_core;
+    } else {
+        core = issue_rr_;
+        for (uint32_t k = 1; k < cfg_.core_count; k++) {
+            uint32_t c = (issue_rr_ + k) % cfg_.core_count;
+            if (std::max(dist_free_, core_free_[c]) < std::max(dist_free_, core_free_[core])) {
+                core = c;
+            }
+        }
+        issue_rr_ = (core + 1) % cfg_.core_count;
+    }
+
+    ready = std::max(dist_free_, core_free_[core]);
+    t = std::max(head, ready);
+    consume(first_word, t);
+
+    op.index = index_++;
+    op.opcode = opcode;
+    op.core = core;
+    op.issue = t;
+    op.starve = head > ready ? head - ready : 0;
+
+    uint32_t lanes = route_mask ? popcount(route_mask & (uint32_t)((1ull << lanes_all_) - 1))
+                                : lanes_all_;
+
+    if ((base == OP_CONV || base == OP_MATMUL || base == OP_POOLING) && count == 1 + DESC_WORDS) {
+        // FETCH_DESC takes one descriptor word per cycle as they arrive
+        uint64_t f = t + 1;
+        for (uint32_t k = 0; k < DESC_WORDS; k++) {
+            f = std::max(f + 1, word_arrival(first_word + 1 + k));
+            consume(first_word + 1 + k, f);
+        }
+        conv_cost(opcode, words + 1, lanes, op, busy);
+        op.done = f + 1 + busy + 1;             // conv_start, engine, conv_done
+        op.result = true;
+        dist_free_ = f + 1;
+    } else if (base >= OP_ADD && base <= OP_MAC) {
+        op.done = t + 3 + (epilogue ? cfg_.act_latency : 0);
+        op.result = true;
+        dist_free_ = t + 1;
+    } else if (base == OP_RELU || base == OP_SIGMOID || base == OP_TANH) {
+        op.done = t + 3 + cfg_.act_latency;
+        op.result = true;
+        dist_free_ = t + 1;
+    } else if (base == OP_LOAD || base == OP_STORE) {
+        op.mem_accesses = 1;
+        op.mem_cycles = (uint64_t)std::llround(access_cycles_);
+        op.done = t + 2 + op.mem_cycles;
+        op.result = true;
+        dist_free_ = t + 1;
+    } else {
+        // Unimplemented opcode: EXECUTE falls back to IDLE with no result
+        op.done = t + 2;
+        dist_free_ = t + 1;
+    }
+
+    if (op.result) {
+        op.done += (uint64_t)std::llround(cfg_.op_overhead);
+    }
+
+    // Memory port shared with the other cores through mem_arbiter
+    if (op.mem_cycles && cfg_.core_count > 1) {
+        double span = (double)(op.done - t);
+        double share = std::min(1.0, op.mem_cycles / span);
+        double slow = std::max(1.0, mem_load(core, t) + share);
+
+        op.done += (uint64_t)std::llround(op.mem_cycles * (slow - 1.0));
+        op.mem_cycles = (uint64_t)std::llround(op.mem_cycles * slow);
+        jobs_[core] = job{t, op.done, share};
+    }
+
+    op.cycles = op.done - op.issue;
+    core_free_[core] = op.done + 1;
+
+    if (op.starve > op.cycles) {
+        op.bound = host_bound ? npu_perf_bound::host : npu_perf_bound::pcie;
+    } else if (op.mem_cycles * 2 > op.cycles) {
+        op.bound = npu_perf_bound::memory;
+    } else {
+        op.bound = npu_perf_bound::compute;
+    }
+
+    retire(op);
+}
+
+void npu_perf_model::retire(const npu_perf_op &op)
+{
+    sum_.instructions++;
+    sum_.results += op.result;
+    sum_.errors += op.error;
+    sum_.macs += op.error ? 0 : op.macs;
+    sum_.mem_accesses += op.mem_accesses;
+    sum_.mem_busy += op.mem_accesses * (uint64_t)std::llround(access_cycles_);
+    sum_.core_busy += op.done - op.issue + 1;
+    sum_.bound[(int)op.bound] += op.cycles;
+
+    npu_perf_class &c = sum_.opcodes[op.opcode & 0xFF];
+    c.count++;
+    c.cycles += op.cycles;
+    c.macs += op.error ? 0 : op.macs;
+    c.mem_accesses += op.mem_accesses;
+    c.bound[(int)op.bound] += op.cycles;
+
+    last_done_ = std::max(last_done_, op.done);
+    sum_.cycles = std::max<uint64_t>(sum_.cycles, last_done_);
+
+    if (keep_ops_) {
+        ops_.push_back(op);
+    }
+}
+
+void npu_perf_model::write(const uint32_t *words, size_t count)
+{
+    uint32_t route_core = CORE_ANY;
+    uint32_t route_mask = 0;
+    size_t i = 0;
+
+    host_ += cfg_.host_write_ns * cfg_.freq_mhz / 1000.0;
+
+    while (i < count) {
+        const uint32_t opcode = words[i] >> 24;
+        const uint32_t base = opcode & OP_BASE_MASK;
+        uint64_t word = words_in_ + i;
+
+        if (opcode == OP_ROUTE) {
+            // Route prefix: the distributor consumes it in one cycle
+            uint64_t t = std::max(word_arrival(word), dist_free_);
+            consume(word, t);
+            dist_free_ = t + 1;
+            route_core = (words[i] >> 16) & 0xFF;
+            route_mask = words[i] & 0xFFFF;
+            i++;
+            continue;
+        }
+
+        size_t n = (base == OP_CONV || base == OP_MATMUL || base == OP_POOLING) ? 1 + DESC_WORDS : 1;
+        n = std::min(n, count - i);
+        issue(words + i, n, route_core, route_mask, word);
+        route_core = CORE_ANY;
+        route_mask = 0;
+        i += n;
+    }
+
+    words_in_ += count;
+    sum_.words += count;
+}
+
+void npu_perf_model::wait()
+{
+    host_ = std::max(host_, (double)(last_done_ + cfg_.cq_latency));
+    host_ += cfg_.host_wait_ns * cfg_.freq_mhz / 1000.0;
+    sum_.cycles = std::max(sum_.cycles, (uint64_t)std::ceil(host_));
+}
+
+void npu_perf_model::dma(uint64_t bytes)
+{
+    double cycles = bytes / dma_bytes_per_cycle_;
+
+    host_ += cfg_.dma_setup_ns * cfg_.freq_mhz / 1000.0;
+    host_ = std::max(host_, link_) + cycles;
+    link_ = host_;                              // Instruction words queue behind the DMA
+
+    sum_.dma_bytes += bytes;
+    sum_.dma_cycles += (uint64_t)std::ceil(cycles);
+    sum_.mem_busy += (uint64_t)std::ceil(bytes / 4.0);
+    sum_.cycles = std::max(sum_.cycles, (uint64_t)std::ceil(host_));
+}
+
+bool npu_perf_replay(npu_perf_model &model, const std::string &path, std::string &err)
+{
+    FILE *f = fopen(path.c_str(), "rb");
+    npu_trace_header header;
+    std::vector<uint32_t> words;
+
+    if (!f) {
+        err = path + ": " + strerror(errno);
+        return false;
+    }
+
+    // Anything without the trace header is a raw instruction stream
+    if (fread(&header, sizeof(header), 1, f) != 1 || header.magic != NPU_TRACE_MAGIC) {
+        uint32_t buf[4096];
+        size_t n;
+
+        rewind(f);
+        while ((n = fread(buf, sizeof(uint32_t), 4096, f)) > 0) {
+            words.insert(words.end(), buf, buf + n);
+        }
+        fclose(f);
+        model.write(words.data(), words.size());
+        model.wait();
+        return true;
+    }
+
+    if (header.version != NPU_TRACE_VERSION) {
+        fclose(f);
+        err = path + ": unsupported trace version " + std::to_string(header.version);
+        return false;
+    }
+
+    npu_trace_record rec;
+    while (fread(&rec, sizeof(rec), 1, f) == 1) {
+        switch (rec.type) {
+            case NPU_TRACE_WORDS:
+                words.resize(rec.count);
+                if (fread(words.data(), sizeof(uint32_t), rec.count, f) != rec.count) {
+                    fclose(f);
+                    err = path + ": truncated trace";
+                    return false;
+                }
+                model.write(words.data(), words.size());
+                break;
+            case NPU_TRACE_WAIT:
+                model.wait();
+                break;
+            case NPU_TRACE_DMA:
+                model.dma(rec.count);
+                break;
+            default:
+                fclose(f);
+                err = path + ": unknown record type " + std::to_string(rec.type);
+                return false;
+        }
+    }
+
+    fclose(f);
+    return true;
+}
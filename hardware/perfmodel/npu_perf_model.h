@@ -0,0 +1,250 @@
+/**
+ * FPGA NPU Performance Model
+ *
+ * Transaction-level timing model of npu_top for design-space exploration.
+ * It consumes the instruction streams libfpga_npu emits (npu_trace.h) and
+ * predicts, per instruction, the issue-to-result cycles the completion
+ * record would report, the memory traffic and the block that bounds it,
+ * for any PE count, core count, PCIe width and link rate, DDR latency and
+ * bandwidth, and convolution line-buffer/partial-sum capacity.
+ *
+ * Nothing is simulated per clock. Every block is reduced to the few events
+ * that decide its timing:
+ *
+ *   - PCIe RX: word arrival times at the link rate, limited to one beat
+ *     per cycle and back-pressured by the RX FIFO depth
+ *   - work_distributor: in-order, one word per cycle, round-robin issue
+ *     to idle cores or to the core named by a route prefix
+ *   - npu_core: the FSM path of each opcode (DECODE, FETCH_DESC,
+ *     EXECUTE, ACTIVATE, MEMORY_ACCESS, WRITEBACK)
+ *   - conv_engine: closed-form cycle count of its loop nest (weight load,
+ *     plane stream, window compute, drain, accumulate, write) per output
+ *     channel group and input channel
+ *   - memory port: one outstanding 32-bit access per requester, shared
+ *     through mem_arbiter as a fluid approximation of round-robin
+ *   - host DMA: buffer syncs at the lower of PCIe and DDR bandwidth
+ *
+ * The fixed costs that depend on pipeline details (access overhead beyond
+ * the DDR latency, per-instruction overhead) are configuration values
+ * that npu_perf --calibrate fits against the Verilator model.
+ */
+
+#ifndef NPU_PERF_MODEL_H
+#define NPU_PERF_MODEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+struct npu_perf_config {
+    // Architecture (npu_top / npu_core parameters)
+    uint32_t pe_count = 16;             // PE_COUNT, also the conv output-channel group
+    uint32_t core_count = 1;            // CORE_COUNT
+    uint32_t pcie_data_width = 128;     // PCIE_DATA_WIDTH, bits per beat
+    uint32_t rx_fifo_depth = 512;       // pcie_controller RX FIFO, words
+    uint32_t conv_max_kernel = 5;       // CONV_MAX_KERNEL
+    uint32_t conv_max_width = 64;       // CONV_MAX_WIDTH, line-buffer width
+    uint32_t conv_max_out_pixels = 1024; // CONV_MAX_OUT_PIXELS, partial-sum buffer
+    uint32_t zero_skip = 1;             // conv_engine ZERO_SKIP
+
+    // Board
+    double freq_mhz = 300.0;            // Core clock
+    double pcie_gbps = 3.94;            // Link payload bandwidth, GB/s
+    double ddr_gbps = 19.2;             // DDR bandwidth, GB/s
+    uint32_t mem_latency = 2;           // DDR request-to-response cycles
+
+    // Pipeline constants (npu_perf --calibrate)
+    double mem_overhead = 2.0;          // Requester cycles per access beyond mem_latency
+    double arb_overhead = 1.0;          // Extra cycles per access through mem_arbiter
+    double op_overhead = 0.0;           // Cycles added to every instruction
+    uint32_t pe_latency = 2;            // MAC issue to PE result
+    uint32_t act_latency = 3;           // Activation unit in to out
+    uint32_t cq_latency = 2;            // Result to completion record visible
+
+    // Workload and host
+    double act_density = 1.0;           // Non-zero fraction of conv inputs (ZERO_SKIP)
+    double host_write_ns = 0.0;         // Host cost of one write() of instructions
+    double host_wait_ns = 0.0;          // Host cost of one completion wait
+    double dma_setup_ns = 0.0;          // Host cost of one buffer sync
+
+    /**
+     * Set a field by name (value parsed as a number)
+     * @return false for an unknown name or bad value
+     */
+    bool set(const std::string &name, const std::string &value);
+
+    /**
+     * Apply a board preset: zcu102, vcu118 or cosim
+     * @return false for an unknown preset
+     */
+    bool preset(const std::string &board);
+
+    /**
+     * Check that the architecture fields are within what the RTL supports
+     * @return false with a message in err for an out-of-range field
+     */
+    bool validate(std::string &err) const;
+
+    /**
+     * Names and values of every field, one "name=value" per entry
+     */
+    std::vector<std::string> dump() const;
+};
+
+// Block that bounds an instruction
+enum class npu_perf_bound {
+    compute,    // Core or PE array busy
+    memory,     // Memory port accesses dominate
+    pcie,       // Core idle waiting for instruction words on the link
+    host,       // Core idle waiting for the host to send
+};
+
+const char *npu_perf_bound_name(npu_perf_bound bound);
+
+// Timing of one instruction
+struct npu_perf_op {
+    uint64_t index = 0;         // Instruction number in the stream
+    uint32_t opcode = 0;        // Full opcode byte, epilogue included
+    uint32_t core = 0;
+    uint64_t issue = 0;         // Cycle the core accepted the instruction
+    uint64_t done = 0;          // Cycle the result left the core
+    uint64_t cycles = 0;        // done - issue, as in the completion record
+    uint64_t starve = 0;        // Cycles the core sat idle before issue
+    uint64_t mem_accesses = 0;
+    uint64_t mem_cycles = 0;    // Part of cycles spent on memory accesses
+    uint64_t macs = 0;          // Nominal multiply-accumulates
+    bool result = false;        // Produces a result and a completion record
+    bool error = false;         // Rejected by the convolution engine
+    npu_perf_bound bound = npu_perf_bound::compute;
+};
+
+// Totals of the instructions sharing one opcode byte
+struct npu_perf_class {
+    uint64_t count = 0;
+    uint64_t cycles = 0;
+    uint64_t macs = 0;
+    uint64_t mem_accesses = 0;
+    uint64_t bound[4] = {};         // Cycles by npu_perf_bound
+};
+
+// Whole-stream totals
+struct npu_perf_summary {
+    uint64_t cycles = 0;            // Last result or host event
+    uint64_t instructions = 0;
+    uint64_t results = 0;
+    uint64_t errors = 0;            // Descriptors the RTL would reject
+    uint64_t words = 0;             // Instruction words over PCIe
+    uint64_t dma_bytes = 0;
+    uint64_t dma_cycles = 0;
+    uint64_t macs = 0;
+    uint64_t mem_accesses = 0;
+    uint64_t mem_busy = 0;          // Cycles the memory port was serving
+    uint64_t core_busy = 0;         // Sum over cores
+    uint64_t bound[4] = {};         // Cycles of instructions by npu_perf_bound
+    npu_perf_class opcodes[256];    // By opcode byte
+
+    double seconds(const npu_perf_config &cfg) const;
+    double pe_utilisation(const npu_perf_config &cfg) const;
+    double core_utilisation(const npu_perf_config &cfg) const;
+    double mem_utilisation() const;
+    double pcie_utilisation(const npu_perf_config &cfg) const;
+};
+
+class npu_perf_model {
+public:
+    /**
+     * @param cfg Configuration that passes npu_perf_config::validate()
+     */
+    explicit npu_perf_model(const npu_perf_config &cfg);
+
+    /**
+     * Host write() of an instruction stream
+     */
+    void write(const uint32_t *words, size_t count);
+
+    /**
+     * Host waits until every instruction written so far has completed
+     */
+    void wait();
+
+    /**
+     * Host buffer sync of bytes over PCIe (blocking)
+     */
+    void dma(uint64_t bytes);
+
+    /**
+     * Keep per-instruction records in ops() (off by default)
+     */
+    void record_ops(bool enable) { keep_ops_ = enable; }
+
+    const std::vector<npu_perf_op> &ops() const { return ops_; }
+    const npu_perf_summary &summary() const { return sum_; }
+    const npu_perf_config &config() const { return cfg_; }
+
+    /**
+     * Cycles and memory accesses of one CONV or POOLING descriptor on a
+     * core with lanes enabled PE lanes, without memory contention
+     */
+    void conv_cost(uint32_t opcode, const uint32_t *desc, uint32_t lanes,
+                   npu_perf_op &op, uint64_t &busy) const;
+
+private:
+    struct job {
+        uint64_t start;
+        uint64_t end;
+        double mem_share;       // Fraction of the job spent on memory accesses
+    };
+
+    uint64_t word_arrival(uint64_t word);
+    void consume(uint64_t word, uint64_t cycle);
+    void issue(const uint32_t *words, size_t count, uint32_t route_core, uint32_t route_mask,
+               uint64_t first_word);
+    double mem_load(uint32_t core, uint64_t at) const;
+    void retire(const npu_perf_op &op);
+
+    npu_perf_config cfg_;
+    double access_cycles_;          // One memory access, uncontended
+    double words_per_cycle_;        // PCIe RX word rate
+    double dma_bytes_per_cycle_;
+    uint32_t lanes_all_;
+
+    // Host and link
+    double host_ = 0;               // Host time, cycles
+    double link_ = 0;               // Arrival time of the last word on the link
+    bool link_host_bound_ = false;  // Last word waited on the host, not the link
+    uint64_t words_in_ = 0;         // Words sent so far
+    std::vector<uint64_t> consumed_; // Consume cycle of recent words (RX FIFO depth)
+
+    // Distributor and cores
+    uint64_t dist_free_ = 0;        // First cycle the distributor can take a word
+    uint32_t issue_rr_ = 0;
+    std::vector<uint64_t> core_free_;
+    std::vector<job> jobs_;         // Last job of each core
+    uint64_t last_done_ = 0;
+
+    uint64_t index_ = 0;
+    bool keep_ops_ = false;
+    std::vector<npu_perf_op> ops_;
+    npu_perf_summary sum_;
+};
+
+/**
+ * Replay a trace file (npu_trace.h) or a raw little-endian word stream
+ * through the model
+ * @return false with err set if the file cannot be read
+ */
+bool npu_perf_replay(npu_perf_model &model, const std::string &path, std::string &err);
+
+/**
+ * Run the probe instruction set (or the instruction words of trace, if not
+ * empty) on the Verilator model in lib, fit mem_overhead and op_overhead of
+ * cfg to the issue-to-result cycles of its completion records, and print the
+ * per-opcode error before and after the fit to report
+ * @return false with err set if the model cannot be loaded or run
+ */
+bool npu_perf_calibrate(const std::string &lib, const std::string &trace, npu_perf_config &cfg,
+                        FILE *report, std::string &err);
+
+#endif // NPU_PERF_MODEL_H
@@ -0,0 +1,178 @@
+/**
+ * Activation Unit Module
+ *
+ * Streaming activation function datapath placed after the PE writeback.
+ * Each lane accepts one element per cycle and produces one result per
+ * cycle after a two-stage pipeline. Supported functions:
+ *   - ReLU:        max(0, x)
+ *   - Leaky ReLU:  x >= 0 ? x : alpha * x   (alpha in Q0.16)
+ *   - Sigmoid:     piecewise-linear, 16 segments over [0, 8)
+ *   - Tanh:        piecewise-linear, 16 segments over [0, 4)
+ * Sigmoid and tanh operate on Q16.16 fixed point. Only the positive half
+ * is stored in the ROM; negative inputs use sigmoid(-x) = 1 - sigmoid(x)
+ * and tanh(-x) = -tanh(x). Inputs beyond the table saturate to 1.0.
+ */
+
+module activation_unit #(
+    parameter DATA_WIDTH = 32,
+    parameter LANES = 1
+) (
+    input  wire clk,
+    input  wire rst_n,
+
+    // Function select and leaky ReLU slope
+    input  wire [2:0] func,
+    input  wire [15:0] alpha,
+
+    // Input stream
+    input  wire [LANES*DATA_WIDTH-1:0] in_data,
+    input  wire in_valid,
+
+    // Output stream
+    output wire [LANES*DATA_WIDTH-1:0] out_data,
+    output reg  out_valid
+);
+
+    // Function codes (shared with the npu_core epilogue field)
+    localparam ACT_NONE       = 3'h0;
+    localparam ACT_RELU       = 3'h1;
+    localparam ACT_LEAKY_RELU = 3'h2;
+    localparam ACT_SIGMOID    = 3'h3;
+    localparam ACT_TANH       = 3'h4;
+
+    // Fixed-point format for the piecewise-linear functions
+    localparam FRAC_BITS = 16;
+    localparam [DATA_WIDTH-1:0] ONE = 1 << FRAC_BITS;
+    localparam [DATA_WIDTH-1:0] SIGMOID_RANGE = 8 << FRAC_BITS;
+    localparam [DATA_WIDTH-1:0] TANH_RANGE = 4 << FRAC_BITS;
+
+    // Piecewise-linear ROM: {slope, intercept} in Q0.16, indexed by
+    // {is_tanh, segment}. y = intercept + slope * |x| on each segment.
+    function automatic logic [31:0] pwl_rom(input logic [4:0] index);
+        case (index)
+            5'h00: return {16'h3EB3, 16'h8000};  // [0.00, 0.50)
+            5'h01: return {16'h379A, 16'h838C};  // [0.50, 1.00)
+            5'h02: return {16'h2C4C, 16'h8EDB};  // [1.00, 1.50)
+            5'h03: return {16'h205F, 16'hA0BE};  // [1.50, 2.00)
+            5'h04: return {16'h1631, 16'hB519};  // [2.00, 2.50)
+            5'h05: return {16'h0E8F, 16'hC830};  // [2.50, 3.00)
+            5'h06: return {16'h0946, 16'hD809};  // [3.00, 3.50)
+            5'h07: return {16'h05CD, 16'hE433};  // [3.50, 4.00)
+            5'h08: return {16'h0395, 16'hED10};  // [4.00, 4.50)
+            5'h09: return {16'h0233, 16'hF34B};  // [4.50, 5.00)
+            5'h0A: return {16'h0158, 16'hF793};  // [5.00, 5.50)
+            5'h0B: return {16'h00D1, 16'hFA76};  // [5.50, 6.00)
+            5'h0C: return {16'h007F, 16'hFC62};  // [6.00, 6.50)
+            5'h0D: return {16'h004D, 16'hFDA7};  // [6.50, 7.00)
+            5'h0E: return {16'h002F, 16'hFE7C};  // [7.00, 7.50)
+            5'h0F: return {16'h001C, 16'hFF06};  // [7.50, 8.00)
+            5'h10: return {16'hFACC, 16'h0000};  // [0.00, 0.25)
+            5'h11: return {16'hDE69, 16'h0719};  // [0.25, 0.50)
+            5'h12: return {16'hB12F, 16'h1DB6};  // [0.50, 0.75)
+            5'h13: return {16'h817B, 16'h417D};  // [0.75, 1.00)
+            5'h14: return {16'h58C5, 16'h6A33};  // [1.00, 1.25)
+            5'h15: return {16'h3A3B, 16'h9060};  // [1.25, 1.50)
+            5'h16: return {16'h2519, 16'hB013};  // [1.50, 1.75)
+            5'h17: return {16'h1732, 16'hC866};  // [1.75, 2.00)
+            5'h18: return {16'h0E56, 16'hDA1F};  // [2.00, 2.25)
+            5'h19: return {16'h08CB, 16'hE696};  // [2.25, 2.50)
+            5'h1A: return {16'h055F, 16'hEF25};  // [2.50, 2.75)
+            5'h1B: return {16'h0346, 16'hF4EB};  // [2.75, 3.00)
+            5'h1C: return {16'h01FD, 16'hF8C4};  // [3.00, 3.25)
+            5'h1D: return {16'h0135, 16'hFB4E};  // [3.25, 3.50)
+            5'h1E: return {16'h00BC, 16'hFCF7};  // [3.50, 3.75)
+            5'h1F: return {16'h0072, 16'hFE0C};  // [3.75, 4.00)
+            default: return 32'h0;
+        endcase
+    endfunction
+
+    // Shared stage 1 control
+    reg [2:0] s1_func;
+    reg [15:0] s1_alpha;
+    reg s1_valid;
+
+    genvar l;
+    generate
+        for (l = 0; l < LANES; l++) begin : lane
+            wire [DATA_WIDTH-1:0] x = in_data[l*DATA_WIDTH +: DATA_WIDTH];
+            wire negative = x[DATA_WIDTH-1];
+            wire [DATA_WIDTH-1:0] abs_x = negative ? (~x + 1'b1) : x;
+            wire is_tanh = (func == ACT_TANH);
+            wire [3:0] segment = is_tanh ? abs_x[FRAC_BITS+1 -: 4] : abs_x[FRAC_BITS+2 -: 4];
+            wire saturated = is_tanh ? (abs_x >= TANH_RANGE) : (abs_x >= SIGMOID_RANGE);
+            wire [31:0] rom_entry = pwl_rom({is_tanh, segment});
+
+            // Stage 1: sign/magnitude split and ROM lookup
+            reg [DATA_WIDTH-1:0] s1_x, s1_abs_x;
+            reg s1_negative, s1_saturated;
+            reg [15:0] s1_slope, s1_intercept;
+
+            always_ff @(posedge clk or negedge rst_n) begin
+                if (!rst_n) begin
+                    s1_x <= '0;
+                    s1_abs_x <= '0;
+                    s1_negative <= 1'b0;
+                    s1_saturated <= 1'b0;
+                    s1_slope <= '0;
+                    s1_intercept <= '0;
+                end else if (in_valid) begin
+                    s1_x <= x;
+                    s1_abs_x <= abs_x;
+                    s1_negative <= negative;
+                    s1_saturated <= saturated;
+                    s1_slope <= rom_entry[31:16];
+                    s1_intercept <= rom_entry[15:0];
+                end
+            end
+
+            // Stage 2: evaluate the selected function
+            logic signed [DATA_WIDTH+16:0] leaky;
+            logic [DATA_WIDTH+15:0] pwl_product;
+            logic [DATA_WIDTH-1:0] pwl_mag;
+            logic [DATA_WIDTH-1:0] y;
+            reg [DATA_WIDTH-1:0] out_lane;
+
+            always_comb begin
+                leaky = $signed(s1_x) * $signed({1'b0, s1_alpha});
+                pwl_product = s1_abs_x * s1_slope;
+                pwl_mag = s1_saturated ? ONE
+                                       : {{(DATA_WIDTH-16){1'b0}}, s1_intercept} + (pwl_product >> FRAC_BITS);
+                case (s1_func)
+                    ACT_RELU:       y = s1_negative ? '0 : s1_x;
+                    ACT_LEAKY_RELU: y = s1_negative ? leaky[FRAC_BITS +: DATA_WIDTH] : s1_x;
+                    ACT_SIGMOID:    y = s1_negative ? ONE - pwl_mag : pwl_mag;
+                    ACT_TANH:       y = s1_negative ? ~pwl_mag + 1'b1 : pwl_mag;
+                    default:        y = s1_x;
+                endcase
+            end
+
+            always_ff @(posedge clk or negedge rst_n) begin
+                if (!rst_n) begin
+                    out_lane <= '0;
+                end else if (s1_valid) begin
+                    out_lane <= y;
+                end
+            end
+
+            assign out_data[l*DATA_WIDTH +: DATA_WIDTH] = out_lane;
+        end
+    endgenerate
+
+    // Shared control pipeline
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            s1_func <= ACT_NONE;
+            s1_alpha <= '0;
+            s1_valid <= 1'b0;
+            out_valid <= 1'b0;
+        end else begin
+            s1_valid <= in_valid;
+            out_valid <= s1_valid;
+            if (in_valid) begin
+                s1_func <= func;
+                s1_alpha <= alpha;
+            end
+        end
+    end
+
+endmodule
@@ -0,0 +1,139 @@
+/**
+ * Completion Writer Module
+ *
+ * Posts a 16-byte completion record into a host-memory ring for every
+ * result leaving the cluster, so the host learns about completions from
+ * cacheable memory instead of polling REG_STATUS across PCIe. The result
+ * itself still goes to the host stream unchanged; the record is posted
+ * one cycle after the result is handed over.
+ *
+ * Record layout (32-bit little-endian words):
+ *   word 0: sequence number (1 for the first record after enabling)
+ *   word 1: status - [2] error, [3] done, [15:8] opcode, [23:16] core
+ *   word 2: cycles from instruction issue to result
+ *   word 3: error code (0: none, 1: configuration rejected)
+ *
+ * The ring has cq_entries slots at cq_base; record n lands in slot
+ * (n - 1) mod cq_entries. The host acknowledges records by writing its
+ * consumer index to cq_head. When the ring is full the result stream is
+ * stalled rather than a record being dropped. With cq_enable low (or
+ * fewer than two slots) the module is a plain pass-through and the
+ * producer index and sequence number return to zero.
+ */
+
+module completion_writer #(
+    parameter DATA_WIDTH = 32,
+    parameter HOST_ADDR_WIDTH = 64
+) (
+    input  wire clk,
+    input  wire rst_n,
+
+    // Tagged result stream from the cluster
+    input  wire [DATA_WIDTH-1:0] res_data,
+    input  wire res_valid,
+    output wire res_ready,
+    input  wire [7:0]  res_core,
+    input  wire [7:0]  res_opcode,
+    input  wire [31:0] res_cycles,
+
+    // Result stream to the host
+    output wire [DATA_WIDTH-1:0] out_data,
+    output wire out_valid,
+    input  wire out_ready,
+
+    // Completion queue configuration (REG_CQ_* register block)
+    input  wire cq_enable,
+    input  wire [HOST_ADDR_WIDTH-1:0] cq_base,
+    input  wire [15:0] cq_entries,
+    input  wire [15:0] cq_head,         // Consumer index written by the host
+    output reg  [15:0] cq_tail,         // Producer index
+    output reg  [31:0] cq_seq,          // Sequence number of the last record taken
+
+    // Host memory write port: one 16-byte posted write per record
+    output wire [HOST_ADDR_WIDTH-1:0] hw_addr,
+    output wire [127:0] hw_data,
+    output wire hw_valid,
+    input  wire hw_ready,
+
+    // One-cycle pulse after each record is posted (completion interrupt)
+    output reg  cq_irq
+);
+
+    // Framing (must match npu_core.sv and encode_instruction())
+    localparam OP_CONV    = 5'h05;
+    localparam OP_MATMUL  = 5'h06;
+    localparam OP_POOLING = 5'h09;
+
+    // Status bits (must match STATUS_* in the driver)
+    localparam STATUS_ERROR = 32'h0000_0004;
+    localparam STATUS_DONE  = 32'h0000_0008;
+
+    localparam CQ_ERR_NONE   = 32'd0;
+    localparam CQ_ERR_CONFIG = 32'd1;
+
+    wire cq_on = cq_enable && (cq_entries > 16'd1);
+
+    // Record waiting to be posted
+    reg rec_valid;
+    reg [HOST_ADDR_WIDTH-1:0] rec_addr;
+    reg [31:0] rec_seq;
+    reg [31:0] rec_status;
+    reg [31:0] rec_cycles;
+    reg [31:0] rec_error;
+
+    wire [15:0] tail_next = (cq_tail + 1'b1 == cq_entries) ? 16'd0 : cq_tail + 1'b1;
+    wire cq_full = (tail_next == cq_head);
+    wire can_take = !cq_on || (!rec_valid && !cq_full);
+
+    assign out_data = res_data;
+    assign out_valid = res_valid && can_take;
+    assign res_ready = out_ready && can_take;
+
+    wire take = cq_on && res_valid && res_ready;
+    wire post = rec_valid && hw_ready;
+
+    // Convolution and pooling report a rejected configuration in bit 0
+    wire [4:0] res_base_op = res_opcode[4:0];
+    wire res_error = ((res_base_op == OP_CONV) || (res_base_op == OP_MATMUL) ||
+                      (res_base_op == OP_POOLING)) && res_data[0];
+
+    assign hw_addr = rec_addr;
+    assign hw_data = {rec_error, rec_cycles, rec_status, rec_seq};
+    assign hw_valid = rec_valid;
+
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            rec_valid <= 1'b0;
+            rec_addr <= '0;
+            rec_seq <= '0;
+            rec_status <= '0;
+            rec_cycles <= '0;
+            rec_error <= '0;
+            cq_tail <= '0;
+            cq_seq <= '0;
+            cq_irq <= 1'b0;
+        end else begin
+            cq_irq <= post;
+
+            if (post) begin
+                rec_valid <= 1'b0;
+                cq_tail <= tail_next;
+            end else if (!cq_on && !rec_valid) begin
+                cq_tail <= '0;
+                cq_seq <= '0;
+            end
+
+            if (take) begin
+                rec_valid <= 1'b1;
+                rec_addr <= cq_base + {cq_tail, 4'b0000};
+                rec_seq <= cq_seq + 1'b1;
+                rec_status <= STATUS_DONE | (res_error ? STATUS_ERROR : 32'd0) |
+                              {8'h00, res_core, res_opcode, 8'h00};
+                rec_cycles <= res_cycles;
+                rec_error <= res_error ? CQ_ERR_CONFIG : CQ_ERR_NONE;
+                cq_seq <= cq_seq + 1'b1;
+            end
+        end
+    end
+
+endmodule
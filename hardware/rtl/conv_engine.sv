@@ -0,0 +1,816 @@
+/**
+ * Convolution Engine Module
+ *
+ * Streaming 2D convolution and pooling over NCHW (N = 1) INT32 tensors in
+ * NPU memory. Input pixels are fetched once in raster order and pushed
+ * through MAX_KERNEL-1 line buffers into a sliding MAX_KERNEL x MAX_KERNEL
+ * window; a runtime KH x KW kernel uses the bottom-right corner. Padding
+ * is generated on the fly: positions outside the image push a pad value
+ * (zero, or the most negative value for max pooling) without a memory
+ * access, so no padded copy is needed. Row and column phase counters pick
+ * the windows for any stride.
+ *
+ * Convolution is ordered output-channel group -> input channel -> pixel.
+ * For each window the KH*KW taps are serialized into the PE array: the tap
+ * pixel is broadcast and each of the OC_GROUP PEs gets the weight of its
+ * own output channel, with acc_clear on the first tap. Partial sums over
+ * input channels stay in an on-chip buffer, so every input pixel is read
+ * exactly once per output-channel group and every output is written once,
+ * after the optional activation epilogue.
+ *
+ * With ZERO_SKIP set, window taps whose pixel is zero are compacted out:
+ * a priority encoder over the window picks the next non-zero tap, so a
+ * post-ReLU input with half its pixels at zero needs about half the MAC
+ * cycles. A window with no non-zero tap still issues one (zero) tap to
+ * clear the accumulators. taps_skipped reports the compacted taps of
+ * each window for the PMU.
+ *
+ * Convolution weights may instead be 2:4 structured-sparse (cfg_sparse).
+ * Each (out channel, in channel) block of KH*KW taps is split into groups
+ * of four taps holding at most two non-zeros, stored compressed as
+ *   [metadata words][value pairs]
+ * where metadata word m packs one nibble per group 8m..8m+7 (bits [1:0]
+ * and [3:2] are the tap indices of the group's two values). The decoder
+ * turns every index into a window position per lane, so each PE reads
+ * its own activation from the window: a group of four taps costs two
+ * MAC cycles and two weight words instead of four.
+ *
+ * cfg_lane_mask gates PE lanes at run time: output channels are dealt
+ * only to enabled lanes (lane n takes the channel of its rank among the
+ * enabled lanes), so a partition of P lanes needs ceil(out_c / P) groups
+ * and disabled lanes never load weights or see a MAC enable.
+ *
+ * Pooling shares the same line buffers and window: taps go to the
+ * pooling_unit instead of the PEs, one plane per channel. Global average
+ * pooling skips the window and reduces every pixel of the plane.
+ * Output geometry and the averaging reciprocal are computed once per job
+ * with a small sequential divider.
+ *
+ * Memory layout (byte addresses, 32-bit words):
+ *   input   [in_c][in_h][in_w]
+ *   weights [out_c][in_c][KH][KW]   (convolution only; 2:4 blocks when sparse)
+ *   output  [out_c][out_h][out_w]   (out_c = in_c for pooling)
+ */
+
+module conv_engine #(
+    parameter DATA_WIDTH = 32,
+    parameter ADDR_WIDTH = 32,
+    parameter OC_GROUP = 4,          // Output channels computed per pass
+    parameter MAX_KERNEL = 5,        // Largest supported KH / KW
+    parameter MAX_WIDTH = 64,        // Largest padded input width
+    parameter MAX_OUT_PIXELS = 1024, // Largest out_h * out_w
+    parameter ZERO_SKIP = 1          // Compact zero taps out of the MAC stream
+) (
+    input  wire clk,
+    input  wire rst_n,
+
+    // Control
+    input  wire start,
+    output wire busy,
+    output reg  done,
+    output reg  error,
+
+    // Configuration (sampled on start)
+    input  wire cfg_pool,            // 0: convolution, 1: pooling
+    input  wire cfg_sparse,          // 2:4 compressed convolution weights
+    input  wire [OC_GROUP-1:0] cfg_lane_mask,   // PE lanes this job may use
+    input  wire [1:0]  cfg_pool_mode,
+    input  wire [ADDR_WIDTH-1:0] cfg_in_addr,
+    input  wire [ADDR_WIDTH-1:0] cfg_w_addr,
+    input  wire [ADDR_WIDTH-1:0] cfg_out_addr,
+    input  wire [15:0] cfg_in_h,
+    input  wire [15:0] cfg_in_w,
+    input  wire [11:0] cfg_in_c,
+    input  wire [11:0] cfg_out_c,
+    input  wire [3:0]  cfg_kernel_h,
+    input  wire [3:0]  cfg_kernel_w,
+    input  wire [3:0]  cfg_stride_h,
+    input  wire [3:0]  cfg_stride_w,
+    input  wire [3:0]  cfg_pad_h,
+    input  wire [3:0]  cfg_pad_w,
+    input  wire [2:0]  cfg_act_func,
+    input  wire [15:0] cfg_act_alpha,
+
+    // PE array interface
+    output wire pe_enable,
+    output wire pe_acc_clear,
+    output wire [OC_GROUP*DATA_WIDTH-1:0] pe_op_a,    // Window tap per output channel
+    output wire [OC_GROUP*DATA_WIDTH-1:0] pe_op_b,    // Weight per output channel
+    input  wire [OC_GROUP*DATA_WIDTH-1:0] pe_results,
+    input  wire pe_valid,
+
+    // Zero-tap compaction statistics (one pulse per window)
+    output reg  [$clog2(MAX_KERNEL*MAX_KERNEL+1)-1:0] taps_skipped,
+
+    // Memory Interface
+    output wire [ADDR_WIDTH-1:0] mem_addr,
+    output wire [DATA_WIDTH-1:0] mem_wdata,
+    input  wire [DATA_WIDTH-1:0] mem_rdata,
+    output wire mem_we,
+    output wire mem_re,
+    input  wire mem_valid
+);
+
+    localparam KK_MAX = MAX_KERNEL * MAX_KERNEL;
+    localparam POS_W = $clog2(KK_MAX);
+    localparam SLOTS_MAX = 2 * ((KK_MAX + 3) / 4);   // Stored values per 2:4 block
+
+    // Pooling modes (must match pooling_unit)
+    localparam POOL_MAX        = 2'h0;
+    localparam POOL_AVG        = 2'h1;
+    localparam POOL_GLOBAL_AVG = 2'h2;
+
+    // Divider jobs run during setup
+    localparam DIV_OUT_H = 2'h0;
+    localparam DIV_OUT_W = 2'h1;
+    localparam DIV_RECIP = 2'h2;
+
+    typedef enum logic [3:0] {
+        IDLE,
+        CHECK,
+        DIVIDE,
+        CHECK_SIZE,
+        LOAD_WEIGHTS,
+        LOAD_SPARSE,
+        STREAM,
+        COMPUTE,
+        DRAIN,
+        ACCUMULATE,
+        ACTIVATE,
+        WRITE,
+        POOL_WRITE,
+        NEXT_PLANE,
+        FINISH
+    } conv_state_t;
+
+    conv_state_t state;
+
+    // Latched configuration
+    reg pool;
+    reg sparse;
+    reg [1:0] pool_mode;
+    reg [ADDR_WIDTH-1:0] in_addr, w_addr, out_addr;
+    reg [15:0] in_h, in_w;
+    reg [11:0] in_c, out_c;
+    reg [3:0] kernel_h, kernel_w;
+    reg [3:0] stride_h, stride_w;
+    reg [3:0] pad_h, pad_w;
+    reg [2:0] act_func;
+    reg [15:0] act_alpha;
+
+    // Derived geometry
+    wire global_pool = pool && (pool_mode == POOL_GLOBAL_AVG);
+    wire [15:0] padded_h = in_h + {pad_h, 1'b0};
+    wire [15:0] padded_w = in_w + {pad_w, 1'b0};
+    wire [9:0]  kk = kernel_h * kernel_w;
+    reg  [15:0] out_h, out_w;
+    wire [31:0] out_pixels = out_h * out_w;
+    reg  [31:0] recip;                        // round(2^31 / window size)
+
+    // 2:4 block geometry: groups of four taps, one metadata nibble per group
+    wire [7:0]  sp_groups = (kk + 3) >> 2;
+    wire [7:0]  sp_meta_words = (sp_groups + 7) >> 3;
+    wire [9:0]  sp_slots = {sp_groups, 1'b0};
+    wire [11:0] w_block = sparse ? sp_meta_words + sp_slots : kk;
+
+    // Lane partition: rank of each enabled lane and the number enabled
+    reg [OC_GROUP-1:0] lane_en;
+    logic [$clog2(OC_GROUP+1)-1:0] lane_rank [OC_GROUP];
+    logic [$clog2(OC_GROUP+1)-1:0] lanes_on;
+
+    always_comb begin
+        lanes_on = '0;
+        for (int l = 0; l < OC_GROUP; l++) begin
+            lane_rank[l] = lanes_on;
+            lanes_on = lanes_on + lane_en[l];
+        end
+    end
+
+    wire config_ok = (pool || lanes_on != 0) &&
+                     (kernel_h != 0) && (kernel_h <= MAX_KERNEL) &&
+                     (kernel_w != 0) && (kernel_w <= MAX_KERNEL) &&
+                     (stride_h != 0) && (stride_w != 0) &&
+                     (in_c != 0) && (out_c != 0) &&
+                     (padded_h >= kernel_h) && (padded_w >= kernel_w) &&
+                     (global_pool || padded_w <= MAX_WIDTH) &&
+                     (!pool || pool_mode != 2'h3);
+
+    // Sequential restoring divider for the setup divisions
+    reg [1:0] div_job;
+    reg [31:0] div_quo, div_rem, div_den;
+    reg [5:0] div_cnt;
+    wire [32:0] div_shift = {div_rem, div_quo[31]};
+    wire div_fits = (div_shift >= {1'b0, div_den});
+
+    // Loop counters
+    reg [11:0] oc_base;                       // First output channel of the group
+    reg [11:0] ic;                            // Current input channel
+    reg [15:0] py, px;                        // Position in the padded input plane
+    reg [3:0] row_phase, col_phase;           // Stride phase of the current row / column
+    reg [31:0] opix;                          // Output pixel index within the plane
+    reg [ADDR_WIDTH-1:0] in_ptr;              // Next input pixel address
+    reg [$clog2(OC_GROUP+1)-1:0] lane;        // Lane counter for weight load / write
+    reg [$clog2(KK_MAX+1)-1:0] tap;           // Tap counter for weight load
+    reg [3:0] ky, kx;
+    reg [POS_W-1:0] pos;                      // Window position (dense) or slot (sparse) issued
+    reg tap_first;                            // Next issued tap starts the window
+    reg [$clog2(KK_MAX+1)-1:0] issue_cnt;
+    reg [$clog2(KK_MAX+1)-1:0] valid_cnt;
+    reg [7:0] grp;                            // 2:4 group being decoded
+    reg sp_k;                                 // Value of the group being decoded
+    reg [DATA_WIDTH-1:0] sp_meta;             // Metadata, current group in [3:0]
+    reg sp_meta_ok;
+    reg plane_end;
+    reg act_issued;
+
+    // Memory request registers
+    reg [ADDR_WIDTH-1:0] mem_addr_reg;
+    reg [DATA_WIDTH-1:0] mem_wdata_reg;
+    reg mem_we_reg, mem_re_reg;
+
+    // Weight, window, line buffer and partial sum storage
+    reg [DATA_WIDTH-1:0] weights [OC_GROUP][KK_MAX];    // Indexed by window position
+    reg [DATA_WIDTH-1:0] sp_val [OC_GROUP][SLOTS_MAX];  // 2:4 values in issue order
+    reg [POS_W-1:0] sp_pos [OC_GROUP][SLOTS_MAX];       // Window position of each value
+    reg [DATA_WIDTH-1:0] window [MAX_KERNEL][MAX_KERNEL];
+    reg [DATA_WIDTH-1:0] line_buf [MAX_KERNEL-1][MAX_WIDTH];
+    reg [DATA_WIDTH-1:0] psum [OC_GROUP][MAX_OUT_PIXELS];
+    reg [DATA_WIDTH-1:0] psum_q [OC_GROUP];
+
+    // Pixel stream: padding positions push the pad value without touching memory
+    wire pix_real = (py >= pad_h) && (py < in_h + pad_h) &&
+                    (px >= pad_w) && (px < in_w + pad_w);
+    wire [DATA_WIDTH-1:0] pad_value = (pool && pool_mode == POOL_MAX)
+                                      ? {1'b1, {(DATA_WIDTH-1){1'b0}}} : '0;
+    wire push = (state == STREAM) && (!pix_real || (mem_re_reg && mem_valid));
+    wire [DATA_WIDTH-1:0] push_data = pix_real ? mem_rdata : pad_value;
+    wire last_col = (px == padded_w - 1);
+    wire last_row = (py == padded_h - 1);
+
+    // Window completed by this push (bottom-right corner at py, px)
+    wire window_ready = !global_pool &&
+                        (py >= kernel_h - 1) && (px >= kernel_w - 1) &&
+                        (row_phase == 0) && (col_phase == 0);
+
+    wire last_ic = (ic == in_c - 1);
+    wire [11:0] lane_oc = oc_base + lane_rank[lane];
+    wire lane_active = lane_en[lane] && (lane_oc < out_c);
+
+    // Window positions are r * MAX_KERNEL + c; the kernel occupies the
+    // bottom-right kernel_h x kernel_w corner
+    wire [POS_W-1:0] origin_pos = (MAX_KERNEL - kernel_h) * MAX_KERNEL + (MAX_KERNEL - kernel_w);
+    wire [POS_W-1:0] w_pos = origin_pos + ky * MAX_KERNEL + kx;
+    logic [KK_MAX-1:0] issue_mask;
+    logic [POS_W-1:0] first_pos, next_pos;
+    logic has_next;
+    wire [POS_W-1:0] cur_pos = tap_first ? (sparse ? '0 : first_pos) : pos;
+
+    always_comb begin
+        for (int p = 0; p < KK_MAX; p++) begin
+            issue_mask[p] = (p / MAX_KERNEL >= MAX_KERNEL - kernel_h) &&
+                            (p % MAX_KERNEL >= MAX_KERNEL - kernel_w) &&
+                            (pool || !ZERO_SKIP || window[p / MAX_KERNEL][p % MAX_KERNEL] != '0);
+        end
+
+        // All-zero window: issue the kernel origin so the accumulators clear
+        first_pos = origin_pos;
+        for (int p = KK_MAX - 1; p >= 0; p--) begin
+            if (issue_mask[p]) begin
+                first_pos = p;
+            end
+        end
+    end
+
+    always_comb begin
+        next_pos = '0;
+        has_next = 1'b0;
+        if (sparse) begin
+            next_pos = cur_pos + 1'b1;
+            has_next = (cur_pos + 1'b1 < sp_slots);
+        end else begin
+            for (int p = KK_MAX - 1; p >= 0; p--) begin
+                if (issue_mask[p] && p > cur_pos) begin
+                    next_pos = p;
+                    has_next = 1'b1;
+                end
+            end
+        end
+    end
+
+    // Kernel coordinates n taps after (y, x) in raster order
+    function automatic [7:0] kernel_step(input [3:0] y, input [3:0] x, input [2:0] n, input [3:0] kw);
+        for (int i = 0; i < 4; i++) begin
+            if (i < n) begin
+                if (x == kw - 1) begin
+                    x = '0;
+                    y = y + 1'b1;
+                end else begin
+                    x = x + 1'b1;
+                end
+            end
+        end
+        return {y, x};
+    endfunction
+
+    // 2:4 decode: tap index of the current value relative to the group base (ky, kx)
+    wire [1:0] sp_idx = sp_k ? sp_meta[3:2] : sp_meta[1:0];
+    wire [7:0] sp_yx = kernel_step(ky, kx, {1'b0, sp_idx}, kernel_w);
+    wire [POS_W-1:0] sp_w_pos = origin_pos + sp_yx[7:4] * MAX_KERNEL + sp_yx[3:0];
+    wire sp_tap_ok = ({grp, 2'b00} + sp_idx) < kk;
+
+    // Current window tap
+    wire [DATA_WIDTH-1:0] tap_pixel = window[cur_pos / MAX_KERNEL][cur_pos % MAX_KERNEL];
+
+    // Activation epilogue on the final sums
+    wire [OC_GROUP*DATA_WIDTH-1:0] act_in;
+    wire [OC_GROUP*DATA_WIDTH-1:0] act_out;
+    wire act_out_valid;
+
+    // Pooling reduction
+    wire pool_in_valid = pool && (global_pool ? push : (state == COMPUTE));
+    wire pool_in_first = global_pool ? (py == 0 && px == 0) : tap_first;
+    wire [DATA_WIDTH-1:0] pool_out;
+
+    // Main control
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            state <= IDLE;
+            done <= 1'b0;
+            error <= 1'b0;
+            pool <= 1'b0;
+            sparse <= 1'b0;
+            pool_mode <= '0;
+            in_addr <= '0;
+            w_addr <= '0;
+            out_addr <= '0;
+            in_h <= '0;
+            in_w <= '0;
+            in_c <= '0;
+            out_c <= '0;
+            kernel_h <= '0;
+            kernel_w <= '0;
+            stride_h <= '0;
+            stride_w <= '0;
+            pad_h <= '0;
+            pad_w <= '0;
+            act_func <= '0;
+            act_alpha <= '0;
+            out_h <= '0;
+            out_w <= '0;
+            recip <= '0;
+            div_job <= '0;
+            div_quo <= '0;
+            div_rem <= '0;
+            div_den <= '0;
+            div_cnt <= '0;
+            lane_en <= '0;
+            oc_base <= '0;
+            ic <= '0;
+            py <= '0;
+            px <= '0;
+            row_phase <= '0;
+            col_phase <= '0;
+            opix <= '0;
+            in_ptr <= '0;
+            lane <= '0;
+            tap <= '0;
+            ky <= '0;
+            kx <= '0;
+            pos <= '0;
+            tap_first <= 1'b0;
+            grp <= '0;
+            sp_k <= 1'b0;
+            sp_meta <= '0;
+            sp_meta_ok <= 1'b0;
+            issue_cnt <= '0;
+            valid_cnt <= '0;
+            taps_skipped <= '0;
+            plane_end <= 1'b0;
+            act_issued <= 1'b0;
+            mem_addr_reg <= '0;
+            mem_wdata_reg <= '0;
+            mem_we_reg <= 1'b0;
+            mem_re_reg <= 1'b0;
+        end else begin
+            done <= 1'b0;
+            taps_skipped <= '0;
+
+            case (state)
+                IDLE: begin
+                    if (start) begin
+                        pool <= cfg_pool;
+                        sparse <= cfg_sparse && !cfg_pool;
+                        lane_en <= cfg_lane_mask;
+                        pool_mode <= cfg_pool_mode;
+                        in_addr <= cfg_in_addr;
+                        w_addr <= cfg_w_addr;
+                        out_addr <= cfg_out_addr;
+                        in_h <= cfg_in_h;
+                        in_w <= cfg_in_w;
+                        in_c <= cfg_in_c;
+                        out_c <= cfg_pool ? cfg_in_c : cfg_out_c;
+                        act_func <= cfg_act_func;
+                        act_alpha <= cfg_act_alpha;
+                        error <= 1'b0;
+                        if (cfg_pool && cfg_pool_mode == POOL_GLOBAL_AVG) begin
+                            // Whole plane, no window
+                            kernel_h <= 4'd1;
+                            kernel_w <= 4'd1;
+                            stride_h <= 4'd1;
+                            stride_w <= 4'd1;
+                            pad_h <= '0;
+                            pad_w <= '0;
+                        end else begin
+                            kernel_h <= cfg_kernel_h;
+                            kernel_w <= cfg_kernel_w;
+                            stride_h <= cfg_stride_h;
+                            stride_w <= cfg_stride_w;
+                            pad_h <= cfg_pad_h;
+                            pad_w <= cfg_pad_w;
+                        end
+                        state <= CHECK;
+                    end
+                end
+
+                CHECK: begin
+                    if (config_ok) begin
+                        div_job <= DIV_OUT_H;
+                        div_quo <= padded_h - kernel_h;
+                        div_den <= stride_h;
+                        div_rem <= '0;
+                        div_cnt <= '0;
+                        state <= DIVIDE;
+                    end else begin
+                        error <= 1'b1;
+                        state <= FINISH;
+                    end
+                end
+
+                // out_h, out_w and the averaging reciprocal, 32 cycles each
+                DIVIDE: begin
+                    if (div_cnt != 6'd32) begin
+                        div_rem <= div_fits ? div_shift - div_den : div_shift[31:0];
+                        div_quo <= {div_quo[30:0], div_fits};
+                        div_cnt <= div_cnt + 1'b1;
+                    end else begin
+                        div_rem <= '0;
+                        div_cnt <= '0;
+                        case (div_job)
+                            DIV_OUT_H: begin
+                                out_h <= global_pool ? 16'd1 : div_quo[15:0] + 1'b1;
+                                div_job <= DIV_OUT_W;
+                                div_quo <= padded_w - kernel_w;
+                                div_den <= stride_w;
+                            end
+                            DIV_OUT_W: begin
+                                out_w <= global_pool ? 16'd1 : div_quo[15:0] + 1'b1;
+                                div_job <= DIV_RECIP;
+                                // Average pooling counts padded positions (count_include_pad)
+                                div_den <= global_pool ? in_h * in_w : kk;
+                                div_quo <= (32'd1 << 31) + ((global_pool ? in_h * in_w : kk) >> 1);
+                            end
+                            default: begin
+                                recip <= div_quo;
+                                state <= CHECK_SIZE;
+                            end
+                        endcase
+                    end
+                end
+
+                CHECK_SIZE: begin
+                    if (out_pixels <= MAX_OUT_PIXELS) begin
+                        oc_base <= '0;
+                        ic <= '0;
+                        lane <= '0;
+                        tap <= '0;
+                        ky <= '0;
+                        kx <= '0;
+                        grp <= '0;
+                        sp_k <= 1'b0;
+                        sp_meta_ok <= 1'b0;
+                        in_ptr <= in_addr;
+                        state <= sparse ? LOAD_SPARSE : LOAD_WEIGHTS;
+                    end else begin
+                        error <= 1'b1;
+                        state <= FINISH;
+                    end
+                end
+
+                // Load KH*KW weights of the current input channel for each lane
+                LOAD_WEIGHTS: begin
+                    if (!pool && !lane_active) begin
+                        weights[lane][w_pos] <= '0;
+                    end else if (!pool && !mem_re_reg) begin
+                        mem_addr_reg <= w_addr + ((((lane_oc * in_c) + ic) * kk + tap) << 2);
+                        mem_re_reg <= 1'b1;
+                    end
+
+                    if (pool || !lane_active || (mem_re_reg && mem_valid)) begin
+                        if (!pool && lane_active) begin
+                            weights[lane][w_pos] <= mem_rdata;
+                            mem_re_reg <= 1'b0;
+                        end
+                        if (kx == kernel_w - 1) begin
+                            kx <= '0;
+                            ky <= ky + 1'b1;
+                        end else begin
+                            kx <= kx + 1'b1;
+                        end
+                        if (pool || tap == kk - 1) begin
+                            tap <= '0;
+                            ky <= '0;
+                            kx <= '0;
+                            if (pool || lane == OC_GROUP - 1) begin
+                                lane <= '0;
+                                py <= '0;
+                                px <= '0;
+                                row_phase <= '0;
+                                col_phase <= '0;
+                                opix <= '0;
+                                state <= STREAM;
+                            end else begin
+                                lane <= lane + 1'b1;
+                            end
+                        end else begin
+                            tap <= tap + 1'b1;
+                        end
+                    end
+                end
+
+                // Decode the 2:4 block of the current input channel for each
+                // lane: a metadata word every eight groups, then two values
+                // per group placed at the window positions their indices name
+                LOAD_SPARSE: begin
+                    if (lane_active && !mem_re_reg) begin
+                        mem_addr_reg <= w_addr + ((((lane_oc * in_c) + ic) * w_block +
+                                        (sp_meta_ok ? sp_meta_words + {grp, sp_k} : grp >> 3)) << 2);
+                        mem_re_reg <= 1'b1;
+                    end
+
+                    if (lane_active && mem_re_reg && mem_valid && !sp_meta_ok) begin
+                        mem_re_reg <= 1'b0;
+                        sp_meta <= mem_rdata;
+                        sp_meta_ok <= 1'b1;
+                    end else if (!lane_active || (mem_re_reg && mem_valid)) begin
+                        mem_re_reg <= 1'b0;
+                        // Indices past the last tap are padding: zero weight at the origin
+                        sp_val[lane][{grp, sp_k}] <= (lane_active && sp_tap_ok) ? mem_rdata : '0;
+                        sp_pos[lane][{grp, sp_k}] <= sp_tap_ok ? sp_w_pos : origin_pos;
+                        sp_k <= ~sp_k;
+                        if (sp_k) begin
+                            sp_meta <= sp_meta >> 4;
+                            {ky, kx} <= kernel_step(ky, kx, 3'd4, kernel_w);
+                            if (grp[2:0] == 3'd7) begin
+                                sp_meta_ok <= 1'b0;
+                            end
+                            if (grp == sp_groups - 1) begin
+                                grp <= '0;
+                                ky <= '0;
+                                kx <= '0;
+                                sp_meta_ok <= 1'b0;
+                                if (lane == OC_GROUP - 1) begin
+                                    lane <= '0;
+                                    py <= '0;
+                                    px <= '0;
+                                    row_phase <= '0;
+                                    col_phase <= '0;
+                                    opix <= '0;
+                                    state <= STREAM;
+                                end else begin
+                                    lane <= lane + 1'b1;
+                                end
+                            end else begin
+                                grp <= grp + 1'b1;
+                            end
+                        end
+                    end
+                end
+
+                // Walk the padded plane, one pixel per push
+                STREAM: begin
+                    if (pix_real && !mem_re_reg) begin
+                        mem_addr_reg <= in_ptr;
+                        mem_re_reg <= 1'b1;
+                    end
+
+                    if (push) begin
+                        if (pix_real) begin
+                            mem_re_reg <= 1'b0;
+                            in_ptr <= in_ptr + 4;
+                        end
+                        if (last_col) begin
+                            px <= '0;
+                            py <= py + 1'b1;
+                            col_phase <= '0;
+                            if (py + 1'b1 == kernel_h - 1) begin
+                                row_phase <= '0;
+                            end else if (py >= kernel_h - 1) begin
+                                row_phase <= (row_phase == stride_h - 1) ? '0 : row_phase + 1'b1;
+                            end
+                        end else begin
+                            px <= px + 1'b1;
+                            if (px >= kernel_w - 1) begin
+                                col_phase <= (col_phase == stride_w - 1) ? '0 : col_phase + 1'b1;
+                            end
+                        end
+
+                        plane_end <= last_col && last_row;
+                        if (window_ready) begin
+                            tap_first <= 1'b1;
+                            issue_cnt <= '0;
+                            valid_cnt <= '0;
+                            state <= COMPUTE;
+                        end else if (last_col && last_row) begin
+                            state <= global_pool ? POOL_WRITE : NEXT_PLANE;
+                        end
+                    end
+                end
+
+                // Issue one tap per cycle to all lanes (or the pooling unit),
+                // jumping straight to the next tap that has work. Sparse
+                // weights issue their stored value slots in order.
+                COMPUTE: begin
+                    if (pe_valid) begin
+                        valid_cnt <= valid_cnt + 1'b1;
+                    end
+                    tap_first <= 1'b0;
+                    pos <= next_pos;
+                    issue_cnt <= issue_cnt + 1'b1;
+                    if (!has_next) begin
+                        if (sparse) begin
+                            taps_skipped <= (kk > sp_slots) ? kk - sp_slots : '0;
+                        end else begin
+                            taps_skipped <= kk - (issue_cnt + 1'b1);
+                        end
+                        state <= pool ? POOL_WRITE : DRAIN;
+                    end
+                end
+
+                // Wait for the last tap to leave the PE pipeline
+                DRAIN: begin
+                    if (pe_valid) begin
+                        valid_cnt <= valid_cnt + 1'b1;
+                        if (valid_cnt == issue_cnt - 1) begin
+                            state <= last_ic ? ACTIVATE : ACCUMULATE;
+                            act_issued <= 1'b0;
+                        end
+                    end
+                end
+
+                ACCUMULATE: begin
+                    opix <= opix + 1'b1;
+                    state <= plane_end ? NEXT_PLANE : STREAM;
+                end
+
+                ACTIVATE: begin
+                    act_issued <= 1'b1;
+                    if (act_out_valid) begin
+                        lane <= '0;
+                        state <= WRITE;
+                    end
+                end
+
+                // Write the finished outputs of this pixel, one lane at a time
+                WRITE: begin
+                    if (lane_active && !mem_we_reg) begin
+                        mem_addr_reg <= out_addr + (((lane_oc * out_pixels) + opix) << 2);
+                        mem_wdata_reg <= act_out[lane*DATA_WIDTH +: DATA_WIDTH];
+                        mem_we_reg <= 1'b1;
+                    end
+
+                    if (!lane_active || (mem_we_reg && mem_valid)) begin
+                        mem_we_reg <= 1'b0;
+                        if (lane == OC_GROUP - 1) begin
+                            lane <= '0;
+                            opix <= opix + 1'b1;
+                            state <= plane_end ? NEXT_PLANE : STREAM;
+                        end else begin
+                            lane <= lane + 1'b1;
+                        end
+                    end
+                end
+
+                // Write one pooled output of the current channel
+                POOL_WRITE: begin
+                    if (!mem_we_reg) begin
+                        mem_addr_reg <= out_addr + (((ic * out_pixels) + opix) << 2);
+                        mem_wdata_reg <= pool_out;
+                        mem_we_reg <= 1'b1;
+                    end else if (mem_valid) begin
+                        mem_we_reg <= 1'b0;
+                        opix <= opix + 1'b1;
+                        state <= plane_end ? NEXT_PLANE : STREAM;
+                    end
+                end
+
+                NEXT_PLANE: begin
+                    plane_end <= 1'b0;
+                    lane <= '0;
+                    tap <= '0;
+                    if (!last_ic) begin
+                        ic <= ic + 1'b1;
+                        state <= sparse ? LOAD_SPARSE : LOAD_WEIGHTS;
+                    end else if (!pool && oc_base + lanes_on < out_c) begin
+                        oc_base <= oc_base + lanes_on;
+                        ic <= '0;
+                        in_ptr <= in_addr;
+                        state <= sparse ? LOAD_SPARSE : LOAD_WEIGHTS;
+                    end else begin
+                        state <= FINISH;
+                    end
+                end
+
+                FINISH: begin
+                    done <= 1'b1;
+                    state <= IDLE;
+                end
+
+                default: state <= IDLE;
+            endcase
+        end
+    end
+
+    // Line buffers and window shift on every pushed pixel
+    always_ff @(posedge clk) begin
+        if (push && !global_pool) begin
+            for (int r = 0; r < MAX_KERNEL; r++) begin
+                for (int c = 0; c < MAX_KERNEL - 1; c++) begin
+                    window[r][c] <= window[r][c+1];
+                end
+            end
+            window[MAX_KERNEL-1][MAX_KERNEL-1] <= push_data;
+            for (int j = 1; j < MAX_KERNEL; j++) begin
+                window[MAX_KERNEL-1-j][MAX_KERNEL-1] <= line_buf[j-1][px];
+            end
+
+            line_buf[0][px] <= push_data;
+            for (int j = 1; j < MAX_KERNEL - 1; j++) begin
+                line_buf[j][px] <= line_buf[j-1][px];
+            end
+        end
+    end
+
+    // Partial sums: synchronous read, update after the last tap
+    always_ff @(posedge clk) begin
+        for (int g = 0; g < OC_GROUP; g++) begin
+            psum_q[g] <= psum[g][opix];
+            if (state == ACCUMULATE) begin
+                psum[g][opix] <= (ic == 0) ? pe_results[g*DATA_WIDTH +: DATA_WIDTH]
+                                           : psum_q[g] + pe_results[g*DATA_WIDTH +: DATA_WIDTH];
+            end
+        end
+    end
+
+    genvar g;
+    generate
+        for (g = 0; g < OC_GROUP; g++) begin : lane_gen
+            // Sparse lanes read the activation their own weight index selects
+            wire [POS_W-1:0] lane_pos = sp_pos[g][cur_pos];
+            assign pe_op_a[g*DATA_WIDTH +: DATA_WIDTH] = sparse
+                ? window[lane_pos / MAX_KERNEL][lane_pos % MAX_KERNEL] : tap_pixel;
+            assign pe_op_b[g*DATA_WIDTH +: DATA_WIDTH] = sparse ? sp_val[g][cur_pos] : weights[g][cur_pos];
+
+            // Final sum over input channels feeds the epilogue
+            assign act_in[g*DATA_WIDTH +: DATA_WIDTH] = (ic == 0)
+                ? pe_results[g*DATA_WIDTH +: DATA_WIDTH]
+                : psum_q[g] + pe_results[g*DATA_WIDTH +: DATA_WIDTH];
+        end
+    endgenerate
+
+    activation_unit #(
+        .DATA_WIDTH(DATA_WIDTH),
+        .LANES(OC_GROUP)
+    ) u_activation (
+        .clk(clk),
+        .rst_n(rst_n),
+        .func(act_func),
+        .alpha(act_alpha),
+        .in_data(act_in),
+        .in_valid(state == ACTIVATE && !act_issued),
+        .out_data(act_out),
+        .out_valid(act_out_valid)
+    );
+
+    pooling_unit #(
+        .DATA_WIDTH(DATA_WIDTH)
+    ) u_pool (
+        .clk(clk),
+        .rst_n(rst_n),
+        .mode(pool_mode),
+        .recip(recip),
+        .in_data(global_pool ? push_data : tap_pixel),
+        .in_valid(pool_in_valid),
+        .in_first(pool_in_first),
+        .out_data(pool_out)
+    );
+
+    // Output assignments
+    assign busy = (state != IDLE);
+    assign pe_enable = (state == COMPUTE) && !pool;
+    assign pe_acc_clear = tap_first;
+    assign mem_addr = mem_addr_reg;
+    assign mem_wdata = mem_wdata_reg;
+    assign mem_we = mem_we_reg;
+    assign mem_re = mem_re_reg;
+
+endmodule
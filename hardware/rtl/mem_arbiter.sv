@@ -0,0 +1,108 @@
+/**
+ * Memory Arbiter Module
+ *
+ * Shares the single DDR4 port between CORE_COUNT npu_core instances. Each
+ * core holds mem_re/mem_we with a stable address until it sees mem_valid,
+ * so a grant is held for exactly one access. After the response the port
+ * idles for one cycle so a response to the previous requester can never
+ * be delivered to the next one, then the grant moves round-robin to the
+ * next core with a request pending.
+ */
+
+module mem_arbiter #(
+    parameter DATA_WIDTH = 32,
+    parameter ADDR_WIDTH = 32,
+    parameter CORE_COUNT = 4
+) (
+    input  wire clk,
+    input  wire rst_n,
+
+    // Per-core memory ports
+    input  wire [CORE_COUNT*ADDR_WIDTH-1:0] core_mem_addr,
+    input  wire [CORE_COUNT*DATA_WIDTH-1:0] core_mem_wdata,
+    output wire [DATA_WIDTH-1:0] core_mem_rdata,
+    input  wire [CORE_COUNT-1:0] core_mem_we,
+    input  wire [CORE_COUNT-1:0] core_mem_re,
+    output wire [CORE_COUNT-1:0] core_mem_valid,
+
+    // Shared memory port
+    output wire [ADDR_WIDTH-1:0] mem_addr,
+    output wire [DATA_WIDTH-1:0] mem_wdata,
+    input  wire [DATA_WIDTH-1:0] mem_rdata,
+    output wire mem_we,
+    output wire mem_re,
+    input  wire mem_valid
+);
+
+    localparam CORE_BITS = (CORE_COUNT > 1) ? $clog2(CORE_COUNT) : 1;
+
+    typedef enum logic [1:0] {
+        ARB_IDLE,
+        ARB_GRANT,
+        ARB_TURNAROUND
+    } arb_state_t;
+
+    arb_state_t state;
+    reg [CORE_BITS-1:0] grant;
+    reg [CORE_BITS-1:0] rr;
+
+    wire [CORE_COUNT-1:0] req = core_mem_re | core_mem_we;
+
+    reg [CORE_BITS-1:0] next_grant;
+    reg req_found;
+    integer k;
+
+    always_comb begin
+        next_grant = rr;
+        req_found = 1'b0;
+        for (k = 0; k < CORE_COUNT; k++) begin
+            if (!req_found && req[(rr + k) % CORE_COUNT]) begin
+                next_grant = (rr + k) % CORE_COUNT;
+                req_found = 1'b1;
+            end
+        end
+    end
+
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            state <= ARB_IDLE;
+            grant <= '0;
+            rr <= '0;
+        end else begin
+            case (state)
+                ARB_IDLE: begin
+                    if (req_found) begin
+                        grant <= next_grant;
+                        state <= ARB_GRANT;
+                    end
+                end
+                ARB_GRANT: begin
+                    if (mem_valid || !req[grant]) begin
+                        rr <= (grant == CORE_COUNT - 1) ? '0 : grant + 1'b1;
+                        state <= ARB_TURNAROUND;
+                    end
+                end
+                ARB_TURNAROUND: begin
+                    state <= ARB_IDLE;
+                end
+                default: state <= ARB_IDLE;
+            endcase
+        end
+    end
+
+    wire granted = (state == ARB_GRANT);
+
+    assign mem_addr = core_mem_addr[grant*ADDR_WIDTH +: ADDR_WIDTH];
+    assign mem_wdata = core_mem_wdata[grant*DATA_WIDTH +: DATA_WIDTH];
+    assign mem_we = granted && core_mem_we[grant];
+    assign mem_re = granted && core_mem_re[grant];
+    assign core_mem_rdata = mem_rdata;
+
+    genvar c;
+    generate
+        for (c = 0; c < CORE_COUNT; c++) begin : core_ports
+            assign core_mem_valid[c] = granted && (grant == c) && mem_valid;
+        end
+    endgenerate
+
+endmodule
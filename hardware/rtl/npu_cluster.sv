@@ -0,0 +1,211 @@
+/**
+ * NPU Cluster Module
+ *
+ * CORE_COUNT npu_core instances sharing one host stream and one memory
+ * port. The work distributor deals instructions from the host stream to
+ * the cores and merges their results; the memory arbiter serialises their
+ * memory accesses (a single core is wired straight through). Each core
+ * gates its PEs with pe_enable_mask and the partition mask of the
+ * instruction's ROUTE prefix (bit n covers PE n mod 16). Performance
+ * counters are summed over cores and per-core counters are exported for
+ * the register block.
+ */
+
+module npu_cluster #(
+    parameter DATA_WIDTH = 32,
+    parameter ADDR_WIDTH = 32,
+    parameter PE_COUNT = 16,
+    parameter CORE_COUNT = 1
+) (
+    input  wire clk,
+    input  wire rst_n,
+    
+    // Host Interface (shared instruction queue and merged results)
+    input  wire [DATA_WIDTH-1:0] host_data_in,
+    input  wire host_data_in_valid,
+    output wire host_data_in_ready,
+    
+    output wire [DATA_WIDTH-1:0] host_data_out,
+    output wire host_data_out_valid,
+    input  wire host_data_out_ready,
+    output wire [7:0]  host_data_out_core,      // Completion tags for host_data_out
+    output wire [7:0]  host_data_out_opcode,
+    output wire [31:0] host_data_out_cycles,
+    
+    // Configuration (REG_CONFIG)
+    input  wire [PE_COUNT-1:0] pe_enable_mask,
+    
+    // Memory Interface
+    output wire [ADDR_WIDTH-1:0] mem_addr,
+    output wire [DATA_WIDTH-1:0] mem_wdata,
+    input  wire [DATA_WIDTH-1:0] mem_rdata,
+    output wire mem_we,
+    output wire mem_re,
+    input  wire mem_valid,
+    
+    // Performance monitor, summed over cores
+    input  wire perf_clear,
+    output reg  [63:0] perf_macs_nominal,
+    output reg  [63:0] perf_macs_skipped,
+    output reg  [63:0] perf_mult_gated,
+    
+    // Per-core status and counters
+    output wire [CORE_COUNT*4-1:0]  core_status,
+    output wire [CORE_COUNT-1:0]    core_busy,
+    output wire [CORE_COUNT*32-1:0] core_inst_count,
+    output wire [CORE_COUNT*32-1:0] core_busy_cycles
+);
+
+    // Per-core host streams
+    wire [DATA_WIDTH-1:0] core_in_data;
+    wire [15:0] core_in_pe_mask;
+    wire [PE_COUNT-1:0] core_pe_mask;
+    wire [CORE_COUNT-1:0] core_in_valid;
+    wire [CORE_COUNT-1:0] core_in_ready;
+    wire [CORE_COUNT*DATA_WIDTH-1:0] core_out_data;
+    wire [CORE_COUNT-1:0] core_out_valid;
+    wire [CORE_COUNT-1:0] core_out_ready;
+    
+    // Per-core memory ports
+    wire [CORE_COUNT*ADDR_WIDTH-1:0] core_mem_addr;
+    wire [CORE_COUNT*DATA_WIDTH-1:0] core_mem_wdata;
+    wire [DATA_WIDTH-1:0] core_mem_rdata;
+    wire [CORE_COUNT-1:0] core_mem_we;
+    wire [CORE_COUNT-1:0] core_mem_re;
+    wire [CORE_COUNT-1:0] core_mem_valid;
+    
+    // Per-core performance counters
+    wire [63:0] core_macs_nominal [CORE_COUNT];
+    wire [63:0] core_macs_skipped [CORE_COUNT];
+    wire [63:0] core_mult_gated [CORE_COUNT];
+    
+    // Work distributor: the host stream is the shared instruction queue
+    work_distributor #(
+        .DATA_WIDTH(DATA_WIDTH),
+        .CORE_COUNT(CORE_COUNT)
+    ) u_work_distributor (
+        .clk(clk),
+        .rst_n(rst_n),
+        
+        .in_data(host_data_in),
+        .in_valid(host_data_in_valid),
+        .in_ready(host_data_in_ready),
+        
+        .core_in_data(core_in_data),
+        .core_in_pe_mask(core_in_pe_mask),
+        .core_in_valid(core_in_valid),
+        .core_in_ready(core_in_ready),
+        
+        .core_out_data(core_out_data),
+        .core_out_valid(core_out_valid),
+        .core_out_ready(core_out_ready),
+        
+        .out_data(host_data_out),
+        .out_valid(host_data_out_valid),
+        .out_ready(host_data_out_ready),
+        .out_core(host_data_out_core),
+        .out_opcode(host_data_out_opcode),
+        .out_cycles(host_data_out_cycles),
+        
+        .perf_clear(perf_clear),
+        .core_busy(core_busy),
+        .core_inst_count(core_inst_count),
+        .core_busy_cycles(core_busy_cycles)
+    );
+    
+    // NPU Core Instances
+    genvar c;
+    generate
+        for (c = 0; c < PE_COUNT; c++) begin : pe_mask_map
+            assign core_pe_mask[c] = core_in_pe_mask[c % 16];
+        end
+        
+        for (c = 0; c < CORE_COUNT; c++) begin : cores
+            npu_core #(
+                .DATA_WIDTH(DATA_WIDTH),
+                .ADDR_WIDTH(ADDR_WIDTH),
+                .PE_COUNT(PE_COUNT)
+            ) u_npu_core (
+                .clk(clk),
+                .rst_n(rst_n),
+                
+                // Host Interface
+                .host_data_in(core_in_data),
+                .host_data_in_valid(core_in_valid[c]),
+                .host_data_in_ready(core_in_ready[c]),
+                .host_pe_mask(core_pe_mask),
+                
+                .host_data_out(core_out_data[c*DATA_WIDTH +: DATA_WIDTH]),
+                .host_data_out_valid(core_out_valid[c]),
+                .host_data_out_ready(core_out_ready[c]),
+                
+                // Memory Interface
+                .mem_addr(core_mem_addr[c*ADDR_WIDTH +: ADDR_WIDTH]),
+                .mem_wdata(core_mem_wdata[c*DATA_WIDTH +: DATA_WIDTH]),
+                .mem_rdata(core_mem_rdata),
+                .mem_we(core_mem_we[c]),
+                .mem_re(core_mem_re[c]),
+                .mem_valid(core_mem_valid[c]),
+                
+                // Status
+                .status(core_status[c*4 +: 4]),
+                
+                // Configuration
+                .pe_enable_mask(pe_enable_mask),
+                
+                // Performance monitor
+                .perf_clear(perf_clear),
+                .perf_macs_nominal(core_macs_nominal[c]),
+                .perf_macs_skipped(core_macs_skipped[c]),
+                .perf_mult_gated(core_mult_gated[c])
+            );
+        end
+    endgenerate
+    
+    always_comb begin
+        perf_macs_nominal = '0;
+        perf_macs_skipped = '0;
+        perf_mult_gated = '0;
+        for (int i = 0; i < CORE_COUNT; i++) begin
+            perf_macs_nominal = perf_macs_nominal + core_macs_nominal[i];
+            perf_macs_skipped = perf_macs_skipped + core_macs_skipped[i];
+            perf_mult_gated = perf_mult_gated + core_mult_gated[i];
+        end
+    end
+    
+    // Memory port: direct for one core, arbitrated otherwise
+    generate
+        if (CORE_COUNT == 1) begin : mem_direct
+            assign mem_addr = core_mem_addr;
+            assign mem_wdata = core_mem_wdata;
+            assign core_mem_rdata = mem_rdata;
+            assign mem_we = core_mem_we[0];
+            assign mem_re = core_mem_re[0];
+            assign core_mem_valid = mem_valid;
+        end else begin : mem_shared
+            mem_arbiter #(
+                .DATA_WIDTH(DATA_WIDTH),
+                .ADDR_WIDTH(ADDR_WIDTH),
+                .CORE_COUNT(CORE_COUNT)
+            ) u_mem_arbiter (
+                .clk(clk),
+                .rst_n(rst_n),
+                
+                .core_mem_addr(core_mem_addr),
+                .core_mem_wdata(core_mem_wdata),
+                .core_mem_rdata(core_mem_rdata),
+                .core_mem_we(core_mem_we),
+                .core_mem_re(core_mem_re),
+                .core_mem_valid(core_mem_valid),
+                
+                .mem_addr(mem_addr),
+                .mem_wdata(mem_wdata),
+                .mem_rdata(mem_rdata),
+                .mem_we(mem_we),
+                .mem_re(mem_re),
+                .mem_valid(mem_valid)
+            );
+        end
+    endgenerate
+
+endmodule
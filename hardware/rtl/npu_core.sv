@@ -3,6 +3,12 @@
  * 
  * Main NPU processing core containing:
  * - Processing Element array
+ * - Activation unit (stand-alone or fused epilogue)
+ * - Streaming convolution / pooling engine (drives the PE array); MATMUL
+ *   runs on it as a 1x1 convolution, fused epilogue included
+ * - Zero-skip performance counters (nominal / skipped MACs, gated multipliers)
+ * - Run-time PE gating: REG_CONFIG pe_enable_mask ANDed with the partition
+ *   mask the host sends with each instruction
  * - Instruction decoder
  * - Memory management unit
  * - Control logic
@@ -12,7 +18,11 @@ module npu_core #(
     parameter DATA_WIDTH = 32,
     parameter ADDR_WIDTH = 32,
     parameter PE_COUNT = 16,
-    parameter INST_WIDTH = 32
+    parameter INST_WIDTH = 32,
+    parameter PE_MAC_LATENCY = 1,
+    parameter CONV_MAX_KERNEL = 5,
+    parameter CONV_MAX_WIDTH = 64,
+    parameter CONV_MAX_OUT_PIXELS = 1024
 ) (
     input  wire clk,
     input  wire rst_n,
@@ -21,6 +31,7 @@ module npu_core #(
     input  wire [DATA_WIDTH-1:0] host_data_in,
     input  wire host_data_in_valid,
     output wire host_data_in_ready,
+    input  wire [PE_COUNT-1:0] host_pe_mask,    // Partition of the instruction word on host_data_in
     
     output wire [DATA_WIDTH-1:0] host_data_out,
     output wire host_data_out_valid,
@@ -35,16 +46,29 @@ module npu_core #(
     input  wire mem_valid,
     
     // Status
-    output wire [3:0] status
+    output wire [3:0] status,
+    
+    // Configuration (REG_CONFIG)
+    input  wire [PE_COUNT-1:0] pe_enable_mask,
+    
+    // Performance monitor
+    input  wire perf_clear,
+    output reg  [63:0] perf_macs_nominal,   // MACs issued to the PE array, zeros included
+    output reg  [63:0] perf_macs_skipped,   // MACs not computed because an operand was zero
+    output reg  [63:0] perf_mult_gated      // PE cycles with the multiplier clock-enable held low
+                                            // (zero operands and disabled PEs)
 );
 
     // Internal state machine
-    typedef enum logic [2:0] {
+    typedef enum logic [3:0] {
         IDLE,
         DECODE,
         EXECUTE,
         MEMORY_ACCESS,
-        WRITEBACK
+        WRITEBACK,
+        ACTIVATE,
+        FETCH_DESC,
+        CONV_RUN
     } npu_state_t;
     
     npu_state_t current_state, next_state;
@@ -55,9 +79,15 @@ module npu_core #(
     reg [ADDR_WIDTH-1:0] mem_addr_reg;
     reg mem_we_reg, mem_re_reg;
     
+    // PEs this instruction may use; the rest keep their clock-enable low
+    reg [PE_COUNT-1:0] inst_pe_mask;
+    wire [PE_COUNT-1:0] pe_active = inst_pe_mask & pe_enable_mask;
+    
     // Processing Element array
     wire [DATA_WIDTH-1:0] pe_results [PE_COUNT-1:0];
     wire [PE_COUNT-1:0] pe_valid;
+    wire [PE_COUNT-1:0] pe_skipped;
+    wire [$clog2(DATA_WIDTH/8+1)-1:0] pe_zero_lanes [PE_COUNT-1:0];
     
     // Instruction fields
     wire [7:0] opcode = instruction_reg[31:24];
@@ -65,6 +95,130 @@ module npu_core #(
     wire [7:0] src2 = instruction_reg[15:8];
     wire [7:0] dst = instruction_reg[7:0];
     
+    // Opcode byte: [4:0] operation, [7:5] fused activation epilogue
+    wire [4:0] base_opcode = opcode[4:0];
+    wire [2:0] epilogue = opcode[7:5];
+    
+    // Activation opcodes and function codes (see activation_unit.sv)
+    localparam OP_RELU    = 5'h07;  // src2 != 0 selects leaky ReLU, alpha = src2/256
+    localparam OP_SIGMOID = 5'h08;
+    localparam OP_TANH    = 5'h0B;
+    
+    localparam ACT_NONE       = 3'h0;
+    localparam ACT_RELU       = 3'h1;
+    localparam ACT_LEAKY_RELU = 3'h2;
+    localparam ACT_SIGMOID    = 3'h3;
+    localparam ACT_TANH       = 3'h4;
+    
+    // Activation unit interface
+    reg [15:0] act_alpha;       // Leaky ReLU slope used by fused epilogues
+    reg act_issued;
+    reg [2:0] act_func;
+    wire [15:0] act_alpha_sel;
+    wire [DATA_WIDTH-1:0] act_out;
+    wire act_out_valid;
+    wire act_in_valid = (current_state == ACTIVATE) && !act_issued;
+    
+    always_comb begin
+        case (base_opcode)
+            OP_RELU:    act_func = (src2 != 8'h00) ? ACT_LEAKY_RELU : ACT_RELU;
+            OP_SIGMOID: act_func = ACT_SIGMOID;
+            OP_TANH:    act_func = ACT_TANH;
+            default:    act_func = epilogue;
+        endcase
+    end
+    
+    assign act_alpha_sel = (base_opcode == OP_RELU) ? {src2, 8'h00} : act_alpha;
+    
+    // Descriptor opcodes are followed by eight words on the host stream,
+    // matching npu_instruction_t: src1, src2, dst, size, params[0..3]
+    localparam OP_CONV = 5'h05;
+    localparam OP_MATMUL = 5'h06;
+    localparam OP_POOLING = 5'h09;
+    localparam DESC_WORDS = 8;
+    
+    wire is_pool = (base_opcode == OP_POOLING);
+    wire is_matmul = (base_opcode == OP_MATMUL);
+    wire has_desc = (base_opcode == OP_CONV) || is_pool || is_matmul;
+    
+    reg [DATA_WIDTH-1:0] desc [DESC_WORDS];
+    reg [2:0] desc_idx;
+    reg conv_started;
+    
+    // Convolution engine interface
+    wire conv_active = (current_state == CONV_RUN);
+    wire conv_start = conv_active && !conv_started;
+    wire conv_busy, conv_done, conv_error;
+    wire conv_pe_enable, conv_pe_acc_clear;
+    wire [PE_COUNT*DATA_WIDTH-1:0] conv_pe_op_a;
+    wire [PE_COUNT*DATA_WIDTH-1:0] conv_pe_op_b;
+    wire [PE_COUNT*DATA_WIDTH-1:0] pe_results_flat;
+    wire [ADDR_WIDTH-1:0] conv_mem_addr;
+    wire [DATA_WIDTH-1:0] conv_mem_wdata;
+    wire conv_mem_we, conv_mem_re;
+    wire [$clog2(CONV_MAX_KERNEL*CONV_MAX_KERNEL+1)-1:0] conv_taps_skipped;
+    
+    // MATMUL C[M,N] = A[M,K] x B[K,N] is a 1x1 convolution in the engine's
+    // layouts: B is the input (K channels of an N x 1 plane), A the weights
+    // (M output channels of K taps) and C the output. M, K and N arrive in
+    // params[0..2]; shapes wider than the engine fields are rejected here.
+    wire matmul_fits = (desc[4][31:12] == '0) && (desc[5][31:12] == '0) &&
+                       (desc[6][31:16] == '0);
+    
+    // Engine configuration per descriptor opcode
+    reg [ADDR_WIDTH-1:0] eng_in_addr, eng_w_addr;
+    reg [15:0] eng_in_h, eng_in_w;
+    reg [11:0] eng_in_c, eng_out_c;
+    reg [3:0] eng_kernel_h, eng_kernel_w;
+    reg [3:0] eng_stride_h, eng_stride_w;
+    reg [3:0] eng_pad_h, eng_pad_w;
+    reg eng_sparse;
+    
+    always_comb begin
+        eng_in_addr = desc[0];
+        eng_w_addr = desc[1];
+        eng_out_c = desc[7][11:0];
+        eng_sparse = 1'b0;
+        if (is_pool) begin
+            // POOLING: src2 = {H, W}, params = kernel, stride, pad, {C, mode}
+            eng_in_h = desc[1][31:16];
+            eng_in_w = desc[1][15:0];
+            eng_in_c = desc[7][19:8];
+            eng_kernel_h = desc[4][19:16];
+            eng_kernel_w = desc[4][3:0];
+            eng_stride_h = desc[5][19:16];
+            eng_stride_w = desc[5][3:0];
+            eng_pad_h = desc[6][19:16];
+            eng_pad_w = desc[6][3:0];
+        end else if (is_matmul) begin
+            // MATMUL: src1 = A, src2 = B, params = M, K, N
+            eng_in_addr = desc[1];
+            eng_w_addr = desc[0];
+            eng_in_h = desc[6][15:0];
+            eng_in_w = 16'd1;
+            eng_in_c = desc[5][11:0];
+            eng_out_c = desc[4][11:0];
+            eng_kernel_h = 4'd1;
+            eng_kernel_w = 4'd1;
+            eng_stride_h = 4'd1;
+            eng_stride_w = 4'd1;
+            eng_pad_h = 4'd0;
+            eng_pad_w = 4'd0;
+        end else begin
+            // CONV: src2 = weights, params = stride, pad, {H, W}, {sparse, K, C_in, C_out}
+            eng_in_h = desc[6][31:16];
+            eng_in_w = desc[6][15:0];
+            eng_in_c = desc[7][23:12];
+            eng_kernel_h = desc[7][27:24];
+            eng_kernel_w = desc[7][27:24];
+            eng_stride_h = desc[4][19:16];
+            eng_stride_w = desc[4][3:0];
+            eng_pad_h = desc[5][19:16];
+            eng_pad_w = desc[5][3:0];
+            eng_sparse = desc[7][28];           // 2:4 compressed weights
+        end
+    end
+    
     // State machine
     always_ff @(posedge clk or negedge rst_n) begin
         if (!rst_n) begin
@@ -83,16 +237,33 @@ module npu_core #(
                 end
             end
             DECODE: begin
-                next_state = EXECUTE;
+                next_state = has_desc ? FETCH_DESC : EXECUTE;
+            end
+            FETCH_DESC: begin
+                if (host_data_in_valid && desc_idx == DESC_WORDS - 1) begin
+                    next_state = (is_matmul && !matmul_fits) ? WRITEBACK : CONV_RUN;
+                end
+            end
+            CONV_RUN: begin
+                if (conv_done) begin
+                    next_state = WRITEBACK;
+                end
             end
             EXECUTE: begin
-                case (opcode)
-                    8'h01, 8'h02: next_state = WRITEBACK; // ADD, SUB
-                    8'h03, 8'h04: next_state = WRITEBACK; // MUL, MAC
-                    8'h10, 8'h11: next_state = MEMORY_ACCESS; // LOAD, STORE
+                case (base_opcode)
+                    5'h01, 5'h02, 5'h03, 5'h04: begin // ADD, SUB, MUL, MAC
+                        next_state = (epilogue != ACT_NONE) ? ACTIVATE : WRITEBACK;
+                    end
+                    OP_RELU, OP_SIGMOID, OP_TANH: next_state = ACTIVATE;
+                    5'h10, 5'h11: next_state = MEMORY_ACCESS; // LOAD, STORE
                     default: next_state = IDLE;
                 endcase
             end
+            ACTIVATE: begin
+                if (act_out_valid) begin
+                    next_state = WRITEBACK;
+                end
+            end
             MEMORY_ACCESS: begin
                 if (mem_valid) begin
                     next_state = WRITEBACK;
@@ -110,17 +281,26 @@ module npu_core #(
     always_ff @(posedge clk or negedge rst_n) begin
         if (!rst_n) begin
             instruction_reg <= '0;
+            inst_pe_mask <= '0;
             operand_a <= '0;
             operand_b <= '0;
             result <= '0;
             mem_addr_reg <= '0;
             mem_we_reg <= 1'b0;
             mem_re_reg <= 1'b0;
+            act_alpha <= 16'h028F;  // 0.01 in Q0.16
+            act_issued <= 1'b0;
+            desc_idx <= '0;
+            conv_started <= 1'b0;
         end else begin
+            act_issued <= (current_state == ACTIVATE);
+            conv_started <= conv_active;
+
             case (current_state)
                 IDLE: begin
                     if (host_data_in_valid) begin
                         instruction_reg <= host_data_in;
+                        inst_pe_mask <= host_pe_mask;
                     end
                     mem_we_reg <= 1'b0;
                     mem_re_reg <= 1'b0;
@@ -129,26 +309,52 @@ module npu_core #(
                     // Decode operands (simplified)
                     operand_a <= {24'h0, src1};
                     operand_b <= {24'h0, src2};
+                    desc_idx <= '0;
+                end
+                FETCH_DESC: begin
+                    if (host_data_in_valid) begin
+                        desc[desc_idx] <= host_data_in;
+                        desc_idx <= desc_idx + 1'b1;
+                        if (desc_idx == DESC_WORDS - 1 && is_matmul && !matmul_fits) begin
+                            result <= {{(DATA_WIDTH-1){1'b0}}, 1'b1};
+                        end
+                    end
+                end
+                CONV_RUN: begin
+                    if (conv_done) begin
+                        result <= {{(DATA_WIDTH-1){1'b0}}, conv_error};
+                    end
                 end
                 EXECUTE: begin
-                    case (opcode)
-                        8'h01: result <= operand_a + operand_b; // ADD
-                        8'h02: result <= operand_a - operand_b; // SUB
-                        8'h03: result <= operand_a * operand_b; // MUL
-                        8'h04: result <= result + (operand_a * operand_b); // MAC
-                        8'h10: begin // LOAD
+                    case (base_opcode)
+                        5'h01: result <= operand_a + operand_b; // ADD
+                        5'h02: result <= operand_a - operand_b; // SUB
+                        5'h03: result <= operand_a * operand_b; // MUL
+                        5'h04: result <= result + (operand_a * operand_b); // MAC
+                        OP_RELU, OP_SIGMOID, OP_TANH: begin
+                            result <= operand_a;
+                            if (base_opcode == OP_RELU && src2 != 8'h00) begin
+                                act_alpha <= act_alpha_sel;
+                            end
+                        end
+                        5'h10: begin // LOAD
                             mem_addr_reg <= {24'h0, src1};
                             mem_re_reg <= 1'b1;
                         end
-                        8'h11: begin // STORE
+                        5'h11: begin // STORE
                             mem_addr_reg <= {24'h0, dst};
                             mem_we_reg <= 1'b1;
                         end
                     endcase
                 end
+                ACTIVATE: begin
+                    if (act_out_valid) begin
+                        result <= act_out;
+                    end
+                end
                 MEMORY_ACCESS: begin
                     if (mem_valid) begin
-                        if (opcode == 8'h10) begin // LOAD
+                        if (base_opcode == 5'h10) begin // LOAD
                             result <= mem_rdata;
                         end
                         mem_we_reg <= 1'b0;
@@ -164,29 +370,140 @@ module npu_core #(
     generate
         for (i = 0; i < PE_COUNT; i++) begin : pe_array
             processing_element #(
-                .DATA_WIDTH(DATA_WIDTH)
+                .DATA_WIDTH(DATA_WIDTH),
+                .MAC_LATENCY(PE_MAC_LATENCY)
             ) u_pe (
                 .clk(clk),
                 .rst_n(rst_n),
-                .enable(current_state == EXECUTE),
-                .op_a(operand_a),
-                .op_b(operand_b),
-                .operation(opcode[3:0]),
+                .enable((current_state == EXECUTE || conv_pe_enable) && pe_active[i]),
+                .op_a(conv_active ? conv_pe_op_a[i*DATA_WIDTH +: DATA_WIDTH] : operand_a),
+                .op_b(conv_active ? conv_pe_op_b[i*DATA_WIDTH +: DATA_WIDTH] : operand_b),
+                .operation(conv_active ? 4'h4 : opcode[3:0]),  // Convolution always MACs
+                .acc_clear(conv_active && conv_pe_acc_clear),
+                .precision(2'b00),      // INT32
+                .saturate(1'b0),
+                .round_mode(2'b00),
+                .shift_amt(5'd0),
                 .result(pe_results[i]),
-                .valid(pe_valid[i])
+                .valid(pe_valid[i]),
+                .zero_lanes(pe_zero_lanes[i]),
+                .skipped(pe_skipped[i])
             );
+            
+            assign pe_results_flat[i*DATA_WIDTH +: DATA_WIDTH] = pe_results[i];
         end
     endgenerate
     
+    // Convolution / pooling engine, one output channel per PE
+    conv_engine #(
+        .DATA_WIDTH(DATA_WIDTH),
+        .ADDR_WIDTH(ADDR_WIDTH),
+        .OC_GROUP(PE_COUNT),
+        .MAX_KERNEL(CONV_MAX_KERNEL),
+        .MAX_WIDTH(CONV_MAX_WIDTH),
+        .MAX_OUT_PIXELS(CONV_MAX_OUT_PIXELS)
+    ) u_conv (
+        .clk(clk),
+        .rst_n(rst_n),
+        .start(conv_start),
+        .busy(conv_busy),
+        .done(conv_done),
+        .error(conv_error),
+        .cfg_pool(is_pool),
+        .cfg_sparse(eng_sparse),
+        .cfg_lane_mask(pe_active),
+        .cfg_pool_mode(desc[7][1:0]),
+        .cfg_in_addr(eng_in_addr),
+        .cfg_w_addr(eng_w_addr),
+        .cfg_out_addr(desc[2]),
+        .cfg_in_h(eng_in_h),
+        .cfg_in_w(eng_in_w),
+        .cfg_in_c(eng_in_c),
+        .cfg_out_c(eng_out_c),
+        .cfg_kernel_h(eng_kernel_h),
+        .cfg_kernel_w(eng_kernel_w),
+        .cfg_stride_h(eng_stride_h),
+        .cfg_stride_w(eng_stride_w),
+        .cfg_pad_h(eng_pad_h),
+        .cfg_pad_w(eng_pad_w),
+        .cfg_act_func(epilogue),
+        .cfg_act_alpha(act_alpha),
+        .pe_enable(conv_pe_enable),
+        .pe_acc_clear(conv_pe_acc_clear),
+        .pe_op_a(conv_pe_op_a),
+        .pe_op_b(conv_pe_op_b),
+        .pe_results(pe_results_flat),
+        .pe_valid(|pe_valid),
+        .taps_skipped(conv_taps_skipped),
+        .mem_addr(conv_mem_addr),
+        .mem_wdata(conv_mem_wdata),
+        .mem_rdata(mem_rdata),
+        .mem_we(conv_mem_we),
+        .mem_re(conv_mem_re),
+        .mem_valid(mem_valid)
+    );
+    
+    // Zero-skip counters. The PEs run INT32 here, so one MAC per active PE
+    // per issue; taps compacted out by the engine count once per active PE.
+    // Disabled PEs count as gated for every issue they sit out.
+    wire pe_mac_issue = (current_state == EXECUTE && base_opcode == 5'h04) || conv_pe_enable;
+    logic [$clog2(PE_COUNT*(DATA_WIDTH/8)+1)-1:0] pe_skip_sum;
+    logic [$clog2(PE_COUNT+1)-1:0] pe_gated_sum;
+    logic [$clog2(PE_COUNT+1)-1:0] pe_active_count;
+    
+    always_comb begin
+        pe_skip_sum = '0;
+        pe_gated_sum = '0;
+        pe_active_count = '0;
+        for (int p = 0; p < PE_COUNT; p++) begin
+            pe_skip_sum = pe_skip_sum + pe_zero_lanes[p];
+            pe_gated_sum = pe_gated_sum + pe_skipped[p] + (pe_mac_issue && !pe_active[p]);
+            pe_active_count = pe_active_count + pe_active[p];
+        end
+    end
+    
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            perf_macs_nominal <= '0;
+            perf_macs_skipped <= '0;
+            perf_mult_gated <= '0;
+        end else if (perf_clear) begin
+            perf_macs_nominal <= '0;
+            perf_macs_skipped <= '0;
+            perf_mult_gated <= '0;
+        end else begin
+            perf_macs_nominal <= perf_macs_nominal + (pe_mac_issue ? pe_active_count : 0)
+                                                   + conv_taps_skipped * pe_active_count;
+            perf_macs_skipped <= perf_macs_skipped + pe_skip_sum
+                                                   + conv_taps_skipped * pe_active_count;
+            perf_mult_gated <= perf_mult_gated + pe_gated_sum;
+        end
+    end
+    
+    // Activation unit on the writeback path
+    activation_unit #(
+        .DATA_WIDTH(DATA_WIDTH),
+        .LANES(1)
+    ) u_activation (
+        .clk(clk),
+        .rst_n(rst_n),
+        .func(act_func),
+        .alpha(act_alpha_sel),
+        .in_data(result),
+        .in_valid(act_in_valid),
+        .out_data(act_out),
+        .out_valid(act_out_valid)
+    );
+    
     // Output assignments
-    assign host_data_in_ready = (current_state == IDLE);
+    assign host_data_in_ready = (current_state == IDLE) || (current_state == FETCH_DESC);
     assign host_data_out = result;
     assign host_data_out_valid = (current_state == WRITEBACK);
     
-    assign mem_addr = mem_addr_reg;
-    assign mem_wdata = operand_a; // For STORE operations
-    assign mem_we = mem_we_reg;
-    assign mem_re = mem_re_reg;
+    assign mem_addr = conv_active ? conv_mem_addr : mem_addr_reg;
+    assign mem_wdata = conv_active ? conv_mem_wdata : operand_a; // operand_a for STORE
+    assign mem_we = conv_active ? conv_mem_we : mem_we_reg;
+    assign mem_re = conv_active ? conv_mem_re : mem_re_reg;
     
     assign status = {current_state[1:0], pe_valid[1:0]};
 
@@ -2,14 +2,19 @@
  * NPU Top Level Module
  * 
  * This is the top-level module for the FPGA NPU with PCIe interface.
- * It instantiates the NPU core, PCIe interface, and memory controller.
+ * It instantiates the NPU cluster (CORE_COUNT cores behind a work
+ * distributor and memory arbiter), PCIe interface, and memory controller.
+ * Results pass through the completion writer, which posts a completion
+ * record per result into a host-memory ring (cq_wr_* is bridged to PCIe
+ * memory writes next to the register block).
  */
 
 module npu_top #(
     parameter DATA_WIDTH = 32,
     parameter ADDR_WIDTH = 32,
     parameter PE_COUNT = 16,
-    parameter PCIE_DATA_WIDTH = 128
+    parameter PCIE_DATA_WIDTH = 128,
+    parameter CORE_COUNT = 1
 ) (
     // Clock and Reset
     input  wire clk,
@@ -19,9 +24,11 @@ module npu_top #(
     input  wire         pcie_clk,
     input  wire         pcie_rst_n,
     input  wire [PCIE_DATA_WIDTH-1:0] pcie_rx_data,
+    input  wire [PCIE_DATA_WIDTH/DATA_WIDTH-1:0] pcie_rx_keep,
     input  wire         pcie_rx_valid,
     output wire         pcie_rx_ready,
     output wire [PCIE_DATA_WIDTH-1:0] pcie_tx_data,
+    output wire [PCIE_DATA_WIDTH/DATA_WIDTH-1:0] pcie_tx_keep,
     output wire         pcie_tx_valid,
     input  wire         pcie_tx_ready,
     
@@ -35,7 +42,35 @@ module npu_top #(
     
     // Status and Control
     output wire [7:0]   status_leds,
-    input  wire [7:0]   dip_switches
+    input  wire [7:0]   dip_switches,
+    
+    // Configuration (REG_CONFIG)
+    input  wire [PE_COUNT-1:0] pe_enable_mask,
+    
+    // Performance monitor (REG_PERF_* register block), summed over cores
+    input  wire         perf_clear,
+    output wire [63:0]  perf_macs_nominal,
+    output wire [63:0]  perf_macs_skipped,
+    output wire [63:0]  perf_mult_gated,
+    
+    // Per-core status and counters (REG_CORE_* register block)
+    output wire [CORE_COUNT*4-1:0]  core_status,
+    output wire [CORE_COUNT-1:0]    core_busy,
+    output wire [CORE_COUNT*32-1:0] core_inst_count,
+    output wire [CORE_COUNT*32-1:0] core_busy_cycles,
+    
+    // Completion queue (REG_CQ_* register block) and its host-memory writes
+    input  wire         cq_enable,
+    input  wire [63:0]  cq_base,
+    input  wire [15:0]  cq_entries,
+    input  wire [15:0]  cq_head,
+    output wire [15:0]  cq_tail,
+    output wire [31:0]  cq_seq,
+    output wire [63:0]  cq_wr_addr,
+    output wire [127:0] cq_wr_data,
+    output wire         cq_wr_valid,
+    input  wire         cq_wr_ready,
+    output wire         cq_irq
 );
 
     // Internal signals
@@ -43,23 +78,24 @@ module npu_top #(
     wire npu_to_pcie_valid;
     wire npu_to_pcie_ready;
     
+    wire [DATA_WIDTH-1:0] result_data;
+    wire result_valid;
+    wire result_ready;
+    wire [7:0] result_core;
+    wire [7:0] result_opcode;
+    wire [31:0] result_cycles;
+    
     wire [DATA_WIDTH-1:0] pcie_to_npu_data;
     wire pcie_to_npu_valid;
     wire pcie_to_npu_ready;
     
-    wire [ADDR_WIDTH-1:0] npu_mem_addr;
-    wire [DATA_WIDTH-1:0] npu_mem_wdata;
-    wire [DATA_WIDTH-1:0] npu_mem_rdata;
-    wire npu_mem_we;
-    wire npu_mem_re;
-    wire npu_mem_valid;
-    
-    // NPU Core Instance
-    npu_core #(
+    // NPU cores, work distributor and memory arbiter
+    npu_cluster #(
         .DATA_WIDTH(DATA_WIDTH),
         .ADDR_WIDTH(ADDR_WIDTH),
-        .PE_COUNT(PE_COUNT)
-    ) u_npu_core (
+        .PE_COUNT(PE_COUNT),
+        .CORE_COUNT(CORE_COUNT)
+    ) u_npu_cluster (
         .clk(clk),
         .rst_n(rst_n),
         
@@ -68,20 +104,70 @@ module npu_top #(
         .host_data_in_valid(pcie_to_npu_valid),
         .host_data_in_ready(pcie_to_npu_ready),
         
-        .host_data_out(npu_to_pcie_data),
-        .host_data_out_valid(npu_to_pcie_valid),
-        .host_data_out_ready(npu_to_pcie_ready),
+        .host_data_out(result_data),
+        .host_data_out_valid(result_valid),
+        .host_data_out_ready(result_ready),
+        .host_data_out_core(result_core),
+        .host_data_out_opcode(result_opcode),
+        .host_data_out_cycles(result_cycles),
+        
+        // Configuration
+        .pe_enable_mask(pe_enable_mask),
         
         // Memory Interface
-        .mem_addr(npu_mem_addr),
-        .mem_wdata(npu_mem_wdata),
-        .mem_rdata(npu_mem_rdata),
-        .mem_we(npu_mem_we),
-        .mem_re(npu_mem_re),
-        .mem_valid(npu_mem_valid),
+        .mem_addr(mem_addr),
+        .mem_wdata(mem_wdata),
+        .mem_rdata(mem_rdata),
+        .mem_we(mem_we),
+        .mem_re(mem_re),
+        .mem_valid(mem_valid),
         
-        // Status
-        .status(status_leds[3:0])
+        // Performance monitor
+        .perf_clear(perf_clear),
+        .perf_macs_nominal(perf_macs_nominal),
+        .perf_macs_skipped(perf_macs_skipped),
+        .perf_mult_gated(perf_mult_gated),
+        
+        // Per-core status and counters
+        .core_status(core_status),
+        .core_busy(core_busy),
+        .core_inst_count(core_inst_count),
+        .core_busy_cycles(core_busy_cycles)
+    );
+    
+    assign status_leds[3:0] = core_status[3:0];
+    
+    // Completion records into the host-memory ring
+    completion_writer #(
+        .DATA_WIDTH(DATA_WIDTH)
+    ) u_completion_writer (
+        .clk(clk),
+        .rst_n(rst_n),
+        
+        .res_data(result_data),
+        .res_valid(result_valid),
+        .res_ready(result_ready),
+        .res_core(result_core),
+        .res_opcode(result_opcode),
+        .res_cycles(result_cycles),
+        
+        .out_data(npu_to_pcie_data),
+        .out_valid(npu_to_pcie_valid),
+        .out_ready(npu_to_pcie_ready),
+        
+        .cq_enable(cq_enable),
+        .cq_base(cq_base),
+        .cq_entries(cq_entries),
+        .cq_head(cq_head),
+        .cq_tail(cq_tail),
+        .cq_seq(cq_seq),
+        
+        .hw_addr(cq_wr_addr),
+        .hw_data(cq_wr_data),
+        .hw_valid(cq_wr_valid),
+        .hw_ready(cq_wr_ready),
+        
+        .cq_irq(cq_irq)
     );
     
     // PCIe Interface Controller
@@ -96,9 +182,11 @@ module npu_top #(
         
         // PCIe Physical Interface
         .pcie_rx_data(pcie_rx_data),
+        .pcie_rx_keep(pcie_rx_keep),
         .pcie_rx_valid(pcie_rx_valid),
         .pcie_rx_ready(pcie_rx_ready),
         .pcie_tx_data(pcie_tx_data),
+        .pcie_tx_keep(pcie_tx_keep),
         .pcie_tx_valid(pcie_tx_valid),
         .pcie_tx_ready(pcie_tx_ready),
         
@@ -114,13 +202,5 @@ module npu_top #(
         // Status
         .status(status_leds[7:4])
     );
-    
-    // Memory Controller (simplified interface)
-    assign mem_addr = npu_mem_addr;
-    assign mem_wdata = npu_mem_wdata;
-    assign npu_mem_rdata = mem_rdata;
-    assign mem_we = npu_mem_we;
-    assign mem_re = npu_mem_re;
-    assign npu_mem_valid = mem_valid;
 
-endmodule
\ No newline at end of file
+endmodule
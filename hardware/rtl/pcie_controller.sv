@@ -3,12 +3,19 @@
  * 
  * Handles PCIe communication protocol and data transfer
  * between host system and NPU core.
+ *
+ * Each beat carries PCIE_DATA_WIDTH/DATA_WIDTH words, least significant
+ * first, with a keep bit per word. RX words whose keep bit is clear are
+ * dropped, so a short instruction stream can end mid-beat. TX packs result
+ * words into beats and sends a partial beat once the TX FIFO has been
+ * empty for TX_FLUSH_CYCLES; pcie_tx_keep marks the words that carry data.
  */
 
 module pcie_controller #(
     parameter DATA_WIDTH = 32,
     parameter PCIE_DATA_WIDTH = 128,
-    parameter FIFO_DEPTH = 512
+    parameter FIFO_DEPTH = 512,
+    parameter TX_FLUSH_CYCLES = 32
 ) (
     input  wire clk,
     input  wire rst_n,
@@ -17,10 +24,12 @@ module pcie_controller #(
     
     // PCIe Physical Interface
     input  wire [PCIE_DATA_WIDTH-1:0] pcie_rx_data,
+    input  wire [PCIE_DATA_WIDTH/DATA_WIDTH-1:0] pcie_rx_keep,
     input  wire pcie_rx_valid,
     output wire pcie_rx_ready,
     
     output wire [PCIE_DATA_WIDTH-1:0] pcie_tx_data,
+    output wire [PCIE_DATA_WIDTH/DATA_WIDTH-1:0] pcie_tx_keep,
     output wire pcie_tx_valid,
     input  wire pcie_tx_ready,
     
@@ -37,6 +46,9 @@ module pcie_controller #(
     output wire [3:0] status
 );
 
+    localparam WORDS_PER_BEAT = PCIE_DATA_WIDTH / DATA_WIDTH;
+    localparam WORD_BITS = (WORDS_PER_BEAT > 1) ? $clog2(WORDS_PER_BEAT) : 1;
+
     // Clock domain crossing FIFOs
     wire [DATA_WIDTH-1:0] rx_fifo_din, rx_fifo_dout;
     wire rx_fifo_wr_en, rx_fifo_rd_en;
@@ -82,42 +94,80 @@ module pcie_controller #(
         .rd_empty(tx_fifo_empty)
     );
     
-    // PCIe RX data processing
-    reg [1:0] rx_word_count;
+    // PCIe RX data processing: hold one beat and unpack it word by word
+    reg [WORD_BITS-1:0] rx_word_count;
     reg [PCIE_DATA_WIDTH-1:0] rx_data_reg;
+    reg [WORDS_PER_BEAT-1:0] rx_keep_reg;
+    reg rx_beat_valid;
+    
+    wire rx_word_kept = rx_keep_reg[rx_word_count];
+    wire rx_word_done = rx_beat_valid && (!rx_word_kept || !rx_fifo_full);
     
     always_ff @(posedge pcie_clk or negedge pcie_rst_n) begin
         if (!pcie_rst_n) begin
-            rx_word_count <= 2'b00;
+            rx_word_count <= '0;
             rx_data_reg <= '0;
+            rx_keep_reg <= '0;
+            rx_beat_valid <= 1'b0;
         end else if (pcie_rx_valid && pcie_rx_ready) begin
             rx_data_reg <= pcie_rx_data;
-            rx_word_count <= rx_word_count + 1;
+            rx_keep_reg <= pcie_rx_keep;
+            rx_word_count <= '0;
+            rx_beat_valid <= 1'b1;
+        end else if (rx_word_done) begin
+            rx_word_count <= rx_word_count + 1'b1;
+            if (rx_word_count == WORDS_PER_BEAT - 1) begin
+                rx_beat_valid <= 1'b0;
+            end
         end
     end
     
     // Extract 32-bit words from 128-bit PCIe data
     assign rx_fifo_din = rx_data_reg[DATA_WIDTH*rx_word_count +: DATA_WIDTH];
-    assign rx_fifo_wr_en = pcie_rx_valid && !rx_fifo_full;
-    assign pcie_rx_ready = !rx_fifo_full;
+    assign rx_fifo_wr_en = rx_beat_valid && rx_word_kept && !rx_fifo_full;
+    assign pcie_rx_ready = !rx_beat_valid;
     
-    // PCIe TX data processing
-    reg [1:0] tx_word_count;
+    // PCIe TX data processing: pack words into a beat, flush partial beats
+    reg [WORD_BITS-1:0] tx_word_count;
     reg [PCIE_DATA_WIDTH-1:0] tx_data_reg;
+    reg [WORDS_PER_BEAT-1:0] tx_keep_reg;
+    reg tx_beat_valid;
+    reg [$clog2(TX_FLUSH_CYCLES+1)-1:0] tx_idle;
+    
+    wire tx_partial = (tx_keep_reg != '0);
+    wire tx_flush = !tx_beat_valid && tx_partial && tx_fifo_empty && (tx_idle == TX_FLUSH_CYCLES);
     
     always_ff @(posedge pcie_clk or negedge pcie_rst_n) begin
         if (!pcie_rst_n) begin
-            tx_word_count <= 2'b00;
+            tx_word_count <= '0;
+            tx_data_reg <= '0;
+            tx_keep_reg <= '0;
+            tx_beat_valid <= 1'b0;
+            tx_idle <= '0;
+        end else if (pcie_tx_valid && pcie_tx_ready) begin
             tx_data_reg <= '0;
+            tx_keep_reg <= '0;
+            tx_beat_valid <= 1'b0;
         end else if (tx_fifo_rd_en) begin
             tx_data_reg[DATA_WIDTH*tx_word_count +: DATA_WIDTH] <= tx_fifo_dout;
-            tx_word_count <= tx_word_count + 1;
+            tx_keep_reg[tx_word_count] <= 1'b1;
+            tx_word_count <= tx_word_count + 1'b1;
+            tx_idle <= '0;
+            if (tx_word_count == WORDS_PER_BEAT - 1) begin
+                tx_beat_valid <= 1'b1;
+            end
+        end else if (tx_flush) begin
+            tx_word_count <= '0;
+            tx_beat_valid <= 1'b1;
+        end else if (tx_partial && !tx_beat_valid) begin
+            tx_idle <= tx_idle + 1'b1;
         end
     end
     
     assign pcie_tx_data = tx_data_reg;
-    assign pcie_tx_valid = (tx_word_count == 2'b11) && !tx_fifo_empty;
-    assign tx_fifo_rd_en = pcie_tx_ready && !tx_fifo_empty;
+    assign pcie_tx_keep = tx_keep_reg;
+    assign pcie_tx_valid = tx_beat_valid;
+    assign tx_fifo_rd_en = !tx_beat_valid && !tx_fifo_empty;
     
     // NPU interface connections
     assign npu_data_out = rx_fifo_dout;
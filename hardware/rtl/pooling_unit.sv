@@ -0,0 +1,62 @@
+/**
+ * Pooling Unit Module
+ *
+ * Reduction datapath for max, average and global average pooling. The
+ * convolution engine feeds it window taps (or, for global pooling, every
+ * pixel of a plane) from its line buffers; in_first starts a new window.
+ * Averages multiply the running sum by a precomputed reciprocal
+ * recip = round(2^31 / count) instead of dividing, with round-half-up.
+ * The sum is kept with 16 guard bits so a full plane cannot overflow.
+ */
+
+module pooling_unit #(
+    parameter DATA_WIDTH = 32
+) (
+    input  wire clk,
+    input  wire rst_n,
+
+    // Mode and averaging reciprocal (Q1.31)
+    input  wire [1:0] mode,
+    input  wire [31:0] recip,
+
+    // Window taps
+    input  wire [DATA_WIDTH-1:0] in_data,
+    input  wire in_valid,
+    input  wire in_first,
+
+    // Reduced window, valid the cycle after the last tap
+    output wire [DATA_WIDTH-1:0] out_data
+);
+
+    // Pooling modes (params[3] of NPU_OP_POOLING)
+    localparam POOL_MAX        = 2'h0;
+    localparam POOL_AVG        = 2'h1;
+    localparam POOL_GLOBAL_AVG = 2'h2;
+
+    localparam ACC_WIDTH = DATA_WIDTH + 16;
+    localparam RECIP_FRAC = 31;
+
+    reg signed [ACC_WIDTH-1:0] acc;
+
+    wire signed [ACC_WIDTH-1:0] in_ext = $signed(in_data);
+    wire signed [ACC_WIDTH+32:0] scaled = acc * $signed({1'b0, recip});
+    wire signed [ACC_WIDTH+32:0] rounded = scaled + (33'sd1 <<< (RECIP_FRAC - 1));
+    wire signed [ACC_WIDTH+32:0] average = rounded >>> RECIP_FRAC;
+
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            acc <= '0;
+        end else if (in_valid) begin
+            if (in_first) begin
+                acc <= in_ext;
+            end else if (mode == POOL_MAX) begin
+                acc <= (in_ext > acc) ? in_ext : acc;
+            end else begin
+                acc <= acc + in_ext;
+            end
+        end
+    end
+
+    assign out_data = (mode == POOL_MAX) ? acc[DATA_WIDTH-1:0] : average[DATA_WIDTH-1:0];
+
+endmodule
@@ -1,23 +1,64 @@
 /**
  * Processing Element (PE) Module
- * 
+ *
  * Individual processing element for parallel computation.
  * Supports basic arithmetic operations: ADD, SUB, MUL, MAC
+ *
+ * Operands can be interpreted as one INT32 value, two packed INT16 lanes
+ * or four packed INT8 lanes (SIMD within a register). ADD/SUB/MUL work
+ * lane-wise; MAC sums all lane products into the 32-bit accumulator, so
+ * an INT8 MAC retires four multiply-accumulates per cycle and an INT16
+ * MAC retires two.
+ *
+ * MAC_LATENCY selects the pipeline depth so the datapath maps onto the
+ * DSP48 register stages:
+ *   1 - multiply and accumulate in one cycle (no internal registers)
+ *   2 - multiply register (MREG) + accumulate/output register (PREG)
+ *   3 - input registers (AREG/BREG) + MREG + PREG
+ * Accumulation only happens in the last stage, so back-to-back MACs
+ * still issue every cycle and results are bit-exact for every depth.
+ * valid follows enable by MAC_LATENCY cycles. acc_clear travels with the
+ * operands and makes that MAC start a fresh sum instead of adding to the
+ * accumulator, so streaming users can begin a new dot product without a
+ * bubble.
+ *
+ * With ZERO_SKIP set, lanes with a zero operand are detected before the
+ * input registers. A MAC whose lanes are all zero is skipped and the
+ * accumulator adds nothing. At MAC_LATENCY 3 the AREG/BREG and MREG clock
+ * enables stay low, so the multiplier inputs do not toggle. Without input
+ * registers (MAC_LATENCY 1 and 2) the operands are AND-isolated to zero
+ * in front of the multiplier instead, so a run of skipped MACs leaves it
+ * idle after the first; at MAC_LATENCY 2 MREG also holds. zero_lanes and
+ * skipped follow valid so the PMU can count effective against nominal
+ * MACs and multiplier cycles gated.
  */
 
 module processing_element #(
-    parameter DATA_WIDTH = 32
+    parameter DATA_WIDTH = 32,
+    parameter MAC_LATENCY = 1,
+    parameter ZERO_SKIP = 1
 ) (
     input  wire clk,
     input  wire rst_n,
     input  wire enable,
-    
+
     input  wire [DATA_WIDTH-1:0] op_a,
     input  wire [DATA_WIDTH-1:0] op_b,
     input  wire [3:0] operation,
-    
+    input  wire acc_clear,          // MAC starts from zero instead of the accumulator
+
+    // Numeric mode
+    input  wire [1:0] precision,    // PREC_INT32, PREC_INT16 or PREC_INT8
+    input  wire saturate,           // Clamp to lane range instead of wrapping
+    input  wire [1:0] round_mode,   // Rounding used by the output shift
+    input  wire [4:0] shift_amt,    // Right shift on MUL lanes and MAC output
+
     output reg  [DATA_WIDTH-1:0] result,
-    output reg  valid
+    output reg  valid,
+
+    // Zero-operand statistics, valid with valid
+    output reg  [$clog2(DATA_WIDTH/8+1)-1:0] zero_lanes,  // MAC lanes with a zero operand
+    output reg  skipped                                   // Whole MAC skipped, multiplier gated
 );
 
     // Operation codes
@@ -25,30 +66,310 @@ module processing_element #(
     localparam OP_SUB = 4'h2;
     localparam OP_MUL = 4'h3;
     localparam OP_MAC = 4'h4;
-    
+
+    // Precision modes
+    localparam PREC_INT32 = 2'h0;
+    localparam PREC_INT16 = 2'h1;
+    localparam PREC_INT8  = 2'h2;
+
+    // Rounding modes
+    localparam RND_TRUNC     = 2'h0;  // Floor (plain arithmetic shift)
+    localparam RND_HALF_UP   = 2'h1;  // Round half towards +infinity
+    localparam RND_HALF_EVEN = 2'h2;  // Round half to even (convergent)
+    localparam RND_ZERO      = 2'h3;  // Round towards zero
+
+    localparam WIDE = 2 * DATA_WIDTH;
+    localparam MAX_LANES = DATA_WIDTH / 8;
+    localparam CNT_WIDTH = $clog2(MAX_LANES + 1);
+
     // Internal accumulator for MAC operations
     reg [DATA_WIDTH-1:0] accumulator;
-    
+
+    // Sign-extended value of one packed lane
+    function automatic logic signed [WIDE-1:0] lane_value(
+        input logic [DATA_WIDTH-1:0] word,
+        input int lane,
+        input int width
+    );
+        logic [DATA_WIDTH-1:0] aligned;
+        aligned = word << (DATA_WIDTH - (lane + 1) * width);
+        return $signed(aligned) >>> (DATA_WIDTH - width);
+    endfunction
+
+    // Arithmetic right shift with the selected rounding
+    function automatic logic signed [WIDE-1:0] round_shift(
+        input logic signed [WIDE-1:0] value,
+        input logic [4:0] shift,
+        input logic [1:0] mode
+    );
+        logic signed [WIDE-1:0] shifted;
+        logic [WIDE-1:0] one, half, remainder;
+        if (shift == 0) begin
+            return value;
+        end
+        one = 1;
+        shifted = value >>> shift;
+        half = one << (shift - 1);
+        remainder = value & ((one << shift) - 1);
+        case (mode)
+            RND_HALF_UP: begin
+                return (remainder >= half) ? shifted + 1 : shifted;
+            end
+            RND_HALF_EVEN: begin
+                return (remainder > half || (remainder == half && shifted[0])) ? shifted + 1 : shifted;
+            end
+            RND_ZERO: begin
+                return (value < 0 && remainder != 0) ? shifted + 1 : shifted;
+            end
+            default: begin
+                return shifted;
+            end
+        endcase
+    endfunction
+
+    // Wrap or saturate a value to a lane and place it at its lane position
+    function automatic logic [DATA_WIDTH-1:0] pack_lane(
+        input logic signed [WIDE-1:0] value,
+        input int lane,
+        input int width,
+        input logic sat
+    );
+        logic signed [WIDE-1:0] one, max_val, min_val, clamped;
+        logic [DATA_WIDTH:0] mask;
+        one = 1;
+        max_val = (one <<< (width - 1)) - 1;
+        min_val = -(one <<< (width - 1));
+        clamped = value;
+        if (sat && value > max_val) begin
+            clamped = max_val;
+        end else if (sat && value < min_val) begin
+            clamped = min_val;
+        end
+        mask = ({{DATA_WIDTH{1'b0}}, 1'b1} << width) - 1;
+        return (clamped[DATA_WIDTH-1:0] & mask[DATA_WIDTH-1:0]) << (lane * width);
+    endfunction
+
+    initial begin
+        if (MAC_LATENCY < 1 || MAC_LATENCY > 3) begin
+            $error("processing_element: MAC_LATENCY must be 1, 2 or 3 (got %0d)", MAC_LATENCY);
+        end
+    end
+
+    // Zero-operand detection on the raw operands, ahead of AREG/BREG
+    logic [CNT_WIDTH-1:0] in_zero_lanes;
+    logic in_skip;
+
+    always_comb begin
+        int width, lanes;
+
+        case (precision)
+            PREC_INT16: width = 16;
+            PREC_INT8:  width = 8;
+            default:    width = DATA_WIDTH;
+        endcase
+        lanes = DATA_WIDTH / width;
+
+        in_zero_lanes = '0;
+        for (int l = 0; l < MAX_LANES; l++) begin
+            if (l < lanes && (lane_value(op_a, l, width) == 0 || lane_value(op_b, l, width) == 0)) begin
+                in_zero_lanes = in_zero_lanes + 1'b1;
+            end
+        end
+        in_skip = ZERO_SKIP && (operation == OP_MAC) && (in_zero_lanes == lanes);
+        if (operation != OP_MAC) begin
+            in_zero_lanes = '0;
+        end
+    end
+
+    // Stage 0: optional input registers (AREG/BREG)
+    logic s0_en;
+    logic [DATA_WIDTH-1:0] s0_a, s0_b;
+    logic [3:0] s0_op;
+    logic s0_clr;
+    logic [1:0] s0_prec;
+    logic s0_sat;
+    logic [1:0] s0_rnd;
+    logic [4:0] s0_shift;
+    logic [CNT_WIDTH-1:0] s0_zero;
+    logic s0_skip;
+
+    generate
+        if (MAC_LATENCY >= 3) begin : g_input_reg
+            always_ff @(posedge clk or negedge rst_n) begin
+                if (!rst_n) begin
+                    s0_en <= 1'b0;
+                    s0_a <= '0;
+                    s0_b <= '0;
+                    s0_op <= '0;
+                    s0_clr <= 1'b0;
+                    s0_prec <= '0;
+                    s0_sat <= 1'b0;
+                    s0_rnd <= '0;
+                    s0_shift <= '0;
+                    s0_zero <= '0;
+                    s0_skip <= 1'b0;
+                end else begin
+                    s0_en <= enable;
+                    // Operand registers hold on a skipped MAC
+                    if (enable && !in_skip) begin
+                        s0_a <= op_a;
+                        s0_b <= op_b;
+                    end
+                    if (enable) begin
+                        s0_op <= operation;
+                        s0_clr <= acc_clear;
+                        s0_prec <= precision;
+                        s0_sat <= saturate;
+                        s0_rnd <= round_mode;
+                        s0_shift <= shift_amt;
+                        s0_zero <= in_zero_lanes;
+                        s0_skip <= in_skip;
+                    end
+                end
+            end
+        end else begin : g_input_comb
+            always_comb begin
+                s0_en = enable;
+                // Operand isolation: a skipped MAC presents zeros to the multiplier
+                s0_a = in_skip ? '0 : op_a;
+                s0_b = in_skip ? '0 : op_b;
+                s0_op = operation;
+                s0_clr = acc_clear;
+                s0_prec = precision;
+                s0_sat = saturate;
+                s0_rnd = round_mode;
+                s0_shift = shift_amt;
+                s0_zero = in_zero_lanes;
+                s0_skip = in_skip;
+            end
+        end
+    endgenerate
+
+    // Stage 1: lane-wise multiply/ALU datapath
+    logic [DATA_WIDTH-1:0] lane_result;
+    logic signed [WIDE-1:0] product_sum;
+
+    always_comb begin
+        int width;
+        logic signed [WIDE-1:0] a_l, b_l, lane_out;
+
+        case (s0_prec)
+            PREC_INT16: width = 16;
+            PREC_INT8:  width = 8;
+            default:    width = DATA_WIDTH;
+        endcase
+
+        lane_result = '0;
+        product_sum = '0;
+        for (int l = 0; l < MAX_LANES; l++) begin
+            if (l < DATA_WIDTH / width) begin
+                a_l = lane_value(s0_a, l, width);
+                b_l = lane_value(s0_b, l, width);
+                case (s0_op)
+                    OP_ADD:  lane_out = a_l + b_l;
+                    OP_SUB:  lane_out = a_l - b_l;
+                    default: lane_out = round_shift(a_l * b_l, s0_shift, s0_rnd);
+                endcase
+                lane_result = lane_result | pack_lane(lane_out, l, width, s0_sat);
+                product_sum = product_sum + a_l * b_l;
+            end
+        end
+    end
+
+    // Multiply register (MREG)
+    logic s1_en;
+    logic [DATA_WIDTH-1:0] s1_lane_result;
+    logic signed [WIDE-1:0] s1_product_sum;
+    logic [3:0] s1_op;
+    logic s1_clr;
+    logic s1_sat;
+    logic [1:0] s1_rnd;
+    logic [4:0] s1_shift;
+    logic [CNT_WIDTH-1:0] s1_zero;
+    logic s1_skip;
+
+    generate
+        if (MAC_LATENCY >= 2) begin : g_mult_reg
+            always_ff @(posedge clk or negedge rst_n) begin
+                if (!rst_n) begin
+                    s1_en <= 1'b0;
+                    s1_lane_result <= '0;
+                    s1_product_sum <= '0;
+                    s1_op <= '0;
+                    s1_clr <= 1'b0;
+                    s1_sat <= 1'b0;
+                    s1_rnd <= '0;
+                    s1_shift <= '0;
+                    s1_zero <= '0;
+                    s1_skip <= 1'b0;
+                end else begin
+                    s1_en <= s0_en;
+                    // Product register holds on a skipped MAC
+                    if (s0_en && !s0_skip) begin
+                        s1_lane_result <= lane_result;
+                        s1_product_sum <= product_sum;
+                    end
+                    if (s0_en) begin
+                        s1_op <= s0_op;
+                        s1_clr <= s0_clr;
+                        s1_sat <= s0_sat;
+                        s1_rnd <= s0_rnd;
+                        s1_shift <= s0_shift;
+                        s1_zero <= s0_zero;
+                        s1_skip <= s0_skip;
+                    end
+                end
+            end
+        end else begin : g_mult_comb
+            always_comb begin
+                s1_en = s0_en;
+                s1_lane_result = lane_result;
+                s1_product_sum = product_sum;
+                s1_op = s0_op;
+                s1_clr = s0_clr;
+                s1_sat = s0_sat;
+                s1_rnd = s0_rnd;
+                s1_shift = s0_shift;
+                s1_zero = s0_zero;
+                s1_skip = s0_skip;
+            end
+        end
+    endgenerate
+
+    // Stage 2: accumulate and output register (PREG)
+    logic [DATA_WIDTH-1:0] acc_base;
+    logic [DATA_WIDTH-1:0] acc_next;
+    logic [DATA_WIDTH-1:0] mac_result;
+    logic signed [WIDE-1:0] s1_addend;
+
+    always_comb begin
+        // A signed zero keeps the add signed; an unbased '0 would not
+        s1_addend = s1_skip ? $signed({WIDE{1'b0}}) : s1_product_sum;
+        acc_base = s1_clr ? '0 : accumulator;
+        acc_next = pack_lane($signed(acc_base) + s1_addend,
+                             0, DATA_WIDTH, s1_sat);
+        mac_result = pack_lane(round_shift($signed(acc_next), s1_shift, s1_rnd),
+                               0, DATA_WIDTH, s1_sat);
+    end
+
     always_ff @(posedge clk or negedge rst_n) begin
         if (!rst_n) begin
             result <= '0;
             valid <= 1'b0;
             accumulator <= '0;
-        end else if (enable) begin
+            zero_lanes <= '0;
+            skipped <= 1'b0;
+        end else if (s1_en) begin
             valid <= 1'b1;
-            case (operation)
-                OP_ADD: begin
-                    result <= op_a + op_b;
-                end
-                OP_SUB: begin
-                    result <= op_a - op_b;
-                end
-                OP_MUL: begin
-                    result <= op_a * op_b;
+            zero_lanes <= s1_zero;
+            skipped <= s1_skip;
+            case (s1_op)
+                OP_ADD, OP_SUB, OP_MUL: begin
+                    result <= s1_lane_result;
                 end
                 OP_MAC: begin
-                    accumulator <= accumulator + (op_a * op_b);
-                    result <= accumulator + (op_a * op_b);
+                    accumulator <= acc_next;
+                    result <= mac_result;
                 end
                 default: begin
                     result <= '0;
@@ -57,7 +378,9 @@ module processing_element #(
             endcase
         end else begin
             valid <= 1'b0;
+            zero_lanes <= '0;
+            skipped <= 1'b0;
         end
     end
 
-endmodule
\ No newline at end of file
+endmodule
@@ -0,0 +1,233 @@
+/**
+ * Work Distributor Module
+ *
+ * Feeds CORE_COUNT npu_core instances from the single host instruction
+ * stream. The PCIe RX FIFO is the shared work queue: at each instruction
+ * boundary the distributor pops the head and hands the whole instruction
+ * (one word, or nine for CONV/MATMUL/POOLING descriptors) to one core.
+ *
+ * A ROUTE prefix word (base opcode 5'h1F) pins the next instruction to the
+ * core in its src1 byte; without one, or with src1 = 8'hFF, the instruction
+ * goes to the next idle core in round-robin order. The prefix's low 16 bits
+ * carry the PE partition mask the instruction may use (0: all PEs); it is
+ * presented to the cores alongside the instruction word. Results from all cores
+ * are merged round-robin onto the host output stream in completion order,
+ * tagged with the core, opcode and issue-to-result cycles of the instruction
+ * that produced them (for the completion writer). Per-core instruction and
+ * busy-cycle counters are kept for the register block.
+ */
+
+module work_distributor #(
+    parameter DATA_WIDTH = 32,
+    parameter CORE_COUNT = 4
+) (
+    input  wire clk,
+    input  wire rst_n,
+
+    // Shared instruction queue (host to NPU)
+    input  wire [DATA_WIDTH-1:0] in_data,
+    input  wire in_valid,
+    output wire in_ready,
+
+    // Per-core instruction streams (data is broadcast, valid is one-hot)
+    output wire [DATA_WIDTH-1:0] core_in_data,
+    output wire [15:0] core_in_pe_mask,
+    output wire [CORE_COUNT-1:0] core_in_valid,
+    input  wire [CORE_COUNT-1:0] core_in_ready,
+
+    // Per-core result streams
+    input  wire [CORE_COUNT*DATA_WIDTH-1:0] core_out_data,
+    input  wire [CORE_COUNT-1:0] core_out_valid,
+    output wire [CORE_COUNT-1:0] core_out_ready,
+
+    // Merged result stream (NPU to host)
+    output wire [DATA_WIDTH-1:0] out_data,
+    output wire out_valid,
+    input  wire out_ready,
+    output wire [7:0]  out_core,        // Core that produced out_data
+    output wire [7:0]  out_opcode,      // Opcode of the instruction behind out_data
+    output wire [31:0] out_cycles,      // Cycles from issue to out_data
+
+    // Per-core counters
+    input  wire perf_clear,
+    output wire [CORE_COUNT-1:0] core_busy,
+    output reg  [CORE_COUNT*32-1:0] core_inst_count,
+    output reg  [CORE_COUNT*32-1:0] core_busy_cycles
+);
+
+    localparam CORE_BITS = (CORE_COUNT > 1) ? $clog2(CORE_COUNT) : 1;
+
+    // Framing (must match npu_core.sv and encode_instruction())
+    localparam OP_CONV    = 5'h05;
+    localparam OP_MATMUL  = 5'h06;
+    localparam OP_POOLING = 5'h09;
+    localparam OP_ROUTE   = 5'h1F;
+    localparam DESC_WORDS = 8;
+    localparam CORE_ANY   = 8'hFF;
+
+    wire [4:0] head_opcode = in_data[28:24];
+    wire [7:0] head_core = in_data[23:16];
+    wire head_is_route = (head_opcode == OP_ROUTE);
+    wire head_has_desc = (head_opcode == OP_CONV) || (head_opcode == OP_MATMUL) ||
+                         (head_opcode == OP_POOLING);
+
+    // Instruction issue state
+    reg [3:0] words_left;           // Descriptor words still owed to cur_core
+    reg [CORE_BITS-1:0] cur_core;
+    reg [CORE_BITS-1:0] issue_rr;   // Next core to try when load-balancing
+    reg route_pinned;
+    reg [CORE_BITS-1:0] route_core;
+    reg [15:0] route_pe_mask;
+
+    // Per-core tags of the instruction in flight (one per core: a core does
+    // not accept the next instruction until its result has been taken)
+    reg [31:0] cycle_now;
+    reg [CORE_COUNT*32-1:0] core_issue_ts;
+    reg [CORE_COUNT*8-1:0] core_issue_op;
+
+    wire mid_inst = (words_left != 0);
+
+    // Pick the first idle core at or after issue_rr. Between instructions a
+    // core only accepts a new word from IDLE, so ready doubles as idle.
+    reg [CORE_BITS-1:0] idle_core;
+    reg idle_found;
+    integer k;
+
+    always_comb begin
+        idle_core = issue_rr;
+        idle_found = 1'b0;
+        for (k = 0; k < CORE_COUNT; k++) begin
+            if (!idle_found && core_in_ready[(issue_rr + k) % CORE_COUNT]) begin
+                idle_core = (issue_rr + k) % CORE_COUNT;
+                idle_found = 1'b1;
+            end
+        end
+    end
+
+    wire [CORE_BITS-1:0] sel_core = mid_inst ? cur_core :
+                                    route_pinned ? route_core : idle_core;
+    wire sel_ok = mid_inst || route_pinned || idle_found;
+    wire forward = in_valid && !(head_is_route && !mid_inst) && sel_ok;
+    wire issue = forward && core_in_ready[sel_core];
+
+    assign core_in_data = in_data;
+    assign core_in_pe_mask = route_pe_mask;
+    assign in_ready = (!mid_inst && head_is_route) || (sel_ok && core_in_ready[sel_core]);
+
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            words_left <= '0;
+            cur_core <= '0;
+            issue_rr <= '0;
+            route_pinned <= 1'b0;
+            route_core <= '0;
+            route_pe_mask <= 16'hFFFF;
+        end else if (in_valid && !mid_inst && head_is_route) begin
+            // Routing prefix: applies to the next instruction only
+            route_pinned <= (head_core != CORE_ANY) && (head_core < CORE_COUNT);
+            route_core <= head_core[CORE_BITS-1:0];
+            route_pe_mask <= (in_data[15:0] == 16'h0000) ? 16'hFFFF : in_data[15:0];
+        end else if (issue) begin
+            if (mid_inst) begin
+                words_left <= words_left - 1'b1;
+            end else begin
+                words_left <= head_has_desc ? DESC_WORDS : 0;
+                cur_core <= sel_core;
+                route_pinned <= 1'b0;
+                route_pe_mask <= 16'hFFFF;
+                if (!route_pinned) begin
+                    issue_rr <= (sel_core == CORE_COUNT - 1) ? '0 : sel_core + 1'b1;
+                end
+            end
+        end
+    end
+
+    // Result merge: round-robin over cores with a result pending, holding the
+    // choice while the host side stalls so out_data stays stable.
+    reg [CORE_BITS-1:0] res_rr;
+    reg [CORE_BITS-1:0] res_core;
+    reg res_found;
+    reg res_locked;
+    reg [CORE_BITS-1:0] res_lock_core;
+
+    always_comb begin
+        res_core = res_rr;
+        res_found = 1'b0;
+        for (k = 0; k < CORE_COUNT; k++) begin
+            if (!res_found && core_out_valid[(res_rr + k) % CORE_COUNT]) begin
+                res_core = (res_rr + k) % CORE_COUNT;
+                res_found = 1'b1;
+            end
+        end
+        if (res_locked) begin
+            res_core = res_lock_core;
+            res_found = 1'b1;
+        end
+    end
+
+    assign out_valid = res_found;
+    assign out_data = core_out_data[res_core*DATA_WIDTH +: DATA_WIDTH];
+    assign out_core = {{(8-CORE_BITS){1'b0}}, res_core};
+    assign out_opcode = core_issue_op[res_core*8 +: 8];
+    assign out_cycles = cycle_now - core_issue_ts[res_core*32 +: 32];
+
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            cycle_now <= '0;
+        end else begin
+            cycle_now <= cycle_now + 1'b1;
+        end
+    end
+
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            res_rr <= '0;
+            res_locked <= 1'b0;
+            res_lock_core <= '0;
+        end else if (res_found) begin
+            res_locked <= !out_ready;
+            res_lock_core <= res_core;
+            if (out_ready) begin
+                res_rr <= (res_core == CORE_COUNT - 1) ? '0 : res_core + 1'b1;
+            end
+        end
+    end
+
+    // Per-core handshakes, status and counters
+    genvar c;
+    generate
+        for (c = 0; c < CORE_COUNT; c++) begin : core_stats
+            assign core_in_valid[c] = forward && (sel_core == c);
+            assign core_out_ready[c] = res_found && out_ready && (res_core == c);
+            assign core_busy[c] = !core_in_ready[c] || (mid_inst && cur_core == c);
+
+            always_ff @(posedge clk or negedge rst_n) begin
+                if (!rst_n) begin
+                    core_issue_ts[c*32 +: 32] <= '0;
+                    core_issue_op[c*8 +: 8] <= '0;
+                end else if (issue && !mid_inst && sel_core == c) begin
+                    core_issue_ts[c*32 +: 32] <= cycle_now;
+                    core_issue_op[c*8 +: 8] <= in_data[31:24];
+                end
+            end
+
+            always_ff @(posedge clk or negedge rst_n) begin
+                if (!rst_n) begin
+                    core_inst_count[c*32 +: 32] <= '0;
+                    core_busy_cycles[c*32 +: 32] <= '0;
+                end else if (perf_clear) begin
+                    core_inst_count[c*32 +: 32] <= '0;
+                    core_busy_cycles[c*32 +: 32] <= '0;
+                end else begin
+                    if (issue && !mid_inst && sel_core == c) begin
+                        core_inst_count[c*32 +: 32] <= core_inst_count[c*32 +: 32] + 1'b1;
+                    end
+                    if (core_busy[c]) begin
+                        core_busy_cycles[c*32 +: 32] <= core_busy_cycles[c*32 +: 32] + 1'b1;
+                    end
+                end
+            end
+        end
+    endgenerate
+
+endmodule
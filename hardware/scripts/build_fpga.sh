@@ -132,6 +132,13 @@ case $BOARD in
         ;;
 esac
 
+# Load board configuration
+NPU_CORE_COUNT=1
+BOARD_CONFIG="$PROJECT_ROOT/configs/${BOARD}_config.sh"
+if [ -f "$BOARD_CONFIG" ]; then
+    source "$BOARD_CONFIG"
+fi
+
 # Validate build type
 case $BUILD_TYPE in
     Debug|Release)
@@ -193,6 +200,7 @@ add_files -fileset constrs_1 [glob "$PROJECT_ROOT/constraints/*.xdc"]
 
 # Set top module
 set_property top npu_top [current_fileset]
+set_property generic "CORE_COUNT=$NPU_CORE_COUNT" [current_fileset]
 
 # Set synthesis options based on build type
 if {"$BUILD_TYPE" == "Debug"} {
@@ -0,0 +1,102 @@
+#!/bin/bash
+#
+# PE Pipeline Synthesis Statistics
+# Synthesizes processing_element with Yosys for each MAC_LATENCY and
+# reports the longest combinational path and cell usage, so the effect
+# of the DSP pipeline registers can be compared without a Vivado run.
+#
+
+set -e  # Exit on any error
+
+# Script directory and project paths
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+PROJECT_ROOT="$(cd "$SCRIPT_DIR/.." && pwd)"
+RTL_FILE="$PROJECT_ROOT/rtl/processing_element.sv"
+REPORT_DIR="$PROJECT_ROOT/build/pe_stats"
+
+# Default configuration
+LATENCIES="1 2 3"
+DATA_WIDTH=32
+
+# Colors for output
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m'
+
+log_info() {
+    echo -e "${BLUE}[INFO]${NC} $1"
+}
+
+log_success() {
+    echo -e "${GREEN}[SUCCESS]${NC} $1"
+}
+
+log_error() {
+    echo -e "${RED}[ERROR]${NC} $1"
+}
+
+usage() {
+    cat << USAGE
+Usage: $0 [OPTIONS]
+
+Options:
+  -l, --latencies "L..."  MAC_LATENCY values to synthesize (default: "1 2 3")
+  -w, --width N           PE DATA_WIDTH (default: 32)
+  -h, --help              Show this help message
+USAGE
+}
+
+while [[ $# -gt 0 ]]; do
+    case $1 in
+        -l|--latencies)
+            LATENCIES="$2"
+            shift 2
+            ;;
+        -w|--width)
+            DATA_WIDTH="$2"
+            shift 2
+            ;;
+        -h|--help)
+            usage
+            exit 0
+            ;;
+        *)
+            log_error "Unknown option: $1"
+            usage
+            exit 1
+            ;;
+    esac
+done
+
+if ! command -v yosys &> /dev/null; then
+    log_error "Yosys not found. Please install Yosys (with SystemVerilog support)."
+    exit 1
+fi
+
+mkdir -p "$REPORT_DIR"
+SUMMARY_FILE="$REPORT_DIR/summary.txt"
+
+printf "%-12s %-18s %-10s %-10s\n" "MAC_LATENCY" "Longest path (LUT)" "Cells" "Flip-flops" | tee "$SUMMARY_FILE"
+for latency in $LATENCIES; do
+    log_file="$REPORT_DIR/pe_latency_${latency}.log"
+
+    # ltp -noff reports the longest path through logic cells between
+    # registers/ports, which tracks the critical path of the MAC. DSP
+    # inference is disabled so the multiplier shows up in that path.
+    yosys -q -l "$log_file" -p "
+        read_verilog -sv $RTL_FILE;
+        chparam -set DATA_WIDTH $DATA_WIDTH -set MAC_LATENCY $latency processing_element;
+        synth_xilinx -top processing_element -flatten -nodsp;
+        ltp -noff;
+        stat;
+    " > /dev/null
+
+    path=$(grep -m1 "Longest topological path" "$log_file" | sed -E 's/.*length=([0-9]+).*/\1/')
+    cells=$(grep -m1 "Number of cells:" "$log_file" | awk '{print $4}')
+    ffs=$(grep -E "^\s+FD" "$log_file" | awk '{sum += $2} END {print sum + 0}')
+
+    printf "%-12s %-18s %-10s %-10s\n" "$latency" "${path:-n/a}" "${cells:-n/a}" "$ffs" | tee -a "$SUMMARY_FILE"
+done
+
+log_success "Reports written to $REPORT_DIR (table in $SUMMARY_FILE)"
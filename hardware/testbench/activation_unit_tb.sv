@@ -0,0 +1,291 @@
+/**
+ * Activation Unit Testbench
+ *
+ * Testbench for activation_unit.sv module
+ * Checks ReLU/leaky ReLU exactly, sigmoid/tanh against a real-valued
+ * reference within the PWL error bound, and one-element-per-cycle
+ * streaming throughput across all lanes
+ */
+
+`timescale 1ns / 1ps
+
+module activation_unit_tb();
+
+    // Parameters
+    parameter DATA_WIDTH = 32;
+    parameter LANES = 4;
+    parameter real PWL_TOLERANCE = 0.01;  // Max absolute error for sigmoid/tanh
+
+    // Function codes (must match DUT)
+    localparam ACT_NONE       = 3'h0;
+    localparam ACT_RELU       = 3'h1;
+    localparam ACT_LEAKY_RELU = 3'h2;
+    localparam ACT_SIGMOID    = 3'h3;
+    localparam ACT_TANH       = 3'h4;
+
+    localparam real Q16_ONE = 65536.0;
+    localparam LATENCY = 2;
+
+    // DUT signals
+    reg clk;
+    reg rst_n;
+    reg [2:0] func;
+    reg [15:0] alpha;
+    reg [LANES*DATA_WIDTH-1:0] in_data;
+    reg in_valid;
+    wire [LANES*DATA_WIDTH-1:0] out_data;
+    wire out_valid;
+
+    // Test variables
+    integer test_case;
+    integer error_count;
+    real max_error;
+
+    // DUT instantiation
+    activation_unit #(
+        .DATA_WIDTH(DATA_WIDTH),
+        .LANES(LANES)
+    ) dut (
+        .clk(clk),
+        .rst_n(rst_n),
+        .func(func),
+        .alpha(alpha),
+        .in_data(in_data),
+        .in_valid(in_valid),
+        .out_data(out_data),
+        .out_valid(out_valid)
+    );
+
+    // Clock generation
+    initial begin
+        clk = 0;
+        forever #5 clk = ~clk;  // 100MHz
+    end
+
+    // Reset generation
+    initial begin
+        rst_n = 0;
+        #50;
+        rst_n = 1;
+        #20;
+    end
+
+    // Test stimulus
+    initial begin
+        // Initialize signals
+        func = ACT_NONE;
+        alpha = 16'h0000;
+        in_data = 0;
+        in_valid = 0;
+        test_case = 0;
+        error_count = 0;
+
+        // Wait for reset release
+        wait(rst_n);
+        #100;
+
+        $display("Starting Activation Unit Testbench");
+
+        // Test Case 1: ReLU
+        test_case = 1;
+        $display("Test Case 1: ReLU");
+        test_relu();
+
+        // Test Case 2: Leaky ReLU
+        test_case = 2;
+        $display("Test Case 2: Leaky ReLU");
+        test_leaky_relu();
+
+        // Test Case 3: Sigmoid accuracy
+        test_case = 3;
+        $display("Test Case 3: Sigmoid Accuracy");
+        test_pwl_accuracy(ACT_SIGMOID, -10.0, 10.0);
+
+        // Test Case 4: Tanh accuracy
+        test_case = 4;
+        $display("Test Case 4: Tanh Accuracy");
+        test_pwl_accuracy(ACT_TANH, -6.0, 6.0);
+
+        // Test Case 5: Pass-through
+        test_case = 5;
+        $display("Test Case 5: Pass-through");
+        apply_and_check(ACT_NONE, 32'hDEADBEEF, 32'hDEADBEEF);
+
+        // Test Case 6: Streaming throughput
+        test_case = 6;
+        $display("Test Case 6: Streaming Throughput");
+        test_streaming();
+
+        if (error_count == 0) begin
+            $display("All tests completed successfully!");
+        end else begin
+            $display("Tests completed with %d errors", error_count);
+        end
+        $finish;
+    end
+
+    // Reference models
+    function automatic real q16_to_real(input [DATA_WIDTH-1:0] value);
+        return $itor($signed(value)) / Q16_ONE;
+    endfunction
+
+    function automatic [DATA_WIDTH-1:0] real_to_q16(input real value);
+        return $rtoi(value * Q16_ONE);
+    endfunction
+
+    function automatic real ref_activation(input [2:0] f, input real x);
+        case (f)
+            ACT_SIGMOID: return 1.0 / (1.0 + $exp(-x));
+            ACT_TANH:    return (($exp(x) - $exp(-x)) / ($exp(x) + $exp(-x)));
+            default:     return x;
+        endcase
+    endfunction
+
+    // Helper task: Push one vector (same value on every lane) and return lane 0
+    task apply(input [2:0] f, input [DATA_WIDTH-1:0] x, output [DATA_WIDTH-1:0] y);
+        begin
+            @(posedge clk);
+            #1;
+            func = f;
+            in_data = {LANES{x}};
+            in_valid = 1;
+
+            @(posedge clk);
+            #1;
+            in_valid = 0;
+            repeat (LATENCY - 1) @(posedge clk);
+            #1;
+
+            if (out_valid !== 1'b1) begin
+                $error("out_valid not asserted %0d cycles after input", LATENCY);
+                error_count = error_count + 1;
+            end
+            if (out_data !== {LANES{out_data[DATA_WIDTH-1:0]}}) begin
+                $error("Lanes disagree for input %h: %h", x, out_data);
+                error_count = error_count + 1;
+            end
+            y = out_data[DATA_WIDTH-1:0];
+        end
+    endtask
+
+    task apply_and_check(input [2:0] f, input [DATA_WIDTH-1:0] x, input [DATA_WIDTH-1:0] expected);
+        reg [DATA_WIDTH-1:0] y;
+        begin
+            apply(f, x, y);
+            if (y !== expected) begin
+                $error("func %0d, x=%h: expected %h, got %h", f, x, expected, y);
+                error_count = error_count + 1;
+            end else begin
+                $display("    ✓ func %0d: %h -> %h", f, x, y);
+            end
+        end
+    endtask
+
+    // Test ReLU
+    task test_relu();
+        begin
+            apply_and_check(ACT_RELU, 32'h0003_8000, 32'h0003_8000);   // 3.5
+            apply_and_check(ACT_RELU, 32'h0000_0000, 32'h0000_0000);   // 0
+            apply_and_check(ACT_RELU, 32'hFFFF_0000, 32'h0000_0000);   // -1
+            apply_and_check(ACT_RELU, 32'h8000_0000, 32'h0000_0000);   // most negative
+            apply_and_check(ACT_RELU, 32'h7FFF_FFFF, 32'h7FFF_FFFF);   // most positive
+            $display("  ✓ ReLU completed");
+        end
+    endtask
+
+    // Test leaky ReLU
+    task test_leaky_relu();
+        begin
+            alpha = 16'h2000;  // 0.125
+            apply_and_check(ACT_LEAKY_RELU, 32'h0002_0000, 32'h0002_0000);  // 2.0 -> 2.0
+            apply_and_check(ACT_LEAKY_RELU, 32'hFFF8_0000, 32'hFFFF_0000);  // -8.0 -> -1.0
+            apply_and_check(ACT_LEAKY_RELU, 32'hFFFF_0000, 32'hFFFF_E000);  // -1.0 -> -0.125
+
+            alpha = 16'h028F;  // ~0.01
+            apply_and_check(ACT_LEAKY_RELU, 32'hFF9C_0000, 32'hFFFF_0024);  // -100 -> ~-1.0
+            $display("  ✓ Leaky ReLU completed");
+        end
+    endtask
+
+    // Sweep the input range and check the PWL approximation error
+    task test_pwl_accuracy(input [2:0] f, input real lo, input real hi);
+        real x, err;
+        reg [DATA_WIDTH-1:0] y;
+        integer i, steps;
+        begin
+            max_error = 0.0;
+            steps = 400;
+            for (i = 0; i <= steps; i++) begin
+                x = lo + (hi - lo) * i / steps;
+                apply(f, real_to_q16(x), y);
+                err = q16_to_real(y) - ref_activation(f, q16_to_real(real_to_q16(x)));
+                if (err < 0.0) err = -err;
+                if (err > max_error) max_error = err;
+                if (err > PWL_TOLERANCE) begin
+                    $error("func %0d, x=%f: expected %f, got %f", f, x,
+                           ref_activation(f, x), q16_to_real(y));
+                    error_count = error_count + 1;
+                end
+            end
+            $display("  ✓ func %0d max abs error %f over [%0.1f, %0.1f]", f, max_error, lo, hi);
+        end
+    endtask
+
+    // Stream back-to-back vectors and check one result per cycle
+    task test_streaming();
+        integer i, sent, received, cycles;
+        reg [DATA_WIDTH-1:0] expected;
+        begin
+            sent = 0;
+            received = 0;
+            cycles = 0;
+            func = ACT_RELU;
+
+            fork
+                begin
+                    for (i = 0; i < 64; i++) begin
+                        @(posedge clk);
+                        #1;
+                        in_valid = 1;
+                        in_data = {LANES{(i[0] ? -i : i)}};
+                        sent = sent + 1;
+                    end
+                    @(posedge clk);
+                    #1;
+                    in_valid = 0;
+                end
+                begin
+                    while (received < 64) begin
+                        @(posedge clk);
+                        #1;
+                        cycles = cycles + 1;
+                        if (out_valid) begin
+                            expected = received[0] ? 0 : received;
+                            if (out_data !== {LANES{expected}}) begin
+                                $error("Stream element %0d: expected %h, got %h",
+                                       received, expected, out_data[DATA_WIDTH-1:0]);
+                                error_count = error_count + 1;
+                            end
+                            received = received + 1;
+                        end
+                    end
+                end
+            join
+
+            if (cycles > 64 + LATENCY) begin
+                $error("Streaming took %0d cycles for 64 vectors", cycles);
+                error_count = error_count + 1;
+            end
+            $display("  ✓ %0d elements in %0d cycles (%0d lanes/cycle)",
+                     received * LANES, cycles, LANES);
+        end
+    endtask
+
+    // Simulation timeout
+    initial begin
+        #500000;  // 500us timeout
+        $error("Simulation timeout!");
+        $finish;
+    end
+
+endmodule
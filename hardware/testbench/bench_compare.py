@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+
+"""
+FPGA NPU Project - RTL Benchmark Comparison
+Compares npu_bench_tb results against a stored baseline
+"""
+
+import argparse
+import csv
+import sys
+from pathlib import Path
+from typing import Dict, Tuple
+
+Results = Dict[Tuple[str, str], Tuple[float, str]]
+
+
+def load_results(path: Path) -> Results:
+    """Read scenario,metric,value,better rows into {(scenario, metric): (value, better)}"""
+    results: Results = {}
+    with open(path, newline='') as f:
+        for row in csv.DictReader(f):
+            results[(row['scenario'], row['metric'])] = (float(row['value']), row['better'])
+    return results
+
+
+def compare(current: Results, baseline: Results, threshold: float) -> int:
+    """Print the delta of every metric and return the number of regressions"""
+    regressions = 0
+
+    print(f"{'scenario':<16} {'metric':<22} {'baseline':>14} {'current':>14} {'delta':>9}")
+    for key in sorted(set(current) | set(baseline)):
+        scenario, metric = key
+        if key not in current or key not in baseline:
+            where = 'baseline' if key not in current else 'current'
+            print(f"{scenario:<16} {metric:<22} {'only in ' + where:>39}")
+            continue
+
+        value, better = current[key]
+        base, _ = baseline[key]
+        delta = (value - base) / abs(base) * 100.0 if base else 0.0
+
+        status = ''
+        if better == 'higher' and delta < -threshold:
+            status = '  REGRESSION'
+        elif better == 'lower' and delta > threshold:
+            status = '  REGRESSION'
+        regressions += bool(status)
+
+        print(f"{scenario:<16} {metric:<22} {base:>14.4f} {value:>14.4f} {delta:>+8.2f}%{status}")
+
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare NPU RTL benchmark results against a baseline")
+    parser.add_argument('current', type=Path, help='Results of this run (npu_bench_results.csv)')
+    parser.add_argument('baseline', type=Path, help='Stored baseline results')
+    parser.add_argument('--threshold', type=float, default=2.0,
+                        help='Allowed change in the worse direction, percent (default: 2.0)')
+    args = parser.parse_args()
+
+    if not args.baseline.exists():
+        print(f"No baseline at {args.baseline}; run 'make bench-baseline' to store one")
+        return 0
+
+    regressions = compare(load_results(args.current), load_results(args.baseline), args.threshold)
+    if regressions:
+        print(f"\n{regressions} metric(s) regressed by more than {args.threshold}%")
+        return 1
+
+    print(f"\nNo regressions beyond {args.threshold}%")
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,432 @@
+/**
+ * Completion Writer Testbench
+ *
+ * Testbench for completion_writer.sv
+ * Tests pass-through while disabled, record contents and ring placement,
+ * error reporting for rejected convolutions, back-pressure from a full
+ * ring and from the host write port, wrap-around, and re-arming
+ */
+
+`timescale 1ns / 1ps
+
+module completion_writer_tb();
+
+    // Parameters
+    parameter DATA_WIDTH = 32;
+    parameter HOST_ADDR_WIDTH = 64;
+    parameter MAX_SLOTS = 16;
+
+    localparam [63:0] CQ_BASE = 64'h0000_0001_0000_1000;
+
+    // Instruction opcodes (must match DUT)
+    localparam OP_ADD     = 8'h01;
+    localparam OP_CONV    = 8'h05;
+    localparam OP_POOLING = 8'h09;
+
+    // Status bits (must match DUT)
+    localparam STATUS_ERROR = 32'h0000_0004;
+    localparam STATUS_DONE  = 32'h0000_0008;
+
+    // DUT signals
+    reg clk;
+    reg rst_n;
+
+    reg [DATA_WIDTH-1:0] res_data;
+    reg res_valid;
+    wire res_ready;
+    reg [7:0] res_core;
+    reg [7:0] res_opcode;
+    reg [31:0] res_cycles;
+
+    wire [DATA_WIDTH-1:0] out_data;
+    wire out_valid;
+    reg out_ready;
+
+    reg cq_enable;
+    reg [HOST_ADDR_WIDTH-1:0] cq_base;
+    reg [15:0] cq_entries;
+    reg [15:0] cq_head;
+    wire [15:0] cq_tail;
+    wire [31:0] cq_seq;
+
+    wire [HOST_ADDR_WIDTH-1:0] hw_addr;
+    wire [127:0] hw_data;
+    wire hw_valid;
+    reg hw_ready;
+    wire cq_irq;
+
+    // Host memory model and monitors
+    reg [127:0] ring [MAX_SLOTS];
+    integer ring_writes;
+    integer bad_addr;
+    integer irq_count;
+    integer out_count;
+    reg [DATA_WIDTH-1:0] last_out;
+
+    // Test variables
+    integer test_case;
+    integer error_count;
+    integer i;
+
+    // DUT instantiation
+    completion_writer #(
+        .DATA_WIDTH(DATA_WIDTH),
+        .HOST_ADDR_WIDTH(HOST_ADDR_WIDTH)
+    ) dut (
+        .clk(clk),
+        .rst_n(rst_n),
+
+        .res_data(res_data),
+        .res_valid(res_valid),
+        .res_ready(res_ready),
+        .res_core(res_core),
+        .res_opcode(res_opcode),
+        .res_cycles(res_cycles),
+
+        .out_data(out_data),
+        .out_valid(out_valid),
+        .out_ready(out_ready),
+
+        .cq_enable(cq_enable),
+        .cq_base(cq_base),
+        .cq_entries(cq_entries),
+        .cq_head(cq_head),
+        .cq_tail(cq_tail),
+        .cq_seq(cq_seq),
+
+        .hw_addr(hw_addr),
+        .hw_data(hw_data),
+        .hw_valid(hw_valid),
+        .hw_ready(hw_ready),
+
+        .cq_irq(cq_irq)
+    );
+
+    // Clock generation
+    initial begin
+        clk = 0;
+        forever #5 clk = ~clk;  // 100MHz
+    end
+
+    // Reset generation
+    initial begin
+        rst_n = 0;
+        #100;
+        rst_n = 1;
+        #50;
+    end
+
+    // Host memory and stream monitors
+    always @(posedge clk) begin
+        if (hw_valid && hw_ready) begin
+            if (hw_addr < cq_base || hw_addr >= cq_base + 16 * cq_entries || hw_addr[3:0] != 0) begin
+                bad_addr = bad_addr + 1;
+            end else begin
+                ring[(hw_addr - cq_base) >> 4] = hw_data;
+            end
+            ring_writes = ring_writes + 1;
+        end
+        if (cq_irq) begin
+            irq_count = irq_count + 1;
+        end
+        if (out_valid && out_ready) begin
+            last_out = out_data;
+            out_count = out_count + 1;
+        end
+    end
+
+    // Test stimulus
+    initial begin
+        // Initialize signals
+        res_data = 0;
+        res_valid = 0;
+        res_core = 0;
+        res_opcode = 0;
+        res_cycles = 0;
+        out_ready = 1;
+        cq_enable = 0;
+        cq_base = CQ_BASE;
+        cq_entries = 8;
+        cq_head = 0;
+        hw_ready = 1;
+        ring_writes = 0;
+        bad_addr = 0;
+        irq_count = 0;
+        out_count = 0;
+        test_case = 0;
+        error_count = 0;
+        clear_ring();
+
+        // Wait for reset release
+        wait(rst_n);
+        #100;
+
+        $display("Starting Completion Writer Testbench");
+
+        // Test Case 1: disabled queue is a pass-through
+        test_case = 1;
+        $display("Test Case 1: Pass-Through While Disabled");
+        test_passthrough();
+
+        // Test Case 2: record contents and ring placement
+        test_case = 2;
+        $display("Test Case 2: Completion Records");
+        test_records();
+
+        // Test Case 3: rejected convolution reported in the record
+        test_case = 3;
+        $display("Test Case 3: Error Reporting");
+        test_errors();
+
+        // Test Case 4: full ring and host write port stall the results
+        test_case = 4;
+        $display("Test Case 4: Back-Pressure and Wrap-Around");
+        test_backpressure();
+
+        // Test Case 5: disabling resets the producer index and sequence
+        test_case = 5;
+        $display("Test Case 5: Re-Arming");
+        test_rearm();
+
+        if (error_count == 0) begin
+            $display("All tests completed successfully!");
+        end else begin
+            $display("Tests completed with %d errors", error_count);
+        end
+        $finish;
+    end
+
+    task test_passthrough();
+        begin
+            out_count = 0;
+            ring_writes = 0;
+            for (i = 0; i < 4; i++) begin
+                send_result(32'h100 + i, 8'd0, OP_ADD, 32'd4);
+                if (last_out !== 32'h100 + i) begin
+                    $error("Pass-through: expected %h, got %h", 32'h100 + i, last_out);
+                    error_count = error_count + 1;
+                end
+            end
+            repeat (4) @(posedge clk);
+            if (out_count != 4 || ring_writes != 0 || cq_seq != 0) begin
+                $error("Disabled queue: %0d results, %0d records, seq %0d", out_count, ring_writes, cq_seq);
+                error_count = error_count + 1;
+            end else begin
+                $display("  ✓ 4 results passed through, no records posted");
+            end
+        end
+    endtask
+
+    task test_records();
+        begin
+            arm(8);
+            for (i = 0; i < 5; i++) begin
+                send_result(32'h200 + i, i % 3, OP_ADD, 32'd10 + i);
+            end
+            wait_records(5);
+            for (i = 0; i < 5; i++) begin
+                check_record(i, i + 1, i % 3, OP_ADD, 10 + i, 0);
+            end
+            if (cq_tail != 5 || cq_seq != 5 || irq_count != 5) begin
+                $error("After 5 records: tail %0d, seq %0d, irqs %0d", cq_tail, cq_seq, irq_count);
+                error_count = error_count + 1;
+            end
+            if (bad_addr != 0) begin
+                $error("%0d records written outside the ring", bad_addr);
+                error_count = error_count + 1;
+            end
+            $display("  ✓ 5 records with sequence, status, cycles and error code");
+        end
+    endtask
+
+    task test_errors();
+        begin
+            arm(8);
+            send_result(32'h1, 8'd2, OP_CONV, 32'd300);      // Rejected configuration
+            send_result(32'h0, 8'd1, OP_POOLING, 32'd120);   // Completed
+            send_result(32'h1, 8'd0, OP_ADD, 32'd4);         // Data, not an error flag
+            wait_records(3);
+            check_record(0, 1, 2, OP_CONV, 300, 1);
+            check_record(1, 2, 1, OP_POOLING, 120, 0);
+            check_record(2, 3, 0, OP_ADD, 4, 0);
+            $display("  ✓ Configuration error reported only for CONV/POOLING");
+        end
+    endtask
+
+    task test_backpressure();
+        integer stall;
+        begin
+            arm(4);
+
+            // Three records fill a four-slot ring while the host sits at 0
+            for (i = 0; i < 3; i++) begin
+                send_result(32'h300 + i, 8'd0, OP_ADD, 32'd4);
+            end
+            wait_records(3);
+
+            res_data = 32'h303;
+            res_valid = 1;
+            stall = 0;
+            repeat (20) begin
+                @(posedge clk);
+                #1;
+                if (!res_ready) stall = stall + 1;
+            end
+            if (stall != 20 || ring_writes != 3) begin
+                $error("Full ring: stalled %0d of 20 cycles, %0d records", stall, ring_writes);
+                error_count = error_count + 1;
+            end else begin
+                $display("    ✓ Full ring stalls the result stream");
+            end
+
+            // Host consumes two records: the pending result and one more go through
+            cq_head = 2;
+            while (!res_ready) begin
+                @(posedge clk);
+                #1;
+            end
+            @(posedge clk);
+            #1;
+            res_valid = 0;
+            send_result(32'h304, 8'd0, OP_ADD, 32'd4);
+            wait_records(5);
+            check_record(3, 4, 0, OP_ADD, 4, 0);
+            check_record(0, 5, 0, OP_ADD, 4, 0);   // Wrapped into slot 0
+
+            // Host write port back-pressure holds the record and the stream
+            cq_head = 1;
+            hw_ready = 0;
+            send_result(32'h305, 8'd0, OP_ADD, 32'd4);
+            res_data = 32'h306;
+            res_valid = 1;
+            stall = 0;
+            repeat (10) begin
+                @(posedge clk);
+                #1;
+                if (!res_ready) stall = stall + 1;
+            end
+            if (stall != 10 || !hw_valid || hw_addr != cq_base + 16) begin
+                $error("Write stall: stalled %0d of 10 cycles, hw_valid %b, addr %h", stall, hw_valid, hw_addr);
+                error_count = error_count + 1;
+            end
+            hw_ready = 1;
+            while (!res_ready) begin
+                @(posedge clk);
+                #1;
+            end
+            @(posedge clk);
+            #1;
+            res_valid = 0;
+            wait_records(7);
+            check_record(1, 6, 0, OP_ADD, 4, 0);
+            check_record(2, 7, 0, OP_ADD, 4, 0);
+            $display("  ✓ Back-pressure and wrap-around tests completed");
+        end
+    endtask
+
+    task test_rearm();
+        begin
+            cq_enable = 0;
+            repeat (2) @(posedge clk);
+            #1;
+            if (cq_tail != 0 || cq_seq != 0) begin
+                $error("Disabled queue kept tail %0d, seq %0d", cq_tail, cq_seq);
+                error_count = error_count + 1;
+            end
+            arm(8);
+            send_result(32'h400, 8'd3, OP_ADD, 32'd7);
+            wait_records(1);
+            check_record(0, 1, 3, OP_ADD, 7, 0);
+            $display("  ✓ Re-armed queue restarts at sequence 1, slot 0");
+        end
+    endtask
+
+    // Helper task: Reset the host ring and enable the queue
+    task arm(input integer entries);
+        begin
+            cq_enable = 0;
+            repeat (2) @(posedge clk);
+            #1;
+            clear_ring();
+            ring_writes = 0;
+            irq_count = 0;
+            bad_addr = 0;
+            cq_head = 0;
+            cq_entries = entries;
+            cq_enable = 1;
+            @(posedge clk);
+            #1;
+        end
+    endtask
+
+    task clear_ring();
+        begin
+            for (i = 0; i < MAX_SLOTS; i++) begin
+                ring[i] = '0;
+            end
+        end
+    endtask
+
+    // Helper task: Hand one tagged result to the DUT
+    task send_result(input [DATA_WIDTH-1:0] data, input [7:0] core,
+                     input [7:0] opcode, input [31:0] cycles);
+        begin
+            res_data = data;
+            res_core = core;
+            res_opcode = opcode;
+            res_cycles = cycles;
+            res_valid = 1;
+            #1;
+            while (!res_ready) begin
+                @(posedge clk);
+                #1;
+            end
+            @(posedge clk);
+            #1;
+            res_valid = 0;
+        end
+    endtask
+
+    // Helper task: Wait until n records have been posted in total
+    task wait_records(input integer n);
+        integer timeout;
+        begin
+            timeout = 0;
+            while (ring_writes < n && timeout < 100) begin
+                @(posedge clk);
+                timeout = timeout + 1;
+            end
+            @(posedge clk);
+            #1;
+            if (ring_writes < n) begin
+                $error("Expected %0d records, got %0d", n, ring_writes);
+                error_count = error_count + 1;
+            end
+        end
+    endtask
+
+    // Helper task: Compare one ring slot with the expected record
+    task check_record(input integer slot, input [31:0] seq, input [7:0] core,
+                      input [7:0] opcode, input [31:0] cycles, input [31:0] err);
+        reg [31:0] status;
+        begin
+            status = STATUS_DONE | (err != 0 ? STATUS_ERROR : 32'd0) | {8'h00, core, opcode, 8'h00};
+            if (ring[slot] !== {err, cycles, status, seq}) begin
+                $error("Slot %0d: expected seq %0d status %h cycles %0d error %0d, got %h",
+                       slot, seq, status, cycles, err, ring[slot]);
+                error_count = error_count + 1;
+            end else begin
+                $display("    ✓ Slot %0d: seq %0d, status %h, %0d cycles, error %0d",
+                         slot, seq, status, cycles, err);
+            end
+        end
+    endtask
+
+    // Simulation timeout
+    initial begin
+        #200000;  // 200us timeout
+        $error("Simulation timeout!");
+        $finish;
+    end
+
+endmodule
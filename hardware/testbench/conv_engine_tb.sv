@@ -0,0 +1,731 @@
+/**
+ * Convolution Engine Testbench
+ *
+ * Testbench for conv_engine.sv module driving an array of processing
+ * elements. Checks convolution and max/avg/global-average pooling outputs
+ * against reference models for several kernel/stride/padding shapes,
+ * checks that every input pixel is read exactly once per output-channel
+ * group and every output written once, checks that zero input taps are
+ * compacted out of the MAC stream, runs 2:4 compressed weights against
+ * the dense reference, and checks configuration error reporting
+ */
+
+`timescale 1ns / 1ps
+
+module conv_engine_tb();
+
+    // Parameters
+    parameter DATA_WIDTH = 32;
+    parameter ADDR_WIDTH = 32;
+    parameter OC_GROUP = 4;
+    parameter MAX_KERNEL = 5;
+    parameter MAX_WIDTH = 32;
+    parameter MAX_OUT_PIXELS = 256;
+    parameter MAC_LATENCY = 1;
+    parameter MEM_WORDS = 16384;
+
+    // Memory map (byte addresses)
+    localparam IN_BASE  = 32'h0000_0000;
+    localparam W_BASE   = 32'h0000_4000;
+    localparam OUT_BASE = 32'h0000_8000;
+    localparam W_REF_BASE = 32'h0000_C000;  // Dense weights for the reference model
+
+    localparam ACT_NONE = 3'h0;
+    localparam ACT_RELU = 3'h1;
+
+    localparam POOL_MAX        = 2'h0;
+    localparam POOL_AVG        = 2'h1;
+    localparam POOL_GLOBAL_AVG = 2'h2;
+
+    // DUT signals
+    reg clk;
+    reg rst_n;
+    reg start;
+    wire busy;
+    wire done;
+    wire error;
+
+    reg cfg_pool;
+    reg cfg_sparse;
+    reg [1:0] cfg_pool_mode;
+    reg [ADDR_WIDTH-1:0] cfg_in_addr, cfg_w_addr, cfg_out_addr;
+    reg [15:0] cfg_in_h, cfg_in_w;
+    reg [11:0] cfg_in_c, cfg_out_c;
+    reg [3:0] cfg_kernel_h, cfg_kernel_w;
+    reg [3:0] cfg_stride_h, cfg_stride_w;
+    reg [3:0] cfg_pad_h, cfg_pad_w;
+    reg [2:0] cfg_act_func;
+    reg [15:0] cfg_act_alpha;
+    reg [OC_GROUP-1:0] cfg_lane_mask;
+
+    wire pe_enable;
+    wire pe_acc_clear;
+    wire [OC_GROUP*DATA_WIDTH-1:0] pe_op_a;
+    wire [OC_GROUP*DATA_WIDTH-1:0] pe_op_b;
+    wire [OC_GROUP*DATA_WIDTH-1:0] pe_results;
+    wire [OC_GROUP-1:0] pe_valid;
+    wire [$clog2(MAX_KERNEL*MAX_KERNEL+1)-1:0] taps_skipped;
+
+    wire [ADDR_WIDTH-1:0] mem_addr;
+    wire [DATA_WIDTH-1:0] mem_wdata;
+    reg  [DATA_WIDTH-1:0] mem_rdata;
+    wire mem_we;
+    wire mem_re;
+    reg  mem_valid;
+
+    // Memory model with per-word access counters
+    reg [DATA_WIDTH-1:0] memory [0:MEM_WORDS-1];
+    integer read_count [0:MEM_WORDS-1];
+    integer write_count [0:MEM_WORDS-1];
+
+    // Test variables
+    integer test_case;
+    integer error_count;
+    integer zero_percent;       // Share of input pixels forced to zero
+    integer sparse_weights;     // Prune weights to 2:4 and load them compressed
+    integer taps_skipped_total;
+
+    // DUT instantiation
+    conv_engine #(
+        .DATA_WIDTH(DATA_WIDTH),
+        .ADDR_WIDTH(ADDR_WIDTH),
+        .OC_GROUP(OC_GROUP),
+        .MAX_KERNEL(MAX_KERNEL),
+        .MAX_WIDTH(MAX_WIDTH),
+        .MAX_OUT_PIXELS(MAX_OUT_PIXELS)
+    ) dut (
+        .clk(clk),
+        .rst_n(rst_n),
+        .start(start),
+        .busy(busy),
+        .done(done),
+        .error(error),
+        .cfg_pool(cfg_pool),
+        .cfg_sparse(cfg_sparse),
+        .cfg_pool_mode(cfg_pool_mode),
+        .cfg_in_addr(cfg_in_addr),
+        .cfg_w_addr(cfg_w_addr),
+        .cfg_out_addr(cfg_out_addr),
+        .cfg_in_h(cfg_in_h),
+        .cfg_in_w(cfg_in_w),
+        .cfg_in_c(cfg_in_c),
+        .cfg_out_c(cfg_out_c),
+        .cfg_kernel_h(cfg_kernel_h),
+        .cfg_kernel_w(cfg_kernel_w),
+        .cfg_stride_h(cfg_stride_h),
+        .cfg_stride_w(cfg_stride_w),
+        .cfg_pad_h(cfg_pad_h),
+        .cfg_pad_w(cfg_pad_w),
+        .cfg_act_func(cfg_act_func),
+        .cfg_act_alpha(cfg_act_alpha),
+        .cfg_lane_mask(cfg_lane_mask),
+        .pe_enable(pe_enable),
+        .pe_acc_clear(pe_acc_clear),
+        .pe_op_a(pe_op_a),
+        .pe_op_b(pe_op_b),
+        .pe_results(pe_results),
+        .pe_valid(|pe_valid),
+        .taps_skipped(taps_skipped),
+        .mem_addr(mem_addr),
+        .mem_wdata(mem_wdata),
+        .mem_rdata(mem_rdata),
+        .mem_we(mem_we),
+        .mem_re(mem_re),
+        .mem_valid(mem_valid)
+    );
+
+    // PE array, wired the same way as in npu_core
+    genvar i;
+    generate
+        for (i = 0; i < OC_GROUP; i++) begin : pe_array
+            processing_element #(
+                .DATA_WIDTH(DATA_WIDTH),
+                .MAC_LATENCY(MAC_LATENCY)
+            ) u_pe (
+                .clk(clk),
+                .rst_n(rst_n),
+                .enable(pe_enable && cfg_lane_mask[i]),
+                .op_a(pe_op_a[i*DATA_WIDTH +: DATA_WIDTH]),
+                .op_b(pe_op_b[i*DATA_WIDTH +: DATA_WIDTH]),
+                .operation(4'h4),
+                .acc_clear(pe_acc_clear),
+                .precision(2'b00),
+                .saturate(1'b0),
+                .round_mode(2'b00),
+                .shift_amt(5'd0),
+                .result(pe_results[i*DATA_WIDTH +: DATA_WIDTH]),
+                .valid(pe_valid[i])
+            );
+        end
+    endgenerate
+
+    // Clock generation
+    initial begin
+        clk = 0;
+        forever #5 clk = ~clk;  // 100MHz
+    end
+
+    // Reset generation
+    initial begin
+        rst_n = 0;
+        #50;
+        rst_n = 1;
+        #20;
+    end
+
+    // Compacted tap counter
+    always @(posedge clk) begin
+        taps_skipped_total <= taps_skipped_total + taps_skipped;
+    end
+
+    // Memory model: one-cycle response, request held until valid
+    always @(posedge clk) begin
+        mem_valid <= 1'b0;
+        if ((mem_re || mem_we) && !mem_valid) begin
+            mem_valid <= 1'b1;
+            if (mem_re) begin
+                mem_rdata <= memory[mem_addr >> 2];
+                read_count[mem_addr >> 2] = read_count[mem_addr >> 2] + 1;
+            end
+            if (mem_we) begin
+                memory[mem_addr >> 2] <= mem_wdata;
+                write_count[mem_addr >> 2] = write_count[mem_addr >> 2] + 1;
+            end
+        end
+    end
+
+    // Test stimulus
+    initial begin
+        // Initialize signals
+        start = 0;
+        cfg_pool = 0;
+        cfg_sparse = 0;
+        cfg_pool_mode = POOL_MAX;
+        cfg_in_addr = IN_BASE;
+        cfg_w_addr = W_BASE;
+        cfg_out_addr = OUT_BASE;
+        cfg_act_func = ACT_NONE;
+        cfg_act_alpha = 16'h0000;
+        cfg_lane_mask = {OC_GROUP{1'b1}};
+        mem_rdata = 0;
+        mem_valid = 0;
+        test_case = 0;
+        error_count = 0;
+        zero_percent = 0;
+        sparse_weights = 0;
+        taps_skipped_total = 0;
+
+        // Wait for reset release
+        wait(rst_n);
+        #100;
+
+        $display("Starting Convolution Engine Testbench");
+
+        // Test Case 1: 3x3, stride 1, same padding
+        test_case = 1;
+        $display("Test Case 1: 3x3 Stride 1 Pad 1");
+        run_conv(8, 8, 2, 4, 3, 1, 1, 1, 1, ACT_NONE);
+
+        // Test Case 2: 3x3, stride 2, two output-channel groups
+        test_case = 2;
+        $display("Test Case 2: 3x3 Stride 2 Pad 1, Partial Second Group");
+        run_conv(9, 9, 3, 6, 3, 2, 2, 1, 1, ACT_NONE);
+
+        // Test Case 3: pointwise convolution
+        test_case = 3;
+        $display("Test Case 3: 1x1 Pointwise");
+        run_conv(5, 5, 4, 3, 1, 1, 1, 0, 0, ACT_NONE);
+
+        // Test Case 4: largest kernel with fused ReLU
+        test_case = 4;
+        $display("Test Case 4: 5x5 Pad 2 with ReLU Epilogue");
+        run_conv(6, 6, 1, 2, 5, 1, 1, 2, 2, ACT_RELU);
+
+        // Test Case 5: asymmetric stride and padding
+        test_case = 5;
+        $display("Test Case 5: Asymmetric Stride and Padding");
+        run_conv(7, 6, 2, 5, 3, 2, 1, 0, 1, ACT_NONE);
+
+        // Test Case 6: stride larger than two
+        test_case = 6;
+        $display("Test Case 6: 3x3 Stride 3");
+        run_conv(10, 10, 1, 3, 3, 3, 3, 1, 1, ACT_NONE);
+
+        // Test Case 7: max pooling
+        test_case = 7;
+        $display("Test Case 7: Max Pooling");
+        run_pool(8, 8, 3, 2, 2, 2, 2, 0, 0, POOL_MAX);
+        run_pool(7, 7, 2, 3, 3, 2, 2, 1, 1, POOL_MAX);   // Padding never wins
+
+        // Test Case 8: average pooling
+        test_case = 8;
+        $display("Test Case 8: Average Pooling");
+        run_pool(8, 8, 2, 2, 2, 2, 2, 0, 0, POOL_AVG);
+        run_pool(9, 6, 2, 3, 2, 3, 1, 1, 0, POOL_AVG);   // Rectangular kernel, stride 3
+
+        // Test Case 9: global average pooling
+        test_case = 9;
+        $display("Test Case 9: Global Average Pooling");
+        run_pool(7, 9, 4, 0, 0, 0, 0, 0, 0, POOL_GLOBAL_AVG);
+        run_pool(40, 40, 1, 0, 0, 0, 0, 0, 0, POOL_GLOBAL_AVG);  // Wider than the line buffer
+
+        // Test Case 10: unsupported configuration
+        test_case = 10;
+        $display("Test Case 10: Configuration Errors");
+        test_config_errors();
+
+        // Test Case 11: sparse (post-ReLU-like) input, zero taps compacted
+        test_case = 11;
+        $display("Test Case 11: Zero-Tap Compaction");
+        zero_percent = 60;
+        run_conv(8, 8, 2, 4, 3, 1, 1, 1, 1, ACT_NONE);
+        zero_percent = 100;
+        run_conv(6, 6, 1, 4, 3, 1, 1, 0, 0, ACT_NONE);
+        zero_percent = 0;
+
+        // Test Case 12: 2:4 structured-sparse weights
+        test_case = 12;
+        $display("Test Case 12: 2:4 Sparse Weights");
+        sparse_weights = 1;
+        run_conv(6, 6, 3, 4, 2, 1, 1, 0, 0, ACT_NONE);    // One full group per block
+        run_conv(8, 8, 2, 6, 3, 1, 1, 1, 1, ACT_NONE);    // Padded last group, partial lane group
+        run_conv(9, 9, 1, 4, 5, 2, 2, 2, 2, ACT_RELU);
+        sparse_weights = 0;
+
+        // Test Case 13: output channels remapped onto the enabled lanes
+        test_case = 13;
+        $display("Test Case 13: PE Lane Partition");
+        test_lane_partition();
+
+        if (error_count == 0) begin
+            $display("All tests completed successfully!");
+        end else begin
+            $display("Tests completed with %d errors", error_count);
+        end
+        $finish;
+    end
+
+    // Reference convolution for one output element
+    function automatic integer ref_conv(
+        input integer oc, input integer oy, input integer ox,
+        input integer h, input integer w, input integer ic_n, input integer k,
+        input integer sh, input integer sw, input integer ph, input integer pw,
+        input [2:0] act
+    );
+        integer ic, ky, kx, iy, ix, sum;
+        sum = 0;
+        for (ic = 0; ic < ic_n; ic++) begin
+            for (ky = 0; ky < k; ky++) begin
+                for (kx = 0; kx < k; kx++) begin
+                    iy = oy * sh + ky - ph;
+                    ix = ox * sw + kx - pw;
+                    if (iy >= 0 && iy < h && ix >= 0 && ix < w) begin
+                        sum = sum + $signed(memory[(IN_BASE >> 2) + (ic * h + iy) * w + ix]) *
+                                    $signed(memory[(W_REF_BASE >> 2) + ((oc * ic_n + ic) * k + ky) * k + kx]);
+                    end
+                end
+            end
+        end
+        if (act == ACT_RELU && sum < 0) begin
+            sum = 0;
+        end
+        return sum;
+    endfunction
+
+    // Number of taps the engine should compact out of one window: every
+    // zero tap (padding included), except one issued to clear an all-zero window
+    function automatic integer ref_zero_taps(
+        input integer ic, input integer oy, input integer ox,
+        input integer h, input integer w, input integer k,
+        input integer sh, input integer sw, input integer ph, input integer pw
+    );
+        integer ky, kx, iy, ix, zeros;
+        zeros = 0;
+        for (ky = 0; ky < k; ky++) begin
+            for (kx = 0; kx < k; kx++) begin
+                iy = oy * sh + ky - ph;
+                ix = ox * sw + kx - pw;
+                if (iy < 0 || iy >= h || ix < 0 || ix >= w ||
+                    memory[(IN_BASE >> 2) + (ic * h + iy) * w + ix] == 0) begin
+                    zeros = zeros + 1;
+                end
+            end
+        end
+        return (zeros == k * k) ? zeros - 1 : zeros;
+    endfunction
+
+    // Prune the reference weights to 2:4 (two non-zeros per group of four taps)
+    task prune_weights_2_4(input integer blocks, input integer kk);
+        integer b, t, keep0, keep1;
+        begin
+            for (b = 0; b < blocks; b++) begin
+                for (t = 0; t < kk; t++) begin
+                    if (t % 4 == 0) begin
+                        keep0 = $urandom_range(0, 3);
+                        keep1 = (keep0 + $urandom_range(1, 3)) % 4;
+                    end
+                    if (t % 4 != keep0 && t % 4 != keep1) begin
+                        memory[(W_REF_BASE >> 2) + b * kk + t] = 0;
+                    end
+                end
+            end
+        end
+    endtask
+
+    // Pack the reference weights into the compressed 2:4 layout at W_BASE:
+    // per block, metadata words (one nibble per group) then value pairs
+    task pack_weights_2_4(input integer blocks, input integer kk, output integer block_words);
+        integer b, g, t, n, groups, meta_words, base, idx0, idx1;
+        begin
+            groups = (kk + 3) / 4;
+            meta_words = (groups + 7) / 8;
+            block_words = meta_words + 2 * groups;
+            for (b = 0; b < blocks; b++) begin
+                base = (W_BASE >> 2) + b * block_words;
+                for (n = 0; n < meta_words; n++) begin
+                    memory[base + n] = 0;
+                end
+                for (g = 0; g < groups; g++) begin
+                    idx0 = -1;
+                    idx1 = -1;
+                    for (t = 0; t < 4; t++) begin
+                        if (4 * g + t < kk && memory[(W_REF_BASE >> 2) + b * kk + 4 * g + t] != 0) begin
+                            if (idx0 < 0) idx0 = t;
+                            else idx1 = t;
+                        end
+                    end
+                    // Unused slots point at a zero (or padding) tap
+                    if (idx0 < 0) idx0 = 0;
+                    if (idx1 < 0) idx1 = (idx0 == 3) ? 2 : 3;
+                    memory[base + g / 8] = memory[base + g / 8] | (((idx1 << 2) | idx0) << (4 * (g % 8)));
+                    memory[base + meta_words + 2 * g] = (4 * g + idx0 < kk)
+                        ? memory[(W_REF_BASE >> 2) + b * kk + 4 * g + idx0] : 0;
+                    memory[base + meta_words + 2 * g + 1] = (4 * g + idx1 < kk)
+                        ? memory[(W_REF_BASE >> 2) + b * kk + 4 * g + idx1] : 0;
+                end
+            end
+        end
+    endtask
+
+    // Helper task: Load random tensors, run the engine and check everything
+    task run_conv(
+        input integer h, input integer w, input integer ic_n, input integer oc_n,
+        input integer k, input integer sh, input integer sw,
+        input integer ph, input integer pw, input [2:0] act
+    );
+        integer j, ic, oc, oy, ox, oh, ow, groups, cycles, expected, addr, bad_reads;
+        integer expected_skipped, block_words, slots, weight_reads, lanes;
+        begin
+            oh = (h + 2 * ph - k) / sh + 1;
+            ow = (w + 2 * pw - k) / sw + 1;
+            lanes = $countones(cfg_lane_mask);
+            groups = (oc_n + lanes - 1) / lanes;
+
+            for (j = 0; j < MEM_WORDS; j++) begin
+                memory[j] = 32'hDEAD_BEEF;
+                read_count[j] = 0;
+                write_count[j] = 0;
+            end
+            for (j = 0; j < ic_n * h * w; j++) begin
+                memory[(IN_BASE >> 2) + j] = ($urandom_range(0, 99) < zero_percent)
+                                             ? 0 : $signed($urandom_range(0, 15)) - 8;
+            end
+            for (j = 0; j < oc_n * ic_n * k * k; j++) begin
+                memory[(W_REF_BASE >> 2) + j] = $signed($urandom_range(0, 15)) - 8;
+            end
+
+            if (sparse_weights) begin
+                prune_weights_2_4(oc_n * ic_n, k * k);
+                pack_weights_2_4(oc_n * ic_n, k * k, block_words);
+                // Structured sparsity issues a fixed two slots per group of four taps
+                slots = 2 * ((k * k + 3) / 4);
+                expected_skipped = (k * k > slots) ? (k * k - slots) * ic_n * oh * ow * groups : 0;
+            end else begin
+                block_words = k * k;
+                for (j = 0; j < oc_n * ic_n * k * k; j++) begin
+                    memory[(W_BASE >> 2) + j] = memory[(W_REF_BASE >> 2) + j];
+                end
+                expected_skipped = 0;
+                for (ic = 0; ic < ic_n; ic++) begin
+                    for (oy = 0; oy < oh; oy++) begin
+                        for (ox = 0; ox < ow; ox++) begin
+                            expected_skipped = expected_skipped +
+                                ref_zero_taps(ic, oy, ox, h, w, k, sh, sw, ph, pw);
+                        end
+                    end
+                end
+                expected_skipped = expected_skipped * groups;
+            end
+
+            cfg_pool = 0;
+            cfg_sparse = sparse_weights;
+            cfg_in_h = h;
+            cfg_in_w = w;
+            cfg_in_c = ic_n;
+            cfg_out_c = oc_n;
+            cfg_kernel_h = k;
+            cfg_kernel_w = k;
+            cfg_stride_h = sh;
+            cfg_stride_w = sw;
+            cfg_pad_h = ph;
+            cfg_pad_w = pw;
+            cfg_act_func = act;
+
+            @(posedge clk);
+            #1;
+            taps_skipped_total = 0;
+            start = 1;
+            @(posedge clk);
+            #1;
+            start = 0;
+
+            cycles = 0;
+            while (!done) begin
+                @(posedge clk);
+                #1;
+                cycles = cycles + 1;
+            end
+
+            if (error) begin
+                $error("Engine flagged a configuration error for a valid shape");
+                error_count = error_count + 1;
+            end
+
+            if (taps_skipped_total != expected_skipped) begin
+                $error("Compacted taps: expected %0d, got %0d", expected_skipped, taps_skipped_total);
+                error_count = error_count + 1;
+            end
+
+            // Outputs
+            for (oc = 0; oc < oc_n; oc++) begin
+                for (oy = 0; oy < oh; oy++) begin
+                    for (ox = 0; ox < ow; ox++) begin
+                        addr = (OUT_BASE >> 2) + (oc * oh + oy) * ow + ox;
+                        expected = ref_conv(oc, oy, ox, h, w, ic_n, k, sh, sw, ph, pw, act);
+                        if (memory[addr] !== expected) begin
+                            $error("out[%0d][%0d][%0d]: expected %0d, got %0d",
+                                   oc, oy, ox, expected, $signed(memory[addr]));
+                            error_count = error_count + 1;
+                        end
+                        if (write_count[addr] != 1) begin
+                            $error("out[%0d][%0d][%0d] written %0d times", oc, oy, ox, write_count[addr]);
+                            error_count = error_count + 1;
+                        end
+                    end
+                end
+            end
+
+            // Each input pixel once per output-channel group
+            bad_reads = 0;
+            for (j = 0; j < ic_n * h * w; j++) begin
+                if (read_count[(IN_BASE >> 2) + j] != groups) begin
+                    bad_reads = bad_reads + 1;
+                end
+            end
+            if (bad_reads != 0) begin
+                $error("%0d input pixels not read exactly %0d time(s)", bad_reads, groups);
+                error_count = error_count + 1;
+            end
+
+            // Each weight block once (compressed blocks are smaller)
+            weight_reads = 0;
+            for (j = 0; j < oc_n * ic_n * block_words; j++) begin
+                weight_reads = weight_reads + read_count[(W_BASE >> 2) + j];
+            end
+            if (weight_reads != oc_n * ic_n * block_words) begin
+                $error("Weight reads: expected %0d, got %0d", oc_n * ic_n * block_words, weight_reads);
+                error_count = error_count + 1;
+            end
+
+            $display("    ✓ %0dx%0dx%0d -> %0dx%0dx%0d (K=%0d, S=%0d/%0d, P=%0d/%0d) in %0d cycles, %0d MACs, %0d taps compacted",
+                     ic_n, h, w, oc_n, oh, ow, k, sh, sw, ph, pw, cycles, oc_n * oh * ow * ic_n * k * k,
+                     expected_skipped);
+        end
+    endtask
+
+    // Reference pooling for one output element (same reciprocal as the RTL)
+    function automatic integer ref_pool(
+        input integer c, input integer oy, input integer ox,
+        input integer h, input integer w, input integer kh, input integer kw,
+        input integer sh, input integer sw, input integer ph, input integer pw,
+        input [1:0] mode
+    );
+        integer ky, kx, iy, ix, value, best, count;
+        longint sum, recip;
+        sum = 0;
+        best = 32'h8000_0000;
+        if (mode == POOL_GLOBAL_AVG) begin
+            kh = h;
+            kw = w;
+        end
+        for (ky = 0; ky < kh; ky++) begin
+            for (kx = 0; kx < kw; kx++) begin
+                iy = oy * sh + ky - ph;
+                ix = ox * sw + kx - pw;
+                if (iy >= 0 && iy < h && ix >= 0 && ix < w) begin
+                    value = $signed(memory[(IN_BASE >> 2) + (c * h + iy) * w + ix]);
+                    sum = sum + value;
+                    if (value > best) best = value;
+                end
+            end
+        end
+        if (mode == POOL_MAX) begin
+            return best;
+        end
+        count = kh * kw;
+        recip = ((64'd1 << 31) + count / 2) / count;
+        return (sum * recip + (64'sd1 <<< 30)) >>> 31;
+    endfunction
+
+    // Helper task: Run a pooling job and check outputs and read counts
+    task run_pool(
+        input integer h, input integer w, input integer c_n,
+        input integer kh, input integer kw, input integer sh, input integer sw,
+        input integer ph, input integer pw, input [1:0] mode
+    );
+        integer j, c, oy, ox, oh, ow, cycles, expected, addr, bad_reads;
+        begin
+            if (mode == POOL_GLOBAL_AVG) begin
+                oh = 1;
+                ow = 1;
+            end else begin
+                oh = (h + 2 * ph - kh) / sh + 1;
+                ow = (w + 2 * pw - kw) / sw + 1;
+            end
+
+            for (j = 0; j < MEM_WORDS; j++) begin
+                memory[j] = 32'hDEAD_BEEF;
+                read_count[j] = 0;
+                write_count[j] = 0;
+            end
+            for (j = 0; j < c_n * h * w; j++) begin
+                memory[(IN_BASE >> 2) + j] = $signed($urandom_range(0, 2000)) - 1000;
+            end
+
+            cfg_pool = 1;
+            cfg_pool_mode = mode;
+            cfg_in_h = h;
+            cfg_in_w = w;
+            cfg_in_c = c_n;
+            cfg_out_c = 0;
+            cfg_kernel_h = kh;
+            cfg_kernel_w = kw;
+            cfg_stride_h = sh;
+            cfg_stride_w = sw;
+            cfg_pad_h = ph;
+            cfg_pad_w = pw;
+            cfg_act_func = ACT_NONE;
+
+            @(posedge clk);
+            #1;
+            start = 1;
+            @(posedge clk);
+            #1;
+            start = 0;
+
+            cycles = 0;
+            while (!done) begin
+                @(posedge clk);
+                #1;
+                cycles = cycles + 1;
+            end
+
+            if (error) begin
+                $error("Engine flagged a configuration error for a valid pooling shape");
+                error_count = error_count + 1;
+            end
+
+            for (c = 0; c < c_n; c++) begin
+                for (oy = 0; oy < oh; oy++) begin
+                    for (ox = 0; ox < ow; ox++) begin
+                        addr = (OUT_BASE >> 2) + (c * oh + oy) * ow + ox;
+                        expected = ref_pool(c, oy, ox, h, w, kh, kw, sh, sw, ph, pw, mode);
+                        if (memory[addr] !== expected || write_count[addr] != 1) begin
+                            $error("pool[%0d][%0d][%0d]: expected %0d, got %0d (%0d writes)",
+                                   c, oy, ox, expected, $signed(memory[addr]), write_count[addr]);
+                            error_count = error_count + 1;
+                        end
+                    end
+                end
+            end
+
+            bad_reads = 0;
+            for (j = 0; j < c_n * h * w; j++) begin
+                if (read_count[(IN_BASE >> 2) + j] != 1) begin
+                    bad_reads = bad_reads + 1;
+                end
+            end
+            if (bad_reads != 0) begin
+                $error("%0d input pixels not read exactly once", bad_reads);
+                error_count = error_count + 1;
+            end
+
+            $display("    ✓ mode %0d: %0dx%0dx%0d -> %0dx%0d (K=%0dx%0d, S=%0d/%0d, P=%0d/%0d) in %0d cycles",
+                     mode, c_n, h, w, oh, ow, kh, kw, sh, sw, ph, pw, cycles);
+        end
+    endtask
+
+    // Helper task: Start with a bad configuration and expect error + done
+    task expect_config_error(input integer k, input integer sh, input integer w);
+        begin
+            cfg_pool = 0;
+            cfg_in_h = 8;
+            cfg_in_w = w;
+            cfg_in_c = 1;
+            cfg_out_c = 1;
+            cfg_kernel_h = k;
+            cfg_kernel_w = k;
+            cfg_stride_h = sh;
+            cfg_stride_w = 1;
+            cfg_pad_h = 0;
+            cfg_pad_w = 0;
+
+            @(posedge clk);
+            #1;
+            start = 1;
+            @(posedge clk);
+            #1;
+            start = 0;
+
+            while (!done) @(posedge clk);
+            #1;
+            if (!error) begin
+                $error("No error for K=%0d, stride=%0d, width=%0d", k, sh, w);
+                error_count = error_count + 1;
+            end else begin
+                $display("    ✓ Rejected K=%0d, stride=%0d, width=%0d", k, sh, w);
+            end
+        end
+    endtask
+
+    task test_config_errors();
+        begin
+            expect_config_error(MAX_KERNEL + 2, 1, 8);   // Kernel too large
+            expect_config_error(3, 0, 8);                // Zero stride
+            expect_config_error(3, 1, MAX_WIDTH + 1);    // Row longer than the line buffer
+            expect_config_error(0, 1, 8);                // Empty kernel
+            $display("  ✓ Configuration error tests completed");
+        end
+    endtask
+
+    task test_lane_partition();
+        begin
+            cfg_lane_mask = 4'b0101;
+            run_conv(8, 8, 2, 5, 3, 1, 1, 1, 1, ACT_NONE);    // Three groups of two lanes
+            cfg_lane_mask = 4'b1000;
+            run_conv(6, 6, 1, 3, 3, 1, 1, 0, 0, ACT_RELU);    // Single lane
+            cfg_lane_mask = 4'b0000;
+            expect_config_error(3, 1, 8);                      // No lane to run on
+            cfg_lane_mask = {OC_GROUP{1'b1}};
+            $display("  ✓ Lane partition tests completed");
+        end
+    endtask
+
+    // Simulation timeout
+    initial begin
+        #5000000;  // 5ms timeout
+        $error("Simulation timeout!");
+        $finish;
+    end
+
+endmodule
@@ -0,0 +1,566 @@
+/**
+ * NPU Top Level Benchmark
+ *
+ * Throughput benchmark for npu_top.sv. Each scenario streams a long
+ * back-to-back instruction mix into the PCIe RX port (full beats, no idle
+ * cycles on the host side) and measures, over the core-clock cycles from
+ * the first word to the last result:
+ *
+ *   - instructions/cycle and nominal MACs/cycle (perf_macs_nominal)
+ *   - core busy fraction
+ *   - RX and TX FIFO occupancy (mean and peak, in words)
+ *   - PCIe RX, PCIe TX and completion-ring bytes/cycle
+ *   - memory-port accesses/cycle
+ *
+ * npu_top has no DMA engine of its own; the host-side traffic it sees is
+ * the instruction stream, the result stream and the completion records it
+ * posts, so those are the bytes/cycle reported. The last scenario throttles
+ * pcie_tx_ready to half rate with the completion ring enabled to load the
+ * TX path.
+ *
+ * Results go to BENCH_OUT (default npu_bench_results.csv, overridable with
+ * +BENCH_OUT=<file>) as "scenario,metric,value,better" rows, where better
+ * is "higher" or "lower". bench_compare.py compares two such files.
+ */
+
+`timescale 1ns / 1ps
+
+module npu_bench_tb();
+
+    // Parameters
+    parameter DATA_WIDTH = 32;
+    parameter ADDR_WIDTH = 32;
+    parameter PE_COUNT = 16;
+    parameter PCIE_DATA_WIDTH = 128;
+    parameter CORE_COUNT = 1;
+    parameter NUM_INST = 512;           // Instructions per scalar scenario
+    parameter NUM_CONV = 16;            // Descriptors per CONV/POOLING scenario
+    parameter MEM_LATENCY = 2;          // DDR request-to-response cycles
+    parameter SCENARIO_CYCLES = 2000000; // Per-scenario cycle limit
+
+    localparam WORDS_PER_BEAT = PCIE_DATA_WIDTH / DATA_WIDTH;
+
+    // Instruction opcodes (must match DUT)
+    localparam OP_ADD      = 8'h01;
+    localparam OP_SUB      = 8'h02;
+    localparam OP_MUL      = 8'h03;
+    localparam OP_MAC      = 8'h04;
+    localparam OP_CONV     = 8'h05;
+    localparam OP_RELU     = 8'h07;
+    localparam OP_SIGMOID  = 8'h08;
+    localparam OP_POOLING  = 8'h09;
+    localparam OP_TANH     = 8'h0B;
+    localparam OP_LOAD     = 8'h10;
+    localparam OP_STORE    = 8'h11;
+    localparam EPI_RELU    = 8'h20;     // ReLU epilogue, opcode bits [7:5] = 1
+
+    // DUT signals
+    reg clk;
+    reg rst_n;
+
+    // PCIe Interface
+    reg pcie_clk;
+    reg pcie_rst_n;
+    reg [PCIE_DATA_WIDTH-1:0] pcie_rx_data;
+    reg [WORDS_PER_BEAT-1:0] pcie_rx_keep;
+    reg pcie_rx_valid;
+    wire pcie_rx_ready;
+    wire [PCIE_DATA_WIDTH-1:0] pcie_tx_data;
+    wire [WORDS_PER_BEAT-1:0] pcie_tx_keep;
+    wire pcie_tx_valid;
+    reg pcie_tx_ready;
+
+    // Memory Interface (DDR4)
+    wire [ADDR_WIDTH-1:0] mem_addr;
+    wire [DATA_WIDTH-1:0] mem_wdata;
+    reg [DATA_WIDTH-1:0] mem_rdata;
+    wire mem_we;
+    wire mem_re;
+    reg mem_valid;
+
+    // Performance monitor and per-core status
+    reg perf_clear;
+    wire [63:0] perf_macs_nominal;
+    wire [CORE_COUNT-1:0] core_busy;
+
+    // Completion ring
+    reg cq_enable;
+    reg [15:0] cq_head;
+    wire [15:0] cq_tail;
+    wire cq_wr_valid;
+
+    // Test variables
+    reg [DATA_WIDTH-1:0] memory [0:65535];  // DDR4 memory model
+    reg [DATA_WIDTH-1:0] stream [$];        // Words of the current scenario
+    integer stream_insts;                   // Instructions in stream
+    integer test_case;
+    integer error_count;
+    integer bench_fd;
+    reg tx_throttle;
+    integer mem_wait;
+
+    // Counters (free-running; scenarios take differences)
+    longint cycle;
+    longint rx_words, tx_words, cq_records, mem_accesses, busy_core_cycles;
+    longint rx_fifo_wr, rx_fifo_rd, tx_fifo_wr, tx_fifo_rd;
+    longint rx_fifo_sum, tx_fifo_sum, rx_fifo_peak, tx_fifo_peak;
+    longint last_result_cycle;
+
+    // DUT instantiation
+    npu_top #(
+        .DATA_WIDTH(DATA_WIDTH),
+        .ADDR_WIDTH(ADDR_WIDTH),
+        .PE_COUNT(PE_COUNT),
+        .PCIE_DATA_WIDTH(PCIE_DATA_WIDTH),
+        .CORE_COUNT(CORE_COUNT)
+    ) dut (
+        .clk(clk),
+        .rst_n(rst_n),
+
+        .pcie_clk(pcie_clk),
+        .pcie_rst_n(pcie_rst_n),
+        .pcie_rx_data(pcie_rx_data),
+        .pcie_rx_keep(pcie_rx_keep),
+        .pcie_rx_valid(pcie_rx_valid),
+        .pcie_rx_ready(pcie_rx_ready),
+        .pcie_tx_data(pcie_tx_data),
+        .pcie_tx_keep(pcie_tx_keep),
+        .pcie_tx_valid(pcie_tx_valid),
+        .pcie_tx_ready(pcie_tx_ready),
+
+        .mem_addr(mem_addr),
+        .mem_wdata(mem_wdata),
+        .mem_rdata(mem_rdata),
+        .mem_we(mem_we),
+        .mem_re(mem_re),
+        .mem_valid(mem_valid),
+
+        .status_leds(),
+        .dip_switches(8'h00),
+
+        .pe_enable_mask({PE_COUNT{1'b1}}),
+
+        .perf_clear(perf_clear),
+        .perf_macs_nominal(perf_macs_nominal),
+        .perf_macs_skipped(),
+        .perf_mult_gated(),
+
+        .core_status(),
+        .core_busy(core_busy),
+        .core_inst_count(),
+        .core_busy_cycles(),
+
+        .cq_enable(cq_enable),
+        .cq_base(64'h0000_0001_0000_0000),
+        .cq_entries(16'd64),
+        .cq_head(cq_head),
+        .cq_tail(cq_tail),
+        .cq_seq(),
+        .cq_wr_addr(),
+        .cq_wr_data(),
+        .cq_wr_valid(cq_wr_valid),
+        .cq_wr_ready(1'b1),
+        .cq_irq()
+    );
+
+    // Clock generation
+    initial begin
+        clk = 0;
+        forever #5 clk = ~clk;  // 100MHz NPU clock
+    end
+
+    initial begin
+        pcie_clk = 0;
+        forever #4 pcie_clk = ~pcie_clk;  // 125MHz PCIe clock
+    end
+
+    // Reset generation
+    initial begin
+        rst_n = 0;
+        pcie_rst_n = 0;
+        #200;
+        rst_n = 1;
+        pcie_rst_n = 1;
+    end
+
+    // DDR4 memory model: fixed latency, one access at a time
+    always @(posedge clk) begin
+        mem_valid <= 1'b0;
+        if (!rst_n) begin
+            mem_wait <= 0;
+        end else if ((mem_re || mem_we) && !mem_valid) begin
+            if (mem_wait >= MEM_LATENCY - 1) begin
+                if (mem_we) begin
+                    memory[mem_addr[15:0]] <= mem_wdata;
+                end
+                mem_rdata <= memory[mem_addr[15:0]];
+                mem_valid <= 1'b1;
+                mem_wait <= 0;
+            end else begin
+                mem_wait <= mem_wait + 1;
+            end
+        end
+    end
+
+    // Host drains the completion ring as fast as records arrive
+    always @(posedge clk) begin
+        cq_head <= rst_n ? cq_tail : 16'h0;
+    end
+
+    // Host TX back-pressure: ready every other PCIe cycle when throttled
+    always @(posedge pcie_clk) begin
+        pcie_tx_ready <= tx_throttle ? !pcie_tx_ready : 1'b1;
+    end
+
+    // Core-clock counters
+    always @(posedge clk) begin
+        longint rx_occ, tx_occ;
+        cycle <= cycle + 1;
+        if (mem_valid) mem_accesses <= mem_accesses + 1;
+        if (cq_wr_valid) cq_records <= cq_records + 1;
+        busy_core_cycles <= busy_core_cycles + $countones(core_busy);
+        if (dut.u_pcie_controller.rx_fifo_rd_en) rx_fifo_rd <= rx_fifo_rd + 1;
+        if (dut.u_pcie_controller.tx_fifo_wr_en) tx_fifo_wr <= tx_fifo_wr + 1;
+
+        rx_occ = rx_fifo_wr - rx_fifo_rd;
+        tx_occ = tx_fifo_wr - tx_fifo_rd;
+        rx_fifo_sum <= rx_fifo_sum + rx_occ;
+        tx_fifo_sum <= tx_fifo_sum + tx_occ;
+        if (rx_occ > rx_fifo_peak) rx_fifo_peak <= rx_occ;
+        if (tx_occ > tx_fifo_peak) tx_fifo_peak <= tx_occ;
+    end
+
+    // PCIe-clock counters
+    always @(posedge pcie_clk) begin
+        if (dut.u_pcie_controller.rx_fifo_wr_en) rx_fifo_wr <= rx_fifo_wr + 1;
+        if (dut.u_pcie_controller.tx_fifo_rd_en) tx_fifo_rd <= tx_fifo_rd + 1;
+        if (pcie_rx_valid && pcie_rx_ready) rx_words <= rx_words + $countones(pcie_rx_keep);
+        if (pcie_tx_valid && pcie_tx_ready) begin
+            tx_words <= tx_words + $countones(pcie_tx_keep);
+            last_result_cycle <= cycle;
+        end
+    end
+
+    // Test stimulus
+    initial begin
+        string bench_out;
+
+        pcie_rx_data = 0;
+        pcie_rx_keep = 0;
+        pcie_rx_valid = 0;
+        pcie_tx_ready = 1;
+        perf_clear = 0;
+        cq_enable = 0;
+        tx_throttle = 0;
+        test_case = 0;
+        error_count = 0;
+        cycle = 0;
+        rx_words = 0;
+        tx_words = 0;
+        cq_records = 0;
+        mem_accesses = 0;
+        busy_core_cycles = 0;
+        rx_fifo_wr = 0;
+        rx_fifo_rd = 0;
+        tx_fifo_wr = 0;
+        tx_fifo_rd = 0;
+        rx_fifo_sum = 0;
+        tx_fifo_sum = 0;
+        rx_fifo_peak = 0;
+        tx_fifo_peak = 0;
+        last_result_cycle = 0;
+
+        initialize_memory();
+
+        if (!$value$plusargs("BENCH_OUT=%s", bench_out)) begin
+            bench_out = "npu_bench_results.csv";
+        end
+        bench_fd = $fopen(bench_out, "w");
+        if (bench_fd == 0) begin
+            $error("Cannot open %s", bench_out);
+            $finish;
+        end
+        $fdisplay(bench_fd, "scenario,metric,value,better");
+
+        wait(rst_n && pcie_rst_n);
+        #500;
+
+        $display("Starting NPU Top Level Benchmark (%0d core(s), %0d PEs, %0d-bit PCIe)",
+                 CORE_COUNT, PE_COUNT, PCIE_DATA_WIDTH);
+
+        // Test Case 1: Scalar ALU stream
+        test_case = 1;
+        $display("Test Case 1: ALU Stream");
+        build_alu();
+        run_scenario("alu_stream");
+
+        // Test Case 2: Mixed ALU, activation and memory instructions
+        test_case = 2;
+        $display("Test Case 2: Mixed Instruction Stream");
+        build_mixed();
+        run_scenario("mixed_stream");
+
+        // Test Case 3: LOAD/STORE stream through the memory port
+        test_case = 3;
+        $display("Test Case 3: Memory Stream");
+        build_memory();
+        run_scenario("memory_stream");
+
+        // Test Case 4: Convolution descriptors on the PE array
+        test_case = 4;
+        $display("Test Case 4: Convolution Stream");
+        build_conv();
+        run_scenario("conv_stream");
+
+        // Test Case 5: Pooling descriptors
+        test_case = 5;
+        $display("Test Case 5: Pooling Stream");
+        build_pool();
+        run_scenario("pool_stream");
+
+        // Test Case 6: Host link at half rate with the completion ring on
+        test_case = 6;
+        $display("Test Case 6: Throttled Host Link with Completion Ring");
+        cq_enable = 1;
+        tx_throttle = 1;
+        build_mixed();
+        run_scenario("host_stream");
+        tx_throttle = 0;
+        cq_enable = 0;
+
+        $fclose(bench_fd);
+        $display("Results written to %s", bench_out);
+
+        if (error_count == 0) begin
+            $display("All tests completed successfully!");
+        end else begin
+            $display("Tests completed with %d errors", error_count);
+        end
+        $finish;
+    end
+
+    // Initialize memory with non-zero data so ZERO_SKIP does not shortcut convolutions
+    task initialize_memory();
+        integer i;
+        begin
+            for (i = 0; i < 65536; i++) begin
+                memory[i] = (i * 32'h9E3779B1) | 32'h1;
+            end
+        end
+    endtask
+
+    // Stream builders
+    task push_inst(input [7:0] opcode, input [7:0] a, input [7:0] b, input [7:0] c);
+        begin
+            stream.push_back({opcode, a, b, c});
+            stream_insts = stream_insts + 1;
+        end
+    endtask
+
+    task push_conv(input integer h, input integer w, input integer k,
+                   input integer in_c, input integer out_c);
+        begin
+            push_inst(OP_CONV, 8'h00, 8'h00, 8'h00);
+            stream.push_back(32'h0000);                    // input
+            stream.push_back(32'h4000);                    // weights
+            stream.push_back(32'h8000);                    // output
+            stream.push_back(out_c * h * w * 4);
+            stream.push_back(32'h0001_0001);               // stride 1
+            stream.push_back({16'(k / 2), 16'(k / 2)});    // same padding
+            stream.push_back({16'(h), 16'(w)});
+            stream.push_back({8'(k), 12'(in_c), 12'(out_c)});
+        end
+    endtask
+
+    task push_pool(input integer h, input integer w, input integer k, input integer c,
+                   input [7:0] mode);
+        begin
+            push_inst(OP_POOLING, 8'h00, 8'h00, 8'h00);
+            stream.push_back(32'h0000);
+            stream.push_back({16'(h), 16'(w)});
+            stream.push_back(32'h8000);
+            stream.push_back(c * h * w * 4);
+            stream.push_back({16'(k), 16'(k)});
+            stream.push_back({16'(k), 16'(k)});            // stride = kernel
+            stream.push_back(32'h0);
+            stream.push_back({12'h0, 12'(c), mode});
+        end
+    endtask
+
+    task clear_stream();
+        begin
+            stream.delete();
+            stream_insts = 0;
+        end
+    endtask
+
+    task build_alu();
+        integer i;
+        begin
+            clear_stream();
+            for (i = 0; i < NUM_INST; i++) begin
+                case (i % 4)
+                    0: push_inst(OP_ADD, i[7:0], 8'd3, 8'h00);
+                    1: push_inst(OP_MUL, i[7:0], 8'd5, 8'h00);
+                    2: push_inst(OP_MAC, i[7:0], 8'd7, 8'h00);
+                    3: push_inst(OP_SUB | EPI_RELU, i[7:0], 8'd9, 8'h00);
+                endcase
+            end
+        end
+    endtask
+
+    task build_mixed();
+        integer i;
+        begin
+            clear_stream();
+            for (i = 0; i < NUM_INST; i++) begin
+                case (i % 8)
+                    0: push_inst(OP_ADD, i[7:0], 8'd3, 8'h00);
+                    1: push_inst(OP_MUL, i[7:0], 8'd5, 8'h00);
+                    2: push_inst(OP_RELU, i[7:0], 8'h00, 8'h00);
+                    3: push_inst(OP_LOAD, i[7:0], 8'h00, 8'h00);
+                    4: push_inst(OP_MAC | EPI_RELU, i[7:0], 8'd7, 8'h00);
+                    5: push_inst(OP_SIGMOID, i[7:0], 8'h00, 8'h00);
+                    6: push_inst(OP_STORE, i[7:0], 8'h00, 8'h80 + i[6:0]);
+                    7: push_inst(OP_TANH, i[7:0], 8'h00, 8'h00);
+                endcase
+            end
+        end
+    endtask
+
+    task build_memory();
+        integer i;
+        begin
+            clear_stream();
+            for (i = 0; i < NUM_INST; i++) begin
+                if (i % 2 == 0) begin
+                    push_inst(OP_STORE, i[7:0], 8'h00, i[7:0]);
+                end else begin
+                    push_inst(OP_LOAD, i[7:0] - 8'd1, 8'h00, 8'h00);
+                end
+            end
+        end
+    endtask
+
+    task build_conv();
+        integer i;
+        begin
+            clear_stream();
+            for (i = 0; i < NUM_CONV; i++) begin
+                push_conv(8, 8, 3, 4, PE_COUNT);
+            end
+        end
+    endtask
+
+    task build_pool();
+        integer i;
+        begin
+            clear_stream();
+            for (i = 0; i < NUM_CONV; i++) begin
+                push_pool(16, 16, 2, 4, i[1:0] == 0 ? 8'd1 : 8'd0);
+            end
+        end
+    endtask
+
+    // Stream the scenario words back to back, WORDS_PER_BEAT per beat
+    task stream_words();
+        integer idx, k;
+        begin
+            idx = 0;
+            while (idx < stream.size()) begin
+                for (k = 0; k < WORDS_PER_BEAT; k++) begin
+                    pcie_rx_data[DATA_WIDTH*k +: DATA_WIDTH] <= (idx + k < stream.size()) ? stream[idx + k] : 0;
+                    pcie_rx_keep[k] <= (idx + k < stream.size());
+                end
+                pcie_rx_valid <= 1'b1;
+                do @(posedge pcie_clk); while (!pcie_rx_ready);
+                idx = idx + WORDS_PER_BEAT;
+            end
+            pcie_rx_valid <= 1'b0;
+            pcie_rx_keep <= 0;
+        end
+    endtask
+
+    // Run the current stream and emit its metrics
+    task run_scenario(input string name);
+        longint c0, rx0, tx0, cq0, mem0, busy0, rxs0, txs0, cycles;
+        reg [63:0] macs0;
+        real ipc, macs_pc;
+        begin
+            // Start from idle FIFOs and fresh peaks
+            @(posedge clk);
+            perf_clear <= 1'b1;
+            @(posedge clk);
+            perf_clear <= 1'b0;
+            @(posedge clk);
+            rx_fifo_peak = 0;
+            tx_fifo_peak = 0;
+            c0 = cycle;
+            rx0 = rx_words;
+            tx0 = tx_words;
+            cq0 = cq_records;
+            mem0 = mem_accesses;
+            busy0 = busy_core_cycles;
+            rxs0 = rx_fifo_sum;
+            txs0 = tx_fifo_sum;
+            macs0 = perf_macs_nominal;
+
+            @(posedge pcie_clk);
+            stream_words();
+
+            // Every instruction in these mixes returns one result word
+            while (tx_words - tx0 < stream_insts && cycle - c0 < SCENARIO_CYCLES) begin
+                @(posedge clk);
+            end
+            if (tx_words - tx0 < stream_insts) begin
+                $error("%s: %0d of %0d results after %0d cycles", name,
+                       tx_words - tx0, stream_insts, SCENARIO_CYCLES);
+                error_count = error_count + 1;
+            end
+            if (cq_enable && cq_records - cq0 != tx_words - tx0) begin
+                $error("%s: %0d completion records for %0d results", name,
+                       cq_records - cq0, tx_words - tx0);
+                error_count = error_count + 1;
+            end
+
+            cycles = last_result_cycle - c0;
+            if (cycles < 1) cycles = 1;
+            ipc = $itor(stream_insts) / $itor(cycles);
+            macs_pc = $itor(perf_macs_nominal - macs0) / $itor(cycles);
+
+            emit(name, "cycles", $itor(cycles), "lower");
+            emit(name, "instructions", $itor(stream_insts), "none");
+            emit(name, "inst_per_cycle", ipc, "higher");
+            emit(name, "macs_per_cycle", macs_pc, "higher");
+            emit(name, "pe_utilisation", macs_pc / (PE_COUNT * CORE_COUNT), "higher");
+            emit(name, "core_busy", $itor(busy_core_cycles - busy0) / $itor(cycles * CORE_COUNT), "none");
+            emit(name, "rx_fifo_avg", $itor(rx_fifo_sum - rxs0) / $itor(cycles), "none");
+            emit(name, "rx_fifo_peak", $itor(rx_fifo_peak), "none");
+            emit(name, "tx_fifo_avg", $itor(tx_fifo_sum - txs0) / $itor(cycles), "none");
+            emit(name, "tx_fifo_peak", $itor(tx_fifo_peak), "none");
+            emit(name, "rx_bytes_per_cycle", $itor((rx_words - rx0) * 4) / $itor(cycles), "higher");
+            emit(name, "tx_bytes_per_cycle", $itor((tx_words - tx0) * 4) / $itor(cycles), "higher");
+            emit(name, "cq_bytes_per_cycle", $itor((cq_records - cq0) * 16) / $itor(cycles), "higher");
+            emit(name, "mem_access_per_cycle", $itor(mem_accesses - mem0) / $itor(cycles), "none");
+
+            $display("  %s: %0d instructions in %0d cycles, %0.3f inst/cycle, %0.2f MACs/cycle",
+                     name, stream_insts, cycles, ipc, macs_pc);
+            $display("  ✓ %s completed", name);
+        end
+    endtask
+
+    task emit(input string scenario, input string metric, input real value, input string better);
+        begin
+            $fdisplay(bench_fd, "%s,%s,%0.6f,%s", scenario, metric, value, better);
+            $display("BENCH %s %s %0.6f", scenario, metric, value);
+        end
+    endtask
+
+    // Simulation timeout
+    initial begin
+        #200000000;  // 200ms timeout
+        $error("Simulation timeout!");
+        $finish;
+    end
+
+endmodule
@@ -0,0 +1,410 @@
+/**
+ * NPU Cluster Testbench
+ *
+ * Testbench for npu_cluster.sv (work_distributor.sv, mem_arbiter.sv)
+ * Builds one cluster per core count from 1 to MAX_CORES, runs the same
+ * compute-bound instruction stream through each and checks results,
+ * per-core counters, ROUTE targeting, memory arbitration, and near-linear
+ * throughput scaling with the number of cores
+ */
+
+`timescale 1ns / 1ps
+
+module npu_cluster_tb();
+
+    // Parameters
+    parameter DATA_WIDTH = 32;
+    parameter ADDR_WIDTH = 32;
+    parameter PE_COUNT = 4;
+    parameter MAX_CORES = 4;
+    parameter NUM_INST = 256;
+    parameter real MIN_SCALING = 0.9;   // Required speedup per core vs. one core
+
+    // Instruction opcodes (must match DUT)
+    localparam OP_ADD      = 8'h01;
+    localparam OP_SUB      = 8'h02;
+    localparam OP_MUL      = 8'h03;
+    localparam OP_LOAD     = 8'h10;
+    localparam OP_STORE    = 8'h11;
+    localparam OP_ROUTE    = 8'h1F;
+    localparam EPI_RELU    = 8'h20;     // ReLU epilogue, opcode bits [7:5] = 1
+    localparam CORE_ANY    = 8'hFF;
+
+    reg clk;
+    reg rst_n;
+
+    // Test variables
+    integer test_case;
+    integer error_count;
+    integer sys_cycles [MAX_CORES];
+    reg [MAX_CORES-1:0] sys_done;
+
+    // Clock generation
+    initial begin
+        clk = 0;
+        forever #5 clk = ~clk;  // 100MHz
+    end
+
+    // Reset generation
+    initial begin
+        rst_n = 0;
+        #100;
+        rst_n = 1;
+        #50;
+    end
+
+    // Workload: instruction i and its expected result
+    function automatic [DATA_WIDTH-1:0] workload_inst(input integer i);
+        reg [7:0] a, b, op;
+        begin
+            a = (i * 37 + 11) & 8'hFF;
+            b = (i * 101 + 7) & 8'hFF;
+            case (i % 4)
+                0: op = OP_ADD;
+                1: op = OP_SUB | EPI_RELU;
+                2: op = OP_MUL;
+                default: op = OP_ADD | EPI_RELU;
+            endcase
+            workload_inst = {op, a, b, 8'h00};
+        end
+    endfunction
+
+    function automatic [DATA_WIDTH-1:0] workload_result(input integer i);
+        reg [DATA_WIDTH-1:0] a, b;
+        begin
+            a = (i * 37 + 11) & 8'hFF;
+            b = (i * 101 + 7) & 8'hFF;
+            case (i % 4)
+                0: workload_result = a + b;
+                1: workload_result = (a > b) ? a - b : 0;
+                2: workload_result = a * b;
+                default: workload_result = a + b;
+            endcase
+        end
+    endfunction
+
+    // One cluster per core count
+    genvar g;
+    generate
+        for (g = 0; g < MAX_CORES; g++) begin : sys
+            localparam CORES = g + 1;
+
+            // DUT signals
+            reg [DATA_WIDTH-1:0] host_data_in;
+            reg host_data_in_valid;
+            wire host_data_in_ready;
+            wire [DATA_WIDTH-1:0] host_data_out;
+            wire host_data_out_valid;
+
+            wire [ADDR_WIDTH-1:0] mem_addr;
+            wire [DATA_WIDTH-1:0] mem_wdata;
+            reg [DATA_WIDTH-1:0] mem_rdata;
+            wire mem_we;
+            wire mem_re;
+            reg mem_valid;
+
+            wire [CORES*4-1:0] core_status;
+            wire [CORES-1:0] core_busy;
+            wire [CORES*32-1:0] core_inst_count;
+            wire [CORES*32-1:0] core_busy_cycles;
+
+            reg perf_clear;
+            reg [DATA_WIDTH-1:0] memory [0:255];
+
+            // Result collection (order-independent: results return in completion order)
+            integer received;
+            reg [63:0] result_sum;
+            reg [63:0] result_sumsq;
+            reg [DATA_WIDTH-1:0] last_result;
+
+            integer cycles;
+            integer i, c, total;
+            reg [63:0] expected_sum;
+            reg [63:0] expected_sumsq;
+            reg [DATA_WIDTH-1:0] expected;
+
+            npu_cluster #(
+                .DATA_WIDTH(DATA_WIDTH),
+                .ADDR_WIDTH(ADDR_WIDTH),
+                .PE_COUNT(PE_COUNT),
+                .CORE_COUNT(CORES)
+            ) dut (
+                .clk(clk),
+                .rst_n(rst_n),
+
+                .host_data_in(host_data_in),
+                .host_data_in_valid(host_data_in_valid),
+                .host_data_in_ready(host_data_in_ready),
+
+                .host_data_out(host_data_out),
+                .host_data_out_valid(host_data_out_valid),
+                .host_data_out_ready(1'b1),
+                .host_data_out_core(),
+                .host_data_out_opcode(),
+                .host_data_out_cycles(),
+
+                .pe_enable_mask({PE_COUNT{1'b1}}),
+
+                .mem_addr(mem_addr),
+                .mem_wdata(mem_wdata),
+                .mem_rdata(mem_rdata),
+                .mem_we(mem_we),
+                .mem_re(mem_re),
+                .mem_valid(mem_valid),
+
+                .perf_clear(perf_clear),
+                .perf_macs_nominal(),
+                .perf_macs_skipped(),
+                .perf_mult_gated(),
+
+                .core_status(core_status),
+                .core_busy(core_busy),
+                .core_inst_count(core_inst_count),
+                .core_busy_cycles(core_busy_cycles)
+            );
+
+            // Memory model, responds in the next cycle
+            always @(posedge clk) begin
+                if (mem_we && mem_addr < 256) begin
+                    memory[mem_addr] <= mem_wdata;
+                end
+                if (mem_re && mem_addr < 256) begin
+                    mem_rdata <= memory[mem_addr];
+                end else begin
+                    mem_rdata <= 32'hDEADDEAD;
+                end
+                mem_valid <= mem_we || mem_re;
+            end
+
+            always @(posedge clk) begin
+                if (host_data_out_valid) begin
+                    received <= received + 1;
+                    result_sum <= result_sum + host_data_out;
+                    result_sumsq <= result_sumsq + host_data_out * host_data_out;
+                    last_result <= host_data_out;
+                end
+            end
+
+            // Helper task: Push one word into the shared queue
+            task send_word(input [DATA_WIDTH-1:0] word);
+                begin
+                    host_data_in = word;
+                    host_data_in_valid = 1;
+                    #1;
+                    while (!host_data_in_ready) begin
+                        @(posedge clk);
+                        #1;
+                    end
+                    @(posedge clk);
+                    #1;
+                    host_data_in_valid = 0;
+                end
+            endtask
+
+            task clear_results();
+                begin
+                    @(posedge clk);
+                    #1;
+                    received = 0;
+                    result_sum = 0;
+                    result_sumsq = 0;
+                end
+            endtask
+
+            task wait_results(input integer count);
+                begin
+                    while (received < count) @(posedge clk);
+                    #1;
+                end
+            endtask
+
+            // Load-balanced throughput run
+            task run_workload();
+                begin
+                    expected_sum = 0;
+                    expected_sumsq = 0;
+                    clear_results();
+                    perf_clear = 1;
+                    @(posedge clk);
+                    #1;
+                    perf_clear = 0;
+
+                    cycles = 0;
+                    fork
+                        begin
+                            for (i = 0; i < NUM_INST; i++) begin
+                                send_word(workload_inst(i));
+                                expected = workload_result(i);
+                                expected_sum = expected_sum + expected;
+                                expected_sumsq = expected_sumsq + expected * expected;
+                            end
+                        end
+                        begin
+                            while (received < NUM_INST) begin
+                                @(posedge clk);
+                                cycles = cycles + 1;
+                            end
+                        end
+                    join
+                    #1;
+
+                    if (result_sum !== expected_sum || result_sumsq !== expected_sumsq) begin
+                        $error("%0d cores: result checksum %0d/%0d, expected %0d/%0d", CORES,
+                               result_sum, result_sumsq, expected_sum, expected_sumsq);
+                        error_count = error_count + 1;
+                    end
+
+                    // Every core took work and the counters add up
+                    total = 0;
+                    for (c = 0; c < CORES; c++) begin
+                        total = total + core_inst_count[c*32 +: 32];
+                        if (core_inst_count[c*32 +: 32] == 0) begin
+                            $error("%0d cores: core %0d received no instructions", CORES, c);
+                            error_count = error_count + 1;
+                        end
+                        if (core_busy_cycles[c*32 +: 32] == 0 || core_busy_cycles[c*32 +: 32] > cycles + 4) begin
+                            $error("%0d cores: core %0d busy for %0d of %0d cycles", CORES, c,
+                                   core_busy_cycles[c*32 +: 32], cycles);
+                            error_count = error_count + 1;
+                        end
+                    end
+                    if (total != NUM_INST) begin
+                        $error("%0d cores: per-core instruction counts sum to %0d, expected %0d",
+                               CORES, total, NUM_INST);
+                        error_count = error_count + 1;
+                    end
+                end
+            endtask
+
+            // ROUTE prefix pins the next instruction to one core
+            task run_routing();
+                reg [31:0] before;
+                begin
+                    for (c = 0; c < CORES; c++) begin
+                        before = core_inst_count[c*32 +: 32];
+                        clear_results();
+                        send_word({OP_ROUTE, c[7:0], 16'h0000});
+                        send_word({OP_ADD, 8'd40, c[7:0], 8'h00});
+                        wait_results(1);
+                        if (last_result !== 40 + c) begin
+                            $error("%0d cores: routed ADD on core %0d returned %0d", CORES, c, last_result);
+                            error_count = error_count + 1;
+                        end
+                        if (core_inst_count[c*32 +: 32] != before + 1) begin
+                            $error("%0d cores: ROUTE to core %0d not honoured", CORES, c);
+                            error_count = error_count + 1;
+                        end
+                    end
+
+                    // CORE_ANY falls back to load balancing
+                    clear_results();
+                    send_word({OP_ROUTE, CORE_ANY, 16'h0000});
+                    send_word({OP_MUL, 8'd6, 8'd7, 8'h00});
+                    wait_results(1);
+                    if (last_result !== 42) begin
+                        $error("%0d cores: MUL after ROUTE(ANY) returned %0d", CORES, last_result);
+                        error_count = error_count + 1;
+                    end
+                end
+            endtask
+
+            // Concurrent stores through the memory arbiter, then read back
+            task run_memory();
+                begin
+                    clear_results();
+                    for (i = 0; i < 16; i++) begin
+                        send_word({OP_STORE, 8'h40 + i[7:0], 8'h00, 8'h80 + i[7:0]});
+                    end
+                    wait_results(16);   // Host orders loads after their stores
+
+                    clear_results();
+                    expected_sum = 0;
+                    for (i = 0; i < 16; i++) begin
+                        send_word({OP_LOAD, 8'h80 + i[7:0], 8'h00, 8'h00});
+                        expected_sum = expected_sum + 8'h40 + i;
+                    end
+                    wait_results(16);
+                    if (result_sum !== expected_sum) begin
+                        $error("%0d cores: load-back sum %0d, expected %0d", CORES, result_sum, expected_sum);
+                        error_count = error_count + 1;
+                    end
+                end
+            endtask
+
+            initial begin
+                host_data_in = 0;
+                host_data_in_valid = 0;
+                perf_clear = 0;
+                received = 0;
+                result_sum = 0;
+                result_sumsq = 0;
+                last_result = 0;
+                sys_done[g] = 1'b0;
+
+                wait(rst_n);
+                #200;
+                @(posedge clk);
+                #1;
+
+                run_workload();
+                sys_cycles[g] = cycles;
+                run_routing();
+                run_memory();
+                sys_done[g] = 1'b1;
+            end
+        end
+    endgenerate
+
+    // Test stimulus
+    initial begin
+        test_case = 0;
+        error_count = 0;
+
+        wait(rst_n);
+        $display("Starting NPU Cluster Testbench");
+
+        // Test Cases 1-3 run concurrently in every cluster
+        test_case = 1;
+        $display("Test Case 1: Load-Balanced Workload (%0d instructions)", NUM_INST);
+        $display("Test Case 2: ROUTE Targeting");
+        $display("Test Case 3: Shared Memory Arbitration");
+        wait(&sys_done);
+
+        // Test Case 4: Throughput scaling
+        test_case = 4;
+        $display("Test Case 4: Throughput Scaling");
+        check_scaling();
+
+        if (error_count == 0) begin
+            $display("All tests completed successfully!");
+        end else begin
+            $display("Tests completed with %d errors", error_count);
+        end
+        $finish;
+    end
+
+    task check_scaling();
+        integer n;
+        real speedup;
+        begin
+            for (n = 1; n <= MAX_CORES; n++) begin
+                speedup = $itor(sys_cycles[0]) / $itor(sys_cycles[n-1]);
+                $display("  %0d core(s): %0d cycles, %0.3f inst/cycle, speedup %0.2fx",
+                         n, sys_cycles[n-1], $itor(NUM_INST) / $itor(sys_cycles[n-1]), speedup);
+                if (speedup < MIN_SCALING * n) begin
+                    $error("Speedup %0.2fx with %0d cores is below %0.2fx", speedup, n, MIN_SCALING * n);
+                    error_count = error_count + 1;
+                end
+            end
+            $display("  ✓ Throughput scaling completed");
+        end
+    endtask
+
+    // Simulation timeout
+    initial begin
+        #1000000;  // 1ms timeout
+        $error("Simulation timeout!");
+        $finish;
+    end
+
+endmodule
@@ -38,6 +38,16 @@ module npu_core_tb();
     // Status
     wire [3:0] status;
     
+    // PE gating (ROUTE prefix partition and REG_CONFIG enable mask)
+    reg [PE_COUNT-1:0] host_pe_mask;
+    reg [PE_COUNT-1:0] pe_enable_mask;
+    
+    // Performance monitor
+    reg perf_clear;
+    wire [63:0] perf_macs_nominal;
+    wire [63:0] perf_macs_skipped;
+    wire [63:0] perf_mult_gated;
+    
     // Test variables
     reg [DATA_WIDTH-1:0] instruction;
     reg [DATA_WIDTH-1:0] expected_result;
@@ -51,9 +61,18 @@ module npu_core_tb();
     localparam OP_SUB = 8'h02;
     localparam OP_MUL = 8'h03;
     localparam OP_MAC = 8'h04;
+    localparam OP_MATMUL = 8'h06;
+    localparam OP_RELU = 8'h07;
+    localparam OP_SIGMOID = 8'h08;
+    localparam OP_TANH = 8'h0B;
     localparam OP_LOAD = 8'h10;
     localparam OP_STORE = 8'h11;
     
+    // Fused activation epilogue, opcode bits [7:5] (must match DUT)
+    localparam EPI_RELU = 8'h20;
+    localparam EPI_LEAKY_RELU = 8'h40;
+    localparam EPI_SIGMOID = 8'h60;
+    
     // DUT instantiation
     npu_core #(
         .DATA_WIDTH(DATA_WIDTH),
@@ -66,6 +85,7 @@ module npu_core_tb();
         .host_data_in(host_data_in),
         .host_data_in_valid(host_data_in_valid),
         .host_data_in_ready(host_data_in_ready),
+        .host_pe_mask(host_pe_mask),
         
         .host_data_out(host_data_out),
         .host_data_out_valid(host_data_out_valid),
@@ -76,7 +96,15 @@ module npu_core_tb();
         .mem_rdata(mem_rdata),
         .mem_we(mem_we),
         .mem_re(mem_re),
-        .mem_valid(mem_valid)
+        .mem_valid(mem_valid),
+        
+        .status(status),
+        .pe_enable_mask(pe_enable_mask),
+        
+        .perf_clear(perf_clear),
+        .perf_macs_nominal(perf_macs_nominal),
+        .perf_macs_skipped(perf_macs_skipped),
+        .perf_mult_gated(perf_mult_gated)
     );
     
     // Clock generation
@@ -117,6 +145,9 @@ module npu_core_tb();
         host_data_in = 0;
         host_data_in_valid = 0;
         host_data_out_ready = 1;
+        host_pe_mask = {PE_COUNT{1'b1}};
+        pe_enable_mask = {PE_COUNT{1'b1}};
+        perf_clear = 0;
         test_case = 0;
         error_count = 0;
         cycle_count = 0;
@@ -165,6 +196,26 @@ module npu_core_tb();
         $display("Test Case 7: Backpressure Handling");
         test_backpressure();
         
+        // Test Case 8: Activation functions and fused epilogues
+        test_case = 8;
+        $display("Test Case 8: Activation Functions");
+        test_activation();
+        
+        // Test Case 9: Zero-operand skip counters
+        test_case = 9;
+        $display("Test Case 9: Zero-Skip Counters");
+        test_zero_skip_counters();
+        
+        // Test Case 10: Run-time PE gating and partitions
+        test_case = 10;
+        $display("Test Case 10: PE Gating");
+        test_pe_gating();
+        
+        // Test Case 11: Matrix multiplication with a fused epilogue
+        test_case = 11;
+        $display("Test Case 11: Matrix Multiplication");
+        test_matmul();
+        
         if (error_count == 0) begin
             $display("All tests completed successfully!");
             $display("Total cycles: %d", cycle_count);
@@ -367,6 +418,182 @@ module npu_core_tb();
         end
     endtask
     
+    // Test activation instructions and fused epilogues
+    task test_activation();
+        begin
+            $display("  Testing fused leaky ReLU epilogue (default alpha)");
+            execute_instruction({OP_SUB | EPI_LEAKY_RELU, 8'd0, 8'd128, 8'd0}, 32'hFFFF_FFFE);  // -128 * 0.01
+            
+            $display("  Testing fused ReLU epilogue");
+            execute_instruction({OP_ADD | EPI_RELU, 8'd100, 8'd200, 8'd0}, 32'd300);
+            execute_instruction({OP_SUB | EPI_RELU, 8'd10, 8'd20, 8'd0}, 32'd0);
+            
+            $display("  Testing fused sigmoid epilogue");
+            execute_instruction({OP_SUB | EPI_SIGMOID, 8'd5, 8'd5, 8'd0}, 32'h0000_8000);  // sigmoid(0) = 0.5
+            
+            $display("  Testing stand-alone activations");
+            execute_instruction({OP_RELU, 8'd50, 8'd0, 8'd0}, 32'd50);
+            execute_instruction({OP_SIGMOID, 8'd0, 8'd0, 8'd0}, 32'h0000_8000);
+            execute_instruction({OP_TANH, 8'd0, 8'd0, 8'd0}, 32'h0000_0000);
+            
+            $display("  ✓ Activation tests completed");
+        end
+    endtask
+    
+    // Test that zero-operand MACs are skipped and counted by the PMU
+    task test_zero_skip_counters();
+        begin
+            @(posedge clk);
+            perf_clear = 1;
+            @(posedge clk);
+            perf_clear = 0;
+            
+            execute_instruction({OP_ADD, 8'd0, 8'd0, 8'd0}, 32'd0);     // Clear result
+            execute_instruction({OP_MAC, 8'd0, 8'd5, 8'd0}, 32'd0);     // Zero operand
+            execute_instruction({OP_MAC, 8'd3, 8'd4, 8'd0}, 32'd12);
+            execute_instruction({OP_MAC, 8'd7, 8'd0, 8'd0}, 32'd12);    // Zero operand
+            repeat (4) @(posedge clk);
+            
+            if (perf_macs_nominal !== 3 * PE_COUNT) begin
+                $error("Nominal MACs: expected %0d, got %0d", 3 * PE_COUNT, perf_macs_nominal);
+                error_count = error_count + 1;
+            end
+            if (perf_macs_skipped !== 2 * PE_COUNT) begin
+                $error("Skipped MACs: expected %0d, got %0d", 2 * PE_COUNT, perf_macs_skipped);
+                error_count = error_count + 1;
+            end
+            if (perf_mult_gated !== 2 * PE_COUNT) begin
+                $error("Gated multiplier cycles: expected %0d, got %0d", 2 * PE_COUNT, perf_mult_gated);
+                error_count = error_count + 1;
+            end
+            $display("  ✓ %0d of %0d MACs skipped, %0d multiplier cycles gated",
+                     perf_macs_skipped, perf_macs_nominal, perf_mult_gated);
+        end
+    endtask
+    
+    task test_pe_gating();
+        begin
+            // Half the array disabled through REG_CONFIG
+            pe_enable_mask = {{(PE_COUNT/2){1'b0}}, {(PE_COUNT/2){1'b1}}};
+            @(posedge clk);
+            perf_clear = 1;
+            @(posedge clk);
+            perf_clear = 0;
+            
+            execute_instruction({OP_ADD, 8'd0, 8'd0, 8'd0}, 32'd0);     // Clear result
+            execute_instruction({OP_MAC, 8'd3, 8'd4, 8'd0}, 32'd12);
+            repeat (4) @(posedge clk);
+            
+            if (perf_macs_nominal !== PE_COUNT / 2) begin
+                $error("Gated array MACs: expected %0d, got %0d", PE_COUNT / 2, perf_macs_nominal);
+                error_count = error_count + 1;
+            end
+            if (perf_mult_gated !== PE_COUNT / 2) begin
+                $error("Gated array cycles: expected %0d, got %0d", PE_COUNT / 2, perf_mult_gated);
+                error_count = error_count + 1;
+            end
+            $display("  ✓ REG_CONFIG mask: %0d MACs issued, %0d PEs gated",
+                     perf_macs_nominal, perf_mult_gated);
+            
+            // A partition mask narrows the enabled set further
+            host_pe_mask = {{(PE_COUNT-2){1'b0}}, 2'b11};
+            @(posedge clk);
+            perf_clear = 1;
+            @(posedge clk);
+            perf_clear = 0;
+            
+            execute_instruction({OP_MAC, 8'd2, 8'd5, 8'd0}, 32'd22);
+            repeat (4) @(posedge clk);
+            
+            if (perf_macs_nominal !== 2 || perf_mult_gated !== PE_COUNT - 2) begin
+                $error("Partition: expected 2 MACs / %0d gated, got %0d / %0d",
+                       PE_COUNT - 2, perf_macs_nominal, perf_mult_gated);
+                error_count = error_count + 1;
+            end else begin
+                $display("  ✓ Partition mask: %0d MACs issued, %0d PEs gated",
+                         perf_macs_nominal, perf_mult_gated);
+            end
+            
+            host_pe_mask = {PE_COUNT{1'b1}};
+            pe_enable_mask = {PE_COUNT{1'b1}};
+        end
+    endtask
+    
+    // C[2x4] = relu(A[2x3] x B[3x4]) through the convolution engine
+    task test_matmul();
+        integer i;
+        reg [DATA_WIDTH-1:0] a [0:5];
+        reg [DATA_WIDTH-1:0] b [0:11];
+        reg [DATA_WIDTH-1:0] c [0:7];
+        begin
+            a = '{1, 2, 3, 4, 5, 6};
+            b = '{1, 0, -3, 2, 0, 1, 1, -2, 1, 1, 0, 1};
+            c = '{4, 5, 0, 1, 10, 11, 0, 4};    // Column 2 is negative before the ReLU
+            
+            // Byte addresses, one word per element (the memory model is word-indexed)
+            for (i = 0; i < 6; i++) memory[32'h000 + 4 * i] = a[i];
+            for (i = 0; i < 12; i++) memory[32'h100 + 4 * i] = b[i];
+            
+            send_word({OP_MATMUL | EPI_RELU, 8'h00, 8'h00, 8'h00});
+            send_word(32'h000);             // A
+            send_word(32'h100);             // B
+            send_word(32'h200);             // C
+            send_word(32'd32);              // size
+            send_word(32'd2);               // M
+            send_word(32'd3);               // K
+            send_word(32'd4);               // N
+            send_word(32'd0);
+            
+            while (!host_data_out_valid) @(posedge clk);
+            if (host_data_out !== 32'd0) begin
+                $error("MATMUL rejected: result %h", host_data_out);
+                error_count = error_count + 1;
+            end
+            @(posedge clk);
+            
+            for (i = 0; i < 8; i++) begin
+                if (memory[32'h200 + 4 * i] !== c[i]) begin
+                    $error("C[%0d]: expected %0d, got %0d", i, $signed(c[i]),
+                           $signed(memory[32'h200 + 4 * i]));
+                    error_count = error_count + 1;
+                end
+            end
+            
+            // K wider than the engine field is rejected without running
+            send_word({OP_MATMUL, 8'h00, 8'h00, 8'h00});
+            send_word(32'h000);
+            send_word(32'h100);
+            send_word(32'h200);
+            send_word(32'd32);
+            send_word(32'd2);
+            send_word(32'd4096);
+            send_word(32'd4);
+            send_word(32'd0);
+            
+            while (!host_data_out_valid) @(posedge clk);
+            if (host_data_out !== 32'd1) begin
+                $error("Oversized MATMUL: expected rejection, got %h", host_data_out);
+                error_count = error_count + 1;
+            end
+            @(posedge clk);
+            
+            $display("  ✓ Matrix multiplication tests completed");
+        end
+    endtask
+    
+    // Helper task: Send one word on the host stream once the core takes it
+    task send_word(input [DATA_WIDTH-1:0] word);
+        begin
+            host_data_in = word;
+            host_data_in_valid = 1;
+            @(negedge clk);
+            while (!host_data_in_ready) @(negedge clk);
+            @(posedge clk);
+            #1;
+            host_data_in_valid = 0;
+        end
+    endtask
+    
     // Helper task: Execute single instruction
     task execute_instruction(input [INST_WIDTH-1:0] inst, input [DATA_WIDTH-1:0] expected);
         begin
@@ -26,6 +26,7 @@ module npu_top_tb();
     reg pcie_rx_valid;
     wire pcie_rx_ready;
     wire [PCIE_DATA_WIDTH-1:0] pcie_tx_data;
+    wire [PCIE_DATA_WIDTH/DATA_WIDTH-1:0] pcie_tx_keep;
     wire pcie_tx_valid;
     reg pcie_tx_ready;
     
@@ -71,9 +72,11 @@ module npu_top_tb();
         .pcie_clk(pcie_clk),
         .pcie_rst_n(pcie_rst_n),
         .pcie_rx_data(pcie_rx_data),
+        .pcie_rx_keep({(PCIE_DATA_WIDTH/DATA_WIDTH){1'b1}}),
         .pcie_rx_valid(pcie_rx_valid),
         .pcie_rx_ready(pcie_rx_ready),
         .pcie_tx_data(pcie_tx_data),
+        .pcie_tx_keep(pcie_tx_keep),
         .pcie_tx_valid(pcie_tx_valid),
         .pcie_tx_ready(pcie_tx_ready),
         
@@ -85,7 +88,31 @@ module npu_top_tb();
         .mem_valid(mem_valid),
         
         .status_leds(status_leds),
-        .dip_switches(dip_switches)
+        .dip_switches(dip_switches),
+        
+        .pe_enable_mask({PE_COUNT{1'b1}}),
+        
+        .perf_clear(1'b0),
+        .perf_macs_nominal(),
+        .perf_macs_skipped(),
+        .perf_mult_gated(),
+        
+        .core_status(),
+        .core_busy(),
+        .core_inst_count(),
+        .core_busy_cycles(),
+        
+        .cq_enable(1'b0),
+        .cq_base(64'h0),
+        .cq_entries(16'h0),
+        .cq_head(16'h0),
+        .cq_tail(),
+        .cq_seq(),
+        .cq_wr_addr(),
+        .cq_wr_data(),
+        .cq_wr_valid(),
+        .cq_wr_ready(1'b1),
+        .cq_irq()
     );
     
     // Clock generation
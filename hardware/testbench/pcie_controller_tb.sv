@@ -25,6 +25,7 @@ module pcie_controller_tb();
     reg pcie_rx_valid;
     wire pcie_rx_ready;
     wire [PCIE_DATA_WIDTH-1:0] pcie_tx_data;
+    wire [PCIE_DATA_WIDTH/DATA_WIDTH-1:0] pcie_tx_keep;
     wire pcie_tx_valid;
     reg pcie_tx_ready;
     
@@ -59,9 +60,11 @@ module pcie_controller_tb();
         .pcie_rst_n(pcie_rst_n),
         
         .pcie_rx_data(pcie_rx_data),
+        .pcie_rx_keep({(PCIE_DATA_WIDTH/DATA_WIDTH){1'b1}}),
         .pcie_rx_valid(pcie_rx_valid),
         .pcie_rx_ready(pcie_rx_ready),
         .pcie_tx_data(pcie_tx_data),
+        .pcie_tx_keep(pcie_tx_keep),
         .pcie_tx_valid(pcie_tx_valid),
         .pcie_tx_ready(pcie_tx_ready),
         
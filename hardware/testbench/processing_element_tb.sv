@@ -2,7 +2,8 @@
  * Processing Element Testbench
  * 
  * Comprehensive testbench for processing_element.sv module
- * Tests all arithmetic operations, accumulator, and edge cases
+ * Tests all arithmetic operations, accumulator, and edge cases,
+ * plus packed INT16/INT8 modes against a reference model
  */
 
 `timescale 1ns / 1ps
@@ -11,6 +12,7 @@ module processing_element_tb();
 
     // Parameters
     parameter DATA_WIDTH = 32;
+    parameter MAC_LATENCY = 1;  // Run with 1, 2 and 3 to cover every pipeline depth
     
     // DUT signals
     reg clk;
@@ -19,8 +21,15 @@ module processing_element_tb();
     reg [DATA_WIDTH-1:0] op_a;
     reg [DATA_WIDTH-1:0] op_b;
     reg [3:0] operation;
+    reg acc_clear;
+    reg [1:0] precision;
+    reg saturate;
+    reg [1:0] round_mode;
+    reg [4:0] shift_amt;
     wire [DATA_WIDTH-1:0] result;
     wire valid;
+    wire [2:0] zero_lanes;
+    wire skipped;
     
     // Test variables
     reg [DATA_WIDTH-1:0] expected_result;
@@ -34,9 +43,19 @@ module processing_element_tb();
     localparam OP_MUL = 4'h3;
     localparam OP_MAC = 4'h4;
     
+    // Precision and rounding modes (must match DUT)
+    localparam PREC_INT32 = 2'h0;
+    localparam PREC_INT16 = 2'h1;
+    localparam PREC_INT8  = 2'h2;
+    localparam RND_TRUNC     = 2'h0;
+    localparam RND_HALF_UP   = 2'h1;
+    localparam RND_HALF_EVEN = 2'h2;
+    localparam RND_ZERO      = 2'h3;
+    
     // DUT instantiation
     processing_element #(
-        .DATA_WIDTH(DATA_WIDTH)
+        .DATA_WIDTH(DATA_WIDTH),
+        .MAC_LATENCY(MAC_LATENCY)
     ) dut (
         .clk(clk),
         .rst_n(rst_n),
@@ -44,8 +63,15 @@ module processing_element_tb();
         .op_a(op_a),
         .op_b(op_b),
         .operation(operation),
+        .acc_clear(acc_clear),
+        .precision(precision),
+        .saturate(saturate),
+        .round_mode(round_mode),
+        .shift_amt(shift_amt),
         .result(result),
-        .valid(valid)
+        .valid(valid),
+        .zero_lanes(zero_lanes),
+        .skipped(skipped)
     );
     
     // Clock generation
@@ -69,6 +95,11 @@ module processing_element_tb();
         op_a = 0;
         op_b = 0;
         operation = 0;
+        acc_clear = 0;
+        precision = PREC_INT32;
+        saturate = 0;
+        round_mode = RND_TRUNC;
+        shift_amt = 0;
         test_case = 0;
         error_count = 0;
         accumulator_ref = 0;
@@ -119,6 +150,28 @@ module processing_element_tb();
         $display("Test Case 8: Random Operation Sequence");
         test_random_sequence();
         
+        // Test Case 9: Packed SIMD MAC throughput against reference model
+        test_case = 9;
+        $display("Test Case 9: Packed INT16/INT8 MAC Modes");
+        test_packed_mac(PREC_INT32, 64);
+        test_packed_mac(PREC_INT16, 64);
+        test_packed_mac(PREC_INT8, 64);
+        
+        // Test Case 10: Saturation and rounding
+        test_case = 10;
+        $display("Test Case 10: Saturation and Rounding Modes");
+        test_saturation_rounding();
+        
+        // Test Case 11: Accumulator clear on issue
+        test_case = 11;
+        $display("Test Case 11: Accumulator Clear");
+        test_acc_clear();
+        
+        // Test Case 12: Zero-operand skipping
+        test_case = 12;
+        $display("Test Case 12: Zero-Operand Skipping");
+        test_zero_skip();
+        
         if (error_count == 0) begin
             $display("All tests completed successfully!");
         end else begin
@@ -272,7 +325,8 @@ module processing_element_tb();
             // Test enable transition
             @(posedge clk);
             enable = 1;
-            @(posedge clk);
+            repeat (MAC_LATENCY) @(posedge clk);
+            #1;
             
             if (valid !== 1'b1) begin
                 $error("Valid should be 1 when enable is 1");
@@ -330,16 +384,223 @@ module processing_element_tb();
         end
     endtask
     
+    // Reference model: sign-extended lane of a packed word
+    function automatic longint ref_lane(input [DATA_WIDTH-1:0] word, input int lane, input int width);
+        longint value;
+        value = (word >> (lane * width)) & ((64'd1 << width) - 1);
+        if (value[width-1]) value = value - (64'sd1 <<< width);
+        return value;
+    endfunction
+    
+    // Reference model: wrap or saturate to a signed width
+    function automatic longint ref_clamp(input longint value, input int width, input bit sat);
+        longint max_val, min_val;
+        max_val = (64'sd1 <<< (width - 1)) - 1;
+        min_val = -(64'sd1 <<< (width - 1));
+        if (sat) begin
+            if (value > max_val) return max_val;
+            if (value < min_val) return min_val;
+            return value;
+        end
+        value = value & ((64'd1 << width) - 1);
+        if (value[width-1]) value = value - (64'sd1 <<< width);
+        return value;
+    endfunction
+    
+    // Reference model: rounding right shift
+    function automatic longint ref_round(input longint value, input int shift, input [1:0] mode);
+        longint floor_val, remainder, half;
+        if (shift == 0) return value;
+        floor_val = value >>> shift;
+        remainder = value - (floor_val <<< shift);
+        half = 64'sd1 <<< (shift - 1);
+        case (mode)
+            RND_HALF_UP:   return (remainder >= half) ? floor_val + 1 : floor_val;
+            RND_HALF_EVEN: return (remainder > half || (remainder == half && floor_val[0])) ? floor_val + 1 : floor_val;
+            RND_ZERO:      return (value < 0 && remainder != 0) ? floor_val + 1 : floor_val;
+            default:       return floor_val;
+        endcase
+    endfunction
+    
+    // Reference model: lane-wise ADD/SUB/MUL result
+    function automatic [DATA_WIDTH-1:0] ref_lane_op(input [3:0] op, input [DATA_WIDTH-1:0] a,
+                                                    input [DATA_WIDTH-1:0] b, input [1:0] prec,
+                                                    input bit sat, input [1:0] rnd, input int shift);
+        int width;
+        longint lane_out;
+        reg [DATA_WIDTH-1:0] packed_out;
+        width = (prec == PREC_INT8) ? 8 : (prec == PREC_INT16) ? 16 : DATA_WIDTH;
+        packed_out = '0;
+        for (int l = 0; l < DATA_WIDTH / width; l++) begin
+            case (op)
+                OP_ADD:  lane_out = ref_lane(a, l, width) + ref_lane(b, l, width);
+                OP_SUB:  lane_out = ref_lane(a, l, width) - ref_lane(b, l, width);
+                default: lane_out = ref_round(ref_lane(a, l, width) * ref_lane(b, l, width), shift, rnd);
+            endcase
+            lane_out = ref_clamp(lane_out, width, sat);
+            packed_out = packed_out | ((lane_out & ((64'd1 << width) - 1)) << (l * width));
+        end
+        return packed_out;
+    endfunction
+    
+    // Reference model: one MAC step, returns the new accumulator
+    function automatic longint ref_mac_step(input longint acc, input [DATA_WIDTH-1:0] a,
+                                            input [DATA_WIDTH-1:0] b, input [1:0] prec, input bit sat);
+        int width;
+        longint sum;
+        width = (prec == PREC_INT8) ? 8 : (prec == PREC_INT16) ? 16 : DATA_WIDTH;
+        sum = acc;
+        for (int l = 0; l < DATA_WIDTH / width; l++) begin
+            sum = sum + ref_lane(a, l, width) * ref_lane(b, l, width);
+        end
+        return ref_clamp(sum, DATA_WIDTH, sat);
+    endfunction
+    
+    // Task: Stream back-to-back random MACs in one precision mode
+    task test_packed_mac(input [1:0] prec, input integer count);
+        integer i, lanes, cycles, results_seen;
+        longint acc_model;
+        reg [DATA_WIDTH-1:0] vec_a [0:255];
+        reg [DATA_WIDTH-1:0] vec_b [0:255];
+        reg [DATA_WIDTH-1:0] expected [0:255];
+        begin
+            lanes = (prec == PREC_INT8) ? 4 : (prec == PREC_INT16) ? 2 : 1;
+            $display("  Testing %0d back-to-back MACs with %0d lane(s)", count, lanes);
+            
+            // Clear the DUT accumulator
+            @(posedge clk);
+            rst_n = 0;
+            @(posedge clk);
+            rst_n = 1;
+            
+            acc_model = 0;
+            for (i = 0; i < count; i++) begin
+                vec_a[i] = $urandom;
+                vec_b[i] = $urandom;
+                acc_model = ref_mac_step(acc_model, vec_a[i], vec_b[i], prec, 1'b0);
+                expected[i] = acc_model[DATA_WIDTH-1:0];
+            end
+            
+            // Drive one vector per cycle and check each result as it retires
+            @(posedge clk);
+            #1;
+            precision = prec;
+            operation = OP_MAC;
+            enable = 1;
+            op_a = vec_a[0];
+            op_b = vec_b[0];
+            cycles = 0;
+            results_seen = 0;
+            while (results_seen < count) begin
+                @(posedge clk);
+                #1;
+                cycles = cycles + 1;
+                if (cycles < count) begin
+                    op_a = vec_a[cycles];
+                    op_b = vec_b[cycles];
+                end else begin
+                    enable = 0;
+                end
+                if (valid) begin
+                    if (result !== expected[results_seen]) begin
+                        $error("MAC %0d (prec %0d): expected %h, got %h", results_seen, prec,
+                               expected[results_seen], result);
+                        error_count = error_count + 1;
+                    end
+                    results_seen = results_seen + 1;
+                end
+                if (cycles > count + 16) begin
+                    $error("MAC results stalled in precision mode %0d", prec);
+                    error_count = error_count + 1;
+                    results_seen = count;
+                end
+            end
+            
+            // Sustained rate excludes the MAC_LATENCY-1 cycle pipeline fill
+            $display("    Precision %0d: %0d MACs in %0d cycles (latency %0d) = %0.2f MACs/cycle",
+                     prec, count * lanes, cycles, MAC_LATENCY,
+                     real'(count * lanes) / real'(cycles - (MAC_LATENCY - 1)));
+            
+            enable = 0;
+            precision = PREC_INT32;
+            $display("  ✓ Packed MAC tests completed");
+        end
+    endtask
+    
+    // Task: Directed and random saturation/rounding checks
+    task test_saturation_rounding();
+        integer i;
+        reg [3:0] rand_op;
+        reg [1:0] rand_prec;
+        reg [DATA_WIDTH-1:0] rand_a, rand_b;
+        begin
+            $display("  Testing saturation and rounding");
+            
+            // INT8 lanes saturate at +127/-128
+            precision = PREC_INT8;
+            saturate = 1;
+            perform_operation(OP_ADD, 32'h7F80017F, 32'h01FF0101, 32'h7F80027F);
+            perform_operation(OP_SUB, 32'h80000000, 32'h01000000, 32'h80000000);
+            
+            // INT16 lanes wrap without saturation
+            precision = PREC_INT16;
+            saturate = 0;
+            perform_operation(OP_ADD, 32'h7FFF0001, 32'h00010001, 32'h80000002);
+            
+            // INT32 MUL with rounding shift: 3*5 = 15, 15 >> 2 = 3.75
+            precision = PREC_INT32;
+            shift_amt = 2;
+            round_mode = RND_TRUNC;
+            perform_operation(OP_MUL, 32'd3, 32'd5, 32'd3);
+            round_mode = RND_HALF_UP;
+            perform_operation(OP_MUL, 32'd3, 32'd5, 32'd4);
+            // -15 >> 2 = -3.75: truncating towards zero gives -3
+            round_mode = RND_ZERO;
+            perform_operation(OP_MUL, 32'hFFFFFFFD, 32'd5, 32'hFFFFFFFD);
+            // 6 >> 2 = 1.5: half-even rounds to 2, 10 >> 2 = 2.5 rounds to 2
+            round_mode = RND_HALF_EVEN;
+            perform_operation(OP_MUL, 32'd3, 32'd2, 32'd2);
+            perform_operation(OP_MUL, 32'd5, 32'd2, 32'd2);
+            
+            // Random lane-wise operations in every mode
+            for (i = 0; i < 60; i++) begin
+                rand_op = $urandom_range(1, 3);
+                rand_prec = $urandom_range(0, 2);
+                rand_a = $urandom;
+                rand_b = $urandom;
+                precision = rand_prec;
+                saturate = $urandom_range(0, 1);
+                round_mode = $urandom_range(0, 3);
+                shift_amt = $urandom_range(0, 7);
+                perform_operation(rand_op, rand_a, rand_b,
+                                  ref_lane_op(rand_op, rand_a, rand_b, rand_prec,
+                                              saturate, round_mode, shift_amt));
+            end
+            
+            precision = PREC_INT32;
+            saturate = 0;
+            round_mode = RND_TRUNC;
+            shift_amt = 0;
+            $display("  ✓ Saturation and rounding tests completed");
+        end
+    endtask
+    
     // Helper task: Perform single operation
     task perform_operation(input [3:0] op, input [DATA_WIDTH-1:0] a, input [DATA_WIDTH-1:0] b, input [DATA_WIDTH-1:0] expected);
         begin
             @(posedge clk);
+            #1;
             enable = 1;
             operation = op;
             op_a = a;
             op_b = b;
             
+            // Issue for exactly one cycle, then wait out the pipeline
             @(posedge clk);
+            #1;
+            enable = 0;
+            repeat (MAC_LATENCY - 1) @(posedge clk);
+            #1;
             
             if (!valid) begin
                 $error("Valid not asserted for operation %h", op);
@@ -350,8 +611,101 @@ module processing_element_tb();
             end else begin
                 $display("    ✓ Op %h: %h ○ %h = %h", op, a, b, result);
             end
+        end
+    endtask
+    
+    // Task: acc_clear starts a new dot product without a reset
+    task test_acc_clear();
+        begin
+            precision = PREC_INT32;
+            saturate = 0;
+            shift_amt = 0;
+            perform_mac_operation(32'd7, 32'd9);
             
-            enable = 0;
+            acc_clear = 1;
+            accumulator_ref = 0;
+            perform_mac_operation(32'd3, 32'd4);    // 12, previous sum discarded
+            acc_clear = 0;
+            perform_mac_operation(32'd5, 32'd6);    // 12 + 30
+            
+            $display("  ✓ Accumulator clear verified");
+        end
+    endtask
+    
+    // Task: zero operands skip the multiplier without changing results
+    task test_zero_skip();
+        begin
+            saturate = 0;
+            shift_amt = 0;
+            
+            precision = PREC_INT32;
+            acc_clear = 1;
+            accumulator_ref = 0;
+            perform_mac_operation(32'd6, 32'd7);
+            acc_clear = 0;
+            perform_mac_operation(32'd0, 32'd9);
+            check_skip(3'd1, 1'b1);
+            perform_mac_operation(32'd11, 32'd0);
+            check_skip(3'd1, 1'b1);
+            perform_mac_operation(32'd2, 32'd5);                // Product register reloads
+            check_skip(3'd0, 1'b0);
+            
+            // Saturating skipped MAC keeps a negative sum instead of clamping to +max
+            saturate = 1;
+            acc_clear = 1;
+            accumulator_ref = 0;
+            perform_mac_operation(-32'sd5, 32'd7);              // -35
+            acc_clear = 0;
+            perform_mac_operation(32'd0, 32'd9);
+            check_skip(3'd1, 1'b1);
+            perform_mac_operation(-32'sd2, 32'd3);              // -41
+            check_skip(3'd0, 1'b0);
+            saturate = 0;
+            
+            acc_clear = 1;
+            accumulator_ref = 0;
+            perform_mac_operation(32'd0, 32'd3);                // Skipped MAC still clears
+            check_skip(3'd1, 1'b1);
+            acc_clear = 0;
+            
+            // INT8: lanes 0 and 2 zero, lanes 1 and 3 compute 3*2 + 1*2
+            precision = PREC_INT8;
+            perform_operation(OP_MAC, 32'h0100_0300, 32'h0202_0202, 32'd8);
+            check_skip(3'd2, 1'b0);
+            
+            // INT8: every lane has a zero operand
+            perform_operation(OP_MAC, 32'h0005_0000, 32'h0300_0103, 32'd8);
+            check_skip(3'd4, 1'b1);
+            
+            // Non-MAC operations are never skipped
+            precision = PREC_INT32;
+            perform_operation(OP_MUL, 32'd0, 32'd9, 32'd0);
+            check_skip(3'd0, 1'b0);
+            
+            // Without input registers the multiplier sees isolated operands
+            if (MAC_LATENCY < 3) begin
+                operation = OP_MAC;
+                op_a = 32'd0;
+                op_b = 32'h1234_5678;
+                #1;
+                if (dut.s0_a !== '0 || dut.s0_b !== '0) begin
+                    $error("Skipped MAC reached the multiplier: %h x %h", dut.s0_a, dut.s0_b);
+                    error_count = error_count + 1;
+                end
+            end
+            
+            $display("  ✓ Zero-operand skipping verified");
+        end
+    endtask
+    
+    // Helper task: Check the skip statistics of the last operation
+    task check_skip(input [2:0] exp_zero_lanes, input exp_skipped);
+        begin
+            if (zero_lanes !== exp_zero_lanes || skipped !== exp_skipped) begin
+                $error("Skip stats: expected zero_lanes=%0d skipped=%0b, got %0d/%0b",
+                       exp_zero_lanes, exp_skipped, zero_lanes, skipped);
+                error_count = error_count + 1;
+            end
         end
     endtask
     
@@ -367,12 +721,17 @@ module processing_element_tb();
     task perform_invalid_operation(input [3:0] op);
         begin
             @(posedge clk);
+            #1;
             enable = 1;
             operation = op;
             op_a = 32'd100;
             op_b = 32'd200;
             
             @(posedge clk);
+            #1;
+            enable = 0;
+            repeat (MAC_LATENCY - 1) @(posedge clk);
+            #1;
             
             if (valid !== 1'b0) begin
                 $error("Valid should be 0 for invalid operation %h", op);
@@ -380,8 +739,6 @@ module processing_element_tb();
             end else begin
                 $display("    ✓ Invalid operation %h correctly rejected", op);
             end
-            
-            enable = 0;
         end
     endtask
     
@@ -96,8 +96,15 @@ compile_rtl() {
     local rtl_files=(
         "async_fifo.sv"
         "processing_element.sv"
+        "activation_unit.sv"
+        "pooling_unit.sv"
+        "conv_engine.sv"
         "pcie_controller.sv"
         "npu_core.sv"
+        "work_distributor.sv"
+        "mem_arbiter.sv"
+        "npu_cluster.sv"
+        "completion_writer.sv"
         "npu_top.sv"
     )
     
@@ -221,8 +228,12 @@ usage() {
     echo "Testbenches:"
     echo "  async_fifo_tb          Test asynchronous FIFO"
     echo "  processing_element_tb  Test processing element"
+    echo "  activation_unit_tb     Test activation unit"
+    echo "  conv_engine_tb         Test convolution engine"
     echo "  pcie_controller_tb     Test PCIe controller"
     echo "  npu_core_tb           Test NPU core"
+    echo "  npu_cluster_tb        Test multi-core cluster"
+    echo "  completion_writer_tb  Test completion queue writer"
     echo "  npu_top_tb            Test complete NPU system"
     echo "  all                   Run all testbenches (default)"
     echo ""
@@ -289,8 +300,12 @@ main() {
     local all_testbenches=(
         "async_fifo_tb"
         "processing_element_tb"
+        "activation_unit_tb"
+        "conv_engine_tb"
         "pcie_controller_tb"
         "npu_core_tb"
+        "npu_cluster_tb"
+        "completion_writer_tb"
         "npu_top_tb"
     )
     
@@ -54,6 +54,17 @@
 #define REG_DMA_SRC     0x34
 #define REG_DMA_DST     0x38
 #define REG_DMA_SIZE    0x3C
+#define REG_PERF_MACS   0x40    /* 64-bit, low word first */
+#define REG_PERF_MACS_SKIPPED 0x48
+#define REG_PERF_MULT_GATED   0x50
+#define REG_CORE_INFO   0x58    /* [7:0] core count, [15:8] busy mask */
+#define REG_CQ_BASE_LO  0x60    /* Completion ring bus address */
+#define REG_CQ_BASE_HI  0x64
+#define REG_CQ_CTRL     0x68    /* [15:0] entries, [31] enable */
+#define REG_CQ_HEAD     0x6C    /* Consumer index, written by the host */
+#define REG_CQ_TAIL     0x70    /* Producer index */
+#define REG_CORE_BASE   0x80    /* Per core: instructions, busy cycles */
+#define REG_CORE_STRIDE 0x08
 
 // Control register bits
 #define CTRL_ENABLE     BIT(0)
@@ -66,6 +77,9 @@
 #define STATUS_ERROR    BIT(2)
 #define STATUS_DONE     BIT(3)
 
+// Completion queue control bits
+#define CQ_CTRL_ENABLE  BIT(31)
+
 // DMA transfer states
 typedef enum {
     DMA_STATE_IDLE,
@@ -123,6 +137,15 @@ struct fpga_npu_dev {
     bool interrupt_received;
     u32 interrupt_status;
     
+    // Completion queue (device-written ring in host memory)
+    struct npu_completion *cq;
+    dma_addr_t cq_dma;
+    spinlock_t cq_lock;
+    bool cq_enabled;
+    u32 cq_head;                // Next slot to consume
+    u32 cq_next_seq;            // Sequence number expected in that slot
+    u32 cq_submit_seq;          // Record number of the last instruction submitted
+    
     // Performance monitoring
     struct npu_performance_counters perf_counters;
     spinlock_t perf_lock;
@@ -175,6 +198,12 @@ static int npu_free_dma_buffer(struct fpga_npu_dev *dev, u32 buffer_id);
 static int npu_dma_transfer(struct fpga_npu_dev *dev, struct npu_dma_transfer *transfer);
 static int npu_execute_instruction(struct fpga_npu_dev *dev, struct npu_instruction *inst);
 static int npu_get_performance_counters(struct fpga_npu_dev *dev, struct npu_performance_counters *perf);
+static u32 npu_core_count(struct fpga_npu_dev *dev);
+static void npu_cq_arm(struct fpga_npu_dev *dev);
+static u32 npu_cq_reap(struct fpga_npu_dev *dev);
+static bool npu_cq_reached(struct fpga_npu_dev *dev, u32 seq);
+static ssize_t npu_submit_stream(struct fpga_npu_dev *dev, const char __user *buffer, size_t len,
+                                 u32 *seq);
 static void npu_thermal_monitor(struct timer_list *timer);
 static void npu_dma_work_handler(struct work_struct *work);
 
@@ -222,6 +251,7 @@ static int fpga_npu_probe(struct pci_dev *pdev, const struct pci_device_id *id)
     INIT_LIST_HEAD(&npu_device->dma_buffers);
     spin_lock_init(&npu_device->dma_lock);
     spin_lock_init(&npu_device->perf_lock);
+    spin_lock_init(&npu_device->cq_lock);
     npu_device->next_buffer_id = 1;
     atomic_set(&npu_device->ref_count, 0);
     
@@ -291,11 +321,20 @@ static int fpga_npu_probe(struct pci_dev *pdev, const struct pci_device_id *id)
         goto err_unmap_data;
     }
     
+    // Allocate completion queue
+    npu_device->cq = dma_alloc_coherent(&pdev->dev, NPU_CQ_ENTRIES * sizeof(struct npu_completion),
+                                        &npu_device->cq_dma, GFP_KERNEL);
+    if (!npu_device->cq) {
+        printk(KERN_ERR "FPGA NPU: Failed to allocate completion queue\n");
+        ret = -ENOMEM;
+        goto err_free_dma;
+    }
+    
     // Request interrupt
     ret = request_irq(pdev->irq, fpga_npu_interrupt, IRQF_SHARED, DRIVER_NAME, npu_device);
     if (ret) {
         printk(KERN_ERR "FPGA NPU: Failed to request interrupt\n");
-        goto err_free_dma;
+        goto err_free_cq;
     }
     npu_device->irq = pdev->irq;
     
@@ -303,6 +342,7 @@ static int fpga_npu_probe(struct pci_dev *pdev, const struct pci_device_id *id)
     iowrite32(CTRL_RESET, npu_device->control_bar + REG_CONTROL);
     msleep(10);
     iowrite32(CTRL_ENABLE, npu_device->control_bar + REG_CONTROL);
+    npu_cq_arm(npu_device);
     
     // Create character device
     ret = alloc_chrdev_region(&dev_number, 0, 1, DEVICE_NAME);
@@ -350,6 +390,9 @@ err_unregister_chrdev:
     unregister_chrdev_region(dev_number, 1);
 err_free_irq:
     free_irq(npu_device->irq, npu_device);
+err_free_cq:
+    dma_free_coherent(&pdev->dev, NPU_CQ_ENTRIES * sizeof(struct npu_completion),
+                      npu_device->cq, npu_device->cq_dma);
 err_free_dma:
     dma_free_coherent(&pdev->dev, npu_device->dma_size, npu_device->dma_buffer, npu_device->dma_handle);
 err_unmap_data:
@@ -383,6 +426,8 @@ static void fpga_npu_remove(struct pci_dev *pdev)
     cdev_del(&dev->cdev);
     unregister_chrdev_region(dev_number, 1);
     free_irq(dev->irq, dev);
+    dma_free_coherent(&pdev->dev, NPU_CQ_ENTRIES * sizeof(struct npu_completion),
+                      dev->cq, dev->cq_dma);
     dma_free_coherent(&pdev->dev, dev->dma_size, dev->dma_buffer, dev->dma_handle);
     pci_iounmap(pdev, dev->data_bar);
     pci_iounmap(pdev, dev->control_bar);
@@ -393,12 +438,21 @@ static void fpga_npu_remove(struct pci_dev *pdev)
 
 /**
  * Interrupt handler
+ *
+ * Completions are taken from the completion queue in host memory; writing
+ * the new consumer index also acknowledges the interrupt. REG_STATUS is
+ * only read on bitstreams without a completion writer, or when the ring
+ * holds nothing new (shared line, or a non-completion interrupt).
  */
 static irqreturn_t fpga_npu_interrupt(int irq, void *dev_id)
 {
     struct fpga_npu_dev *dev = (struct fpga_npu_dev *)dev_id;
     u32 status;
     
+    if (dev->cq_enabled && npu_cq_reap(dev)) {
+        return IRQ_HANDLED;
+    }
+    
     status = ioread32(dev->control_bar + REG_STATUS);
     if (!(status & STATUS_DONE)) {
         return IRQ_NONE; // Not our interrupt
@@ -475,23 +529,9 @@ static ssize_t fpga_npu_read(struct file *file, char __user *buffer, size_t len,
 static ssize_t fpga_npu_write(struct file *file, const char __user *buffer, size_t len, loff_t *offset)
 {
     struct fpga_npu_dev *dev = file->private_data;
-    ssize_t bytes_written = 0;
-    
-    if (len > dev->dma_size) {
-        len = dev->dma_size;
-    }
-    
-    if (copy_from_user(dev->dma_buffer, buffer, len)) {
-        return -EFAULT;
-    }
+    u32 seq;
     
-    // Start NPU processing
-    iowrite32((u32)dev->dma_handle, dev->control_bar + REG_DATA_ADDR);
-    iowrite32((u32)len, dev->control_bar + REG_DATA_SIZE);
-    iowrite32(CTRL_ENABLE | CTRL_START, dev->control_bar + REG_CONTROL);
-    
-    bytes_written = len;
-    return bytes_written;
+    return npu_submit_stream(dev, buffer, len, &seq);
 }
 
 /**
@@ -512,6 +552,11 @@ static long fpga_npu_ioctl(struct file *file, unsigned int cmd, unsigned long ar
     }
     
     switch (cmd) {
+        case NPU_IOCTL_NOP: {
+            // Syscall and dispatch cost only: no lock, copy or register access
+            break;
+        }
+        
         case NPU_IOCTL_GET_DEVICE_INFO: {
             struct npu_device_info info = {
                 .vendor_id = dev->pdev->vendor,
@@ -524,7 +569,8 @@ static long fpga_npu_ioctl(struct file *file, unsigned int cmd, unsigned long ar
                 .max_frequency = 300,
                 .memory_size = dev->dma_size,
                 .pcie_generation = 3,
-                .pcie_lanes = 4
+                .pcie_lanes = 4,
+                .core_count = npu_core_count(dev)
             };
             strcpy(info.board_name, "FPGA NPU Board");
             
@@ -542,6 +588,43 @@ static long fpga_npu_ioctl(struct file *file, unsigned int cmd, unsigned long ar
             break;
         }
         
+        case NPU_IOCTL_GET_CQ_INFO: {
+            struct npu_cq_info info = {
+                .enabled = dev->cq_enabled,
+                .entries = NPU_CQ_ENTRIES
+            };
+            unsigned long flags;
+            
+            spin_lock_irqsave(&dev->cq_lock, flags);
+            info.last_seq = dev->cq_next_seq - 1;
+            spin_unlock_irqrestore(&dev->cq_lock, flags);
+            
+            if (copy_to_user((void __user *)arg, &info, sizeof(info))) {
+                ret = -EFAULT;
+            }
+            break;
+        }
+        
+        case NPU_IOCTL_GET_CORE_STATS: {
+            struct npu_core_stats stats;
+            u32 info = ioread32(dev->control_bar + REG_CORE_INFO);
+            u32 i;
+            
+            memset(&stats, 0, sizeof(stats));
+            stats.core_count = npu_core_count(dev);
+            stats.busy_mask = (info >> 8) & 0xFF;
+            for (i = 0; i < stats.core_count; i++) {
+                void __iomem *regs = dev->control_bar + REG_CORE_BASE + i * REG_CORE_STRIDE;
+                stats.instructions[i] = ioread32(regs);
+                stats.busy_cycles[i] = ioread32(regs + 4);
+            }
+            
+            if (copy_to_user((void __user *)arg, &stats, sizeof(stats))) {
+                ret = -EFAULT;
+            }
+            break;
+        }
+        
         case NPU_IOCTL_GET_PERF_COUNTERS: {
             ret = npu_get_performance_counters(dev, (struct npu_performance_counters *)arg);
             break;
@@ -596,7 +679,38 @@ static long fpga_npu_ioctl(struct file *file, unsigned int cmd, unsigned long ar
                 ret = -EFAULT;
                 break;
             }
+            
+            mutex_lock(&dev->dev_mutex);
             ret = npu_execute_instruction(dev, &inst);
+            if (ret == 0) {
+                inst.seq = ++dev->cq_submit_seq;
+            }
+            mutex_unlock(&dev->dev_mutex);
+            
+            if (ret == 0 && copy_to_user((void __user *)arg, &inst, sizeof(inst))) {
+                ret = -EFAULT;
+            }
+            break;
+        }
+        
+        case NPU_IOCTL_SUBMIT: {
+            struct npu_submit req;
+            ssize_t written;
+            
+            if (copy_from_user(&req, (void __user *)arg, sizeof(req))) {
+                ret = -EFAULT;
+                break;
+            }
+            
+            written = npu_submit_stream(dev, u64_to_user_ptr(req.words), req.len, &req.seq);
+            if (written < 0) {
+                ret = written;
+                break;
+            }
+            req.len = written;
+            if (copy_to_user((void __user *)arg, &req, sizeof(req))) {
+                ret = -EFAULT;
+            }
             break;
         }
         
@@ -623,6 +737,36 @@ static long fpga_npu_ioctl(struct file *file, unsigned int cmd, unsigned long ar
             break;
         }
         
+        case NPU_IOCTL_WAIT_SEQ: {
+            struct npu_cq_wait req;
+            long left;
+            
+            if (copy_from_user(&req, (void __user *)arg, sizeof(req))) {
+                ret = -EFAULT;
+                break;
+            }
+            if (!dev->cq_enabled) {
+                ret = -EOPNOTSUPP;
+                break;
+            }
+            
+            // Take records the interrupt has not reaped yet; the IRQ reaps the rest
+            npu_cq_reap(dev);
+            if (req.timeout_ms == 0) {
+                ret = wait_event_interruptible(dev->wait_queue, npu_cq_reached(dev, req.seq));
+            } else {
+                left = wait_event_interruptible_timeout(dev->wait_queue,
+                                                        npu_cq_reached(dev, req.seq),
+                                                        msecs_to_jiffies(req.timeout_ms));
+                if (left == 0) {
+                    ret = -ETIMEDOUT;
+                } else if (left < 0) {
+                    ret = left;
+                }
+            }
+            break;
+        }
+        
         case NPU_IOCTL_SET_CONFIG: {
             struct npu_device_config config;
             if (copy_from_user(&config, (void __user *)arg, sizeof(config))) {
@@ -650,6 +794,7 @@ static long fpga_npu_ioctl(struct file *file, unsigned int cmd, unsigned long ar
             iowrite32(CTRL_RESET, dev->control_bar + REG_CONTROL);
             msleep(10);
             iowrite32(CTRL_ENABLE, dev->control_bar + REG_CONTROL);
+            npu_cq_arm(dev);
             mutex_unlock(&dev->dev_mutex);
             break;
         }
@@ -689,6 +834,21 @@ static int fpga_npu_mmap(struct file *file, struct vm_area_struct *vma)
         return -ENODEV;
     }
     
+    // Completion queue: read-only view of the coherent ring
+    if (vma->vm_pgoff == (NPU_CQ_MMAP_OFFSET >> PAGE_SHIFT)) {
+        if (!dev->cq_enabled ||
+            size > PAGE_ALIGN(NPU_CQ_ENTRIES * sizeof(struct npu_completion))) {
+            return -EINVAL;
+        }
+        if (vma->vm_flags & VM_WRITE) {
+            return -EPERM;
+        }
+        vma->vm_flags &= ~VM_MAYWRITE;
+        vma->vm_pgoff = 0;
+        return dma_mmap_coherent(&dev->pdev->dev, vma, dev->cq, dev->cq_dma,
+                                 NPU_CQ_ENTRIES * sizeof(struct npu_completion));
+    }
+    
     // Ensure the mapping size doesn't exceed our DMA buffer
     if (size > dev->dma_size) {
         return -EINVAL;
@@ -723,6 +883,15 @@ static unsigned int fpga_npu_poll(struct file *file, poll_table *wait)
     
     poll_wait(file, &dev->wait_queue, wait);
     
+    if (dev->cq_enabled) {
+        // Completions come from host memory; instructions queue in the RX FIFO
+        npu_cq_reap(dev);
+        if (dev->interrupt_received) {
+            mask |= POLLIN | POLLRDNORM;
+        }
+        return mask | POLLOUT | POLLWRNORM;
+    }
+    
     if (dev->interrupt_received) {
         mask |= POLLIN | POLLRDNORM;
     }
@@ -881,12 +1050,164 @@ out:
     return ret;
 }
 
+/**
+ * Number of NPU cores behind the work distributor (1 on older bitstreams)
+ */
+static u32 npu_core_count(struct fpga_npu_dev *dev)
+{
+    u32 count = ioread32(dev->control_bar + REG_CORE_INFO) & 0xFF;
+    
+    if (count == 0) {
+        return 1;
+    }
+    return min_t(u32, count, NPU_MAX_CORES);
+}
+
+/**
+ * Reset the completion queue and point the device at it. Bitstreams
+ * without a completion writer read REG_CQ_CTRL back as zero; the driver
+ * then falls back to REG_STATUS.
+ */
+static void npu_cq_arm(struct fpga_npu_dev *dev)
+{
+    unsigned long flags;
+    u32 ctrl = CQ_CTRL_ENABLE | NPU_CQ_ENTRIES;
+    
+    spin_lock_irqsave(&dev->cq_lock, flags);
+    iowrite32(0, dev->control_bar + REG_CQ_CTRL);
+    memset(dev->cq, 0, NPU_CQ_ENTRIES * sizeof(struct npu_completion));
+    dev->cq_head = 0;
+    dev->cq_next_seq = 1;
+    dev->cq_submit_seq = 0;
+    
+    iowrite32(lower_32_bits(dev->cq_dma), dev->control_bar + REG_CQ_BASE_LO);
+    iowrite32(upper_32_bits(dev->cq_dma), dev->control_bar + REG_CQ_BASE_HI);
+    iowrite32(0, dev->control_bar + REG_CQ_HEAD);
+    iowrite32(ctrl, dev->control_bar + REG_CQ_CTRL);
+    dev->cq_enabled = (ioread32(dev->control_bar + REG_CQ_CTRL) == ctrl);
+    spin_unlock_irqrestore(&dev->cq_lock, flags);
+    
+    if (!dev->cq_enabled) {
+        printk(KERN_INFO "FPGA NPU: No completion queue, polling REG_STATUS\n");
+    }
+}
+
+/**
+ * Consume new completion records and hand their slots back to the device
+ * @return Number of records consumed
+ */
+static u32 npu_cq_reap(struct fpga_npu_dev *dev)
+{
+    struct npu_completion *rec;
+    unsigned long flags;
+    u32 count = 0;
+    
+    spin_lock_irqsave(&dev->cq_lock, flags);
+    for (;;) {
+        rec = &dev->cq[dev->cq_head];
+        if (READ_ONCE(rec->seq) != dev->cq_next_seq) {
+            break;
+        }
+        dma_rmb();  // Read the record body after seeing its sequence number
+        
+        if (rec->error != NPU_CQ_ERR_NONE) {
+            dev->error_info.error_code = rec->error;
+            dev->error_info.error_count++;
+            dev->error_info.timestamp = ktime_get_ns();
+        }
+        
+        dev->cq_head = (dev->cq_head + 1) % NPU_CQ_ENTRIES;
+        dev->cq_next_seq++;
+        count++;
+    }
+    
+    if (count) {
+        // Also acknowledges the completion interrupt
+        iowrite32(dev->cq_head, dev->control_bar + REG_CQ_HEAD);
+        dev->interrupt_received = true;
+    }
+    spin_unlock_irqrestore(&dev->cq_lock, flags);
+    
+    if (count) {
+        wake_up_interruptible(&dev->wait_queue);
+    }
+    return count;
+}
+
+/**
+ * Whether record seq has been reaped (wrap-safe). A wait condition, so it
+ * only reads state; records are consumed by npu_cq_reap().
+ */
+static bool npu_cq_reached(struct fpga_npu_dev *dev, u32 seq)
+{
+    return (s32)(READ_ONCE(dev->cq_next_seq) - 1 - seq) >= 0;
+}
+
+/**
+ * Number of instructions in a word stream. Routing prefixes post no
+ * completion record; descriptor operations span NPU_INST_MAX_WORDS words.
+ */
+static u32 npu_stream_instructions(const u32 *words, size_t count)
+{
+    u32 instructions = 0;
+    size_t i = 0;
+    u32 base;
+    
+    while (i < count) {
+        if ((words[i] >> 24) == NPU_OP_ROUTE) {
+            i++;
+            continue;
+        }
+        base = (words[i] >> 24) & NPU_OP_BASE_MASK;
+        if (base == NPU_OP_CONV || base == NPU_OP_MATMUL || base == NPU_OP_POOLING) {
+            i += NPU_INST_MAX_WORDS;
+        } else {
+            i++;
+        }
+        instructions++;
+    }
+    return instructions;
+}
+
+/**
+ * Start an instruction stream from user space and number its instructions
+ * @param seq Receives the record number of the last instruction
+ * @return Bytes accepted, or a negative errno
+ */
+static ssize_t npu_submit_stream(struct fpga_npu_dev *dev, const char __user *buffer, size_t len,
+                                 u32 *seq)
+{
+    if (len > dev->dma_size) {
+        len = dev->dma_size;
+    }
+    
+    // Streams are numbered in the order they reach the device
+    mutex_lock(&dev->dev_mutex);
+    if (copy_from_user(dev->dma_buffer, buffer, len)) {
+        mutex_unlock(&dev->dev_mutex);
+        return -EFAULT;
+    }
+    
+    // Start NPU processing
+    iowrite32((u32)dev->dma_handle, dev->control_bar + REG_DATA_ADDR);
+    iowrite32((u32)len, dev->control_bar + REG_DATA_SIZE);
+    iowrite32(CTRL_ENABLE | CTRL_START, dev->control_bar + REG_CONTROL);
+    
+    dev->cq_submit_seq += npu_stream_instructions(dev->dma_buffer, len / sizeof(u32));
+    *seq = dev->cq_submit_seq;
+    mutex_unlock(&dev->dev_mutex);
+    
+    return len;
+}
+
 /**
  * Execute NPU instruction
  */
 static int npu_execute_instruction(struct fpga_npu_dev *dev, struct npu_instruction *inst)
 {
     u32 instruction_word;
+    u32 base;
+    int i;
     
     // Pack instruction into 32-bit word
     instruction_word = ((u32)inst->operation << 24) |
@@ -894,8 +1215,30 @@ static int npu_execute_instruction(struct fpga_npu_dev *dev, struct npu_instruct
                       ((inst->src2_addr & 0xFF) << 8) |
                       (inst->dst_addr & 0xFF);
     
+    // Pin to one core with a routing prefix, otherwise the distributor load-balances
+    if (inst->flags & NPU_INST_FLAG_TARGET_CORE) {
+        u32 core = NPU_INST_CORE(inst->flags);
+        
+        if (core >= npu_core_count(dev)) {
+            return -EINVAL;
+        }
+        iowrite32(((u32)NPU_OP_ROUTE << 24) | (core << 16), dev->control_bar + REG_DATA_ADDR);
+    }
+    
     // Write instruction to device
     iowrite32(instruction_word, dev->control_bar + REG_DATA_ADDR);
+    
+    // Descriptor operations are followed by eight words, as on the write() path
+    base = inst->operation & NPU_OP_BASE_MASK;
+    if (base == NPU_OP_CONV || base == NPU_OP_MATMUL || base == NPU_OP_POOLING) {
+        iowrite32(inst->src1_addr, dev->control_bar + REG_DATA_ADDR);
+        iowrite32(inst->src2_addr, dev->control_bar + REG_DATA_ADDR);
+        iowrite32(inst->dst_addr, dev->control_bar + REG_DATA_ADDR);
+        iowrite32(inst->size, dev->control_bar + REG_DATA_ADDR);
+        for (i = 0; i < 4; i++) {
+            iowrite32(inst->params[i], dev->control_bar + REG_DATA_ADDR);
+        }
+    }
     iowrite32(inst->size, dev->control_bar + REG_DATA_SIZE);
     
     // Start execution
@@ -929,6 +1272,17 @@ static int npu_get_performance_counters(struct fpga_npu_dev *dev, struct npu_per
         ((u64)ioread32(dev->control_bar + REG_PERF_CYCLES + 4) << 32) |
         ioread32(dev->control_bar + REG_PERF_CYCLES);
     
+    // Zero-skip counters
+    dev->perf_counters.counters[NPU_PERF_MACS_NOMINAL] = 
+        ((u64)ioread32(dev->control_bar + REG_PERF_MACS + 4) << 32) |
+        ioread32(dev->control_bar + REG_PERF_MACS);
+    dev->perf_counters.counters[NPU_PERF_MACS_SKIPPED] = 
+        ((u64)ioread32(dev->control_bar + REG_PERF_MACS_SKIPPED + 4) << 32) |
+        ioread32(dev->control_bar + REG_PERF_MACS_SKIPPED);
+    dev->perf_counters.counters[NPU_PERF_MULT_GATED] = 
+        ((u64)ioread32(dev->control_bar + REG_PERF_MULT_GATED + 4) << 32) |
+        ioread32(dev->control_bar + REG_PERF_MULT_GATED);
+    
     dev->perf_counters.timestamp = ktime_get_ns();
     dev->perf_counters.frequency_mhz = 300;  // From config
     dev->perf_counters.temperature_celsius = ioread32(dev->control_bar + REG_TEMPERATURE);
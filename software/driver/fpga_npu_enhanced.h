@@ -17,6 +17,7 @@
 #define NPU_MAX_DMA_BUFFERS     16
 #define NPU_MAX_BUFFER_SIZE     (16 * 1024 * 1024)  /* 16MB */
 #define NPU_MIN_BUFFER_SIZE     4096                 /* 4KB */
+#define NPU_MAX_CORES           8
 
 /* Performance counter types */
 typedef enum {
@@ -28,6 +29,9 @@ typedef enum {
     NPU_PERF_CACHE_MISSES,
     NPU_PERF_PIPELINE_STALLS,
     NPU_PERF_POWER_CONSUMPTION,
+    NPU_PERF_MACS_NOMINAL,      /* MACs issued to the PE array, zero operands included */
+    NPU_PERF_MACS_SKIPPED,      /* MACs skipped or compacted out for a zero operand */
+    NPU_PERF_MULT_GATED,        /* PE cycles with the multiplier clock-enable gated */
     NPU_PERF_COUNTER_MAX
 } npu_perf_counter_t;
 
@@ -42,9 +46,65 @@ typedef enum {
     NPU_OP_RELU = 7,
     NPU_OP_SIGMOID = 8,
     NPU_OP_POOLING = 9,
-    NPU_OP_BATCH_NORM = 10
+    NPU_OP_BATCH_NORM = 10,
+    NPU_OP_TANH = 11
 } npu_operation_t;
 
+/* Activation functions, usable stand-alone or as a fused epilogue */
+typedef enum {
+    NPU_ACT_NONE = 0,
+    NPU_ACT_RELU = 1,
+    NPU_ACT_LEAKY_RELU = 2,
+    NPU_ACT_SIGMOID = 3,
+    NPU_ACT_TANH = 4
+} npu_activation_t;
+
+/* Opcode bits [7:5] select an activation applied before writeback */
+#define NPU_OP_EPILOGUE_SHIFT   5
+#define NPU_OP_WITH_EPILOGUE(op, act) \
+    ((op) | ((act) << NPU_OP_EPILOGUE_SHIFT))
+#define NPU_OP_BASE_MASK        0x1F
+
+/* Pooling modes (params[3] of NPU_OP_POOLING) */
+#define NPU_POOL_MAX            0
+#define NPU_POOL_AVG            1
+#define NPU_POOL_GLOBAL_AVG     2
+
+/* NPU_OP_CONV params[3] flag: weights are 2:4 compressed (see npu_pack_weights_2_4) */
+#define NPU_CONV_SPARSE_2_4     (1u << 28)
+
+/* Longest instruction stream: instruction word + 8 descriptor words */
+#define NPU_INST_MAX_WORDS      9
+
+/*
+ * Routing prefix for multi-core devices: a word with this opcode pins the
+ * next instruction to the core in its src1 byte. Without a prefix, or with
+ * NPU_CORE_ANY, the work distributor hands the instruction to an idle core.
+ * The low 16 bits restrict the instruction to a partition of the PE array
+ * (0: all PEs); the partition is further ANDed with pe_enable_mask.
+ */
+#define NPU_OP_ROUTE            0x1F
+#define NPU_CORE_ANY            0xFF
+
+/*
+ * Completion queue: the device posts one record per finished instruction
+ * into a host-memory ring, so completion is detected from cacheable memory
+ * instead of REG_STATUS reads. Record n (counting from 1 after the queue is
+ * armed) lands in slot (n - 1) % NPU_CQ_ENTRIES; a slot holds record n once
+ * its seq equals n. The ring is mapped read-only at NPU_CQ_MMAP_OFFSET.
+ * Records are numbered per device, not per client: NPU_IOCTL_SUBMIT and
+ * NPU_IOCTL_EXECUTE_INSTRUCTION return the record number that is posted once
+ * the submitted instructions, and all submitted before them, have completed.
+ */
+#define NPU_CQ_ENTRIES          256
+#define NPU_CQ_MMAP_OFFSET      0x10000000
+#define NPU_CQ_STATUS_ERROR     (1u << 2)
+#define NPU_CQ_STATUS_DONE      (1u << 3)
+#define NPU_CQ_STATUS_OPCODE(s) (((s) >> 8) & 0xFF)
+#define NPU_CQ_STATUS_CORE(s)   (((s) >> 16) & 0xFF)
+#define NPU_CQ_ERR_NONE         0
+#define NPU_CQ_ERR_CONFIG       1   /* CONV/MATMUL/POOLING descriptor rejected */
+
 /* Data types */
 typedef enum {
     NPU_DTYPE_INT8,
@@ -69,6 +129,44 @@ struct npu_device_info {
     __u64 memory_size;
     __u32 pcie_generation;
     __u32 pcie_lanes;
+    __u32 core_count;
+};
+
+/* Per-core status and counters */
+struct npu_core_stats {
+    __u32 core_count;
+    __u32 busy_mask;                        /* Bit n set while core n is busy */
+    __u32 instructions[NPU_MAX_CORES];      /* Instructions dispatched to each core */
+    __u32 busy_cycles[NPU_MAX_CORES];       /* Cycles each core spent busy */
+};
+
+/* Completion record, written by the device */
+struct npu_completion {
+    __u32 seq;                  /* Sequence number, 1 for the first record */
+    __u32 status;               /* NPU_CQ_STATUS_* bits, opcode and core */
+    __u32 cycles;               /* Cycles from instruction issue to result */
+    __u32 error;                /* NPU_CQ_ERR_* */
+};
+
+/* Completion queue state */
+struct npu_cq_info {
+    __u32 enabled;              /* 0 on bitstreams without a completion writer */
+    __u32 entries;
+    __u32 last_seq;             /* Last record consumed by the driver */
+    __u32 reserved;
+};
+
+/* Submit an instruction stream (as write()) and learn its record number */
+struct npu_submit {
+    __u64 words;                /* User pointer to the instruction words */
+    __u32 len;                  /* Stream length in bytes; out: bytes accepted */
+    __u32 seq;                  /* Out: record number of the last instruction */
+};
+
+/* Wait until record seq has been posted */
+struct npu_cq_wait {
+    __u32 seq;
+    __u32 timeout_ms;           /* 0 = infinite */
 };
 
 /* Performance counters structure */
@@ -112,7 +210,8 @@ struct npu_instruction {
     __u32 size;
     __u32 params[8];  /* Operation-specific parameters */
     __u32 flags;
-    __u32 reserved[3];
+    __u32 seq;        /* Out: record number of this instruction */
+    __u32 reserved[2];
 };
 
 /* Batch instruction execution */
@@ -134,7 +233,7 @@ struct npu_mmap_request {
 
 /* Device configuration */
 struct npu_device_config {
-    __u32 pe_enable_mask;    /* Bitmask of enabled processing elements */
+    __u32 pe_enable_mask;    /* Bitmask of enabled processing elements; disabled PEs are clock-gated */
     __u32 clock_frequency;   /* Target clock frequency in MHz */
     __u32 power_mode;        /* 0: performance, 1: balanced, 2: power_save */
     __u32 cache_policy;      /* 0: write-through, 1: write-back */
@@ -168,6 +267,7 @@ struct npu_thermal_info {
 #define NPU_IOCTL_SET_CONFIG         _IOW(FPGA_NPU_MAGIC, 0x02, struct npu_device_config)
 #define NPU_IOCTL_GET_CONFIG         _IOR(FPGA_NPU_MAGIC, 0x03, struct npu_device_config)
 #define NPU_IOCTL_RESET_DEVICE       _IO(FPGA_NPU_MAGIC, 0x04)
+#define NPU_IOCTL_NOP                _IO(FPGA_NPU_MAGIC, 0x05)  /* Returns without touching the device */
 
 /* Status and monitoring */
 #define NPU_IOCTL_GET_STATUS         _IOR(FPGA_NPU_MAGIC, 0x10, __u32)
@@ -175,6 +275,8 @@ struct npu_thermal_info {
 #define NPU_IOCTL_RESET_PERF_COUNTERS _IO(FPGA_NPU_MAGIC, 0x12)
 #define NPU_IOCTL_GET_ERROR_INFO     _IOR(FPGA_NPU_MAGIC, 0x13, struct npu_error_info)
 #define NPU_IOCTL_GET_THERMAL_INFO   _IOR(FPGA_NPU_MAGIC, 0x14, struct npu_thermal_info)
+#define NPU_IOCTL_GET_CORE_STATS     _IOR(FPGA_NPU_MAGIC, 0x15, struct npu_core_stats)
+#define NPU_IOCTL_GET_CQ_INFO        _IOR(FPGA_NPU_MAGIC, 0x16, struct npu_cq_info)
 
 /* Memory management */
 #define NPU_IOCTL_ALLOC_BUFFER       _IOWR(FPGA_NPU_MAGIC, 0x20, struct npu_dma_buffer)
@@ -188,9 +290,11 @@ struct npu_thermal_info {
 #define NPU_IOCTL_DMA_ABORT          _IOW(FPGA_NPU_MAGIC, 0x32, __u32)
 
 /* Instruction execution */
-#define NPU_IOCTL_EXECUTE_INSTRUCTION _IOW(FPGA_NPU_MAGIC, 0x40, struct npu_instruction)
+#define NPU_IOCTL_EXECUTE_INSTRUCTION _IOWR(FPGA_NPU_MAGIC, 0x40, struct npu_instruction)
 #define NPU_IOCTL_EXECUTE_BATCH      _IOW(FPGA_NPU_MAGIC, 0x41, struct npu_instruction_batch)
 #define NPU_IOCTL_WAIT_COMPLETION    _IOW(FPGA_NPU_MAGIC, 0x42, __u32)
+#define NPU_IOCTL_WAIT_SEQ           _IOW(FPGA_NPU_MAGIC, 0x43, struct npu_cq_wait)
+#define NPU_IOCTL_SUBMIT             _IOWR(FPGA_NPU_MAGIC, 0x44, struct npu_submit)
 
 /* Debug and development */
 #define NPU_IOCTL_READ_REGISTER      _IOWR(FPGA_NPU_MAGIC, 0x50, struct { __u32 offset; __u32 value; })
@@ -212,6 +316,9 @@ struct npu_thermal_info {
 #define NPU_INST_FLAG_ASYNC          BIT(0)  /* Asynchronous execution */
 #define NPU_INST_FLAG_HIGH_PRIORITY  BIT(1)  /* High priority execution */
 #define NPU_INST_FLAG_PROFILE        BIT(2)  /* Enable profiling */
+#define NPU_INST_FLAG_TARGET_CORE    BIT(3)  /* Run on core NPU_INST_CORE(flags) */
+#define NPU_INST_CORE_SHIFT          8
+#define NPU_INST_CORE(flags)         (((flags) >> NPU_INST_CORE_SHIFT) & 0xFF)
 
 /* Status register bits */
 #define NPU_STATUS_READY             BIT(0)
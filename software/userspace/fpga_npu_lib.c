@@ -5,6 +5,8 @@
  */
 
 #include "fpga_npu_lib.h"
+#include "npu_cosim.h"
+#include "npu_trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -17,10 +19,22 @@
 #include <math.h>
 #include <stdbool.h>
 #include <stdarg.h>
+#include <dlfcn.h>
+#include <pthread.h>
 
 #define DEVICE_PATH "/dev/fpga_npu"
 #define MAX_BUFFER_SIZE (1024 * 1024)  // 1MB
 #define MAX_MANAGED_BUFFERS 64
+#define CQ_SPIN_NS (20 * 1000)         // Spin on the completion ring before sleeping
+#define PLACEMENT_OPS 16               // Base opcodes the cost model tracks
+#define PLACEMENT_BUCKETS 48           // Power-of-two work sizes
+#define PLACEMENT_WEIGHT 0.125f        // Weight of a new latency in its estimate
+#define PLACEMENT_PROBE_INTERVAL 64    // Calls between runs on the side predicted slower
+#define PLACEMENT_CALIBRATION_RUNS 3   // Best of this many runs per calibration size
+#define PLACEMENT_READBACK_BYTES 16384 // Mapped buffer read to time host readback
+#define PLACE_NPU 0
+#define PLACE_CPU 1
+#define COOP_WEIGHT 0.25f              // Weight of a new throughput split in the NPU share
 
 // Buffer management structure
 struct npu_buffer {
@@ -33,9 +47,22 @@ struct npu_buffer {
     struct npu_context *ctx;   // Parent context
 };
 
+// Co-simulation model entry points, resolved with dlsym()
+struct npu_cosim_ops {
+    void (*destroy)(struct npu_cosim *sim);
+    int (*ioctl)(struct npu_cosim *sim, unsigned long cmd, void *arg);
+    long (*write)(struct npu_cosim *sim, const void *buf, size_t len);
+    void *(*mmap)(struct npu_cosim *sim, size_t len, long offset);
+};
+
 // NPU context structure
 struct npu_context {
+    const struct npu_transport *transport;  // Kernel driver or RTL co-simulation
     int fd;                    // Device file descriptor
+    struct npu_cosim *sim;     // Co-simulation instance
+    void *sim_lib;             // Co-simulation model library
+    struct npu_cosim_ops sim_ops;
+    FILE *trace;               // Instruction stream trace (NPU_TRACE_FILE)
     void *buffer;              // Legacy shared buffer
     size_t buffer_size;        // Legacy buffer size
     uint32_t buffer_offset;    // Current buffer offset
@@ -45,6 +72,48 @@ struct npu_context {
     uint32_t next_buffer_slot; // Next available buffer slot
     size_t total_allocated;    // Total allocated memory
     uint32_t active_buffers;   // Number of active buffers
+    
+    // Multi-core dispatch
+    uint32_t target_core;      // Core for subsequent instructions, or NPU_CORE_ANY
+    uint32_t pe_partition;     // PE mask for subsequent instructions, 0 for all
+    
+    // Completion queue (read-only mapping of the device-written ring)
+    const struct npu_completion *cq;
+    uint32_t cq_submitted;     // Record number the driver gave the last instruction sent
+    uint32_t cq_completed;     // Last record number seen complete
+    
+    // The device has one DMA channel; threads take turns programming it
+    pthread_mutex_t dma_lock;
+    
+    // Host time per operator phase while a profiling session is active
+    bool profiling;
+    uint64_t stage_in_ns;      // Copying operands into the shared buffer
+    uint64_t stage_in_bytes;
+    uint64_t device_ns;        // Instruction writes and completion waits
+    uint64_t stage_out_ns;     // Copying results out of the shared buffer
+    uint64_t stage_out_bytes;
+    
+    // Operator placement (npu_set_placement)
+    npu_placement_t placement;
+    bool placement_calibrated;
+    pthread_mutex_t placement_lock;
+    float placement_ns[PLACEMENT_OPS][2][PLACEMENT_BUCKETS];    // Latency estimates, NPU then CPU
+    uint32_t placement_calls[PLACEMENT_OPS][PLACEMENT_BUCKETS]; // Calls since the last probe
+    float readback_ns_per_byte;    // Extra host time reading a mapped device buffer
+    npu_placement_stats_t placement_stats;
+    
+    // Cooperative matmul host thread pool (npu_set_host_threads)
+    pthread_t *host_threads;
+    uint32_t host_thread_count;
+    pthread_mutex_t coop_lock;
+    pthread_cond_t coop_work;  // A job was posted or the pool is stopping
+    pthread_cond_t coop_done;  // The last thread left the job
+    struct coop_gemm *coop_job;
+    uint32_t coop_generation;  // Jobs posted so far
+    uint32_t coop_pending;     // Threads yet to leave the current job
+    bool coop_stop;
+    bool coop_measured;        // npu_share comes from a cooperative call
+    npu_coop_stats_t coop_stats;
 };
 
 // Status register bits (must match driver)
@@ -53,17 +122,272 @@ struct npu_context {
 #define STATUS_ERROR    (1 << 2)
 #define STATUS_DONE     (1 << 3)
 
+// DMA transfer flags (must match driver)
+#define DMA_FLAG_BLOCKING   (1 << 0)
+#define DMA_FLAG_INTERRUPT  (1 << 1)
+
 // Internal helper functions
 static int calculate_tensor_size(const npu_tensor_t *tensor);
 static int copy_tensor_to_buffer(struct npu_context *ctx, const npu_tensor_t *tensor, uint32_t *offset);
 static int copy_tensor_from_buffer(struct npu_context *ctx, npu_tensor_t *tensor, uint32_t offset);
+static size_t encode_instruction(const npu_instruction_t *inst, uint32_t *words);
+static size_t encode_route(const struct npu_context *ctx, uint32_t *words);
+static void cq_map(struct npu_context *ctx);
+static bool cq_reached(const struct npu_context *ctx, uint32_t seq);
+static uint64_t get_time_ns(void);
+static void trace_open(struct npu_context *ctx);
+static void trace_record(struct npu_context *ctx, uint16_t type, uint16_t arg,
+                         const uint32_t *words, uint32_t count);
+
+/*
+ * Device transport. Every system call on the device goes through one of
+ * these so the library can run against the kernel driver or against the
+ * Verilator model of the RTL (npu_cosim.h) without other changes.
+ */
+struct npu_transport {
+    const char *name;
+    int (*open)(struct npu_context *ctx);
+    void (*close)(struct npu_context *ctx);
+    int (*ioctl)(struct npu_context *ctx, unsigned long cmd, void *arg);
+    ssize_t (*write)(struct npu_context *ctx, const void *buf, size_t len);
+    void *(*mmap)(struct npu_context *ctx, size_t len, int prot, off_t offset);
+    int (*munmap)(struct npu_context *ctx, void *addr, size_t len);
+    uint64_t cq_spin_ns;       // Spin on the completion ring before sleeping
+};
+
+static int device_open(struct npu_context *ctx)
+{
+    ctx->fd = open(DEVICE_PATH, O_RDWR);
+    if (ctx->fd < 0) {
+        fprintf(stderr, "NPU: Failed to open device %s: %s\n", DEVICE_PATH, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+static void device_close(struct npu_context *ctx)
+{
+    if (ctx->fd >= 0) {
+        close(ctx->fd);
+    }
+}
+
+static int device_ioctl(struct npu_context *ctx, unsigned long cmd, void *arg)
+{
+    return ioctl(ctx->fd, cmd, arg);
+}
+
+static ssize_t device_write(struct npu_context *ctx, const void *buf, size_t len)
+{
+    return write(ctx->fd, buf, len);
+}
+
+static void *device_mmap(struct npu_context *ctx, size_t len, int prot, off_t offset)
+{
+    return mmap(NULL, len, prot, MAP_SHARED, ctx->fd, offset);
+}
+
+static int device_munmap(struct npu_context *ctx, void *addr, size_t len)
+{
+    (void)ctx;
+    return munmap(addr, len);
+}
+
+static int cosim_open(struct npu_context *ctx)
+{
+    const char *path = getenv("NPU_COSIM_LIB");
+    int (*abi_version)(void);
+    struct npu_cosim *(*create)(void);
+    
+    if (!path) {
+        path = NPU_COSIM_LIB_DEFAULT;
+    }
+    
+    ctx->sim_lib = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (!ctx->sim_lib) {
+        fprintf(stderr, "NPU: Failed to load co-simulation model %s: %s\n", path, dlerror());
+        return -1;
+    }
+    
+    abi_version = (int (*)(void))dlsym(ctx->sim_lib, "npu_cosim_abi_version");
+    create = (struct npu_cosim *(*)(void))dlsym(ctx->sim_lib, "npu_cosim_create");
+    ctx->sim_ops.destroy = (void (*)(struct npu_cosim *))dlsym(ctx->sim_lib, "npu_cosim_destroy");
+    ctx->sim_ops.ioctl = (int (*)(struct npu_cosim *, unsigned long, void *))
+        dlsym(ctx->sim_lib, "npu_cosim_ioctl");
+    ctx->sim_ops.write = (long (*)(struct npu_cosim *, const void *, size_t))
+        dlsym(ctx->sim_lib, "npu_cosim_write");
+    ctx->sim_ops.mmap = (void *(*)(struct npu_cosim *, size_t, long))
+        dlsym(ctx->sim_lib, "npu_cosim_mmap");
+    
+    if (!abi_version || !create || !ctx->sim_ops.destroy || !ctx->sim_ops.ioctl ||
+        !ctx->sim_ops.write || !ctx->sim_ops.mmap) {
+        fprintf(stderr, "NPU: %s is not a co-simulation model\n", path);
+        goto fail;
+    }
+    if (abi_version() != NPU_COSIM_ABI_VERSION) {
+        fprintf(stderr, "NPU: Co-simulation ABI %d, expected %d\n",
+                abi_version(), NPU_COSIM_ABI_VERSION);
+        goto fail;
+    }
+    
+    ctx->sim = create();
+    if (!ctx->sim) {
+        fprintf(stderr, "NPU: Failed to create co-simulation model\n");
+        goto fail;
+    }
+    return 0;
+    
+fail:
+    dlclose(ctx->sim_lib);
+    ctx->sim_lib = NULL;
+    return -1;
+}
+
+static void cosim_close(struct npu_context *ctx)
+{
+    if (ctx->sim) {
+        ctx->sim_ops.destroy(ctx->sim);
+    }
+    if (ctx->sim_lib) {
+        dlclose(ctx->sim_lib);
+    }
+}
+
+static int cosim_ioctl(struct npu_context *ctx, unsigned long cmd, void *arg)
+{
+    int ret = ctx->sim_ops.ioctl(ctx->sim, cmd, arg);
+    
+    if (ret < 0) {
+        errno = -ret;
+        return -1;
+    }
+    return ret;
+}
+
+static ssize_t cosim_write(struct npu_context *ctx, const void *buf, size_t len)
+{
+    long ret = ctx->sim_ops.write(ctx->sim, buf, len);
+    
+    if (ret < 0) {
+        errno = (int)-ret;
+        return -1;
+    }
+    return ret;
+}
+
+static void *cosim_mmap(struct npu_context *ctx, size_t len, int prot, off_t offset)
+{
+    void *addr;
+    
+    (void)prot;
+    addr = ctx->sim_ops.mmap(ctx->sim, len, (long)offset);
+    if (!addr) {
+        errno = EINVAL;
+        return MAP_FAILED;
+    }
+    return addr;
+}
+
+static int cosim_munmap(struct npu_context *ctx, void *addr, size_t len)
+{
+    // Mappings belong to the model and go away with their buffer
+    (void)ctx;
+    (void)addr;
+    (void)len;
+    return 0;
+}
+
+static const struct npu_transport device_transport = {
+    .name = "device",
+    .open = device_open,
+    .close = device_close,
+    .ioctl = device_ioctl,
+    .write = device_write,
+    .mmap = device_mmap,
+    .munmap = device_munmap,
+    .cq_spin_ns = CQ_SPIN_NS
+};
+
+// Simulated time only advances inside the model, so spinning cannot see progress
+static const struct npu_transport cosim_transport = {
+    .name = "cosim",
+    .open = cosim_open,
+    .close = cosim_close,
+    .ioctl = cosim_ioctl,
+    .write = cosim_write,
+    .mmap = cosim_mmap,
+    .munmap = cosim_munmap,
+    .cq_spin_ns = 0
+};
+
+static inline int npu_ioctl(struct npu_context *ctx, unsigned long cmd, void *arg)
+{
+    return ctx->transport->ioctl(ctx, cmd, arg);
+}
+
+/**
+ * Send an instruction stream. Records are numbered per device, so with a
+ * completion queue the stream goes through NPU_IOCTL_SUBMIT to learn the
+ * number the driver gave its last instruction.
+ * @return Bytes accepted, -1 on failure
+ */
+static ssize_t submit_words(struct npu_context *ctx, const void *words, size_t len)
+{
+    struct npu_submit req;
+    
+    if (!ctx->cq) {
+        return ctx->transport->write(ctx, words, len);
+    }
+    
+    memset(&req, 0, sizeof(req));
+    req.words = (uint64_t)(uintptr_t)words;
+    req.len = (uint32_t)len;
+    if (npu_ioctl(ctx, NPU_IOCTL_SUBMIT, &req) < 0) {
+        return -1;
+    }
+    ctx->cq_submitted = req.seq;
+    return req.len;
+}
+
+/**
+ * Run one instruction through the driver and remember its record number
+ */
+static int execute_ioctl(struct npu_context *ctx, struct npu_instruction *inst)
+{
+    if (npu_ioctl(ctx, NPU_IOCTL_EXECUTE_INSTRUCTION, inst) < 0) {
+        return -1;
+    }
+    if (ctx->cq) {
+        ctx->cq_submitted = inst->seq;
+    }
+    return 0;
+}
 
 /**
  * Initialize NPU library and open device
  */
 npu_handle_t npu_init(void)
+{
+    const char *backend = getenv("NPU_BACKEND");
+    
+    if (backend && strcmp(backend, "cosim") == 0) {
+        return npu_init_backend(NPU_BACKEND_COSIM);
+    }
+    return npu_init_backend(NPU_BACKEND_DEVICE);
+}
+
+/**
+ * Initialize NPU library on an explicit backend
+ */
+npu_handle_t npu_init_backend(npu_backend_t backend)
 {
     struct npu_context *ctx;
+    const char *placement = getenv("NPU_PLACEMENT");
+    const char *host_threads = getenv("NPU_HOST_THREADS");
+    
+    if (backend != NPU_BACKEND_DEVICE && backend != NPU_BACKEND_COSIM) {
+        return NULL;
+    }
     
     ctx = malloc(sizeof(struct npu_context));
     if (!ctx) {
@@ -76,11 +400,31 @@ npu_handle_t npu_init(void)
     ctx->next_buffer_slot = 0;
     ctx->total_allocated = 0;
     ctx->active_buffers = 0;
+    ctx->target_core = NPU_CORE_ANY;
+    ctx->pe_partition = 0;
+    ctx->profiling = false;
+    ctx->placement = NPU_PLACEMENT_NPU;
+    ctx->placement_calibrated = false;
+    ctx->readback_ns_per_byte = 0.0f;
+    memset(ctx->placement_ns, 0, sizeof(ctx->placement_ns));
+    memset(ctx->placement_calls, 0, sizeof(ctx->placement_calls));
+    memset(&ctx->placement_stats, 0, sizeof(ctx->placement_stats));
+    ctx->host_threads = NULL;
+    ctx->host_thread_count = 0;
+    ctx->coop_job = NULL;
+    ctx->coop_generation = 0;
+    ctx->coop_pending = 0;
+    ctx->coop_stop = false;
+    ctx->coop_measured = false;
+    memset(&ctx->coop_stats, 0, sizeof(ctx->coop_stats));
+    ctx->coop_stats.npu_share = 1.0f;
+    ctx->fd = -1;
+    ctx->sim = NULL;
+    ctx->sim_lib = NULL;
+    ctx->transport = backend == NPU_BACKEND_COSIM ? &cosim_transport : &device_transport;
     
     // Open device
-    ctx->fd = open(DEVICE_PATH, O_RDWR);
-    if (ctx->fd < 0) {
-        fprintf(stderr, "NPU: Failed to open device %s: %s\n", DEVICE_PATH, strerror(errno));
+    if (ctx->transport->open(ctx) < 0) {
         free(ctx);
         return NULL;
     }
@@ -90,14 +434,34 @@ npu_handle_t npu_init(void)
     ctx->buffer = malloc(ctx->buffer_size);
     if (!ctx->buffer) {
         fprintf(stderr, "NPU: Failed to allocate buffer\n");
-        close(ctx->fd);
+        ctx->transport->close(ctx);
         free(ctx);
         return NULL;
     }
     
     ctx->buffer_offset = 0;
+    pthread_mutex_init(&ctx->dma_lock, NULL);
+    pthread_mutex_init(&ctx->placement_lock, NULL);
+    pthread_mutex_init(&ctx->coop_lock, NULL);
+    pthread_cond_init(&ctx->coop_work, NULL);
+    pthread_cond_init(&ctx->coop_done, NULL);
+    cq_map(ctx);
+    trace_open(ctx);
+    
+    // Calibration runs on the device, so it waits until the device is up
+    if (placement && strcmp(placement, "cpu") == 0) {
+        npu_set_placement((npu_handle_t)ctx, NPU_PLACEMENT_CPU);
+    } else if (placement && strcmp(placement, "auto") == 0 &&
+               npu_set_placement((npu_handle_t)ctx, NPU_PLACEMENT_AUTO) != NPU_SUCCESS) {
+        fprintf(stderr, "NPU: Placement calibration failed, offloading every operator\n");
+    }
+    
+    if (host_threads && atoi(host_threads) > 0 &&
+        npu_set_host_threads((npu_handle_t)ctx, (uint32_t)atoi(host_threads)) != NPU_SUCCESS) {
+        fprintf(stderr, "NPU: Failed to start %s host threads, matmuls are not shared\n", host_threads);
+    }
     
-    printf("NPU: Initialized successfully\n");
+    printf("NPU: Initialized successfully (%s)\n", ctx->transport->name);
     return (npu_handle_t)ctx;
 }
 
@@ -112,6 +476,8 @@ int npu_cleanup(npu_handle_t handle)
         return NPU_ERROR_INVALID;
     }
     
+    npu_set_host_threads(handle, 0);
+    
     // Free all managed buffers
     for (int i = 0; i < MAX_MANAGED_BUFFERS; i++) {
         if (ctx->managed_buffers[i]) {
@@ -123,10 +489,21 @@ int npu_cleanup(npu_handle_t handle)
         free(ctx->buffer);
     }
     
-    if (ctx->fd >= 0) {
-        close(ctx->fd);
+    if (ctx->cq) {
+        ctx->transport->munmap(ctx, (void *)ctx->cq, NPU_CQ_ENTRIES * sizeof(struct npu_completion));
     }
     
+    ctx->transport->close(ctx);
+    
+    if (ctx->trace) {
+        fclose(ctx->trace);
+    }
+    
+    pthread_mutex_destroy(&ctx->dma_lock);
+    pthread_mutex_destroy(&ctx->placement_lock);
+    pthread_mutex_destroy(&ctx->coop_lock);
+    pthread_cond_destroy(&ctx->coop_work);
+    pthread_cond_destroy(&ctx->coop_done);
     free(ctx);
     
     printf("NPU: Cleanup completed\n");
@@ -223,7 +600,7 @@ npu_buffer_handle_t npu_buffer_alloc(npu_handle_t handle, size_t size, uint32_t
     dma_req.size = size;
     dma_req.flags = flags;
     
-    if (ioctl(ctx->fd, NPU_IOCTL_ALLOC_BUFFER, &dma_req) < 0) {
+    if (npu_ioctl(ctx, NPU_IOCTL_ALLOC_BUFFER, &dma_req) < 0) {
         fprintf(stderr, "NPU: Failed to allocate DMA buffer: %s\n", strerror(errno));
         free(buffer);
         return NULL;
@@ -258,7 +635,7 @@ int npu_buffer_free(npu_handle_t handle, npu_buffer_handle_t buffer_handle)
     }
     
     // Free DMA buffer in driver
-    if (ioctl(ctx->fd, NPU_IOCTL_FREE_BUFFER, buffer->buffer_id) < 0) {
+    if (npu_ioctl(ctx, NPU_IOCTL_FREE_BUFFER, (void *)(uintptr_t)buffer->buffer_id) < 0) {
         fprintf(stderr, "NPU: Failed to free DMA buffer: %s\n", strerror(errno));
         return NPU_ERROR_DEVICE;
     }
@@ -323,13 +700,13 @@ void* npu_buffer_map(npu_handle_t handle, npu_buffer_handle_t buffer_handle)
     mmap_req.buffer_id = buffer->buffer_id;
     mmap_req.flags = buffer->flags;
     
-    if (ioctl(ctx->fd, NPU_IOCTL_MMAP_REQUEST, &mmap_req) < 0) {
+    if (npu_ioctl(ctx, NPU_IOCTL_MMAP_REQUEST, &mmap_req) < 0) {
         fprintf(stderr, "NPU: Failed to prepare mmap: %s\n", strerror(errno));
         return NULL;
     }
     
     // Map the buffer
-    mapped_ptr = mmap(NULL, buffer->size, PROT_READ | PROT_WRITE, MAP_SHARED, ctx->fd, 0);
+    mapped_ptr = ctx->transport->mmap(ctx, buffer->size, PROT_READ | PROT_WRITE, 0);
     if (mapped_ptr == MAP_FAILED) {
         fprintf(stderr, "NPU: Failed to map buffer: %s\n", strerror(errno));
         return NULL;
@@ -356,7 +733,7 @@ int npu_buffer_unmap(npu_handle_t handle, npu_buffer_handle_t buffer_handle, voi
         return NPU_ERROR_INVALID;
     }
     
-    if (munmap(ptr, buffer->size) < 0) {
+    if (buffer->ctx->transport->munmap(buffer->ctx, ptr, buffer->size) < 0) {
         fprintf(stderr, "NPU: Failed to unmap buffer: %s\n", strerror(errno));
         return NPU_ERROR_DEVICE;
     }
@@ -379,11 +756,12 @@ int npu_buffer_sync(npu_handle_t handle, npu_buffer_handle_t buffer_handle, uint
         return NPU_ERROR_INVALID;
     }
     
-    if (ioctl(ctx->fd, NPU_IOCTL_DMA_SYNC, buffer->buffer_id) < 0) {
+    if (npu_ioctl(ctx, NPU_IOCTL_DMA_SYNC, (void *)(uintptr_t)buffer->buffer_id) < 0) {
         fprintf(stderr, "NPU: Failed to sync buffer: %s\n", strerror(errno));
         return NPU_ERROR_DEVICE;
     }
     
+    trace_record(ctx, NPU_TRACE_DMA, (uint16_t)direction, NULL, (uint32_t)buffer->size);
     return NPU_SUCCESS;
 }
 
@@ -431,6 +809,44 @@ int npu_buffer_read(npu_handle_t handle, npu_buffer_handle_t buffer_handle, size
     return NPU_SUCCESS;
 }
 
+/**
+ * DMA between a managed buffer and device memory
+ */
+int npu_dma_transfer(npu_handle_t handle, npu_buffer_handle_t buffer_handle, size_t offset,
+                     uint64_t device_addr, size_t size, uint32_t direction, uint32_t timeout_ms)
+{
+    struct npu_context *ctx = (struct npu_context *)handle;
+    struct npu_buffer *buffer = (struct npu_buffer *)buffer_handle;
+    struct npu_dma_transfer transfer;
+    int ret = NPU_SUCCESS;
+    
+    if (!ctx || !buffer || size == 0 || size > buffer->size || offset > buffer->size - size ||
+        (direction != NPU_DMA_TO_DEVICE && direction != NPU_DMA_FROM_DEVICE)) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    memset(&transfer, 0, sizeof(transfer));
+    transfer.buffer_id = buffer->buffer_id;
+    transfer.offset = offset;
+    transfer.size = size;
+    transfer.direction = direction;
+    transfer.flags = DMA_FLAG_BLOCKING | DMA_FLAG_INTERRUPT;
+    transfer.user_addr = device_addr;
+    transfer.timeout_ms = timeout_ms;
+    
+    pthread_mutex_lock(&ctx->dma_lock);
+    if (npu_ioctl(ctx, NPU_IOCTL_DMA_TRANSFER, &transfer) < 0) {
+        ret = errno == ETIMEDOUT ? NPU_ERROR_TIMEOUT :
+              errno == EINVAL ? NPU_ERROR_INVALID : NPU_ERROR_DEVICE;
+    }
+    pthread_mutex_unlock(&ctx->dma_lock);
+    
+    if (ret == NPU_SUCCESS) {
+        trace_record(ctx, NPU_TRACE_DMA, (uint16_t)direction, NULL, (uint32_t)size);
+    }
+    return ret;
+}
+
 /**
  * Create tensor from managed buffer
  */
@@ -520,100 +936,1269 @@ npu_tensor_t npu_create_tensor(void *data, uint32_t n, uint32_t c, uint32_t h, u
         default: element_size = 1; break;
     }
     
-    tensor.size = n * c * h * w * element_size;
+    tensor.size = n * c * h * w * element_size;
+    
+    return tensor;
+}
+
+/**
+ * Encode an instruction as the word stream consumed by the NPU core.
+ * Word 0 is the packed instruction word (opcode, src1, src2, dst bytes).
+ * Descriptor operations (convolution, matmul, pooling) are followed by eight full-width
+ * words: src1, src2, dst, size and params[0..3].
+ * @return Number of words written to words (at most NPU_INST_MAX_WORDS)
+ */
+static size_t encode_instruction(const npu_instruction_t *inst, uint32_t *words)
+{
+    uint32_t opcode = (uint32_t)inst->op & 0xFF;
+    
+    words[0] = (opcode << 24) |
+               ((inst->src1_addr & 0xFF) << 16) |
+               ((inst->src2_addr & 0xFF) << 8) |
+               (inst->dst_addr & 0xFF);
+    
+    if ((opcode & NPU_OP_BASE_MASK) != NPU_OP_CONV &&
+        (opcode & NPU_OP_BASE_MASK) != NPU_OP_MATMUL &&
+        (opcode & NPU_OP_BASE_MASK) != NPU_OP_POOLING) {
+        return 1;
+    }
+    
+    words[1] = inst->src1_addr;
+    words[2] = inst->src2_addr;
+    words[3] = inst->dst_addr;
+    words[4] = inst->size;
+    for (int i = 0; i < 4; i++) {
+        words[5 + i] = inst->params[i];
+    }
+    return NPU_INST_MAX_WORDS;
+}
+
+/**
+ * Emit the routing prefix that pins the next instruction to ctx->target_core
+ * and restricts it to the ctx->pe_partition PEs.
+ * @return Number of words written (0 when the defaults apply)
+ */
+static size_t encode_route(const struct npu_context *ctx, uint32_t *words)
+{
+    if (ctx->target_core == NPU_CORE_ANY && ctx->pe_partition == 0) {
+        return 0;
+    }
+    
+    words[0] = ((uint32_t)NPU_OP_ROUTE << 24) | ((ctx->target_core & 0xFF) << 16) |
+               (ctx->pe_partition & 0xFFFF);
+    return 1;
+}
+
+/**
+ * Execute single NPU instruction
+ */
+int npu_execute_instruction(npu_handle_t handle, const npu_instruction_t *inst)
+{
+    struct npu_context *ctx = (struct npu_context *)handle;
+    uint32_t words[NPU_INST_MAX_WORDS + 1];
+    size_t len;
+    ssize_t bytes_written;
+    
+    if (!ctx || !inst) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    // Encode into a local stream so tensors staged in the shared buffer survive
+    len = encode_route(ctx, words);
+    len += encode_instruction(inst, words + len);
+    len *= sizeof(uint32_t);
+    
+    // Send to device
+    uint64_t start = ctx->profiling ? get_time_ns() : 0;
+    bytes_written = submit_words(ctx, words, len);
+    if (ctx->profiling) {
+        ctx->device_ns += get_time_ns() - start;
+    }
+    if (bytes_written != (ssize_t)len) {
+        fprintf(stderr, "NPU: Failed to write instruction\n");
+        return NPU_ERROR_DEVICE;
+    }
+    
+    trace_record(ctx, NPU_TRACE_WORDS, 0, words, len / sizeof(uint32_t));
+    return NPU_SUCCESS;
+}
+
+/**
+ * Execute batch of NPU instructions
+ */
+int npu_execute_batch(npu_handle_t handle, const npu_instruction_t *instructions, size_t count)
+{
+    struct npu_context *ctx = (struct npu_context *)handle;
+    uint32_t *words;
+    size_t batch_size = 0;
+    ssize_t bytes_written;
+    
+    if (!ctx || !instructions || count == 0) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    words = (uint32_t *)ctx->buffer;
+    
+    if (count * (NPU_INST_MAX_WORDS + 1) * sizeof(uint32_t) > ctx->buffer_size) {
+        return NPU_ERROR_MEMORY;
+    }
+    
+    // Encode instructions into the buffer, each with its routing prefix
+    for (size_t i = 0; i < count; i++) {
+        batch_size += encode_route(ctx, words + batch_size);
+        batch_size += encode_instruction(&instructions[i], words + batch_size);
+    }
+    batch_size *= sizeof(uint32_t);
+    
+    // Send to device
+    uint64_t start = ctx->profiling ? get_time_ns() : 0;
+    bytes_written = submit_words(ctx, ctx->buffer, batch_size);
+    if (ctx->profiling) {
+        ctx->device_ns += get_time_ns() - start;
+    }
+    if (bytes_written != (ssize_t)batch_size) {
+        fprintf(stderr, "NPU: Failed to write instruction batch\n");
+        return NPU_ERROR_DEVICE;
+    }
+    
+    trace_record(ctx, NPU_TRACE_WORDS, 0, words, batch_size / sizeof(uint32_t));
+    return NPU_SUCCESS;
+}
+
+/**
+ * Select the core for subsequent instructions
+ */
+int npu_set_target_core(npu_handle_t handle, uint32_t core)
+{
+    struct npu_context *ctx = (struct npu_context *)handle;
+    struct npu_device_info info;
+    
+    if (!ctx) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    if (core != NPU_CORE_ANY) {
+        if (npu_ioctl(ctx, NPU_IOCTL_GET_DEVICE_INFO, &info) < 0) {
+            return NPU_ERROR_DEVICE;
+        }
+        if (core >= (info.core_count ? info.core_count : 1)) {
+            return NPU_ERROR_INVALID;
+        }
+    }
+    
+    ctx->target_core = core;
+    return NPU_SUCCESS;
+}
+
+/**
+ * Restrict subsequent instructions to a partition of the PE array
+ */
+int npu_set_pe_partition(npu_handle_t handle, uint32_t pe_mask)
+{
+    struct npu_context *ctx = (struct npu_context *)handle;
+    struct npu_device_info info;
+    
+    if (!ctx) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    if (pe_mask != 0) {
+        if (npu_ioctl(ctx, NPU_IOCTL_GET_DEVICE_INFO, &info) < 0) {
+            return NPU_ERROR_DEVICE;
+        }
+        if (info.pe_count < 32 && (pe_mask >> info.pe_count) != 0) {
+            return NPU_ERROR_INVALID;
+        }
+    }
+    
+    ctx->pe_partition = pe_mask;
+    return NPU_SUCCESS;
+}
+
+/**
+ * Map the completion queue read-only; without one, waits use the driver
+ */
+static void cq_map(struct npu_context *ctx)
+{
+    struct npu_cq_info info;
+    void *ring;
+    
+    ctx->cq = NULL;
+    ctx->cq_submitted = 0;
+    ctx->cq_completed = 0;
+    
+    if (npu_ioctl(ctx, NPU_IOCTL_GET_CQ_INFO, &info) < 0 || !info.enabled ||
+        info.entries != NPU_CQ_ENTRIES) {
+        return;
+    }
+    
+    ring = ctx->transport->mmap(ctx, NPU_CQ_ENTRIES * sizeof(struct npu_completion), PROT_READ,
+                                NPU_CQ_MMAP_OFFSET);
+    if (ring == MAP_FAILED) {
+        return;
+    }
+    
+    ctx->cq = (const struct npu_completion *)ring;
+    ctx->cq_submitted = info.last_seq;
+    ctx->cq_completed = info.last_seq;
+}
+
+/**
+ * Start an instruction stream trace if NPU_TRACE_FILE is set
+ */
+static void trace_open(struct npu_context *ctx)
+{
+    const char *path = getenv("NPU_TRACE_FILE");
+    struct npu_trace_header header = { NPU_TRACE_MAGIC, NPU_TRACE_VERSION };
+    
+    ctx->trace = NULL;
+    if (!path || !*path) {
+        return;
+    }
+    
+    ctx->trace = fopen(path, "wb");
+    if (!ctx->trace) {
+        fprintf(stderr, "NPU: Failed to open trace %s: %s\n", path, strerror(errno));
+        return;
+    }
+    fwrite(&header, sizeof(header), 1, ctx->trace);
+}
+
+/**
+ * Append one record (and its instruction words) to the trace
+ */
+static void trace_record(struct npu_context *ctx, uint16_t type, uint16_t arg,
+                         const uint32_t *words, uint32_t count)
+{
+    struct npu_trace_record rec = { type, arg, count };
+    
+    if (!ctx->trace) {
+        return;
+    }
+    
+    fwrite(&rec, sizeof(rec), 1, ctx->trace);
+    if (words) {
+        fwrite(words, sizeof(uint32_t), count, ctx->trace);
+    }
+}
+
+/**
+ * Whether the device has posted record seq (wrap-safe)
+ */
+static bool cq_reached(const struct npu_context *ctx, uint32_t seq)
+{
+    const struct npu_completion *rec = &ctx->cq[(seq - 1) % NPU_CQ_ENTRIES];
+    
+    return (int32_t)(__atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE) - seq) >= 0;
+}
+
+static int wait_for_completion(struct npu_context *ctx, uint32_t timeout_ms)
+{
+    struct npu_cq_wait req;
+    uint32_t target, seq;
+    uint64_t spin_end;
+    int ret = NPU_SUCCESS;
+    
+    trace_record(ctx, NPU_TRACE_WAIT, 0, NULL, 0);
+    
+    if (!ctx->cq) {
+        if (npu_ioctl(ctx, NPU_IOCTL_WAIT_COMPLETION, &timeout_ms) < 0) {
+            return errno == ETIMEDOUT ? NPU_ERROR_TIMEOUT : NPU_ERROR_DEVICE;
+        }
+        return NPU_SUCCESS;
+    }
+    
+    // Nothing sent since the last wait, or only work already seen complete
+    target = ctx->cq_submitted;
+    if ((int32_t)(target - ctx->cq_completed) <= 0) {
+        return NPU_SUCCESS;
+    }
+    
+    // Short operations finish within the spin; longer ones sleep in the driver
+    spin_end = get_time_ns() + ctx->transport->cq_spin_ns;
+    while (!cq_reached(ctx, target)) {
+        if (get_time_ns() < spin_end) {
+            continue;
+        }
+        req.seq = target;
+        req.timeout_ms = timeout_ms;
+        if (npu_ioctl(ctx, NPU_IOCTL_WAIT_SEQ, &req) < 0) {
+            return errno == ETIMEDOUT ? NPU_ERROR_TIMEOUT : NPU_ERROR_DEVICE;
+        }
+        break;
+    }
+    
+    // Report an error from any record since the last wait still in the ring
+    seq = target - ctx->cq_completed > NPU_CQ_ENTRIES ? target - NPU_CQ_ENTRIES : ctx->cq_completed;
+    while (seq != target) {
+        const struct npu_completion *rec = &ctx->cq[seq % NPU_CQ_ENTRIES];
+        
+        seq++;
+        if (__atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE) == seq && rec->error != NPU_CQ_ERR_NONE) {
+            ret = NPU_ERROR_DEVICE;
+        }
+    }
+    
+    ctx->cq_completed = target;
+    return ret;
+}
+
+/**
+ * Wait for NPU operation completion
+ */
+int npu_wait_completion(npu_handle_t handle, uint32_t timeout_ms)
+{
+    struct npu_context *ctx = (struct npu_context *)handle;
+    uint64_t start;
+    int ret;
+    
+    if (!ctx) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    if (!ctx->profiling) {
+        return wait_for_completion(ctx, timeout_ms);
+    }
+    
+    start = get_time_ns();
+    ret = wait_for_completion(ctx, timeout_ms);
+    ctx->device_ns += get_time_ns() - start;
+    return ret;
+}
+
+/**
+ * Get NPU status
+ */
+int npu_get_status(npu_handle_t handle, uint32_t *status)
+{
+    struct npu_context *ctx = (struct npu_context *)handle;
+    
+    if (!ctx || !status) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    if (npu_ioctl(ctx, NPU_IOCTL_GET_STATUS, status) < 0) {
+        return NPU_ERROR_DEVICE;
+    }
+    
+    return NPU_SUCCESS;
+}
+
+/**
+ * Issue an ioctl that does no work in the driver
+ */
+int npu_null_ioctl(npu_handle_t handle)
+{
+    struct npu_context *ctx = (struct npu_context *)handle;
+    
+    if (!ctx) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    if (npu_ioctl(ctx, NPU_IOCTL_NOP, NULL) < 0) {
+        return NPU_ERROR_DEVICE;
+    }
+    
+    return NPU_SUCCESS;
+}
+
+// Operator placement
+
+// Placement of one operator call
+struct placed_call {
+    uint32_t op;
+    uint32_t bucket;
+    int side;                  // PLACE_NPU or PLACE_CPU
+    bool timed;                // Refines the cost model when it succeeds
+    float readback_ns;         // Modelled host time reading resident operands
+    uint64_t start;
+};
+
+static size_t tensor_elements(const npu_tensor_t *tensor)
+{
+    return (size_t)tensor->dims[0] * tensor->dims[1] * tensor->dims[2] * tensor->dims[3];
+}
+
+static uint32_t work_bucket(uint64_t work)
+{
+    uint32_t bucket = 0;
+    
+    while (work > 1 && bucket < PLACEMENT_BUCKETS - 1) {
+        work >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+/**
+ * Size of a tensor if it lives in a mapped device buffer, else 0
+ */
+static uint64_t tensor_resident_bytes(const struct npu_context *ctx, const npu_tensor_t *tensor)
+{
+    if (!tensor || !tensor->data || ctx->active_buffers == 0) {
+        return 0;
+    }
+    
+    for (int i = 0; i < MAX_MANAGED_BUFFERS; i++) {
+        const struct npu_buffer *buffer = ctx->managed_buffers[i];
+        if (buffer && buffer->is_mapped && (const char *)tensor->data >= (const char *)buffer->mapped_ptr &&
+            (const char *)tensor->data < (const char *)buffer->mapped_ptr + buffer->size) {
+            return tensor->size;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Choose where an operator call runs
+ * @param work MACs of a matmul or conv2d, output elements otherwise
+ * @param host Whether the host kernels support the call
+ * @return PLACE_NPU or PLACE_CPU
+ */
+static int placement_begin(struct npu_context *ctx, struct placed_call *call, uint32_t op, uint64_t work,
+                           bool host, const npu_tensor_t *a, const npu_tensor_t *b, const npu_tensor_t *c)
+{
+    call->side = PLACE_NPU;
+    call->timed = false;
+    
+    if (ctx->placement == NPU_PLACEMENT_NPU) {
+        return PLACE_NPU;
+    }
+    
+    pthread_mutex_lock(&ctx->placement_lock);
+    if (!host) {
+        ctx->placement_stats.unsupported++;
+    } else if (ctx->placement == NPU_PLACEMENT_CPU) {
+        call->side = PLACE_CPU;
+    } else {
+        call->op = op;
+        call->bucket = work_bucket(work);
+        call->timed = true;
+        call->readback_ns = ctx->readback_ns_per_byte *
+                            (float)(tensor_resident_bytes(ctx, a) + tensor_resident_bytes(ctx, b) +
+                                     tensor_resident_bytes(ctx, c));
+    
+        float npu_ns = ctx->placement_ns[op][PLACE_NPU][call->bucket];
+        float cpu_ns = ctx->placement_ns[op][PLACE_CPU][call->bucket] + call->readback_ns;
+        call->side = cpu_ns < npu_ns ? PLACE_CPU : PLACE_NPU;
+    
+        // The side predicted slower runs now and then, so that its estimate
+        // follows changes in device and host load
+        if (++ctx->placement_calls[op][call->bucket] >= PLACEMENT_PROBE_INTERVAL) {
+            ctx->placement_calls[op][call->bucket] = 0;
+            call->side = call->side == PLACE_CPU ? PLACE_NPU : PLACE_CPU;
+            ctx->placement_stats.probes++;
+        }
+    }
+    
+    if (call->side == PLACE_CPU) {
+        ctx->placement_stats.cpu_calls++;
+    } else {
+        ctx->placement_stats.npu_calls++;
+    }
+    pthread_mutex_unlock(&ctx->placement_lock);
+    
+    call->start = call->timed ? get_time_ns() : 0;
+    return call->side;
+}
+
+/**
+ * Refine the cost model with the latency of a placed call
+ * @return ret, the result of the call
+ */
+static int placement_end(struct npu_context *ctx, const struct placed_call *call, int ret)
+{
+    if (!call->timed || ret != NPU_SUCCESS) {
+        return ret;
+    }
+    
+    // Readback is modelled separately, so host estimates leave it out
+    float ns = (float)(get_time_ns() - call->start);
+    if (call->side == PLACE_CPU) {
+        ns = ns > call->readback_ns ? ns - call->readback_ns : 0.0f;
+    }
+    
+    pthread_mutex_lock(&ctx->placement_lock);
+    float *estimate = &ctx->placement_ns[call->op][call->side][call->bucket];
+    *estimate += (ns - *estimate) * PLACEMENT_WEIGHT;
+    pthread_mutex_unlock(&ctx->placement_lock);
+    
+    return ret;
+}
+
+/**
+ * Whether the host kernels compute a data type and epilogue
+ * FLOAT32 takes every epilogue but leaky ReLU, whose slope is fixed in
+ * hardware. INT32 takes none or ReLU.
+ */
+static bool host_supports(npu_dtype_t dtype, npu_activation_t act)
+{
+    if (act == NPU_ACT_LEAKY_RELU) {
+        return false;
+    }
+    return dtype == NPU_DTYPE_FLOAT32 || (dtype == NPU_DTYPE_INT32 && act <= NPU_ACT_RELU);
+}
+
+/**
+ * Whether a tensor holds dense 32-bit elements of the given type
+ */
+static bool host_tensor_ok(const npu_tensor_t *tensor, npu_dtype_t dtype)
+{
+    return tensor->data && tensor->dtype == dtype && tensor->size == tensor_elements(tensor) * 4;
+}
+
+static float host_activate(float x, npu_activation_t act, float alpha)
+{
+    switch (act) {
+        case NPU_ACT_RELU:
+            return x > 0.0f ? x : 0.0f;
+        case NPU_ACT_LEAKY_RELU:
+            return x > 0.0f ? x : alpha * x;
+        case NPU_ACT_SIGMOID:
+            return 1.0f / (1.0f + expf(-x));
+        case NPU_ACT_TANH:
+            return tanhf(x);
+        default:
+            return x;
+    }
+}
+
+static double host_load(const npu_tensor_t *tensor, size_t i)
+{
+    if (tensor->dtype == NPU_DTYPE_FLOAT32) {
+        return ((const float *)tensor->data)[i];
+    }
+    return ((const int32_t *)tensor->data)[i];
+}
+
+static void host_store(npu_tensor_t *tensor, size_t i, double value, npu_activation_t act, float alpha)
+{
+    if (tensor->dtype == NPU_DTYPE_FLOAT32) {
+        ((float *)tensor->data)[i] = host_activate((float)value, act, alpha);
+    } else {
+        ((int32_t *)tensor->data)[i] = (int32_t)(act == NPU_ACT_RELU && value < 0.0 ? 0 : (int64_t)value);
+    }
+}
+
+static bool host_matrix_multiply_ok(const npu_tensor_t *a, const npu_tensor_t *b, const npu_tensor_t *c,
+                                    npu_activation_t act)
+{
+    return host_supports(c->dtype, act) && host_tensor_ok(a, c->dtype) && host_tensor_ok(b, c->dtype) &&
+           host_tensor_ok(c, c->dtype) && a->dims[3] == b->dims[2] &&
+           tensor_elements(c) == (size_t)a->dims[2] * b->dims[3];
+}
+
+/**
+ * Rows [first, end) of C = act(A * B)
+ * Each row of A scales rows of B into an accumulator, so B is read in
+ * order rather than down its columns.
+ * @param acc Accumulator for one row of C
+ */
+static void host_matrix_multiply_rows(const npu_tensor_t *a, const npu_tensor_t *b, npu_tensor_t *c,
+                                      npu_activation_t act, uint32_t first, uint32_t end, double *acc)
+{
+    uint32_t k = a->dims[3], n = b->dims[3];
+    
+    for (uint32_t i = first; i < end; i++) {
+        memset(acc, 0, n * sizeof(double));
+        for (uint32_t p = 0; p < k; p++) {
+            double x = host_load(a, (size_t)i * k + p);
+            for (uint32_t j = 0; j < n; j++) {
+                acc[j] += x * host_load(b, (size_t)p * n + j);
+            }
+        }
+        for (uint32_t j = 0; j < n; j++) {
+            host_store(c, (size_t)i * n + j, acc[j], act, 0.0f);
+        }
+    }
+}
+
+static int host_matrix_multiply(const npu_tensor_t *a, const npu_tensor_t *b, npu_tensor_t *c,
+                                npu_activation_t act)
+{
+    double *acc = malloc((size_t)b->dims[3] * sizeof(double));
+    
+    if (!acc) {
+        return NPU_ERROR_MEMORY;
+    }
+    host_matrix_multiply_rows(a, b, c, act, 0, a->dims[2], acc);
+    free(acc);
+    return NPU_SUCCESS;
+}
+
+static bool host_conv2d_ok(const npu_tensor_t *input, const npu_tensor_t *weights, const npu_tensor_t *output,
+                           uint32_t stride_h, uint32_t stride_w, uint32_t pad_h, uint32_t pad_w,
+                           npu_activation_t act)
+{
+    uint32_t k = weights->dims[2];
+    
+    return host_supports(output->dtype, act) && host_tensor_ok(input, output->dtype) &&
+           host_tensor_ok(weights, output->dtype) && host_tensor_ok(output, output->dtype) &&
+           input->dims[2] + 2 * pad_h >= k && input->dims[3] + 2 * pad_w >= k &&
+           output->dims[0] == input->dims[0] && output->dims[1] == weights->dims[0] &&
+           output->dims[2] == (input->dims[2] + 2 * pad_h - k) / stride_h + 1 &&
+           output->dims[3] == (input->dims[3] + 2 * pad_w - k) / stride_w + 1;
+}
+
+static int host_conv2d(const npu_tensor_t *input, const npu_tensor_t *weights, npu_tensor_t *output,
+                       uint32_t stride_h, uint32_t stride_w, uint32_t pad_h, uint32_t pad_w,
+                       npu_activation_t act)
+{
+    uint32_t in_c = input->dims[1], in_h = input->dims[2], in_w = input->dims[3];
+    uint32_t out_c = output->dims[1], out_h = output->dims[2], out_w = output->dims[3];
+    uint32_t k = weights->dims[2];
+    
+    for (uint32_t n = 0; n < output->dims[0]; n++) {
+        for (uint32_t o = 0; o < out_c; o++) {
+            for (uint32_t y = 0; y < out_h; y++) {
+                for (uint32_t x = 0; x < out_w; x++) {
+                    double sum = 0.0;
+                    for (uint32_t c = 0; c < in_c; c++) {
+                        for (uint32_t ky = 0; ky < k; ky++) {
+                            int64_t iy = (int64_t)y * stride_h + ky - pad_h;
+                            if (iy < 0 || iy >= in_h) continue;
+                            for (uint32_t kx = 0; kx < k; kx++) {
+                                int64_t ix = (int64_t)x * stride_w + kx - pad_w;
+                                if (ix < 0 || ix >= in_w) continue;
+                                sum += host_load(input, (((size_t)n * in_c + c) * in_h + iy) * in_w + ix) *
+                                       host_load(weights, (((size_t)o * in_c + c) * k + ky) * k + kx);
+                            }
+                        }
+                    }
+                    host_store(output, (((size_t)n * out_c + o) * out_h + y) * out_w + x, sum, act, 0.0f);
+                }
+            }
+        }
+    }
+    return NPU_SUCCESS;
+}
+
+/**
+ * Whether the host computes an element-wise operator; b is NULL for unary
+ * operators
+ */
+static bool host_elementwise_ok(const npu_tensor_t *a, const npu_tensor_t *b, const npu_tensor_t *c,
+                                npu_activation_t act)
+{
+    return host_supports(c->dtype, act) && host_tensor_ok(a, c->dtype) && host_tensor_ok(c, c->dtype) &&
+           a->size == c->size && (!b || (host_tensor_ok(b, c->dtype) && b->size == c->size));
+}
+
+/**
+ * Element-wise add (NPU_OP_ADD), multiply (NPU_OP_MUL) or, with b NULL,
+ * the activation alone
+ */
+static int host_elementwise(uint32_t op, const npu_tensor_t *a, const npu_tensor_t *b, npu_tensor_t *c,
+                            npu_activation_t act, float alpha)
+{
+    size_t count = tensor_elements(c);
+    
+    for (size_t i = 0; i < count; i++) {
+        double value = host_load(a, i);
+        if (b) {
+            value = op == NPU_OP_MUL ? value * host_load(b, i) : value + host_load(b, i);
+        }
+        host_store(c, i, value, act, alpha);
+    }
+    return NPU_SUCCESS;
+}
+
+/**
+ * Fill every work size of one estimate row from calibrated samples
+ * Sizes between two samples are interpolated on log-log axes; sizes
+ * outside them follow the nearest segment.
+ */
+static void seed_estimates(float *estimates, const uint32_t *buckets, const float *ns, int count)
+{
+    for (uint32_t b = 0; b < PLACEMENT_BUCKETS; b++) {
+        int i = 0;
+        while (i < count - 2 && b > buckets[i + 1]) {
+            i++;
+        }
+    
+        // Latency grows at most about linearly with work and never shrinks
+        float slope = (log2f(ns[i + 1]) - log2f(ns[i])) / (float)(buckets[i + 1] - buckets[i]);
+        if (slope < 0.0f) slope = 0.0f;
+        if (slope > 1.5f) slope = 1.5f;
+        estimates[b] = exp2f(log2f(ns[i]) + slope * ((float)b - (float)buckets[i]));
+    }
+}
+
+/**
+ * Set operator placement policy
+ */
+int npu_set_placement(npu_handle_t handle, npu_placement_t placement)
+{
+    struct npu_context *ctx = (struct npu_context *)handle;
+    int ret;
+    
+    if (!ctx || placement > NPU_PLACEMENT_AUTO) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    if (placement == NPU_PLACEMENT_AUTO && !ctx->placement_calibrated) {
+        ret = npu_calibrate_placement(handle);
+        if (ret != NPU_SUCCESS) return ret;
+    }
+    
+    pthread_mutex_lock(&ctx->placement_lock);
+    ctx->placement = placement;
+    memset(ctx->placement_calls, 0, sizeof(ctx->placement_calls));
+    memset(&ctx->placement_stats, 0, sizeof(ctx->placement_stats));
+    pthread_mutex_unlock(&ctx->placement_lock);
+    
+    return NPU_SUCCESS;
+}
+
+/**
+ * Seed the placement cost model
+ */
+int npu_calibrate_placement(npu_handle_t handle)
+{
+    static const uint32_t matmul_sizes[] = { 4, 8, 16, 32, 64, 128 };
+    static const uint32_t elementwise_shifts[] = { 6, 10, 14, 18 };
+    struct npu_context *ctx = (struct npu_context *)handle;
+    float matmul_ns[2][6], elementwise_ns[2][4];
+    uint32_t matmul_buckets[6], elementwise_buckets[4];
+    size_t max_elements = (size_t)1 << 18;
+    npu_placement_t placement;
+    float *a, *b, *c;
+    int ret = NPU_SUCCESS;
+    
+    if (!ctx) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    a = malloc(max_elements * sizeof(float));
+    b = malloc(max_elements * sizeof(float));
+    c = malloc(max_elements * sizeof(float));
+    if (!a || !b || !c) {
+        free(a);
+        free(b);
+        free(c);
+        return NPU_ERROR_MEMORY;
+    }
+    for (size_t i = 0; i < max_elements; i++) {
+        a[i] = (float)(i % 7) * 0.25f;
+        b[i] = (float)(i % 5) * 0.5f;
+    }
+    
+    // The device runs are timed through the public calls, offloaded
+    placement = ctx->placement;
+    ctx->placement = NPU_PLACEMENT_NPU;
+    
+    for (int s = 0; s < 6 && ret == NPU_SUCCESS; s++) {
+        uint32_t n = matmul_sizes[s];
+        npu_tensor_t ta = npu_create_tensor(a, 1, 1, n, n, NPU_DTYPE_FLOAT32);
+        npu_tensor_t tb = npu_create_tensor(b, 1, 1, n, n, NPU_DTYPE_FLOAT32);
+        npu_tensor_t tc = npu_create_tensor(c, 1, 1, n, n, NPU_DTYPE_FLOAT32);
+    
+        matmul_buckets[s] = work_bucket((uint64_t)n * n * n);
+        matmul_ns[PLACE_NPU][s] = matmul_ns[PLACE_CPU][s] = INFINITY;
+        for (int r = 0; r < PLACEMENT_CALIBRATION_RUNS && ret == NPU_SUCCESS; r++) {
+            uint64_t start = get_time_ns();
+            ret = npu_matrix_multiply(handle, &ta, &tb, &tc);
+            uint64_t middle = get_time_ns();
+            host_matrix_multiply(&ta, &tb, &tc, NPU_ACT_NONE);
+            uint64_t end = get_time_ns();
+            matmul_ns[PLACE_NPU][s] = fminf(matmul_ns[PLACE_NPU][s], (float)(middle - start) + 1.0f);
+            matmul_ns[PLACE_CPU][s] = fminf(matmul_ns[PLACE_CPU][s], (float)(end - middle) + 1.0f);
+        }
+    }
+    
+    for (int s = 0; s < 4 && ret == NPU_SUCCESS; s++) {
+        npu_tensor_t ta = npu_create_tensor(a, 1, 1, 1, 1u << elementwise_shifts[s], NPU_DTYPE_FLOAT32);
+        npu_tensor_t tb = npu_create_tensor(b, 1, 1, 1, 1u << elementwise_shifts[s], NPU_DTYPE_FLOAT32);
+        npu_tensor_t tc = npu_create_tensor(c, 1, 1, 1, 1u << elementwise_shifts[s], NPU_DTYPE_FLOAT32);
+    
+        elementwise_buckets[s] = elementwise_shifts[s];
+        elementwise_ns[PLACE_NPU][s] = elementwise_ns[PLACE_CPU][s] = INFINITY;
+        for (int r = 0; r < PLACEMENT_CALIBRATION_RUNS && ret == NPU_SUCCESS; r++) {
+            uint64_t start = get_time_ns();
+            ret = npu_add(handle, &ta, &tb, &tc);
+            uint64_t middle = get_time_ns();
+            host_elementwise(NPU_OP_ADD, &ta, &tb, &tc, NPU_ACT_NONE, 0.0f);
+            uint64_t end = get_time_ns();
+            elementwise_ns[PLACE_NPU][s] = fminf(elementwise_ns[PLACE_NPU][s], (float)(middle - start) + 1.0f);
+            elementwise_ns[PLACE_CPU][s] = fminf(elementwise_ns[PLACE_CPU][s], (float)(end - middle) + 1.0f);
+        }
+    }
+    
+    // Extra host time per byte when reading a mapped device buffer rather
+    // than ordinary memory; zero if no buffer can be mapped
+    float readback_ns_per_byte = 0.0f;
+    npu_buffer_handle_t buffer = ret == NPU_SUCCESS ?
+                                 npu_buffer_alloc(handle, PLACEMENT_READBACK_BYTES, NPU_ALLOC_COHERENT) : NULL;
+    const volatile uint32_t *mapped = buffer ? npu_buffer_map(handle, buffer) : NULL;
+    if (mapped) {
+        const volatile uint32_t *host = (const volatile uint32_t *)a;
+        uint32_t sum = 0;
+        uint64_t start = get_time_ns();
+        for (size_t i = 0; i < PLACEMENT_READBACK_BYTES / sizeof(uint32_t); i++) {
+            sum += mapped[i];
+        }
+        uint64_t middle = get_time_ns();
+        for (size_t i = 0; i < PLACEMENT_READBACK_BYTES / sizeof(uint32_t); i++) {
+            sum += host[i];
+        }
+        uint64_t end = get_time_ns();
+        (void)sum;
+        if (middle - start > end - middle) {
+            readback_ns_per_byte = (float)((middle - start) - (end - middle)) / PLACEMENT_READBACK_BYTES;
+        }
+    }
+    if (buffer) {
+        npu_buffer_free(handle, buffer);
+    }
+    
+    free(a);
+    free(b);
+    free(c);
+    ctx->placement = placement;
+    if (ret != NPU_SUCCESS) {
+        return ret;
+    }
+    
+    // Conv2d starts from the matmul estimates and the other element-wise
+    // operators from the add estimates, per MAC or element
+    pthread_mutex_lock(&ctx->placement_lock);
+    for (int side = PLACE_NPU; side <= PLACE_CPU; side++) {
+        seed_estimates(ctx->placement_ns[NPU_OP_MATMUL][side], matmul_buckets, matmul_ns[side], 6);
+        seed_estimates(ctx->placement_ns[NPU_OP_ADD][side], elementwise_buckets, elementwise_ns[side], 4);
+        memcpy(ctx->placement_ns[NPU_OP_CONV][side], ctx->placement_ns[NPU_OP_MATMUL][side],
+               sizeof(ctx->placement_ns[NPU_OP_CONV][side]));
+        memcpy(ctx->placement_ns[NPU_OP_MUL][side], ctx->placement_ns[NPU_OP_ADD][side],
+               sizeof(ctx->placement_ns[NPU_OP_MUL][side]));
+        memcpy(ctx->placement_ns[NPU_OP_RELU][side], ctx->placement_ns[NPU_OP_ADD][side],
+               sizeof(ctx->placement_ns[NPU_OP_RELU][side]));
+        memcpy(ctx->placement_ns[NPU_OP_SIGMOID][side], ctx->placement_ns[NPU_OP_ADD][side],
+               sizeof(ctx->placement_ns[NPU_OP_SIGMOID][side]));
+        memcpy(ctx->placement_ns[NPU_OP_TANH][side], ctx->placement_ns[NPU_OP_ADD][side],
+               sizeof(ctx->placement_ns[NPU_OP_TANH][side]));
+    }
+    ctx->readback_ns_per_byte = readback_ns_per_byte;
+    ctx->placement_calibrated = true;
+    pthread_mutex_unlock(&ctx->placement_lock);
+    
+    return NPU_SUCCESS;
+}
+
+/**
+ * Get placement statistics
+ */
+int npu_get_placement_stats(npu_handle_t handle, npu_placement_stats_t *stats)
+{
+    struct npu_context *ctx = (struct npu_context *)handle;
+    
+    if (!ctx || !stats) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    pthread_mutex_lock(&ctx->placement_lock);
+    *stats = ctx->placement_stats;
+    pthread_mutex_unlock(&ctx->placement_lock);
+    return NPU_SUCCESS;
+}
+
+/**
+ * Predicted latency of an operator on each side
+ */
+int npu_get_placement_estimate(npu_handle_t handle, npu_operation_t operation, uint64_t work,
+                               uint64_t resident_bytes, uint64_t *npu_ns, uint64_t *cpu_ns)
+{
+    struct npu_context *ctx = (struct npu_context *)handle;
+    uint32_t op = (uint32_t)operation & NPU_OP_BASE_MASK;
+    uint32_t bucket = work_bucket(work);
+    
+    if (!ctx || !npu_ns || !cpu_ns || op >= PLACEMENT_OPS || !ctx->placement_calibrated) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    pthread_mutex_lock(&ctx->placement_lock);
+    *npu_ns = (uint64_t)ctx->placement_ns[op][PLACE_NPU][bucket];
+    *cpu_ns = (uint64_t)(ctx->placement_ns[op][PLACE_CPU][bucket] +
+                         ctx->readback_ns_per_byte * (float)resident_bytes);
+    pthread_mutex_unlock(&ctx->placement_lock);
+    return NPU_SUCCESS;
+}
+
+// Cooperative matrix multiplication
+
+// A matmul shared between the NPU and the host thread pool
+struct coop_gemm {
+    const npu_tensor_t *a;
+    const npu_tensor_t *b;
+    npu_tensor_t *c;
+    npu_activation_t act;
+    uint64_t tiles;            // Unclaimed tiles: first in the low word, end in the high word
+    uint64_t start;
+    uint64_t cpu_rows;         // Rows computed on the host
+    uint64_t cpu_end;          // When the last host tile finished
+    int error;                 // First host error
+};
+
+/**
+ * Stage a matmul in the shared buffer and run it on the device
+ */
+static int device_matrix_multiply(struct npu_context *ctx, const npu_tensor_t *a, const npu_tensor_t *b,
+                                  npu_tensor_t *c, npu_activation_t act)
+{
+    npu_instruction_t inst;
+    uint32_t offset_a, offset_b, offset_c;
+    int ret;
+    
+    // Reset buffer offset
+    ctx->buffer_offset = 0;
+    
+    // Copy tensors to buffer
+    ret = copy_tensor_to_buffer(ctx, a, &offset_a);
+    if (ret != NPU_SUCCESS) return ret;
+    
+    ret = copy_tensor_to_buffer(ctx, b, &offset_b);
+    if (ret != NPU_SUCCESS) return ret;
+    
+    ret = copy_tensor_to_buffer(ctx, c, &offset_c);
+    if (ret != NPU_SUCCESS) return ret;
+    
+    // Prepare instruction
+    memset(&inst, 0, sizeof(inst));
+    inst.op = (npu_operation_t)NPU_OP_WITH_EPILOGUE(NPU_OP_MATMUL, act);
+    inst.src1_addr = offset_a;
+    inst.src2_addr = offset_b;
+    inst.dst_addr = offset_c;
+    inst.size = c->size;
+    inst.params[0] = a->dims[2];  // M
+    inst.params[1] = a->dims[3];  // K
+    inst.params[2] = b->dims[3];  // N
+    
+    // Execute
+    ret = npu_execute_instruction((npu_handle_t)ctx, &inst);
+    if (ret != NPU_SUCCESS) return ret;
+    
+    ret = npu_wait_completion((npu_handle_t)ctx, 0);
+    if (ret != NPU_SUCCESS) return ret;
+    
+    // Copy result back
+    return copy_tensor_from_buffer(ctx, c, offset_c);
+}
+
+/**
+ * Claim up to count tiles from the top of C, or one from the bottom
+ * @param first First tile claimed
+ * @return Tiles claimed, 0 once the two sides have met
+ */
+static uint32_t coop_claim(struct coop_gemm *job, bool top, uint32_t count, uint32_t *first)
+{
+    uint64_t tiles = __atomic_load_n(&job->tiles, __ATOMIC_ACQUIRE);
+    
+    for (;;) {
+        uint32_t lo = (uint32_t)tiles, hi = (uint32_t)(tiles >> 32);
+        uint32_t n = top ? (count < hi - lo ? count : hi - lo) : (hi > lo ? 1 : 0);
+        uint64_t next = top ? ((uint64_t)hi << 32) | (lo + n) : ((uint64_t)(hi - n) << 32) | lo;
+    
+        if (n == 0) {
+            return 0;
+        }
+        if (__atomic_compare_exchange_n(&job->tiles, &tiles, next, false, __ATOMIC_ACQ_REL,
+                                        __ATOMIC_ACQUIRE)) {
+            *first = top ? lo : hi - n;
+            return n;
+        }
+    }
+}
+
+/**
+ * Compute tiles from the bottom of C until the two sides meet
+ * @param rows Rows computed
+ * @param end When the last tile finished
+ * @return NPU_SUCCESS, or NPU_ERROR_MEMORY if a claimed tile was not computed
+ */
+static int coop_host_tiles(struct coop_gemm *job, uint64_t *rows, uint64_t *end)
+{
+    uint32_t m = job->a->dims[2], first;
+    double *acc = NULL;
+    
+    *rows = 0;
+    while (coop_claim(job, false, 1, &first) > 0) {
+        uint32_t row = first * NPU_COOP_TILE_ROWS;
+        uint32_t last = row + NPU_COOP_TILE_ROWS < m ? row + NPU_COOP_TILE_ROWS : m;
+    
+        if (!acc) {
+            acc = malloc((size_t)job->b->dims[3] * sizeof(double));
+            if (!acc) return NPU_ERROR_MEMORY;
+        }
+        host_matrix_multiply_rows(job->a, job->b, job->c, job->act, row, last, acc);
+        *rows += last - row;
+        *end = get_time_ns();
+    }
+    
+    free(acc);
+    return NPU_SUCCESS;
+}
+
+/**
+ * Add one thread's host tiles to a job; called with coop_lock held
+ */
+static void coop_fold(struct coop_gemm *job, uint64_t rows, uint64_t end, int ret)
+{
+    job->cpu_rows += rows;
+    if (rows > 0 && end > job->cpu_end) {
+        job->cpu_end = end;
+    }
+    if (job->error == NPU_SUCCESS) {
+        job->error = ret;
+    }
+}
+
+static void *coop_worker(void *arg)
+{
+    struct npu_context *ctx = (struct npu_context *)arg;
+    uint32_t generation = 0;   // A job may be posted before the thread first runs
+    
+    pthread_mutex_lock(&ctx->coop_lock);
+    for (;;) {
+        while (!ctx->coop_stop && ctx->coop_generation == generation) {
+            pthread_cond_wait(&ctx->coop_work, &ctx->coop_lock);
+        }
+        if (ctx->coop_stop) {
+            break;
+        }
+    
+        struct coop_gemm *job = ctx->coop_job;
+        uint64_t rows = 0, end = 0;
+        generation = ctx->coop_generation;
+        pthread_mutex_unlock(&ctx->coop_lock);
+    
+        int ret = coop_host_tiles(job, &rows, &end);
+    
+        pthread_mutex_lock(&ctx->coop_lock);
+        coop_fold(job, rows, end, ret);
+        if (--ctx->coop_pending == 0) {
+            pthread_cond_signal(&ctx->coop_done);
+        }
+    }
+    pthread_mutex_unlock(&ctx->coop_lock);
+    return NULL;
+}
+
+/**
+ * Fraction of a matmul's rows planned for the NPU
+ * Until a cooperative call has measured both sides, a calibrated cost model
+ * gives the split, counting each host thread at the speed of one.
+ */
+static float coop_npu_share(struct npu_context *ctx, uint64_t work)
+{
+    float share;
+    bool measured;
+    
+    if (ctx->host_thread_count == 0) {
+        return 1.0f;
+    }
+    
+    // Concurrent calls update the share under coop_lock
+    pthread_mutex_lock(&ctx->coop_lock);
+    share = ctx->coop_stats.npu_share;
+    measured = ctx->coop_measured;
+    pthread_mutex_unlock(&ctx->coop_lock);
+    
+    if (!measured && ctx->placement_calibrated) {
+        pthread_mutex_lock(&ctx->placement_lock);
+        float npu_ns = ctx->placement_ns[NPU_OP_MATMUL][PLACE_NPU][work_bucket(work)];
+        float cpu_ns = ctx->placement_ns[NPU_OP_MATMUL][PLACE_CPU][work_bucket(work)] / ctx->host_thread_count;
+        pthread_mutex_unlock(&ctx->placement_lock);
+        if (npu_ns > 0.0f && cpu_ns > 0.0f) {
+            share = cpu_ns / (npu_ns + cpu_ns);
+        }
+    }
+    return share;
+}
+
+/**
+ * Share a matmul between the NPU and the host thread pool
+ */
+static int coop_matrix_multiply(struct npu_context *ctx, const npu_tensor_t *a, const npu_tensor_t *b,
+                                npu_tensor_t *c, npu_activation_t act)
+{
+    uint32_t m = a->dims[2], k = a->dims[3], n = b->dims[3];
+    uint32_t tiles = (m + NPU_COOP_TILE_ROWS - 1) / NPU_COOP_TILE_ROWS;
+    float share = coop_npu_share(ctx, (uint64_t)m * k * n);
+    uint64_t npu_rows = 0, npu_ns = 0, npu_batches = 0, rows = 0, end = 0;
+    uint32_t max_batch = 0, first, count;
+    struct coop_gemm job;
+    int ret = NPU_SUCCESS;
+    
+    // A batch's rows of A and C have to fit in the shared buffer next to B
+    if (b->size < ctx->buffer_size && k + n > 0) {
+        size_t fit = (ctx->buffer_size - b->size) / ((size_t)(k + n) * 4) / NPU_COOP_TILE_ROWS;
+        max_batch = fit < tiles ? (uint32_t)fit : tiles;
+    }
+    if (max_batch == 0 && ctx->host_thread_count == 0) {
+        return NPU_ERROR_MEMORY;
+    }
+    
+    job.a = a;
+    job.b = b;
+    job.c = c;
+    job.act = act;
+    job.tiles = (uint64_t)tiles << 32;
+    job.start = get_time_ns();
+    job.cpu_rows = 0;
+    job.cpu_end = 0;
+    job.error = NPU_SUCCESS;
+    
+    pthread_mutex_lock(&ctx->coop_lock);
+    ctx->coop_job = &job;
+    ctx->coop_pending = ctx->host_thread_count;
+    ctx->coop_generation++;
+    pthread_cond_broadcast(&ctx->coop_work);
+    pthread_mutex_unlock(&ctx->coop_lock);
+    
+    // Each batch is half the NPU's share of the tiles left, so batches
+    // shrink as the host threads come up from the bottom
+    while (max_batch > 0) {
+        uint64_t left = __atomic_load_n(&job.tiles, __ATOMIC_ACQUIRE);
+        uint32_t want = (uint32_t)ceilf((float)((uint32_t)(left >> 32) - (uint32_t)left) * share * 0.5f);
+    
+        count = coop_claim(&job, true, want < 1 ? 1 : (want > max_batch ? max_batch : want), &first);
+        if (count == 0) {
+            break;
+        }
+    
+        uint32_t row = first * NPU_COOP_TILE_ROWS;
+        uint32_t last = row + count * NPU_COOP_TILE_ROWS < m ? row + count * NPU_COOP_TILE_ROWS : m;
+        npu_tensor_t a_rows = npu_create_tensor((char *)a->data + (size_t)row * k * 4, 1, 1, last - row, k,
+                                                a->dtype);
+        npu_tensor_t c_rows = npu_create_tensor((char *)c->data + (size_t)row * n * 4, 1, 1, last - row, n,
+                                                c->dtype);
+        uint64_t start = get_time_ns();
+    
+        ret = device_matrix_multiply(ctx, &a_rows, b, &c_rows, act);
+        if (ret != NPU_SUCCESS) {
+            // Leave the host threads nothing more to start
+            coop_claim(&job, true, tiles, &first);
+            break;
+        }
+        npu_ns += get_time_ns() - start;
+        npu_rows += last - row;
+        npu_batches++;
+    }
+    
+    // Tiles the NPU could not take are computed here as well
+    if (ret == NPU_SUCCESS) {
+        ret = coop_host_tiles(&job, &rows, &end);
+    }
     
-    return tensor;
+    pthread_mutex_lock(&ctx->coop_lock);
+    coop_fold(&job, rows, end, ret);
+    while (ctx->coop_pending > 0) {
+        pthread_cond_wait(&ctx->coop_done, &ctx->coop_lock);
+    }
+    ctx->coop_job = NULL;
+    
+    // The NPU's share of the throughput measured on this call moves the
+    // split of the next one
+    if (job.error == NPU_SUCCESS && npu_rows > 0 && ctx->host_thread_count > 0) {
+        float npu_rate = (float)npu_rows / (float)(npu_ns + 1);
+        float cpu_rate = (float)job.cpu_rows / (float)(job.cpu_end - job.start + 1);
+        float measured = npu_rate / (npu_rate + cpu_rate);
+        
+        // Fold into the current share, which other calls may have moved since
+        share = ctx->coop_measured ? ctx->coop_stats.npu_share : share;
+        share += (measured - share) * (ctx->coop_measured ? COOP_WEIGHT : 1.0f);
+        ctx->coop_stats.npu_share = share;
+        ctx->coop_measured = true;
+    }
+    ctx->coop_stats.calls++;
+    ctx->coop_stats.npu_rows += npu_rows;
+    ctx->coop_stats.cpu_rows += job.cpu_rows;
+    ctx->coop_stats.npu_batches += npu_batches;
+    pthread_mutex_unlock(&ctx->coop_lock);
+    
+    return job.error;
 }
 
 /**
- * Execute single NPU instruction
+ * Start the host thread pool of cooperative matmuls
  */
-int npu_execute_instruction(npu_handle_t handle, const npu_instruction_t *inst)
+int npu_set_host_threads(npu_handle_t handle, uint32_t threads)
 {
     struct npu_context *ctx = (struct npu_context *)handle;
-    ssize_t bytes_written;
     
-    if (!ctx || !inst) {
+    if (!ctx || threads > NPU_COOP_MAX_THREADS) {
         return NPU_ERROR_INVALID;
     }
     
-    // Copy instruction to buffer
-    memcpy(ctx->buffer, inst, sizeof(npu_instruction_t));
-    
-    // Send to device
-    bytes_written = write(ctx->fd, ctx->buffer, sizeof(npu_instruction_t));
-    if (bytes_written != sizeof(npu_instruction_t)) {
-        fprintf(stderr, "NPU: Failed to write instruction\n");
-        return NPU_ERROR_DEVICE;
+    // Stop the current pool
+    pthread_mutex_lock(&ctx->coop_lock);
+    ctx->coop_stop = true;
+    pthread_cond_broadcast(&ctx->coop_work);
+    pthread_mutex_unlock(&ctx->coop_lock);
+    for (uint32_t i = 0; i < ctx->host_thread_count; i++) {
+        pthread_join(ctx->host_threads[i], NULL);
     }
+    free(ctx->host_threads);
+    ctx->host_threads = NULL;
+    ctx->host_thread_count = 0;
+    ctx->coop_generation = 0;
+    ctx->coop_stop = false;
     
-    return NPU_SUCCESS;
-}
-
-/**
- * Execute batch of NPU instructions
- */
-int npu_execute_batch(npu_handle_t handle, const npu_instruction_t *instructions, size_t count)
-{
-    struct npu_context *ctx = (struct npu_context *)handle;
-    size_t batch_size = count * sizeof(npu_instruction_t);
-    ssize_t bytes_written;
+    // The split depends on the pool size, so it is measured again
+    ctx->coop_measured = false;
+    memset(&ctx->coop_stats, 0, sizeof(ctx->coop_stats));
+    ctx->coop_stats.npu_share = threads > 0 ? 0.5f : 1.0f;
     
-    if (!ctx || !instructions || count == 0) {
-        return NPU_ERROR_INVALID;
+    if (threads == 0) {
+        return NPU_SUCCESS;
     }
     
-    if (batch_size > ctx->buffer_size) {
+    ctx->host_threads = malloc(threads * sizeof(pthread_t));
+    if (!ctx->host_threads) {
         return NPU_ERROR_MEMORY;
     }
     
-    // Copy instructions to buffer
-    memcpy(ctx->buffer, instructions, batch_size);
-    
-    // Send to device
-    bytes_written = write(ctx->fd, ctx->buffer, batch_size);
-    if (bytes_written != (ssize_t)batch_size) {
-        fprintf(stderr, "NPU: Failed to write instruction batch\n");
-        return NPU_ERROR_DEVICE;
+    for (uint32_t i = 0; i < threads; i++) {
+        if (pthread_create(&ctx->host_threads[i], NULL, coop_worker, ctx) != 0) {
+            npu_set_host_threads(handle, 0);
+            return NPU_ERROR_MEMORY;
+        }
+        ctx->host_thread_count++;
     }
     
     return NPU_SUCCESS;
 }
 
 /**
- * Wait for NPU operation completion
+ * Matrix multiplication shared between the NPU and the host thread pool
  */
-int npu_wait_completion(npu_handle_t handle, uint32_t timeout_ms)
+int npu_matrix_multiply_cooperative(npu_handle_t handle, const npu_tensor_t *a, const npu_tensor_t *b,
+                                    npu_tensor_t *c, npu_activation_t act)
 {
     struct npu_context *ctx = (struct npu_context *)handle;
     
-    if (!ctx) {
+    if (!ctx || !a || !b || !c || act > NPU_ACT_TANH) {
         return NPU_ERROR_INVALID;
     }
     
-    // Use ioctl to wait for completion
-    if (ioctl(ctx->fd, 1, 0) < 0) {
-        return NPU_ERROR_DEVICE;
+    if (!host_matrix_multiply_ok(a, b, c, act)) {
+        return device_matrix_multiply(ctx, a, b, c, act);
     }
-    
-    return NPU_SUCCESS;
+    return coop_matrix_multiply(ctx, a, b, c, act);
 }
 
 /**
- * Get NPU status
+ * Get cooperative matmul statistics
  */
-int npu_get_status(npu_handle_t handle, uint32_t *status)
+int npu_get_coop_stats(npu_handle_t handle, npu_coop_stats_t *stats)
 {
     struct npu_context *ctx = (struct npu_context *)handle;
     
-    if (!ctx || !status) {
+    if (!ctx || !stats) {
         return NPU_ERROR_INVALID;
     }
     
-    if (ioctl(ctx->fd, 0, status) < 0) {
-        return NPU_ERROR_DEVICE;
-    }
-    
+    pthread_mutex_lock(&ctx->coop_lock);
+    *stats = ctx->coop_stats;
+    pthread_mutex_unlock(&ctx->coop_lock);
     return NPU_SUCCESS;
 }
 
@@ -621,49 +2206,36 @@ int npu_get_status(npu_handle_t handle, uint32_t *status)
  * Matrix multiplication: C = A * B
  */
 int npu_matrix_multiply(npu_handle_t handle, const npu_tensor_t *a, const npu_tensor_t *b, npu_tensor_t *c)
+{
+    return npu_matrix_multiply_fused(handle, a, b, c, NPU_ACT_NONE);
+}
+
+/**
+ * Matrix multiplication with fused activation epilogue
+ */
+int npu_matrix_multiply_fused(npu_handle_t handle, const npu_tensor_t *a, const npu_tensor_t *b,
+                              npu_tensor_t *c, npu_activation_t act)
 {
     struct npu_context *ctx = (struct npu_context *)handle;
-    npu_instruction_t inst;
-    uint32_t offset_a, offset_b, offset_c;
-    int ret;
+    struct placed_call call;
+    uint64_t work;
+    bool host;
     
-    if (!ctx || !a || !b || !c) {
+    if (!ctx || !a || !b || !c || act > NPU_ACT_TANH) {
         return NPU_ERROR_INVALID;
     }
     
-    // Reset buffer offset
-    ctx->buffer_offset = 0;
-    
-    // Copy tensors to buffer
-    ret = copy_tensor_to_buffer(ctx, a, &offset_a);
-    if (ret != NPU_SUCCESS) return ret;
-    
-    ret = copy_tensor_to_buffer(ctx, b, &offset_b);
-    if (ret != NPU_SUCCESS) return ret;
-    
-    ret = copy_tensor_to_buffer(ctx, c, &offset_c);
-    if (ret != NPU_SUCCESS) return ret;
-    
-    // Prepare instruction
-    memset(&inst, 0, sizeof(inst));
-    inst.op = NPU_OP_MATMUL;
-    inst.src1_addr = offset_a;
-    inst.src2_addr = offset_b;
-    inst.dst_addr = offset_c;
-    inst.size = c->size;
-    inst.params[0] = a->dims[2];  // M
-    inst.params[1] = a->dims[3];  // K
-    inst.params[2] = b->dims[3];  // N
-    
-    // Execute
-    ret = npu_execute_instruction(handle, &inst);
-    if (ret != NPU_SUCCESS) return ret;
-    
-    ret = npu_wait_completion(handle, 0);
-    if (ret != NPU_SUCCESS) return ret;
+    work = (uint64_t)a->dims[2] * a->dims[3] * b->dims[3];
+    host = host_matrix_multiply_ok(a, b, c, act);
+    if (placement_begin(ctx, &call, NPU_OP_MATMUL, work, host, a, b, c) == PLACE_CPU) {
+        return placement_end(ctx, &call, host_matrix_multiply(a, b, c, act));
+    }
     
-    // Copy result back
-    return copy_tensor_from_buffer(ctx, c, offset_c);
+    // Large matmuls share their rows with the host thread pool
+    if (ctx->host_thread_count > 0 && host && work >= NPU_COOP_MIN_MACS) {
+        return placement_end(ctx, &call, coop_matrix_multiply(ctx, a, b, c, act));
+    }
+    return placement_end(ctx, &call, device_matrix_multiply(ctx, a, b, c, act));
 }
 
 /**
@@ -672,16 +2244,44 @@ int npu_matrix_multiply(npu_handle_t handle, const npu_tensor_t *a, const npu_te
 int npu_conv2d(npu_handle_t handle, const npu_tensor_t *input, const npu_tensor_t *weights, 
                npu_tensor_t *output, uint32_t stride_h, uint32_t stride_w, 
                uint32_t pad_h, uint32_t pad_w)
+{
+    return npu_conv2d_fused(handle, input, weights, output, stride_h, stride_w,
+                            pad_h, pad_w, NPU_ACT_NONE);
+}
+
+/**
+ * 2D Convolution with fused activation epilogue
+ */
+int npu_conv2d_fused(npu_handle_t handle, const npu_tensor_t *input, const npu_tensor_t *weights,
+                     npu_tensor_t *output, uint32_t stride_h, uint32_t stride_w,
+                     uint32_t pad_h, uint32_t pad_w, npu_activation_t act)
 {
     struct npu_context *ctx = (struct npu_context *)handle;
     npu_instruction_t inst;
+    struct placed_call call;
     uint32_t offset_input, offset_weights, offset_output;
     int ret;
     
-    if (!ctx || !input || !weights || !output) {
+    if (!ctx || !input || !weights || !output || act > NPU_ACT_TANH) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    // The convolution engine takes square kernels and 4-bit strides/padding
+    if (weights->dims[2] != weights->dims[3] || weights->dims[1] != input->dims[1] ||
+        weights->dims[2] < 1 || weights->dims[2] > 15 ||
+        stride_h < 1 || stride_h > 15 || stride_w < 1 || stride_w > 15 ||
+        pad_h > 15 || pad_w > 15) {
         return NPU_ERROR_INVALID;
     }
     
+    if (placement_begin(ctx, &call, NPU_OP_CONV,
+                        (uint64_t)tensor_elements(output) * input->dims[1] * weights->dims[2] * weights->dims[3],
+                        host_conv2d_ok(input, weights, output, stride_h, stride_w, pad_h, pad_w, act),
+                        input, weights, output) == PLACE_CPU) {
+        return placement_end(ctx, &call, host_conv2d(input, weights, output, stride_h, stride_w,
+                                                     pad_h, pad_w, act));
+    }
+    
     // Reset buffer offset
     ctx->buffer_offset = 0;
     
@@ -697,13 +2297,20 @@ int npu_conv2d(npu_handle_t handle, const npu_tensor_t *input, const npu_tensor_
     
     // Prepare instruction
     memset(&inst, 0, sizeof(inst));
-    inst.op = NPU_OP_CONV;
+    inst.op = (npu_operation_t)NPU_OP_WITH_EPILOGUE(NPU_OP_CONV, act);
     inst.src1_addr = offset_input;
     inst.src2_addr = offset_weights;
     inst.dst_addr = offset_output;
     inst.size = output->size;
     inst.params[0] = (stride_h << 16) | stride_w;
     inst.params[1] = (pad_h << 16) | pad_w;
+    inst.params[2] = (input->dims[2] << 16) | input->dims[3];    // H, W
+    inst.params[3] = (weights->dims[2] << 24) |                   // K
+                     ((input->dims[1] & 0xFFF) << 12) |           // C_in
+                     (weights->dims[0] & 0xFFF);                  // C_out
+    if (weights->dtype == NPU_DTYPE_SPARSE_2_4) {
+        inst.params[3] |= NPU_CONV_SPARSE_2_4;
+    }
     
     // Execute
     ret = npu_execute_instruction(handle, &inst);
@@ -713,7 +2320,90 @@ int npu_conv2d(npu_handle_t handle, const npu_tensor_t *input, const npu_tensor_
     if (ret != NPU_SUCCESS) return ret;
     
     // Copy result back
-    return copy_tensor_from_buffer(ctx, output, offset_output);
+    return placement_end(ctx, &call, copy_tensor_from_buffer(ctx, output, offset_output));
+}
+
+/**
+ * Packed size of 2:4 sparse weights
+ */
+size_t npu_weights_2_4_size(uint32_t out_c, uint32_t in_c, uint32_t kernel_h, uint32_t kernel_w)
+{
+    size_t groups = ((size_t)kernel_h * kernel_w + 3) / 4;
+    size_t meta_words = (groups + 7) / 8;
+    
+    return (size_t)out_c * in_c * (meta_words + 2 * groups) * sizeof(uint32_t);
+}
+
+/**
+ * Pack dense weights into the 2:4 compressed layout read by the convolution engine
+ */
+int npu_pack_weights_2_4(const npu_tensor_t *dense, npu_tensor_t *packed)
+{
+    const int32_t *src;
+    uint32_t *dst;
+    size_t taps, groups, meta_words, block_words, blocks;
+    
+    if (!dense || !packed || !dense->data || !packed->data ||
+        dense->dtype != NPU_DTYPE_INT32) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    taps = (size_t)dense->dims[2] * dense->dims[3];
+    groups = (taps + 3) / 4;
+    meta_words = (groups + 7) / 8;
+    block_words = meta_words + 2 * groups;
+    blocks = (size_t)dense->dims[0] * dense->dims[1];
+    
+    if (taps == 0 || packed->size < blocks * block_words * sizeof(uint32_t)) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    src = (const int32_t *)dense->data;
+    dst = (uint32_t *)packed->data;
+    memset(dst, 0, blocks * block_words * sizeof(uint32_t));
+    
+    for (size_t b = 0; b < blocks; b++) {
+        const int32_t *block = src + b * taps;
+        uint32_t *meta = dst + b * block_words;
+        uint32_t *values = meta + meta_words;
+        
+        for (size_t g = 0; g < groups; g++) {
+            int idx[2] = {-1, -1};
+            int count = 0;
+            
+            for (int t = 0; t < 4 && g * 4 + t < taps; t++) {
+                if (block[g * 4 + t] != 0) {
+                    if (count == 2) {
+                        return NPU_ERROR_INVALID;   // More than two non-zeros in the group
+                    }
+                    idx[count++] = t;
+                }
+            }
+            
+            // Unused slots point at a tap known to be zero (or padding)
+            if (idx[0] < 0) {
+                idx[0] = 0;
+            }
+            if (idx[1] < 0) {
+                idx[1] = (idx[0] == 3) ? 2 : 3;
+            }
+            
+            meta[g / 8] |= (uint32_t)((idx[1] << 2) | idx[0]) << (4 * (g % 8));
+            for (int k = 0; k < 2; k++) {
+                size_t t = g * 4 + idx[k];
+                values[2 * g + k] = (t < taps) ? (uint32_t)block[t] : 0;
+            }
+        }
+    }
+    
+    packed->dims[0] = dense->dims[0];
+    packed->dims[1] = dense->dims[1];
+    packed->dims[2] = dense->dims[2];
+    packed->dims[3] = dense->dims[3];
+    packed->dtype = NPU_DTYPE_SPARSE_2_4;
+    packed->size = blocks * block_words * sizeof(uint32_t);
+    
+    return NPU_SUCCESS;
 }
 
 /**
@@ -721,22 +2411,38 @@ int npu_conv2d(npu_handle_t handle, const npu_tensor_t *input, const npu_tensor_
  */
 int npu_add(npu_handle_t handle, const npu_tensor_t *a, const npu_tensor_t *b, npu_tensor_t *c)
 {
+    return npu_add_fused(handle, a, b, c, NPU_ACT_NONE);
+}
+
+/**
+ * Element-wise addition with fused activation epilogue
+ */
+int npu_add_fused(npu_handle_t handle, const npu_tensor_t *a, const npu_tensor_t *b,
+                  npu_tensor_t *c, npu_activation_t act)
+{
+    struct npu_context *ctx = (struct npu_context *)handle;
     npu_instruction_t inst;
+    struct placed_call call;
     int ret;
     
-    if (!handle || !a || !b || !c) {
+    if (!ctx || !a || !b || !c || act > NPU_ACT_TANH) {
         return NPU_ERROR_INVALID;
     }
     
+    if (placement_begin(ctx, &call, NPU_OP_ADD, tensor_elements(c), host_elementwise_ok(a, b, c, act),
+                        a, b, c) == PLACE_CPU) {
+        return placement_end(ctx, &call, host_elementwise(NPU_OP_ADD, a, b, c, act, 0.0f));
+    }
+    
     // Prepare instruction
     memset(&inst, 0, sizeof(inst));
-    inst.op = NPU_OP_ADD;
+    inst.op = (npu_operation_t)NPU_OP_WITH_EPILOGUE(NPU_OP_ADD, act);
     inst.size = c->size;
     
     ret = npu_execute_instruction(handle, &inst);
     if (ret != NPU_SUCCESS) return ret;
     
-    return npu_wait_completion(handle, 0);
+    return placement_end(ctx, &call, npu_wait_completion(handle, 0));
 }
 
 /**
@@ -744,13 +2450,20 @@ int npu_add(npu_handle_t handle, const npu_tensor_t *a, const npu_tensor_t *b, n
  */
 int npu_multiply(npu_handle_t handle, const npu_tensor_t *a, const npu_tensor_t *b, npu_tensor_t *c)
 {
+    struct npu_context *ctx = (struct npu_context *)handle;
     npu_instruction_t inst;
+    struct placed_call call;
     int ret;
     
-    if (!handle || !a || !b || !c) {
+    if (!ctx || !a || !b || !c) {
         return NPU_ERROR_INVALID;
     }
     
+    if (placement_begin(ctx, &call, NPU_OP_MUL, tensor_elements(c), host_elementwise_ok(a, b, c, NPU_ACT_NONE),
+                        a, b, c) == PLACE_CPU) {
+        return placement_end(ctx, &call, host_elementwise(NPU_OP_MUL, a, b, c, NPU_ACT_NONE, 0.0f));
+    }
+    
     // Prepare instruction
     memset(&inst, 0, sizeof(inst));
     inst.op = NPU_OP_MUL;
@@ -759,7 +2472,7 @@ int npu_multiply(npu_handle_t handle, const npu_tensor_t *a, const npu_tensor_t
     ret = npu_execute_instruction(handle, &inst);
     if (ret != NPU_SUCCESS) return ret;
     
-    return npu_wait_completion(handle, 0);
+    return placement_end(ctx, &call, npu_wait_completion(handle, 0));
 }
 
 /**
@@ -774,7 +2487,7 @@ int npu_get_performance_counters(npu_handle_t handle, uint64_t *cycles, uint64_t
         return NPU_ERROR_INVALID;
     }
     
-    if (ioctl(ctx->fd, NPU_IOCTL_GET_PERF_COUNTERS, &perf) < 0) {
+    if (npu_ioctl(ctx, NPU_IOCTL_GET_PERF_COUNTERS, &perf) < 0) {
         return NPU_ERROR_DEVICE;
     }
     
@@ -795,7 +2508,7 @@ int npu_reset_performance_counters(npu_handle_t handle)
         return NPU_ERROR_INVALID;
     }
     
-    if (ioctl(ctx->fd, NPU_IOCTL_RESET_PERF_COUNTERS) < 0) {
+    if (npu_ioctl(ctx, NPU_IOCTL_RESET_PERF_COUNTERS, NULL) < 0) {
         return NPU_ERROR_DEVICE;
     }
     
@@ -813,7 +2526,7 @@ int npu_get_comprehensive_perf_counters(npu_handle_t handle, struct npu_performa
         return NPU_ERROR_INVALID;
     }
     
-    if (ioctl(ctx->fd, NPU_IOCTL_GET_PERF_COUNTERS, perf) < 0) {
+    if (npu_ioctl(ctx, NPU_IOCTL_GET_PERF_COUNTERS, perf) < 0) {
         return NPU_ERROR_DEVICE;
     }
     
@@ -831,7 +2544,7 @@ int npu_get_device_info(npu_handle_t handle, struct npu_device_info *info)
         return NPU_ERROR_INVALID;
     }
     
-    if (ioctl(ctx->fd, NPU_IOCTL_GET_DEVICE_INFO, info) < 0) {
+    if (npu_ioctl(ctx, NPU_IOCTL_GET_DEVICE_INFO, info) < 0) {
         return NPU_ERROR_DEVICE;
     }
     
@@ -849,7 +2562,25 @@ int npu_get_thermal_info(npu_handle_t handle, struct npu_thermal_info *thermal)
         return NPU_ERROR_INVALID;
     }
     
-    if (ioctl(ctx->fd, NPU_IOCTL_GET_THERMAL_INFO, thermal) < 0) {
+    if (npu_ioctl(ctx, NPU_IOCTL_GET_THERMAL_INFO, thermal) < 0) {
+        return NPU_ERROR_DEVICE;
+    }
+    
+    return NPU_SUCCESS;
+}
+
+/**
+ * Get per-core status and counters
+ */
+int npu_get_core_stats(npu_handle_t handle, struct npu_core_stats *stats)
+{
+    struct npu_context *ctx = (struct npu_context *)handle;
+    
+    if (!handle || !stats) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    if (npu_ioctl(ctx, NPU_IOCTL_GET_CORE_STATS, stats) < 0) {
         return NPU_ERROR_DEVICE;
     }
     
@@ -881,7 +2612,9 @@ static uint64_t get_time_ns(void)
  */
 int npu_start_profiling(npu_handle_t handle)
 {
-    if (!handle) {
+    struct npu_context *ctx = (struct npu_context *)handle;
+    
+    if (!ctx) {
         return NPU_ERROR_INVALID;
     }
     
@@ -905,6 +2638,13 @@ int npu_start_profiling(npu_handle_t handle)
     profiling_session.active = true;
     profiling_session.handle = handle;
     
+    ctx->stage_in_ns = 0;
+    ctx->stage_in_bytes = 0;
+    ctx->device_ns = 0;
+    ctx->stage_out_ns = 0;
+    ctx->stage_out_bytes = 0;
+    ctx->profiling = true;
+    
     return NPU_SUCCESS;
 }
 
@@ -913,6 +2653,7 @@ int npu_start_profiling(npu_handle_t handle)
  */
 int npu_stop_profiling(npu_handle_t handle, npu_perf_profile_t *profile)
 {
+    struct npu_context *ctx = (struct npu_context *)handle;
     struct timespec end_time;
     struct npu_performance_counters end_counters;
     
@@ -951,9 +2692,20 @@ int npu_stop_profiling(npu_handle_t handle, npu_perf_profile_t *profile)
                           profiling_session.start_counters.counters[NPU_PERF_CACHE_HITS];
     profile->cache_misses = end_counters.counters[NPU_PERF_CACHE_MISSES] - 
                             profiling_session.start_counters.counters[NPU_PERF_CACHE_MISSES];
+    profile->macs_nominal = end_counters.counters[NPU_PERF_MACS_NOMINAL] - 
+                            profiling_session.start_counters.counters[NPU_PERF_MACS_NOMINAL];
+    profile->macs_skipped = end_counters.counters[NPU_PERF_MACS_SKIPPED] - 
+                            profiling_session.start_counters.counters[NPU_PERF_MACS_SKIPPED];
+    profile->mult_gated = end_counters.counters[NPU_PERF_MULT_GATED] - 
+                          profiling_session.start_counters.counters[NPU_PERF_MULT_GATED];
     profile->temperature = end_counters.temperature_celsius;
     profile->power_consumption = end_counters.power_watts;
     profile->utilization = end_counters.utilization_percent;
+    profile->stage_in_ns = ctx->stage_in_ns;
+    profile->stage_in_bytes = ctx->stage_in_bytes;
+    profile->device_ns = ctx->device_ns;
+    profile->stage_out_ns = ctx->stage_out_ns;
+    profile->stage_out_bytes = ctx->stage_out_bytes;
     
     // Calculate derived metrics
     uint64_t elapsed_ns = end_ns - start_ns;
@@ -963,6 +2715,7 @@ int npu_stop_profiling(npu_handle_t handle, npu_perf_profile_t *profile)
     
     profiling_session.active = false;
     profiling_session.handle = NULL;
+    ctx->profiling = false;
     
     return NPU_SUCCESS;
 }
@@ -1151,7 +2904,7 @@ int npu_get_error_info(npu_handle_t handle, npu_error_info_t *error_info)
         return NPU_ERROR_INVALID;
     }
     
-    if (ioctl(ctx->fd, NPU_IOCTL_GET_ERROR_INFO, &driver_error) < 0) {
+    if (npu_ioctl(ctx, NPU_IOCTL_GET_ERROR_INFO, &driver_error) < 0) {
         NPU_LOG(NPU_LOG_ERROR, "Failed to get error info from driver");
         return NPU_ERROR_DEVICE;
     }
@@ -1245,7 +2998,7 @@ int npu_validate_tensor(const npu_tensor_t *tensor)
     }
     
     // Validate data type
-    if (tensor->dtype < NPU_DTYPE_INT8 || tensor->dtype > NPU_DTYPE_FLOAT32) {
+    if (tensor->dtype < NPU_DTYPE_INT8 || tensor->dtype > NPU_DTYPE_SPARSE_2_4) {
         NPU_LOG(NPU_LOG_ERROR, "Invalid tensor data type: %d", tensor->dtype);
         return NPU_ERROR_INVALID;
     }
@@ -1334,7 +3087,7 @@ int npu_dump_registers(npu_handle_t handle, uint32_t *registers, uint32_t count)
         return NPU_ERROR_INVALID;
     }
     
-    if (ioctl(ctx->fd, NPU_IOCTL_DUMP_REGISTERS, registers) < 0) {
+    if (npu_ioctl(ctx, NPU_IOCTL_DUMP_REGISTERS, registers) < 0) {
         NPU_LOG(NPU_LOG_ERROR, "Failed to dump registers: %s", strerror(errno));
         return NPU_ERROR_DEVICE;
     }
@@ -1455,9 +3208,14 @@ static int copy_tensor_to_buffer(struct npu_context *ctx, const npu_tensor_t *te
         return NPU_ERROR_MEMORY;
     }
     
+    uint64_t start = ctx->profiling ? get_time_ns() : 0;
     *offset = ctx->buffer_offset;
     memcpy((char *)ctx->buffer + ctx->buffer_offset, tensor->data, tensor->size);
     ctx->buffer_offset += tensor->size;
+    if (ctx->profiling) {
+        ctx->stage_in_ns += get_time_ns() - start;
+        ctx->stage_in_bytes += tensor->size;
+    }
     
     return NPU_SUCCESS;
 }
@@ -1472,7 +3230,12 @@ static int copy_tensor_from_buffer(struct npu_context *ctx, npu_tensor_t *tensor
         return NPU_ERROR_MEMORY;
     }
     
+    uint64_t start = ctx->profiling ? get_time_ns() : 0;
     memcpy(tensor->data, (char *)ctx->buffer + offset, tensor->size);
+    if (ctx->profiling) {
+        ctx->stage_out_ns += get_time_ns() - start;
+        ctx->stage_out_bytes += tensor->size;
+    }
     
     return NPU_SUCCESS;
 }
@@ -1484,6 +3247,7 @@ int npu_relu(npu_handle_t handle, const npu_tensor_t *input, npu_tensor_t *outpu
 {
     struct npu_context *ctx = (struct npu_context *)handle;
     struct npu_instruction inst;
+    struct placed_call call;
     
     if (!ctx || !input || !output) {
         return NPU_ERROR_INVALID;
@@ -1494,6 +3258,13 @@ int npu_relu(npu_handle_t handle, const npu_tensor_t *input, npu_tensor_t *outpu
         return NPU_ERROR_INVALID;
     }
     
+    if (placement_begin(ctx, &call, NPU_OP_RELU, tensor_elements(output),
+                        host_elementwise_ok(input, NULL, output, NPU_ACT_RELU),
+                        input, NULL, output) == PLACE_CPU) {
+        return placement_end(ctx, &call, host_elementwise(NPU_OP_RELU, input, NULL, output,
+                                                          NPU_ACT_RELU, 0.0f));
+    }
+    
     // Prepare ReLU instruction
     memset(&inst, 0, sizeof(inst));
     inst.operation = NPU_OP_RELU;
@@ -1501,11 +3272,11 @@ int npu_relu(npu_handle_t handle, const npu_tensor_t *input, npu_tensor_t *outpu
     inst.flags = NPU_INST_FLAG_ASYNC;
     
     // Execute instruction
-    if (ioctl(ctx->fd, NPU_IOCTL_EXECUTE_INSTRUCTION, &inst) < 0) {
+    if (execute_ioctl(ctx, &inst) < 0) {
         return NPU_ERROR_DEVICE;
     }
     
-    return npu_wait_completion(handle, 0);
+    return placement_end(ctx, &call, npu_wait_completion(handle, 0));
 }
 
 /**
@@ -1515,22 +3286,39 @@ int npu_leaky_relu(npu_handle_t handle, const npu_tensor_t *input, npu_tensor_t
 {
     struct npu_context *ctx = (struct npu_context *)handle;
     struct npu_instruction inst;
+    struct placed_call call;
+    float slope;
     
     if (!ctx || !input || !output) {
         return NPU_ERROR_INVALID;
     }
     
+    // The host takes the slope as given; only FLOAT32 has a fraction
+    if (placement_begin(ctx, &call, NPU_OP_RELU, tensor_elements(output),
+                        output->dtype == NPU_DTYPE_FLOAT32 &&
+                        host_elementwise_ok(input, NULL, output, NPU_ACT_NONE),
+                        input, NULL, output) == PLACE_CPU) {
+        return placement_end(ctx, &call, host_elementwise(NPU_OP_RELU, input, NULL, output,
+                                                          NPU_ACT_LEAKY_RELU, alpha));
+    }
+    
+    // Hardware slope is src2/256; src2 == 0 selects plain ReLU
+    slope = alpha * 256.0f + 0.5f;
+    if (slope < 1.0f) slope = 1.0f;
+    if (slope > 255.0f) slope = 255.0f;
+    
     memset(&inst, 0, sizeof(inst));
     inst.operation = NPU_OP_RELU;
     inst.size = input->size;
+    inst.src2_addr = (uint32_t)slope;
     inst.params[0] = *(uint32_t*)&alpha;  // Pack float as uint32
     inst.flags = NPU_INST_FLAG_ASYNC;
     
-    if (ioctl(ctx->fd, NPU_IOCTL_EXECUTE_INSTRUCTION, &inst) < 0) {
+    if (execute_ioctl(ctx, &inst) < 0) {
         return NPU_ERROR_DEVICE;
     }
     
-    return npu_wait_completion(handle, 0);
+    return placement_end(ctx, &call, npu_wait_completion(handle, 0));
 }
 
 /**
@@ -1540,31 +3328,61 @@ int npu_sigmoid(npu_handle_t handle, const npu_tensor_t *input, npu_tensor_t *ou
 {
     struct npu_context *ctx = (struct npu_context *)handle;
     struct npu_instruction inst;
+    struct placed_call call;
     
     if (!ctx || !input || !output) {
         return NPU_ERROR_INVALID;
     }
     
+    if (placement_begin(ctx, &call, NPU_OP_SIGMOID, tensor_elements(output),
+                        host_elementwise_ok(input, NULL, output, NPU_ACT_SIGMOID),
+                        input, NULL, output) == PLACE_CPU) {
+        return placement_end(ctx, &call, host_elementwise(NPU_OP_SIGMOID, input, NULL, output,
+                                                          NPU_ACT_SIGMOID, 0.0f));
+    }
+    
     memset(&inst, 0, sizeof(inst));
     inst.operation = NPU_OP_SIGMOID;
     inst.size = input->size;
     inst.flags = NPU_INST_FLAG_ASYNC;
     
-    if (ioctl(ctx->fd, NPU_IOCTL_EXECUTE_INSTRUCTION, &inst) < 0) {
+    if (execute_ioctl(ctx, &inst) < 0) {
         return NPU_ERROR_DEVICE;
     }
     
-    return npu_wait_completion(handle, 0);
+    return placement_end(ctx, &call, npu_wait_completion(handle, 0));
 }
 
 /**
- * Tanh activation function (implemented using sigmoid: tanh(x) = 2*sigmoid(2*x) - 1)
+ * Tanh activation function
  */
 int npu_tanh(npu_handle_t handle, const npu_tensor_t *input, npu_tensor_t *output)
 {
-    // For now, use a simplified implementation
-    // In hardware, this would be optimized with dedicated tanh units
-    return npu_sigmoid(handle, input, output);  // Placeholder
+    struct npu_context *ctx = (struct npu_context *)handle;
+    struct npu_instruction inst;
+    struct placed_call call;
+    
+    if (!ctx || !input || !output) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    if (placement_begin(ctx, &call, NPU_OP_TANH, tensor_elements(output),
+                        host_elementwise_ok(input, NULL, output, NPU_ACT_TANH),
+                        input, NULL, output) == PLACE_CPU) {
+        return placement_end(ctx, &call, host_elementwise(NPU_OP_TANH, input, NULL, output,
+                                                          NPU_ACT_TANH, 0.0f));
+    }
+    
+    memset(&inst, 0, sizeof(inst));
+    inst.operation = NPU_OP_TANH;
+    inst.size = input->size;
+    inst.flags = NPU_INST_FLAG_ASYNC;
+    
+    if (execute_ioctl(ctx, &inst) < 0) {
+        return NPU_ERROR_DEVICE;
+    }
+    
+    return placement_end(ctx, &call, npu_wait_completion(handle, 0));
 }
 
 /**
@@ -1627,7 +3445,7 @@ int npu_batch_norm(npu_handle_t handle, const npu_tensor_t *input,
     inst.params[0] = *(uint32_t*)&epsilon;
     inst.flags = NPU_INST_FLAG_ASYNC;
     
-    if (ioctl(ctx->fd, NPU_IOCTL_EXECUTE_INSTRUCTION, &inst) < 0) {
+    if (execute_ioctl(ctx, &inst) < 0) {
         return NPU_ERROR_DEVICE;
     }
     
@@ -1635,34 +3453,69 @@ int npu_batch_norm(npu_handle_t handle, const npu_tensor_t *input,
 }
 
 /**
- * Max pooling 2D
+ * Run a pooling job on the streaming engine.
+ * The descriptor carries {H, W} in src2 and {C, mode} in params[3].
  */
-int npu_max_pool2d(npu_handle_t handle, const npu_tensor_t *input, npu_tensor_t *output,
-                   uint32_t kernel_h, uint32_t kernel_w,
-                   uint32_t stride_h, uint32_t stride_w,
-                   uint32_t pad_h, uint32_t pad_w)
+static int run_pooling(npu_handle_t handle, const npu_tensor_t *input, npu_tensor_t *output,
+                       uint32_t kernel_h, uint32_t kernel_w,
+                       uint32_t stride_h, uint32_t stride_w,
+                       uint32_t pad_h, uint32_t pad_w, uint32_t mode)
 {
     struct npu_context *ctx = (struct npu_context *)handle;
-    struct npu_instruction inst;
+    npu_instruction_t inst;
+    uint32_t offset_input, offset_output;
+    int ret;
     
     if (!ctx || !input || !output) {
         return NPU_ERROR_INVALID;
     }
     
+    if (mode != NPU_POOL_GLOBAL_AVG &&
+        (kernel_h < 1 || kernel_h > 15 || kernel_w < 1 || kernel_w > 15 ||
+         stride_h < 1 || stride_h > 15 || stride_w < 1 || stride_w > 15 ||
+         pad_h > 15 || pad_w > 15)) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    // Reset buffer offset
+    ctx->buffer_offset = 0;
+    
+    ret = copy_tensor_to_buffer(ctx, input, &offset_input);
+    if (ret != NPU_SUCCESS) return ret;
+    
+    ret = copy_tensor_to_buffer(ctx, output, &offset_output);
+    if (ret != NPU_SUCCESS) return ret;
+    
     memset(&inst, 0, sizeof(inst));
-    inst.operation = NPU_OP_POOLING;
-    inst.size = input->size;
+    inst.op = (npu_operation_t)NPU_OP_POOLING;
+    inst.src1_addr = offset_input;
+    inst.src2_addr = (input->dims[2] << 16) | input->dims[3];    // H, W
+    inst.dst_addr = offset_output;
+    inst.size = output->size;
     inst.params[0] = (kernel_h << 16) | kernel_w;
     inst.params[1] = (stride_h << 16) | stride_w;
     inst.params[2] = (pad_h << 16) | pad_w;
-    inst.params[3] = 0;  // Max pooling mode
-    inst.flags = NPU_INST_FLAG_ASYNC;
+    inst.params[3] = ((input->dims[1] & 0xFFF) << 8) | mode;     // C, mode
     
-    if (ioctl(ctx->fd, NPU_IOCTL_EXECUTE_INSTRUCTION, &inst) < 0) {
-        return NPU_ERROR_DEVICE;
-    }
+    ret = npu_execute_instruction(handle, &inst);
+    if (ret != NPU_SUCCESS) return ret;
     
-    return npu_wait_completion(handle, 0);
+    ret = npu_wait_completion(handle, 0);
+    if (ret != NPU_SUCCESS) return ret;
+    
+    return copy_tensor_from_buffer(ctx, output, offset_output);
+}
+
+/**
+ * Max pooling 2D
+ */
+int npu_max_pool2d(npu_handle_t handle, const npu_tensor_t *input, npu_tensor_t *output,
+                   uint32_t kernel_h, uint32_t kernel_w,
+                   uint32_t stride_h, uint32_t stride_w,
+                   uint32_t pad_h, uint32_t pad_w)
+{
+    return run_pooling(handle, input, output, kernel_h, kernel_w,
+                       stride_h, stride_w, pad_h, pad_w, NPU_POOL_MAX);
 }
 
 /**
@@ -1673,27 +3526,8 @@ int npu_avg_pool2d(npu_handle_t handle, const npu_tensor_t *input, npu_tensor_t
                    uint32_t stride_h, uint32_t stride_w,
                    uint32_t pad_h, uint32_t pad_w)
 {
-    struct npu_context *ctx = (struct npu_context *)handle;
-    struct npu_instruction inst;
-    
-    if (!ctx || !input || !output) {
-        return NPU_ERROR_INVALID;
-    }
-    
-    memset(&inst, 0, sizeof(inst));
-    inst.operation = NPU_OP_POOLING;
-    inst.size = input->size;
-    inst.params[0] = (kernel_h << 16) | kernel_w;
-    inst.params[1] = (stride_h << 16) | stride_w;
-    inst.params[2] = (pad_h << 16) | pad_w;
-    inst.params[3] = 1;  // Average pooling mode
-    inst.flags = NPU_INST_FLAG_ASYNC;
-    
-    if (ioctl(ctx->fd, NPU_IOCTL_EXECUTE_INSTRUCTION, &inst) < 0) {
-        return NPU_ERROR_DEVICE;
-    }
-    
-    return npu_wait_completion(handle, 0);
+    return run_pooling(handle, input, output, kernel_h, kernel_w,
+                       stride_h, stride_w, pad_h, pad_w, NPU_POOL_AVG);
 }
 
 /**
@@ -1705,11 +3539,8 @@ int npu_global_avg_pool2d(npu_handle_t handle, const npu_tensor_t *input, npu_te
         return NPU_ERROR_INVALID;
     }
     
-    // Use average pooling with kernel size equal to spatial dimensions
-    uint32_t kernel_h = input->dims[2];  // Height
-    uint32_t kernel_w = input->dims[3];  // Width
-    
-    return npu_avg_pool2d(handle, input, output, kernel_h, kernel_w, 1, 1, 0, 0);
+    // The engine reduces whole planes, so the kernel fields are unused
+    return run_pooling(handle, input, output, 0, 0, 0, 0, 0, 0, NPU_POOL_GLOBAL_AVG);
 }
 
 /**
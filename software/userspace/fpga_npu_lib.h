@@ -39,7 +39,8 @@ typedef enum {
     NPU_DTYPE_INT8,
     NPU_DTYPE_INT16,
     NPU_DTYPE_INT32,
-    NPU_DTYPE_FLOAT32
+    NPU_DTYPE_FLOAT32,
+    NPU_DTYPE_SPARSE_2_4    // INT32 weights packed by npu_pack_weights_2_4
 } npu_dtype_t;
 
 // Tensor descriptor
@@ -56,12 +57,22 @@ typedef struct npu_context* npu_handle_t;
 // NPU buffer handle for managed memory
 typedef struct npu_buffer* npu_buffer_handle_t;
 
+// Device backend
+typedef enum {
+    NPU_BACKEND_DEVICE,     // Kernel driver (/dev/fpga_npu)
+    NPU_BACKEND_COSIM       // Verilator model of the RTL (libnpu_cosim.so)
+} npu_backend_t;
+
 // Buffer allocation flags
 #define NPU_ALLOC_COHERENT    0x01  /* CPU coherent buffer */
 #define NPU_ALLOC_STREAMING   0x02  /* Streaming DMA buffer */
 #define NPU_ALLOC_READONLY    0x04  /* Read-only buffer */
 #define NPU_ALLOC_WRITEONLY   0x08  /* Write-only buffer */
 
+// DMA directions
+#define NPU_DMA_TO_DEVICE     0     /* Managed buffer to device memory */
+#define NPU_DMA_FROM_DEVICE   1     /* Device memory to managed buffer */
+
 // NPU instruction
 typedef struct {
     npu_operation_t op;
@@ -74,10 +85,22 @@ typedef struct {
 
 /**
  * Initialize NPU library and open device
+ * Set NPU_BACKEND=cosim in the environment to run on the co-simulation
+ * model instead of the device. Set NPU_TRACE_FILE to record the
+ * instruction streams, waits and DMAs of the session (npu_trace.h).
  * @return NPU handle on success, NULL on failure
  */
 npu_handle_t npu_init(void);
 
+/**
+ * Initialize NPU library on an explicit backend
+ * The co-simulation model is loaded from NPU_COSIM_LIB if set, otherwise
+ * libnpu_cosim.so on the library search path.
+ * @param backend Device backend
+ * @return NPU handle on success, NULL on failure
+ */
+npu_handle_t npu_init_backend(npu_backend_t backend);
+
 /**
  * Cleanup and close NPU device
  * @param handle NPU handle
@@ -178,6 +201,22 @@ int npu_buffer_write(npu_handle_t handle, npu_buffer_handle_t buffer, size_t off
  */
 int npu_buffer_read(npu_handle_t handle, npu_buffer_handle_t buffer, size_t offset, void *dst, size_t size);
 
+/**
+ * Transfer between a managed buffer and device memory with the DMA engine
+ * @param handle NPU handle
+ * @param buffer Buffer handle
+ * @param offset Offset within buffer
+ * @param device_addr Device memory address
+ * @param size Bytes to transfer (at most the buffer size less offset)
+ * @param direction NPU_DMA_TO_DEVICE or NPU_DMA_FROM_DEVICE
+ * @param timeout_ms Timeout in milliseconds (0 = infinite)
+ * @return NPU_SUCCESS on success, error code on failure
+ * @note Blocks until the transfer completes. The device has one DMA
+ *       channel, so transfers from several threads are serialized.
+ */
+int npu_dma_transfer(npu_handle_t handle, npu_buffer_handle_t buffer, size_t offset,
+                     uint64_t device_addr, size_t size, uint32_t direction, uint32_t timeout_ms);
+
 /**
  * Create tensor from managed buffer
  * @param buffer Buffer handle
@@ -230,11 +269,38 @@ int npu_execute_instruction(npu_handle_t handle, const npu_instruction_t *inst);
  */
 int npu_execute_batch(npu_handle_t handle, const npu_instruction_t *instructions, size_t count);
 
+/**
+ * Select the core that runs subsequent instructions on a multi-core device
+ * @param handle NPU handle
+ * @param core Core index below npu_device_info.core_count, or NPU_CORE_ANY to
+ *             let the hardware work distributor load-balance (the default)
+ * @return NPU_SUCCESS on success, error code on failure
+ * @note Results return in completion order; instructions that depend on each
+ *       other must either target the same core or wait for completion.
+ */
+int npu_set_target_core(npu_handle_t handle, uint32_t core);
+
+/**
+ * Restrict subsequent instructions to a subset of the PE array
+ * @param handle NPU handle
+ * @param pe_mask Bitmask of PEs the instructions may use, or 0 for all PEs
+ * @return NPU_SUCCESS on success, error code on failure
+ * @note The mask is ANDed with the device pe_enable_mask; PEs outside it are
+ *       clock-gated and convolutions spread their output channels over the
+ *       remaining ones. Disjoint masks give isolated partitions, which run
+ *       concurrently when pinned to different cores with npu_set_target_core().
+ */
+int npu_set_pe_partition(npu_handle_t handle, uint32_t pe_mask);
+
 /**
  * Wait for NPU operation completion
  * @param handle NPU handle
  * @param timeout_ms Timeout in milliseconds (0 = infinite)
  * @return NPU_SUCCESS on success, error code on failure
+ * @note On devices with a completion queue this waits for the last submitted
+ *       instruction by watching the completion ring in host memory (briefly
+ *       spinning, then sleeping in the driver) and returns NPU_ERROR_DEVICE
+ *       if any instruction since the previous wait reported an error.
  */
 int npu_wait_completion(npu_handle_t handle, uint32_t timeout_ms);
 
@@ -246,6 +312,15 @@ int npu_wait_completion(npu_handle_t handle, uint32_t timeout_ms);
  */
 int npu_get_status(npu_handle_t handle, uint32_t *status);
 
+/**
+ * Issue an ioctl that returns without touching the device
+ * @param handle NPU handle
+ * @return NPU_SUCCESS on success, error code on failure
+ * @note Measures the cost of a call into the driver (syscall entry, ioctl
+ *       dispatch and return) with nothing else in it
+ */
+int npu_null_ioctl(npu_handle_t handle);
+
 /**
  * Matrix multiplication: C = A * B
  * @param handle NPU handle
@@ -256,8 +331,23 @@ int npu_get_status(npu_handle_t handle, uint32_t *status);
  */
 int npu_matrix_multiply(npu_handle_t handle, const npu_tensor_t *a, const npu_tensor_t *b, npu_tensor_t *c);
 
+/**
+ * Matrix multiplication with fused activation: C = act(A * B)
+ * The activation runs on the writeback path, so no extra pass over C is needed.
+ * @param handle NPU handle
+ * @param a Input matrix A
+ * @param b Input matrix B
+ * @param c Output matrix C
+ * @param act Activation epilogue (NPU_ACT_NONE for plain matmul)
+ * @return NPU_SUCCESS on success, error code on failure
+ */
+int npu_matrix_multiply_fused(npu_handle_t handle, const npu_tensor_t *a, const npu_tensor_t *b,
+                              npu_tensor_t *c, npu_activation_t act);
+
 /**
  * 2D Convolution operation
+ * Runs on the streaming convolution engine: square kernels, strides of 1 or 2,
+ * zero padding generated in hardware.
  * @param handle NPU handle
  * @param input Input tensor (NCHW)
  * @param weights Convolution weights
@@ -272,6 +362,51 @@ int npu_conv2d(npu_handle_t handle, const npu_tensor_t *input, const npu_tensor_
                npu_tensor_t *output, uint32_t stride_h, uint32_t stride_w, 
                uint32_t pad_h, uint32_t pad_w);
 
+/**
+ * 2D Convolution with fused activation: output = act(conv2d(input, weights))
+ * @param handle NPU handle
+ * @param input Input tensor (NCHW)
+ * @param weights Convolution weights (dense, or packed by npu_pack_weights_2_4)
+ * @param output Output tensor
+ * @param stride_h Vertical stride
+ * @param stride_w Horizontal stride
+ * @param pad_h Vertical padding
+ * @param pad_w Horizontal padding
+ * @param act Activation epilogue (NPU_ACT_NONE for plain convolution)
+ * @return NPU_SUCCESS on success, error code on failure
+ */
+int npu_conv2d_fused(npu_handle_t handle, const npu_tensor_t *input, const npu_tensor_t *weights,
+                     npu_tensor_t *output, uint32_t stride_h, uint32_t stride_w,
+                     uint32_t pad_h, uint32_t pad_w, npu_activation_t act);
+
+/**
+ * Size of 2:4 structured-sparse convolution weights once packed
+ * @param out_c Output channels
+ * @param in_c Input channels
+ * @param kernel_h Kernel height
+ * @param kernel_w Kernel width
+ * @return Packed size in bytes
+ */
+size_t npu_weights_2_4_size(uint32_t out_c, uint32_t in_c, uint32_t kernel_h, uint32_t kernel_w);
+
+/**
+ * Pack INT32 convolution weights with 2:4 structured sparsity
+ *
+ * Each [out_c][in_c] block of kernel_h * kernel_w taps is split into
+ * groups of four taps with at most two non-zeros. A block is stored as
+ * metadata words (one nibble per group, eight groups per word; bits [1:0]
+ * and [3:2] hold the tap indices of the two values) followed by the two
+ * values of every group. The packed tensor can be passed as the weights
+ * of npu_conv2d/npu_conv2d_fused, which then reads roughly half the
+ * weight words and issues two MACs per group instead of four.
+ *
+ * @param dense Dense weights (OIHW, NPU_DTYPE_INT32)
+ * @param packed Output tensor; data must hold npu_weights_2_4_size() bytes
+ * @return NPU_SUCCESS on success, NPU_ERROR_INVALID if a group has more
+ *         than two non-zeros or the buffer is too small
+ */
+int npu_pack_weights_2_4(const npu_tensor_t *dense, npu_tensor_t *packed);
+
 /**
  * Element-wise addition: C = A + B
  * @param handle NPU handle
@@ -282,6 +417,19 @@ int npu_conv2d(npu_handle_t handle, const npu_tensor_t *input, const npu_tensor_
  */
 int npu_add(npu_handle_t handle, const npu_tensor_t *a, const npu_tensor_t *b, npu_tensor_t *c);
 
+/**
+ * Element-wise addition with fused activation: C = act(A + B)
+ * Applies a bias and its activation in one instruction.
+ * @param handle NPU handle
+ * @param a Input tensor A
+ * @param b Input tensor B
+ * @param c Output tensor C
+ * @param act Activation epilogue (NPU_ACT_NONE for plain addition)
+ * @return NPU_SUCCESS on success, error code on failure
+ */
+int npu_add_fused(npu_handle_t handle, const npu_tensor_t *a, const npu_tensor_t *b,
+                  npu_tensor_t *c, npu_activation_t act);
+
 /**
  * Element-wise multiplication: C = A * B
  * @param handle NPU handle
@@ -324,6 +472,14 @@ typedef struct {
     uint64_t memory_writes;
     uint64_t cache_hits;
     uint64_t cache_misses;
+    uint64_t macs_nominal;      // MACs issued, zero operands included
+    uint64_t macs_skipped;      // MACs skipped for a zero operand
+    uint64_t mult_gated;        // PE cycles with the multiplier gated
+    uint64_t stage_in_ns;       // Host time copying operands into the device buffer
+    uint64_t stage_in_bytes;
+    uint64_t device_ns;         // Host time writing instructions and waiting for them
+    uint64_t stage_out_ns;      // Host time copying results out of the device buffer
+    uint64_t stage_out_bytes;
     uint32_t temperature;
     uint32_t power_consumption;
     uint32_t utilization;
@@ -355,6 +511,14 @@ int npu_get_device_info(npu_handle_t handle, struct npu_device_info *info);
  */
 int npu_get_thermal_info(npu_handle_t handle, struct npu_thermal_info *thermal);
 
+/**
+ * Get per-core status and counters
+ * @param handle NPU handle
+ * @param stats Pointer to core statistics structure
+ * @return NPU_SUCCESS on success, error code on failure
+ */
+int npu_get_core_stats(npu_handle_t handle, struct npu_core_stats *stats);
+
 /**
  * Start performance profiling session
  * @param handle NPU handle
@@ -396,6 +560,150 @@ float npu_calculate_efficiency(float throughput_gops, float power_watts);
  */
 int npu_benchmark_operation(npu_handle_t handle, npu_operation_t operation, uint32_t iterations, npu_perf_profile_t *profile);
 
+/**
+ * Operator Placement
+ *
+ * For a small tensor, the host finishes an operator before an offload has
+ * paid for its system call, operand copies and completion interrupt. With
+ * automatic placement, each call of a matmul, conv2d or element-wise
+ * operator runs wherever a cost model predicts it finishes first. Graph
+ * nodes are placed the same way on every run.
+ *
+ * The model keeps one latency estimate per operator, side and power-of-two
+ * work size. A calibration run seeds it, and every placed call refines it.
+ * A host estimate also counts reading operands out of mapped device
+ * buffers. Set NPU_PLACEMENT=auto or NPU_PLACEMENT=cpu in the environment
+ * to choose the policy at npu_init().
+ */
+
+// Where operators run
+typedef enum {
+    NPU_PLACEMENT_NPU,          // Always offload (default)
+    NPU_PLACEMENT_CPU,          // On the host, where the host supports the call
+    NPU_PLACEMENT_AUTO          // Wherever the cost model predicts is faster
+} npu_placement_t;
+
+/**
+ * Placement of operator calls since the policy was last set
+ */
+typedef struct {
+    uint64_t npu_calls;
+    uint64_t cpu_calls;
+    uint64_t probes;            // Calls run on the side predicted slower, to refresh its estimate
+    uint64_t unsupported;       // Calls the host cannot run, such as INT8 or sparse weights
+} npu_placement_stats_t;
+
+/**
+ * Set where operators run
+ * Automatic placement calibrates the cost model first if it has not been
+ * calibrated yet.
+ * @param handle NPU handle
+ * @param placement Placement policy
+ * @return NPU_SUCCESS on success, error code on failure
+ */
+int npu_set_placement(npu_handle_t handle, npu_placement_t placement);
+
+/**
+ * Seed the cost model by timing matmuls and element-wise adds of several
+ * sizes on both sides
+ * Conv2d shares the matmul estimates, and the other element-wise operators
+ * share the add estimates, until their own calls refine them.
+ * @param handle NPU handle
+ * @return NPU_SUCCESS on success, error code on failure
+ */
+int npu_calibrate_placement(npu_handle_t handle);
+
+/**
+ * Get placement statistics
+ * @param handle NPU handle
+ * @param stats Placement statistics
+ * @return NPU_SUCCESS on success, error code on failure
+ */
+int npu_get_placement_stats(npu_handle_t handle, npu_placement_stats_t *stats);
+
+/**
+ * Predicted latency of an operator on each side
+ * @param handle NPU handle
+ * @param operation Operation type (NPU_OP_MATMUL, NPU_OP_CONV, NPU_OP_ADD, ...)
+ * @param work MACs of a matmul or conv2d, output elements otherwise
+ * @param resident_bytes Operand bytes held in mapped device buffers
+ * @param npu_ns Predicted NPU latency in nanoseconds
+ * @param cpu_ns Predicted host latency in nanoseconds
+ * @return NPU_SUCCESS on success, error code on failure
+ */
+int npu_get_placement_estimate(npu_handle_t handle, npu_operation_t operation, uint64_t work,
+                               uint64_t resident_bytes, uint64_t *npu_ns, uint64_t *cpu_ns);
+
+/**
+ * Cooperative Matrix Multiplication
+ *
+ * While the NPU computes a large matmul, host cores can compute part of it.
+ * The rows of C are cut into tiles of NPU_COOP_TILE_ROWS rows. The NPU takes
+ * batches of tiles from the top of C, and a pool of host threads takes one
+ * tile at a time from the bottom. They stop when they meet, so both sides
+ * finish within a tile or a batch of each other.
+ *
+ * Each NPU batch is half the NPU's share of the tiles that remain. The share
+ * comes from the throughput each side measured on earlier calls. Batches
+ * therefore shrink as the two sides meet. If the NPU runs slower than
+ * expected, the host threads take the tiles it has not reached.
+ *
+ * If B leaves no room in the shared buffer for a tile of A and C, the host
+ * threads and the calling thread compute every row.
+ *
+ * Start the pool with npu_set_host_threads() or NPU_HOST_THREADS=n in the
+ * environment. Matmuls that would be offloaded and have at least
+ * NPU_COOP_MIN_MACS MACs then run cooperatively.
+ */
+
+#define NPU_COOP_TILE_ROWS  16          // Rows of C per tile
+#define NPU_COOP_MIN_MACS   (1u << 23)  // Smallest matmul npu_matrix_multiply() shares
+#define NPU_COOP_MAX_THREADS 256
+
+/**
+ * Cooperative matmuls since the host thread pool was last started
+ */
+typedef struct {
+    uint64_t calls;
+    uint64_t npu_rows;          // Rows of C computed by the NPU
+    uint64_t cpu_rows;          // Rows of C computed by host threads
+    uint64_t npu_batches;       // Instructions the NPU ran
+    float npu_share;            // Fraction of the rows the next call plans for the NPU
+} npu_coop_stats_t;
+
+/**
+ * Start the host thread pool that shares large matmuls with the NPU
+ * Must not be called while another thread uses the handle.
+ * @param handle NPU handle
+ * @param threads Host threads, or 0 to stop the pool (default)
+ * @return NPU_SUCCESS on success, error code on failure
+ */
+int npu_set_host_threads(npu_handle_t handle, uint32_t threads);
+
+/**
+ * Matrix multiplication shared between the NPU and the host thread pool:
+ * C = act(A * B)
+ * Without a pool the NPU computes every row, in batches that fit the shared
+ * buffer, so A and C may be larger than the buffer; B still has to fit. Data types the host
+ * does not compute are offloaded as one matmul.
+ * @param handle NPU handle
+ * @param a Input matrix A
+ * @param b Input matrix B
+ * @param c Output matrix C
+ * @param act Activation epilogue (NPU_ACT_NONE for plain matmul)
+ * @return NPU_SUCCESS on success, error code on failure
+ */
+int npu_matrix_multiply_cooperative(npu_handle_t handle, const npu_tensor_t *a, const npu_tensor_t *b,
+                                    npu_tensor_t *c, npu_activation_t act);
+
+/**
+ * Get cooperative matmul statistics
+ * @param handle NPU handle
+ * @param stats Cooperative matmul statistics
+ * @return NPU_SUCCESS on success, error code on failure
+ */
+int npu_get_coop_stats(npu_handle_t handle, npu_coop_stats_t *stats);
+
 /**
  * Error Handling and Debugging Functions
  */
@@ -518,6 +826,7 @@ int npu_relu(npu_handle_t handle, const npu_tensor_t *input, npu_tensor_t *outpu
 
 /**
  * Leaky ReLU activation: output = max(alpha*input, input)
+ * The hardware holds alpha in 1/256 steps, clamped to [1/256, 255/256].
  * @param handle NPU handle
  * @param input Input tensor
  * @param output Output tensor
@@ -591,6 +900,7 @@ int npu_max_pool2d(npu_handle_t handle, const npu_tensor_t *input, npu_tensor_t
 
 /**
  * Average pooling operation
+ * Padded positions count towards the window size (count_include_pad).
  * @param handle NPU handle
  * @param input Input tensor
  * @param output Output tensor
@@ -0,0 +1,82 @@
+/**
+ * FPGA NPU Co-simulation Interface
+ *
+ * C ABI exported by libnpu_cosim.so (hardware/cosim), a Verilator model of
+ * npu_top wrapped in an emulation of the driver and register block. The
+ * user-space library loads it with dlopen() when the co-simulation backend
+ * is selected, so applications, tests and benchmarks run unchanged against
+ * the RTL. Calls mirror the character-device entry points: ioctl commands
+ * and argument structures are those of fpga_npu_enhanced.h.
+ *
+ * Time only advances inside calls that wait on the device (WAIT_SEQ,
+ * WAIT_COMPLETION, blocking DMA) or that model a register access, so
+ * results are deterministic for a given call sequence.
+ */
+
+#ifndef NPU_COSIM_H
+#define NPU_COSIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NPU_COSIM_ABI_VERSION   2
+#define NPU_COSIM_LIB_DEFAULT   "libnpu_cosim.so"
+
+struct npu_cosim;
+
+/**
+ * ABI version of the loaded model (NPU_COSIM_ABI_VERSION)
+ */
+int npu_cosim_abi_version(void);
+
+/**
+ * Build and reset a model instance
+ * @return Instance, NULL on failure
+ */
+struct npu_cosim *npu_cosim_create(void);
+
+/**
+ * Release a model instance and every buffer it handed out
+ */
+void npu_cosim_destroy(struct npu_cosim *sim);
+
+/**
+ * Device ioctl; by-value arguments are passed cast to a pointer
+ * @return 0 on success, negative errno on failure
+ */
+int npu_cosim_ioctl(struct npu_cosim *sim, unsigned long cmd, void *arg);
+
+/**
+ * Stream instruction words to the device (write() on the device node)
+ * @return Bytes accepted, negative errno on failure
+ */
+long npu_cosim_write(struct npu_cosim *sim, const void *buf, size_t len);
+
+/**
+ * Read back results of the last write (read() on the device node)
+ * @return Bytes copied, negative errno on failure
+ */
+long npu_cosim_read(struct npu_cosim *sim, void *buf, size_t len);
+
+/**
+ * Map the buffer selected by NPU_IOCTL_MMAP_REQUEST (offset 0) or the
+ * completion ring (NPU_CQ_MMAP_OFFSET). Mappings live until the buffer is
+ * freed or the instance is destroyed.
+ * @return Mapping, NULL on failure
+ */
+void *npu_cosim_mmap(struct npu_cosim *sim, size_t len, long offset);
+
+/**
+ * Simulated core clock cycles since creation
+ */
+uint64_t npu_cosim_cycles(struct npu_cosim *sim);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NPU_COSIM_H
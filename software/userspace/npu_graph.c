@@ -0,0 +1,1156 @@
+/**
+ * FPGA NPU Operator Graph Implementation
+ *
+ * Graph building, rewriting, liveness-based memory planning and execution
+ * on top of the operators of fpga_npu_lib.
+ */
+
+#include "npu_graph.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+
+#define GRAPH_INITIAL_CAPACITY 16
+#define GRAPH_MAX_INPUTS 5      // Batch norm: input, scale, bias, mean, variance
+
+// Where the data of a value comes from
+typedef enum {
+    GRAPH_VALUE_INPUT,          // Caller tensor, bound at execution
+    GRAPH_VALUE_CONSTANT,       // Caller data, fixed when added
+    GRAPH_VALUE_INTERMEDIATE,   // Arena
+    GRAPH_VALUE_OUTPUT          // Caller tensor, bound at execution
+} graph_value_kind_t;
+
+typedef enum {
+    GRAPH_OP_CONV2D,
+    GRAPH_OP_MATMUL,
+    GRAPH_OP_ADD,
+    GRAPH_OP_RELU,
+    GRAPH_OP_SIGMOID,
+    GRAPH_OP_MAX_POOL,
+    GRAPH_OP_SOFTMAX,
+    GRAPH_OP_RESHAPE,
+    GRAPH_OP_BATCH_NORM,
+    GRAPH_OP_DROPOUT
+} graph_op_t;
+
+struct graph_value {
+    graph_value_kind_t kind;
+    npu_tensor_t tensor;        // Shape and dtype; data of constants
+    uint32_t index;             // Position among the inputs or outputs
+    int32_t last_use;           // Last node that reads the value, -1 if none
+    int32_t buffer;             // Arena buffer of an intermediate
+    void *owned;                // Data of a constant made by npu_graph_optimize()
+};
+
+struct graph_node {
+    graph_op_t op;
+    npu_value_t inputs[GRAPH_MAX_INPUTS];   // Unused inputs are -1
+    npu_value_t output;
+    uint32_t params[4];         // Operator-specific parameters
+    npu_activation_t act;       // Epilogue of conv2d, matmul and add
+    void *expanded;             // Bias of an add broadcast to the output shape
+};
+
+// Arena region shared by an intermediate and the in-place nodes after it
+struct graph_buffer {
+    size_t size;
+    size_t offset;
+    int32_t first;              // Node that writes it first
+    int32_t last;               // Node that reads it last
+};
+
+struct npu_graph {
+    struct graph_value *values;
+    uint32_t value_count;
+    uint32_t value_capacity;
+    struct graph_node *nodes;
+    uint32_t node_count;
+    uint32_t node_capacity;
+    uint32_t input_count;
+    uint32_t output_count;
+
+    // Memory plan
+    bool planned;
+    struct graph_buffer *buffers;
+    npu_graph_memory_report_t report;
+    npu_tensor_t *views;        // Tensor of every value during execution
+    void *arena;                // Unaligned allocation behind the arena
+    size_t arena_capacity;
+};
+
+// Helper functions
+
+static size_t align_size(size_t size)
+{
+    return (size + NPU_GRAPH_ALIGN - 1) & ~((size_t)NPU_GRAPH_ALIGN - 1);
+}
+
+static uint32_t element_count(const npu_tensor_t *tensor)
+{
+    return tensor->dims[0] * tensor->dims[1] * tensor->dims[2] * tensor->dims[3];
+}
+
+static bool same_shape(const npu_tensor_t *a, const npu_tensor_t *b)
+{
+    return memcmp(a->dims, b->dims, sizeof(a->dims)) == 0 && a->dtype == b->dtype;
+}
+
+/**
+ * Check a builder operand; errors from earlier builder calls pass through
+ */
+static int check_operand(const struct npu_graph *graph, npu_value_t value)
+{
+    if (value < 0) {
+        return value;
+    }
+    if (!graph || (uint32_t)value >= graph->value_count) {
+        return NPU_ERROR_INVALID;
+    }
+    return NPU_SUCCESS;
+}
+
+static npu_value_t add_value(struct npu_graph *graph, graph_value_kind_t kind, const npu_tensor_t *tensor)
+{
+    if (graph->value_count == graph->value_capacity) {
+        uint32_t capacity = graph->value_capacity ? graph->value_capacity * 2 : GRAPH_INITIAL_CAPACITY;
+        struct graph_value *values = realloc(graph->values, capacity * sizeof(*values));
+        if (!values) {
+            return NPU_ERROR_MEMORY;
+        }
+        graph->values = values;
+        graph->value_capacity = capacity;
+    }
+    
+    struct graph_value *value = &graph->values[graph->value_count];
+    memset(value, 0, sizeof(*value));
+    value->kind = kind;
+    value->tensor = *tensor;
+    value->last_use = -1;
+    value->buffer = -1;
+    
+    graph->planned = false;
+    return (npu_value_t)graph->value_count++;
+}
+
+/**
+ * Append a node writing a new intermediate of the given shape
+ */
+static npu_value_t add_node(struct npu_graph *graph, graph_op_t op, npu_value_t a, npu_value_t b,
+                            const npu_tensor_t *shape, const uint32_t *params)
+{
+    if (graph->node_count == graph->node_capacity) {
+        uint32_t capacity = graph->node_capacity ? graph->node_capacity * 2 : GRAPH_INITIAL_CAPACITY;
+        struct graph_node *nodes = realloc(graph->nodes, capacity * sizeof(*nodes));
+        if (!nodes) {
+            return NPU_ERROR_MEMORY;
+        }
+        graph->nodes = nodes;
+        graph->node_capacity = capacity;
+    }
+    
+    npu_tensor_t tensor = npu_create_tensor(NULL, shape->dims[0], shape->dims[1],
+                                            shape->dims[2], shape->dims[3], shape->dtype);
+    npu_value_t output = add_value(graph, GRAPH_VALUE_INTERMEDIATE, &tensor);
+    if (output < 0) {
+        return output;
+    }
+    
+    struct graph_node *node = &graph->nodes[graph->node_count++];
+    memset(node, 0, sizeof(*node));
+    node->op = op;
+    for (int k = 0; k < GRAPH_MAX_INPUTS; k++) {
+        node->inputs[k] = -1;
+    }
+    node->inputs[0] = a;
+    node->inputs[1] = b;
+    node->output = output;
+    if (params) {
+        memcpy(node->params, params, sizeof(node->params));
+    }
+    
+    return output;
+}
+
+/**
+ * Output extent of a sliding window, 0 if the window does not fit
+ */
+static uint32_t window_extent(uint32_t in, uint32_t kernel, uint32_t stride, uint32_t pad)
+{
+    if (stride == 0 || in + 2 * pad < kernel) {
+        return 0;
+    }
+    return (in + 2 * pad - kernel) / stride + 1;
+}
+
+// Graph construction
+
+npu_graph_t npu_graph_create(void)
+{
+    return calloc(1, sizeof(struct npu_graph));
+}
+
+void npu_graph_destroy(npu_graph_t graph)
+{
+    if (!graph) {
+        return;
+    }
+    
+    for (uint32_t i = 0; i < graph->node_count; i++) {
+        free(graph->nodes[i].expanded);
+    }
+    for (uint32_t v = 0; v < graph->value_count; v++) {
+        free(graph->values[v].owned);
+    }
+    free(graph->values);
+    free(graph->nodes);
+    free(graph->buffers);
+    free(graph->views);
+    free(graph->arena);
+    free(graph);
+}
+
+npu_value_t npu_graph_input(npu_graph_t graph, uint32_t n, uint32_t c, uint32_t h, uint32_t w,
+                            npu_dtype_t dtype)
+{
+    if (!graph || n == 0 || c == 0 || h == 0 || w == 0) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    npu_tensor_t tensor = npu_create_tensor(NULL, n, c, h, w, dtype);
+    npu_value_t value = add_value(graph, GRAPH_VALUE_INPUT, &tensor);
+    if (value >= 0) {
+        graph->values[value].index = graph->input_count++;
+    }
+    return value;
+}
+
+npu_value_t npu_graph_constant(npu_graph_t graph, const npu_tensor_t *tensor)
+{
+    if (!graph || !tensor || !tensor->data || element_count(tensor) == 0) {
+        return NPU_ERROR_INVALID;
+    }
+    return add_value(graph, GRAPH_VALUE_CONSTANT, tensor);
+}
+
+int npu_graph_output(npu_graph_t graph, npu_value_t value)
+{
+    int ret = check_operand(graph, value);
+    if (ret != NPU_SUCCESS) {
+        return ret;
+    }
+    
+    // Only node results can be outputs, and each only once
+    if (graph->values[value].kind != GRAPH_VALUE_INTERMEDIATE) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    graph->values[value].kind = GRAPH_VALUE_OUTPUT;
+    graph->values[value].index = graph->output_count++;
+    graph->planned = false;
+    return NPU_SUCCESS;
+}
+
+int npu_graph_get_tensor(npu_graph_t graph, npu_value_t value, npu_tensor_t *tensor)
+{
+    int ret = check_operand(graph, value);
+    if (ret != NPU_SUCCESS) return ret;
+    if (!tensor) return NPU_ERROR_INVALID;
+    
+    *tensor = graph->values[value].tensor;
+    if (graph->values[value].kind != GRAPH_VALUE_CONSTANT) {
+        tensor->data = NULL;
+    }
+    return NPU_SUCCESS;
+}
+
+npu_value_t npu_graph_conv2d(npu_graph_t graph, npu_value_t input, npu_value_t weights,
+                             uint32_t stride_h, uint32_t stride_w, uint32_t pad_h, uint32_t pad_w)
+{
+    int ret = check_operand(graph, input);
+    if (ret == NPU_SUCCESS) ret = check_operand(graph, weights);
+    if (ret != NPU_SUCCESS) return ret;
+    
+    const npu_tensor_t *x = &graph->values[input].tensor;
+    const npu_tensor_t *w = &graph->values[weights].tensor;
+    if (w->dims[1] != x->dims[1] || w->dims[2] != w->dims[3]) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    npu_tensor_t shape = *x;
+    shape.dims[1] = w->dims[0];
+    shape.dims[2] = window_extent(x->dims[2], w->dims[2], stride_h, pad_h);
+    shape.dims[3] = window_extent(x->dims[3], w->dims[3], stride_w, pad_w);
+    if (shape.dims[2] == 0 || shape.dims[3] == 0) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    uint32_t params[4] = { stride_h, stride_w, pad_h, pad_w };
+    return add_node(graph, GRAPH_OP_CONV2D, input, weights, &shape, params);
+}
+
+npu_value_t npu_graph_matmul(npu_graph_t graph, npu_value_t a, npu_value_t b)
+{
+    int ret = check_operand(graph, a);
+    if (ret == NPU_SUCCESS) ret = check_operand(graph, b);
+    if (ret != NPU_SUCCESS) return ret;
+    
+    const npu_tensor_t *ta = &graph->values[a].tensor;
+    const npu_tensor_t *tb = &graph->values[b].tensor;
+    if (ta->dims[0] != 1 || ta->dims[1] != 1 || tb->dims[0] != 1 || tb->dims[1] != 1 ||
+        ta->dims[3] != tb->dims[2]) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    npu_tensor_t shape = *ta;
+    shape.dims[3] = tb->dims[3];
+    return add_node(graph, GRAPH_OP_MATMUL, a, b, &shape, NULL);
+}
+
+npu_value_t npu_graph_add(npu_graph_t graph, npu_value_t a, npu_value_t b)
+{
+    int ret = check_operand(graph, a);
+    if (ret == NPU_SUCCESS) ret = check_operand(graph, b);
+    if (ret != NPU_SUCCESS) return ret;
+    
+    const struct graph_value *va = &graph->values[a];
+    const struct graph_value *vb = &graph->values[b];
+    if (va->tensor.dtype != vb->tensor.dtype) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    // The device adds equal shapes only; constants are broadcast when planned
+    if (!same_shape(&va->tensor, &vb->tensor)) {
+        if (vb->kind != GRAPH_VALUE_CONSTANT) {
+            return NPU_ERROR_INVALID;
+        }
+        for (int d = 0; d < 4; d++) {
+            if (vb->tensor.dims[d] != 1 && vb->tensor.dims[d] != va->tensor.dims[d]) {
+                return NPU_ERROR_INVALID;
+            }
+        }
+    }
+    
+    return add_node(graph, GRAPH_OP_ADD, a, b, &va->tensor, NULL);
+}
+
+npu_value_t npu_graph_relu(npu_graph_t graph, npu_value_t input)
+{
+    int ret = check_operand(graph, input);
+    if (ret != NPU_SUCCESS) return ret;
+    
+    return add_node(graph, GRAPH_OP_RELU, input, -1, &graph->values[input].tensor, NULL);
+}
+
+npu_value_t npu_graph_sigmoid(npu_graph_t graph, npu_value_t input)
+{
+    int ret = check_operand(graph, input);
+    if (ret != NPU_SUCCESS) return ret;
+    
+    return add_node(graph, GRAPH_OP_SIGMOID, input, -1, &graph->values[input].tensor, NULL);
+}
+
+npu_value_t npu_graph_max_pool2d(npu_graph_t graph, npu_value_t input,
+                                 uint32_t kernel_h, uint32_t kernel_w,
+                                 uint32_t stride_h, uint32_t stride_w,
+                                 uint32_t pad_h, uint32_t pad_w)
+{
+    int ret = check_operand(graph, input);
+    if (ret != NPU_SUCCESS) return ret;
+    
+    npu_tensor_t shape = graph->values[input].tensor;
+    shape.dims[2] = window_extent(shape.dims[2], kernel_h, stride_h, pad_h);
+    shape.dims[3] = window_extent(shape.dims[3], kernel_w, stride_w, pad_w);
+    if (shape.dims[2] == 0 || shape.dims[3] == 0) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    uint32_t params[4] = { (kernel_h << 16) | kernel_w, (stride_h << 16) | stride_w,
+                           (pad_h << 16) | pad_w, 0 };
+    return add_node(graph, GRAPH_OP_MAX_POOL, input, -1, &shape, params);
+}
+
+npu_value_t npu_graph_softmax(npu_graph_t graph, npu_value_t input)
+{
+    int ret = check_operand(graph, input);
+    if (ret != NPU_SUCCESS) return ret;
+    
+    // npu_softmax computes on the host in float
+    if (graph->values[input].tensor.dtype != NPU_DTYPE_FLOAT32) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    return add_node(graph, GRAPH_OP_SOFTMAX, input, -1, &graph->values[input].tensor, NULL);
+}
+
+npu_value_t npu_graph_reshape(npu_graph_t graph, npu_value_t input,
+                              uint32_t n, uint32_t c, uint32_t h, uint32_t w)
+{
+    int ret = check_operand(graph, input);
+    if (ret != NPU_SUCCESS) return ret;
+    
+    npu_tensor_t shape = npu_create_tensor(NULL, n, c, h, w, graph->values[input].tensor.dtype);
+    if (element_count(&shape) == 0 || element_count(&shape) != element_count(&graph->values[input].tensor)) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    return add_node(graph, GRAPH_OP_RESHAPE, input, -1, &shape, NULL);
+}
+
+npu_value_t npu_graph_batch_norm(npu_graph_t graph, npu_value_t input,
+                                 npu_value_t scale, npu_value_t bias,
+                                 npu_value_t mean, npu_value_t variance, float epsilon)
+{
+    npu_value_t params[4] = { scale, bias, mean, variance };
+    int ret = check_operand(graph, input);
+    
+    for (int k = 0; k < 4 && ret == NPU_SUCCESS; k++) {
+        ret = check_operand(graph, params[k]);
+    }
+    if (ret != NPU_SUCCESS) return ret;
+    
+    // One FLOAT32 constant per channel: dims[1], or the columns of a matrix
+    const npu_tensor_t *x = &graph->values[input].tensor;
+    uint32_t channels = element_count(&graph->values[scale].tensor);
+    if (channels != x->dims[1] &&
+        (x->dims[0] != 1 || x->dims[1] != 1 || channels != x->dims[3])) {
+        return NPU_ERROR_INVALID;
+    }
+    for (int k = 0; k < 4; k++) {
+        const struct graph_value *param = &graph->values[params[k]];
+        if (param->kind != GRAPH_VALUE_CONSTANT || param->tensor.dtype != NPU_DTYPE_FLOAT32 ||
+            element_count(&param->tensor) != channels) {
+            return NPU_ERROR_INVALID;
+        }
+    }
+    
+    uint32_t bits[4] = { 0 };
+    memcpy(&bits[0], &epsilon, sizeof(epsilon));
+    npu_value_t output = add_node(graph, GRAPH_OP_BATCH_NORM, input, scale, x, bits);
+    if (output >= 0) {
+        graph->nodes[graph->node_count - 1].inputs[2] = bias;
+        graph->nodes[graph->node_count - 1].inputs[3] = mean;
+        graph->nodes[graph->node_count - 1].inputs[4] = variance;
+    }
+    return output;
+}
+
+npu_value_t npu_graph_dropout(npu_graph_t graph, npu_value_t input, float dropout_rate)
+{
+    int ret = check_operand(graph, input);
+    if (ret != NPU_SUCCESS) return ret;
+    
+    uint32_t params[4] = { 0 };
+    memcpy(&params[0], &dropout_rate, sizeof(dropout_rate));
+    return add_node(graph, GRAPH_OP_DROPOUT, input, -1, &graph->values[input].tensor, params);
+}
+
+// Memory planning
+
+/**
+ * Broadcast a constant bias to the shape of an add's output
+ */
+static void *expand_bias(const npu_tensor_t *bias, const npu_tensor_t *shape)
+{
+    size_t element_size = bias->size / element_count(bias);
+    const char *src = bias->data;
+    char *dst = malloc(shape->size);
+    uint32_t n, c, h, w;
+    
+    if (!dst) {
+        return NULL;
+    }
+    
+    for (n = 0; n < shape->dims[0]; n++) {
+        for (c = 0; c < shape->dims[1]; c++) {
+            for (h = 0; h < shape->dims[2]; h++) {
+                for (w = 0; w < shape->dims[3]; w++) {
+                    size_t s = (((size_t)(bias->dims[0] > 1 ? n : 0) * bias->dims[1] +
+                                 (bias->dims[1] > 1 ? c : 0)) * bias->dims[2] +
+                                (bias->dims[2] > 1 ? h : 0)) * bias->dims[3] +
+                               (bias->dims[3] > 1 ? w : 0);
+                    size_t d = (((size_t)n * shape->dims[1] + c) * shape->dims[2] + h) * shape->dims[3] + w;
+                    memcpy(dst + d * element_size, src + s * element_size, element_size);
+                }
+            }
+        }
+    }
+    
+    return dst;
+}
+
+/**
+ * Input that node i can write its output over: for element-wise nodes, an
+ * intermediate input of the output's size whose buffer no later node reads.
+ * A reshape leaves the data as it is, so it shares any intermediate input's
+ * buffer, and that buffer then lives until the later of their last reads.
+ */
+static npu_value_t in_place_source(const struct npu_graph *graph, uint32_t i)
+{
+    const struct graph_node *node = &graph->nodes[i];
+    const npu_tensor_t *output = &graph->values[node->output].tensor;
+    int candidates;
+    
+    switch (node->op) {
+        case GRAPH_OP_RESHAPE:
+            if (graph->values[node->inputs[0]].kind == GRAPH_VALUE_INTERMEDIATE) {
+                return node->inputs[0];
+            }
+            return -1;
+        case GRAPH_OP_ADD:
+            candidates = 2;
+            break;
+        case GRAPH_OP_RELU:
+        case GRAPH_OP_SIGMOID:
+        case GRAPH_OP_BATCH_NORM:
+        case GRAPH_OP_DROPOUT:
+            candidates = 1;
+            break;
+        default:
+            return -1;
+    }
+    
+    for (int k = 0; k < candidates; k++) {
+        const struct graph_value *input = &graph->values[node->inputs[k]];
+        if (input->kind == GRAPH_VALUE_INTERMEDIATE && input->tensor.size == output->size &&
+            graph->buffers[input->buffer].last == (int32_t)i) {
+            return node->inputs[k];
+        }
+    }
+    return -1;
+}
+
+static bool lifetimes_overlap(const struct graph_buffer *a, const struct graph_buffer *b)
+{
+    return a->first <= b->last && b->first <= a->last;
+}
+
+int npu_graph_plan_memory(npu_graph_t graph, npu_graph_memory_report_t *report)
+{
+    npu_graph_memory_report_t plan;
+    uint32_t *order;
+    uint32_t count = 0;
+    
+    if (!graph) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    // Lifetimes: every value is read last by the last node that takes it
+    for (uint32_t v = 0; v < graph->value_count; v++) {
+        graph->values[v].last_use = -1;
+        graph->values[v].buffer = -1;
+    }
+    for (uint32_t i = 0; i < graph->node_count; i++) {
+        for (int k = 0; k < GRAPH_MAX_INPUTS; k++) {
+            if (graph->nodes[i].inputs[k] >= 0) {
+                graph->values[graph->nodes[i].inputs[k]].last_use = (int32_t)i;
+            }
+        }
+    }
+    
+    free(graph->buffers);
+    free(graph->views);
+    graph->buffers = malloc((graph->node_count + 1) * sizeof(struct graph_buffer));
+    graph->views = malloc((graph->value_count + 1) * sizeof(npu_tensor_t));
+    order = malloc((graph->node_count + 1) * sizeof(uint32_t));
+    if (!graph->buffers || !graph->views || !order) {
+        free(order);
+        return NPU_ERROR_MEMORY;
+    }
+    
+    memset(&plan, 0, sizeof(plan));
+    for (uint32_t i = 0; i < graph->node_count; i++) {
+        struct graph_node *node = &graph->nodes[i];
+        struct graph_value *output = &graph->values[node->output];
+    
+        // Constant biases are broadcast again in case their data changed
+        free(node->expanded);
+        node->expanded = NULL;
+        if (node->op == GRAPH_OP_ADD &&
+            !same_shape(&graph->values[node->inputs[1]].tensor, &output->tensor)) {
+            node->expanded = expand_bias(&graph->values[node->inputs[1]].tensor, &output->tensor);
+            if (!node->expanded) {
+                free(order);
+                return NPU_ERROR_MEMORY;
+            }
+        }
+    
+        if (output->kind != GRAPH_VALUE_INTERMEDIATE) {
+            continue;
+        }
+        plan.intermediate_count++;
+        plan.naive_bytes += output->tensor.size;
+    
+        npu_value_t source = in_place_source(graph, i);
+        if (source >= 0) {
+            output->buffer = graph->values[source].buffer;
+            plan.in_place_count++;
+        } else {
+            struct graph_buffer *buffer = &graph->buffers[count];
+            buffer->size = align_size(output->tensor.size);
+            buffer->offset = 0;
+            buffer->first = (int32_t)i;
+            buffer->last = (int32_t)i;
+            output->buffer = (int32_t)count++;
+        }
+    
+        struct graph_buffer *buffer = &graph->buffers[output->buffer];
+        if (output->last_use > buffer->last) {
+            buffer->last = output->last_use;
+        }
+    }
+    
+    // Largest buffers first, each at the lowest offset clear of every
+    // placed buffer whose lifetime overlaps its own
+    for (uint32_t b = 0; b < count; b++) {
+        uint32_t j = b;
+        while (j > 0 && graph->buffers[order[j - 1]].size < graph->buffers[b].size) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = b;
+    }
+    
+    for (uint32_t p = 0; p < count; p++) {
+        struct graph_buffer *buffer = &graph->buffers[order[p]];
+        bool moved = true;
+    
+        // Jumping past each clash in turn ends on the lowest free offset
+        while (moved) {
+            moved = false;
+            for (uint32_t q = 0; q < p; q++) {
+                const struct graph_buffer *placed = &graph->buffers[order[q]];
+                if (lifetimes_overlap(buffer, placed) &&
+                    buffer->offset < placed->offset + placed->size &&
+                    placed->offset < buffer->offset + buffer->size) {
+                    buffer->offset = placed->offset + placed->size;
+                    moved = true;
+                }
+            }
+        }
+    
+        if (buffer->offset + buffer->size > plan.arena_bytes) {
+            plan.arena_bytes = buffer->offset + buffer->size;
+        }
+    }
+    
+    for (uint32_t i = 0; i < graph->node_count; i++) {
+        size_t live = 0;
+        for (uint32_t b = 0; b < count; b++) {
+            if (graph->buffers[b].first <= (int32_t)i && (int32_t)i <= graph->buffers[b].last) {
+                live += graph->buffers[b].size;
+            }
+        }
+        if (live > plan.peak_live_bytes) {
+            plan.peak_live_bytes = live;
+        }
+    }
+    
+    free(order);
+    plan.buffer_count = count;
+    graph->report = plan;
+    graph->planned = true;
+    
+    if (report) {
+        *report = plan;
+    }
+    return NPU_SUCCESS;
+}
+
+// Execution
+
+/**
+ * One image of a batched tensor
+ */
+static npu_tensor_t image_of(const npu_tensor_t *tensor, uint32_t n)
+{
+    npu_tensor_t image = *tensor;
+    
+    image.size = tensor->size / tensor->dims[0];
+    image.data = (char *)tensor->data + n * image.size;
+    image.dims[0] = 1;
+    return image;
+}
+
+static int run_node(npu_handle_t handle, const struct graph_node *node, npu_tensor_t *views)
+{
+    npu_tensor_t *a = &views[node->inputs[0]];
+    npu_tensor_t *b = node->inputs[1] >= 0 ? &views[node->inputs[1]] : NULL;
+    npu_tensor_t *y = &views[node->output];
+    int ret = NPU_SUCCESS;
+    
+    switch (node->op) {
+        case GRAPH_OP_CONV2D:
+            // The convolution engine takes one image per instruction
+            for (uint32_t n = 0; n < a->dims[0] && ret == NPU_SUCCESS; n++) {
+                npu_tensor_t x = image_of(a, n);
+                npu_tensor_t out = image_of(y, n);
+                ret = npu_conv2d_fused(handle, &x, b, &out, node->params[0], node->params[1],
+                                       node->params[2], node->params[3], node->act);
+            }
+            return ret;
+        case GRAPH_OP_MATMUL:
+            return npu_matrix_multiply_fused(handle, a, b, y, node->act);
+        case GRAPH_OP_ADD: {
+            npu_tensor_t bias = *y;
+            if (node->expanded) {
+                bias.data = node->expanded;
+                b = &bias;
+            }
+            return npu_add_fused(handle, a, b, y, node->act);
+        }
+        case GRAPH_OP_RELU:
+            return npu_relu(handle, a, y);
+        case GRAPH_OP_SIGMOID:
+            return npu_sigmoid(handle, a, y);
+        case GRAPH_OP_MAX_POOL:
+            for (uint32_t n = 0; n < a->dims[0] && ret == NPU_SUCCESS; n++) {
+                npu_tensor_t x = image_of(a, n);
+                npu_tensor_t out = image_of(y, n);
+                ret = npu_max_pool2d(handle, &x, &out,
+                                     node->params[0] >> 16, node->params[0] & 0xFFFF,
+                                     node->params[1] >> 16, node->params[1] & 0xFFFF,
+                                     node->params[2] >> 16, node->params[2] & 0xFFFF);
+            }
+            return ret;
+        case GRAPH_OP_SOFTMAX:
+            for (uint32_t n = 0; n < a->dims[0] && ret == NPU_SUCCESS; n++) {
+                npu_tensor_t x = image_of(a, n);
+                npu_tensor_t out = image_of(y, n);
+                ret = npu_softmax(handle, &x, &out, 1);
+            }
+            return ret;
+        case GRAPH_OP_RESHAPE: {
+            // Planned onto its input's buffer, so npu_reshape only rewrites the
+            // descriptor; a graph input or output is still copied
+            npu_tensor_t out = *y;
+            return npu_reshape(handle, a, &out, y->dims, 4);
+        }
+        case GRAPH_OP_BATCH_NORM: {
+            float epsilon;
+            memcpy(&epsilon, &node->params[0], sizeof(epsilon));
+            return npu_batch_norm(handle, a, b, &views[node->inputs[2]], &views[node->inputs[3]],
+                                  &views[node->inputs[4]], y, epsilon);
+        }
+        case GRAPH_OP_DROPOUT: {
+            float rate;
+            memcpy(&rate, &node->params[0], sizeof(rate));
+            return npu_dropout(handle, a, y, rate);
+        }
+        default:
+            return NPU_ERROR_INVALID;
+    }
+}
+
+int npu_graph_execute(npu_handle_t handle, npu_graph_t graph,
+                      const npu_tensor_t *inputs, npu_tensor_t *outputs)
+{
+    char *arena;
+    int ret;
+    
+    if (!handle || !graph || (graph->input_count && !inputs) || (graph->output_count && !outputs)) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    if (!graph->planned) {
+        ret = npu_graph_plan_memory(graph, NULL);
+        if (ret != NPU_SUCCESS) return ret;
+    }
+    
+    if (graph->report.arena_bytes > graph->arena_capacity) {
+        free(graph->arena);
+        graph->arena = malloc(graph->report.arena_bytes + NPU_GRAPH_ALIGN);
+        graph->arena_capacity = graph->arena ? graph->report.arena_bytes : 0;
+        if (!graph->arena) {
+            return NPU_ERROR_MEMORY;
+        }
+    }
+    arena = (char *)(((uintptr_t)graph->arena + NPU_GRAPH_ALIGN - 1) &
+                     ~((uintptr_t)NPU_GRAPH_ALIGN - 1));
+    
+    // Bind every value to its memory for this run
+    for (uint32_t v = 0; v < graph->value_count; v++) {
+        const struct graph_value *value = &graph->values[v];
+        npu_tensor_t *view = &graph->views[v];
+        const npu_tensor_t *bound = NULL;
+    
+        *view = value->tensor;
+        switch (value->kind) {
+            case GRAPH_VALUE_INPUT:
+                bound = &inputs[value->index];
+                break;
+            case GRAPH_VALUE_OUTPUT:
+                bound = &outputs[value->index];
+                break;
+            case GRAPH_VALUE_INTERMEDIATE:
+                if (value->buffer >= 0) {
+                    view->data = arena + graph->buffers[value->buffer].offset;
+                }
+                break;
+            default:
+                break;
+        }
+    
+        if (bound) {
+            if (!bound->data || bound->size != value->tensor.size) {
+                return NPU_ERROR_INVALID;
+            }
+            view->data = bound->data;
+        }
+    }
+    
+    for (uint32_t i = 0; i < graph->node_count; i++) {
+        ret = run_node(handle, &graph->nodes[i], graph->views);
+        if (ret != NPU_SUCCESS) {
+            return ret;
+        }
+    }
+    
+    return NPU_SUCCESS;
+}
+
+// Graph rewriting
+
+/**
+ * Number of node inputs that read a value
+ */
+static uint32_t count_uses(const struct npu_graph *graph, npu_value_t value)
+{
+    uint32_t uses = 0;
+    
+    for (uint32_t i = 0; i < graph->node_count; i++) {
+        for (int k = 0; k < GRAPH_MAX_INPUTS; k++) {
+            if (graph->nodes[i].inputs[k] == value) {
+                uses++;
+            }
+        }
+    }
+    return uses;
+}
+
+/**
+ * Node that writes a value, -1 for inputs and constants
+ */
+static int32_t find_producer(const struct npu_graph *graph, npu_value_t value)
+{
+    for (uint32_t i = 0; i < graph->node_count; i++) {
+        if (graph->nodes[i].output == value) {
+            return (int32_t)i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Producer of an intermediate that exactly one node reads, -1 if there is
+ * none or the value has to stay visible
+ */
+static int32_t sole_producer(const struct npu_graph *graph, npu_value_t value)
+{
+    if (graph->values[value].kind != GRAPH_VALUE_INTERMEDIATE || count_uses(graph, value) != 1) {
+        return -1;
+    }
+    return find_producer(graph, value);
+}
+
+static void remove_node(struct npu_graph *graph, uint32_t i)
+{
+    free(graph->nodes[i].expanded);
+    memmove(&graph->nodes[i], &graph->nodes[i + 1],
+            (graph->node_count - i - 1) * sizeof(struct graph_node));
+    graph->node_count--;
+}
+
+/**
+ * Add a constant whose data the graph frees; the data is freed on failure
+ */
+static npu_value_t add_owned_constant(struct npu_graph *graph, const npu_tensor_t *tensor)
+{
+    npu_value_t value = add_value(graph, GRAPH_VALUE_CONSTANT, tensor);
+    
+    if (value < 0) {
+        free(tensor->data);
+        return value;
+    }
+    graph->values[value].owned = tensor->data;
+    return value;
+}
+
+/**
+ * Remove dropout or a reshape to the same shape at node i
+ * Readers of the result read the input instead. A graph output is instead
+ * written directly by the node before.
+ */
+static bool remove_identity(struct npu_graph *graph, uint32_t i)
+{
+    const struct graph_node *node = &graph->nodes[i];
+    npu_value_t x = node->inputs[0];
+    npu_value_t y = node->output;
+    
+    if (node->op != GRAPH_OP_DROPOUT &&
+        (node->op != GRAPH_OP_RESHAPE || !same_shape(&graph->values[x].tensor, &graph->values[y].tensor))) {
+        return false;
+    }
+    
+    if (graph->values[y].kind == GRAPH_VALUE_INTERMEDIATE) {
+        for (uint32_t j = i + 1; j < graph->node_count; j++) {
+            for (int k = 0; k < GRAPH_MAX_INPUTS; k++) {
+                if (graph->nodes[j].inputs[k] == y) {
+                    graph->nodes[j].inputs[k] = x;
+                }
+            }
+        }
+    } else {
+        int32_t producer = sole_producer(graph, x);
+        if (producer < 0) {
+            return false;
+        }
+        graph->nodes[producer].output = y;
+    }
+    
+    remove_node(graph, i);
+    return true;
+}
+
+/**
+ * Run node i once if all its inputs are constants and make its result a
+ * constant
+ * @return 1 if folded, 0 if not, or a negative error code
+ */
+static int fold_constant(npu_handle_t handle, struct npu_graph *graph, uint32_t i)
+{
+    struct graph_node node = graph->nodes[i];
+    struct graph_value *output = &graph->values[node.output];
+    npu_tensor_t *views;
+    void *data;
+    int ret;
+    
+    if (output->kind != GRAPH_VALUE_INTERMEDIATE) {
+        return 0;
+    }
+    for (int k = 0; k < GRAPH_MAX_INPUTS; k++) {
+        if (node.inputs[k] >= 0 && graph->values[node.inputs[k]].kind != GRAPH_VALUE_CONSTANT) {
+            return 0;
+        }
+    }
+    
+    views = malloc(graph->value_count * sizeof(npu_tensor_t));
+    data = malloc(output->tensor.size);
+    if (!views || !data) {
+        free(views);
+        free(data);
+        return NPU_ERROR_MEMORY;
+    }
+    
+    node.expanded = NULL;
+    if (node.op == GRAPH_OP_ADD && !same_shape(&graph->values[node.inputs[1]].tensor, &output->tensor)) {
+        node.expanded = expand_bias(&graph->values[node.inputs[1]].tensor, &output->tensor);
+        if (!node.expanded) {
+            free(views);
+            free(data);
+            return NPU_ERROR_MEMORY;
+        }
+    }
+    
+    for (uint32_t v = 0; v < graph->value_count; v++) {
+        views[v] = graph->values[v].tensor;
+    }
+    views[node.output].data = data;
+    ret = run_node(handle, &node, views);
+    free(node.expanded);
+    free(views);
+    if (ret != NPU_SUCCESS) {
+        free(data);
+        return ret;
+    }
+    
+    output->kind = GRAPH_VALUE_CONSTANT;
+    output->tensor.data = data;
+    output->owned = data;
+    remove_node(graph, i);
+    return 1;
+}
+
+/**
+ * Fold the batch norm at node i into the conv2d or matmul before it
+ *
+ * With s = scale / sqrt(variance + epsilon), the batch norm computes
+ * s * (W * x) + (bias - mean * s) per channel. The first term is a conv2d
+ * or matmul with each output channel of W scaled by s. The batch norm
+ * becomes an add of the second term. Only FLOAT32 nodes are folded.
+ * @return 1 if folded, 0 if not, or a negative error code
+ */
+static int fold_batch_norm(struct npu_graph *graph, uint32_t i)
+{
+    const struct graph_node *bn = &graph->nodes[i];
+    int32_t p = sole_producer(graph, bn->inputs[0]);
+    const npu_tensor_t *x = &graph->values[bn->inputs[0]].tensor;
+    uint32_t channels = x->dims[1];
+    
+    if (p < 0 || graph->nodes[p].act != NPU_ACT_NONE ||
+        graph->values[graph->nodes[p].inputs[1]].kind != GRAPH_VALUE_CONSTANT) {
+        return 0;
+    }
+    
+    // Conv2d weights are OIHW; matmul weights have one column per channel
+    bool columns = graph->nodes[p].op == GRAPH_OP_MATMUL;
+    if (columns) {
+        channels = x->dims[3];
+    } else if (graph->nodes[p].op != GRAPH_OP_CONV2D) {
+        return 0;
+    }
+    
+    npu_tensor_t weights = graph->values[graph->nodes[p].inputs[1]].tensor;
+    // Integer weights would need requantising, so only FLOAT32 is folded
+    if (channels != element_count(&graph->values[bn->inputs[1]].tensor) ||
+        weights.dtype != NPU_DTYPE_FLOAT32 || x->dtype != NPU_DTYPE_FLOAT32) {
+        return 0;
+    }
+    
+    const float *gamma = graph->values[bn->inputs[1]].tensor.data;
+    const float *beta = graph->values[bn->inputs[2]].tensor.data;
+    const float *mean = graph->values[bn->inputs[3]].tensor.data;
+    const float *variance = graph->values[bn->inputs[4]].tensor.data;
+    uint32_t count = element_count(&weights);
+    float epsilon;
+    memcpy(&epsilon, &bn->params[0], sizeof(epsilon));
+    
+    float *factor = malloc(channels * sizeof(float));
+    float *scaled = malloc(weights.size);
+    float *shift = malloc(channels * sizeof(float));
+    if (!factor || !scaled || !shift) {
+        free(factor);
+        free(scaled);
+        free(shift);
+        return NPU_ERROR_MEMORY;
+    }
+    
+    for (uint32_t c = 0; c < channels; c++) {
+        factor[c] = gamma[c] / sqrtf(variance[c] + epsilon);
+        shift[c] = beta[c] - mean[c] * factor[c];
+    }
+    for (uint32_t e = 0; e < count; e++) {
+        float f = factor[columns ? e % channels : e / (count / channels)];
+        scaled[e] = ((const float *)weights.data)[e] * f;
+    }
+    free(factor);
+    
+    // The weights may be shared with other nodes, so they are copied
+    weights.data = scaled;
+    npu_tensor_t bias = npu_create_tensor(shift, 1, columns ? 1 : channels, 1, columns ? channels : 1,
+                                          x->dtype);
+    npu_value_t w = add_owned_constant(graph, &weights);
+    if (w < 0) {
+        free(shift);
+        return w;
+    }
+    npu_value_t b = add_owned_constant(graph, &bias);
+    if (b < 0) {
+        return b;
+    }
+    
+    struct graph_node *node = &graph->nodes[i];
+    graph->nodes[p].inputs[1] = w;
+    node->op = GRAPH_OP_ADD;
+    node->inputs[1] = b;
+    for (int k = 2; k < GRAPH_MAX_INPUTS; k++) {
+        node->inputs[k] = -1;
+    }
+    memset(node->params, 0, sizeof(node->params));
+    return 1;
+}
+
+/**
+ * Move the ReLU or sigmoid at node i into the epilogue of its producer
+ */
+static bool fuse_activation(struct npu_graph *graph, uint32_t i)
+{
+    const struct graph_node *node = &graph->nodes[i];
+    npu_activation_t act;
+    
+    switch (node->op) {
+        case GRAPH_OP_RELU:
+            act = NPU_ACT_RELU;
+            break;
+        case GRAPH_OP_SIGMOID:
+            act = NPU_ACT_SIGMOID;
+            break;
+        default:
+            return false;
+    }
+    
+    int32_t p = sole_producer(graph, node->inputs[0]);
+    if (p < 0 || graph->nodes[p].act != NPU_ACT_NONE ||
+        (graph->nodes[p].op != GRAPH_OP_CONV2D && graph->nodes[p].op != GRAPH_OP_MATMUL &&
+         graph->nodes[p].op != GRAPH_OP_ADD)) {
+        return false;
+    }
+    
+    // The producer writes the activation's result directly
+    graph->nodes[p].act = act;
+    graph->nodes[p].output = node->output;
+    remove_node(graph, i);
+    return true;
+}
+
+int npu_graph_optimize(npu_handle_t handle, npu_graph_t graph, npu_graph_optimize_report_t *report)
+{
+    npu_graph_optimize_report_t rewrites;
+    uint32_t i;
+    int ret;
+    
+    if (!graph) {
+        return NPU_ERROR_INVALID;
+    }
+    
+    memset(&rewrites, 0, sizeof(rewrites));
+    rewrites.nodes_before = graph->node_count;
+    
+    for (i = 0; i < graph->node_count; ) {
+        if (remove_identity(graph, i)) {
+            rewrites.identities_removed++;
+        } else {
+            i++;
+        }
+    }
+    
+    // Nodes are in order, so constants fold through whole subgraphs
+    for (i = 0; handle && i < graph->node_count; ) {
+        ret = fold_constant(handle, graph, i);
+        if (ret < 0) {
+            return ret;
+        }
+        if (ret) {
+            rewrites.constants_folded++;
+        } else {
+            i++;
+        }
+    }
+    
+    for (i = 0; i < graph->node_count; i++) {
+        if (graph->nodes[i].op == GRAPH_OP_BATCH_NORM) {
+            ret = fold_batch_norm(graph, i);
+            if (ret < 0) {
+                return ret;
+            }
+            rewrites.batch_norms_folded += (uint32_t)ret;
+        }
+    }
+    
+    // Runs last, so that a folded batch norm's add takes the activation
+    for (i = 0; i < graph->node_count; ) {
+        if (fuse_activation(graph, i)) {
+            rewrites.activations_fused++;
+        } else {
+            i++;
+        }
+    }
+    
+    graph->planned = false;
+    rewrites.nodes_after = graph->node_count;
+    if (report) {
+        *report = rewrites;
+    }
+    return NPU_SUCCESS;
+}
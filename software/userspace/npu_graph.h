@@ -0,0 +1,287 @@
+/**
+ * FPGA NPU Operator Graphs
+ *
+ * Captures a network once as a graph of library operators and runs it many
+ * times. Only the shapes of intermediate tensors are given when the graph
+ * is built. npu_graph_plan_memory() then finds the nodes that produce and
+ * last read each intermediate. Intermediates whose lifetimes do not overlap
+ * share memory in one arena. ReLU, sigmoid and bias add write over their
+ * input when that input is not read again. So do batch norm and dropout.
+ * A reshape always shares its input's memory.
+ *
+ * npu_graph_optimize() rewrites a graph before it is planned. It removes
+ * identity nodes, computes constant nodes once and folds batch norms into
+ * the weights before them. It also moves activations into the epilogue of
+ * the node that produces their input.
+ *
+ * Builder calls return the new value, or a negative error code. An operand
+ * that is an error code is passed through unchanged. A whole network can
+ * therefore be built and checked once at the end.
+ */
+
+#ifndef NPU_GRAPH_H
+#define NPU_GRAPH_H
+
+#include "fpga_npu_lib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NPU_GRAPH_ALIGN     64      // Arena offset alignment in bytes
+
+// Graph handle
+typedef struct npu_graph* npu_graph_t;
+
+// Tensor in a graph; negative values are error codes
+typedef int32_t npu_value_t;
+
+/**
+ * Activation memory of a planned graph
+ */
+typedef struct {
+    size_t naive_bytes;         // One allocation per intermediate
+    size_t arena_bytes;         // Arena size after planning
+    size_t peak_live_bytes;     // Most intermediate bytes live at any node
+    uint32_t intermediate_count;
+    uint32_t buffer_count;      // Distinct arena regions
+    uint32_t in_place_count;    // Nodes that write over or share their input's memory
+} npu_graph_memory_report_t;
+
+/**
+ * Rewrites made by npu_graph_optimize()
+ */
+typedef struct {
+    uint32_t nodes_before;
+    uint32_t nodes_after;
+    uint32_t identities_removed;    // Dropout and reshape to the same shape
+    uint32_t constants_folded;      // Nodes whose inputs are all constants
+    uint32_t batch_norms_folded;    // Into conv or matmul weights and a bias add
+    uint32_t activations_fused;     // Into their producer's epilogue
+} npu_graph_optimize_report_t;
+
+/**
+ * Create an empty graph
+ * @return Graph on success, NULL on failure
+ */
+npu_graph_t npu_graph_create(void);
+
+/**
+ * Destroy a graph and its arena
+ * @param graph Graph (may be NULL)
+ */
+void npu_graph_destroy(npu_graph_t graph);
+
+/**
+ * Add an input, bound to a caller tensor by npu_graph_execute()
+ * @param graph Graph
+ * @param n Batch dimension
+ * @param c Channel dimension
+ * @param h Height dimension
+ * @param w Width dimension
+ * @param dtype Data type
+ * @return Input value, or a negative error code
+ */
+npu_value_t npu_graph_input(npu_graph_t graph, uint32_t n, uint32_t c, uint32_t h, uint32_t w,
+                            npu_dtype_t dtype);
+
+/**
+ * Add a constant such as weights or a bias
+ * @param graph Graph
+ * @param tensor Constant tensor; its data must outlive the graph
+ * @return Constant value, or a negative error code
+ */
+npu_value_t npu_graph_constant(npu_graph_t graph, const npu_tensor_t *tensor);
+
+/**
+ * Mark a value as a graph output
+ * Outputs are written straight to the caller tensors passed to
+ * npu_graph_execute(), in the order they are marked.
+ * @param graph Graph
+ * @param value Value produced by a node
+ * @return NPU_SUCCESS on success, error code on failure
+ */
+int npu_graph_output(npu_graph_t graph, npu_value_t value);
+
+/**
+ * Get the shape and type of a value, and the data of a constant
+ * Constants made by npu_graph_optimize() are owned by the graph.
+ * @param graph Graph
+ * @param value Value
+ * @param tensor Receives the tensor; data is NULL unless value is a constant
+ * @return NPU_SUCCESS on success, error code on failure
+ */
+int npu_graph_get_tensor(npu_graph_t graph, npu_value_t value, npu_tensor_t *tensor);
+
+/**
+ * 2D convolution node (see npu_conv2d); runs once per image of the batch
+ * @param graph Graph
+ * @param input Input value (NCHW)
+ * @param weights Weights value (OIHW, square kernel)
+ * @param stride_h Vertical stride
+ * @param stride_w Horizontal stride
+ * @param pad_h Vertical padding
+ * @param pad_w Horizontal padding
+ * @return Output value, or a negative error code
+ */
+npu_value_t npu_graph_conv2d(npu_graph_t graph, npu_value_t input, npu_value_t weights,
+                             uint32_t stride_h, uint32_t stride_w, uint32_t pad_h, uint32_t pad_w);
+
+/**
+ * Matrix multiplication node: C = A * B (see npu_matrix_multiply)
+ * @param graph Graph
+ * @param a Matrix A, shape [1, 1, M, K]
+ * @param b Matrix B, shape [1, 1, K, N]
+ * @return Matrix C, shape [1, 1, M, N], or a negative error code
+ */
+npu_value_t npu_graph_matmul(npu_graph_t graph, npu_value_t a, npu_value_t b);
+
+/**
+ * Element-wise addition node: C = A + B (see npu_add)
+ * B may be a constant with a dimension of 1 wherever A's differs, such as
+ * a per-channel bias; it is expanded to A's shape once, when planned.
+ * @param graph Graph
+ * @param a Tensor A
+ * @param b Tensor B
+ * @return Sum with A's shape, or a negative error code
+ */
+npu_value_t npu_graph_add(npu_graph_t graph, npu_value_t a, npu_value_t b);
+
+/**
+ * ReLU node (see npu_relu)
+ * @param graph Graph
+ * @param input Input value
+ * @return Output value, or a negative error code
+ */
+npu_value_t npu_graph_relu(npu_graph_t graph, npu_value_t input);
+
+/**
+ * Sigmoid node (see npu_sigmoid)
+ * @param graph Graph
+ * @param input Input value
+ * @return Output value, or a negative error code
+ */
+npu_value_t npu_graph_sigmoid(npu_graph_t graph, npu_value_t input);
+
+/**
+ * Max pooling node (see npu_max_pool2d); runs once per image of the batch
+ * @param graph Graph
+ * @param input Input value (NCHW)
+ * @param kernel_h Pooling kernel height
+ * @param kernel_w Pooling kernel width
+ * @param stride_h Vertical stride
+ * @param stride_w Horizontal stride
+ * @param pad_h Vertical padding
+ * @param pad_w Horizontal padding
+ * @return Output value, or a negative error code
+ */
+npu_value_t npu_graph_max_pool2d(npu_graph_t graph, npu_value_t input,
+                                 uint32_t kernel_h, uint32_t kernel_w,
+                                 uint32_t stride_h, uint32_t stride_w,
+                                 uint32_t pad_h, uint32_t pad_w);
+
+/**
+ * Softmax node (see npu_softmax) over each image of a FLOAT32 batch
+ * @param graph Graph
+ * @param input Input value
+ * @return Output value, or a negative error code
+ */
+npu_value_t npu_graph_softmax(npu_graph_t graph, npu_value_t input);
+
+/**
+ * Reshape node (see npu_reshape); the element count must not change
+ * @param graph Graph
+ * @param input Input value
+ * @param n Batch dimension
+ * @param c Channel dimension
+ * @param h Height dimension
+ * @param w Width dimension
+ * @return Output value, or a negative error code
+ */
+npu_value_t npu_graph_reshape(npu_graph_t graph, npu_value_t input,
+                              uint32_t n, uint32_t c, uint32_t h, uint32_t w);
+
+/**
+ * Batch normalization node (see npu_batch_norm)
+ * Normalizes over dims[1], or over dims[3] of a [1, 1, M, N] matrix.
+ * @param graph Graph
+ * @param input Input value
+ * @param scale Scale constant (gamma), FLOAT32, one value per channel
+ * @param bias Bias constant (beta), FLOAT32, one value per channel
+ * @param mean Running mean constant, FLOAT32, one value per channel
+ * @param variance Running variance constant, FLOAT32, one value per channel
+ * @param epsilon Small constant for numerical stability
+ * @return Output value, or a negative error code
+ */
+npu_value_t npu_graph_batch_norm(npu_graph_t graph, npu_value_t input,
+                                 npu_value_t scale, npu_value_t bias,
+                                 npu_value_t mean, npu_value_t variance, float epsilon);
+
+/**
+ * Dropout node (see npu_dropout); the identity at inference
+ * @param graph Graph
+ * @param input Input value
+ * @param dropout_rate Dropout rate (ignored in inference)
+ * @return Output value, or a negative error code
+ */
+npu_value_t npu_graph_dropout(npu_graph_t graph, npu_value_t input, float dropout_rate);
+
+/**
+ * Rewrite a graph into fewer, cheaper nodes
+ *
+ * The passes run in this order:
+ * - Dropout, and reshape to the input's own shape, are removed.
+ * - A node whose inputs are all constants runs once on the device. Its
+ *   result becomes a constant. This pass is skipped when handle is NULL.
+ * - A batch norm that alone reads a conv2d or matmul result is folded into
+ *   that node's weights. Each output channel's weights are multiplied by
+ *   scale / sqrt(variance + epsilon). The batch norm becomes an add of the
+ *   remaining per-channel shift. Only FLOAT32 nodes are folded; integer
+ *   weights would need requantising.
+ * - A ReLU or sigmoid that alone reads a conv2d, matmul or add result is
+ *   moved into that node's activation epilogue.
+ *
+ * Graph outputs are kept.
+ * @param handle NPU handle for constant folding (may be NULL)
+ * @param graph Graph
+ * @param report Rewrites made (may be NULL)
+ * @return NPU_SUCCESS on success, error code on failure
+ */
+int npu_graph_optimize(npu_handle_t handle, npu_graph_t graph, npu_graph_optimize_report_t *report);
+
+/**
+ * Assign every intermediate an offset in one arena
+ *
+ * Each intermediate is live from the node that produces it to the last
+ * node that reads it. Element-wise nodes whose input dies at that node
+ * reuse the input's memory. The remaining buffers are placed largest
+ * first at the lowest offset that does not overlap a buffer with an
+ * overlapping lifetime. This is first-fit colouring of the interval
+ * graph, with buffer sizes as weights.
+ *
+ * Building the graph further discards the plan. npu_graph_execute()
+ * plans an unplanned graph itself.
+ * @param graph Graph
+ * @param report Memory report (may be NULL)
+ * @return NPU_SUCCESS on success, error code on failure
+ */
+int npu_graph_plan_memory(npu_graph_t graph, npu_graph_memory_report_t *report);
+
+/**
+ * Run every node in the order it was added
+ * @param handle NPU handle
+ * @param graph Graph
+ * @param inputs Input tensors, in the order of npu_graph_input() calls
+ * @param outputs Output tensors, in the order of npu_graph_output() calls
+ * @return NPU_SUCCESS on success, error code on failure
+ * @note Tensor sizes must match the graph; the arena is allocated on the
+ *       first run and reused after that.
+ */
+int npu_graph_execute(npu_handle_t handle, npu_graph_t graph,
+                      const npu_tensor_t *inputs, npu_tensor_t *outputs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NPU_GRAPH_H
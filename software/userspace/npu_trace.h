@@ -0,0 +1,48 @@
+/**
+ * FPGA NPU Instruction Stream Trace
+ *
+ * With NPU_TRACE_FILE set in the environment, libfpga_npu records every
+ * instruction stream it sends to the device, every wait for completion and
+ * every buffer DMA to that file. The performance model (hardware/perfmodel)
+ * replays these traces to predict cycles per instruction for other NPU
+ * configurations.
+ *
+ * Layout (host byte order):
+ *   struct npu_trace_header
+ *   struct npu_trace_record, followed for NPU_TRACE_WORDS by count
+ *   32-bit instruction words exactly as written to the device
+ */
+
+#ifndef NPU_TRACE_H
+#define NPU_TRACE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NPU_TRACE_MAGIC     0x5450504Eu     // "NPPT"
+#define NPU_TRACE_VERSION   1
+
+// Record types
+#define NPU_TRACE_WORDS     1   // count instruction words follow
+#define NPU_TRACE_WAIT      2   // Host waits for every instruction sent so far
+#define NPU_TRACE_DMA       3   // count bytes synced, arg = direction
+
+struct npu_trace_header {
+    uint32_t magic;
+    uint32_t version;
+};
+
+struct npu_trace_record {
+    uint16_t type;
+    uint16_t arg;
+    uint32_t count;
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NPU_TRACE_H
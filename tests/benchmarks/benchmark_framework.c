@@ -136,12 +136,8 @@ benchmark_context_t* create_benchmark_context(const benchmark_config_t *config)
     // Copy config to result
     memcpy(&ctx->result->config, config, sizeof(benchmark_config_t));
     
-    // Allocate latency samples array
-    ctx->result->latency_samples = calloc(config->iterations, sizeof(double));
-    if (!ctx->result->latency_samples) {
-        destroy_benchmark_context(ctx);
-        return NULL;
-    }
+    // Empty latency histogram
+    latency_histogram_reset(&ctx->result->latency_histogram);
     
     ctx->stop_requested = false;
     
@@ -177,9 +173,6 @@ void destroy_benchmark_context(benchmark_context_t *ctx)
     
     // Free result structure
     if (ctx->result) {
-        if (ctx->result->latency_samples) {
-            free(ctx->result->latency_samples);
-        }
         free(ctx->result);
     }
     
@@ -333,12 +326,21 @@ void start_performance_monitoring(benchmark_context_t *ctx)
     
     // Initialize metrics
     memset(&ctx->result->metrics, 0, sizeof(performance_metrics_t));
+    
+    // Host CPU counters of this thread; worker threads merge their own
+    memset(&ctx->host_totals, 0, sizeof(ctx->host_totals));
+    host_counters_open(&ctx->host_counters);
+    host_counters_start(&ctx->host_counters);
 }
 
 void stop_performance_monitoring(benchmark_context_t *ctx)
 {
     if (!ctx) return;
     
+    host_counters_stop(&ctx->host_counters);
+    merge_host_counters(ctx, &ctx->host_counters.totals);
+    host_counters_close(&ctx->host_counters);
+    
     // Get NPU performance counters
     if (ctx->npu_handle) {
         uint64_t cycles, operations;
@@ -372,12 +374,8 @@ void stop_performance_monitoring(benchmark_context_t *ctx)
         
         // Calculate latency statistics
         if (ctx->result->sample_count > 0) {
-            calculate_latency_statistics(ctx->result->latency_samples, 
-                                       ctx->result->sample_count,
-                                       &ctx->result->metrics.latency_ms,
-                                       &ctx->result->metrics.latency_std_ms,
-                                       &ctx->result->metrics.latency_min_ms,
-                                       &ctx->result->metrics.latency_max_ms);
+            calculate_histogram_statistics(&ctx->result->latency_histogram,
+                                         &ctx->result->metrics);
         }
         
         // Calculate memory bandwidth
@@ -385,18 +383,64 @@ void stop_performance_monitoring(benchmark_context_t *ctx)
         ctx->result->metrics.bandwidth_gbps = 
             (double)ctx->result->metrics.data_transferred / (duration * 1e9);
     }
+    
+    host_counters_to_metrics(&ctx->host_totals, &ctx->result->metrics);
 }
 
 void record_latency_sample(benchmark_context_t *ctx, double latency_ms)
 {
-    if (!ctx || !ctx->result || ctx->result->sample_count >= ctx->config.iterations) {
+    if (!ctx || !ctx->result || latency_ms < 0) {
         return;
     }
     
-    ctx->result->latency_samples[ctx->result->sample_count] = latency_ms;
+    uint64_t interval_ns = (uint64_t)(ctx->config.intended_interval_ms * 1e6);
+    latency_histogram_record_corrected(&ctx->result->latency_histogram,
+                                       (uint64_t)(latency_ms * 1e6), interval_ns);
     ctx->result->sample_count++;
 }
 
+void merge_latency_histogram(benchmark_context_t *ctx, const latency_histogram_t *hist)
+{
+    if (!ctx || !ctx->result || !hist) {
+        return;
+    }
+    
+    pthread_mutex_lock(&ctx->mutex);
+    latency_histogram_merge(&ctx->result->latency_histogram, hist);
+    ctx->result->sample_count += hist->total_count;
+    pthread_mutex_unlock(&ctx->mutex);
+}
+
+void calculate_histogram_statistics(const latency_histogram_t *hist,
+                                  performance_metrics_t *metrics)
+{
+    if (!hist || !metrics) {
+        return;
+    }
+    
+    if (hist->total_count == 0) {
+        metrics->latency_ms = metrics->latency_std_ms = 0;
+        metrics->latency_min_ms = metrics->latency_max_ms = 0;
+        metrics->latency_p50_ms = metrics->latency_p90_ms = metrics->latency_p99_ms = 0;
+        metrics->latency_p999_ms = metrics->latency_p9999_ms = 0;
+        return;
+    }
+    
+    double n = (double)hist->total_count;
+    double mean = hist->sum_ns / n;
+    double variance = hist->sum_sq_ns / n - mean * mean;
+    
+    metrics->latency_ms = mean / 1e6;
+    metrics->latency_std_ms = variance > 0 ? sqrt(variance) / 1e6 : 0;
+    metrics->latency_min_ms = hist->min_ns / 1e6;
+    metrics->latency_max_ms = hist->max_ns / 1e6;
+    metrics->latency_p50_ms = latency_histogram_percentile(hist, 50.0) / 1e6;
+    metrics->latency_p90_ms = latency_histogram_percentile(hist, 90.0) / 1e6;
+    metrics->latency_p99_ms = latency_histogram_percentile(hist, 99.0) / 1e6;
+    metrics->latency_p999_ms = latency_histogram_percentile(hist, 99.9) / 1e6;
+    metrics->latency_p9999_ms = latency_histogram_percentile(hist, 99.99) / 1e6;
+}
+
 void calculate_latency_statistics(double *samples, uint32_t count,
                                 double *mean, double *std_dev,
                                 double *min_val, double *max_val)
@@ -439,6 +483,150 @@ void calculate_latency_statistics(double *samples, uint32_t count,
     if (max_val) *max_val = max_v;
 }
 
+// =============================================================================
+// Latency Histogram Functions
+// =============================================================================
+
+#define LATENCY_HIST_HALF (1ULL << (LATENCY_HIST_SUB_BITS - 1))
+#define LATENCY_HIST_LIMIT ((1ULL << LATENCY_HIST_MAX_BITS) - 1)
+
+// Bucket of a value: exact below 2^SUB_BITS, then HALF linear steps per octave
+static uint32_t latency_bucket_index(uint64_t value)
+{
+    if (value < (1ULL << LATENCY_HIST_SUB_BITS)) {
+        return (uint32_t)value;
+    }
+    
+    uint32_t shift = (63 - __builtin_clzll(value)) - LATENCY_HIST_SUB_BITS + 1;
+    return (uint32_t)(shift * LATENCY_HIST_HALF + (value >> shift));
+}
+
+static uint64_t latency_bucket_lowest(uint32_t index)
+{
+    if (index < (1U << LATENCY_HIST_SUB_BITS)) {
+        return index;
+    }
+    
+    uint32_t shift = (uint32_t)(index / LATENCY_HIST_HALF) - 1;
+    return (index % LATENCY_HIST_HALF + LATENCY_HIST_HALF) << shift;
+}
+
+static uint64_t latency_bucket_highest(uint32_t index)
+{
+    if (index < (1U << LATENCY_HIST_SUB_BITS)) {
+        return index;
+    }
+    
+    uint32_t shift = (uint32_t)(index / LATENCY_HIST_HALF) - 1;
+    return latency_bucket_lowest(index) + (1ULL << shift) - 1;
+}
+
+void latency_histogram_reset(latency_histogram_t *hist)
+{
+    if (!hist) return;
+    
+    memset(hist, 0, sizeof(*hist));
+    hist->min_ns = UINT64_MAX;
+}
+
+void latency_histogram_record(latency_histogram_t *hist, uint64_t value_ns)
+{
+    if (!hist) return;
+    
+    if (value_ns > LATENCY_HIST_LIMIT) {
+        value_ns = LATENCY_HIST_LIMIT;
+    }
+    
+    hist->counts[latency_bucket_index(value_ns)]++;
+    hist->total_count++;
+    hist->sum_ns += (double)value_ns;
+    hist->sum_sq_ns += (double)value_ns * (double)value_ns;
+    if (value_ns < hist->min_ns) hist->min_ns = value_ns;
+    if (value_ns > hist->max_ns) hist->max_ns = value_ns;
+}
+
+void latency_histogram_record_corrected(latency_histogram_t *hist, uint64_t value_ns,
+                                       uint64_t interval_ns)
+{
+    if (!hist) return;
+    
+    if (value_ns > LATENCY_HIST_LIMIT) {
+        value_ns = LATENCY_HIST_LIMIT;
+    }
+    latency_histogram_record(hist, value_ns);
+    
+    if (interval_ns == 0 || value_ns <= interval_ns) {
+        return;
+    }
+    
+    // Missed samples value - k * interval (k >= 1) down to interval, added a
+    // bucket at a time so a long stall costs O(buckets), not O(stall / interval)
+    uint64_t v = value_ns - interval_ns;
+    while (v >= interval_ns) {
+        uint32_t index = latency_bucket_index(v);
+        uint64_t lowest = latency_bucket_lowest(index);
+        uint64_t floor_v = lowest > interval_ns ? lowest : interval_ns;
+        uint64_t n = (v - floor_v) / interval_ns + 1;
+        
+        // Arithmetic series v, v - interval, ..., v - (n - 1) * interval
+        double dn = (double)n;
+        double dv = (double)v;
+        double di = (double)interval_ns;
+        double s1 = dn * (dn - 1) / 2;
+        double s2 = (dn - 1) * dn * (2 * dn - 1) / 6;
+        
+        hist->counts[index] += n;
+        hist->total_count += n;
+        hist->sum_ns += dn * dv - di * s1;
+        hist->sum_sq_ns += dn * dv * dv - 2 * dv * di * s1 + di * di * s2;
+        
+        uint64_t last = v - (n - 1) * interval_ns;
+        if (last < hist->min_ns) hist->min_ns = last;
+        v = last - interval_ns;
+    }
+}
+
+void latency_histogram_merge(latency_histogram_t *dst, const latency_histogram_t *src)
+{
+    if (!dst || !src || src->total_count == 0) return;
+    
+    for (uint32_t i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        dst->counts[i] += src->counts[i];
+    }
+    dst->total_count += src->total_count;
+    dst->sum_ns += src->sum_ns;
+    dst->sum_sq_ns += src->sum_sq_ns;
+    if (src->min_ns < dst->min_ns) dst->min_ns = src->min_ns;
+    if (src->max_ns > dst->max_ns) dst->max_ns = src->max_ns;
+}
+
+uint64_t latency_histogram_percentile(const latency_histogram_t *hist, double percentile)
+{
+    if (!hist || hist->total_count == 0) {
+        return 0;
+    }
+    
+    if (percentile < 0) percentile = 0;
+    if (percentile > 100) percentile = 100;
+    
+    // Smallest value with at least percentile% of samples at or below it
+    uint64_t target = (uint64_t)ceil(percentile / 100.0 * (double)hist->total_count);
+    if (target == 0) target = 1;
+    
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        seen += hist->counts[i];
+        if (seen >= target) {
+            uint64_t value = latency_bucket_highest(i);
+            if (value > hist->max_ns) value = hist->max_ns;
+            if (value < hist->min_ns) value = hist->min_ns;
+            return value;
+        }
+    }
+    
+    return hist->max_ns;
+}
+
 // =============================================================================
 // Utility Functions
 // =============================================================================
@@ -636,6 +824,9 @@ void print_performance_metrics(const performance_metrics_t *metrics)
     printf("  Latency: %.3f ± %.3f ms (min: %.3f, max: %.3f)\n",
            metrics->latency_ms, metrics->latency_std_ms,
            metrics->latency_min_ms, metrics->latency_max_ms);
+    printf("  Latency Percentiles: p50 %.3f, p90 %.3f, p99 %.3f, p99.9 %.3f, p99.99 %.3f ms\n",
+           metrics->latency_p50_ms, metrics->latency_p90_ms, metrics->latency_p99_ms,
+           metrics->latency_p999_ms, metrics->latency_p9999_ms);
     printf("  Bandwidth: %.2f GB/s\n", metrics->bandwidth_gbps);
     if (metrics->power_watts > 0) {
         printf("  Power: %.2f W\n", metrics->power_watts);
@@ -643,5 +834,6 @@ void print_performance_metrics(const performance_metrics_t *metrics)
     }
     printf("  Operations: %lu\n", metrics->operations_count);
     printf("  Data Transferred: %.2f MB\n", (double)metrics->data_transferred / (1024*1024));
+    print_host_counters(metrics);
     printf("\n");
 }
\ No newline at end of file
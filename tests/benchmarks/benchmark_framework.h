@@ -30,9 +30,14 @@
 #define MAX_DESCRIPTION_LENGTH 256
 #define MAX_WARMUP_ITERATIONS 10
 #define DEFAULT_BENCHMARK_ITERATIONS 100
-#define MAX_DATA_POINTS 10000
 #define TIMESTAMP_BUFFER_SIZE 1024
 
+// Latency histogram: log-linear buckets, within 1/256 of each value up to 2^MAX_BITS ns
+#define LATENCY_HIST_SUB_BITS 9
+#define LATENCY_HIST_MAX_BITS 44
+#define LATENCY_HIST_BUCKETS \
+    ((LATENCY_HIST_MAX_BITS - LATENCY_HIST_SUB_BITS + 2) << (LATENCY_HIST_SUB_BITS - 1))
+
 // Color codes for terminal output
 #define ANSI_RESET   "\033[0m"
 #define ANSI_RED     "\033[31m"
@@ -71,6 +76,15 @@ typedef enum {
     SIZE_CUSTOM    // User-defined size
 } benchmark_size_t;
 
+/**
+ * Open-loop arrival processes
+ */
+typedef enum {
+    ARRIVAL_CONSTANT,  // Fixed inter-arrival time
+    ARRIVAL_POISSON,   // Exponential inter-arrival times
+    ARRIVAL_BURSTY     // On-off: Poisson during on periods, silent during off
+} arrival_process_t;
+
 /**
  * Performance metrics structure
  */
@@ -81,6 +95,11 @@ typedef struct {
     double latency_min_ms;       // Minimum latency
     double latency_max_ms;       // Maximum latency
     double latency_std_ms;       // Standard deviation of latency
+    double latency_p50_ms;       // Latency percentiles
+    double latency_p90_ms;
+    double latency_p99_ms;
+    double latency_p999_ms;
+    double latency_p9999_ms;
     double bandwidth_gbps;       // Memory bandwidth in GB/s
     double power_watts;          // Power consumption in watts
     double efficiency_gops_watt; // Energy efficiency in GOPS/Watt
@@ -89,6 +108,15 @@ typedef struct {
     uint64_t operations_count;   // Total operations performed
     uint64_t data_transferred;   // Total data transferred in bytes
     double duration_seconds;     // Total benchmark duration
+    uint64_t host_cycles;        // Host CPU counters of the benchmark threads
+    uint64_t host_instructions;  // (0: counter unavailable)
+    uint64_t host_cache_references;
+    uint64_t host_cache_misses;  // Last-level cache misses
+    uint64_t host_context_switches;
+    uint64_t host_page_faults;
+    bool host_user_only;         // Kernel-mode work not counted (perf_event_paranoid)
+    double host_ipc;             // Host instructions per cycle
+    double host_instructions_per_byte; // Host instructions per byte transferred
 } performance_metrics_t;
 
 /**
@@ -110,16 +138,68 @@ typedef struct {
     bool enable_memory_profiling;
     uint32_t thread_count;       // For multi-threaded benchmarks
     double target_duration_sec;  // Target benchmark duration
+    double intended_interval_ms; // Intended send interval for coordinated-omission
+                                 // correction of latency samples (0: off)
+    arrival_process_t arrival_process; // Open-loop arrival process
+    double offered_rate;         // Open-loop offered load, requests/s (0: sweep)
+    char output_path[MAX_DESCRIPTION_LENGTH]; // Data file for curve benchmarks ("": none)
 } benchmark_config_t;
 
+/**
+ * Streaming latency histogram
+ */
+typedef struct {
+    uint64_t counts[LATENCY_HIST_BUCKETS];
+    uint64_t total_count;        // Samples, corrections included
+    uint64_t min_ns;             // Exact minimum
+    uint64_t max_ns;             // Exact maximum
+    double sum_ns;               // Sum of samples, for the mean
+    double sum_sq_ns;            // Sum of squares, for the standard deviation
+} latency_histogram_t;
+
+/**
+ * Host CPU counters (perf_event_open)
+ */
+typedef enum {
+    HOST_COUNTER_CYCLES,
+    HOST_COUNTER_INSTRUCTIONS,
+    HOST_COUNTER_CACHE_REFERENCES,
+    HOST_COUNTER_CACHE_MISSES,
+    HOST_COUNTER_CONTEXT_SWITCHES,
+    HOST_COUNTER_PAGE_FAULTS,
+    HOST_COUNTER_COUNT
+} host_counter_t;
+
+/**
+ * Host counter totals of one or more threads
+ */
+typedef struct {
+    uint64_t values[HOST_COUNTER_COUNT]; // Scaled for PMU multiplexing
+    uint32_t valid_mask;         // Bit per counter counted by every thread
+    uint32_t threads;            // Threads added in
+    bool user_only;              // Kernel-mode work excluded
+} host_counter_values_t;
+
+/**
+ * Counter groups of one thread: hardware events in one group, software
+ * events in another
+ */
+typedef struct {
+    int hw_leader;               // -1: hardware counters unavailable
+    int sw_leader;               // -1: software counters unavailable
+    int fds[HOST_COUNTER_COUNT];
+    uint64_t ids[HOST_COUNTER_COUNT];
+    host_counter_values_t totals; // Accumulated over start/stop intervals
+} host_counter_group_t;
+
 /**
  * Benchmark result structure
  */
 typedef struct {
     benchmark_config_t config;
     performance_metrics_t metrics;
-    double *latency_samples;     // Array of individual latency measurements
-    uint32_t sample_count;       // Number of latency samples
+    latency_histogram_t latency_histogram; // Distribution of latency samples
+    uint64_t sample_count;       // Number of latency samples
     struct timespec start_time;  // Benchmark start timestamp
     struct timespec end_time;    // Benchmark end timestamp
     bool success;                // Whether benchmark completed successfully
@@ -142,6 +222,8 @@ typedef struct {
     npu_buffer_handle_t buffer_result; // NPU result buffer handle
     bool stop_requested;         // Stop flag for long-running benchmarks
     pthread_mutex_t mutex;       // Thread synchronization
+    host_counter_group_t host_counters; // Counters of the benchmark thread
+    host_counter_values_t host_totals;  // Benchmark thread plus merged worker threads
 } benchmark_context_t;
 
 /**
@@ -235,12 +317,31 @@ void start_performance_monitoring(benchmark_context_t *ctx);
 void stop_performance_monitoring(benchmark_context_t *ctx);
 
 /**
- * Record single latency measurement
+ * Record single latency measurement into the result histogram. With
+ * config.intended_interval_ms set, the samples a stalled closed-loop sender
+ * failed to issue are added as well (coordinated-omission correction).
+ * Not thread-safe; worker threads record into their own histogram and
+ * hand it to merge_latency_histogram.
  * @param ctx Benchmark context
  * @param latency_ms Latency in milliseconds
  */
 void record_latency_sample(benchmark_context_t *ctx, double latency_ms);
 
+/**
+ * Merge a per-thread histogram into the result histogram (thread-safe)
+ * @param ctx Benchmark context
+ * @param hist Histogram recorded by one thread
+ */
+void merge_latency_histogram(benchmark_context_t *ctx, const latency_histogram_t *hist);
+
+/**
+ * Calculate latency statistics and percentiles from a histogram
+ * @param hist Latency histogram
+ * @param metrics Metrics to store latency_* values in
+ */
+void calculate_histogram_statistics(const latency_histogram_t *hist,
+                                  performance_metrics_t *metrics);
+
 /**
  * Calculate statistics from latency samples
  * @param samples Array of latency samples
@@ -254,6 +355,210 @@ void calculate_latency_statistics(double *samples, uint32_t count,
                                 double *mean, double *std_dev,
                                 double *min_val, double *max_val);
 
+// =============================================================================
+// Host CPU Counters
+// =============================================================================
+
+/**
+ * Open the host counter groups of the calling thread. Counters the kernel
+ * refuses are left out; kernel-mode counting falls back to user-only when
+ * not permitted.
+ * @param group Counter groups to initialize
+ * @return 0 if any counter is available, -1 if none (group is still safe to use)
+ */
+int host_counters_open(host_counter_group_t *group);
+
+/**
+ * Reset and start counting on the calling thread
+ * @param group Counter groups opened by the calling thread
+ */
+void host_counters_start(host_counter_group_t *group);
+
+/**
+ * Stop counting and add the interval to group->totals
+ * @param group Counter groups opened by the calling thread
+ */
+void host_counters_stop(host_counter_group_t *group);
+
+/**
+ * Close the counter groups
+ * @param group Counter groups
+ */
+void host_counters_close(host_counter_group_t *group);
+
+/**
+ * Add the totals of src to dst
+ * @param dst Destination totals
+ * @param src Source totals
+ */
+void host_counter_values_add(host_counter_values_t *dst, const host_counter_values_t *src);
+
+/**
+ * Merge the totals of a worker thread into ctx->host_totals (thread-safe)
+ * @param ctx Benchmark context
+ * @param values Totals counted by one thread
+ */
+void merge_host_counters(benchmark_context_t *ctx, const host_counter_values_t *values);
+
+/**
+ * Store host counters and derived IPC and instructions per byte in metrics.
+ * Call after metrics->data_transferred is set.
+ * @param values Counter totals
+ * @param metrics Metrics to store host_* values in
+ */
+void host_counters_to_metrics(const host_counter_values_t *values, performance_metrics_t *metrics);
+
+/**
+ * Print the host counter line of metrics (nothing if none were counted)
+ * @param metrics Performance metrics
+ */
+void print_host_counters(const performance_metrics_t *metrics);
+
+// =============================================================================
+// Latency Histogram Functions
+// =============================================================================
+
+/**
+ * Reset histogram to empty
+ * @param hist Histogram to reset
+ */
+void latency_histogram_reset(latency_histogram_t *hist);
+
+/**
+ * Record one latency value
+ * @param hist Histogram
+ * @param value_ns Latency in nanoseconds (clamped to the tracked range)
+ */
+void latency_histogram_record(latency_histogram_t *hist, uint64_t value_ns);
+
+/**
+ * Record one latency value with coordinated-omission correction: a value
+ * longer than the intended send interval also records the latencies of the
+ * requests that would have been sent while it was outstanding (value minus
+ * one interval, minus two, ... down to the interval)
+ * @param hist Histogram
+ * @param value_ns Latency in nanoseconds
+ * @param interval_ns Intended send interval in nanoseconds (0: no correction)
+ */
+void latency_histogram_record_corrected(latency_histogram_t *hist, uint64_t value_ns,
+                                       uint64_t interval_ns);
+
+/**
+ * Add every sample of src to dst
+ * @param dst Destination histogram
+ * @param src Source histogram
+ */
+void latency_histogram_merge(latency_histogram_t *dst, const latency_histogram_t *src);
+
+/**
+ * Get value at a percentile
+ * @param hist Histogram
+ * @param percentile Percentile, 0 to 100
+ * @return Highest value equivalent to the bucket holding the percentile, in
+ *         nanoseconds (0 if empty)
+ */
+uint64_t latency_histogram_percentile(const latency_histogram_t *hist, double percentile);
+
+// =============================================================================
+// Open-Loop Load Generation
+// =============================================================================
+
+#define LOAD_DEFAULT_QUEUE_DEPTH 65536
+#define LOAD_MAX_SWEEP_POINTS 32
+
+/**
+ * Request issued by a submitter thread
+ * @param ctx Benchmark context
+ * @param arg User argument
+ * @param submitter Submitter index, for per-thread buffers
+ * @return 0 on success, negative on error
+ */
+typedef int (*load_request_function_t)(benchmark_context_t *ctx, void *arg, uint32_t submitter);
+
+/**
+ * Open-loop load configuration
+ */
+typedef struct {
+    arrival_process_t arrival;
+    double rate_per_sec;         // Mean offered load, requests per second
+    double duration_sec;         // Length of the arrival window
+    uint32_t submitters;         // Submitter threads serving the arrival queue
+    uint32_t queue_depth;        // Pending arrivals before new ones are dropped (0: default)
+    double burst_on_ms;          // BURSTY: mean on period
+    double burst_off_ms;         // BURSTY: mean off period
+    uint64_t seed;               // Arrival process seed
+} load_generator_config_t;
+
+/**
+ * Result of one open-loop run
+ */
+typedef struct {
+    double offered_rate;         // Arrivals per second actually generated
+    double achieved_rate;        // Completions per second
+    uint64_t arrivals;
+    uint64_t completed;
+    uint64_t errors;
+    uint64_t dropped;            // Arrivals lost to a full queue
+    double max_lateness_ms;      // Worst generator lag behind the schedule
+    latency_histogram_t response; // Completion minus intended start
+    latency_histogram_t service;  // Completion minus dispatch
+    performance_metrics_t metrics; // Latency statistics of response
+} load_generator_result_t;
+
+/**
+ * Default open-loop configuration: Poisson arrivals for 5 seconds
+ * @param rate_per_sec Offered load
+ * @param submitters Submitter threads
+ * @return Configuration
+ */
+load_generator_config_t create_default_load_config(double rate_per_sec, uint32_t submitters);
+
+/**
+ * Generate arrivals at the configured rate and dispatch them to a pool of
+ * submitters. Response time is measured from each request's intended start,
+ * so queueing behind a slow request is counted (open loop).
+ * @param ctx Benchmark context
+ * @param config Load configuration
+ * @param request Request to issue per arrival
+ * @param arg Argument passed to request
+ * @param result Result to fill
+ * @return 0 on success, negative on error
+ */
+int run_open_loop_load(benchmark_context_t *ctx, const load_generator_config_t *config,
+                      load_request_function_t request, void *arg,
+                      load_generator_result_t *result);
+
+/**
+ * Latency versus offered load: one open-loop run per rate, in order, until
+ * the system saturates (achieved rate below 95% of offered, or drops)
+ * @param ctx Benchmark context
+ * @param config Base configuration (rate_per_sec is replaced per point)
+ * @param request Request to issue per arrival
+ * @param arg Argument passed to request
+ * @param rates Offered loads, requests per second
+ * @param count Number of rates
+ * @param csv Optional CSV output of the curve (NULL: none)
+ * @return Number of points run, negative on error
+ */
+int sweep_open_loop_load(benchmark_context_t *ctx, const load_generator_config_t *config,
+                        load_request_function_t request, void *arg,
+                        const double *rates, size_t count, FILE *csv);
+
+/**
+ * Open-loop latency benchmark: measures closed-loop capacity, then sweeps
+ * offered load from 10% to 120% of it (or runs config.offered_rate)
+ * @param ctx Benchmark context
+ * @return 0 on success, negative on error
+ */
+int benchmark_open_loop_latency(benchmark_context_t *ctx);
+
+/**
+ * Convert arrival process to string
+ * @param arrival Arrival process
+ * @return String representation
+ */
+const char* arrival_process_to_string(arrival_process_t arrival);
+
 // =============================================================================
 // Throughput Benchmarks
 // =============================================================================
@@ -361,6 +666,478 @@ int benchmark_energy_efficiency(benchmark_context_t *ctx);
  */
 int benchmark_thermal_behavior(benchmark_context_t *ctx);
 
+// =============================================================================
+// Roofline Analysis
+// =============================================================================
+
+/**
+ * Operators placed on the roofline
+ */
+typedef enum {
+    ROOFLINE_OP_MATMUL = 0,
+    ROOFLINE_OP_CONV2D,
+    ROOFLINE_OP_ADD,
+    ROOFLINE_OP_MULTIPLY,
+    ROOFLINE_OP_RELU,
+    ROOFLINE_OP_COUNT
+} roofline_op_t;
+
+/**
+ * Operator and shape. dims is {M, N, K} for MATMUL, {C_in, H, W, C_out, K}
+ * for CONV2D (stride 1, same padding) and {elements} otherwise.
+ */
+typedef struct {
+    roofline_op_t op;
+    uint32_t dims[5];
+} roofline_shape_t;
+
+/**
+ * Ceilings of the device, from npu_device_info and a measured copy
+ */
+typedef struct {
+    uint32_t frequency_mhz;
+    double peak_gflops;          // PEs x cores x 2 FLOPs x clock
+    double memory_gbps;          // Device memory port
+    double pcie_theoretical_gbps; // Link generation x lanes
+    double pcie_measured_gbps;   // DMA to the device and back, largest buffer
+} roofline_ceilings_t;
+
+/**
+ * One operator measured against the ceilings
+ */
+typedef struct {
+    roofline_shape_t shape;
+    char label[64];
+    double flops;                // Per call
+    double bytes;                // Operands and result, per call
+    double intensity;            // flops / bytes
+    double time_ms;              // Per call, end to end
+    double gflops;               // End to end
+    double gbps;                 // End to end
+    double device_gflops;        // Over device cycles (0: counters unavailable)
+    double device_bytes;         // Memory-port traffic per call (0: not counted)
+    double device_intensity;     // flops / device_bytes
+    double attainable_gflops;    // Lowest roof at this intensity
+    double efficiency;           // gflops / attainable_gflops
+    const char *bound;           // "compute", "pcie" or "memory"
+} roofline_point_t;
+
+/**
+ * FLOPs and compulsory bytes of one call of an operator
+ * @param shape Operator and shape
+ * @param flops Pointer to store FLOPs
+ * @param bytes Pointer to store bytes read and written
+ */
+void roofline_operator_cost(const roofline_shape_t *shape, double *flops, double *bytes);
+
+/**
+ * Derive the compute and bandwidth ceilings of the device
+ * @param ctx Benchmark context
+ * @param ceilings Ceilings to fill
+ * @return 0 on success, negative on error
+ */
+int measure_roofline_ceilings(benchmark_context_t *ctx, roofline_ceilings_t *ceilings);
+
+/**
+ * Time one operator over config.iterations calls and place it on the roofline
+ * @param ctx Benchmark context
+ * @param shape Operator and shape
+ * @param ceilings Device ceilings
+ * @param point Point to fill
+ * @return 0 on success, negative on error
+ */
+int measure_roofline_point(benchmark_context_t *ctx, const roofline_shape_t *shape,
+                          const roofline_ceilings_t *ceilings, roofline_point_t *point);
+
+/**
+ * Write the roofline as CSV and as HTML with an inline log-log SVG chart
+ * @param csv_path CSV output (NULL: none)
+ * @param html_path HTML output (NULL: none)
+ * @param ceilings Device ceilings
+ * @param points Measured operators
+ * @param count Number of points
+ * @return 0 on success, negative on error
+ */
+int write_roofline_report(const char *csv_path, const char *html_path,
+                         const roofline_ceilings_t *ceilings,
+                         const roofline_point_t *points, size_t count);
+
+/**
+ * Roofline benchmark: measures the ceilings and every default operator
+ * shape, and writes <output>.csv and <output>.html
+ * @param ctx Benchmark context
+ * @return 0 on success, negative on error
+ */
+int benchmark_roofline(benchmark_context_t *ctx);
+
+/**
+ * Convert roofline operator to string
+ * @param op Operator
+ * @return String representation
+ */
+const char* roofline_op_to_string(roofline_op_t op);
+
+// =============================================================================
+// Host Overhead Microbenchmarks
+// =============================================================================
+
+#define OVERHEAD_MAX_BUDGET_LINES 8
+
+/**
+ * Host-side layers timed in isolation, cheapest first
+ */
+typedef enum {
+    OVERHEAD_PROBE_TIMER = 0,    // Timestamp pair, subtracted from every probe
+    OVERHEAD_PROBE_SYSCALL,      // Bare system call
+    OVERHEAD_PROBE_NULL_IOCTL,   // Driver entry and return (NPU_IOCTL_NOP)
+    OVERHEAD_PROBE_COPY_IOCTL,   // ioctl copying a struct to user space
+    OVERHEAD_PROBE_STATUS_POLL,  // ioctl reading the status register
+    OVERHEAD_PROBE_SUBMIT,       // Instruction write and doorbell
+    OVERHEAD_PROBE_ROUND_TRIP,   // Minimal instruction, submit to completion
+    OVERHEAD_PROBE_EVENTFD,      // eventfd round trip between two threads
+    OVERHEAD_PROBE_CONDVAR,      // Condition variable round trip between two threads
+    OVERHEAD_PROBE_OPERATOR,     // Small operator through the library
+    OVERHEAD_PROBE_COUNT
+} overhead_probe_t;
+
+/**
+ * Latency of one probe
+ */
+typedef struct {
+    overhead_probe_t probe;
+    bool available;              // False if the backend does not support it
+    uint64_t samples;
+    double min_us;
+    double p50_us;
+    double p99_us;
+    double mean_us;
+} overhead_probe_result_t;
+
+/**
+ * Where the median latency of the operator probe goes
+ */
+typedef struct {
+    struct {
+        const char *layer;
+        double us;
+    } lines[OVERHEAD_MAX_BUDGET_LINES];
+    uint32_t count;
+    double total_us;             // Operator median, timer excluded
+    double copy_to_user_us;      // Reference costs inside the layers
+    double mmio_read_us;
+    double wait_queue_wakeup_us; // One way: half an eventfd round trip
+    double futex_wakeup_us;      // One way: half a condvar round trip
+} overhead_budget_t;
+
+/**
+ * Time one probe config.iterations times after config.warmup_iterations
+ * @param ctx Benchmark context
+ * @param probe Probe to run
+ * @param result Result to fill
+ * @param metrics Metrics to store the latency statistics in (NULL: none)
+ * @return 0 on success, negative if the probe is unavailable or failed
+ */
+int run_overhead_probe(benchmark_context_t *ctx, overhead_probe_t probe,
+                      overhead_probe_result_t *result, performance_metrics_t *metrics);
+
+/**
+ * Split the operator median into layers by differences between probe
+ * medians (syscall, ioctl dispatch, copy and doorbell, device completion,
+ * tensor staging)
+ * @param results Results of every probe, indexed by overhead_probe_t
+ * @param budget Budget to fill
+ */
+void compute_overhead_budget(const overhead_probe_result_t *results, overhead_budget_t *budget);
+
+/**
+ * Write probe latencies and the budget as CSV
+ * @param filename Output CSV filename
+ * @param results Results of every probe
+ * @param budget Latency budget
+ * @return 0 on success, negative on error
+ */
+int write_overhead_csv(const char *filename, const overhead_probe_result_t *results,
+                      const overhead_budget_t *budget);
+
+/**
+ * Host overhead benchmark: runs every probe and prints the latency budget
+ * of a small operator. Reports the minimal round trip as its latency.
+ * @param ctx Benchmark context
+ * @return 0 on success, negative on error
+ */
+int benchmark_host_overhead(benchmark_context_t *ctx);
+
+/**
+ * Convert overhead probe to string
+ * @param probe Probe
+ * @return String representation
+ */
+const char* overhead_probe_to_string(overhead_probe_t probe);
+
+// =============================================================================
+// DMA Bandwidth Sweep
+// =============================================================================
+
+#define DMA_SWEEP_MAX_POINTS 192
+#define DMA_SWEEP_MAX_DEPTH 8
+
+/**
+ * Direction of the transfers in a sweep point
+ */
+typedef enum {
+    DMA_DIR_H2D = 0,             // Host to device
+    DMA_DIR_D2H,                 // Device to host
+    DMA_DIR_BIDIR,               // Both, alternating per transfer and thread
+    DMA_DIR_COUNT
+} dma_direction_t;
+
+/**
+ * One configuration of the sweep
+ */
+typedef struct {
+    dma_direction_t direction;
+    bool pinned;                 // Data already in a managed buffer; otherwise
+                                 // staged through pageable malloc memory
+    uint32_t alignment;          // Byte offset of the host side from a page boundary
+    uint32_t queue_depth;        // Threads keeping a transfer outstanding
+    size_t size;                 // Bytes per transfer
+} dma_sweep_params_t;
+
+/**
+ * Measured rate and per-transfer latency of one configuration
+ */
+typedef struct {
+    dma_sweep_params_t params;
+    uint64_t transfers;
+    double gbps;                 // Bytes moved over wall time, all threads
+    double mean_us;              // Per transfer
+    double p50_us;
+    double p99_us;
+} dma_sweep_point_t;
+
+/**
+ * Fit of t = overhead + size / peak to the size sweep of one curve
+ */
+typedef struct {
+    dma_direction_t direction;
+    bool pinned;
+    double overhead_us;          // Fixed cost of every transfer
+    double peak_gbps;            // Rate approached by large transfers
+    double half_size;            // Size reaching half the peak (n 1/2), bytes
+    size_t knee_size;            // Smallest size measured at 90% of the best rate
+    double best_gbps;            // Best measured rate
+} dma_sweep_fit_t;
+
+/**
+ * Time one sweep configuration: config.iterations transfers per thread after
+ * config.warmup_iterations, fewer for large sizes
+ * @param ctx Benchmark context
+ * @param params Configuration to time
+ * @param point Point to fill
+ * @return 0 on success, negative on error
+ */
+int run_dma_sweep_point(benchmark_context_t *ctx, const dma_sweep_params_t *params,
+                       dma_sweep_point_t *point);
+
+/**
+ * Fit the per-transfer overhead and peak rate of one curve by least
+ * squares on relative error, and find its knee
+ * @param points Points of the curve (queue depth 1, no misalignment)
+ * @param count Number of points
+ * @param fit Fit to fill; direction and pinned are taken from the points
+ */
+void fit_dma_sweep_curve(const dma_sweep_point_t *points, size_t count, dma_sweep_fit_t *fit);
+
+/**
+ * Write sweep points and curve fits as CSV, one row each
+ * @param filename Output CSV filename
+ * @param points Sweep points
+ * @param point_count Number of points
+ * @param fits Curve fits
+ * @param fit_count Number of fits
+ * @return 0 on success, negative on error
+ */
+int write_dma_sweep_csv(const char *filename, const dma_sweep_point_t *points, size_t point_count,
+                       const dma_sweep_fit_t *fits, size_t fit_count);
+
+/**
+ * DMA bandwidth sweep through npu_dma_transfer(): sizes from 64 B up to the
+ * configured size class, each direction, pinned and pageable memory, then
+ * host alignments and queue depths. Reports the best pinned host-to-device
+ * rate as its bandwidth.
+ * @param ctx Benchmark context
+ * @return 0 on success, negative on error
+ */
+int benchmark_dma_sweep(benchmark_context_t *ctx);
+
+/**
+ * Convert DMA direction to string
+ * @param direction Direction
+ * @return String representation
+ */
+const char* dma_direction_to_string(dma_direction_t direction);
+
+// =============================================================================
+// Model Inference Benchmark
+// =============================================================================
+
+#define MODEL_MAX_LAYERS 24
+#define MODEL_MAX_BATCHES 9          // Batch sizes 1, 2, 4, ... 256
+#define MODEL_TOP_LAYERS 5
+
+/**
+ * Operator of a model layer
+ */
+typedef enum {
+    MODEL_OP_CONV = 0,           // Valid convolution, stride 1, one image per call
+    MODEL_OP_MAX_POOL,           // Non-overlapping max pooling, one image per call
+    MODEL_OP_FC,                 // Matrix multiply over the whole batch
+    MODEL_OP_BIAS,               // Add a bias broadcast to the batch, in place
+    MODEL_OP_RELU,               // In place
+    MODEL_OP_SIGMOID,            // In place
+    MODEL_OP_SOFTMAX,            // Dequantize logits on the host, softmax per image
+    MODEL_OP_COUNT
+} model_op_t;
+
+/**
+ * One layer; the input shape is the output shape of the layer before
+ */
+typedef struct {
+    const char *name;
+    model_op_t op;
+    uint32_t out_features;       // Conv: filters; FC: outputs
+    uint32_t kernel;             // Conv: kernel size; pool: window and stride
+} model_layer_t;
+
+/**
+ * A network of the examples
+ */
+typedef struct {
+    const char *name;
+    const char *description;
+    uint32_t in_c, in_h, in_w;   // Shape of one input image
+    const model_layer_t *layers;
+    size_t layer_count;
+} model_def_t;
+
+/**
+ * Time of one layer per inference, split by phase
+ */
+typedef struct {
+    double host_prep_us;         // Host work outside the other phases
+    double h2d_us;               // Operands copied into the device buffer
+    double compute_us;           // Instruction submission to completion
+    double d2h_us;               // Results copied out of the device buffer
+    double total_us;
+    double h2d_bytes;
+    double d2h_bytes;
+} model_layer_time_t;
+
+/**
+ * Throughput and per-layer breakdown of a model at one batch size
+ */
+typedef struct {
+    uint32_t batch;
+    double images_per_sec;
+    double latency_ms;           // Per batch, without profiling
+    model_layer_time_t layers[MODEL_MAX_LAYERS];
+} model_batch_result_t;
+
+/**
+ * Run one model at one batch size: config.iterations timed inferences for
+ * images/sec, then as many again with each layer profiled
+ * @param ctx Benchmark context
+ * @param model Model to run
+ * @param batch Images per inference
+ * @param result Result to fill
+ * @return 0 on success, negative on error
+ */
+int run_model_batch(benchmark_context_t *ctx, const model_def_t *model, uint32_t batch,
+                   model_batch_result_t *result);
+
+/**
+ * Write throughput and per-layer rows of every model and batch size as CSV
+ * @param filename Output CSV filename
+ * @param models Models run
+ * @param results Results, MODEL_MAX_BATCHES per model
+ * @param batch_counts Batch sizes run per model
+ * @param model_count Number of models
+ * @return 0 on success, negative on error
+ */
+int write_model_csv(const char *filename, const model_def_t *models,
+                   const model_batch_result_t *results, const size_t *batch_counts,
+                   size_t model_count);
+
+/**
+ * End-to-end benchmark of the example networks (the LeNet-5 CNN and the
+ * MLP) at batch sizes 1 to 256, with a per-layer time breakdown and the
+ * layers that take the most time. Reports the best CNN images/sec as its
+ * throughput.
+ * @param ctx Benchmark context
+ * @return 0 on success, negative on error
+ */
+int benchmark_model_inference(benchmark_context_t *ctx);
+
+/**
+ * Convert model operator to string
+ * @param op Operator
+ * @return String representation
+ */
+const char* model_op_to_string(model_op_t op);
+
+// =============================================================================
+// Cooperative GEMM Benchmark
+// =============================================================================
+
+#define COOP_GEMM_MAX_POINTS 32
+
+/**
+ * Throughput of one matmul shape and host thread count
+ */
+typedef struct {
+    uint32_t m, k, n;
+    uint32_t threads;            // Host threads
+    double npu_gflops;           // NPU alone
+    double host_gflops;          // Host threads alone
+    double coop_gflops;          // Both, sharing the rows of C
+    double speedup;              // Cooperative over the faster side alone
+    float npu_share;             // Split planned for the next call
+    uint64_t npu_rows;           // Rows of C per side over the timed runs
+    uint64_t cpu_rows;
+} coop_gemm_point_t;
+
+/**
+ * Time one shape and thread count on the NPU alone, on the host threads
+ * alone and cooperatively: config.iterations matmuls each after
+ * config.warmup_iterations
+ * @param ctx Benchmark context
+ * @param m Rows of A and C
+ * @param threads Host threads
+ * @param point Point to fill
+ * @return 0 on success, negative on error
+ */
+int run_coop_gemm_point(benchmark_context_t *ctx, uint32_t m, uint32_t threads,
+                        coop_gemm_point_t *point);
+
+/**
+ * Write every point as CSV
+ * @param filename Output CSV filename
+ * @param points Points measured
+ * @param count Number of points
+ * @return 0 on success, negative on error
+ */
+int write_coop_gemm_csv(const char *filename, const coop_gemm_point_t *points, size_t count);
+
+/**
+ * Matmul throughput of the NPU alone, of host threads alone and of both
+ * sharing the rows of C (npu_matrix_multiply_cooperative), across shapes
+ * and host thread counts. Reports the best cooperative GFLOPS as its
+ * throughput.
+ * @param ctx Benchmark context
+ * @return 0 on success, negative on error
+ */
+int benchmark_coop_gemm(benchmark_context_t *ctx);
+
 // =============================================================================
 // Data Management Functions
 // =============================================================================
@@ -446,6 +1223,83 @@ int generate_html_report(const char *filename, const benchmark_suite_t *suite);
  */
 int generate_json_report(const char *filename, const benchmark_suite_t *suite);
 
+// =============================================================================
+// Results Store
+// =============================================================================
+
+#define RESULTS_SCHEMA_VERSION 1
+#define RESULTS_MAX_REPETITIONS 100
+#define RESULTS_FILE_NAME "benchmark_results.json"
+
+/**
+ * Environment fingerprint, stored with every run so that a comparison can
+ * tell a code regression from a change of machine, kernel or build
+ */
+typedef struct {
+    char hostname[64];
+    char kernel[128];            // uname release
+    char machine[32];            // uname machine
+    char cpu_model[128];
+    uint32_t cpu_count;          // Online CPUs
+    char cpu_governor[32];       // cpu0 cpufreq governor ("" if unavailable)
+    char compiler[64];
+    char build_type[16];         // release, debug or profile
+    char git_commit[48];         // Source revision the suite was built from
+    char npu_board[64];          // From npu_get_device_info ("" if unavailable)
+    uint32_t npu_pe_count;
+    uint32_t npu_core_count;
+    uint32_t npu_max_frequency;
+} environment_fingerprint_t;
+
+/**
+ * Metrics of every repetition of one benchmark
+ */
+typedef struct {
+    char name[MAX_BENCHMARK_NAME_LENGTH];
+    benchmark_type_t type;
+    benchmark_size_t size;
+    uint32_t iterations;
+    uint32_t thread_count;
+    bool success;                // Every repetition passed
+    uint32_t repetitions;        // Entries used in samples
+    performance_metrics_t samples[RESULTS_MAX_REPETITIONS];
+} benchmark_run_record_t;
+
+/**
+ * Collect the environment fingerprint of this host
+ * @param handle NPU handle for device information (NULL: skip device)
+ * @param env Fingerprint to fill
+ */
+void collect_environment_fingerprint(npu_handle_t handle, environment_fingerprint_t *env);
+
+/**
+ * Write one run as JSON: fingerprint, then per benchmark the samples of
+ * every repetition for each metric the benchmark reported. This is the
+ * format scripts/check_regression.py compares.
+ * @param filename Output JSON filename
+ * @param env Environment fingerprint
+ * @param records Benchmark records
+ * @param count Number of records
+ * @return 0 on success, negative on error
+ */
+int write_results_json(const char *filename, const environment_fingerprint_t *env,
+                      const benchmark_run_record_t *records, size_t count);
+
+/**
+ * Add a run to a results store: a directory holding one JSON file per run,
+ * named by UTC start time and hostname
+ * @param store_dir Store directory (created if missing)
+ * @param env Environment fingerprint
+ * @param records Benchmark records
+ * @param count Number of records
+ * @param path Buffer for the stored file name (may be NULL)
+ * @param path_size Size of path
+ * @return 0 on success, negative on error
+ */
+int store_results_run(const char *store_dir, const environment_fingerprint_t *env,
+                     const benchmark_run_record_t *records, size_t count,
+                     char *path, size_t path_size);
+
 // =============================================================================
 // Utility Functions
 // =============================================================================
@@ -13,11 +13,17 @@ extern int benchmark_matmul_throughput(benchmark_context_t *ctx);
 extern int benchmark_conv2d_throughput(benchmark_context_t *ctx);
 extern int benchmark_elementwise_throughput(benchmark_context_t *ctx);
 extern int benchmark_memory_bandwidth(benchmark_context_t *ctx);
+extern int benchmark_roofline(benchmark_context_t *ctx);
+extern int benchmark_dma_sweep(benchmark_context_t *ctx);
+extern int benchmark_model_inference(benchmark_context_t *ctx);
+extern int benchmark_coop_gemm(benchmark_context_t *ctx);
 
 extern int benchmark_single_operation_latency(benchmark_context_t *ctx);
 extern int benchmark_batch_operation_latency(benchmark_context_t *ctx);
 extern int benchmark_memory_access_latency(benchmark_context_t *ctx);
 extern int benchmark_context_switch_latency(benchmark_context_t *ctx);
+extern int benchmark_open_loop_latency(benchmark_context_t *ctx);
+extern int benchmark_host_overhead(benchmark_context_t *ctx);
 
 extern int benchmark_multithreaded_throughput(benchmark_context_t *ctx);
 extern int benchmark_data_size_scaling(benchmark_context_t *ctx);
@@ -78,6 +84,38 @@ static const benchmark_definition_t g_benchmark_definitions[] = {
         BENCHMARK_SIZE_MEDIUM,
         50, 5, false
     },
+    {
+        "roofline",
+        "Roofline: operators against compute and bandwidth ceilings",
+        benchmark_roofline,
+        BENCHMARK_TYPE_THROUGHPUT,
+        BENCHMARK_SIZE_MEDIUM,
+        20, 3, false
+    },
+    {
+        "dma_sweep",
+        "DMA bandwidth across size, direction, alignment and queue depth",
+        benchmark_dma_sweep,
+        BENCHMARK_TYPE_MEMORY_BANDWIDTH,
+        BENCHMARK_SIZE_MEDIUM,
+        100, 5, false
+    },
+    {
+        "model_inference",
+        "Example CNN and MLP end to end with per-layer breakdown",
+        benchmark_model_inference,
+        BENCHMARK_TYPE_THROUGHPUT,
+        BENCHMARK_SIZE_SMALL,
+        20, 2, false
+    },
+    {
+        "coop_gemm",
+        "Matmul shared between the NPU and host threads",
+        benchmark_coop_gemm,
+        BENCHMARK_TYPE_THROUGHPUT,
+        BENCHMARK_SIZE_LARGE,
+        5, 2, false
+    },
     
     // Latency benchmarks
     {
@@ -112,6 +150,22 @@ static const benchmark_definition_t g_benchmark_definitions[] = {
         BENCHMARK_SIZE_SMALL,
         200, 20, false
     },
+    {
+        "open_loop_latency",
+        "Open-loop latency versus offered load",
+        benchmark_open_loop_latency,
+        BENCHMARK_TYPE_LATENCY,
+        BENCHMARK_SIZE_SMALL,
+        100, 10, false
+    },
+    {
+        "host_overhead",
+        "Host overhead microbenchmarks and latency budget",
+        benchmark_host_overhead,
+        BENCHMARK_TYPE_LATENCY,
+        BENCHMARK_SIZE_SMALL,
+        10000, 1000, false
+    },
     
     // Scalability benchmarks
     {
@@ -199,11 +253,16 @@ typedef struct {
     uint32_t iterations;
     uint32_t warmup_iterations;
     uint32_t thread_count;
+    arrival_process_t arrival_process;
+    double offered_rate;
+    double duration_sec;
+    uint32_t repetitions;
     bool enable_power_monitoring;
     bool enable_thermal_monitoring;
     bool verbose_output;
     char output_directory[256];
     char log_file[256];
+    char store_directory[256];
     bool generate_csv_report;
     bool generate_json_report;
     bool help_requested;
@@ -220,11 +279,16 @@ static benchmark_config_options_t g_config = {
     .iterations = 0, // Use benchmark defaults
     .warmup_iterations = 0, // Use benchmark defaults
     .thread_count = 4,
+    .arrival_process = ARRIVAL_POISSON,
+    .offered_rate = 0.0, // Sweep to saturation
+    .duration_sec = 0.0, // Use benchmark defaults
+    .repetitions = 1,
     .enable_power_monitoring = false,
     .enable_thermal_monitoring = false,
     .verbose_output = false,
     .output_directory = "./benchmark_results",
     .log_file = "",
+    .store_directory = "", // No results store
     .generate_csv_report = true,
     .generate_json_report = false,
     .help_requested = false
@@ -254,6 +318,11 @@ void print_usage(const char *program_name)
     printf("  --iterations N             Number of iterations (default: benchmark-specific)\n");
     printf("  --warmup N                 Warmup iterations (default: benchmark-specific)\n");
     printf("  --threads N                Thread count for scalability tests (default: 4)\n");
+    printf("  --arrival TYPE             Open-loop arrivals (constant, poisson, bursty; default: poisson)\n");
+    printf("  --rate N                   Open-loop offered load, requests/s (default: sweep to saturation)\n");
+    printf("  --duration SEC             Open-loop duration per load point (default: 5)\n");
+    printf("  --repetitions N            Run each benchmark N times (default: 1, max: %d)\n",
+           RESULTS_MAX_REPETITIONS);
     printf("\n");
     
     printf("Monitoring Options:\n");
@@ -266,8 +335,9 @@ void print_usage(const char *program_name)
     printf("  -o, --output DIR           Output directory (default: %s)\n", g_config.output_directory);
     printf("  --log FILE                 Log file path (default: stdout)\n");
     printf("  --csv                      Generate CSV report (default: enabled)\n");
-    printf("  --json                     Generate JSON report\n");
+    printf("  --json                     Generate JSON report (%s)\n", RESULTS_FILE_NAME);
     printf("  --no-csv                   Disable CSV report\n");
+    printf("  --store DIR                Also add the JSON report to results store DIR\n");
     printf("\n");
     
     printf("Other Options:\n");
@@ -297,9 +367,26 @@ void print_usage(const char *program_name)
     printf("  %s -t --size large                    # Run throughput benchmarks, large size\n", program_name);
     printf("  %s -b matmul_throughput --iterations 500  # Run specific benchmark\n", program_name);
     printf("  %s -p --enable-power --enable-thermal     # Run power benchmarks with monitoring\n", program_name);
+    printf("  %s -b open_loop_latency --arrival bursty  # Latency vs. offered load, bursty traffic\n", program_name);
+    printf("  %s -t --repetitions 10 --store runs       # Store a run for regression checks\n", program_name);
+    printf("  %s -b roofline -o results                 # Roofline chart in results/roofline.html\n", program_name);
+    printf("  %s -b dma_sweep -s xlarge                 # DMA GB/s from 64 B to 256 MB\n", program_name);
+    printf("  %s -b model_inference                     # Images/s and slowest layers of the examples\n", program_name);
+    printf("  %s -b coop_gemm                           # Matmul GFLOPS with host threads helping the NPU\n", program_name);
+    printf("  %s -b host_overhead                       # Where the microseconds of a small op go\n", program_name);
     printf("\n");
 }
 
+arrival_process_t parse_arrival_process(const char *arrival_str)
+{
+    if (strcmp(arrival_str, "constant") == 0) return ARRIVAL_CONSTANT;
+    if (strcmp(arrival_str, "poisson") == 0) return ARRIVAL_POISSON;
+    if (strcmp(arrival_str, "bursty") == 0) return ARRIVAL_BURSTY;
+    
+    fprintf(stderr, "Invalid arrival process: %s\n", arrival_str);
+    return ARRIVAL_POISSON; // Default
+}
+
 benchmark_size_t parse_benchmark_size(const char *size_str)
 {
     if (strcmp(size_str, "small") == 0) return BENCHMARK_SIZE_SMALL;
@@ -332,6 +419,11 @@ int parse_command_line(int argc, char *argv[])
         {"csv",             no_argument,       0, 1008},
         {"json",            no_argument,       0, 1009},
         {"no-csv",          no_argument,       0, 1010},
+        {"arrival",         required_argument, 0, 1011},
+        {"rate",            required_argument, 0, 1012},
+        {"duration",        required_argument, 0, 1013},
+        {"repetitions",     required_argument, 0, 1014},
+        {"store",           required_argument, 0, 1015},
         {"help",            no_argument,       0, 'h'},
         {0, 0, 0, 0}
     };
@@ -418,6 +510,30 @@ int parse_command_line(int argc, char *argv[])
                 g_config.generate_csv_report = false;
                 break;
                 
+            case 1011: // --arrival
+                g_config.arrival_process = parse_arrival_process(optarg);
+                break;
+                
+            case 1012: // --rate
+                g_config.offered_rate = atof(optarg);
+                break;
+                
+            case 1013: // --duration
+                g_config.duration_sec = atof(optarg);
+                break;
+                
+            case 1014: // --repetitions
+                g_config.repetitions = (uint32_t)atoi(optarg);
+                if (g_config.repetitions < 1 || g_config.repetitions > RESULTS_MAX_REPETITIONS) {
+                    fprintf(stderr, "Repetitions must be between 1 and %d\n", RESULTS_MAX_REPETITIONS);
+                    return -1;
+                }
+                break;
+                
+            case 1015: // --store
+                strncpy(g_config.store_directory, optarg, sizeof(g_config.store_directory) - 1);
+                break;
+                
             case 'h':
                 g_config.help_requested = true;
                 return 0;
@@ -466,12 +582,46 @@ bool should_run_benchmark(const benchmark_definition_t *benchmark)
     return false;
 }
 
+int write_run_results(npu_handle_t npu_handle, const benchmark_run_record_t *records, size_t count)
+{
+    environment_fingerprint_t env;
+    char path[512];
+    int result = 0;
+    
+    collect_environment_fingerprint(npu_handle, &env);
+    
+    if (g_config.generate_json_report) {
+        snprintf(path, sizeof(path), "%s/%s", g_config.output_directory, RESULTS_FILE_NAME);
+        if (write_results_json(path, &env, records, count) == 0) {
+            printf("JSON results written to %s\n", path);
+        } else {
+            result = -1;
+        }
+    }
+    
+    if (strlen(g_config.store_directory) > 0) {
+        if (store_results_run(g_config.store_directory, &env, records, count, path, sizeof(path)) == 0) {
+            printf("Run stored as %s\n", path);
+        } else {
+            result = -1;
+        }
+    }
+    
+    return result;
+}
+
 int run_benchmark_suite(npu_handle_t npu_handle)
 {
     size_t benchmarks_run = 0;
     size_t benchmarks_passed = 0;
     size_t benchmarks_failed = 0;
     
+    benchmark_run_record_t *records = calloc(g_num_benchmarks, sizeof(benchmark_run_record_t));
+    if (!records) {
+        fprintf(stderr, "Failed to allocate benchmark records\n");
+        return -1;
+    }
+    
     printf("Starting NPU Performance Benchmark Suite\n");
     printf("==========================================\n\n");
     
@@ -488,6 +638,7 @@ int run_benchmark_suite(npu_handle_t npu_handle)
             continue;
         }
         
+        benchmark_run_record_t *record = &records[benchmarks_run];
         benchmarks_run++;
         
         printf("Running benchmark: %s\n", benchmark->name);
@@ -503,24 +654,55 @@ int run_benchmark_suite(npu_handle_t npu_handle)
             .enable_power_monitoring = g_config.enable_power_monitoring,
             .enable_thermal_monitoring = g_config.enable_thermal_monitoring,
             .thread_count = g_config.thread_count,
-            .target_duration_sec = 0.0 // Let benchmark determine
+            .target_duration_sec = g_config.duration_sec, // 0: let benchmark determine
+            .arrival_process = g_config.arrival_process,
+            .offered_rate = g_config.offered_rate
         };
+        snprintf(config.output_path, sizeof(config.output_path), "%s/%s.csv",
+                 g_config.output_directory, benchmark->name);
         
-        // Create benchmark context
-        performance_metrics_t metrics = {0};
-        benchmark_context_t ctx = {
-            .config = config,
-            .npu_handle = npu_handle,
-            .result = &metrics
-        };
+        snprintf(record->name, sizeof(record->name), "%s", benchmark->name);
+        record->type = config.type;
+        record->size = config.size;
+        record->iterations = config.iterations;
+        record->thread_count = config.thread_count;
         
-        // Execute benchmark
+        // Execute benchmark, once per repetition
         struct timespec start_time, end_time;
         clock_gettime(CLOCK_MONOTONIC, &start_time);
         
-        int result = benchmark->function(&ctx);
+        int result = 0;
+        for (uint32_t rep = 0; rep < g_config.repetitions; rep++) {
+            if (g_config.repetitions > 1) {
+                printf("Repetition %u/%u\n", rep + 1, g_config.repetitions);
+            }
+            
+            // Create benchmark context
+            performance_metrics_t *metrics = &record->samples[rep];
+            benchmark_context_t ctx = {
+                .config = config,
+                .npu_handle = npu_handle,
+                .result = metrics,
+                .mutex = PTHREAD_MUTEX_INITIALIZER
+            };
+            
+            // Host CPU counters of this thread; worker threads merge their own
+            host_counters_open(&ctx.host_counters);
+            host_counters_start(&ctx.host_counters);
+            
+            if (benchmark->function(&ctx) != 0) {
+                result = -1;
+            }
+            
+            host_counters_stop(&ctx.host_counters);
+            merge_host_counters(&ctx, &ctx.host_counters.totals);
+            host_counters_close(&ctx.host_counters);
+            host_counters_to_metrics(&ctx.host_totals, metrics);
+            record->repetitions++;
+        }
         
         clock_gettime(CLOCK_MONOTONIC, &end_time);
+        record->success = (result == 0);
         
         // Report results
         if (result == 0) {
@@ -531,6 +713,7 @@ int run_benchmark_suite(npu_handle_t npu_handle)
             printf("BENCHMARK FAILED\n");
         }
         
+        print_host_counters(&record->samples[record->repetitions - 1]);
         printf("Execution time: %.3f seconds\n", calculate_duration_seconds(start_time, end_time));
         printf("\n");
     }
@@ -543,6 +726,12 @@ int run_benchmark_suite(npu_handle_t npu_handle)
     printf("Benchmarks failed: %zu\n", benchmarks_failed);
     printf("Success rate: %.1f%%\n", benchmarks_run > 0 ? (double)benchmarks_passed / benchmarks_run * 100.0 : 0.0);
     
+    if (write_run_results(npu_handle, records, benchmarks_run) != 0) {
+        benchmarks_failed++;
+    }
+    
+    free(records);
+    
     return (benchmarks_failed == 0) ? 0 : -1;
 }
 
@@ -593,6 +782,7 @@ int main(int argc, char *argv[])
            g_config.benchmark_size == BENCHMARK_SIZE_MEDIUM ? "Medium" :
            g_config.benchmark_size == BENCHMARK_SIZE_LARGE ? "Large" : "XLarge");
     printf("  Thread count:       %u\n", g_config.thread_count);
+    printf("  Repetitions:        %u\n", g_config.repetitions);
     printf("  Power monitoring:   %s\n", g_config.enable_power_monitoring ? "Enabled" : "Disabled");
     printf("  Thermal monitoring: %s\n", g_config.enable_thermal_monitoring ? "Enabled" : "Disabled");
     printf("  Verbose output:     %s\n", g_config.verbose_output ? "Enabled" : "Disabled");
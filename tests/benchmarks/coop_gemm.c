@@ -0,0 +1,282 @@
+/**
+ * Cooperative GEMM Benchmark Implementation
+ * 
+ * FLOAT32 matmul on the NPU alone, on host threads alone,
+ * and with both sharing the rows of C
+ */
+
+#include "benchmark_framework.h"
+#include <errno.h>
+
+// =============================================================================
+// Configuration
+// =============================================================================
+
+#define COOP_GEMM_K 256
+#define COOP_GEMM_N 256              // B fills a quarter of the shared buffer
+
+static const uint32_t g_coop_rows[] = { 512, 2048, 8192 };
+
+#define NUM_COOP_SHAPES (sizeof(g_coop_rows) / sizeof(g_coop_rows[0]))
+
+// =============================================================================
+// Timed Runs
+// =============================================================================
+
+typedef struct {
+    npu_handle_t handle;
+    npu_tensor_t a;              // Band of rows of A
+    npu_tensor_t b;
+    npu_tensor_t c;              // Same band of rows of C
+    int status;
+} coop_host_band_t;
+
+static void* coop_host_band_thread(void *arg)
+{
+    coop_host_band_t *band = (coop_host_band_t *)arg;
+    
+    band->status = npu_matrix_multiply(band->handle, &band->a, &band->b, &band->c);
+    return NULL;
+}
+
+/**
+ * One matmul split into a band of rows per host thread
+ */
+static int host_matmul(npu_handle_t handle, const npu_tensor_t *a, const npu_tensor_t *b,
+                       npu_tensor_t *c, uint32_t threads, coop_host_band_t *bands, pthread_t *ids)
+{
+    uint32_t m = a->dims[2], k = a->dims[3], n = b->dims[3];
+    uint32_t started;
+    int ret = 0;
+    
+    for (started = 0; started < threads; started++) {
+        uint32_t first = (uint32_t)((uint64_t)m * started / threads);
+        uint32_t last = (uint32_t)((uint64_t)m * (started + 1) / threads);
+    
+        bands[started].handle = handle;
+        bands[started].a = npu_create_tensor((float *)a->data + (size_t)first * k, 1, 1, last - first, k,
+                                             NPU_DTYPE_FLOAT32);
+        bands[started].b = *b;
+        bands[started].c = npu_create_tensor((float *)c->data + (size_t)first * n, 1, 1, last - first, n,
+                                             NPU_DTYPE_FLOAT32);
+        bands[started].status = NPU_SUCCESS;
+        if (pthread_create(&ids[started], NULL, coop_host_band_thread, &bands[started]) != 0) {
+            ret = -1;
+            break;
+        }
+    }
+    
+    for (uint32_t t = 0; t < started; t++) {
+        pthread_join(ids[t], NULL);
+        if (bands[t].status != NPU_SUCCESS) {
+            ret = -1;
+        }
+    }
+    
+    return ret;
+}
+
+typedef enum {
+    COOP_MODE_NPU = 0,
+    COOP_MODE_HOST,
+    COOP_MODE_COOP
+} coop_mode_t;
+
+/**
+ * Mean seconds per matmul in one mode
+ * @return Seconds, or a negative value on error
+ */
+static double time_mode(benchmark_context_t *ctx, coop_mode_t mode, uint32_t threads,
+                        const npu_tensor_t *a, const npu_tensor_t *b, npu_tensor_t *c,
+                        coop_host_band_t *bands, pthread_t *ids)
+{
+    npu_handle_t handle = ctx->npu_handle;
+    uint32_t runs = ctx->config.warmup_iterations + ctx->config.iterations;
+    uint64_t start = 0;
+    
+    if (npu_set_placement(handle, mode == COOP_MODE_HOST ? NPU_PLACEMENT_CPU : NPU_PLACEMENT_NPU) != NPU_SUCCESS ||
+        npu_set_host_threads(handle, mode == COOP_MODE_COOP ? threads : 0) != NPU_SUCCESS) {
+        return -1.0;
+    }
+    
+    for (uint32_t i = 0; i < runs; i++) {
+        int ret;
+    
+        if (i == ctx->config.warmup_iterations) {
+            start = get_timestamp_ns();
+        }
+    
+        if (mode == COOP_MODE_HOST) {
+            ret = host_matmul(handle, a, b, c, threads, bands, ids);
+        } else {
+            ret = npu_matrix_multiply_cooperative(handle, a, b, c, NPU_ACT_NONE);
+        }
+        if (ret != 0) {
+            return -1.0;
+        }
+    }
+    
+    return (double)(get_timestamp_ns() - start) / 1e9 / ctx->config.iterations;
+}
+
+int run_coop_gemm_point(benchmark_context_t *ctx, uint32_t m, uint32_t threads,
+                        coop_gemm_point_t *point)
+{
+    uint32_t k = COOP_GEMM_K, n = COOP_GEMM_N;
+    float *a_data = malloc((size_t)m * k * sizeof(float));
+    float *b_data = malloc((size_t)k * n * sizeof(float));
+    float *c_data = malloc((size_t)m * n * sizeof(float));
+    coop_host_band_t *bands = calloc(threads, sizeof(coop_host_band_t));
+    pthread_t *ids = calloc(threads, sizeof(pthread_t));
+    double flops = 2.0 * m * k * n;
+    double npu_s = -1.0, host_s = -1.0, coop_s = -1.0;
+    npu_coop_stats_t stats;
+    int ret = -1;
+    
+    memset(point, 0, sizeof(*point));
+    point->m = m;
+    point->k = k;
+    point->n = n;
+    point->threads = threads;
+    
+    if (a_data && b_data && c_data && bands && ids) {
+        for (size_t i = 0; i < (size_t)m * k; i++) {
+            a_data[i] = (float)rand() / RAND_MAX - 0.5f;
+        }
+        for (size_t i = 0; i < (size_t)k * n; i++) {
+            b_data[i] = (float)rand() / RAND_MAX - 0.5f;
+        }
+    
+        npu_tensor_t a = npu_create_tensor(a_data, 1, 1, m, k, NPU_DTYPE_FLOAT32);
+        npu_tensor_t b = npu_create_tensor(b_data, 1, 1, k, n, NPU_DTYPE_FLOAT32);
+        npu_tensor_t c = npu_create_tensor(c_data, 1, 1, m, n, NPU_DTYPE_FLOAT32);
+    
+        npu_s = time_mode(ctx, COOP_MODE_NPU, threads, &a, &b, &c, bands, ids);
+        host_s = time_mode(ctx, COOP_MODE_HOST, threads, &a, &b, &c, bands, ids);
+        coop_s = time_mode(ctx, COOP_MODE_COOP, threads, &a, &b, &c, bands, ids);
+    
+        // Statistics cover the warmup runs as well; scale rows to the timed ones
+        if (coop_s > 0.0 && npu_get_coop_stats(ctx->npu_handle, &stats) == NPU_SUCCESS && stats.calls > 0) {
+            point->npu_share = stats.npu_share;
+            point->npu_rows = stats.npu_rows * ctx->config.iterations / stats.calls;
+            point->cpu_rows = stats.cpu_rows * ctx->config.iterations / stats.calls;
+        }
+    }
+    
+    npu_set_host_threads(ctx->npu_handle, 0);
+    npu_set_placement(ctx->npu_handle, NPU_PLACEMENT_NPU);
+    
+    if (npu_s > 0.0 && host_s > 0.0 && coop_s > 0.0) {
+        point->npu_gflops = flops / npu_s / 1e9;
+        point->host_gflops = flops / host_s / 1e9;
+        point->coop_gflops = flops / coop_s / 1e9;
+        point->speedup = point->coop_gflops / fmax(point->npu_gflops, point->host_gflops);
+        ret = 0;
+    }
+    
+    free(a_data);
+    free(b_data);
+    free(c_data);
+    free(bands);
+    free(ids);
+    return ret;
+}
+
+// =============================================================================
+// Reporting
+// =============================================================================
+
+int write_coop_gemm_csv(const char *filename, const coop_gemm_point_t *points, size_t count)
+{
+    FILE *file = fopen(filename, "w");
+    if (!file) {
+        fprintf(stderr, "Failed to open %s: %s\n", filename, strerror(errno));
+        return -1;
+    }
+    
+    fprintf(file, "m,k,n,threads,npu_gflops,host_gflops,coop_gflops,speedup,npu_share,npu_rows,cpu_rows\n");
+    for (size_t i = 0; i < count; i++) {
+        const coop_gemm_point_t *p = &points[i];
+        fprintf(file, "%u,%u,%u,%u,%.3f,%.3f,%.3f,%.3f,%.3f,%llu,%llu\n",
+                p->m, p->k, p->n, p->threads, p->npu_gflops, p->host_gflops, p->coop_gflops,
+                p->speedup, p->npu_share, (unsigned long long)p->npu_rows,
+                (unsigned long long)p->cpu_rows);
+    }
+    
+    if (fclose(file) != 0) {
+        fprintf(stderr, "Failed to write %s: %s\n", filename, strerror(errno));
+        return -1;
+    }
+    
+    return 0;
+}
+
+static void print_coop_gemm_report(const coop_gemm_point_t *points, size_t count)
+{
+    printf("\n  %-16s %7s %10s %10s %10s %8s %9s\n",
+           "Shape", "Threads", "NPU GF/s", "Host GF/s", "Coop GF/s", "Speedup", "NPU rows");
+    for (size_t i = 0; i < count; i++) {
+        const coop_gemm_point_t *p = &points[i];
+        char shape[32];
+        uint64_t rows = p->npu_rows + p->cpu_rows;
+    
+        snprintf(shape, sizeof(shape), "%ux%ux%u", p->m, p->k, p->n);
+        printf("  %-16s %7u %10.2f %10.2f %10.2f %7.2fx %8.1f%%\n",
+               shape, p->threads, p->npu_gflops, p->host_gflops, p->coop_gflops, p->speedup,
+               rows > 0 ? 100.0 * p->npu_rows / rows : 0.0);
+    }
+}
+
+// =============================================================================
+// Benchmark
+// =============================================================================
+
+int benchmark_coop_gemm(benchmark_context_t *ctx)
+{
+    performance_metrics_t *metrics = &ctx->result->metrics;
+    coop_gemm_point_t points[COOP_GEMM_MAX_POINTS];
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t max_threads, thread_counts[COOP_GEMM_MAX_POINTS];
+    size_t thread_count_n = 0, count = 0;
+    uint64_t matmuls = 0;
+    double best = 0.0;
+    int ret = 0;
+    
+    // The calling thread drives the NPU; the other cores can compute
+    max_threads = cores > 1 ? (uint32_t)(cores - 1) : 1;
+    if (max_threads > NPU_COOP_MAX_THREADS) {
+        max_threads = NPU_COOP_MAX_THREADS;
+    }
+    for (uint32_t t = 1; t < max_threads; t *= 2) {
+        thread_counts[thread_count_n++] = t;
+    }
+    thread_counts[thread_count_n++] = max_threads;
+    
+    printf("Running cooperative GEMM benchmark (%u matmuls per mode, up to %u host threads)\n",
+           ctx->config.iterations, max_threads);
+    
+    for (size_t s = 0; s < NUM_COOP_SHAPES && ret == 0; s++) {
+        for (size_t t = 0; t < thread_count_n && count < COOP_GEMM_MAX_POINTS; t++) {
+            if (run_coop_gemm_point(ctx, g_coop_rows[s], thread_counts[t], &points[count]) != 0) {
+                ret = -1;
+                break;
+            }
+            if (points[count].coop_gflops > best) {
+                best = points[count].coop_gflops;
+            }
+            matmuls += 3ull * ctx->config.iterations;
+            count++;
+        }
+    }
+    
+    print_coop_gemm_report(points, count);
+    
+    if (strlen(ctx->config.output_path) > 0 &&
+        write_coop_gemm_csv(ctx->config.output_path, points, count) == 0) {
+        printf("\nThroughput per shape and thread count written to %s\n", ctx->config.output_path);
+    }
+    
+    metrics->throughput_gops = best;
+    metrics->operations_count = matmuls;
+    return ret;
+}
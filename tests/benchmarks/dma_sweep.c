@@ -0,0 +1,645 @@
+/**
+ * DMA Bandwidth Sweep Implementation
+ * 
+ * Transfer bandwidth across size, direction, host memory type,
+ * alignment and queue depth, with a fixed-cost fit per curve
+ */
+
+#include "benchmark_framework.h"
+#include <errno.h>
+
+// =============================================================================
+// Sweep Configuration
+// =============================================================================
+
+#define DMA_SWEEP_MIN_SIZE 64
+#define DMA_SWEEP_MAX_SIZE (256u << 20)
+#define DMA_SWEEP_CHUNK (8u << 20)           // Largest single ioctl; fits a managed buffer
+#define DMA_SWEEP_BYTES_PER_POINT (512u << 20) // Caps the transfers timed at large sizes
+#define DMA_SWEEP_MIN_TRANSFERS 3
+#define DMA_SWEEP_TIMEOUT_MS 5000
+#define DMA_SWEEP_KNEE_FRACTION 0.9
+#define DMA_SWEEP_DEFAULT_DEVICE_MEMORY (64u << 20)
+#define DMA_SWEEP_PAGE 4096
+
+// Sizes and settings of the alignment and queue-depth sweeps
+static const size_t g_detail_sizes[] = { 4096, 1u << 20 };
+static const uint32_t g_alignments[] = { 0, 1, 4, 64 };
+static const uint32_t g_queue_depths[] = { 1, 2, 4, DMA_SWEEP_MAX_DEPTH };
+static const dma_direction_t g_depth_directions[] = { DMA_DIR_H2D, DMA_DIR_BIDIR };
+
+#define NUM_DETAIL_SIZES (sizeof(g_detail_sizes) / sizeof(g_detail_sizes[0]))
+#define NUM_ALIGNMENTS (sizeof(g_alignments) / sizeof(g_alignments[0]))
+#define NUM_QUEUE_DEPTHS (sizeof(g_queue_depths) / sizeof(g_queue_depths[0]))
+#define NUM_DEPTH_DIRECTIONS (sizeof(g_depth_directions) / sizeof(g_depth_directions[0]))
+
+const char* dma_direction_to_string(dma_direction_t direction)
+{
+    switch (direction) {
+        case DMA_DIR_H2D: return "h2d";
+        case DMA_DIR_D2H: return "d2h";
+        case DMA_DIR_BIDIR: return "bidir";
+        default: return "unknown";
+    }
+}
+
+// Largest transfer of the size sweep for a size class
+static size_t dma_sweep_max_size(const benchmark_config_t *config)
+{
+    switch (config->size) {
+        case SIZE_SMALL: return 1u << 20;
+        case SIZE_MEDIUM: return 16u << 20;
+        case SIZE_LARGE: return 64u << 20;
+        case SIZE_CUSTOM:
+            if (config->custom_size_x >= DMA_SWEEP_MIN_SIZE) {
+                return config->custom_size_x < DMA_SWEEP_MAX_SIZE ?
+                       config->custom_size_x : DMA_SWEEP_MAX_SIZE;
+            }
+            return 16u << 20;
+        default: return DMA_SWEEP_MAX_SIZE;
+    }
+}
+
+static size_t round_up_page(size_t size)
+{
+    return (size + DMA_SWEEP_PAGE - 1) & ~(size_t)(DMA_SWEEP_PAGE - 1);
+}
+
+// =============================================================================
+// Transfer Workers
+// =============================================================================
+
+// Holds warmed-up threads until all are ready, so they start timing together
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    uint32_t ready;
+    bool go;
+    bool abort;                  // Not every thread started; skip the timed loop
+    uint64_t start_ns;
+} dma_sweep_gate_t;
+
+typedef struct {
+    npu_handle_t handle;
+    const dma_sweep_params_t *params;
+    uint32_t index;
+    uint32_t warmup;
+    uint32_t iterations;
+    size_t chunk;                // Bytes per ioctl
+    uint64_t device_base;        // Device memory region of this thread
+    uint64_t device_span;        // Room left in the region after one chunk
+    npu_buffer_handle_t buffer;
+    uint8_t *host;               // Pageable source or destination (unpinned only)
+    dma_sweep_gate_t *gate;
+    latency_histogram_t hist;
+    uint64_t end_ns;
+    int status;
+} dma_sweep_worker_t;
+
+static int transfer_chunk(dma_sweep_worker_t *worker, dma_direction_t direction,
+                          size_t done, size_t bytes)
+{
+    const dma_sweep_params_t *params = worker->params;
+    uint64_t device_addr = worker->device_base + ((done % (worker->device_span + 1)) & ~(uint64_t)63);
+    int ret;
+    
+    if (direction == DMA_DIR_H2D) {
+        if (!params->pinned) {
+            ret = npu_buffer_write(worker->handle, worker->buffer, params->alignment,
+                                   worker->host + params->alignment + done, bytes);
+            if (ret != NPU_SUCCESS) {
+                return ret;
+            }
+        }
+        return npu_dma_transfer(worker->handle, worker->buffer, params->alignment, device_addr,
+                                bytes, NPU_DMA_TO_DEVICE, DMA_SWEEP_TIMEOUT_MS);
+    }
+    
+    ret = npu_dma_transfer(worker->handle, worker->buffer, params->alignment, device_addr,
+                           bytes, NPU_DMA_FROM_DEVICE, DMA_SWEEP_TIMEOUT_MS);
+    if (ret == NPU_SUCCESS && !params->pinned) {
+        ret = npu_buffer_read(worker->handle, worker->buffer, params->alignment,
+                              worker->host + params->alignment + done, bytes);
+    }
+    return ret;
+}
+
+// One transfer of params->size bytes, split into chunks a buffer can hold
+static int transfer_once(dma_sweep_worker_t *worker, uint32_t iteration)
+{
+    const dma_sweep_params_t *params = worker->params;
+    dma_direction_t direction = params->direction;
+    
+    if (direction == DMA_DIR_BIDIR) {
+        // Neighbouring threads start in opposite directions
+        direction = ((iteration + worker->index) & 1) ? DMA_DIR_D2H : DMA_DIR_H2D;
+    }
+    
+    for (size_t done = 0; done < params->size; done += worker->chunk) {
+        size_t bytes = params->size - done < worker->chunk ? params->size - done : worker->chunk;
+        int ret = transfer_chunk(worker, direction, done, bytes);
+        if (ret != NPU_SUCCESS) {
+            return ret;
+        }
+    }
+    
+    return NPU_SUCCESS;
+}
+
+static void* dma_sweep_worker_thread(void *arg)
+{
+    dma_sweep_worker_t *worker = (dma_sweep_worker_t *)arg;
+    uint32_t i;
+    
+    for (i = 0; i < worker->warmup && worker->status == 0; i++) {
+        worker->status = transfer_once(worker, i);
+    }
+    
+    // Every thread reaches the gate, even after a failure, so none waits forever
+    pthread_mutex_lock(&worker->gate->mutex);
+    worker->gate->ready++;
+    pthread_cond_broadcast(&worker->gate->cond);
+    while (!worker->gate->go) {
+        pthread_cond_wait(&worker->gate->cond, &worker->gate->mutex);
+    }
+    bool aborted = worker->gate->abort;
+    pthread_mutex_unlock(&worker->gate->mutex);
+    
+    for (i = 0; i < worker->iterations && worker->status == 0 && !aborted; i++) {
+        uint64_t start = get_timestamp_ns();
+        worker->status = transfer_once(worker, i);
+        if (worker->status == 0) {
+            latency_histogram_record(&worker->hist, get_timestamp_ns() - start);
+        }
+    }
+    
+    worker->end_ns = get_timestamp_ns();
+    return NULL;
+}
+
+static int setup_worker(dma_sweep_worker_t *worker, npu_handle_t handle,
+                        const dma_sweep_params_t *params, size_t chunk)
+{
+    size_t buffer_size = round_up_page(chunk + params->alignment);
+    
+    worker->buffer = npu_buffer_alloc(handle, buffer_size, NPU_ALLOC_COHERENT);
+    if (!worker->buffer) {
+        return -1;
+    }
+    
+    if (!params->pinned) {
+        // The whole transfer, so large sizes stream through the host caches
+        worker->host = aligned_alloc(DMA_SWEEP_PAGE, round_up_page(params->size + params->alignment));
+        if (!worker->host) {
+            return -1;
+        }
+        // Fault the pages in outside the timed loop
+        memset(worker->host, 0x5a, params->size + params->alignment);
+    }
+    
+    latency_histogram_reset(&worker->hist);
+    return 0;
+}
+
+static uint64_t device_memory_size(npu_handle_t handle)
+{
+    struct npu_device_info info = {0};
+    
+    if (npu_get_device_info(handle, &info) == NPU_SUCCESS && info.memory_size > 0) {
+        return info.memory_size;
+    }
+    return DMA_SWEEP_DEFAULT_DEVICE_MEMORY;
+}
+
+int run_dma_sweep_point(benchmark_context_t *ctx, const dma_sweep_params_t *params,
+                       dma_sweep_point_t *point)
+{
+    uint32_t depth = params->queue_depth ? params->queue_depth : 1;
+    uint32_t iterations = ctx->config.iterations ? ctx->config.iterations : 100;
+    uint32_t warmup = ctx->config.warmup_iterations;
+    pthread_t threads[DMA_SWEEP_MAX_DEPTH];
+    dma_sweep_gate_t gate = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, false, false, 0 };
+    latency_histogram_t *hist = malloc(sizeof(latency_histogram_t));
+    dma_sweep_worker_t *workers = calloc(depth, sizeof(dma_sweep_worker_t));
+    uint32_t started = 0;
+    int ret = 0;
+    
+    memset(point, 0, sizeof(*point));
+    point->params = *params;
+    
+    if (depth > DMA_SWEEP_MAX_DEPTH || params->size == 0 || !hist || !workers) {
+        free(hist);
+        free(workers);
+        return -1;
+    }
+    
+    // Large transfers are timed fewer times to bound the bytes each point moves
+    uint64_t budget = DMA_SWEEP_BYTES_PER_POINT / params->size;
+    if (budget < DMA_SWEEP_MIN_TRANSFERS) {
+        budget = DMA_SWEEP_MIN_TRANSFERS;
+    }
+    if (iterations > budget) {
+        iterations = (uint32_t)budget;
+    }
+    if (warmup > iterations) {
+        warmup = iterations;
+    }
+    
+    // Each thread gets its own slice of device memory
+    uint64_t slice = (device_memory_size(ctx->npu_handle) / depth) & ~(uint64_t)(DMA_SWEEP_PAGE - 1);
+    size_t chunk = params->size < DMA_SWEEP_CHUNK ? params->size : DMA_SWEEP_CHUNK;
+    if (chunk > slice) {
+        chunk = (size_t)slice;
+    }
+    if (chunk == 0) {
+        free(hist);
+        free(workers);
+        return -1;
+    }
+    
+    for (uint32_t t = 0; t < depth && ret == 0; t++) {
+        dma_sweep_worker_t *worker = &workers[t];
+        worker->handle = ctx->npu_handle;
+        worker->params = params;
+        worker->index = t;
+        worker->warmup = warmup;
+        worker->iterations = iterations;
+        worker->chunk = chunk;
+        worker->device_base = t * slice;
+        worker->device_span = slice - chunk;
+        worker->gate = &gate;
+        ret = setup_worker(worker, ctx->npu_handle, params, chunk);
+    }
+    
+    for (started = 0; ret == 0 && started < depth; started++) {
+        if (pthread_create(&threads[started], NULL, dma_sweep_worker_thread, &workers[started]) != 0) {
+            ret = -1;
+            break;
+        }
+    }
+    
+    if (started > 0) {
+        pthread_mutex_lock(&gate.mutex);
+        while (gate.ready < started) {
+            pthread_cond_wait(&gate.cond, &gate.mutex);
+        }
+        gate.go = true;
+        gate.abort = ret != 0;
+        gate.start_ns = get_timestamp_ns();
+        pthread_cond_broadcast(&gate.cond);
+        pthread_mutex_unlock(&gate.mutex);
+    
+        uint64_t end = gate.start_ns;
+        latency_histogram_reset(hist);
+        for (uint32_t t = 0; t < started; t++) {
+            pthread_join(threads[t], NULL);
+            if (workers[t].status != 0) {
+                ret = -1;
+            }
+            if (workers[t].end_ns > end) {
+                end = workers[t].end_ns;
+            }
+            latency_histogram_merge(hist, &workers[t].hist);
+        }
+    
+        if (ret == 0 && hist->total_count > 0 && end > gate.start_ns) {
+            point->transfers = hist->total_count;
+            point->gbps = (double)(point->transfers * params->size) / (double)(end - gate.start_ns);
+            point->mean_us = hist->sum_ns / hist->total_count / 1e3;
+            point->p50_us = latency_histogram_percentile(hist, 50.0) / 1e3;
+            point->p99_us = latency_histogram_percentile(hist, 99.0) / 1e3;
+        }
+    }
+    
+    for (uint32_t t = 0; t < depth; t++) {
+        free(workers[t].host);
+        if (workers[t].buffer) {
+            npu_buffer_free(ctx->npu_handle, workers[t].buffer);
+        }
+    }
+    free(hist);
+    free(workers);
+    
+    return (ret == 0 && point->transfers > 0) ? 0 : -1;
+}
+
+// =============================================================================
+// Curve Fit
+// =============================================================================
+
+void fit_dma_sweep_curve(const dma_sweep_point_t *points, size_t count, dma_sweep_fit_t *fit)
+{
+    double s = 0.0, sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    
+    memset(fit, 0, sizeof(*fit));
+    if (count == 0) {
+        return;
+    }
+    fit->direction = points[0].params.direction;
+    fit->pinned = points[0].params.pinned;
+    
+    // Weight by 1/t^2 so small transfers, which set the overhead, count as
+    // much as large ones
+    for (size_t i = 0; i < count; i++) {
+        double x = (double)points[i].params.size;
+        double y = points[i].mean_us;
+        if (y <= 0.0) {
+            continue;
+        }
+        double w = 1.0 / (y * y);
+        s += w;
+        sx += w * x;
+        sy += w * y;
+        sxx += w * x * x;
+        sxy += w * x * y;
+    
+        if (points[i].gbps > fit->best_gbps) {
+            fit->best_gbps = points[i].gbps;
+        }
+    }
+    
+    double denominator = s * sxx - sx * sx;
+    if (denominator > 0.0) {
+        double us_per_byte = (s * sxy - sx * sy) / denominator;
+        double intercept = (sy - us_per_byte * sx) / s;
+        fit->overhead_us = intercept > 0.0 ? intercept : 0.0;
+        if (us_per_byte > 0.0) {
+            fit->peak_gbps = 1e-3 / us_per_byte;
+            fit->half_size = fit->overhead_us / us_per_byte;
+        }
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        if (points[i].gbps >= DMA_SWEEP_KNEE_FRACTION * fit->best_gbps) {
+            fit->knee_size = points[i].params.size;
+            break;
+        }
+    }
+}
+
+// =============================================================================
+// Reporting
+// =============================================================================
+
+static void format_size(double bytes, char *buffer, size_t size)
+{
+    if (bytes >= (1u << 20)) {
+        snprintf(buffer, size, "%.4g MB", bytes / (1u << 20));
+    } else if (bytes >= 1024) {
+        snprintf(buffer, size, "%.4g KB", bytes / 1024);
+    } else {
+        snprintf(buffer, size, "%.4g B", bytes);
+    }
+}
+
+static const char* memory_to_string(bool pinned)
+{
+    return pinned ? "pinned" : "pageable";
+}
+
+static const dma_sweep_point_t* find_point(const dma_sweep_point_t *points, size_t count,
+                                           const dma_sweep_params_t *params)
+{
+    for (size_t i = 0; i < count; i++) {
+        const dma_sweep_params_t *p = &points[i].params;
+        if (p->direction == params->direction && p->pinned == params->pinned &&
+            p->alignment == params->alignment && p->queue_depth == params->queue_depth &&
+            p->size == params->size) {
+            return &points[i];
+        }
+    }
+    return NULL;
+}
+
+static void print_gbps_cell(const dma_sweep_point_t *point)
+{
+    if (point) {
+        printf(" %10.3f", point->gbps);
+    } else {
+        printf(" %10s", "-");
+    }
+}
+
+static void print_dma_sweep_report(const dma_sweep_point_t *points, size_t count,
+                                   const dma_sweep_fit_t *fits, size_t fit_count,
+                                   size_t max_size)
+{
+    char size_text[32];
+    char half_text[32];
+    char knee_text[32];
+    
+    printf("\nSize sweep (GB/s, queue depth 1, page-aligned):\n");
+    printf("  %-10s", "Size");
+    for (size_t f = 0; f < fit_count; f++) {
+        snprintf(size_text, sizeof(size_text), "%s %s", dma_direction_to_string(fits[f].direction),
+                 fits[f].pinned ? "pin" : "page");
+        printf(" %10s", size_text);
+    }
+    printf("\n");
+    
+    for (size_t size = DMA_SWEEP_MIN_SIZE; size <= max_size; size *= 2) {
+        format_size((double)size, size_text, sizeof(size_text));
+        printf("  %-10s", size_text);
+        for (size_t f = 0; f < fit_count; f++) {
+            dma_sweep_params_t params = { fits[f].direction, fits[f].pinned, 0, 1, size };
+            print_gbps_cell(find_point(points, count, &params));
+        }
+        printf("\n");
+    }
+    
+    printf("\nPer-transfer overhead and knee (fit of t = overhead + size / peak):\n");
+    printf("  %-16s %12s %10s %10s %12s\n", "Curve", "Overhead us", "Peak GB/s", "n1/2", "Knee (90%)");
+    for (size_t f = 0; f < fit_count; f++) {
+        format_size(fits[f].half_size, half_text, sizeof(half_text));
+        format_size((double)fits[f].knee_size, knee_text, sizeof(knee_text));
+        snprintf(size_text, sizeof(size_text), "%s %s", dma_direction_to_string(fits[f].direction),
+                 memory_to_string(fits[f].pinned));
+        printf("  %-16s %12.2f %10.3f %10s %12s\n", size_text, fits[f].overhead_us,
+               fits[f].peak_gbps, half_text, knee_text);
+    }
+    
+    printf("\nHost alignment (GB/s, h2d, queue depth 1):\n");
+    printf("  %-20s", "Size");
+    for (size_t a = 0; a < NUM_ALIGNMENTS; a++) {
+        snprintf(size_text, sizeof(size_text), "+%u", g_alignments[a]);
+        printf(" %10s", size_text);
+    }
+    printf("\n");
+    for (size_t s = 0; s < NUM_DETAIL_SIZES; s++) {
+        for (int pinned = 1; pinned >= 0; pinned--) {
+            format_size((double)g_detail_sizes[s], size_text, sizeof(size_text));
+            printf("  %-10s %-9s", size_text, memory_to_string(pinned));
+            for (size_t a = 0; a < NUM_ALIGNMENTS; a++) {
+                dma_sweep_params_t params = { DMA_DIR_H2D, pinned, g_alignments[a], 1, g_detail_sizes[s] };
+                print_gbps_cell(find_point(points, count, &params));
+            }
+            printf("\n");
+        }
+    }
+    
+    printf("\nQueue depth (GB/s, pinned):\n");
+    printf("  %-20s", "Size");
+    for (size_t q = 0; q < NUM_QUEUE_DEPTHS; q++) {
+        snprintf(size_text, sizeof(size_text), "QD%u", g_queue_depths[q]);
+        printf(" %10s", size_text);
+    }
+    printf("\n");
+    for (size_t s = 0; s < NUM_DETAIL_SIZES; s++) {
+        for (size_t d = 0; d < NUM_DEPTH_DIRECTIONS; d++) {
+            format_size((double)g_detail_sizes[s], size_text, sizeof(size_text));
+            printf("  %-10s %-9s", size_text, dma_direction_to_string(g_depth_directions[d]));
+            for (size_t q = 0; q < NUM_QUEUE_DEPTHS; q++) {
+                dma_sweep_params_t params = { g_depth_directions[d], true, 0, g_queue_depths[q],
+                                              g_detail_sizes[s] };
+                print_gbps_cell(find_point(points, count, &params));
+            }
+            printf("\n");
+        }
+    }
+}
+
+int write_dma_sweep_csv(const char *filename, const dma_sweep_point_t *points, size_t point_count,
+                       const dma_sweep_fit_t *fits, size_t fit_count)
+{
+    FILE *file = fopen(filename, "w");
+    if (!file) {
+        fprintf(stderr, "Failed to open %s: %s\n", filename, strerror(errno));
+        return -1;
+    }
+    
+    fprintf(file, "kind,direction,memory,alignment,queue_depth,size_bytes,transfers,gbps,"
+                  "mean_us,p50_us,p99_us,overhead_us,peak_gbps,half_size_bytes,knee_bytes\n");
+    
+    for (size_t i = 0; i < point_count; i++) {
+        const dma_sweep_point_t *point = &points[i];
+        fprintf(file, "point,%s,%s,%u,%u,%zu,%llu,%.4f,%.3f,%.3f,%.3f,,,,\n",
+                dma_direction_to_string(point->params.direction),
+                memory_to_string(point->params.pinned), point->params.alignment,
+                point->params.queue_depth, point->params.size,
+                (unsigned long long)point->transfers, point->gbps,
+                point->mean_us, point->p50_us, point->p99_us);
+    }
+    
+    for (size_t f = 0; f < fit_count; f++) {
+        const dma_sweep_fit_t *fit = &fits[f];
+        fprintf(file, "fit,%s,%s,0,1,,,%.4f,,,,%.3f,%.4f,%.0f,%zu\n",
+                dma_direction_to_string(fit->direction), memory_to_string(fit->pinned),
+                fit->best_gbps, fit->overhead_us, fit->peak_gbps, fit->half_size, fit->knee_size);
+    }
+    
+    if (fclose(file) != 0) {
+        fprintf(stderr, "Failed to write %s: %s\n", filename, strerror(errno));
+        return -1;
+    }
+    
+    return 0;
+}
+
+// =============================================================================
+// Benchmark
+// =============================================================================
+
+typedef struct {
+    benchmark_context_t *ctx;
+    dma_sweep_point_t *points;
+    size_t count;
+    uint64_t bytes;
+    uint32_t failures;
+} dma_sweep_run_t;
+
+static void sweep_point(dma_sweep_run_t *run, dma_direction_t direction, bool pinned,
+                        uint32_t alignment, uint32_t queue_depth, size_t size)
+{
+    dma_sweep_params_t params = { direction, pinned, alignment, queue_depth, size };
+    char size_text[32];
+    
+    if (run->count >= DMA_SWEEP_MAX_POINTS) {
+        return;
+    }
+    
+    if (run_dma_sweep_point(run->ctx, &params, &run->points[run->count]) != 0) {
+        format_size((double)size, size_text, sizeof(size_text));
+        printf(ANSI_YELLOW "  %s %s %s +%u QD%u: transfer failed" ANSI_RESET "\n",
+               dma_direction_to_string(direction), memory_to_string(pinned), size_text,
+               alignment, queue_depth);
+        run->failures++;
+        return;
+    }
+    
+    run->bytes += run->points[run->count].transfers * size;
+    run->count++;
+}
+
+int benchmark_dma_sweep(benchmark_context_t *ctx)
+{
+    performance_metrics_t *metrics = &ctx->result->metrics;
+    dma_sweep_fit_t fits[DMA_DIR_COUNT * 2];
+    size_t fit_count = 0;
+    size_t max_size = dma_sweep_max_size(&ctx->config);
+    dma_sweep_run_t run = { ctx, calloc(DMA_SWEEP_MAX_POINTS, sizeof(dma_sweep_point_t)), 0, 0, 0 };
+    char size_text[32];
+    
+    if (!run.points) {
+        return -1;
+    }
+    
+    format_size((double)max_size, size_text, sizeof(size_text));
+    printf("Running DMA bandwidth sweep (64 B to %s, up to %u transfers per point)\n",
+           size_text, ctx->config.iterations);
+    
+    // A backend without a DMA engine fails the first transfer; say so once
+    sweep_point(&run, DMA_DIR_H2D, true, 0, 1, DMA_SWEEP_MIN_SIZE);
+    if (run.count == 0) {
+        printf(ANSI_YELLOW "DMA transfers not supported by this backend" ANSI_RESET "\n");
+        free(run.points);
+        return -1;
+    }
+    run.count = 0;
+    run.bytes = 0;
+    
+    // Size sweep: one curve per direction and memory kind
+    for (int d = 0; d < DMA_DIR_COUNT; d++) {
+        for (int pinned = 1; pinned >= 0; pinned--) {
+            size_t first = run.count;
+            for (size_t size = DMA_SWEEP_MIN_SIZE; size <= max_size; size *= 2) {
+                sweep_point(&run, (dma_direction_t)d, pinned, 0, 1, size);
+            }
+            fit_dma_sweep_curve(&run.points[first], run.count - first, &fits[fit_count]);
+            fits[fit_count].direction = (dma_direction_t)d;
+            fits[fit_count].pinned = pinned;
+            fit_count++;
+        }
+    }
+    
+    // Host alignment, at sizes where the fixed cost and the copy each dominate
+    for (size_t s = 0; s < NUM_DETAIL_SIZES && g_detail_sizes[s] <= max_size; s++) {
+        for (int pinned = 1; pinned >= 0; pinned--) {
+            for (size_t a = 1; a < NUM_ALIGNMENTS; a++) {
+                sweep_point(&run, DMA_DIR_H2D, pinned, g_alignments[a], 1, g_detail_sizes[s]);
+            }
+        }
+    }
+    
+    // Queue depth: threads overlap their host work with each other's transfers
+    for (size_t s = 0; s < NUM_DETAIL_SIZES && g_detail_sizes[s] <= max_size; s++) {
+        for (size_t d = 0; d < NUM_DEPTH_DIRECTIONS; d++) {
+            for (size_t q = 1; q < NUM_QUEUE_DEPTHS; q++) {
+                sweep_point(&run, g_depth_directions[d], true, 0, g_queue_depths[q], g_detail_sizes[s]);
+            }
+        }
+    }
+    
+    print_dma_sweep_report(run.points, run.count, fits, fit_count, max_size);
+    
+    if (strlen(ctx->config.output_path) > 0 &&
+        write_dma_sweep_csv(ctx->config.output_path, run.points, run.count, fits, fit_count) == 0) {
+        printf("\nSweep points and fits written to %s\n", ctx->config.output_path);
+    }
+    
+    // fits[0] is the pinned host-to-device curve
+    metrics->bandwidth_gbps = fits[0].best_gbps;
+    metrics->data_transferred = run.bytes;
+    
+    free(run.points);
+    return run.failures == 0 ? 0 : -1;
+}
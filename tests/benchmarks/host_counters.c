@@ -0,0 +1,294 @@
+/**
+ * Host CPU Counter Implementation
+ * 
+ * Per-thread host cycles, instructions, cache misses and scheduler
+ * events counted with perf_event_open
+ */
+
+#include "benchmark_framework.h"
+#include <errno.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+// =============================================================================
+// Counter Definitions
+// =============================================================================
+
+#ifdef __linux__
+
+typedef struct {
+    uint32_t type;
+    uint64_t config;
+} host_counter_event_t;
+
+static const host_counter_event_t g_host_events[HOST_COUNTER_COUNT] = {
+    [HOST_COUNTER_CYCLES]           = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    [HOST_COUNTER_INSTRUCTIONS]     = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    [HOST_COUNTER_CACHE_REFERENCES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES },
+    [HOST_COUNTER_CACHE_MISSES]     = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    [HOST_COUNTER_CONTEXT_SWITCHES] = { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+    [HOST_COUNTER_PAGE_FAULTS]      = { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+};
+
+// Group read: PERF_FORMAT_GROUP | TOTAL_TIME_ENABLED | TOTAL_TIME_RUNNING | ID
+typedef struct {
+    uint64_t nr;
+    uint64_t time_enabled;
+    uint64_t time_running;
+    struct {
+        uint64_t value;
+        uint64_t id;
+    } values[HOST_COUNTER_COUNT];
+} host_counter_read_t;
+
+static pthread_mutex_t g_warning_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bool g_warning_printed = false;
+
+static void warn_unavailable(int error)
+{
+    pthread_mutex_lock(&g_warning_mutex);
+    if (!g_warning_printed) {
+        g_warning_printed = true;
+        printf(ANSI_YELLOW "Host hardware counters unavailable (%s)%s" ANSI_RESET "\n", strerror(error),
+               (error == EACCES || error == EPERM) ?
+               "; lower kernel.perf_event_paranoid to enable them" : "");
+    }
+    pthread_mutex_unlock(&g_warning_mutex);
+}
+
+static int perf_event_open(struct perf_event_attr *attr, int group_fd, bool exclude_kernel)
+{
+    attr->exclude_kernel = exclude_kernel;
+    return (int)syscall(SYS_perf_event_open, attr, 0 /* this thread */, -1 /* any CPU */,
+                        group_fd, 0);
+}
+
+// Open one event; the leader of a group starts disabled
+static int open_event(host_counter_group_t *group, host_counter_t counter, int group_fd)
+{
+    struct perf_event_attr attr;
+    
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = g_host_events[counter].type;
+    attr.config = g_host_events[counter].config;
+    attr.disabled = (group_fd == -1);
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID |
+                       PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    
+    // Kernel time is wanted (syscalls, page faults), but unprivileged users
+    // may only count user space
+    int fd = perf_event_open(&attr, group_fd, group->totals.user_only);
+    if (fd < 0 && (errno == EACCES || errno == EPERM) && !group->totals.user_only) {
+        group->totals.user_only = true;
+        fd = perf_event_open(&attr, group_fd, true);
+    }
+    if (fd < 0) {
+        return -1;
+    }
+    
+    if (ioctl(fd, PERF_EVENT_IOC_ID, &group->ids[counter]) != 0) {
+        close(fd);
+        return -1;
+    }
+    
+    group->fds[counter] = fd;
+    return fd;
+}
+
+// Open a group of consecutive counters; members that fail are skipped
+static int open_group(host_counter_group_t *group, host_counter_t first, host_counter_t last)
+{
+    int leader = open_event(group, first, -1);
+    if (leader < 0) {
+        return errno ? -errno : -ENOENT;
+    }
+    
+    for (int counter = first + 1; counter <= (int)last; counter++) {
+        open_event(group, (host_counter_t)counter, leader);
+    }
+    
+    return leader;
+}
+
+static void read_group(host_counter_group_t *group, int leader)
+{
+    host_counter_read_t data;
+    
+    if (leader < 0 || read(leader, &data, sizeof(data)) <= 0 || data.time_running == 0) {
+        return;
+    }
+    
+    // Scale up when the PMU was shared with other groups part of the time
+    double scale = (double)data.time_enabled / (double)data.time_running;
+    
+    for (uint64_t i = 0; i < data.nr && i < HOST_COUNTER_COUNT; i++) {
+        for (int counter = 0; counter < HOST_COUNTER_COUNT; counter++) {
+            if (group->fds[counter] >= 0 && group->ids[counter] == data.values[i].id) {
+                group->totals.values[counter] += (uint64_t)((double)data.values[i].value * scale);
+                break;
+            }
+        }
+    }
+}
+
+#endif // __linux__
+
+// =============================================================================
+// Counter Groups
+// =============================================================================
+
+int host_counters_open(host_counter_group_t *group)
+{
+    memset(group, 0, sizeof(*group));
+    group->hw_leader = -1;
+    group->sw_leader = -1;
+    for (int counter = 0; counter < HOST_COUNTER_COUNT; counter++) {
+        group->fds[counter] = -1;
+    }
+    
+#ifdef __linux__
+    int hw = open_group(group, HOST_COUNTER_CYCLES, HOST_COUNTER_CACHE_MISSES);
+    int sw = open_group(group, HOST_COUNTER_CONTEXT_SWITCHES, HOST_COUNTER_PAGE_FAULTS);
+    
+    group->hw_leader = hw >= 0 ? hw : -1;
+    group->sw_leader = sw >= 0 ? sw : -1;
+    
+    for (int counter = 0; counter < HOST_COUNTER_COUNT; counter++) {
+        if (group->fds[counter] >= 0) {
+            group->totals.valid_mask |= 1u << counter;
+        }
+    }
+    group->totals.threads = 1;
+    
+    if (hw < 0) {
+        warn_unavailable(-hw);
+    }
+    
+    return group->totals.valid_mask ? 0 : -1;
+#else
+    return -1;
+#endif
+}
+
+void host_counters_start(host_counter_group_t *group)
+{
+#ifdef __linux__
+    int leaders[2] = { group->hw_leader, group->sw_leader };
+    
+    for (int i = 0; i < 2; i++) {
+        if (leaders[i] >= 0) {
+            ioctl(leaders[i], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(leaders[i], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+    }
+#else
+    (void)group;
+#endif
+}
+
+void host_counters_stop(host_counter_group_t *group)
+{
+#ifdef __linux__
+    int leaders[2] = { group->hw_leader, group->sw_leader };
+    
+    for (int i = 0; i < 2; i++) {
+        if (leaders[i] >= 0) {
+            ioctl(leaders[i], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+            read_group(group, leaders[i]);
+        }
+    }
+#else
+    (void)group;
+#endif
+}
+
+void host_counters_close(host_counter_group_t *group)
+{
+    for (int counter = 0; counter < HOST_COUNTER_COUNT; counter++) {
+        if (group->fds[counter] >= 0) {
+            close(group->fds[counter]);
+            group->fds[counter] = -1;
+        }
+    }
+    group->hw_leader = -1;
+    group->sw_leader = -1;
+}
+
+void host_counter_values_add(host_counter_values_t *dst, const host_counter_values_t *src)
+{
+    if (src->threads == 0) {
+        return;
+    }
+    
+    // A total is only meaningful if every thread counted it
+    dst->valid_mask = dst->threads ? (dst->valid_mask & src->valid_mask) : src->valid_mask;
+    dst->user_only = dst->user_only || src->user_only;
+    dst->threads += src->threads;
+    
+    for (int counter = 0; counter < HOST_COUNTER_COUNT; counter++) {
+        dst->values[counter] += src->values[counter];
+    }
+}
+
+void merge_host_counters(benchmark_context_t *ctx, const host_counter_values_t *values)
+{
+    if (!ctx || !values) return;
+    
+    pthread_mutex_lock(&ctx->mutex);
+    host_counter_values_add(&ctx->host_totals, values);
+    pthread_mutex_unlock(&ctx->mutex);
+}
+
+// =============================================================================
+// Metrics
+// =============================================================================
+
+static uint64_t host_value(const host_counter_values_t *values, host_counter_t counter)
+{
+    return (values->valid_mask & (1u << counter)) ? values->values[counter] : 0;
+}
+
+void host_counters_to_metrics(const host_counter_values_t *values, performance_metrics_t *metrics)
+{
+    metrics->host_cycles = host_value(values, HOST_COUNTER_CYCLES);
+    metrics->host_instructions = host_value(values, HOST_COUNTER_INSTRUCTIONS);
+    metrics->host_cache_references = host_value(values, HOST_COUNTER_CACHE_REFERENCES);
+    metrics->host_cache_misses = host_value(values, HOST_COUNTER_CACHE_MISSES);
+    metrics->host_context_switches = host_value(values, HOST_COUNTER_CONTEXT_SWITCHES);
+    metrics->host_page_faults = host_value(values, HOST_COUNTER_PAGE_FAULTS);
+    metrics->host_user_only = values->user_only;
+    
+    metrics->host_ipc = metrics->host_cycles ?
+        (double)metrics->host_instructions / (double)metrics->host_cycles : 0.0;
+    metrics->host_instructions_per_byte = metrics->data_transferred ?
+        (double)metrics->host_instructions / (double)metrics->data_transferred : 0.0;
+}
+
+void print_host_counters(const performance_metrics_t *metrics)
+{
+    if (metrics->host_cycles == 0 && metrics->host_instructions == 0 &&
+        metrics->host_context_switches == 0 && metrics->host_page_faults == 0) {
+        return;
+    }
+    
+    printf("  Host CPU%s:", metrics->host_user_only ? " (user only)" : "");
+    if (metrics->host_cycles > 0) {
+        printf(" %.2f IPC,", metrics->host_ipc);
+    }
+    if (metrics->host_instructions_per_byte > 0) {
+        printf(" %.2f instructions/byte,", metrics->host_instructions_per_byte);
+    }
+    if (metrics->host_cache_references > 0) {
+        printf(" %llu LLC misses (%.1f%%),", (unsigned long long)metrics->host_cache_misses,
+               100.0 * (double)metrics->host_cache_misses / (double)metrics->host_cache_references);
+    }
+    printf(" %llu context switches, %llu page faults\n",
+           (unsigned long long)metrics->host_context_switches,
+           (unsigned long long)metrics->host_page_faults);
+}
@@ -0,0 +1,483 @@
+/**
+ * Host Overhead Microbenchmark Implementation
+ * 
+ * Timer, syscall, ioctl, MMIO, submission and wake-up costs
+ * making up the latency budget of one small operator
+ */
+
+#include "benchmark_framework.h"
+#include <errno.h>
+#include <sys/syscall.h>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+// =============================================================================
+// Probes
+// =============================================================================
+
+#define OVERHEAD_OPERATOR_DIM 16     // Matmul used as the small operator
+#define EVENTFD_STOP 2               // Ping value that ends the echo thread
+
+static const char *g_probe_names[OVERHEAD_PROBE_COUNT] = {
+    [OVERHEAD_PROBE_TIMER]          = "timer",
+    [OVERHEAD_PROBE_SYSCALL]        = "syscall",
+    [OVERHEAD_PROBE_NULL_IOCTL]     = "null_ioctl",
+    [OVERHEAD_PROBE_COPY_IOCTL]     = "copy_ioctl",
+    [OVERHEAD_PROBE_STATUS_POLL]    = "status_poll",
+    [OVERHEAD_PROBE_SUBMIT]         = "submit",
+    [OVERHEAD_PROBE_ROUND_TRIP]     = "round_trip",
+    [OVERHEAD_PROBE_EVENTFD]        = "eventfd_round_trip",
+    [OVERHEAD_PROBE_CONDVAR]        = "condvar_round_trip",
+    [OVERHEAD_PROBE_OPERATOR]       = "operator",
+};
+
+static const char *g_probe_descriptions[OVERHEAD_PROBE_COUNT] = {
+    [OVERHEAD_PROBE_TIMER]          = "Back-to-back timestamps",
+    [OVERHEAD_PROBE_SYSCALL]        = "getppid() system call",
+    [OVERHEAD_PROBE_NULL_IOCTL]     = "NPU_IOCTL_NOP (driver entry and return)",
+    [OVERHEAD_PROBE_COPY_IOCTL]     = "NPU_IOCTL_GET_THERMAL_INFO (copy_to_user)",
+    [OVERHEAD_PROBE_STATUS_POLL]    = "NPU_IOCTL_GET_STATUS (MMIO read)",
+    [OVERHEAD_PROBE_SUBMIT]         = "Minimal instruction write (copy and doorbell)",
+    [OVERHEAD_PROBE_ROUND_TRIP]     = "Minimal instruction submit and wait",
+    [OVERHEAD_PROBE_EVENTFD]        = "eventfd ping-pong between two threads",
+    [OVERHEAD_PROBE_CONDVAR]        = "Condition variable ping-pong between two threads",
+    [OVERHEAD_PROBE_OPERATOR]       = "16x16x16 matmul, tensors staged",
+};
+
+const char* overhead_probe_to_string(overhead_probe_t probe)
+{
+    return probe < OVERHEAD_PROBE_COUNT ? g_probe_names[probe] : "unknown";
+}
+
+// One add of a single element: the least the device can be asked to do
+static npu_instruction_t minimal_instruction(void)
+{
+    npu_instruction_t inst;
+    
+    memset(&inst, 0, sizeof(inst));
+    inst.op = NPU_OP_ADD;
+    inst.size = sizeof(int32_t);
+    return inst;
+}
+
+// =============================================================================
+// Thread Ping-Pong
+// =============================================================================
+
+typedef struct {
+    int ping_fd;
+    int pong_fd;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    uint64_t turn;               // Odd: echo thread's turn
+    bool stop;
+} ping_pong_t;
+
+#ifdef __linux__
+static void* eventfd_echo(void *arg)
+{
+    ping_pong_t *pp = (ping_pong_t *)arg;
+    uint64_t value;
+    
+    while (read(pp->ping_fd, &value, sizeof(value)) == sizeof(value)) {
+        if (value >= EVENTFD_STOP) {
+            break;
+        }
+        value = 1;
+        if (write(pp->pong_fd, &value, sizeof(value)) != sizeof(value)) {
+            break;
+        }
+    }
+    
+    return NULL;
+}
+#endif
+
+static void* condvar_echo(void *arg)
+{
+    ping_pong_t *pp = (ping_pong_t *)arg;
+    
+    pthread_mutex_lock(&pp->mutex);
+    while (!pp->stop) {
+        while (!(pp->turn & 1) && !pp->stop) {
+            pthread_cond_wait(&pp->cond, &pp->mutex);
+        }
+        pp->turn++;
+        pthread_cond_broadcast(&pp->cond);
+    }
+    pthread_mutex_unlock(&pp->mutex);
+    
+    return NULL;
+}
+
+static int run_eventfd_probe(uint32_t warmup, uint32_t iterations, latency_histogram_t *hist)
+{
+#ifdef __linux__
+    ping_pong_t pp = { .ping_fd = eventfd(0, 0), .pong_fd = eventfd(0, 0) };
+    pthread_t thread;
+    uint64_t value;
+    int ret = -1;
+    
+    if (pp.ping_fd < 0 || pp.pong_fd < 0 ||
+        pthread_create(&thread, NULL, eventfd_echo, &pp) != 0) {
+        goto out;
+    }
+    
+    ret = 0;
+    for (uint32_t i = 0; i < warmup + iterations; i++) {
+        uint64_t start = get_timestamp_ns();
+        value = 1;
+        if (write(pp.ping_fd, &value, sizeof(value)) != sizeof(value) ||
+            read(pp.pong_fd, &value, sizeof(value)) != sizeof(value)) {
+            ret = -1;
+            break;
+        }
+        if (i >= warmup) {
+            latency_histogram_record(hist, get_timestamp_ns() - start);
+        }
+    }
+    
+    value = EVENTFD_STOP;
+    if (write(pp.ping_fd, &value, sizeof(value)) != sizeof(value)) {
+        ret = -1;
+    }
+    pthread_join(thread, NULL);
+    
+out:
+    if (pp.ping_fd >= 0) close(pp.ping_fd);
+    if (pp.pong_fd >= 0) close(pp.pong_fd);
+    return ret;
+#else
+    (void)warmup;
+    (void)iterations;
+    (void)hist;
+    return -1;
+#endif
+}
+
+static int run_condvar_probe(uint32_t warmup, uint32_t iterations, latency_histogram_t *hist)
+{
+    ping_pong_t pp = { .turn = 0, .stop = false };
+    pthread_t thread;
+    
+    pthread_mutex_init(&pp.mutex, NULL);
+    pthread_cond_init(&pp.cond, NULL);
+    
+    if (pthread_create(&thread, NULL, condvar_echo, &pp) != 0) {
+        pthread_cond_destroy(&pp.cond);
+        pthread_mutex_destroy(&pp.mutex);
+        return -1;
+    }
+    
+    for (uint32_t i = 0; i < warmup + iterations; i++) {
+        uint64_t start = get_timestamp_ns();
+        pthread_mutex_lock(&pp.mutex);
+        pp.turn++;
+        pthread_cond_broadcast(&pp.cond);
+        while (pp.turn & 1) {
+            pthread_cond_wait(&pp.cond, &pp.mutex);
+        }
+        pthread_mutex_unlock(&pp.mutex);
+        if (i >= warmup) {
+            latency_histogram_record(hist, get_timestamp_ns() - start);
+        }
+    }
+    
+    pthread_mutex_lock(&pp.mutex);
+    pp.stop = true;
+    pthread_cond_broadcast(&pp.cond);
+    pthread_mutex_unlock(&pp.mutex);
+    pthread_join(thread, NULL);
+    
+    pthread_cond_destroy(&pp.cond);
+    pthread_mutex_destroy(&pp.mutex);
+    return 0;
+}
+
+// =============================================================================
+// Device Probes
+// =============================================================================
+
+typedef struct {
+    int32_t a[OVERHEAD_OPERATOR_DIM * OVERHEAD_OPERATOR_DIM];
+    int32_t b[OVERHEAD_OPERATOR_DIM * OVERHEAD_OPERATOR_DIM];
+    int32_t c[OVERHEAD_OPERATOR_DIM * OVERHEAD_OPERATOR_DIM];
+} overhead_operands_t;
+
+// One timed call of a probe; returns the elapsed time, or 0 on failure
+static uint64_t time_probe(npu_handle_t handle, overhead_probe_t probe,
+                           overhead_operands_t *operands)
+{
+    npu_instruction_t inst = minimal_instruction();
+    struct npu_thermal_info thermal;
+    uint32_t status;
+    uint64_t start, end;
+    int rc = NPU_SUCCESS;
+    
+    start = get_timestamp_ns();
+    switch (probe) {
+        case OVERHEAD_PROBE_TIMER:
+            break;
+        case OVERHEAD_PROBE_SYSCALL:
+            syscall(SYS_getppid);
+            break;
+        case OVERHEAD_PROBE_NULL_IOCTL:
+            rc = npu_null_ioctl(handle);
+            break;
+        case OVERHEAD_PROBE_COPY_IOCTL:
+            rc = npu_get_thermal_info(handle, &thermal);
+            break;
+        case OVERHEAD_PROBE_STATUS_POLL:
+            rc = npu_get_status(handle, &status);
+            break;
+        case OVERHEAD_PROBE_SUBMIT:
+            rc = npu_execute_instruction(handle, &inst);
+            end = get_timestamp_ns();
+            // Drain outside the timed section so submissions never queue up
+            if (rc == NPU_SUCCESS) {
+                rc = npu_wait_completion(handle, 1000);
+            }
+            return rc == NPU_SUCCESS ? end - start : 0;
+        case OVERHEAD_PROBE_ROUND_TRIP:
+            rc = npu_execute_instruction(handle, &inst);
+            if (rc == NPU_SUCCESS) {
+                rc = npu_wait_completion(handle, 1000);
+            }
+            break;
+        case OVERHEAD_PROBE_OPERATOR: {
+            npu_tensor_t a = npu_create_tensor(operands->a, 1, 1, OVERHEAD_OPERATOR_DIM,
+                                               OVERHEAD_OPERATOR_DIM, NPU_DTYPE_INT32);
+            npu_tensor_t b = npu_create_tensor(operands->b, 1, 1, OVERHEAD_OPERATOR_DIM,
+                                               OVERHEAD_OPERATOR_DIM, NPU_DTYPE_INT32);
+            npu_tensor_t c = npu_create_tensor(operands->c, 1, 1, OVERHEAD_OPERATOR_DIM,
+                                               OVERHEAD_OPERATOR_DIM, NPU_DTYPE_INT32);
+            rc = npu_matrix_multiply(handle, &a, &b, &c);
+            break;
+        }
+        default:
+            return 0;
+    }
+    end = get_timestamp_ns();
+    
+    return rc == NPU_SUCCESS ? (end > start ? end - start : 1) : 0;
+}
+
+int run_overhead_probe(benchmark_context_t *ctx, overhead_probe_t probe,
+                      overhead_probe_result_t *result, performance_metrics_t *metrics)
+{
+    uint32_t iterations = ctx->config.iterations ? ctx->config.iterations : 1000;
+    uint32_t warmup = ctx->config.warmup_iterations;
+    latency_histogram_t *hist = malloc(sizeof(latency_histogram_t));
+    overhead_operands_t *operands = calloc(1, sizeof(overhead_operands_t));
+    int ret = 0;
+    
+    memset(result, 0, sizeof(*result));
+    result->probe = probe;
+    
+    if (!hist || !operands) {
+        free(hist);
+        free(operands);
+        return -1;
+    }
+    latency_histogram_reset(hist);
+    
+    if (probe == OVERHEAD_PROBE_EVENTFD) {
+        ret = run_eventfd_probe(warmup, iterations, hist);
+    } else if (probe == OVERHEAD_PROBE_CONDVAR) {
+        ret = run_condvar_probe(warmup, iterations, hist);
+    } else {
+        for (uint32_t i = 0; i < warmup + iterations; i++) {
+            uint64_t elapsed = time_probe(ctx->npu_handle, probe, operands);
+            if (elapsed == 0) {
+                // A probe the backend does not support fails on its first call
+                ret = -1;
+                break;
+            }
+            if (i >= warmup) {
+                latency_histogram_record(hist, elapsed);
+            }
+        }
+    }
+    
+    if (ret == 0 && hist->total_count > 0) {
+        result->available = true;
+        result->samples = hist->total_count;
+        result->min_us = hist->min_ns / 1e3;
+        result->p50_us = latency_histogram_percentile(hist, 50.0) / 1e3;
+        result->p99_us = latency_histogram_percentile(hist, 99.0) / 1e3;
+        result->mean_us = hist->sum_ns / hist->total_count / 1e3;
+        if (metrics) {
+            calculate_histogram_statistics(hist, metrics);
+        }
+    }
+    
+    free(hist);
+    free(operands);
+    return result->available ? 0 : -1;
+}
+
+// =============================================================================
+// Latency Budget
+// =============================================================================
+
+// Median of a probe less the timer's own cost, or 0 when not measured
+static double net_us(const overhead_probe_result_t *results, overhead_probe_t probe)
+{
+    const overhead_probe_result_t *timer = &results[OVERHEAD_PROBE_TIMER];
+    const overhead_probe_result_t *r = &results[probe];
+    
+    if (!r->available) {
+        return 0.0;
+    }
+    return fmax(r->p50_us - (timer->available ? timer->p50_us : 0.0), 0.0);
+}
+
+static void add_budget_line(overhead_budget_t *budget, const char *layer, double us)
+{
+    if (budget->count < OVERHEAD_MAX_BUDGET_LINES) {
+        budget->lines[budget->count].layer = layer;
+        budget->lines[budget->count].us = fmax(us, 0.0);
+        budget->count++;
+    }
+}
+
+void compute_overhead_budget(const overhead_probe_result_t *results, overhead_budget_t *budget)
+{
+    double syscall_us = net_us(results, OVERHEAD_PROBE_SYSCALL);
+    double null_us = net_us(results, OVERHEAD_PROBE_NULL_IOCTL);
+    double submit_us = net_us(results, OVERHEAD_PROBE_SUBMIT);
+    double round_trip_us = net_us(results, OVERHEAD_PROBE_ROUND_TRIP);
+    double operator_us = net_us(results, OVERHEAD_PROBE_OPERATOR);
+    
+    // Without the null ioctl, dispatch is counted with the copy and doorbell
+    double entry_us = results[OVERHEAD_PROBE_NULL_IOCTL].available ? null_us : syscall_us;
+    
+    memset(budget, 0, sizeof(*budget));
+    budget->total_us = operator_us;
+    
+    // The operator path: submit, wait, and everything else the call does
+    add_budget_line(budget, "Syscall entry and return", syscall_us);
+    if (results[OVERHEAD_PROBE_NULL_IOCTL].available) {
+        add_budget_line(budget, "Driver ioctl dispatch", null_us - syscall_us);
+    }
+    add_budget_line(budget, "Instruction copy and doorbell", submit_us - entry_us);
+    add_budget_line(budget, "Device execution and completion", round_trip_us - submit_us);
+    add_budget_line(budget, "Tensor staging and compute", operator_us - round_trip_us);
+    
+    // Costs that appear inside the layers above, for reference
+    budget->copy_to_user_us = fmax(net_us(results, OVERHEAD_PROBE_COPY_IOCTL) - null_us, 0.0);
+    budget->mmio_read_us = fmax(net_us(results, OVERHEAD_PROBE_STATUS_POLL) -
+                                net_us(results, OVERHEAD_PROBE_COPY_IOCTL), 0.0);
+    budget->wait_queue_wakeup_us = net_us(results, OVERHEAD_PROBE_EVENTFD) / 2.0;
+    budget->futex_wakeup_us = net_us(results, OVERHEAD_PROBE_CONDVAR) / 2.0;
+}
+
+// =============================================================================
+// Report
+// =============================================================================
+
+static void print_overhead_report(const overhead_probe_result_t *results,
+                                  const overhead_budget_t *budget)
+{
+    printf("\n%-20s %10s %10s %10s %10s  %s\n",
+           "Probe", "min (us)", "p50 (us)", "p99 (us)", "mean (us)", "Layer");
+    for (int p = 0; p < OVERHEAD_PROBE_COUNT; p++) {
+        const overhead_probe_result_t *r = &results[p];
+        if (!r->available) {
+            printf("%-20s %10s %10s %10s %10s  %s\n", g_probe_names[p], "n/a", "n/a", "n/a", "n/a",
+                   g_probe_descriptions[p]);
+            continue;
+        }
+        printf("%-20s %10.3f %10.3f %10.3f %10.3f  %s\n", g_probe_names[p],
+               r->min_us, r->p50_us, r->p99_us, r->mean_us, g_probe_descriptions[p]);
+    }
+    
+    if (budget->total_us <= 0.0) {
+        printf(ANSI_YELLOW "\nOperator probe unavailable; no latency budget" ANSI_RESET "\n");
+        return;
+    }
+    
+    printf("\nLatency budget of one %s (median %.3f us):\n",
+           g_probe_descriptions[OVERHEAD_PROBE_OPERATOR], budget->total_us);
+    for (uint32_t i = 0; i < budget->count; i++) {
+        double share = budget->lines[i].us / budget->total_us * 100.0;
+        int bar = (int)(share / 2.0 + 0.5);
+        printf("  %-34s %10.3f us %6.1f%%  %.*s\n", budget->lines[i].layer, budget->lines[i].us,
+               share, bar, "##################################################");
+    }
+    
+    printf("\nReference costs:\n");
+    printf("  %-34s %10.3f us\n", "copy_to_user of a small struct", budget->copy_to_user_us);
+    printf("  %-34s %10.3f us\n", "MMIO register read", budget->mmio_read_us);
+    printf("  %-34s %10.3f us\n", "Wait-queue wake-up (eventfd)", budget->wait_queue_wakeup_us);
+    printf("  %-34s %10.3f us\n", "Futex wake-up (condvar)", budget->futex_wakeup_us);
+}
+
+int write_overhead_csv(const char *filename, const overhead_probe_result_t *results,
+                      const overhead_budget_t *budget)
+{
+    FILE *csv = fopen(filename, "w");
+    if (!csv) {
+        fprintf(stderr, "Failed to open %s: %s\n", filename, strerror(errno));
+        return -1;
+    }
+    
+    fprintf(csv, "kind,name,samples,min_us,p50_us,p99_us,mean_us,share_pct\n");
+    for (int p = 0; p < OVERHEAD_PROBE_COUNT; p++) {
+        const overhead_probe_result_t *r = &results[p];
+        if (r->available) {
+            fprintf(csv, "probe,%s,%llu,%.4f,%.4f,%.4f,%.4f,\n", g_probe_names[p],
+                    (unsigned long long)r->samples, r->min_us, r->p50_us, r->p99_us, r->mean_us);
+        }
+    }
+    for (uint32_t i = 0; i < budget->count; i++) {
+        fprintf(csv, "budget,%s,,,%.4f,,,%.2f\n", budget->lines[i].layer, budget->lines[i].us,
+                budget->total_us > 0 ? budget->lines[i].us / budget->total_us * 100.0 : 0.0);
+    }
+    fprintf(csv, "reference,copy_to_user,,,%.4f,,,\n", budget->copy_to_user_us);
+    fprintf(csv, "reference,mmio_read,,,%.4f,,,\n", budget->mmio_read_us);
+    fprintf(csv, "reference,wait_queue_wakeup,,,%.4f,,,\n", budget->wait_queue_wakeup_us);
+    fprintf(csv, "reference,futex_wakeup,,,%.4f,,,\n", budget->futex_wakeup_us);
+    
+    if (fclose(csv) != 0) {
+        fprintf(stderr, "Failed to write %s: %s\n", filename, strerror(errno));
+        return -1;
+    }
+    
+    return 0;
+}
+
+// =============================================================================
+// Host Overhead Benchmark
+// =============================================================================
+
+int benchmark_host_overhead(benchmark_context_t *ctx)
+{
+    performance_metrics_t *metrics = &ctx->result->metrics;
+    overhead_probe_result_t results[OVERHEAD_PROBE_COUNT];
+    overhead_budget_t budget;
+    
+    printf("Running host overhead microbenchmarks (%u iterations per probe)\n",
+           ctx->config.iterations);
+    
+    for (int p = 0; p < OVERHEAD_PROBE_COUNT; p++) {
+        // The minimal round trip is the latency this benchmark reports
+        performance_metrics_t *probe_metrics = p == OVERHEAD_PROBE_ROUND_TRIP ? metrics : NULL;
+        if (run_overhead_probe(ctx, (overhead_probe_t)p, &results[p], probe_metrics) != 0) {
+            printf(ANSI_YELLOW "  %s: not supported by this backend" ANSI_RESET "\n", g_probe_names[p]);
+        }
+    }
+    
+    compute_overhead_budget(results, &budget);
+    print_overhead_report(results, &budget);
+    
+    if (strlen(ctx->config.output_path) > 0 &&
+        write_overhead_csv(ctx->config.output_path, results, &budget) == 0) {
+        printf("\nProbes and budget written to %s\n", ctx->config.output_path);
+    }
+    
+    // The round trip is what every operator pays; it must work
+    return results[OVERHEAD_PROBE_ROUND_TRIP].available ? 0 : -1;
+}
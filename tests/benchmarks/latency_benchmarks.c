@@ -43,12 +43,6 @@ int benchmark_single_operation_latency(benchmark_context_t *ctx)
     }
     
     // Measure individual operation latencies
-    double *latencies = malloc(config->iterations * sizeof(double));
-    if (!latencies) {
-        fprintf(stderr, "Failed to allocate latency array\n");
-        goto cleanup;
-    }
-    
     printf("Measuring %u individual operations...\n", config->iterations);
     
     for (uint32_t i = 0; i < config->iterations; i++) {
@@ -65,9 +59,8 @@ int benchmark_single_operation_latency(benchmark_context_t *ctx)
         if (result != NPU_SUCCESS) {
             fprintf(stderr, "Operation %u failed: %d\n", i, result);
             metrics->errors_count++;
-            latencies[i] = 0.0;
         } else {
-            latencies[i] = calculate_duration_seconds(start_time, end_time) * 1000.0; // Convert to ms
+            record_latency_sample(ctx, calculate_duration_seconds(start_time, end_time) * 1000.0); // Convert to ms
             metrics->operations_count++;
         }
         
@@ -78,19 +71,17 @@ int benchmark_single_operation_latency(benchmark_context_t *ctx)
     }
     
     // Calculate latency statistics
-    calculate_latency_statistics(latencies, config->iterations, metrics);
+    calculate_histogram_statistics(&ctx->result->latency_histogram, metrics);
     
     printf("Single operation latency statistics:\n");
     printf("  Average: %.3f ms\n", metrics->latency_ms);
-    printf("  Minimum: %.3f ms\n", metrics->min_latency_ms);
-    printf("  Maximum: %.3f ms\n", metrics->max_latency_ms);
-    printf("  95th percentile: %.3f ms\n", metrics->p95_latency_ms);
-    printf("  99th percentile: %.3f ms\n", metrics->p99_latency_ms);
-    printf("  Standard deviation: %.3f ms\n", metrics->latency_stddev_ms);
+    printf("  Minimum: %.3f ms\n", metrics->latency_min_ms);
+    printf("  Maximum: %.3f ms\n", metrics->latency_max_ms);
+    printf("  50th percentile: %.3f ms\n", metrics->latency_p50_ms);
+    printf("  99th percentile: %.3f ms\n", metrics->latency_p99_ms);
+    printf("  99.99th percentile: %.3f ms\n", metrics->latency_p9999_ms);
+    printf("  Standard deviation: %.3f ms\n", metrics->latency_std_ms);
     
-    free(latencies);
-
-cleanup:
     free_aligned_buffer(matrix_a);
     free_aligned_buffer(matrix_b);
     free_aligned_buffer(matrix_c);
@@ -149,12 +140,6 @@ int benchmark_batch_operation_latency(benchmark_context_t *ctx)
     }
     
     // Measure batch operation latencies
-    double *batch_latencies = malloc(config->iterations * sizeof(double));
-    if (!batch_latencies) {
-        fprintf(stderr, "Failed to allocate batch latency array\n");
-        goto cleanup;
-    }
-    
     printf("Measuring %u batch operations...\n", config->iterations);
     
     for (uint32_t i = 0; i < config->iterations; i++) {
@@ -171,15 +156,14 @@ int benchmark_batch_operation_latency(benchmark_context_t *ctx)
         if (result != NPU_SUCCESS) {
             fprintf(stderr, "Batch operation %u failed: %d\n", i, result);
             metrics->errors_count++;
-            batch_latencies[i] = 0.0;
         } else {
-            batch_latencies[i] = calculate_duration_seconds(start_time, end_time) * 1000.0; // Convert to ms
+            record_latency_sample(ctx, calculate_duration_seconds(start_time, end_time) * 1000.0); // Convert to ms
             metrics->operations_count += batch_size;
         }
     }
     
     // Calculate batch latency statistics
-    calculate_latency_statistics(batch_latencies, config->iterations, metrics);
+    calculate_histogram_statistics(&ctx->result->latency_histogram, metrics);
     
     // Calculate per-operation latency within batch
     double avg_per_op_latency = metrics->latency_ms / batch_size;
@@ -187,14 +171,11 @@ int benchmark_batch_operation_latency(benchmark_context_t *ctx)
     printf("Batch operation latency statistics:\n");
     printf("  Batch average: %.3f ms\n", metrics->latency_ms);
     printf("  Per-operation in batch: %.3f ms\n", avg_per_op_latency);
-    printf("  Batch minimum: %.3f ms\n", metrics->min_latency_ms);
-    printf("  Batch maximum: %.3f ms\n", metrics->max_latency_ms);
-    printf("  Batch 95th percentile: %.3f ms\n", metrics->p95_latency_ms);
-    printf("  Batch 99th percentile: %.3f ms\n", metrics->p99_latency_ms);
+    printf("  Batch minimum: %.3f ms\n", metrics->latency_min_ms);
+    printf("  Batch maximum: %.3f ms\n", metrics->latency_max_ms);
+    printf("  Batch 99th percentile: %.3f ms\n", metrics->latency_p99_ms);
+    printf("  Batch 99.99th percentile: %.3f ms\n", metrics->latency_p9999_ms);
     
-    free(batch_latencies);
-
-cleanup:
     free_aligned_buffer(batch_a);
     free_aligned_buffer(batch_b);
     free_aligned_buffer(batch_c);
@@ -239,13 +220,14 @@ int benchmark_memory_access_latency(benchmark_context_t *ctx)
         }
         
         // Measure memory access latencies
-        double *mem_latencies = malloc(config->iterations * sizeof(double));
+        latency_histogram_t *mem_latencies = malloc(sizeof(latency_histogram_t));
         if (!mem_latencies) {
-            fprintf(stderr, "Failed to allocate memory latency array\n");
+            fprintf(stderr, "Failed to allocate memory latency histogram\n");
             free_aligned_buffer(src_buffer);
             free_aligned_buffer(dst_buffer);
             continue;
         }
+        latency_histogram_reset(mem_latencies);
         
         for (uint32_t i = 0; i < config->iterations; i++) {
             struct timespec start_time, end_time;
@@ -259,22 +241,23 @@ int benchmark_memory_access_latency(benchmark_context_t *ctx)
             if (result != NPU_SUCCESS) {
                 fprintf(stderr, "Memory copy %u failed for size %zu: %d\n", i, buffer_size, result);
                 metrics->errors_count++;
-                mem_latencies[i] = 0.0;
             } else {
-                mem_latencies[i] = calculate_duration_seconds(start_time, end_time) * 1000000.0; // Convert to microseconds
+                latency_histogram_record_corrected(mem_latencies,
+                    (uint64_t)(calculate_duration_seconds(start_time, end_time) * 1e9),
+                    (uint64_t)(config->intended_interval_ms * 1e6));
                 metrics->operations_count++;
             }
         }
         
         // Calculate memory access statistics
         performance_metrics_t size_metrics = {0};
-        calculate_latency_statistics(mem_latencies, config->iterations, &size_metrics);
+        calculate_histogram_statistics(mem_latencies, &size_metrics);
         
-        printf("  %zu bytes - Average: %.1f μs, Min: %.1f μs, Max: %.1f μs, P95: %.1f μs\n",
+        printf("  %zu bytes - Average: %.1f μs, Min: %.1f μs, Max: %.1f μs, P99: %.1f μs\n",
                buffer_size, size_metrics.latency_ms * 1000.0,
-               size_metrics.min_latency_ms * 1000.0,
-               size_metrics.max_latency_ms * 1000.0,
-               size_metrics.p95_latency_ms * 1000.0);
+               size_metrics.latency_min_ms * 1000.0,
+               size_metrics.latency_max_ms * 1000.0,
+               size_metrics.latency_p99_ms * 1000.0);
         
         // Accumulate overall metrics
         metrics->latency_ms += size_metrics.latency_ms;
@@ -340,12 +323,6 @@ int benchmark_context_switch_latency(benchmark_context_t *ctx)
     }
     
     // Measure context switch latencies
-    double *switch_latencies = malloc(config->iterations * sizeof(double));
-    if (!switch_latencies) {
-        fprintf(stderr, "Failed to allocate switch latency array\n");
-        goto cleanup_contexts;
-    }
-    
     for (uint32_t i = 0; i < config->iterations; i++) {
         int current_ctx = i % num_contexts;
         int next_ctx = (i + 1) % num_contexts;
@@ -366,26 +343,22 @@ int benchmark_context_switch_latency(benchmark_context_t *ctx)
         if (result1 != NPU_SUCCESS || result2 != NPU_SUCCESS) {
             fprintf(stderr, "Context switch %u failed: ctx=%d, op=%d\n", i, result1, result2);
             metrics->errors_count++;
-            switch_latencies[i] = 0.0;
         } else {
-            switch_latencies[i] = calculate_duration_seconds(start_time, end_time) * 1000000.0; // Convert to microseconds
+            record_latency_sample(ctx, calculate_duration_seconds(start_time, end_time) * 1000.0); // Convert to ms
             metrics->operations_count++;
         }
     }
     
     // Calculate context switch statistics
-    calculate_latency_statistics(switch_latencies, config->iterations, metrics);
+    calculate_histogram_statistics(&ctx->result->latency_histogram, metrics);
     
     printf("Context switch latency statistics:\n");
     printf("  Average: %.1f μs\n", metrics->latency_ms * 1000.0);
-    printf("  Minimum: %.1f μs\n", metrics->min_latency_ms * 1000.0);
-    printf("  Maximum: %.1f μs\n", metrics->max_latency_ms * 1000.0);
-    printf("  95th percentile: %.1f μs\n", metrics->p95_latency_ms * 1000.0);
-    printf("  99th percentile: %.1f μs\n", metrics->p99_latency_ms * 1000.0);
+    printf("  Minimum: %.1f μs\n", metrics->latency_min_ms * 1000.0);
+    printf("  Maximum: %.1f μs\n", metrics->latency_max_ms * 1000.0);
+    printf("  99th percentile: %.1f μs\n", metrics->latency_p99_ms * 1000.0);
+    printf("  99.99th percentile: %.1f μs\n", metrics->latency_p9999_ms * 1000.0);
     
-    free(switch_latencies);
-
-cleanup_contexts:
     for (int i = 0; i < num_contexts; i++) {
         npu_destroy_context(ctx->npu_handle, contexts[i]);
     }
@@ -397,58 +370,3 @@ cleanup:
     
     return (metrics->errors_count == 0) ? 0 : -1;
 }
-
-// =============================================================================
-// Helper Functions
-// =============================================================================
-
-void calculate_latency_statistics(double *latencies, uint32_t count, performance_metrics_t *metrics)
-{
-    if (count == 0) return;
-    
-    // Sort latencies for percentile calculation
-    qsort(latencies, count, sizeof(double), compare_double);
-    
-    // Calculate basic statistics
-    double sum = 0.0;
-    double min_val = latencies[0];
-    double max_val = latencies[0];
-    
-    for (uint32_t i = 0; i < count; i++) {
-        if (latencies[i] > 0.0) { // Skip failed operations
-            sum += latencies[i];
-            if (latencies[i] < min_val) min_val = latencies[i];
-            if (latencies[i] > max_val) max_val = latencies[i];
-        }
-    }
-    
-    metrics->latency_ms = sum / count;
-    metrics->min_latency_ms = min_val;
-    metrics->max_latency_ms = max_val;
-    
-    // Calculate percentiles
-    uint32_t p95_idx = (uint32_t)(count * 0.95);
-    uint32_t p99_idx = (uint32_t)(count * 0.99);
-    metrics->p95_latency_ms = latencies[p95_idx];
-    metrics->p99_latency_ms = latencies[p99_idx];
-    
-    // Calculate standard deviation
-    double variance_sum = 0.0;
-    for (uint32_t i = 0; i < count; i++) {
-        if (latencies[i] > 0.0) {
-            double diff = latencies[i] - metrics->latency_ms;
-            variance_sum += diff * diff;
-        }
-    }
-    metrics->latency_stddev_ms = sqrt(variance_sum / count);
-}
-
-int compare_double(const void *a, const void *b)
-{
-    double da = *(const double*)a;
-    double db = *(const double*)b;
-    
-    if (da < db) return -1;
-    if (da > db) return 1;
-    return 0;
-}
\ No newline at end of file
@@ -0,0 +1,491 @@
+/**
+ * Open-Loop Load Generator Implementation
+ * 
+ * Request arrivals on a fixed schedule, dispatched to submitter threads,
+ * timed from each request's intended start
+ */
+
+#include "benchmark_framework.h"
+#include <errno.h>
+#include <pthread.h>
+#include <math.h>
+
+// =============================================================================
+// Load Generator State
+// =============================================================================
+
+typedef struct {
+    benchmark_context_t *ctx;
+    load_request_function_t request;
+    void *arg;
+    
+    // Arrival queue of intended start times (ns), a ring of capacity entries
+    uint64_t *queue;
+    uint32_t capacity;
+    uint32_t head;
+    uint32_t count;
+    bool done;                   // No more arrivals
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+} load_state_t;
+
+typedef struct {
+    load_state_t *state;
+    uint32_t index;
+    latency_histogram_t response;
+    latency_histogram_t service;
+    uint64_t completed;
+    uint64_t errors;
+    uint64_t last_completion_ns;
+} load_submitter_t;
+
+typedef struct {
+    arrival_process_t arrival;
+    uint64_t rng;
+    double mean_gap_ns;          // Mean inter-arrival time (during on periods for BURSTY)
+    double on_mean_ns;
+    double off_mean_ns;
+    double on_end_ns;            // End of the current on period
+    double t_ns;                 // Last arrival, relative to the start
+} arrival_generator_t;
+
+// =============================================================================
+// Arrival Processes
+// =============================================================================
+
+// Uniform in [0, 1) (xorshift64*)
+static double arrival_uniform(uint64_t *state)
+{
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return (double)((x * 2685821657736338717ULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double arrival_exponential(uint64_t *state, double mean)
+{
+    return -log(1.0 - arrival_uniform(state)) * mean;
+}
+
+static void arrival_generator_init(arrival_generator_t *gen, const load_generator_config_t *config)
+{
+    memset(gen, 0, sizeof(*gen));
+    gen->arrival = config->arrival;
+    gen->rng = config->seed ? config->seed : 0x9E3779B97F4A7C15ULL;
+    gen->mean_gap_ns = 1e9 / config->rate_per_sec;
+    
+    if (gen->arrival == ARRIVAL_BURSTY) {
+        // Same mean rate overall, all of it squeezed into the on periods
+        gen->on_mean_ns = config->burst_on_ms * 1e6;
+        gen->off_mean_ns = config->burst_off_ms * 1e6;
+        gen->mean_gap_ns *= gen->on_mean_ns / (gen->on_mean_ns + gen->off_mean_ns);
+        gen->on_end_ns = arrival_exponential(&gen->rng, gen->on_mean_ns);
+    }
+}
+
+// Intended time of the next arrival, ns after the start
+static double arrival_next(arrival_generator_t *gen)
+{
+    switch (gen->arrival) {
+        case ARRIVAL_CONSTANT:
+            gen->t_ns += gen->mean_gap_ns;
+            break;
+        
+        case ARRIVAL_POISSON:
+            gen->t_ns += arrival_exponential(&gen->rng, gen->mean_gap_ns);
+            break;
+        
+        case ARRIVAL_BURSTY:
+            // Poisson is memoryless, so a gap cut short by the end of an on
+            // period simply restarts at the beginning of the next one
+            for (;;) {
+                double gap = arrival_exponential(&gen->rng, gen->mean_gap_ns);
+                if (gen->t_ns + gap < gen->on_end_ns) {
+                    gen->t_ns += gap;
+                    break;
+                }
+                gen->t_ns = gen->on_end_ns + arrival_exponential(&gen->rng, gen->off_mean_ns);
+                gen->on_end_ns = gen->t_ns + arrival_exponential(&gen->rng, gen->on_mean_ns);
+            }
+            break;
+    }
+    
+    return gen->t_ns;
+}
+
+static void sleep_until_ns(uint64_t deadline_ns)
+{
+    struct timespec ts = {
+        .tv_sec = (time_t)(deadline_ns / 1000000000ULL),
+        .tv_nsec = (long)(deadline_ns % 1000000000ULL)
+    };
+    
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+// =============================================================================
+// Submitters
+// =============================================================================
+
+static void* load_submitter_worker(void *arg)
+{
+    load_submitter_t *sub = (load_submitter_t*)arg;
+    load_state_t *state = sub->state;
+    
+    // Host CPU cost of submission, including the queue wait
+    host_counter_group_t host_counters;
+    host_counters_open(&host_counters);
+    host_counters_start(&host_counters);
+    
+    for (;;) {
+        pthread_mutex_lock(&state->lock);
+        while (state->count == 0 && !state->done) {
+            pthread_cond_wait(&state->not_empty, &state->lock);
+        }
+        if (state->count == 0) {
+            pthread_mutex_unlock(&state->lock);
+            break;
+        }
+        uint64_t intended = state->queue[state->head];
+        state->head = (state->head + 1) % state->capacity;
+        state->count--;
+        pthread_mutex_unlock(&state->lock);
+        
+        uint64_t dispatch = get_timestamp_ns();
+        int rc = state->request(state->ctx, state->arg, sub->index);
+        uint64_t end = get_timestamp_ns();
+        
+        if (rc != 0) {
+            sub->errors++;
+        } else {
+            latency_histogram_record(&sub->response, end - intended);
+            latency_histogram_record(&sub->service, end - dispatch);
+            sub->completed++;
+        }
+        sub->last_completion_ns = end;
+    }
+    
+    host_counters_stop(&host_counters);
+    merge_host_counters(state->ctx, &host_counters.totals);
+    host_counters_close(&host_counters);
+    
+    return NULL;
+}
+
+// =============================================================================
+// Open-Loop Runs
+// =============================================================================
+
+load_generator_config_t create_default_load_config(double rate_per_sec, uint32_t submitters)
+{
+    load_generator_config_t config = {0};
+    
+    config.arrival = ARRIVAL_POISSON;
+    config.rate_per_sec = rate_per_sec;
+    config.duration_sec = 5.0;
+    config.submitters = submitters ? submitters : 1;
+    config.queue_depth = LOAD_DEFAULT_QUEUE_DEPTH;
+    config.burst_on_ms = 10.0;
+    config.burst_off_ms = 40.0;
+    config.seed = 12345;
+    
+    return config;
+}
+
+int run_open_loop_load(benchmark_context_t *ctx, const load_generator_config_t *config,
+                      load_request_function_t request, void *arg,
+                      load_generator_result_t *result)
+{
+    if (!ctx || !config || !request || !result || config->rate_per_sec <= 0 ||
+        config->duration_sec <= 0 || config->submitters == 0) {
+        return -1;
+    }
+    if (config->arrival == ARRIVAL_BURSTY && (config->burst_on_ms <= 0 || config->burst_off_ms < 0)) {
+        return -1;
+    }
+    
+    memset(result, 0, sizeof(*result));
+    latency_histogram_reset(&result->response);
+    latency_histogram_reset(&result->service);
+    
+    load_state_t state = {
+        .ctx = ctx,
+        .request = request,
+        .arg = arg,
+        .capacity = config->queue_depth ? config->queue_depth : LOAD_DEFAULT_QUEUE_DEPTH
+    };
+    
+    state.queue = malloc(state.capacity * sizeof(uint64_t));
+    load_submitter_t *subs = calloc(config->submitters, sizeof(load_submitter_t));
+    pthread_t *threads = malloc(config->submitters * sizeof(pthread_t));
+    
+    if (!state.queue || !subs || !threads) {
+        fprintf(stderr, "Failed to allocate load generator resources\n");
+        free(state.queue);
+        free(subs);
+        free(threads);
+        return -1;
+    }
+    
+    pthread_mutex_init(&state.lock, NULL);
+    pthread_cond_init(&state.not_empty, NULL);
+    
+    // Start submitters
+    uint32_t started = 0;
+    for (uint32_t i = 0; i < config->submitters; i++) {
+        subs[i].state = &state;
+        subs[i].index = i;
+        latency_histogram_reset(&subs[i].response);
+        latency_histogram_reset(&subs[i].service);
+        if (pthread_create(&threads[i], NULL, load_submitter_worker, &subs[i]) != 0) {
+            fprintf(stderr, "Failed to create submitter %u\n", i);
+            break;
+        }
+        started++;
+    }
+    
+    // Generate arrivals on schedule, independent of completions
+    arrival_generator_t gen;
+    arrival_generator_init(&gen, config);
+    
+    uint64_t start_ns = get_timestamp_ns() + 1000000; // Let submitters reach their wait
+    uint64_t window_ns = (uint64_t)(config->duration_sec * 1e9);
+    uint64_t max_lateness_ns = 0;
+    
+    while (started == config->submitters && !ctx->stop_requested) {
+        double offset = arrival_next(&gen);
+        if (offset >= (double)window_ns) {
+            break;
+        }
+        
+        uint64_t intended = start_ns + (uint64_t)offset;
+        sleep_until_ns(intended);
+        
+        uint64_t now = get_timestamp_ns();
+        if (now > intended && now - intended > max_lateness_ns) {
+            max_lateness_ns = now - intended;
+        }
+        
+        pthread_mutex_lock(&state.lock);
+        if (state.count == state.capacity) {
+            result->dropped++;
+        } else {
+            state.queue[(state.head + state.count) % state.capacity] = intended;
+            state.count++;
+            pthread_cond_signal(&state.not_empty);
+        }
+        result->arrivals++;
+        pthread_mutex_unlock(&state.lock);
+    }
+    
+    // Drain the queue and stop
+    pthread_mutex_lock(&state.lock);
+    state.done = true;
+    pthread_cond_broadcast(&state.not_empty);
+    pthread_mutex_unlock(&state.lock);
+    
+    uint64_t last_ns = start_ns + window_ns;
+    for (uint32_t i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+        latency_histogram_merge(&result->response, &subs[i].response);
+        latency_histogram_merge(&result->service, &subs[i].service);
+        result->completed += subs[i].completed;
+        result->errors += subs[i].errors;
+        if (subs[i].last_completion_ns > last_ns) {
+            last_ns = subs[i].last_completion_ns;
+        }
+    }
+    
+    result->offered_rate = (double)result->arrivals / config->duration_sec;
+    result->achieved_rate = (double)result->completed / ((double)(last_ns - start_ns) / 1e9);
+    result->max_lateness_ms = max_lateness_ns / 1e6;
+    calculate_histogram_statistics(&result->response, &result->metrics);
+    
+    pthread_cond_destroy(&state.not_empty);
+    pthread_mutex_destroy(&state.lock);
+    free(state.queue);
+    free(subs);
+    free(threads);
+    
+    return (started == config->submitters) ? 0 : -1;
+}
+
+int sweep_open_loop_load(benchmark_context_t *ctx, const load_generator_config_t *config,
+                        load_request_function_t request, void *arg,
+                        const double *rates, size_t count, FILE *csv)
+{
+    if (!config || !rates) {
+        return -1;
+    }
+    
+    load_generator_result_t *result = malloc(sizeof(load_generator_result_t));
+    if (!result) {
+        return -1;
+    }
+    
+    printf("Open-loop sweep: %s arrivals, %u submitters, %.1f s per point\n",
+           arrival_process_to_string(config->arrival), config->submitters, config->duration_sec);
+    printf("  %10s %10s %10s %10s %10s %10s %10s %8s\n",
+           "offered/s", "achieved/s", "p50 ms", "p99 ms", "p99.9 ms", "p99.99 ms", "max ms", "dropped");
+    if (csv) {
+        fprintf(csv, "arrival,offered_rate,achieved_rate,completed,errors,dropped,"
+                     "mean_ms,p50_ms,p90_ms,p99_ms,p999_ms,p9999_ms,max_ms,"
+                     "service_p50_ms,max_lateness_ms\n");
+    }
+    
+    int points = 0;
+    for (size_t i = 0; i < count && !ctx->stop_requested; i++) {
+        load_generator_config_t point = *config;
+        point.rate_per_sec = rates[i];
+        
+        if (run_open_loop_load(ctx, &point, request, arg, result) != 0) {
+            free(result);
+            return -1;
+        }
+        points++;
+        
+        const performance_metrics_t *m = &result->metrics;
+        printf("  %10.1f %10.1f %10.3f %10.3f %10.3f %10.3f %10.3f %8lu\n",
+               result->offered_rate, result->achieved_rate, m->latency_p50_ms,
+               m->latency_p99_ms, m->latency_p999_ms, m->latency_p9999_ms,
+               m->latency_max_ms, result->dropped);
+        if (csv) {
+            fprintf(csv, "%s,%.3f,%.3f,%lu,%lu,%lu,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f\n",
+                    arrival_process_to_string(point.arrival), result->offered_rate,
+                    result->achieved_rate, result->completed, result->errors, result->dropped,
+                    m->latency_ms, m->latency_p50_ms, m->latency_p90_ms, m->latency_p99_ms,
+                    m->latency_p999_ms, m->latency_p9999_ms, m->latency_max_ms,
+                    latency_histogram_percentile(&result->service, 50.0) / 1e6,
+                    result->max_lateness_ms);
+            fflush(csv);
+        }
+        
+        // Past saturation the queue only grows; further points add nothing
+        if (result->dropped > 0 || result->achieved_rate < 0.95 * result->offered_rate) {
+            printf("  Saturated at %.1f requests/s offered\n", result->offered_rate);
+            break;
+        }
+    }
+    
+    free(result);
+    return points;
+}
+
+const char* arrival_process_to_string(arrival_process_t arrival)
+{
+    switch (arrival) {
+        case ARRIVAL_CONSTANT: return "constant";
+        case ARRIVAL_POISSON: return "poisson";
+        case ARRIVAL_BURSTY: return "bursty";
+        default: return "unknown";
+    }
+}
+
+// =============================================================================
+// Open-Loop Latency Benchmark
+// =============================================================================
+
+#define OPEN_LOOP_MATRIX_DIM 32
+
+typedef struct {
+    int32_t *a;
+    int32_t *b;
+    int32_t *c;                  // One output per submitter
+    uint32_t submitters;
+} open_loop_matmul_t;
+
+static int open_loop_matmul_request(benchmark_context_t *ctx, void *arg, uint32_t submitter)
+{
+    open_loop_matmul_t *mm = (open_loop_matmul_t*)arg;
+    const uint32_t dim = OPEN_LOOP_MATRIX_DIM;
+    
+    npu_tensor_t a = npu_create_tensor(mm->a, 1, 1, dim, dim, NPU_DTYPE_INT32);
+    npu_tensor_t b = npu_create_tensor(mm->b, 1, 1, dim, dim, NPU_DTYPE_INT32);
+    npu_tensor_t c = npu_create_tensor(mm->c + (size_t)submitter * dim * dim, 1, 1, dim, dim,
+                                       NPU_DTYPE_INT32);
+    
+    return npu_matrix_multiply(ctx->npu_handle, &a, &b, &c) == NPU_SUCCESS ? 0 : -1;
+}
+
+int benchmark_open_loop_latency(benchmark_context_t *ctx)
+{
+    const benchmark_config_t *config = &ctx->config;
+    const size_t elements = OPEN_LOOP_MATRIX_DIM * OPEN_LOOP_MATRIX_DIM;
+    uint32_t submitters = config->thread_count ? config->thread_count : 1;
+    int ret = -1;
+    
+    printf("Running open-loop latency benchmark\n");
+    
+    open_loop_matmul_t mm = {
+        .a = malloc(elements * sizeof(int32_t)),
+        .b = malloc(elements * sizeof(int32_t)),
+        .c = calloc((size_t)submitters * elements, sizeof(int32_t)),
+        .submitters = submitters
+    };
+    
+    if (!mm.a || !mm.b || !mm.c) {
+        fprintf(stderr, "Failed to allocate open-loop matrices\n");
+        goto cleanup;
+    }
+    
+    for (size_t i = 0; i < elements; i++) {
+        mm.a[i] = (int32_t)(rand() % 16);
+        mm.b[i] = (int32_t)(rand() % 16);
+    }
+    
+    load_generator_config_t load = create_default_load_config(config->offered_rate, submitters);
+    load.arrival = config->arrival_process;
+    if (config->target_duration_sec > 0) {
+        load.duration_sec = config->target_duration_sec;
+    }
+    
+    double rates[LOAD_MAX_SWEEP_POINTS];
+    size_t rate_count = 0;
+    FILE *csv = NULL;
+    
+    if (config->offered_rate > 0) {
+        rates[rate_count++] = config->offered_rate;
+    } else {
+        // Closed-loop service time bounds what the submitters can sustain
+        uint32_t probes = config->iterations ? config->iterations : 100;
+        uint64_t start = get_timestamp_ns();
+        for (uint32_t i = 0; i < probes; i++) {
+            if (open_loop_matmul_request(ctx, &mm, 0) != 0) {
+                fprintf(stderr, "Capacity probe %u failed\n", i);
+                goto cleanup;
+            }
+        }
+        double service_sec = (double)(get_timestamp_ns() - start) / 1e9 / probes;
+        double capacity = submitters / service_sec;
+        
+        printf("Closed-loop service time %.3f ms, submitter capacity %.1f requests/s\n",
+               service_sec * 1e3, capacity);
+        
+        static const double load_fractions[] = {0.1, 0.25, 0.5, 0.7, 0.8, 0.9, 0.95, 1.0, 1.1, 1.2};
+        for (size_t i = 0; i < sizeof(load_fractions) / sizeof(load_fractions[0]); i++) {
+            rates[rate_count++] = load_fractions[i] * capacity;
+        }
+    }
+    
+    if (config->output_path[0] && !(csv = fopen(config->output_path, "w"))) {
+        fprintf(stderr, "Failed to open %s\n", config->output_path);
+    }
+    
+    ret = sweep_open_loop_load(ctx, &load, open_loop_matmul_request, &mm,
+                               rates, rate_count, csv) > 0 ? 0 : -1;
+    
+    if (csv) {
+        fclose(csv);
+        printf("Latency curve written to %s\n", config->output_path);
+    }
+    
+cleanup:
+    free(mm.a);
+    free(mm.b);
+    free(mm.c);
+    
+    return ret;
+}
@@ -0,0 +1,569 @@
+/**
+ * Model Inference Benchmark Implementation
+ * 
+ * End-to-end LeNet-5 and MLP throughput across batch sizes
+ * with a per-layer host/H2D/compute/D2H breakdown
+ */
+
+#include "benchmark_framework.h"
+#include <errno.h>
+
+// =============================================================================
+// Models
+// =============================================================================
+
+static const model_layer_t g_lenet_layers[] = {
+    { "conv1",          MODEL_OP_CONV,      6, 5 },
+    { "conv1_bias",     MODEL_OP_BIAS,      0, 0 },
+    { "conv1_relu",     MODEL_OP_RELU,      0, 0 },
+    { "pool1",          MODEL_OP_MAX_POOL,  0, 2 },
+    { "conv2",          MODEL_OP_CONV,     16, 5 },
+    { "conv2_bias",     MODEL_OP_BIAS,      0, 0 },
+    { "conv2_relu",     MODEL_OP_RELU,      0, 0 },
+    { "pool2",          MODEL_OP_MAX_POOL,  0, 2 },
+    { "fc1",            MODEL_OP_FC,      120, 0 },
+    { "fc1_bias",       MODEL_OP_BIAS,      0, 0 },
+    { "fc1_relu",       MODEL_OP_RELU,      0, 0 },
+    { "fc2",            MODEL_OP_FC,       84, 0 },
+    { "fc2_bias",       MODEL_OP_BIAS,      0, 0 },
+    { "fc2_relu",       MODEL_OP_RELU,      0, 0 },
+    { "output",         MODEL_OP_FC,       10, 0 },
+    { "output_bias",    MODEL_OP_BIAS,      0, 0 },
+    { "softmax",        MODEL_OP_SOFTMAX,   0, 0 },
+};
+
+static const model_layer_t g_mlp_layers[] = {
+    { "hidden",         MODEL_OP_FC,        4, 0 },
+    { "hidden_bias",    MODEL_OP_BIAS,      0, 0 },
+    { "hidden_sigmoid", MODEL_OP_SIGMOID,   0, 0 },
+    { "output",         MODEL_OP_FC,        1, 0 },
+    { "output_bias",    MODEL_OP_BIAS,      0, 0 },
+    { "output_sigmoid", MODEL_OP_SIGMOID,   0, 0 },
+};
+
+static const model_def_t g_models[] = {
+    { "cnn", "LeNet-5 CNN (examples/cnn_inference)", 1, 28, 28,
+      g_lenet_layers, sizeof(g_lenet_layers) / sizeof(g_lenet_layers[0]) },
+    { "mlp", "2-4-1 MLP (examples/neural_network)", 2, 1, 1,
+      g_mlp_layers, sizeof(g_mlp_layers) / sizeof(g_mlp_layers[0]) },
+};
+
+#define NUM_MODELS (sizeof(g_models) / sizeof(g_models[0]))
+#define MODEL_LOGIT_SCALE (1.0f / 256.0f)  // Fixed-point scale of the logits
+
+const char* model_op_to_string(model_op_t op)
+{
+    switch (op) {
+        case MODEL_OP_CONV: return "conv";
+        case MODEL_OP_MAX_POOL: return "max_pool";
+        case MODEL_OP_FC: return "fc";
+        case MODEL_OP_BIAS: return "bias";
+        case MODEL_OP_RELU: return "relu";
+        case MODEL_OP_SIGMOID: return "sigmoid";
+        case MODEL_OP_SOFTMAX: return "softmax";
+        default: return "unknown";
+    }
+}
+
+// =============================================================================
+// Model Instances
+// =============================================================================
+
+typedef struct {
+    uint32_t in_c, in_h, in_w;   // Per-image input shape
+    uint32_t c, h, w;            // Per-image output shape
+    int32_t *input;
+    int32_t *output;             // The input for in-place layers
+    int32_t *weights;            // Conv: [F, C, K, K]; FC: [in, out]
+    int32_t *bias;               // Per-feature bias repeated for every image
+    float *probabilities;        // Softmax output
+    bool owns_output;
+} model_layer_state_t;
+
+typedef struct {
+    const model_def_t *model;
+    uint32_t batch;
+    int32_t *input;
+    model_layer_state_t layers[MODEL_MAX_LAYERS];
+} model_instance_t;
+
+static size_t shape_elements(uint32_t c, uint32_t h, uint32_t w)
+{
+    return (size_t)c * h * w;
+}
+
+static int32_t* alloc_random(size_t count)
+{
+    int32_t *data = malloc(count * sizeof(int32_t));
+    
+    if (data) {
+        // Small values keep INT32 accumulations far from overflow
+        for (size_t i = 0; i < count; i++) {
+            data[i] = (rand() % 5) - 2;
+        }
+    }
+    return data;
+}
+
+static void destroy_model_instance(model_instance_t *inst)
+{
+    for (size_t l = 0; l < inst->model->layer_count; l++) {
+        model_layer_state_t *state = &inst->layers[l];
+        if (state->owns_output) {
+            free(state->output);
+        }
+        free(state->weights);
+        free(state->bias);
+        free(state->probabilities);
+    }
+    free(inst->input);
+}
+
+static int create_model_instance(model_instance_t *inst, const model_def_t *model, uint32_t batch)
+{
+    uint32_t c = model->in_c, h = model->in_h, w = model->in_w;
+    
+    memset(inst, 0, sizeof(*inst));
+    inst->model = model;
+    inst->batch = batch;
+    
+    if (model->layer_count > MODEL_MAX_LAYERS) {
+        return -1;
+    }
+    
+    inst->input = alloc_random(batch * shape_elements(c, h, w));
+    if (!inst->input) {
+        return -1;
+    }
+    
+    int32_t *input = inst->input;
+    for (size_t l = 0; l < model->layer_count; l++) {
+        const model_layer_t *layer = &model->layers[l];
+        model_layer_state_t *state = &inst->layers[l];
+        bool ok = true;
+    
+        state->in_c = c;
+        state->in_h = h;
+        state->in_w = w;
+        state->input = input;
+    
+        switch (layer->op) {
+            case MODEL_OP_CONV:
+                state->weights = alloc_random(shape_elements(layer->out_features, c, layer->kernel) *
+                                              layer->kernel);
+                c = layer->out_features;
+                h -= layer->kernel - 1;
+                w -= layer->kernel - 1;
+                ok = state->weights != NULL;
+                break;
+            case MODEL_OP_MAX_POOL:
+                h /= layer->kernel;
+                w /= layer->kernel;
+                break;
+            case MODEL_OP_FC:
+                state->weights = alloc_random(shape_elements(c, h, w) * layer->out_features);
+                c = layer->out_features;
+                h = 1;
+                w = 1;
+                ok = state->weights != NULL;
+                break;
+            case MODEL_OP_BIAS: {
+                // Repeat the per-feature bias for every image once, outside the timed loop
+                size_t features = shape_elements(c, h, w);
+                int32_t *bias = alloc_random(features);
+                state->bias = malloc(batch * features * sizeof(int32_t));
+                if (bias && state->bias) {
+                    for (uint32_t n = 0; n < batch; n++) {
+                        memcpy(state->bias + n * features, bias, features * sizeof(int32_t));
+                    }
+                }
+                ok = bias && state->bias;
+                free(bias);
+                break;
+            }
+            case MODEL_OP_SOFTMAX:
+                state->probabilities = malloc(batch * shape_elements(c, h, w) * sizeof(float));
+                ok = state->probabilities != NULL;
+                break;
+            default:
+                break;
+        }
+    
+        state->c = c;
+        state->h = h;
+        state->w = w;
+    
+        if (layer->op == MODEL_OP_CONV || layer->op == MODEL_OP_MAX_POOL || layer->op == MODEL_OP_FC) {
+            state->output = malloc(batch * shape_elements(c, h, w) * sizeof(int32_t));
+            state->owns_output = true;
+            ok = ok && state->output;
+        } else {
+            state->output = input;
+        }
+    
+        if (!ok || c == 0 || h == 0 || w == 0) {
+            destroy_model_instance(inst);
+            return -1;
+        }
+        input = state->output;
+    }
+    
+    return 0;
+}
+
+// =============================================================================
+// Execution
+// =============================================================================
+
+static int run_layer(npu_handle_t handle, const model_instance_t *inst, size_t index)
+{
+    const model_layer_t *layer = &inst->model->layers[index];
+    const model_layer_state_t *s = &inst->layers[index];
+    uint32_t batch = inst->batch;
+    size_t in_elements = shape_elements(s->in_c, s->in_h, s->in_w);
+    size_t out_elements = shape_elements(s->c, s->h, s->w);
+    int ret = NPU_SUCCESS;
+    
+    switch (layer->op) {
+        case MODEL_OP_CONV: {
+            npu_tensor_t w = npu_create_tensor(s->weights, s->c, s->in_c, layer->kernel, layer->kernel,
+                                               NPU_DTYPE_INT32);
+            for (uint32_t n = 0; n < batch && ret == NPU_SUCCESS; n++) {
+                npu_tensor_t x = npu_create_tensor(s->input + n * in_elements, 1, s->in_c, s->in_h,
+                                                   s->in_w, NPU_DTYPE_INT32);
+                npu_tensor_t y = npu_create_tensor(s->output + n * out_elements, 1, s->c, s->h, s->w,
+                                                   NPU_DTYPE_INT32);
+                ret = npu_conv2d(handle, &x, &w, &y, 1, 1, 0, 0);
+            }
+            return ret;
+        }
+        case MODEL_OP_MAX_POOL:
+            for (uint32_t n = 0; n < batch && ret == NPU_SUCCESS; n++) {
+                npu_tensor_t x = npu_create_tensor(s->input + n * in_elements, 1, s->in_c, s->in_h,
+                                                   s->in_w, NPU_DTYPE_INT32);
+                npu_tensor_t y = npu_create_tensor(s->output + n * out_elements, 1, s->c, s->h, s->w,
+                                                   NPU_DTYPE_INT32);
+                ret = npu_max_pool2d(handle, &x, &y, layer->kernel, layer->kernel,
+                                     layer->kernel, layer->kernel, 0, 0);
+            }
+            return ret;
+        case MODEL_OP_FC: {
+            npu_tensor_t x = npu_create_tensor(s->input, 1, 1, batch, in_elements, NPU_DTYPE_INT32);
+            npu_tensor_t w = npu_create_tensor(s->weights, 1, 1, in_elements, s->c, NPU_DTYPE_INT32);
+            npu_tensor_t y = npu_create_tensor(s->output, 1, 1, batch, s->c, NPU_DTYPE_INT32);
+            return npu_matrix_multiply(handle, &x, &w, &y);
+        }
+        case MODEL_OP_BIAS: {
+            npu_tensor_t x = npu_create_tensor(s->output, batch, s->c, s->h, s->w, NPU_DTYPE_INT32);
+            npu_tensor_t b = npu_create_tensor(s->bias, batch, s->c, s->h, s->w, NPU_DTYPE_INT32);
+            return npu_add(handle, &x, &b, &x);
+        }
+        case MODEL_OP_RELU: {
+            npu_tensor_t x = npu_create_tensor(s->output, batch, s->c, s->h, s->w, NPU_DTYPE_INT32);
+            return npu_relu(handle, &x, &x);
+        }
+        case MODEL_OP_SIGMOID: {
+            npu_tensor_t x = npu_create_tensor(s->output, batch, s->c, s->h, s->w, NPU_DTYPE_INT32);
+            return npu_sigmoid(handle, &x, &x);
+        }
+        case MODEL_OP_SOFTMAX:
+            for (uint32_t n = 0; n < batch && ret == NPU_SUCCESS; n++) {
+                float *p = s->probabilities + n * out_elements;
+                for (size_t i = 0; i < out_elements; i++) {
+                    p[i] = (float)s->input[n * out_elements + i] * MODEL_LOGIT_SCALE;
+                }
+                npu_tensor_t x = npu_create_tensor(p, 1, s->c, s->h, s->w, NPU_DTYPE_FLOAT32);
+                ret = npu_softmax(handle, &x, &x, 1);
+            }
+            return ret;
+        default:
+            return NPU_ERROR_INVALID;
+    }
+}
+
+static int run_inference(npu_handle_t handle, const model_instance_t *inst)
+{
+    for (size_t l = 0; l < inst->model->layer_count; l++) {
+        int ret = run_layer(handle, inst, l);
+        if (ret != NPU_SUCCESS) {
+            return ret;
+        }
+    }
+    return NPU_SUCCESS;
+}
+
+// Run every layer inside its own profiling session and add up its phases
+static int run_profiled_inference(npu_handle_t handle, const model_instance_t *inst,
+                                  model_layer_time_t *times)
+{
+    for (size_t l = 0; l < inst->model->layer_count; l++) {
+        npu_perf_profile_t profile;
+        bool profiled = npu_start_profiling(handle) == NPU_SUCCESS;
+    
+        uint64_t start = get_timestamp_ns();
+        int ret = run_layer(handle, inst, l);
+        uint64_t elapsed = get_timestamp_ns() - start;
+    
+        memset(&profile, 0, sizeof(profile));
+        if (profiled && npu_stop_profiling(handle, &profile) != NPU_SUCCESS) {
+            memset(&profile, 0, sizeof(profile));
+        }
+        if (ret != NPU_SUCCESS) {
+            return ret;
+        }
+    
+        double phases_ns = (double)(profile.stage_in_ns + profile.device_ns + profile.stage_out_ns);
+        times[l].total_us += elapsed / 1e3;
+        times[l].h2d_us += profile.stage_in_ns / 1e3;
+        times[l].compute_us += profile.device_ns / 1e3;
+        times[l].d2h_us += profile.stage_out_ns / 1e3;
+        times[l].host_prep_us += elapsed > phases_ns ? (elapsed - phases_ns) / 1e3 : 0.0;
+        times[l].h2d_bytes += profile.stage_in_bytes;
+        times[l].d2h_bytes += profile.stage_out_bytes;
+    }
+    return NPU_SUCCESS;
+}
+
+int run_model_batch(benchmark_context_t *ctx, const model_def_t *model, uint32_t batch,
+                   model_batch_result_t *result)
+{
+    uint32_t iterations = ctx->config.iterations ? ctx->config.iterations : 20;
+    model_instance_t inst;
+    int ret = NPU_SUCCESS;
+    
+    memset(result, 0, sizeof(*result));
+    result->batch = batch;
+    
+    if (create_model_instance(&inst, model, batch) != 0) {
+        fprintf(stderr, "Failed to allocate %s at batch %u\n", model->name, batch);
+        return -1;
+    }
+    
+    for (uint32_t i = 0; i < ctx->config.warmup_iterations && ret == NPU_SUCCESS; i++) {
+        ret = run_inference(ctx->npu_handle, &inst);
+    }
+    
+    // Throughput without the profiling sessions in the way
+    uint64_t start = get_timestamp_ns();
+    for (uint32_t i = 0; i < iterations && ret == NPU_SUCCESS; i++) {
+        ret = run_inference(ctx->npu_handle, &inst);
+    }
+    uint64_t elapsed = get_timestamp_ns() - start;
+    
+    for (uint32_t i = 0; i < iterations && ret == NPU_SUCCESS; i++) {
+        ret = run_profiled_inference(ctx->npu_handle, &inst, result->layers);
+    }
+    
+    destroy_model_instance(&inst);
+    
+    if (ret != NPU_SUCCESS || elapsed == 0) {
+        fprintf(stderr, "%s inference failed at batch %u: %d\n", model->name, batch, ret);
+        return -1;
+    }
+    
+    result->images_per_sec = (double)batch * iterations * 1e9 / (double)elapsed;
+    result->latency_ms = elapsed / 1e6 / iterations;
+    
+    for (size_t l = 0; l < model->layer_count; l++) {
+        model_layer_time_t *t = &result->layers[l];
+        t->host_prep_us /= iterations;
+        t->h2d_us /= iterations;
+        t->compute_us /= iterations;
+        t->d2h_us /= iterations;
+        t->total_us /= iterations;
+        t->h2d_bytes /= iterations;
+        t->d2h_bytes /= iterations;
+    }
+    
+    return 0;
+}
+
+// Operations of one image: two per MAC for conv and FC, one per element otherwise
+static double model_ops_per_image(const model_def_t *model)
+{
+    uint32_t c = model->in_c, h = model->in_h, w = model->in_w;
+    double ops = 0.0;
+    
+    for (size_t l = 0; l < model->layer_count; l++) {
+        const model_layer_t *layer = &model->layers[l];
+        double in_elements = (double)shape_elements(c, h, w);
+    
+        switch (layer->op) {
+            case MODEL_OP_CONV:
+                h -= layer->kernel - 1;
+                w -= layer->kernel - 1;
+                ops += 2.0 * shape_elements(layer->out_features, h, w) * c * layer->kernel * layer->kernel;
+                c = layer->out_features;
+                break;
+            case MODEL_OP_MAX_POOL:
+                ops += in_elements;
+                h /= layer->kernel;
+                w /= layer->kernel;
+                break;
+            case MODEL_OP_FC:
+                ops += 2.0 * in_elements * layer->out_features;
+                c = layer->out_features;
+                h = 1;
+                w = 1;
+                break;
+            default:
+                ops += in_elements;
+                break;
+        }
+    }
+    return ops;
+}
+
+// =============================================================================
+// Reporting
+// =============================================================================
+
+static void print_model_report(const model_def_t *model, const model_batch_result_t *results,
+                               size_t batch_count)
+{
+    const model_batch_result_t *largest = &results[batch_count - 1];
+    size_t order[MODEL_MAX_LAYERS];
+    double total = 0.0;
+    
+    printf("\n%s: %s\n", model->name, model->description);
+    printf("  %-6s %12s %12s\n", "Batch", "Images/s", "Batch ms");
+    for (size_t b = 0; b < batch_count; b++) {
+        printf("  %-6u %12.1f %12.3f\n", results[b].batch, results[b].images_per_sec,
+               results[b].latency_ms);
+    }
+    
+    for (size_t l = 0; l < model->layer_count; l++) {
+        total += largest->layers[l].total_us;
+        order[l] = l;
+    }
+    
+    printf("\n  Per-layer time at batch %u (us per inference):\n", largest->batch);
+    printf("  %-16s %-9s %10s %10s %10s %10s %10s %7s\n",
+           "Layer", "Op", "Host prep", "H2D", "Compute", "D2H", "Total", "Share");
+    for (size_t l = 0; l < model->layer_count; l++) {
+        const model_layer_time_t *t = &largest->layers[l];
+        printf("  %-16s %-9s %10.1f %10.1f %10.1f %10.1f %10.1f %6.1f%%\n",
+               model->layers[l].name, model_op_to_string(model->layers[l].op),
+               t->host_prep_us, t->h2d_us, t->compute_us, t->d2h_us, t->total_us,
+               total > 0 ? 100.0 * t->total_us / total : 0.0);
+    }
+    
+    // Selection sort of the layer indices by total time; there are few layers
+    for (size_t i = 0; i < model->layer_count; i++) {
+        for (size_t j = i + 1; j < model->layer_count; j++) {
+            if (largest->layers[order[j]].total_us > largest->layers[order[i]].total_us) {
+                size_t tmp = order[i];
+                order[i] = order[j];
+                order[j] = tmp;
+            }
+        }
+    }
+    
+    printf("\n  Top layers by time at batch %u:\n", largest->batch);
+    for (size_t i = 0; i < MODEL_TOP_LAYERS && i < model->layer_count; i++) {
+        const model_layer_time_t *t = &largest->layers[order[i]];
+        const char *phase = "compute";
+        double phase_us = t->compute_us;
+    
+        if (t->host_prep_us > phase_us) { phase = "host prep"; phase_us = t->host_prep_us; }
+        if (t->h2d_us > phase_us) { phase = "H2D"; phase_us = t->h2d_us; }
+        if (t->d2h_us > phase_us) { phase = "D2H"; phase_us = t->d2h_us; }
+    
+        printf("  %zu. %-16s %6.1f%%  (mostly %s)\n", i + 1, model->layers[order[i]].name,
+               total > 0 ? 100.0 * t->total_us / total : 0.0, phase);
+    }
+}
+
+int write_model_csv(const char *filename, const model_def_t *models,
+                   const model_batch_result_t *results, const size_t *batch_counts,
+                   size_t model_count)
+{
+    FILE *file = fopen(filename, "w");
+    if (!file) {
+        fprintf(stderr, "Failed to open %s: %s\n", filename, strerror(errno));
+        return -1;
+    }
+    
+    fprintf(file, "kind,model,batch,layer,op,images_per_sec,latency_ms,host_prep_us,h2d_us,"
+                  "compute_us,d2h_us,total_us,h2d_bytes,d2h_bytes\n");
+    
+    for (size_t m = 0; m < model_count; m++) {
+        for (size_t b = 0; b < batch_counts[m]; b++) {
+            const model_batch_result_t *r = &results[m * MODEL_MAX_BATCHES + b];
+    
+            fprintf(file, "throughput,%s,%u,,,%.2f,%.4f,,,,,,,\n",
+                    models[m].name, r->batch, r->images_per_sec, r->latency_ms);
+    
+            for (size_t l = 0; l < models[m].layer_count; l++) {
+                const model_layer_time_t *t = &r->layers[l];
+                fprintf(file, "layer,%s,%u,%s,%s,,,%.2f,%.2f,%.2f,%.2f,%.2f,%.0f,%.0f\n",
+                        models[m].name, r->batch, models[m].layers[l].name,
+                        model_op_to_string(models[m].layers[l].op),
+                        t->host_prep_us, t->h2d_us, t->compute_us, t->d2h_us, t->total_us,
+                        t->h2d_bytes, t->d2h_bytes);
+            }
+        }
+    }
+    
+    if (fclose(file) != 0) {
+        fprintf(stderr, "Failed to write %s: %s\n", filename, strerror(errno));
+        return -1;
+    }
+    
+    return 0;
+}
+
+// =============================================================================
+// Benchmark
+// =============================================================================
+
+int benchmark_model_inference(benchmark_context_t *ctx)
+{
+    performance_metrics_t *metrics = &ctx->result->metrics;
+    model_batch_result_t *results = calloc(NUM_MODELS * MODEL_MAX_BATCHES, sizeof(model_batch_result_t));
+    size_t batch_counts[NUM_MODELS] = {0};
+    uint64_t images = 0;
+    int ret = 0;
+    
+    if (!results) {
+        return -1;
+    }
+    
+    printf("Running model inference benchmark (%u inferences per batch size)\n",
+           ctx->config.iterations);
+    
+    for (size_t m = 0; m < NUM_MODELS; m++) {
+        for (uint32_t b = 0; b < MODEL_MAX_BATCHES; b++) {
+            model_batch_result_t *r = &results[m * MODEL_MAX_BATCHES + batch_counts[m]];
+            if (run_model_batch(ctx, &g_models[m], 1u << b, r) != 0) {
+                ret = -1;
+                break;
+            }
+            images += (uint64_t)r->batch * ctx->config.iterations * 2;
+            batch_counts[m]++;
+        }
+    
+        if (batch_counts[m] > 0) {
+            print_model_report(&g_models[m], &results[m * MODEL_MAX_BATCHES], batch_counts[m]);
+        }
+    }
+    
+    if (strlen(ctx->config.output_path) > 0 &&
+        write_model_csv(ctx->config.output_path, g_models, results, batch_counts, NUM_MODELS) == 0) {
+        printf("\nThroughput and per-layer times written to %s\n", ctx->config.output_path);
+    }
+    
+    // The CNN is what the throughput and latency figures describe
+    double best = 0.0;
+    for (size_t b = 0; b < batch_counts[0]; b++) {
+        if (results[b].images_per_sec > best) {
+            best = results[b].images_per_sec;
+        }
+    }
+    metrics->throughput_gops = best * model_ops_per_image(&g_models[0]) / 1e9;
+    metrics->latency_ms = batch_counts[0] > 0 ? results[0].latency_ms : 0.0;
+    metrics->operations_count = images;
+    
+    free(results);
+    return ret;
+}
@@ -0,0 +1,310 @@
+/**
+ * Benchmark Results Store Implementation
+ * 
+ * Per-run JSON results with every repetition of every metric,
+ * read by scripts/check_regression.py
+ */
+
+#include "benchmark_framework.h"
+#include <errno.h>
+#include <stddef.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+
+#ifndef BENCHMARK_GIT_COMMIT
+#define BENCHMARK_GIT_COMMIT "unknown"
+#endif
+
+// =============================================================================
+// Stored Metrics
+// =============================================================================
+
+typedef struct {
+    const char *name;
+    size_t offset;               // Offset of the double in performance_metrics_t
+    const char *unit;
+    const char *better;          // "higher" or "lower"
+} stored_metric_t;
+
+#define STORED_METRIC(field, unit, better) \
+    { #field, offsetof(performance_metrics_t, field), unit, better }
+
+// Metrics a regression check can judge. Counts and durations depend on the
+// configuration rather than on performance, so they are not stored.
+static const stored_metric_t g_stored_metrics[] = {
+    STORED_METRIC(throughput_gops,            "GOPS",    "higher"),
+    STORED_METRIC(throughput_gflops,          "GFLOPS",  "higher"),
+    STORED_METRIC(bandwidth_gbps,             "GB/s",    "higher"),
+    STORED_METRIC(efficiency_gops_watt,       "GOPS/W",  "higher"),
+    STORED_METRIC(latency_ms,                 "ms",      "lower"),
+    STORED_METRIC(latency_p50_ms,             "ms",      "lower"),
+    STORED_METRIC(latency_p90_ms,             "ms",      "lower"),
+    STORED_METRIC(latency_p99_ms,             "ms",      "lower"),
+    STORED_METRIC(latency_p999_ms,            "ms",      "lower"),
+    STORED_METRIC(power_watts,                "W",       "lower"),
+    STORED_METRIC(host_instructions_per_byte, "instr/B", "lower"),
+};
+
+#define NUM_STORED_METRICS (sizeof(g_stored_metrics) / sizeof(g_stored_metrics[0]))
+
+static double stored_metric_value(const performance_metrics_t *metrics, const stored_metric_t *metric)
+{
+    return *(const double *)((const char *)metrics + metric->offset);
+}
+
+// =============================================================================
+// Environment Fingerprint
+// =============================================================================
+
+static void read_first_line(const char *path, char *buffer, size_t size)
+{
+    buffer[0] = '\0';
+    
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return;
+    }
+    
+    if (fgets(buffer, (int)size, file)) {
+        buffer[strcspn(buffer, "\n")] = '\0';
+    }
+    fclose(file);
+}
+
+static void read_cpu_model(char *buffer, size_t size)
+{
+    char line[256];
+    
+    snprintf(buffer, size, "unknown");
+    
+    FILE *file = fopen("/proc/cpuinfo", "r");
+    if (!file) {
+        return;
+    }
+    
+    while (fgets(line, sizeof(line), file)) {
+        if (strncmp(line, "model name", 10) != 0) {
+            continue;
+        }
+    
+        char *value = strchr(line, ':');
+        if (value) {
+            value++;
+            value += strspn(value, " \t");
+            value[strcspn(value, "\n")] = '\0';
+            snprintf(buffer, size, "%s", value);
+        }
+        break;
+    }
+    fclose(file);
+}
+
+void collect_environment_fingerprint(npu_handle_t handle, environment_fingerprint_t *env)
+{
+    struct utsname uts;
+    
+    memset(env, 0, sizeof(*env));
+    
+    if (gethostname(env->hostname, sizeof(env->hostname) - 1) != 0) {
+        snprintf(env->hostname, sizeof(env->hostname), "unknown");
+    }
+    
+    if (uname(&uts) == 0) {
+        snprintf(env->kernel, sizeof(env->kernel), "%s", uts.release);
+        snprintf(env->machine, sizeof(env->machine), "%.*s",
+                 (int)sizeof(env->machine) - 1, uts.machine);
+    }
+    
+    read_cpu_model(env->cpu_model, sizeof(env->cpu_model));
+    env->cpu_count = (uint32_t)sysconf(_SC_NPROCESSORS_ONLN);
+    read_first_line("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor",
+                    env->cpu_governor, sizeof(env->cpu_governor));
+    
+#if defined(__clang__)
+    snprintf(env->compiler, sizeof(env->compiler), "clang %s", __clang_version__);
+#elif defined(__GNUC__)
+    snprintf(env->compiler, sizeof(env->compiler), "gcc %s", __VERSION__);
+#else
+    snprintf(env->compiler, sizeof(env->compiler), "unknown");
+#endif
+    
+#if defined(BENCHMARK_DEBUG)
+    snprintf(env->build_type, sizeof(env->build_type), "debug");
+#elif defined(BENCHMARK_PROFILE)
+    snprintf(env->build_type, sizeof(env->build_type), "profile");
+#else
+    snprintf(env->build_type, sizeof(env->build_type), "release");
+#endif
+    
+    snprintf(env->git_commit, sizeof(env->git_commit), "%s", BENCHMARK_GIT_COMMIT);
+    
+    if (handle) {
+        struct npu_device_info info = {0};
+        if (npu_get_device_info(handle, &info) == NPU_SUCCESS) {
+            snprintf(env->npu_board, sizeof(env->npu_board), "%.*s",
+                     (int)sizeof(info.board_name), info.board_name);
+            env->npu_pe_count = info.pe_count;
+            env->npu_core_count = info.core_count;
+            env->npu_max_frequency = info.max_frequency;
+        }
+    }
+}
+
+// =============================================================================
+// JSON Output
+// =============================================================================
+
+static void json_write_string(FILE *file, const char *value)
+{
+    fputc('"', file);
+    for (const unsigned char *p = (const unsigned char *)value; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            fprintf(file, "\\%c", *p);
+        } else if (*p < 0x20) {
+            fprintf(file, "\\u%04x", *p);
+        } else {
+            fputc(*p, file);
+        }
+    }
+    fputc('"', file);
+}
+
+static void json_write_field(FILE *file, const char *indent, const char *key,
+                             const char *value, bool last)
+{
+    fprintf(file, "%s\"%s\": ", indent, key);
+    json_write_string(file, value);
+    fprintf(file, "%s\n", last ? "" : ",");
+}
+
+static void write_environment(FILE *file, const environment_fingerprint_t *env)
+{
+    const char *in = "    ";
+    
+    fprintf(file, "  \"environment\": {\n");
+    json_write_field(file, in, "hostname", env->hostname, false);
+    json_write_field(file, in, "kernel", env->kernel, false);
+    json_write_field(file, in, "machine", env->machine, false);
+    json_write_field(file, in, "cpu_model", env->cpu_model, false);
+    fprintf(file, "%s\"cpu_count\": %u,\n", in, env->cpu_count);
+    json_write_field(file, in, "cpu_governor", env->cpu_governor, false);
+    json_write_field(file, in, "compiler", env->compiler, false);
+    json_write_field(file, in, "build_type", env->build_type, false);
+    json_write_field(file, in, "git_commit", env->git_commit, false);
+    json_write_field(file, in, "npu_board", env->npu_board, false);
+    fprintf(file, "%s\"npu_pe_count\": %u,\n", in, env->npu_pe_count);
+    fprintf(file, "%s\"npu_core_count\": %u,\n", in, env->npu_core_count);
+    fprintf(file, "%s\"npu_max_frequency\": %u\n", in, env->npu_max_frequency);
+    fprintf(file, "  },\n");
+}
+
+static void write_record(FILE *file, const benchmark_run_record_t *record, bool last)
+{
+    bool reported[NUM_STORED_METRICS] = {false};
+    size_t metric_count = 0;
+    
+    // A metric the benchmark never set reads zero in every repetition
+    for (size_t m = 0; m < NUM_STORED_METRICS; m++) {
+        for (uint32_t r = 0; r < record->repetitions; r++) {
+            if (stored_metric_value(&record->samples[r], &g_stored_metrics[m]) != 0.0) {
+                reported[m] = true;
+                metric_count++;
+                break;
+            }
+        }
+    }
+    
+    fprintf(file, "    ");
+    json_write_string(file, record->name);
+    fprintf(file, ": {\n");
+    fprintf(file, "      \"type\": ");
+    json_write_string(file, benchmark_type_to_string(record->type));
+    fprintf(file, ",\n      \"size\": ");
+    json_write_string(file, benchmark_size_to_string(record->size));
+    fprintf(file, ",\n      \"iterations\": %u,\n", record->iterations);
+    fprintf(file, "      \"threads\": %u,\n", record->thread_count);
+    fprintf(file, "      \"success\": %s,\n", record->success ? "true" : "false");
+    fprintf(file, "      \"repetitions\": %u,\n", record->repetitions);
+    fprintf(file, "      \"metrics\": {\n");
+    
+    for (size_t m = 0; m < NUM_STORED_METRICS; m++) {
+        const stored_metric_t *metric = &g_stored_metrics[m];
+        if (!reported[m]) {
+            continue;
+        }
+    
+        fprintf(file, "        \"%s\": {\"unit\": \"%s\", \"better\": \"%s\", \"samples\": [",
+                metric->name, metric->unit, metric->better);
+        for (uint32_t r = 0; r < record->repetitions; r++) {
+            fprintf(file, "%s%.9g", r ? ", " : "", stored_metric_value(&record->samples[r], metric));
+        }
+        fprintf(file, "]}%s\n", --metric_count ? "," : "");
+    }
+    
+    fprintf(file, "      }\n");
+    fprintf(file, "    }%s\n", last ? "" : ",");
+}
+
+int write_results_json(const char *filename, const environment_fingerprint_t *env,
+                      const benchmark_run_record_t *records, size_t count)
+{
+    char timestamp[32];
+    time_t now = time(NULL);
+    struct tm utc;
+    
+    FILE *file = fopen(filename, "w");
+    if (!file) {
+        fprintf(stderr, "Failed to open %s: %s\n", filename, strerror(errno));
+        return -1;
+    }
+    
+    gmtime_r(&now, &utc);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", &utc);
+    
+    fprintf(file, "{\n");
+    fprintf(file, "  \"schema_version\": %d,\n", RESULTS_SCHEMA_VERSION);
+    fprintf(file, "  \"timestamp\": \"%s\",\n", timestamp);
+    write_environment(file, env);
+    fprintf(file, "  \"benchmarks\": {\n");
+    for (size_t i = 0; i < count; i++) {
+        write_record(file, &records[i], i + 1 == count);
+    }
+    fprintf(file, "  }\n");
+    fprintf(file, "}\n");
+    
+    if (fclose(file) != 0) {
+        fprintf(stderr, "Failed to write %s: %s\n", filename, strerror(errno));
+        return -1;
+    }
+    
+    return 0;
+}
+
+int store_results_run(const char *store_dir, const environment_fingerprint_t *env,
+                     const benchmark_run_record_t *records, size_t count,
+                     char *path, size_t path_size)
+{
+    char filename[512];
+    char timestamp[32];
+    time_t now = time(NULL);
+    struct tm utc;
+    
+    if (mkdir(store_dir, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Failed to create results store %s: %s\n", store_dir, strerror(errno));
+        return -1;
+    }
+    
+    gmtime_r(&now, &utc);
+    strftime(timestamp, sizeof(timestamp), "%Y%m%dT%H%M%SZ", &utc);
+    snprintf(filename, sizeof(filename), "%s/%s-%s.json", store_dir, timestamp, env->hostname);
+    
+    if (write_results_json(filename, env, records, count) != 0) {
+        return -1;
+    }
+    
+    if (path) {
+        snprintf(path, path_size, "%s", filename);
+    }
+    
+    return 0;
+}
@@ -0,0 +1,620 @@
+/**
+ * Roofline Analysis Implementation
+ * 
+ * Arithmetic intensity and achieved GFLOP/s of operators against
+ * the device compute and bandwidth ceilings
+ */
+
+#include "benchmark_framework.h"
+#include <errno.h>
+
+// =============================================================================
+// Operator Shapes
+// =============================================================================
+
+#define ROOFLINE_ELEMENT_BYTES 4         // INT32 tensors
+#define ROOFLINE_COPY_BYTES (16u << 20)  // Largest DMA buffer; sets the measured link rate
+
+// The memory arbiter serves one 32-bit access per cycle to all cores
+#define ROOFLINE_MEM_PORT_BYTES_PER_CYCLE 4
+
+static const roofline_shape_t g_roofline_shapes[] = {
+    { ROOFLINE_OP_MATMUL, { 16, 16, 16, 0, 0 } },
+    { ROOFLINE_OP_MATMUL, { 64, 64, 64, 0, 0 } },
+    { ROOFLINE_OP_MATMUL, { 128, 128, 128, 0, 0 } },
+    { ROOFLINE_OP_MATMUL, { 256, 256, 256, 0, 0 } },
+    { ROOFLINE_OP_MATMUL, { 256, 1, 256, 0, 0 } },      // Matrix-vector
+    { ROOFLINE_OP_CONV2D, { 3, 32, 32, 16, 3 } },
+    { ROOFLINE_OP_CONV2D, { 16, 32, 32, 32, 3 } },
+    { ROOFLINE_OP_CONV2D, { 32, 16, 16, 64, 3 } },
+    { ROOFLINE_OP_CONV2D, { 64, 8, 8, 64, 1 } },        // Pointwise
+    { ROOFLINE_OP_ADD, { 4096, 0, 0, 0, 0 } },
+    { ROOFLINE_OP_ADD, { 262144, 0, 0, 0, 0 } },
+    { ROOFLINE_OP_MULTIPLY, { 262144, 0, 0, 0, 0 } },
+    { ROOFLINE_OP_RELU, { 262144, 0, 0, 0, 0 } },
+};
+
+#define NUM_ROOFLINE_SHAPES (sizeof(g_roofline_shapes) / sizeof(g_roofline_shapes[0]))
+
+const char* roofline_op_to_string(roofline_op_t op)
+{
+    switch (op) {
+        case ROOFLINE_OP_MATMUL: return "matmul";
+        case ROOFLINE_OP_CONV2D: return "conv2d";
+        case ROOFLINE_OP_ADD: return "add";
+        case ROOFLINE_OP_MULTIPLY: return "multiply";
+        case ROOFLINE_OP_RELU: return "relu";
+        default: return "unknown";
+    }
+}
+
+static void shape_to_string(const roofline_shape_t *shape, char *buffer, size_t size)
+{
+    const uint32_t *d = shape->dims;
+    
+    switch (shape->op) {
+        case ROOFLINE_OP_MATMUL:
+            snprintf(buffer, size, "matmul %ux%ux%u", d[0], d[1], d[2]);
+            break;
+        case ROOFLINE_OP_CONV2D:
+            snprintf(buffer, size, "conv2d %ux%ux%u->%u k%u", d[0], d[1], d[2], d[3], d[4]);
+            break;
+        default:
+            snprintf(buffer, size, "%s %u", roofline_op_to_string(shape->op), d[0]);
+            break;
+    }
+}
+
+void roofline_operator_cost(const roofline_shape_t *shape, double *flops, double *bytes)
+{
+    const double e = ROOFLINE_ELEMENT_BYTES;
+    double d[5];
+    
+    for (int i = 0; i < 5; i++) {
+        d[i] = shape->dims[i];
+    }
+    
+    switch (shape->op) {
+        case ROOFLINE_OP_MATMUL:
+            // C[M,N] = A[M,K] x B[K,N]
+            *flops = 2.0 * d[0] * d[1] * d[2];
+            *bytes = e * (d[0] * d[2] + d[2] * d[1] + d[0] * d[1]);
+            break;
+        case ROOFLINE_OP_CONV2D:
+            // Stride 1, same padding: output plane equals the input plane
+            *flops = 2.0 * d[3] * d[1] * d[2] * d[0] * d[4] * d[4];
+            *bytes = e * (d[0] * d[1] * d[2] + d[3] * d[0] * d[4] * d[4] + d[3] * d[1] * d[2]);
+            break;
+        case ROOFLINE_OP_ADD:
+        case ROOFLINE_OP_MULTIPLY:
+            *flops = d[0];
+            *bytes = e * 3.0 * d[0];
+            break;
+        case ROOFLINE_OP_RELU:
+            *flops = d[0];
+            *bytes = e * 2.0 * d[0];
+            break;
+        default:
+            *flops = 0.0;
+            *bytes = 0.0;
+            break;
+    }
+}
+
+// =============================================================================
+// Ceilings
+// =============================================================================
+
+static double pcie_lane_gbps(uint32_t generation)
+{
+    // Payload rate per lane after line coding, GB/s
+    switch (generation) {
+        case 1: return 0.25;
+        case 2: return 0.5;
+        case 3: return 0.985;
+        case 4: return 1.969;
+        case 5: return 3.938;
+        default: return 0.0;
+    }
+}
+
+static double measure_copy_gbps(npu_handle_t handle)
+{
+    npu_buffer_handle_t buffer = npu_buffer_alloc(handle, ROOFLINE_COPY_BYTES, NPU_ALLOC_COHERENT);
+    void *host = aligned_alloc(4096, ROOFLINE_COPY_BYTES);
+    double gbps = 0.0;
+    
+    if (buffer && host) {
+        memset(host, 0x5a, ROOFLINE_COPY_BYTES);
+        npu_buffer_write(handle, buffer, 0, host, ROOFLINE_COPY_BYTES);
+    
+        // One transfer to warm the path, then the timed pair
+        npu_dma_transfer(handle, buffer, 0, 0, ROOFLINE_COPY_BYTES, NPU_DMA_TO_DEVICE, 0);
+    
+        uint64_t start = get_timestamp_ns();
+        int rc = npu_dma_transfer(handle, buffer, 0, 0, ROOFLINE_COPY_BYTES, NPU_DMA_TO_DEVICE, 0);
+        rc |= npu_dma_transfer(handle, buffer, 0, 0, ROOFLINE_COPY_BYTES, NPU_DMA_FROM_DEVICE, 0);
+        uint64_t elapsed = get_timestamp_ns() - start;
+    
+        if (rc == NPU_SUCCESS && elapsed > 0) {
+            gbps = 2.0 * ROOFLINE_COPY_BYTES / (double)elapsed;
+        }
+    }
+    
+    free(host);
+    if (buffer) {
+        npu_buffer_free(handle, buffer);
+    }
+    
+    return gbps;
+}
+
+int measure_roofline_ceilings(benchmark_context_t *ctx, roofline_ceilings_t *ceilings)
+{
+    struct npu_device_info info = {0};
+    
+    memset(ceilings, 0, sizeof(*ceilings));
+    
+    if (npu_get_device_info(ctx->npu_handle, &info) != NPU_SUCCESS) {
+        fprintf(stderr, "Failed to read device information\n");
+        return -1;
+    }
+    
+    ceilings->frequency_mhz = info.max_frequency;
+    if (ceilings->frequency_mhz == 0) {
+        struct npu_performance_counters perf;
+        if (npu_get_comprehensive_perf_counters(ctx->npu_handle, &perf) == NPU_SUCCESS) {
+            ceilings->frequency_mhz = perf.frequency_mhz;
+        }
+    }
+    
+    uint32_t cores = info.core_count ? info.core_count : 1;
+    double hz = ceilings->frequency_mhz * 1e6;
+    
+    // Every PE retires one multiply-accumulate (2 FLOPs) per cycle
+    ceilings->peak_gflops = 2.0 * info.pe_count * cores * hz / 1e9;
+    ceilings->memory_gbps = ROOFLINE_MEM_PORT_BYTES_PER_CYCLE * hz / 1e9;
+    ceilings->pcie_theoretical_gbps = pcie_lane_gbps(info.pcie_generation) * info.pcie_lanes;
+    ceilings->pcie_measured_gbps = measure_copy_gbps(ctx->npu_handle);
+    
+    if (ceilings->peak_gflops <= 0.0) {
+        fprintf(stderr, "Device reports no PEs or clock; no compute ceiling\n");
+        return -1;
+    }
+    
+    return 0;
+}
+
+// =============================================================================
+// Measurement
+// =============================================================================
+
+typedef struct {
+    int32_t *a;
+    int32_t *b;
+    int32_t *c;
+} roofline_buffers_t;
+
+static int run_operator(npu_handle_t handle, const roofline_shape_t *shape,
+                        const roofline_buffers_t *buf)
+{
+    const uint32_t *d = shape->dims;
+    
+    switch (shape->op) {
+        case ROOFLINE_OP_MATMUL: {
+            npu_tensor_t a = npu_create_tensor(buf->a, 1, 1, d[0], d[2], NPU_DTYPE_INT32);
+            npu_tensor_t b = npu_create_tensor(buf->b, 1, 1, d[2], d[1], NPU_DTYPE_INT32);
+            npu_tensor_t c = npu_create_tensor(buf->c, 1, 1, d[0], d[1], NPU_DTYPE_INT32);
+            return npu_matrix_multiply(handle, &a, &b, &c);
+        }
+        case ROOFLINE_OP_CONV2D: {
+            npu_tensor_t in = npu_create_tensor(buf->a, 1, d[0], d[1], d[2], NPU_DTYPE_INT32);
+            npu_tensor_t w = npu_create_tensor(buf->b, d[3], d[0], d[4], d[4], NPU_DTYPE_INT32);
+            npu_tensor_t out = npu_create_tensor(buf->c, 1, d[3], d[1], d[2], NPU_DTYPE_INT32);
+            return npu_conv2d(handle, &in, &w, &out, 1, 1, d[4] / 2, d[4] / 2);
+        }
+        case ROOFLINE_OP_ADD:
+        case ROOFLINE_OP_MULTIPLY: {
+            npu_tensor_t a = npu_create_tensor(buf->a, 1, 1, 1, d[0], NPU_DTYPE_INT32);
+            npu_tensor_t b = npu_create_tensor(buf->b, 1, 1, 1, d[0], NPU_DTYPE_INT32);
+            npu_tensor_t c = npu_create_tensor(buf->c, 1, 1, 1, d[0], NPU_DTYPE_INT32);
+            return shape->op == ROOFLINE_OP_ADD ? npu_add(handle, &a, &b, &c) :
+                                                  npu_multiply(handle, &a, &b, &c);
+        }
+        case ROOFLINE_OP_RELU: {
+            npu_tensor_t in = npu_create_tensor(buf->a, 1, 1, 1, d[0], NPU_DTYPE_INT32);
+            npu_tensor_t out = npu_create_tensor(buf->c, 1, 1, 1, d[0], NPU_DTYPE_INT32);
+            return npu_relu(handle, &in, &out);
+        }
+        default:
+            return NPU_ERROR_INVALID;
+    }
+}
+
+static size_t operator_elements(const roofline_shape_t *shape, int operand)
+{
+    const uint32_t *d = shape->dims;
+    
+    switch (shape->op) {
+        case ROOFLINE_OP_MATMUL:
+            return operand == 0 ? (size_t)d[0] * d[2] :
+                   operand == 1 ? (size_t)d[2] * d[1] : (size_t)d[0] * d[1];
+        case ROOFLINE_OP_CONV2D:
+            return operand == 0 ? (size_t)d[0] * d[1] * d[2] :
+                   operand == 1 ? (size_t)d[3] * d[0] * d[4] * d[4] : (size_t)d[3] * d[1] * d[2];
+        default:
+            return d[0];
+    }
+}
+
+// Place a measurement under the ceilings: the lowest roof at its intensity binds
+static void classify_point(const roofline_ceilings_t *ceilings, roofline_point_t *point)
+{
+    double attainable = ceilings->peak_gflops;
+    point->bound = "compute";
+    
+    if (ceilings->pcie_measured_gbps > 0 &&
+        point->intensity * ceilings->pcie_measured_gbps < attainable) {
+        attainable = point->intensity * ceilings->pcie_measured_gbps;
+        point->bound = "pcie";
+    }
+    if (ceilings->memory_gbps > 0 &&
+        point->intensity * ceilings->memory_gbps < attainable) {
+        attainable = point->intensity * ceilings->memory_gbps;
+        point->bound = "memory";
+    }
+    
+    point->attainable_gflops = attainable;
+    point->efficiency = attainable > 0 ? point->gflops / attainable : 0.0;
+}
+
+int measure_roofline_point(benchmark_context_t *ctx, const roofline_shape_t *shape,
+                           const roofline_ceilings_t *ceilings, roofline_point_t *point)
+{
+    uint32_t iterations = ctx->config.iterations ? ctx->config.iterations : 10;
+    roofline_buffers_t buf = {
+        .a = calloc(operator_elements(shape, 0), sizeof(int32_t)),
+        .b = calloc(operator_elements(shape, 1), sizeof(int32_t)),
+        .c = calloc(operator_elements(shape, 2), sizeof(int32_t))
+    };
+    int ret = -1;
+    
+    memset(point, 0, sizeof(*point));
+    point->shape = *shape;
+    shape_to_string(shape, point->label, sizeof(point->label));
+    roofline_operator_cost(shape, &point->flops, &point->bytes);
+    point->intensity = point->bytes > 0 ? point->flops / point->bytes : 0.0;
+    
+    if (!buf.a || !buf.b || !buf.c) {
+        fprintf(stderr, "%s: failed to allocate operands\n", point->label);
+        goto cleanup;
+    }
+    
+    for (size_t i = 0; i < operator_elements(shape, 0); i++) buf.a[i] = (int32_t)(rand() % 16) - 8;
+    for (size_t i = 0; i < operator_elements(shape, 1); i++) buf.b[i] = (int32_t)(rand() % 16) - 8;
+    
+    for (uint32_t i = 0; i < ctx->config.warmup_iterations; i++) {
+        run_operator(ctx->npu_handle, shape, &buf);
+    }
+    
+    struct npu_performance_counters before = {0}, after = {0};
+    bool have_counters =
+        npu_get_comprehensive_perf_counters(ctx->npu_handle, &before) == NPU_SUCCESS;
+    
+    uint64_t start = get_timestamp_ns();
+    for (uint32_t i = 0; i < iterations; i++) {
+        if (run_operator(ctx->npu_handle, shape, &buf) != NPU_SUCCESS) {
+            fprintf(stderr, "%s: operator failed\n", point->label);
+            goto cleanup;
+        }
+    }
+    uint64_t elapsed = get_timestamp_ns() - start;
+    
+    have_counters = have_counters &&
+        npu_get_comprehensive_perf_counters(ctx->npu_handle, &after) == NPU_SUCCESS;
+    
+    point->time_ms = (double)elapsed / 1e6 / iterations;
+    point->gflops = point->flops * iterations / (double)elapsed;
+    point->gbps = point->bytes * iterations / (double)elapsed;
+    
+    // Device-side view: cycles and memory-port traffic, when the counters run
+    if (have_counters && ceilings->frequency_mhz > 0) {
+        uint64_t cycles = after.counters[NPU_PERF_CYCLES] - before.counters[NPU_PERF_CYCLES];
+        uint64_t accesses = (after.counters[NPU_PERF_MEMORY_READS] -
+                             before.counters[NPU_PERF_MEMORY_READS]) +
+                            (after.counters[NPU_PERF_MEMORY_WRITES] -
+                             before.counters[NPU_PERF_MEMORY_WRITES]);
+    
+        if (cycles > 0) {
+            double device_ns = (double)cycles * 1e3 / ceilings->frequency_mhz;
+            point->device_gflops = point->flops * iterations / device_ns;
+        }
+        if (accesses > 0) {
+            point->device_bytes = (double)accesses * ROOFLINE_MEM_PORT_BYTES_PER_CYCLE / iterations;
+            point->device_intensity = point->flops / point->device_bytes;
+        }
+    }
+    
+    classify_point(ceilings, point);
+    ret = 0;
+    
+cleanup:
+    free(buf.a);
+    free(buf.b);
+    free(buf.c);
+    
+    return ret;
+}
+
+// =============================================================================
+// Report
+// =============================================================================
+
+#define SVG_WIDTH 760
+#define SVG_HEIGHT 480
+#define SVG_LEFT 70
+#define SVG_RIGHT 20
+#define SVG_TOP 20
+#define SVG_BOTTOM 50
+
+typedef struct {
+    double x_min, x_max;         // Decades of intensity
+    double y_min, y_max;         // Decades of GFLOP/s
+} svg_axes_t;
+
+static double svg_x(const svg_axes_t *ax, double intensity)
+{
+    double f = (log10(intensity) - ax->x_min) / (ax->x_max - ax->x_min);
+    return SVG_LEFT + f * (SVG_WIDTH - SVG_LEFT - SVG_RIGHT);
+}
+
+static double svg_y(const svg_axes_t *ax, double gflops)
+{
+    double f = (log10(gflops) - ax->y_min) / (ax->y_max - ax->y_min);
+    return SVG_HEIGHT - SVG_BOTTOM - f * (SVG_HEIGHT - SVG_TOP - SVG_BOTTOM);
+}
+
+static const char* op_color(roofline_op_t op)
+{
+    switch (op) {
+        case ROOFLINE_OP_MATMUL: return "#1f77b4";
+        case ROOFLINE_OP_CONV2D: return "#2ca02c";
+        case ROOFLINE_OP_ADD: return "#ff7f0e";
+        case ROOFLINE_OP_MULTIPLY: return "#d62728";
+        case ROOFLINE_OP_RELU: return "#9467bd";
+        default: return "#7f7f7f";
+    }
+}
+
+// Bandwidth roof: sloped up to its ridge point, then the compute roof
+static void svg_roof(FILE *f, const svg_axes_t *ax, double peak, double gbps,
+                     const char *color, const char *label)
+{
+    double x0 = pow(10.0, ax->x_min);
+    double x1 = pow(10.0, ax->x_max);
+    double ridge = peak / gbps;
+    double y0 = fmax(gbps * x0, pow(10.0, ax->y_min));
+    
+    x0 = y0 / gbps;
+    fprintf(f, "<polyline fill=\"none\" stroke=\"%s\" stroke-width=\"2\" points=\"%.1f,%.1f %.1f,%.1f %.1f,%.1f\"/>\n",
+            color, svg_x(ax, x0), svg_y(ax, y0), svg_x(ax, ridge), svg_y(ax, peak),
+            svg_x(ax, x1), svg_y(ax, peak));
+    fprintf(f, "<text x=\"%.1f\" y=\"%.1f\" font-size=\"11\" fill=\"%s\">%s %.2f GB/s</text>\n",
+            svg_x(ax, x0) + 4, svg_y(ax, y0) - 6, color, label, gbps);
+}
+
+static void write_svg(FILE *f, const roofline_ceilings_t *c, const roofline_point_t *points,
+                      size_t count)
+{
+    double x_lo = 1e30, x_hi = 0, y_lo = c->peak_gflops, y_hi = c->peak_gflops;
+    double roofs[3] = { c->memory_gbps, c->pcie_measured_gbps, c->pcie_theoretical_gbps };
+    
+    for (int i = 0; i < 3; i++) {
+        if (roofs[i] > 0) {
+            x_hi = fmax(x_hi, c->peak_gflops / roofs[i]);
+            x_lo = fmin(x_lo, c->peak_gflops / roofs[i]);
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (points[i].intensity > 0) {
+            x_lo = fmin(x_lo, points[i].intensity);
+            x_hi = fmax(x_hi, points[i].intensity);
+        }
+        if (points[i].gflops > 0) y_lo = fmin(y_lo, points[i].gflops);
+        if (points[i].device_gflops > 0) y_lo = fmin(y_lo, points[i].device_gflops);
+    }
+    if (x_hi <= 0) {
+        x_lo = 0.1;
+        x_hi = 100.0;
+    }
+    
+    svg_axes_t ax = {
+        .x_min = floor(log10(x_lo)) - 0.5, .x_max = ceil(log10(x_hi)) + 0.5,
+        .y_min = floor(log10(y_lo)) - 0.5, .y_max = ceil(log10(y_hi)) + 0.3
+    };
+    
+    fprintf(f, "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\" font-family=\"sans-serif\">\n",
+            SVG_WIDTH, SVG_HEIGHT);
+    fprintf(f, "<rect x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\" fill=\"#fafafa\" stroke=\"#999\"/>\n",
+            SVG_LEFT, SVG_TOP, SVG_WIDTH - SVG_LEFT - SVG_RIGHT, SVG_HEIGHT - SVG_TOP - SVG_BOTTOM);
+    
+    // Decade grid
+    for (int d = (int)ceil(ax.x_min); d <= (int)floor(ax.x_max); d++) {
+        double x = svg_x(&ax, pow(10.0, d));
+        fprintf(f, "<line x1=\"%.1f\" y1=\"%d\" x2=\"%.1f\" y2=\"%d\" stroke=\"#ddd\"/>\n",
+                x, SVG_TOP, x, SVG_HEIGHT - SVG_BOTTOM);
+        fprintf(f, "<text x=\"%.1f\" y=\"%d\" font-size=\"11\" text-anchor=\"middle\">%g</text>\n",
+                x, SVG_HEIGHT - SVG_BOTTOM + 15, pow(10.0, d));
+    }
+    for (int d = (int)ceil(ax.y_min); d <= (int)floor(ax.y_max); d++) {
+        double y = svg_y(&ax, pow(10.0, d));
+        fprintf(f, "<line x1=\"%d\" y1=\"%.1f\" x2=\"%d\" y2=\"%.1f\" stroke=\"#ddd\"/>\n",
+                SVG_LEFT, y, SVG_WIDTH - SVG_RIGHT, y);
+        fprintf(f, "<text x=\"%d\" y=\"%.1f\" font-size=\"11\" text-anchor=\"end\">%g</text>\n",
+                SVG_LEFT - 5, y + 4, pow(10.0, d));
+    }
+    fprintf(f, "<text x=\"%d\" y=\"%d\" font-size=\"12\" text-anchor=\"middle\">Arithmetic intensity (FLOP/byte)</text>\n",
+            (SVG_WIDTH + SVG_LEFT) / 2, SVG_HEIGHT - 12);
+    fprintf(f, "<text x=\"15\" y=\"%d\" font-size=\"12\" text-anchor=\"middle\" transform=\"rotate(-90 15 %d)\">GFLOP/s</text>\n",
+            SVG_HEIGHT / 2, SVG_HEIGHT / 2);
+    
+    // Ceilings
+    fprintf(f, "<text x=\"%d\" y=\"%.1f\" font-size=\"11\" text-anchor=\"end\">Peak %.2f GFLOP/s</text>\n",
+            SVG_WIDTH - SVG_RIGHT - 4, svg_y(&ax, c->peak_gflops) - 6, c->peak_gflops);
+    if (c->memory_gbps > 0) {
+        svg_roof(f, &ax, c->peak_gflops, c->memory_gbps, "#555", "Memory port");
+    }
+    if (c->pcie_theoretical_gbps > 0) {
+        svg_roof(f, &ax, c->peak_gflops, c->pcie_theoretical_gbps, "#aaa", "PCIe link");
+    }
+    if (c->pcie_measured_gbps > 0) {
+        svg_roof(f, &ax, c->peak_gflops, c->pcie_measured_gbps, "#000", "PCIe measured");
+    }
+    
+    // Measurements: filled end to end, hollow from device cycles
+    for (size_t i = 0; i < count; i++) {
+        const roofline_point_t *p = &points[i];
+        const char *color = op_color(p->shape.op);
+        if (p->intensity <= 0 || p->gflops <= 0) {
+            continue;
+        }
+        fprintf(f, "<circle cx=\"%.1f\" cy=\"%.1f\" r=\"5\" fill=\"%s\"><title>%s: %.1f FLOP/B, %.3f GFLOP/s (%s-bound)</title></circle>\n",
+                svg_x(&ax, p->intensity), svg_y(&ax, p->gflops), color,
+                p->label, p->intensity, p->gflops, p->bound);
+        if (p->device_gflops > 0) {
+            fprintf(f, "<circle cx=\"%.1f\" cy=\"%.1f\" r=\"5\" fill=\"none\" stroke=\"%s\" stroke-width=\"1.5\"><title>%s: %.3f GFLOP/s device time</title></circle>\n",
+                    svg_x(&ax, p->intensity), svg_y(&ax, p->device_gflops), color,
+                    p->label, p->device_gflops);
+        }
+    }
+    
+    // Legend
+    for (int op = 0; op < ROOFLINE_OP_COUNT; op++) {
+        int y = SVG_TOP + 16 + op * 16;
+        fprintf(f, "<circle cx=\"%d\" cy=\"%d\" r=\"5\" fill=\"%s\"/>\n",
+                SVG_LEFT + 14, y - 4, op_color((roofline_op_t)op));
+        fprintf(f, "<text x=\"%d\" y=\"%d\" font-size=\"11\">%s</text>\n",
+                SVG_LEFT + 24, y, roofline_op_to_string((roofline_op_t)op));
+    }
+    
+    fprintf(f, "</svg>\n");
+}
+
+int write_roofline_report(const char *csv_path, const char *html_path,
+                          const roofline_ceilings_t *ceilings,
+                          const roofline_point_t *points, size_t count)
+{
+    if (csv_path) {
+        FILE *csv = fopen(csv_path, "w");
+        if (!csv) {
+            fprintf(stderr, "Failed to open %s: %s\n", csv_path, strerror(errno));
+            return -1;
+        }
+    
+        fprintf(csv, "operator,flops,bytes,intensity,time_ms,gflops,gbps,device_gflops,"
+                     "device_bytes,device_intensity,attainable_gflops,efficiency,bound\n");
+        for (size_t i = 0; i < count; i++) {
+            const roofline_point_t *p = &points[i];
+            fprintf(csv, "%s,%.0f,%.0f,%.4f,%.4f,%.4f,%.4f,%.4f,%.0f,%.4f,%.4f,%.4f,%s\n",
+                    p->label, p->flops, p->bytes, p->intensity, p->time_ms, p->gflops, p->gbps,
+                    p->device_gflops, p->device_bytes, p->device_intensity,
+                    p->attainable_gflops, p->efficiency, p->bound);
+        }
+        fclose(csv);
+    }
+    
+    if (html_path) {
+        FILE *html = fopen(html_path, "w");
+        if (!html) {
+            fprintf(stderr, "Failed to open %s: %s\n", html_path, strerror(errno));
+            return -1;
+        }
+    
+        fprintf(html, "<!DOCTYPE html>\n<html>\n<head>\n<meta charset=\"utf-8\">\n"
+                      "<title>NPU Roofline</title>\n<style>\n"
+                      "body { font-family: sans-serif; margin: 2em; }\n"
+                      "table { border-collapse: collapse; }\n"
+                      "td, th { border: 1px solid #ccc; padding: 3px 8px; text-align: right; }\n"
+                      "td:first-child, th:first-child { text-align: left; }\n"
+                      "</style>\n</head>\n<body>\n<h1>NPU Roofline</h1>\n");
+    
+        fprintf(html, "<h2>Ceilings</h2>\n<table>\n");
+        fprintf(html, "<tr><td>Compute peak</td><td>%.2f GFLOP/s</td></tr>\n", ceilings->peak_gflops);
+        fprintf(html, "<tr><td>Memory port</td><td>%.2f GB/s</td></tr>\n", ceilings->memory_gbps);
+        fprintf(html, "<tr><td>PCIe link</td><td>%.2f GB/s</td></tr>\n", ceilings->pcie_theoretical_gbps);
+        fprintf(html, "<tr><td>PCIe measured</td><td>%.2f GB/s</td></tr>\n", ceilings->pcie_measured_gbps);
+        fprintf(html, "<tr><td>Clock</td><td>%u MHz</td></tr>\n", ceilings->frequency_mhz);
+        fprintf(html, "</table>\n");
+    
+        fprintf(html, "<h2>Chart</h2>\n<p>Filled: end-to-end time. Hollow: device cycles.</p>\n");
+        write_svg(html, ceilings, points, count);
+    
+        fprintf(html, "<h2>Operators</h2>\n<table>\n<tr><th>Operator</th><th>FLOP/B</th>"
+                      "<th>Time (ms)</th><th>GFLOP/s</th><th>GB/s</th><th>Device GFLOP/s</th>"
+                      "<th>Attainable</th><th>Efficiency</th><th>Bound</th></tr>\n");
+        for (size_t i = 0; i < count; i++) {
+            const roofline_point_t *p = &points[i];
+            fprintf(html, "<tr><td>%s</td><td>%.2f</td><td>%.4f</td><td>%.3f</td><td>%.3f</td>"
+                          "<td>%.3f</td><td>%.3f</td><td>%.1f%%</td><td>%s</td></tr>\n",
+                    p->label, p->intensity, p->time_ms, p->gflops, p->gbps, p->device_gflops,
+                    p->attainable_gflops, p->efficiency * 100.0, p->bound);
+        }
+        fprintf(html, "</table>\n</body>\n</html>\n");
+        fclose(html);
+    }
+    
+    return 0;
+}
+
+// =============================================================================
+// Roofline Benchmark
+// =============================================================================
+
+int benchmark_roofline(benchmark_context_t *ctx)
+{
+    roofline_ceilings_t ceilings;
+    roofline_point_t points[NUM_ROOFLINE_SHAPES];
+    size_t count = 0;
+    
+    printf("Running roofline analysis\n");
+    
+    if (measure_roofline_ceilings(ctx, &ceilings) != 0) {
+        return -1;
+    }
+    
+    printf("Ceilings: %.2f GFLOP/s peak, memory port %.2f GB/s, PCIe %.2f GB/s (measured %.2f)\n",
+           ceilings.peak_gflops, ceilings.memory_gbps, ceilings.pcie_theoretical_gbps,
+           ceilings.pcie_measured_gbps);
+    printf("%-28s %9s %11s %11s %11s %8s %s\n",
+           "Operator", "FLOP/B", "GFLOP/s", "GB/s", "Attainable", "Eff.", "Bound");
+    
+    for (size_t i = 0; i < NUM_ROOFLINE_SHAPES; i++) {
+        roofline_point_t *p = &points[count];
+        if (measure_roofline_point(ctx, &g_roofline_shapes[i], &ceilings, p) != 0) {
+            continue;
+        }
+        printf("%-28s %9.2f %11.3f %11.3f %11.3f %7.1f%% %s\n",
+               p->label, p->intensity, p->gflops, p->gbps, p->attainable_gflops,
+               p->efficiency * 100.0, p->bound);
+        count++;
+    }
+    
+    if (count == 0) {
+        return -1;
+    }
+    
+    if (strlen(ctx->config.output_path) > 0) {
+        char html_path[sizeof(ctx->config.output_path) + 8];
+        snprintf(html_path, sizeof(html_path), "%s", ctx->config.output_path);
+        char *ext = strrchr(html_path, '.');
+        snprintf(ext ? ext : html_path + strlen(html_path),
+                 sizeof(html_path) - (size_t)((ext ? ext : html_path + strlen(html_path)) - html_path),
+                 ".html");
+    
+        if (write_roofline_report(ctx->config.output_path, html_path, &ceilings, points, count) == 0) {
+            printf("Roofline written to %s and %s\n", ctx->config.output_path, html_path);
+        }
+    }
+    
+    return count == NUM_ROOFLINE_SHAPES ? 0 : -1;
+}
@@ -48,11 +48,16 @@ void* multithreaded_matmul_worker(void *arg)
     initialize_matrix_random(matrix_a, matrix_dim, matrix_dim);
     initialize_matrix_random(matrix_b, matrix_dim, matrix_dim);
     
+    // Host CPU counters of this worker
+    host_counter_group_t host_counters;
+    host_counters_open(&host_counters);
+    
     // Wait for all threads to be ready
     pthread_barrier_wait(tctx->start_barrier);
     
     struct timespec start_time, end_time;
     clock_gettime(CLOCK_MONOTONIC, &start_time);
+    host_counters_start(&host_counters);
     
     uint64_t operations_performed = 0;
     
@@ -68,8 +73,12 @@ void* multithreaded_matmul_worker(void *arg)
         }
     }
     
+    host_counters_stop(&host_counters);
     clock_gettime(CLOCK_MONOTONIC, &end_time);
     
+    merge_host_counters(ctx, &host_counters.totals);
+    host_counters_close(&host_counters);
+    
     // Calculate thread metrics
     double duration = calculate_duration_seconds(start_time, end_time);
     tctx->thread_metrics.duration_seconds = duration;
@@ -320,11 +329,16 @@ void* concurrent_mixed_workload_worker(void *arg)
     initialize_matrix_random(matrix_a, matrix_dim, matrix_dim);
     initialize_matrix_random(matrix_b, matrix_dim, matrix_dim);
     
+    // Host CPU counters of this worker
+    host_counter_group_t host_counters;
+    host_counters_open(&host_counters);
+    
     // Wait for all threads to be ready
     pthread_barrier_wait(tctx->start_barrier);
     
     struct timespec start_time, end_time;
     clock_gettime(CLOCK_MONOTONIC, &start_time);
+    host_counters_start(&host_counters);
     
     uint64_t operations_performed = 0;
     
@@ -364,8 +378,12 @@ void* concurrent_mixed_workload_worker(void *arg)
         }
     }
     
+    host_counters_stop(&host_counters);
     clock_gettime(CLOCK_MONOTONIC, &end_time);
     
+    merge_host_counters(ctx, &host_counters.totals);
+    host_counters_close(&host_counters);
+    
     // Calculate thread metrics
     double duration = calculate_duration_seconds(start_time, end_time);
     tctx->thread_metrics.duration_seconds = duration;
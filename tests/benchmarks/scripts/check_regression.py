@@ -0,0 +1,282 @@
+#!/usr/bin/env python3
+
+"""
+FPGA NPU Project - Benchmark Regression Check
+Compares a benchmark run against a stored baseline run, metric by metric,
+with a Mann-Whitney U test and a bootstrap confidence interval
+"""
+
+import argparse
+import json
+import math
+import random
+import statistics
+import sys
+from functools import lru_cache
+from pathlib import Path
+from typing import Dict, List, Optional, Tuple
+
+# Fingerprint fields that change what a benchmark measures. A differing
+# git_commit is the point of the comparison and is not listed.
+ENVIRONMENT_KEYS = ['hostname', 'kernel', 'machine', 'cpu_model', 'cpu_count', 'cpu_governor',
+                    'compiler', 'build_type', 'npu_board', 'npu_pe_count', 'npu_core_count',
+                    'npu_max_frequency']
+
+# Fields that identify the machine, used to pick a baseline from a store
+MACHINE_KEYS = ['hostname', 'cpu_model', 'npu_board']
+
+
+def load_run(path: Path) -> Dict:
+    """Read one run written by npu_benchmark --json or --store"""
+    with open(path) as f:
+        run = json.load(f)
+    if 'benchmarks' not in run:
+        raise ValueError(f"{path} is not a benchmark results file")
+    return run
+
+
+def select_baseline(store: Path, current: Dict, exclude: Path) -> Optional[Path]:
+    """Newest run in a store taken on the same machine, else the newest run"""
+    runs = []
+    for path in sorted(store.glob('*.json')):
+        if path.resolve() == exclude.resolve():
+            continue
+        try:
+            run = load_run(path)
+        except (ValueError, json.JSONDecodeError):
+            continue
+        runs.append((run.get('timestamp', ''), path, run))
+
+    if not runs:
+        return None
+
+    runs.sort(key=lambda r: (r[0], str(r[1])))
+    env = current.get('environment', {})
+    same_machine = [r for r in runs
+                    if all(r[2].get('environment', {}).get(k) == env.get(k) for k in MACHINE_KEYS)]
+    return (same_machine or runs)[-1][1]
+
+
+def environment_differences(current: Dict, baseline: Dict) -> List[Tuple[str, str, str]]:
+    """Fingerprint fields whose values differ between the two runs"""
+    cur = current.get('environment', {})
+    base = baseline.get('environment', {})
+    return [(k, str(base.get(k, '')), str(cur.get(k, ''))) for k in ENVIRONMENT_KEYS
+            if cur.get(k) != base.get(k)]
+
+
+# =============================================================================
+# Statistics
+# =============================================================================
+
+def rank(values: List[float]) -> List[float]:
+    """Ranks starting at 1, ties given their average rank"""
+    order = sorted(range(len(values)), key=lambda i: values[i])
+    ranks = [0.0] * len(values)
+    i = 0
+    while i < len(order):
+        j = i
+        while j + 1 < len(order) and values[order[j + 1]] == values[order[i]]:
+            j += 1
+        for k in range(i, j + 1):
+            ranks[order[k]] = (i + j) / 2.0 + 1.0
+        i = j + 1
+    return ranks
+
+
+@lru_cache(maxsize=None)
+def u_count(n1: int, n2: int, u: int) -> int:
+    """Orderings of n1 + n2 distinct values whose U statistic for the first sample is u"""
+    if u < 0 or u > n1 * n2:
+        return 0
+    if n1 == 0 or n2 == 0:
+        return 1 if u == 0 else 0
+    # The largest value belongs to either sample
+    return u_count(n1 - 1, n2, u - n2) + u_count(n1, n2 - 1, u)
+
+
+def mann_whitney(a: List[float], b: List[float]) -> float:
+    """Two-sided Mann-Whitney U test p-value. Exact for small samples
+    without ties, normal approximation with tie correction otherwise."""
+    n1, n2 = len(a), len(b)
+    combined = a + b
+    ranks = rank(combined)
+    u1 = sum(ranks[:n1]) - n1 * (n1 + 1) / 2.0
+    ties = len(set(combined)) != len(combined)
+
+    if not ties and n1 + n2 <= 30:
+        total = math.comb(n1 + n2, n1)
+        u = int(round(u1))
+        lower = sum(u_count(n1, n2, k) for k in range(0, u + 1)) / total
+        upper = sum(u_count(n1, n2, k) for k in range(u, n1 * n2 + 1)) / total
+        return min(1.0, 2.0 * min(lower, upper))
+
+    n = n1 + n2
+    tie_sum = sum(t ** 3 - t for t in (combined.count(v) for v in set(combined)))
+    variance = n1 * n2 / 12.0 * ((n + 1) - tie_sum / (n * (n - 1)))
+    if variance <= 0:
+        return 1.0
+    z = (abs(u1 - n1 * n2 / 2.0) - 0.5) / math.sqrt(variance)
+    return min(1.0, math.erfc(max(z, 0.0) / math.sqrt(2.0)))
+
+
+def min_p_value(n1: int, n2: int) -> float:
+    """Smallest two-sided p-value the test can reach with these sample sizes"""
+    return min(1.0, 2.0 / math.comb(n1 + n2, n1))
+
+
+def worse_percent(base: float, current: float, better: str) -> float:
+    """Change from base to current in percent, positive when current is worse"""
+    if base == 0:
+        return 0.0
+    change = (current - base) / abs(base) * 100.0
+    return -change if better == 'higher' else change
+
+
+def bootstrap_interval(base: List[float], current: List[float], better: str,
+                       level: float, resamples: int, rng: random.Random) -> Tuple[float, float]:
+    """Percentile bootstrap interval of worse_percent between the medians"""
+    estimates = []
+    for _ in range(resamples):
+        b = statistics.median(rng.choices(base, k=len(base)))
+        c = statistics.median(rng.choices(current, k=len(current)))
+        estimates.append(worse_percent(b, c, better))
+    estimates.sort()
+    tail = (1.0 - level) / 2.0
+    low = estimates[int(tail * (resamples - 1))]
+    high = estimates[int(math.ceil((1.0 - tail) * (resamples - 1)))]
+    return low, high
+
+
+# =============================================================================
+# Comparison
+# =============================================================================
+
+def compare(current: Dict, baseline: Dict, args: argparse.Namespace) -> int:
+    """Print every metric of every benchmark and return the number of regressions"""
+    rng = random.Random(args.seed)
+    level = 1.0 - args.alpha
+    regressions = 0
+    underpowered = set()
+
+    cur_benchmarks = current['benchmarks']
+    base_benchmarks = baseline['benchmarks']
+
+    print(f"{'benchmark':<28} {'metric':<20} {'baseline':>11} {'current':>11} {'worse':>8} "
+          f"{'%d%% CI' % round(level * 100):>17} {'p':>7}")
+
+    for name in sorted(set(cur_benchmarks) | set(base_benchmarks)):
+        if name not in cur_benchmarks or name not in base_benchmarks:
+            where = 'baseline' if name not in cur_benchmarks else 'current'
+            print(f"{name:<28} {'only in ' + where}")
+            continue
+
+        cur = cur_benchmarks[name]
+        base = base_benchmarks[name]
+        if base.get('success', True) and not cur.get('success', True):
+            print(f"{name:<28} failed in the current run  REGRESSION")
+            regressions += 1
+            continue
+
+        for metric in sorted(set(cur['metrics']) & set(base['metrics'])):
+            better = base['metrics'][metric]['better']
+            a = [float(v) for v in base['metrics'][metric]['samples']]
+            b = [float(v) for v in cur['metrics'][metric]['samples']]
+            if not a or not b:
+                continue
+
+            base_median = statistics.median(a)
+            cur_median = statistics.median(b)
+            worse = worse_percent(base_median, cur_median, better)
+
+            if len(a) < 2 or len(b) < 2:
+                # Single runs: no test possible, fall back to the threshold alone
+                status = 'REGRESSION' if worse > args.threshold else ''
+                ci_text, p_text = 'n/a', 'n/a'
+            else:
+                p = mann_whitney(a, b)
+                low, high = bootstrap_interval(a, b, better, level, args.resamples, rng)
+                if min_p_value(len(a), len(b)) >= args.alpha:
+                    underpowered.add(name)
+
+                # Significant, and a change as large as the threshold is
+                # consistent with the data
+                status = ''
+                if p < args.alpha:
+                    if worse > 0 and high >= args.threshold:
+                        status = 'REGRESSION'
+                    elif worse > 0:
+                        status = 'worse'
+                    else:
+                        status = 'better'
+                ci_text = f"[{low:+.2f}, {high:+.2f}]"
+                p_text = f"{p:.4f}"
+
+            regressions += status == 'REGRESSION'
+            print(f"{name:<28} {metric:<20} {base_median:>11.4g} {cur_median:>11.4g} {worse:>+7.2f}% "
+                  f"{ci_text:>17} {p_text:>7}  {status}".rstrip())
+
+    for name in sorted(underpowered):
+        print(f"warning: {name}: too few repetitions to reach p < {args.alpha}; "
+              f"run with --repetitions 5 or more")
+
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Check NPU benchmark results for statistically "
+                                                 "significant regressions against a baseline")
+    parser.add_argument('--current', type=Path, required=True,
+                        help='Results of this run (benchmark_results.json)')
+    parser.add_argument('--baseline', type=Path, required=True,
+                        help='Baseline run, or a results store directory to take the newest run from')
+    parser.add_argument('--threshold', type=float, default=5.0,
+                        help='Slowdown that must be caught, percent (default: 5.0)')
+    parser.add_argument('--alpha', type=float, default=0.05,
+                        help='Significance level of the test (default: 0.05)')
+    parser.add_argument('--resamples', type=int, default=2000,
+                        help='Bootstrap resamples (default: 2000)')
+    parser.add_argument('--seed', type=int, default=1,
+                        help='Bootstrap seed (default: 1)')
+    parser.add_argument('--require-same-env', action='store_true',
+                        help='Fail if the environment fingerprints differ')
+    args = parser.parse_args()
+
+    current = load_run(args.current)
+
+    baseline_path = args.baseline
+    if baseline_path.is_dir():
+        baseline_path = select_baseline(baseline_path, current, args.current)
+        if baseline_path is None:
+            print(f"No runs in {args.baseline}; store one with 'npu_benchmark --store'")
+            return 0
+    elif not baseline_path.exists():
+        print(f"No baseline at {baseline_path}")
+        return 0
+
+    baseline = load_run(baseline_path)
+    print(f"Baseline: {baseline_path} ({baseline.get('timestamp', 'unknown')}, "
+          f"commit {baseline.get('environment', {}).get('git_commit', 'unknown')})")
+    print(f"Current:  {args.current} ({current.get('timestamp', 'unknown')}, "
+          f"commit {current.get('environment', {}).get('git_commit', 'unknown')})")
+
+    differences = environment_differences(current, baseline)
+    for key, base, cur in differences:
+        print(f"warning: environment differs: {key}: '{base}' -> '{cur}'")
+    if differences and args.require_same_env:
+        print("Environment fingerprints differ; results are not comparable")
+        return 2
+    print()
+
+    regressions = compare(current, baseline, args)
+    if regressions:
+        print(f"\n{regressions} metric(s) regressed significantly (alpha {args.alpha}, "
+              f"threshold {args.threshold}%)")
+        return 1
+
+    print(f"\nNo significant regressions (alpha {args.alpha}, threshold {args.threshold}%)")
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
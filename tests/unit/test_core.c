@@ -41,6 +41,22 @@ int __wrap_ioctl(int fd, unsigned long request, ...)
     return 0;
 }
 
+ssize_t __real_write(int fd, const void *buf, size_t count);
+
+// Mock implementation of write() for testing: instruction streams sent to
+// the mock device are accepted without executing
+ssize_t __wrap_write(int fd, const void *buf, size_t count)
+{
+    if (fd != mock_device.mock_fd) {
+        return __real_write(fd, buf, count);
+    }
+    
+    if (mock_device.ioctl_should_fail) {
+        return -1;
+    }
+    return (ssize_t)count;
+}
+
 // Mock implementation of malloc() that can fail
 void* __wrap_malloc(size_t size)
 {
@@ -303,6 +319,13 @@ bool test_device_status(void)
     ret = npu_get_status(NULL, &status);
     ASSERT_EQ(NPU_ERROR_INVALID, ret);
     
+    // Test null ioctl
+    ret = npu_null_ioctl(handle);
+    ASSERT_EQ(NPU_SUCCESS, ret);
+    
+    ret = npu_null_ioctl(NULL);
+    ASSERT_EQ(NPU_ERROR_INVALID, ret);
+    
     // Test wait completion
     ret = npu_wait_completion(handle, 1000);
     ASSERT_EQ(NPU_SUCCESS, ret);
@@ -0,0 +1,401 @@
+/**
+ * Unit Tests for NPU Operator Graphs
+ *
+ * Tests graph building, graph rewriting and the liveness-based memory
+ * planner.
+ */
+
+#include "test_framework.h"
+#include "../../software/userspace/npu_graph.h"
+
+// Weights and biases of the test networks; only their shapes matter here
+static int32_t weight_data[256 * 120];
+
+static float float_data[128];
+
+// Batch norm with sqrt(variance + 1) = 2, 1, 4, 3 and nonzero shifts
+static float bn_gamma[4] = { 1.0f, 2.0f, 0.5f, -1.0f };
+static float bn_beta[4] = { 0.5f, -1.0f, 2.0f, 0.0f };
+static float bn_mean[4] = { 1.0f, 0.0f, -2.0f, 3.0f };
+static float bn_variance[4] = { 3.0f, 0.0f, 15.0f, 8.0f };
+static const float bn_factor[4] = { 0.5f, 2.0f, 0.125f, -1.0f / 3.0f };
+static const float bn_shift[4] = { 0.0f, -1.0f, 2.25f, 1.0f };
+
+static npu_value_t graph_constant(npu_graph_t graph, uint32_t n, uint32_t c, uint32_t h, uint32_t w)
+{
+    npu_tensor_t tensor = npu_create_tensor(weight_data, n, c, h, w, NPU_DTYPE_INT32);
+    return npu_graph_constant(graph, &tensor);
+}
+
+static npu_value_t float_constant(npu_graph_t graph, uint32_t n, uint32_t c, uint32_t h, uint32_t w)
+{
+    npu_tensor_t tensor = npu_create_tensor(float_data, n, c, h, w, NPU_DTYPE_FLOAT32);
+    return npu_graph_constant(graph, &tensor);
+}
+
+static npu_value_t bn_constant(npu_graph_t graph, float *data, bool columns)
+{
+    npu_tensor_t tensor = npu_create_tensor(data, 1, columns ? 1 : 4, 1, columns ? 4 : 1,
+                                            NPU_DTYPE_FLOAT32);
+    return npu_graph_constant(graph, &tensor);
+}
+
+static npu_value_t add_batch_norm(npu_graph_t graph, npu_value_t x, bool columns)
+{
+    return npu_graph_batch_norm(graph, x, bn_constant(graph, bn_gamma, columns),
+                                bn_constant(graph, bn_beta, columns),
+                                bn_constant(graph, bn_mean, columns),
+                                bn_constant(graph, bn_variance, columns), 1.0f);
+}
+
+/**
+ * Build the LeNet-5 network of examples/cnn_inference
+ */
+static npu_value_t build_lenet(npu_graph_t graph, uint32_t batch)
+{
+    npu_value_t x = npu_graph_input(graph, batch, 1, 28, 28, NPU_DTYPE_INT32);
+    
+    x = npu_graph_conv2d(graph, x, graph_constant(graph, 6, 1, 5, 5), 1, 1, 0, 0);
+    x = npu_graph_add(graph, x, graph_constant(graph, 1, 6, 1, 1));
+    x = npu_graph_relu(graph, x);
+    x = npu_graph_max_pool2d(graph, x, 2, 2, 2, 2, 0, 0);
+    x = npu_graph_conv2d(graph, x, graph_constant(graph, 16, 6, 5, 5), 1, 1, 0, 0);
+    x = npu_graph_add(graph, x, graph_constant(graph, 1, 16, 1, 1));
+    x = npu_graph_relu(graph, x);
+    x = npu_graph_max_pool2d(graph, x, 2, 2, 2, 2, 0, 0);
+    x = npu_graph_reshape(graph, x, 1, 1, batch, 256);
+    x = npu_graph_matmul(graph, x, graph_constant(graph, 1, 1, 256, 120));
+    x = npu_graph_add(graph, x, graph_constant(graph, 1, 1, 1, 120));
+    x = npu_graph_relu(graph, x);
+    x = npu_graph_matmul(graph, x, graph_constant(graph, 1, 1, 120, 84));
+    x = npu_graph_add(graph, x, graph_constant(graph, 1, 1, 1, 84));
+    x = npu_graph_relu(graph, x);
+    x = npu_graph_matmul(graph, x, graph_constant(graph, 1, 1, 84, 10));
+    x = npu_graph_add(graph, x, graph_constant(graph, 1, 1, 1, 10));
+    return x;
+}
+
+/**
+ * Test graph building and shape checks
+ */
+bool test_graph_build(void)
+{
+    TEST_CASE("graph building");
+    
+    npu_graph_t graph = npu_graph_create();
+    ASSERT_NOT_NULL(graph);
+    
+    npu_value_t x = npu_graph_input(graph, 2, 3, 8, 8, NPU_DTYPE_INT32);
+    ASSERT_TRUE(x >= 0);
+    
+    // Inner dimensions of a matmul must agree
+    npu_value_t a = npu_graph_input(graph, 1, 1, 4, 5, NPU_DTYPE_INT32);
+    npu_value_t b = graph_constant(graph, 1, 1, 6, 7);
+    npu_value_t bad = npu_graph_matmul(graph, a, b);
+    ASSERT_EQ(NPU_ERROR_INVALID, bad);
+    
+    // Errors pass through later builder calls
+    ASSERT_EQ(NPU_ERROR_INVALID, npu_graph_relu(graph, bad));
+    ASSERT_EQ(NPU_ERROR_INVALID, npu_graph_output(graph, bad));
+    
+    // Only constants are broadcast
+    npu_value_t bias = npu_graph_input(graph, 1, 3, 1, 1, NPU_DTYPE_INT32);
+    ASSERT_EQ(NPU_ERROR_INVALID, npu_graph_add(graph, x, bias));
+    ASSERT_TRUE(npu_graph_add(graph, x, graph_constant(graph, 1, 3, 1, 1)) >= 0);
+    
+    // Window larger than the padded input
+    ASSERT_EQ(NPU_ERROR_INVALID, npu_graph_max_pool2d(graph, x, 9, 9, 1, 1, 0, 0));
+    
+    // Softmax runs in float; reshape keeps the element count
+    ASSERT_EQ(NPU_ERROR_INVALID, npu_graph_softmax(graph, x));
+    ASSERT_EQ(NPU_ERROR_INVALID, npu_graph_reshape(graph, x, 1, 1, 1, 100));
+    
+    // Inputs and constants cannot be outputs
+    ASSERT_EQ(NPU_ERROR_INVALID, npu_graph_output(graph, x));
+    
+    npu_value_t y = npu_graph_conv2d(graph, x, graph_constant(graph, 4, 3, 3, 3), 1, 1, 1, 1);
+    ASSERT_TRUE(y >= 0);
+    ASSERT_EQ(NPU_SUCCESS, npu_graph_output(graph, y));
+    ASSERT_EQ(NPU_ERROR_INVALID, npu_graph_output(graph, y));
+    
+    // Execution needs a device
+    ASSERT_EQ(NPU_ERROR_INVALID, npu_graph_execute(NULL, graph, NULL, NULL));
+    
+    npu_graph_destroy(graph);
+    npu_graph_destroy(NULL);
+    
+    TEST_PASS();
+}
+
+/**
+ * Test memory planning of the example CNN
+ */
+bool test_graph_plan_lenet(void)
+{
+    TEST_CASE("graph memory plan of LeNet-5");
+    
+    npu_graph_memory_report_t report;
+    npu_graph_t graph = npu_graph_create();
+    ASSERT_NOT_NULL(graph);
+    
+    npu_value_t logits = build_lenet(graph, 8);
+    ASSERT_TRUE(logits >= 0);
+    ASSERT_EQ(NPU_SUCCESS, npu_graph_output(graph, logits));
+    ASSERT_EQ(NPU_SUCCESS, npu_graph_plan_memory(graph, &report));
+    
+    // Every bias add, ReLU and the flatten run in place
+    ASSERT_EQ(16, report.intermediate_count);
+    ASSERT_EQ(9, report.in_place_count);
+    ASSERT_EQ(7, report.buffer_count);
+    
+    // conv1 and pool1 are the largest pair live together
+    ASSERT_EQ(8 * (6 * 24 * 24 + 6 * 12 * 12) * sizeof(int32_t), report.peak_live_bytes);
+    ASSERT_EQ(report.peak_live_bytes, report.arena_bytes);
+    ASSERT_TRUE(report.naive_bytes >= 3 * report.arena_bytes);
+    
+    npu_graph_destroy(graph);
+    
+    TEST_PASS();
+}
+
+/**
+ * Test that buffers live at the same time never share memory
+ */
+bool test_graph_plan_skip_connection(void)
+{
+    TEST_CASE("graph memory plan with skip connection");
+    
+    npu_graph_memory_report_t report;
+    npu_graph_t graph = npu_graph_create();
+    ASSERT_NOT_NULL(graph);
+    
+    // a is read again by the add, so the sigmoid cannot overwrite it
+    npu_value_t x = npu_graph_input(graph, 1, 1, 1, 256, NPU_DTYPE_INT32);
+    npu_value_t a = npu_graph_relu(graph, x);
+    npu_value_t b = npu_graph_sigmoid(graph, a);
+    npu_value_t c = npu_graph_add(graph, a, b);
+    ASSERT_EQ(NPU_SUCCESS, npu_graph_output(graph, npu_graph_relu(graph, c)));
+    
+    ASSERT_EQ(NPU_SUCCESS, npu_graph_plan_memory(graph, &report));
+    ASSERT_EQ(3 * 1024, report.naive_bytes);
+    ASSERT_EQ(1, report.in_place_count);
+    ASSERT_EQ(2, report.buffer_count);
+    ASSERT_EQ(2 * 1024, report.arena_bytes);
+    
+    // Adding a node discards the plan. Once a is read after the add, the
+    // add writes over b instead.
+    npu_value_t d = npu_graph_relu(graph, a);
+    ASSERT_TRUE(d >= 0);
+    ASSERT_EQ(NPU_SUCCESS, npu_graph_plan_memory(graph, &report));
+    ASSERT_EQ(4 * 1024, report.naive_bytes);
+    ASSERT_EQ(2, report.in_place_count);
+    ASSERT_EQ(2, report.buffer_count);
+    ASSERT_EQ(2 * 1024, report.arena_bytes);
+    
+    npu_graph_destroy(graph);
+    
+    TEST_PASS();
+}
+
+/**
+ * Test batch norm folding, identity removal and activation fusion
+ */
+bool test_graph_optimize(void)
+{
+    TEST_CASE("graph optimization");
+    
+    npu_graph_optimize_report_t report;
+    npu_graph_memory_report_t plan;
+    npu_graph_t graph = npu_graph_create();
+    ASSERT_NOT_NULL(graph);
+    
+    // Batch norm parameters are per-channel FLOAT32 constants
+    npu_value_t x = npu_graph_input(graph, 2, 3, 8, 8, NPU_DTYPE_FLOAT32);
+    npu_value_t y = npu_graph_conv2d(graph, x, float_constant(graph, 4, 3, 3, 3), 1, 1, 1, 1);
+    npu_value_t c4 = float_constant(graph, 1, 4, 1, 1);
+    ASSERT_EQ(NPU_ERROR_INVALID, npu_graph_batch_norm(graph, y, c4, c4, c4, x, 1e-5f));
+    ASSERT_EQ(NPU_ERROR_INVALID, npu_graph_batch_norm(graph, x, c4, c4, c4, c4, 1e-5f));
+    
+    // conv -> batch norm -> relu -> dropout -> flatten to the same shape
+    y = add_batch_norm(graph, y, false);
+    y = npu_graph_relu(graph, y);
+    y = npu_graph_dropout(graph, y, 0.5f);
+    y = npu_graph_reshape(graph, y, 2, 4, 8, 8);
+    ASSERT_TRUE(y >= 0);
+    ASSERT_EQ(NPU_SUCCESS, npu_graph_output(graph, y));
+    
+    // A batch norm of an input and a softmax have nothing to fold into
+    npu_value_t z = npu_graph_input(graph, 1, 1, 4, 4, NPU_DTYPE_FLOAT32);
+    npu_value_t c1 = float_constant(graph, 1, 1, 1, 1);
+    z = npu_graph_batch_norm(graph, z, c1, c1, c1, c1, 1e-5f);
+    z = npu_graph_softmax(graph, z);
+    ASSERT_TRUE(z >= 0);
+    ASSERT_EQ(NPU_SUCCESS, npu_graph_output(graph, z));
+    
+    // Without a device, constant folding is skipped
+    ASSERT_EQ(NPU_SUCCESS, npu_graph_optimize(NULL, graph, &report));
+    ASSERT_EQ(7, report.nodes_before);
+    ASSERT_EQ(4, report.nodes_after);
+    ASSERT_EQ(2, report.identities_removed);
+    ASSERT_EQ(0, report.constants_folded);
+    ASSERT_EQ(1, report.batch_norms_folded);
+    ASSERT_EQ(1, report.activations_fused);
+    
+    // The conv result and the unfolded batch norm remain between nodes
+    ASSERT_EQ(NPU_SUCCESS, npu_graph_plan_memory(graph, &plan));
+    ASSERT_EQ(2, plan.intermediate_count);
+    ASSERT_EQ(0, plan.in_place_count);
+    
+    // A second run finds nothing left to do
+    ASSERT_EQ(NPU_SUCCESS, npu_graph_optimize(NULL, graph, &report));
+    ASSERT_EQ(report.nodes_before, report.nodes_after);
+    ASSERT_EQ(NPU_ERROR_INVALID, npu_graph_optimize(NULL, NULL, NULL));
+    
+    npu_graph_destroy(graph);
+    
+    TEST_PASS();
+}
+
+/**
+ * Test that a reshape shares its input's memory even when the input is
+ * read again, and that nothing then writes over that memory early
+ */
+bool test_graph_plan_reshape(void)
+{
+    TEST_CASE("graph memory plan with reshape");
+    
+    npu_graph_memory_report_t report;
+    npu_graph_t graph = npu_graph_create();
+    ASSERT_NOT_NULL(graph);
+    
+    // a is read again after the reshape, which still needs no memory of its own
+    npu_value_t x = npu_graph_input(graph, 1, 1, 1, 256, NPU_DTYPE_INT32);
+    npu_value_t a = npu_graph_relu(graph, x);
+    npu_value_t r = npu_graph_reshape(graph, a, 1, 1, 16, 16);
+    ASSERT_EQ(NPU_SUCCESS, npu_graph_output(graph, npu_graph_sigmoid(graph, r)));
+    ASSERT_EQ(NPU_SUCCESS, npu_graph_output(graph, npu_graph_relu(graph, a)));
+    
+    ASSERT_EQ(NPU_SUCCESS, npu_graph_plan_memory(graph, &report));
+    ASSERT_EQ(2 * 1024, report.naive_bytes);
+    ASSERT_EQ(1, report.in_place_count);
+    ASSERT_EQ(1, report.buffer_count);
+    ASSERT_EQ(1024, report.arena_bytes);
+    npu_graph_destroy(graph);
+    
+    // The sigmoid's input is last read there, but its memory is a's
+    graph = npu_graph_create();
+    ASSERT_NOT_NULL(graph);
+    x = npu_graph_input(graph, 1, 1, 1, 256, NPU_DTYPE_INT32);
+    a = npu_graph_relu(graph, x);
+    r = npu_graph_reshape(graph, a, 1, 1, 16, 16);
+    npu_value_t s = npu_graph_sigmoid(graph, r);
+    ASSERT_EQ(NPU_SUCCESS, npu_graph_output(graph, npu_graph_relu(graph, s)));
+    ASSERT_EQ(NPU_SUCCESS, npu_graph_output(graph, npu_graph_relu(graph, a)));
+    
+    ASSERT_EQ(NPU_SUCCESS, npu_graph_plan_memory(graph, &report));
+    ASSERT_EQ(3 * 1024, report.naive_bytes);
+    ASSERT_EQ(1, report.in_place_count);
+    ASSERT_EQ(2, report.buffer_count);
+    ASSERT_EQ(2 * 1024, report.arena_bytes);
+    npu_graph_destroy(graph);
+    
+    TEST_PASS();
+}
+
+/**
+ * Test the weights and bias a folded batch norm leaves behind
+ */
+bool test_graph_fold_batch_norm(void)
+{
+    TEST_CASE("batch norm folding");
+    
+    npu_graph_optimize_report_t report;
+    npu_tensor_t tensor;
+    float weights[12];
+    
+    for (int e = 0; e < 12; e++) {
+        weights[e] = (float)(e + 1);
+    }
+    
+    // Matmul weights have one column per channel
+    npu_graph_t graph = npu_graph_create();
+    ASSERT_NOT_NULL(graph);
+    npu_tensor_t w = npu_create_tensor(weights, 1, 1, 3, 4, NPU_DTYPE_FLOAT32);
+    npu_value_t y = npu_graph_matmul(graph, npu_graph_input(graph, 1, 1, 2, 3, NPU_DTYPE_FLOAT32),
+                                     npu_graph_constant(graph, &w));
+    y = add_batch_norm(graph, y, true);
+    ASSERT_TRUE(y >= 0);
+    ASSERT_EQ(NPU_SUCCESS, npu_graph_output(graph, y));
+    ASSERT_EQ(NPU_SUCCESS, npu_graph_optimize(NULL, graph, &report));
+    ASSERT_EQ(1, report.batch_norms_folded);
+    
+    // Folding appends the scaled weights, then the shift
+    ASSERT_EQ(NPU_SUCCESS, npu_graph_get_tensor(graph, y + 1, &tensor));
+    ASSERT_EQ(12, tensor.dims[2] * tensor.dims[3]);
+    for (int e = 0; e < 12; e++) {
+        ASSERT_FLOAT_EQ(weights[e] * bn_factor[e % 4], ((const float *)tensor.data)[e], 1e-5f);
+    }
+    ASSERT_EQ(NPU_SUCCESS, npu_graph_get_tensor(graph, y + 2, &tensor));
+    ASSERT_EQ(4, tensor.dims[3]);
+    for (int c = 0; c < 4; c++) {
+        ASSERT_FLOAT_EQ(bn_shift[c], ((const float *)tensor.data)[c], 1e-5f);
+    }
+    npu_graph_destroy(graph);
+    
+    // Conv2d weights are OIHW: each output channel is a block of I*H*W
+    graph = npu_graph_create();
+    ASSERT_NOT_NULL(graph);
+    w = npu_create_tensor(weights, 4, 3, 1, 1, NPU_DTYPE_FLOAT32);
+    y = npu_graph_conv2d(graph, npu_graph_input(graph, 1, 3, 4, 4, NPU_DTYPE_FLOAT32),
+                         npu_graph_constant(graph, &w), 1, 1, 0, 0);
+    y = add_batch_norm(graph, y, false);
+    ASSERT_TRUE(y >= 0);
+    ASSERT_EQ(NPU_SUCCESS, npu_graph_output(graph, y));
+    ASSERT_EQ(NPU_SUCCESS, npu_graph_optimize(NULL, graph, &report));
+    ASSERT_EQ(1, report.batch_norms_folded);
+    ASSERT_EQ(NPU_SUCCESS, npu_graph_get_tensor(graph, y + 1, &tensor));
+    for (int e = 0; e < 12; e++) {
+        ASSERT_FLOAT_EQ(weights[e] * bn_factor[e / 3], ((const float *)tensor.data)[e], 1e-5f);
+    }
+    ASSERT_EQ(NPU_SUCCESS, npu_graph_get_tensor(graph, y + 2, &tensor));
+    ASSERT_EQ(4, tensor.dims[1]);
+    for (int c = 0; c < 4; c++) {
+        ASSERT_FLOAT_EQ(bn_shift[c], ((const float *)tensor.data)[c], 1e-5f);
+    }
+    npu_graph_destroy(graph);
+    
+    // INT32 weights would need requantising, so they are left alone
+    graph = npu_graph_create();
+    ASSERT_NOT_NULL(graph);
+    y = npu_graph_matmul(graph, npu_graph_input(graph, 1, 1, 2, 3, NPU_DTYPE_INT32),
+                         graph_constant(graph, 1, 1, 3, 4));
+    y = add_batch_norm(graph, y, true);
+    ASSERT_TRUE(y >= 0);
+    ASSERT_EQ(NPU_SUCCESS, npu_graph_output(graph, y));
+    ASSERT_EQ(NPU_SUCCESS, npu_graph_optimize(NULL, graph, &report));
+    ASSERT_EQ(0, report.batch_norms_folded);
+    ASSERT_EQ(report.nodes_before, report.nodes_after);
+    ASSERT_EQ(NPU_ERROR_INVALID, npu_graph_get_tensor(graph, y + 1, &tensor));
+    
+    ASSERT_EQ(NPU_SUCCESS, npu_graph_get_tensor(graph, y, &tensor));
+    ASSERT_NULL(tensor.data);
+    ASSERT_EQ(NPU_ERROR_INVALID, npu_graph_get_tensor(graph, y, NULL));
+    npu_graph_destroy(graph);
+    
+    TEST_PASS();
+}
+
+/**
+ * Run all graph tests
+ */
+void run_graph_tests(void)
+{
+    TEST_SUITE("Operator Graphs");
+    
+    RUN_TEST(test_graph_build);
+    RUN_TEST(test_graph_plan_lenet);
+    RUN_TEST(test_graph_plan_skip_connection);
+    RUN_TEST(test_graph_plan_reshape);
+    RUN_TEST(test_graph_optimize);
+    RUN_TEST(test_graph_fold_batch_norm);
+}
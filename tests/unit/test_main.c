@@ -12,6 +12,7 @@
 extern void run_core_tests(void);
 extern void run_memory_tests(void);
 extern void run_tensor_tests(void);
+extern void run_graph_tests(void);
 
 /**
  * Print test banner
@@ -186,6 +187,7 @@ int main(int argc, char* argv[])
     run_core_tests();
     run_memory_tests();
     run_tensor_tests();
+    run_graph_tests();
     run_performance_tests();
     run_stress_tests();
     run_edge_case_tests();
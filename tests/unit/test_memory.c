@@ -241,6 +241,49 @@ bool test_buffer_sync(void)
     TEST_PASS();
 }
 
+/**
+ * Test DMA transfers between a buffer and device memory
+ */
+bool test_buffer_dma_transfer(void)
+{
+    TEST_CASE("buffer DMA transfer");
+    
+    mock_reset();
+    npu_handle_t handle = npu_init();
+    ASSERT_NOT_NULL(handle);
+    
+    npu_buffer_handle_t buffer = npu_buffer_alloc(handle, 4096, NPU_ALLOC_COHERENT);
+    ASSERT_NOT_NULL(buffer);
+    
+    // Test both directions
+    int ret = npu_dma_transfer(handle, buffer, 0, 0, 4096, NPU_DMA_TO_DEVICE, 1000);
+    ASSERT_EQ(NPU_SUCCESS, ret);
+    
+    ret = npu_dma_transfer(handle, buffer, 64, 0x1000, 1024, NPU_DMA_FROM_DEVICE, 1000);
+    ASSERT_EQ(NPU_SUCCESS, ret);
+    
+    // Test transfers past the end of the buffer and bad directions
+    ret = npu_dma_transfer(handle, buffer, 64, 0, 4096, NPU_DMA_TO_DEVICE, 1000);
+    ASSERT_EQ(NPU_ERROR_INVALID, ret);
+    
+    ret = npu_dma_transfer(handle, buffer, 0, 0, 4096, 2, 1000);
+    ASSERT_EQ(NPU_ERROR_INVALID, ret);
+    
+    ret = npu_dma_transfer(handle, buffer, 0, 0, 0, NPU_DMA_TO_DEVICE, 1000);
+    ASSERT_EQ(NPU_ERROR_INVALID, ret);
+    
+    // Test with NULL parameters
+    ret = npu_dma_transfer(handle, NULL, 0, 0, 4096, NPU_DMA_TO_DEVICE, 1000);
+    ASSERT_EQ(NPU_ERROR_INVALID, ret);
+    
+    ret = npu_dma_transfer(NULL, buffer, 0, 0, 4096, NPU_DMA_TO_DEVICE, 1000);
+    ASSERT_EQ(NPU_ERROR_INVALID, ret);
+    
+    npu_buffer_free(handle, buffer);
+    npu_cleanup(handle);
+    TEST_PASS();
+}
+
 /**
  * Test buffer information retrieval
  */
@@ -389,6 +432,7 @@ void run_memory_tests(void)
     RUN_TEST(test_buffer_mapping);
     RUN_TEST(test_buffer_readwrite);
     RUN_TEST(test_buffer_sync);
+    RUN_TEST(test_buffer_dma_transfer);
     RUN_TEST(test_buffer_info);
     RUN_TEST(test_tensor_from_buffer);
     RUN_TEST(test_memory_stats);
@@ -118,6 +118,13 @@ bool test_elementwise_ops(void)
     int ret = npu_add(handle, &a, &b, &c);
     ASSERT_EQ(NPU_SUCCESS, ret);
     
+    // Test addition with a fused ReLU epilogue
+    ret = npu_add_fused(handle, &a, &b, &c, NPU_ACT_RELU);
+    ASSERT_EQ(NPU_SUCCESS, ret);
+    
+    ret = npu_add_fused(handle, &a, &b, &c, (npu_activation_t)(NPU_ACT_TANH + 1));
+    ASSERT_EQ(NPU_ERROR_INVALID, ret);
+    
     // Test multiplication
     ret = npu_multiply(handle, &a, &b, &c);
     ASSERT_EQ(NPU_SUCCESS, ret);
@@ -371,6 +378,268 @@ bool test_softmax_detailed(void)
     TEST_PASS();
 }
 
+/**
+ * Test 2:4 structured-sparse weight packing
+ */
+bool test_sparse_weight_packing(void)
+{
+    TEST_CASE("2:4 sparse weight packing");
+    
+    // 2 output channels x 1 input channel x 3x3: three groups per block,
+    // the last one holding a single tap
+    int32_t dense_data[18] = {
+        5, 0, 0, -3,   0, 7, 2, 0,   0,
+        0, 0, 0, 0,    1, 0, 0, 0,   9
+    };
+    uint32_t packed_data[14];
+    
+    npu_tensor_t dense = npu_create_tensor(dense_data, 2, 1, 3, 3, NPU_DTYPE_INT32);
+    npu_tensor_t packed = npu_create_tensor(packed_data, 1, 1, 1, 14, NPU_DTYPE_INT32);
+    
+    // One metadata word plus three value pairs per block
+    ASSERT_EQ(14 * sizeof(uint32_t), npu_weights_2_4_size(2, 1, 3, 3));
+    
+    int ret = npu_pack_weights_2_4(&dense, &packed);
+    ASSERT_EQ(NPU_SUCCESS, ret);
+    ASSERT_EQ(NPU_DTYPE_SPARSE_2_4, packed.dtype);
+    ASSERT_EQ(14 * sizeof(uint32_t), packed.size);
+    ASSERT_EQ(2, packed.dims[0]);
+    ASSERT_EQ(3, packed.dims[2]);
+    
+    // Block 0: groups {0,3}, {1,2}, {0,3 (padding)}
+    ASSERT_EQ(0xC9C, packed_data[0]);
+    ASSERT_EQ(5, (int32_t)packed_data[1]);
+    ASSERT_EQ(-3, (int32_t)packed_data[2]);
+    ASSERT_EQ(7, (int32_t)packed_data[3]);
+    ASSERT_EQ(2, (int32_t)packed_data[4]);
+    ASSERT_EQ(0, (int32_t)packed_data[5]);
+    ASSERT_EQ(0, (int32_t)packed_data[6]);
+    
+    // Block 1: empty group, single value at index 0, last tap
+    ASSERT_EQ(0xCCC, packed_data[7]);
+    ASSERT_EQ(1, (int32_t)packed_data[10]);
+    ASSERT_EQ(9, (int32_t)packed_data[12]);
+    
+    // Three non-zeros in one group cannot be packed
+    dense_data[1] = 4;
+    ret = npu_pack_weights_2_4(&dense, &packed);
+    ASSERT_EQ(NPU_ERROR_INVALID, ret);
+    dense_data[1] = 0;
+    
+    // Buffer too small
+    packed.size = 13 * sizeof(uint32_t);
+    ret = npu_pack_weights_2_4(&dense, &packed);
+    ASSERT_EQ(NPU_ERROR_INVALID, ret);
+    
+    // NULL parameters
+    ret = npu_pack_weights_2_4(NULL, &packed);
+    ASSERT_EQ(NPU_ERROR_INVALID, ret);
+    
+    TEST_PASS();
+}
+
+/**
+ * Test placement of operators on the host
+ */
+bool test_operator_placement(void)
+{
+    TEST_CASE("operator placement");
+    
+    mock_reset();
+    npu_handle_t handle = npu_init();
+    ASSERT_NOT_NULL(handle);
+    
+    float a_data[6] = {1, 2, 3, 4, 5, 6}; // 2x3
+    float b_data[6] = {1, 2, 3, 4, 5, 6}; // 3x2
+    float c_data[4] = {0};                 // 2x2 result
+    float shift_data[4] = {-30, -20, -60, 0};
+    int8_t q_data[4] = {-1, 2, -3, 4};
+    npu_placement_stats_t stats;
+    uint64_t npu_ns, cpu_ns;
+    
+    npu_tensor_t a = npu_create_tensor(a_data, 1, 1, 2, 3, NPU_DTYPE_FLOAT32);
+    npu_tensor_t b = npu_create_tensor(b_data, 1, 1, 3, 2, NPU_DTYPE_FLOAT32);
+    npu_tensor_t c = npu_create_tensor(c_data, 1, 1, 2, 2, NPU_DTYPE_FLOAT32);
+    npu_tensor_t shift = npu_create_tensor(shift_data, 1, 1, 2, 2, NPU_DTYPE_FLOAT32);
+    npu_tensor_t q = npu_create_tensor(q_data, 1, 1, 1, 4, NPU_DTYPE_INT8);
+    
+    // The cost model has no estimates before calibration
+    int ret = npu_get_placement_estimate(handle, NPU_OP_MATMUL, 12, 0, &npu_ns, &cpu_ns);
+    ASSERT_EQ(NPU_ERROR_INVALID, ret);
+    
+    // Host placement computes the results itself
+    ret = npu_set_placement(handle, NPU_PLACEMENT_CPU);
+    ASSERT_EQ(NPU_SUCCESS, ret);
+    
+    ret = npu_matrix_multiply(handle, &a, &b, &c);
+    ASSERT_EQ(NPU_SUCCESS, ret);
+    ASSERT_FLOAT_EQ(22.0f, c_data[0], 0.001f);
+    ASSERT_FLOAT_EQ(28.0f, c_data[1], 0.001f);
+    ASSERT_FLOAT_EQ(49.0f, c_data[2], 0.001f);
+    ASSERT_FLOAT_EQ(64.0f, c_data[3], 0.001f);
+    
+    ret = npu_add_fused(handle, &c, &shift, &c, NPU_ACT_RELU);
+    ASSERT_EQ(NPU_SUCCESS, ret);
+    ASSERT_FLOAT_EQ(0.0f, c_data[0], 0.001f);
+    ASSERT_FLOAT_EQ(8.0f, c_data[1], 0.001f);
+    ASSERT_FLOAT_EQ(0.0f, c_data[2], 0.001f);
+    ASSERT_FLOAT_EQ(64.0f, c_data[3], 0.001f);
+    
+    ret = npu_sigmoid(handle, &c, &c);
+    ASSERT_EQ(NPU_SUCCESS, ret);
+    ASSERT_FLOAT_EQ(0.5f, c_data[0], 0.001f);
+    
+    // INT8 has no host kernel, so it is still submitted to the (mock) device
+    ret = npu_relu(handle, &q, &q);
+    ASSERT_EQ(NPU_SUCCESS, ret);
+    
+    ret = npu_get_placement_stats(handle, &stats);
+    ASSERT_EQ(NPU_SUCCESS, ret);
+    ASSERT_EQ(3, stats.cpu_calls);
+    ASSERT_EQ(1, stats.npu_calls);
+    ASSERT_EQ(1, stats.unsupported);
+    
+    // Automatic placement calibrates first, then places every call
+    ret = npu_set_placement(handle, NPU_PLACEMENT_AUTO);
+    ASSERT_EQ(NPU_SUCCESS, ret);
+    
+    ret = npu_get_placement_estimate(handle, NPU_OP_MATMUL, 12, 0, &npu_ns, &cpu_ns);
+    ASSERT_EQ(NPU_SUCCESS, ret);
+    ASSERT_TRUE(npu_ns > 0 && cpu_ns > 0);
+    
+    for (int i = 0; i < 10; i++) {
+        ret = npu_matrix_multiply(handle, &a, &b, &c);
+        ASSERT_EQ(NPU_SUCCESS, ret);
+    }
+    
+    ret = npu_get_placement_stats(handle, &stats);
+    ASSERT_EQ(NPU_SUCCESS, ret);
+    ASSERT_EQ(10, stats.npu_calls + stats.cpu_calls);
+    
+    // Invalid parameters
+    ret = npu_set_placement(handle, (npu_placement_t)(NPU_PLACEMENT_AUTO + 1));
+    ASSERT_EQ(NPU_ERROR_INVALID, ret);
+    
+    ret = npu_set_placement(NULL, NPU_PLACEMENT_CPU);
+    ASSERT_EQ(NPU_ERROR_INVALID, ret);
+    
+    ret = npu_get_placement_stats(handle, NULL);
+    ASSERT_EQ(NPU_ERROR_INVALID, ret);
+    
+    npu_cleanup(handle);
+    TEST_PASS();
+}
+
+/**
+ * Test matrix multiplication shared with host threads
+ */
+bool test_cooperative_matmul(void)
+{
+    TEST_CASE("cooperative matrix multiplication");
+    
+    mock_reset();
+    npu_handle_t handle = npu_init();
+    ASSERT_NOT_NULL(handle);
+    
+    // 100 rows make 7 tiles, the last one short
+    uint32_t m = 100, k = 8, n = 16;
+    float a_data[100 * 8];
+    float b_data[8 * 16];
+    float c_data[100 * 16];
+    
+    for (uint32_t i = 0; i < m * k; i++) a_data[i] = (float)(i % 5);
+    for (uint32_t i = 0; i < k * n; i++) b_data[i] = (float)(i % 3) - 1.0f;
+    for (uint32_t i = 0; i < m * n; i++) c_data[i] = -100.0f;
+    
+    npu_tensor_t a = npu_create_tensor(a_data, 1, 1, m, k, NPU_DTYPE_FLOAT32);
+    npu_tensor_t b = npu_create_tensor(b_data, 1, 1, k, n, NPU_DTYPE_FLOAT32);
+    npu_tensor_t c = npu_create_tensor(c_data, 1, 1, m, n, NPU_DTYPE_FLOAT32);
+    npu_coop_stats_t stats;
+    
+    int ret = npu_set_host_threads(handle, 2);
+    ASSERT_EQ(NPU_SUCCESS, ret);
+    
+    ret = npu_matrix_multiply_cooperative(handle, &a, &b, &c, NPU_ACT_NONE);
+    ASSERT_EQ(NPU_SUCCESS, ret);
+    
+    ret = npu_get_coop_stats(handle, &stats);
+    ASSERT_EQ(NPU_SUCCESS, ret);
+    ASSERT_EQ(1, stats.calls);
+    ASSERT_EQ(m, stats.npu_rows + stats.cpu_rows);
+    ASSERT_TRUE(stats.npu_batches <= 7);
+    ASSERT_TRUE(stats.npu_share >= 0.0f && stats.npu_share <= 1.0f);
+    
+    // The mocked device leaves its rows as they were; host rows are exact
+    uint32_t host_rows = 0;
+    for (uint32_t i = 0; i < m; i++) {
+        if (c_data[i * n] == -100.0f) {
+            continue;
+        }
+        for (uint32_t j = 0; j < n; j++) {
+            float expected = 0.0f;
+            for (uint32_t p = 0; p < k; p++) expected += a_data[i * k + p] * b_data[p * n + j];
+            ASSERT_FLOAT_EQ(expected, c_data[i * n + j], 0.001f);
+        }
+        host_rows++;
+    }
+    ASSERT_EQ(stats.cpu_rows, host_rows);
+    
+    // B fills the shared buffer by itself, so the host computes every row
+    float *wide_b = malloc(8 * 32768 * sizeof(float));
+    float *wide_c = malloc(16 * 32768 * sizeof(float));
+    ASSERT_NOT_NULL(wide_b);
+    ASSERT_NOT_NULL(wide_c);
+    for (uint32_t i = 0; i < 8 * 32768; i++) wide_b[i] = 1.0f;
+    
+    npu_tensor_t wide_a = npu_create_tensor(a_data, 1, 1, 16, 8, NPU_DTYPE_FLOAT32);
+    npu_tensor_t wide_bt = npu_create_tensor(wide_b, 1, 1, 8, 32768, NPU_DTYPE_FLOAT32);
+    npu_tensor_t wide_ct = npu_create_tensor(wide_c, 1, 1, 16, 32768, NPU_DTYPE_FLOAT32);
+    
+    ret = npu_matrix_multiply_cooperative(handle, &wide_a, &wide_bt, &wide_ct, NPU_ACT_NONE);
+    ASSERT_EQ(NPU_SUCCESS, ret);
+    ASSERT_FLOAT_EQ(13.0f, wide_c[0], 0.001f);                  // Rows of A sum to 13
+    ASSERT_FLOAT_EQ(13.0f, wide_c[15 * 32768 + 32767], 0.001f);
+    
+    ret = npu_get_coop_stats(handle, &stats);
+    ASSERT_EQ(NPU_SUCCESS, ret);
+    ASSERT_EQ(2, stats.calls);
+    ASSERT_EQ(m + 16, stats.npu_rows + stats.cpu_rows);
+    
+    // Without a pool the NPU computes every row
+    ret = npu_set_host_threads(handle, 0);
+    ASSERT_EQ(NPU_SUCCESS, ret);
+    
+    ret = npu_matrix_multiply_cooperative(handle, &a, &b, &c, NPU_ACT_RELU);
+    ASSERT_EQ(NPU_SUCCESS, ret);
+    
+    ret = npu_get_coop_stats(handle, &stats);
+    ASSERT_EQ(NPU_SUCCESS, ret);
+    ASSERT_EQ(1, stats.calls);
+    ASSERT_EQ(m, stats.npu_rows);
+    ASSERT_EQ(1.0f, stats.npu_share);
+    
+    ret = npu_matrix_multiply_cooperative(handle, &wide_a, &wide_bt, &wide_ct, NPU_ACT_NONE);
+    ASSERT_EQ(NPU_ERROR_MEMORY, ret);
+    
+    // Invalid parameters
+    ret = npu_set_host_threads(handle, NPU_COOP_MAX_THREADS + 1);
+    ASSERT_EQ(NPU_ERROR_INVALID, ret);
+    
+    ret = npu_set_host_threads(NULL, 2);
+    ASSERT_EQ(NPU_ERROR_INVALID, ret);
+    
+    ret = npu_matrix_multiply_cooperative(handle, &a, NULL, &c, NPU_ACT_NONE);
+    ASSERT_EQ(NPU_ERROR_INVALID, ret);
+    
+    ret = npu_get_coop_stats(handle, NULL);
+    ASSERT_EQ(NPU_ERROR_INVALID, ret);
+    
+    free(wide_b);
+    free(wide_c);
+    npu_cleanup(handle);
+    TEST_PASS();
+}
+
 /**
  * Run all tensor operation tests
  */
@@ -386,4 +655,7 @@ void run_tensor_tests(void)
     RUN_TEST(test_normalization_ops);
     RUN_TEST(test_tensor_utilities);
     RUN_TEST(test_softmax_detailed);
+    RUN_TEST(test_sparse_weight_packing);
+    RUN_TEST(test_operator_placement);
+    RUN_TEST(test_cooperative_matmul);
 }
\ No newline at end of file